@@ -0,0 +1,5 @@
+public class Greeter {
+    public static String greeting() {
+        return "Well, hello friends, from inside a JAR!";
+    }
+}
@@ -0,0 +1,32 @@
+# Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+#
+# SPDX-License-Identifier: MIT
+
+#
+# check-example-jar.sh
+# Runs Example/Example.jar with the built binary, and fails if it doesn't print the expected greeting
+#
+# The JAR has a deflated (Main.class) and a stored (Greeter.class) entry, so this covers both ways of reading a class from an archive.
+# It is generated by Scripts/make-example-jar.py.
+#
+
+BUILD_DIRECTORY="Build"
+EXPECTED_OUTPUT="Well, hello friends, from inside a JAR!"
+
+OUTPUT=$("${BUILD_DIRECTORY}/jvm" Example/Example.jar --main-class Main)
+STATUS=$?
+
+if [ ${STATUS} -ne 0 ]; then
+    echo "Example/Example.jar exited with status ${STATUS}"
+    exit 1
+fi
+
+if [ "${OUTPUT}" != "${EXPECTED_OUTPUT}" ]; then
+    echo "Example/Example.jar printed:"
+    echo "${OUTPUT}"
+    echo "but was expected to print:"
+    echo "${EXPECTED_OUTPUT}"
+    exit 1
+fi
+
+echo "Example/Example.jar printed the expected output"
@@ -0,0 +1,141 @@
+# Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+#
+# SPDX-License-Identifier: MIT
+
+#
+# make-example-jar.py
+# Generates Example/Example.jar, which holds the classes from Example/Jar
+#
+# The class files are assembled by hand, so that the JAR can be rebuilt without a JDK.
+# They are equivalent to what `javac` emits for Example/Jar/*.java, without a StackMapTable (neither method branches).
+# Main.class is deflated and Greeter.class is stored, so that both ways of reading an entry are covered.
+#
+
+import os
+import struct
+import zipfile
+
+JAR_PATH = os.path.join(os.path.dirname(__file__), "..", "Example", "Example.jar")
+
+# https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4
+CONSTANT_UTF8 = 1
+CONSTANT_CLASS = 7
+CONSTANT_STRING = 8
+CONSTANT_FIELDREF = 9
+CONSTANT_METHODREF = 10
+CONSTANT_NAME_AND_TYPE = 12
+
+ACC_PUBLIC = 0x0001
+ACC_STATIC = 0x0008
+ACC_SUPER = 0x0020
+
+LDC = 0x12
+ALOAD_0 = 0x2A
+ARETURN = 0xB0
+RETURN = 0xB1
+GETSTATIC = 0xB2
+INVOKEVIRTUAL = 0xB6
+INVOKESPECIAL = 0xB7
+INVOKESTATIC = 0xB8
+
+
+class ConstantPool:
+    def __init__(self):
+        self.entries = []
+        self.indices = {}
+
+    def add(self, key, entry):
+        if key not in self.indices:
+            self.entries.append(entry)
+            self.indices[key] = len(self.entries)
+
+        return self.indices[key]
+
+    def utf8(self, text):
+        data = text.encode()
+        return self.add(("utf8", text), struct.pack(">BH", CONSTANT_UTF8, len(data)) + data)
+
+    def klass(self, name):
+        return self.add(("class", name), struct.pack(">BH", CONSTANT_CLASS, self.utf8(name)))
+
+    def string(self, text):
+        return self.add(("string", text), struct.pack(">BH", CONSTANT_STRING, self.utf8(text)))
+
+    def name_and_type(self, name, descriptor):
+        return self.add(("name_and_type", name, descriptor), struct.pack(">BHH", CONSTANT_NAME_AND_TYPE, self.utf8(name), self.utf8(descriptor)))
+
+    def member(self, tag, class_name, name, descriptor):
+        return self.add((tag, class_name, name, descriptor), struct.pack(">BHH", tag, self.klass(class_name), self.name_and_type(name, descriptor)))
+
+    def to_bytes(self):
+        return struct.pack(">H", len(self.entries) + 1) + b"".join(self.entries)
+
+
+def code_attribute(pool, max_stack, max_locals, code, line):
+    line_number_table = struct.pack(">HIHHH", pool.utf8("LineNumberTable"), 6, 1, 0, line)
+    body = struct.pack(">HHI", max_stack, max_locals, len(code)) + code + struct.pack(">HH", 0, 1) + line_number_table
+    return struct.pack(">HI", pool.utf8("Code"), len(body)) + body
+
+
+def class_file(name, source_file, declare_methods):
+    pool = ConstantPool()
+
+    # The default constructor that javac generates
+    object_init = pool.member(CONSTANT_METHODREF, "java/lang/Object", "<init>", "()V")
+    methods = [(ACC_PUBLIC, "<init>", "()V", 1, 1, bytes([ALOAD_0, INVOKESPECIAL]) + struct.pack(">H", object_init) + bytes([RETURN]), 1)]
+    methods += declare_methods(pool)
+
+    this_class = pool.klass(name)
+    super_class = pool.klass("java/lang/Object")
+
+    method_bytes = b""
+    for access_flags, method_name, descriptor, max_stack, max_locals, code, line in methods:
+        method_bytes += struct.pack(">HHHH", access_flags, pool.utf8(method_name), pool.utf8(descriptor), 1)
+        method_bytes += code_attribute(pool, max_stack, max_locals, code, line)
+
+    source_file_attribute = struct.pack(">HIH", pool.utf8("SourceFile"), 2, pool.utf8(source_file))
+
+    # Java 17 class files (major version 61), with no interfaces or fields
+    return (struct.pack(">IHH", 0xCAFEBABE, 0, 61) + pool.to_bytes()
+            + struct.pack(">HHHHH", ACC_PUBLIC | ACC_SUPER, this_class, super_class, 0, 0)
+            + struct.pack(">H", len(methods)) + method_bytes
+            + struct.pack(">H", 1) + source_file_attribute)
+
+
+# public static String greeting() { return "Well, hello friends, from inside a JAR!"; }
+def greeter_methods(pool):
+    greeting = pool.string("Well, hello friends, from inside a JAR!")
+    return [(ACC_PUBLIC | ACC_STATIC, "greeting", "()Ljava/lang/String;", 1, 0, bytes([LDC, greeting, ARETURN]), 3)]
+
+
+# public static void main(String[] args) { System.out.println(Greeter.greeting()); }
+def main_methods(pool):
+    out = pool.member(CONSTANT_FIELDREF, "java/lang/System", "out", "Ljava/io/PrintStream;")
+    greeting = pool.member(CONSTANT_METHODREF, "Greeter", "greeting", "()Ljava/lang/String;")
+    println = pool.member(CONSTANT_METHODREF, "java/io/PrintStream", "println", "(Ljava/lang/String;)V")
+
+    code = bytes([GETSTATIC]) + struct.pack(">H", out)
+    code += bytes([INVOKESTATIC]) + struct.pack(">H", greeting)
+    code += bytes([INVOKEVIRTUAL]) + struct.pack(">H", println)
+    code += bytes([RETURN])
+    return [(ACC_PUBLIC | ACC_STATIC, "main", "([Ljava/lang/String;)V", 2, 1, code, 3)]
+
+
+# A fixed timestamp keeps the generated JAR identical between runs
+TIMESTAMP = (2023, 1, 1, 0, 0, 0)
+
+with zipfile.ZipFile(JAR_PATH, "w") as jar:
+    def add_entry(name, data, compression_method):
+        info = zipfile.ZipInfo(name, TIMESTAMP)
+        info.compress_type = compression_method
+        info.external_attr = 0o644 << 16
+        jar.writestr(info, data)
+
+    # Like the `jar` tool, start with the META-INF/ directory and the manifest
+    directory = zipfile.ZipInfo("META-INF/", TIMESTAMP)
+    directory.external_attr = (0o40755 << 16) | 0x10
+    jar.writestr(directory, b"")
+
+    add_entry("META-INF/MANIFEST.MF", b"Manifest-Version: 1.0\r\nMain-Class: Main\r\nCreated-By: Scripts/make-example-jar.py\r\n\r\n", zipfile.ZIP_DEFLATED)
+    add_entry("Main.class", class_file("Main", "Main.java", main_methods), zipfile.ZIP_DEFLATED)
+    add_entry("Greeter.class", class_file("Greeter", "Greeter.java", greeter_methods), zipfile.ZIP_STORED)
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.1-200-E.1
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.5-200-A.1
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.6-200-A.1
+//
+// Classes, fields and methods share most of their flags, some bits mean different things depending on where they're used.
+// This is scoped for the same reason as Constant::Tag.
+struct Access {
+    enum Flags : u16 {
+        // Declared public; may be accessed from outside its package
+        Public = 0x0001,
+
+        // Declared private; accessible only within the defining class and other classes belonging to the same nest
+        Private = 0x0002,
+
+        // Declared protected; may be accessed within subclasses
+        Protected = 0x0004,
+
+        // Declared static
+        Static = 0x0008,
+
+        // Declared final; never directly assigned to after object construction, or must not be overridden / subclassed
+        Final = 0x0010,
+
+        // Methods: Declared synchronized; invocation is wrapped by a monitor use
+        // Classes: Treat superclass methods specially when invoked by the invokespecial instruction
+        Synchronized = 0x0020,
+
+        // Fields: Declared volatile; cannot be cached
+        Volatile = 0x0040,
+
+        // Fields: Declared transient; not written or read by a persistent object manager
+        Transient = 0x0080,
+
+        // Methods: Declared native; implemented in a language other than the Java programming language
+        Native = 0x0100,
+
+        // Classes: Is an interface, not a class
+        Interface = 0x0200,
+
+        // Declared abstract; must not be instantiated, or no implementation is provided
+        Abstract = 0x0400,
+
+        // Methods: In a class file whose major version number is at least 46 and at most 60: Declared strictfp
+        Strict = 0x0800,
+
+        // Declared synthetic; not present in the source code
+        Synthetic = 0x1000,
+
+        // Classes: Declared as an annotation interface
+        Annotation = 0x2000,
+
+        // Declared as an enum class, or an element of an enum class
+        Enum = 0x4000,
+    };
+};
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+
+#include "../AccessFlags.h"
+#include "../ConstantTag.h"
+#include "../Interpreter/Opcode.h"
+#include "../Parser/ClassFile.h"
+#include "../Parser/ClassParser.h"
+
+// Writes just enough of the class file format for the benchmarks to assemble their classes, without a Java compiler.
+// This means that the bytecode (and its instruction mix) is fixed.
+class ClassFileBuilder {
+public:
+    u16 add_utf8(StringView string)
+    {
+        append_u1(m_constant_pool, Constant::Tag::UTF8);
+        append_u2(m_constant_pool, string.length());
+        m_constant_pool.append(string.bytes().data(), string.length());
+        return m_constant_pool_count++;
+    }
+
+    u16 add_class(StringView name)
+    {
+        auto name_index = add_utf8(name);
+        append_u1(m_constant_pool, Constant::Tag::Class);
+        append_u2(m_constant_pool, name_index);
+        return m_constant_pool_count++;
+    }
+
+    u16 add_method_reference(u16 class_index, StringView name, StringView descriptor)
+    {
+        auto name_index = add_utf8(name);
+        auto descriptor_index = add_utf8(descriptor);
+
+        append_u1(m_constant_pool, Constant::Tag::NameAndType);
+        append_u2(m_constant_pool, name_index);
+        append_u2(m_constant_pool, descriptor_index);
+        auto name_and_type_index = m_constant_pool_count++;
+
+        append_u1(m_constant_pool, Constant::Tag::MethodReference);
+        append_u2(m_constant_pool, class_index);
+        append_u2(m_constant_pool, name_and_type_index);
+        return m_constant_pool_count++;
+    }
+
+    void add_interface(u16 class_index)
+    {
+        m_interfaces.append(class_index);
+    }
+
+    // Abstract methods don't have any code, so they aren't given a Code attribute
+    void add_method(u16 access_flags, StringView name, StringView descriptor, u16 max_stack, u16 max_locals, Vector<u8> const& code)
+    {
+        auto name_index = add_utf8(name);
+        auto descriptor_index = add_utf8(descriptor);
+
+        append_u2(m_methods, access_flags);
+        append_u2(m_methods, name_index);
+        append_u2(m_methods, descriptor_index);
+        m_method_count++;
+
+        if (access_flags & Access::Abstract) {
+            append_u2(m_methods, 0);
+            return;
+        }
+
+        // A single Code attribute, without an exception table or any nested attributes
+        auto code_name_index = add_utf8("Code"sv);
+        append_u2(m_methods, 1);
+        append_u2(m_methods, code_name_index);
+        append_u4(m_methods, 12 + code.size());
+        append_u2(m_methods, max_stack);
+        append_u2(m_methods, max_locals);
+        append_u4(m_methods, code.size());
+        m_methods.extend(code);
+        append_u2(m_methods, 0);
+        append_u2(m_methods, 0);
+    }
+
+    void add_static_method(StringView name, StringView descriptor, u16 max_stack, u16 max_locals, Vector<u8> const& code)
+    {
+        add_method(Access::Public | Access::Static, name, descriptor, max_stack, max_locals, code);
+    }
+
+    ErrorOr<ByteBuffer> build(u16 access_flags, u16 this_class, u16 super_class)
+    {
+        Vector<u8> bytes;
+        append_u4(bytes, 0xCAFEBABE);
+        append_u2(bytes, 0);
+        append_u2(bytes, Parser::MajorVersion::V17);
+
+        append_u2(bytes, m_constant_pool_count);
+        bytes.extend(m_constant_pool);
+
+        append_u2(bytes, access_flags);
+        append_u2(bytes, this_class);
+        append_u2(bytes, super_class);
+
+        append_u2(bytes, m_interfaces.size());
+        for (auto interface : m_interfaces)
+            append_u2(bytes, interface);
+
+        // No fields
+        append_u2(bytes, 0);
+
+        append_u2(bytes, m_method_count);
+        bytes.extend(m_methods);
+
+        // No class attributes
+        append_u2(bytes, 0);
+
+        return ByteBuffer::copy(bytes.span());
+    }
+
+    ErrorOr<NonnullOwnPtr<Parser::ClassFile>> build_class_file(u16 access_flags, u16 this_class, u16 super_class)
+    {
+        auto class_parser = TRY(Parser::ClassParser::create(TRY(build(access_flags, this_class, super_class))));
+        return try_make<Parser::ClassFile>(TRY(class_parser->parse()));
+    }
+
+private:
+    static void append_u1(Vector<u8>& bytes, u8 value)
+    {
+        bytes.append(value);
+    }
+
+    static void append_u2(Vector<u8>& bytes, u16 value)
+    {
+        bytes.append(value >> 8);
+        bytes.append(value & 0xFF);
+    }
+
+    static void append_u4(Vector<u8>& bytes, u32 value)
+    {
+        append_u2(bytes, value >> 16);
+        append_u2(bytes, value & 0xFFFF);
+    }
+
+    Vector<u8> m_constant_pool;
+    u16 m_constant_pool_count { 1 };
+
+    Vector<u16> m_interfaces;
+
+    Vector<u8> m_methods;
+    u16 m_method_count { 0 };
+};
+
+static constexpr u8 op(Interpreter::Opcode opcode)
+{
+    return to_underlying(opcode);
+}
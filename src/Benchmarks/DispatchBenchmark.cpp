@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NumericLimits.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibMain/Main.h>
+#include <time.h>
+
+#include "../Interpreter/Interpreter.h"
+#include "../Interpreter/Runtime.h"
+#include "../Loader/ClassLoader.h"
+#include "ClassFileBuilder.h"
+
+// Compares the dispatch modes of the interpreter on a couple of small, hot loops.
+//
+// There's no Java compiler involved, the benchmark class is assembled here so that the bytecode (and its instruction mix) is fixed.
+// Each workload is run in both dispatch modes, and the fastest of a few runs is reported.
+// If the JIT was compiled in, each workload is also run in compiled code. The interpreted runs have already made it hot, so it's compiled when it's first invoked.
+
+using Interpreter::Opcode;
+
+static ErrorOr<NonnullOwnPtr<Parser::ClassFile>> assemble_benchmark_class()
+{
+    ClassFileBuilder builder;
+    auto this_class = builder.add_class("DispatchBenchmark"sv);
+    auto super_class = builder.add_class("java/lang/Object"sv);
+    auto add_method = builder.add_method_reference(this_class, "add"sv, "(II)I"sv);
+
+    // static int add(int a, int b) { return a + b; }
+    builder.add_static_method("add"sv, "(II)I"sv, 2, 2,
+        {
+            op(Opcode::Iload0),
+            op(Opcode::Iload1),
+            op(Opcode::Iadd),
+            op(Opcode::Ireturn),
+        });
+
+    // static int arithmetic() {
+    //     int sum = 0;
+    //     for (int i = 0; i < (1 << 24); i++)
+    //         sum = (sum + i) ^ (i & 3);
+    //     return sum;
+    // }
+    builder.add_static_method("arithmetic"sv, "()I"sv, 3, 3,
+        {
+            /*  0 */ op(Opcode::Iconst0),
+            /*  1 */ op(Opcode::Istore0),
+            /*  2 */ op(Opcode::Iconst0),
+            /*  3 */ op(Opcode::Istore1),
+            /*  4 */ op(Opcode::Iconst1),
+            /*  5 */ op(Opcode::Bipush), 24,
+            /*  7 */ op(Opcode::Ishl),
+            /*  8 */ op(Opcode::Istore2),
+            /*  9 */ op(Opcode::Goto), 0x00, 14,
+            /* 12 */ op(Opcode::Iload0),
+            /* 13 */ op(Opcode::Iload1),
+            /* 14 */ op(Opcode::Iadd),
+            /* 15 */ op(Opcode::Iload1),
+            /* 16 */ op(Opcode::Iconst3),
+            /* 17 */ op(Opcode::Iand),
+            /* 18 */ op(Opcode::Ixor),
+            /* 19 */ op(Opcode::Istore0),
+            /* 20 */ op(Opcode::Iinc), 1, 1,
+            /* 23 */ op(Opcode::Iload1),
+            /* 24 */ op(Opcode::Iload2),
+            /* 25 */ op(Opcode::IfIcmplt), 0xFF, static_cast<u8>(12 - 25),
+            /* 28 */ op(Opcode::Iload0),
+            /* 29 */ op(Opcode::Ireturn),
+        });
+
+    // static int calls() {
+    //     int sum = 0;
+    //     for (int i = 0; i < (1 << 22); i++)
+    //         sum = add(sum, i);
+    //     return sum;
+    // }
+    builder.add_static_method("calls"sv, "()I"sv, 3, 3,
+        {
+            /*  0 */ op(Opcode::Iconst0),
+            /*  1 */ op(Opcode::Istore0),
+            /*  2 */ op(Opcode::Iconst0),
+            /*  3 */ op(Opcode::Istore1),
+            /*  4 */ op(Opcode::Iconst1),
+            /*  5 */ op(Opcode::Bipush), 22,
+            /*  7 */ op(Opcode::Ishl),
+            /*  8 */ op(Opcode::Istore2),
+            /*  9 */ op(Opcode::Goto), 0x00, 12,
+            /* 12 */ op(Opcode::Iload0),
+            /* 13 */ op(Opcode::Iload1),
+            /* 14 */ op(Opcode::Invokestatic), static_cast<u8>(add_method >> 8), static_cast<u8>(add_method & 0xFF),
+            /* 17 */ op(Opcode::Istore0),
+            /* 18 */ op(Opcode::Iinc), 1, 1,
+            /* 21 */ op(Opcode::Iload1),
+            /* 22 */ op(Opcode::Iload2),
+            /* 23 */ op(Opcode::IfIcmplt), 0xFF, static_cast<u8>(12 - 23),
+            /* 26 */ op(Opcode::Iload0),
+            /* 27 */ op(Opcode::Ireturn),
+        });
+
+    // static int allocations() {
+    //     int sum = 0;
+    //     for (int i = 0; i < (1 << 20); i++)
+    //         sum += new int[2].length;
+    //     return sum;
+    // }
+    builder.add_static_method("allocations"sv, "()I"sv, 3, 3,
+        {
+            /*  0 */ op(Opcode::Iconst0),
+            /*  1 */ op(Opcode::Istore0),
+            /*  2 */ op(Opcode::Iconst0),
+            /*  3 */ op(Opcode::Istore1),
+            /*  4 */ op(Opcode::Iconst1),
+            /*  5 */ op(Opcode::Bipush), 20,
+            /*  7 */ op(Opcode::Ishl),
+            /*  8 */ op(Opcode::Istore2),
+            /*  9 */ op(Opcode::Goto), 0x00, 13,
+            /* 12 */ op(Opcode::Iload0),
+            /* 13 */ op(Opcode::Iconst2),
+            /* 14 */ op(Opcode::Newarray), 10,
+            /* 16 */ op(Opcode::Arraylength),
+            /* 17 */ op(Opcode::Iadd),
+            /* 18 */ op(Opcode::Istore0),
+            /* 19 */ op(Opcode::Iinc), 1, 1,
+            /* 22 */ op(Opcode::Iload1),
+            /* 23 */ op(Opcode::Iload2),
+            /* 24 */ op(Opcode::IfIcmplt), 0xFF, static_cast<u8>(12 - 24),
+            /* 27 */ op(Opcode::Iload0),
+            /* 28 */ op(Opcode::Ireturn),
+        });
+
+    return builder.build_class_file(Access::Public, this_class, super_class);
+}
+
+static u64 monotonic_nanoseconds()
+{
+    timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<u64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+struct Measurement {
+    i32 result;
+    u64 best_nanoseconds;
+};
+
+static ErrorOr<Measurement> measure(Interpreter::Interpreter& interpreter, Interpreter::Method& method, size_t runs)
+{
+    Measurement measurement { .result = 0, .best_nanoseconds = NumericLimits<u64>::max() };
+    for (size_t run = 0; run < runs; run++) {
+        auto start = monotonic_nanoseconds();
+        auto result = TRY(interpreter.invoke(method, {}));
+        auto elapsed = monotonic_nanoseconds() - start;
+
+        measurement.result = result.as_int();
+        measurement.best_nanoseconds = min(measurement.best_nanoseconds, elapsed);
+    }
+
+    return measurement;
+}
+
+ErrorOr<int> serenity_main(Main::Arguments arguments)
+{
+    size_t runs = 5;
+
+    auto args_parser = make<Core::ArgsParser>();
+    args_parser->add_option(runs, "The number of times to run each workload, the fastest run is reported", "runs", 'n', "count");
+    args_parser->parse(arguments);
+
+    if (!Interpreter::is_dispatch_mode_supported(Interpreter::DispatchMode::Threaded)) {
+        warnln("Threaded dispatch wasn't compiled in, rebuild with CAOVM_COMPUTED_GOTO enabled to compare the dispatch modes");
+        return 1;
+    }
+
+    Loader::ClassRegistry class_registry;
+    auto class_file = TRY(assemble_benchmark_class());
+    auto class_name = TRY(Loader::ClassLoader::class_name(*class_file));
+    TRY(class_registry.register_class(class_name, move(class_file)));
+
+    auto runtime = TRY(Interpreter::Runtime::create(class_registry, Interpreter::DispatchMode::Switch));
+    auto* klass = TRY(runtime->resolve_class(TRY(Symbol::intern("DispatchBenchmark"sv))));
+    TRY(runtime->initialize_class(*klass));
+
+    auto& interpreter = runtime->interpreter();
+    interpreter.set_jit_enabled(false);
+
+    auto integer_method_descriptor = TRY(Symbol::intern("()I"sv));
+
+    for (auto workload : { "arithmetic"sv, "calls"sv, "allocations"sv }) {
+        auto* method = klass->declared_method(TRY(Symbol::intern(workload)), integer_method_descriptor);
+        VERIFY(method);
+
+        interpreter.set_dispatch_mode(Interpreter::DispatchMode::Switch);
+        auto switch_measurement = TRY(measure(interpreter, *method, runs));
+
+        interpreter.set_dispatch_mode(Interpreter::DispatchMode::Threaded);
+        auto threaded_measurement = TRY(measure(interpreter, *method, runs));
+
+        // Both dispatch modes run the same handlers, so they must always agree
+        VERIFY(switch_measurement.result == threaded_measurement.result);
+
+        outln("{}: switch {:.2} ms, threaded {:.2} ms, speedup {:.2}x",
+            workload,
+            switch_measurement.best_nanoseconds / 1e6,
+            threaded_measurement.best_nanoseconds / 1e6,
+            static_cast<double>(switch_measurement.best_nanoseconds) / threaded_measurement.best_nanoseconds);
+
+        if constexpr (Interpreter::is_jit_supported()) {
+            interpreter.set_jit_enabled(true);
+            auto compiled_measurement = TRY(measure(interpreter, *method, runs));
+            interpreter.set_jit_enabled(false);
+
+            VERIFY(compiled_measurement.result == threaded_measurement.result);
+
+            outln("{}: compiled {:.2} ms, speedup over threaded {:.2}x",
+                workload,
+                compiled_measurement.best_nanoseconds / 1e6,
+                static_cast<double>(threaded_measurement.best_nanoseconds) / compiled_measurement.best_nanoseconds);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/QuickSort.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibMain/Main.h>
+#include <time.h>
+
+#include "../Interpreter/Interpreter.h"
+#include "../Interpreter/Runtime.h"
+#include "../Loader/ClassLoader.h"
+#include "ClassFileBuilder.h"
+
+// Compares the pause times of young and full collections on an allocation-heavy workload.
+//
+// Most of the objects that the benchmark class allocates die straight away, but some of them are kept alive for a while,
+// which is the case that generational collection is designed for. The workload is run with young collections enabled,
+// and again with every collection being a full one, and the distribution of the pause times of each kind of collection is reported.
+
+using Interpreter::Opcode;
+
+static ErrorOr<NonnullOwnPtr<Parser::ClassFile>> assemble_benchmark_class()
+{
+    ClassFileBuilder builder;
+    auto this_class = builder.add_class("GarbageCollectionBenchmark"sv);
+    auto super_class = builder.add_class("java/lang/Object"sv);
+
+    // Every array that the workload allocates is an Object[], its superclass is also the component class
+    // static int churn() {
+    //     Object[] live = new Object[16384];
+    //     int sum = 0;
+    //     for (int i = 0; i < (1 << 23); i++) {
+    //         Object[] node = new Object[4];
+    //         if ((i & 31) == 0)
+    //             live[(i >> 5) & 16383] = node;
+    //         sum += node.length;
+    //     }
+    //     return sum;
+    // }
+    builder.add_static_method("churn"sv, "()I"sv, 3, 4,
+        {
+            /*  0 */ op(Opcode::Sipush), 0x40, 0x00,
+            /*  3 */ op(Opcode::Anewarray), static_cast<u8>(super_class >> 8), static_cast<u8>(super_class & 0xFF),
+            /*  6 */ op(Opcode::Astore0),
+            /*  7 */ op(Opcode::Iconst0),
+            /*  8 */ op(Opcode::Istore1),
+            /*  9 */ op(Opcode::Iconst0),
+            /* 10 */ op(Opcode::Istore2),
+            /* 11 */ op(Opcode::Goto), 0x00, 44 - 11,
+            /* 14 */ op(Opcode::Iconst4),
+            /* 15 */ op(Opcode::Anewarray), static_cast<u8>(super_class >> 8), static_cast<u8>(super_class & 0xFF),
+            /* 18 */ op(Opcode::Astore3),
+            /* 19 */ op(Opcode::Iload2),
+            /* 20 */ op(Opcode::Bipush), 31,
+            /* 22 */ op(Opcode::Iand),
+            /* 23 */ op(Opcode::Ifne), 0x00, 36 - 23,
+            /* 26 */ op(Opcode::Aload0),
+            /* 27 */ op(Opcode::Iload2),
+            /* 28 */ op(Opcode::Iconst5),
+            /* 29 */ op(Opcode::Ishr),
+            /* 30 */ op(Opcode::Sipush), 0x3F, 0xFF,
+            /* 33 */ op(Opcode::Iand),
+            /* 34 */ op(Opcode::Aload3),
+            /* 35 */ op(Opcode::Aastore),
+            /* 36 */ op(Opcode::Iload1),
+            /* 37 */ op(Opcode::Aload3),
+            /* 38 */ op(Opcode::Arraylength),
+            /* 39 */ op(Opcode::Iadd),
+            /* 40 */ op(Opcode::Istore1),
+            /* 41 */ op(Opcode::Iinc), 2, 1,
+            /* 44 */ op(Opcode::Iload2),
+            /* 45 */ op(Opcode::Iconst1),
+            /* 46 */ op(Opcode::Bipush), 23,
+            /* 48 */ op(Opcode::Ishl),
+            /* 49 */ op(Opcode::IfIcmplt), 0xFF, static_cast<u8>(14 - 49),
+            /* 52 */ op(Opcode::Iload1),
+            /* 53 */ op(Opcode::Ireturn),
+        });
+
+    return builder.build_class_file(Access::Public, this_class, super_class);
+}
+
+static u64 monotonic_nanoseconds()
+{
+    timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<u64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+struct Measurement {
+    i32 result { 0 };
+    u64 nanoseconds { 0 };
+
+    // The pause time of every collection of each kind
+    Vector<u64> young_pauses;
+    Vector<u64> full_pauses;
+};
+
+static ErrorOr<Measurement> measure(Loader::ClassRegistry& class_registry, size_t heap_size, bool young_collections_enabled)
+{
+    // Each measurement gets a fresh runtime, so that it starts with an empty heap
+    auto runtime = TRY(Interpreter::Runtime::create(class_registry, Interpreter::default_dispatch_mode(), heap_size));
+    auto* klass = TRY(runtime->resolve_class(TRY(Symbol::intern("GarbageCollectionBenchmark"sv))));
+    TRY(runtime->initialize_class(*klass));
+
+    auto* method = klass->declared_method(TRY(Symbol::intern("churn"sv)), TRY(Symbol::intern("()I"sv)));
+    VERIFY(method);
+
+    Measurement measurement;
+    runtime->heap().set_young_collections_enabled(young_collections_enabled);
+    runtime->heap().set_collection_observer([&](Interpreter::Heap::CollectionStatistics const& statistics) {
+        auto& pauses = statistics.kind == Interpreter::Heap::CollectionKind::Young ? measurement.young_pauses : measurement.full_pauses;
+        pauses.append(statistics.pause_nanoseconds);
+    });
+
+    auto start = monotonic_nanoseconds();
+    measurement.result = TRY(runtime->interpreter().invoke(*method, {})).as_int();
+    measurement.nanoseconds = monotonic_nanoseconds() - start;
+
+    return measurement;
+}
+
+static void report_pauses(StringView kind, Vector<u64>& pauses)
+{
+    if (pauses.is_empty()) {
+        outln("  {} collections: none", kind);
+        return;
+    }
+
+    quick_sort(pauses);
+    auto percentile = [&](size_t percent) {
+        return pauses[min(pauses.size() - 1, pauses.size() * percent / 100)] / 1e6;
+    };
+
+    outln("  {} {} collections, pauses: p50 {:.3} ms, p90 {:.3} ms, p99 {:.3} ms, max {:.3} ms",
+        pauses.size(),
+        kind,
+        percentile(50),
+        percentile(90),
+        percentile(99),
+        pauses.last() / 1e6);
+}
+
+ErrorOr<int> serenity_main(Main::Arguments arguments)
+{
+    size_t heap_size_in_mebibytes = 64;
+
+    auto args_parser = make<Core::ArgsParser>();
+    args_parser->add_option(heap_size_in_mebibytes, "The size of the heap in MiB, including both generations", "heap-size", 0, "size");
+    args_parser->parse(arguments);
+
+    Loader::ClassRegistry class_registry;
+    auto class_file = TRY(assemble_benchmark_class());
+    auto class_name = TRY(Loader::ClassLoader::class_name(*class_file));
+    TRY(class_registry.register_class(class_name, move(class_file)));
+
+    auto generational = TRY(measure(class_registry, heap_size_in_mebibytes * MiB, true));
+    auto full_only = TRY(measure(class_registry, heap_size_in_mebibytes * MiB, false));
+
+    // The collector must never change what the program computes
+    VERIFY(generational.result == full_only.result);
+
+    outln("generational: {:.2} ms", generational.nanoseconds / 1e6);
+    report_pauses("young"sv, generational.young_pauses);
+    report_pauses("full"sv, generational.full_pauses);
+
+    outln("full collections only: {:.2} ms", full_only.nanoseconds / 1e6);
+    report_pauses("full"sv, full_only.full_pauses);
+
+    return 0;
+}
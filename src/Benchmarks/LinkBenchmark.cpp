@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NumericLimits.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibMain/Main.h>
+#include <time.h>
+
+#include "../Interpreter/Runtime.h"
+#include "../Loader/ClassLoader.h"
+#include "ClassFileBuilder.h"
+
+// Measures how quickly the runtime can link a large set of classes, which is dominated by laying out their vtables and itables.
+//
+// The classes are assembled here, and form hierarchies which are `hierarchy_depth` classes deep.
+// Every class overrides the virtual methods of its superclass, adds one of its own, and implements a couple of interfaces,
+// some of which extend other interfaces. Each run links every class into a fresh runtime, and the fastest run is reported.
+
+using Interpreter::Opcode;
+
+static constexpr size_t interface_count = 64;
+static constexpr size_t methods_per_interface = 4;
+static constexpr size_t hierarchy_depth = 8;
+static constexpr size_t overridden_method_count = 12;
+
+static ErrorOr<String> interface_name(size_t index)
+{
+    return String::formatted("LinkBenchmark$Interface{}", index);
+}
+
+static ErrorOr<String> class_name(size_t index)
+{
+    return String::formatted("LinkBenchmark$Class{}", index);
+}
+
+// int method() { return 0; }
+static Vector<u8> const& return_zero_code()
+{
+    static Vector<u8> const code { op(Opcode::Iconst0), op(Opcode::Ireturn) };
+    return code;
+}
+
+static ErrorOr<NonnullOwnPtr<Parser::ClassFile>> assemble_interface(size_t index)
+{
+    ClassFileBuilder builder;
+    auto this_class = builder.add_class(TRY(interface_name(index)).bytes_as_string_view());
+    auto super_class = builder.add_class("java/lang/Object"sv);
+
+    // Interfaces form short chains, so that classes also implement superinterfaces
+    if (index % 4 != 0)
+        builder.add_interface(builder.add_class(TRY(interface_name(index - 1)).bytes_as_string_view()));
+
+    for (size_t method = 0; method < methods_per_interface; method++) {
+        auto method_name = TRY(String::formatted("interface{}Method{}", index, method));
+        builder.add_method(Access::Public | Access::Abstract, method_name.bytes_as_string_view(), "()I"sv, 0, 0, {});
+    }
+
+    return builder.build_class_file(Access::Public | Access::Interface | Access::Abstract, this_class, super_class);
+}
+
+static ErrorOr<NonnullOwnPtr<Parser::ClassFile>> assemble_class(size_t index)
+{
+    ClassFileBuilder builder;
+    auto this_class = builder.add_class(TRY(class_name(index)).bytes_as_string_view());
+    auto super_class = index % hierarchy_depth == 0
+        ? builder.add_class("java/lang/Object"sv)
+        : builder.add_class(TRY(class_name(index - 1)).bytes_as_string_view());
+
+    for (size_t method = 0; method < overridden_method_count; method++) {
+        auto method_name = TRY(String::formatted("method{}", method));
+        builder.add_method(Access::Public, method_name.bytes_as_string_view(), "()I"sv, 1, 1, return_zero_code());
+    }
+
+    auto own_method_name = TRY(String::formatted("class{}Method", index));
+    builder.add_method(Access::Public, own_method_name.bytes_as_string_view(), "()I"sv, 1, 1, return_zero_code());
+
+    for (auto interface : { (index * 7) % interface_count, (index * 13 + 5) % interface_count }) {
+        builder.add_interface(builder.add_class(TRY(interface_name(interface)).bytes_as_string_view()));
+
+        for (size_t method = 0; method < methods_per_interface; method++) {
+            auto method_name = TRY(String::formatted("interface{}Method{}", interface, method));
+            builder.add_method(Access::Public, method_name.bytes_as_string_view(), "()I"sv, 1, 1, return_zero_code());
+        }
+    }
+
+    return builder.build_class_file(Access::Public, this_class, super_class);
+}
+
+static u64 monotonic_nanoseconds()
+{
+    timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<u64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+ErrorOr<int> serenity_main(Main::Arguments arguments)
+{
+    size_t class_count = 4096;
+    size_t runs = 5;
+
+    auto args_parser = make<Core::ArgsParser>();
+    args_parser->add_option(class_count, "The number of classes to link, in addition to the interfaces", "classes", 'c', "count");
+    args_parser->add_option(runs, "The number of times to link every class, the fastest run is reported", "runs", 'n', "count");
+    args_parser->parse(arguments);
+
+    // Parsing isn't part of the measurement, every class file is parsed up front
+    Loader::ClassRegistry class_registry;
+    Vector<Symbol> class_names;
+    for (size_t index = 0; index < interface_count; index++) {
+        auto name = TRY(Symbol::intern(TRY(interface_name(index)).bytes_as_string_view()));
+        TRY(class_registry.register_class(name, TRY(assemble_interface(index))));
+    }
+
+    for (size_t index = 0; index < class_count; index++) {
+        auto name = TRY(Symbol::intern(TRY(class_name(index)).bytes_as_string_view()));
+        TRY(class_registry.register_class(name, TRY(assemble_class(index))));
+        TRY(class_names.try_append(name));
+    }
+
+    auto best_nanoseconds = NumericLimits<u64>::max();
+    size_t vtable_entries = 0;
+    for (size_t run = 0; run < runs; run++) {
+        // Classes stay linked for the lifetime of a runtime, so each run needs a fresh one
+        auto runtime = TRY(Interpreter::Runtime::create(class_registry, Interpreter::default_dispatch_mode()));
+
+        auto start = monotonic_nanoseconds();
+        for (auto name : class_names)
+            TRY(runtime->resolve_class(name));
+        best_nanoseconds = min(best_nanoseconds, monotonic_nanoseconds() - start);
+
+        vtable_entries = 0;
+        for (auto name : class_names)
+            vtable_entries += TRY(runtime->resolve_class(name))->vtable().size();
+    }
+
+    outln("linked {} classes and {} interfaces in {:.2} ms, {:.0} classes per second, {:.1} vtable entries per class",
+        class_count,
+        interface_count,
+        best_nanoseconds / 1e6,
+        class_count / (best_nanoseconds / 1e9),
+        static_cast<double>(vtable_entries) / class_count);
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NumericLimits.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibMain/Main.h>
+
+#include "../Interpreter/Interpreter.h"
+#include "../Interpreter/Runtime.h"
+#include "../Loader/ClassLoader.h"
+#include "ClassFileBuilder.h"
+
+// Measures how the throughput of a full collection's mark phase scales with the number of marking threads.
+//
+// The benchmark class builds a large tree of small arrays, which is kept alive while the heap is collected over and over again,
+// with 1, 2, 4, 8 and 16 marking threads. The fastest mark phase of a few collections is reported for each thread count.
+
+using Interpreter::Opcode;
+
+static ErrorOr<NonnullOwnPtr<Parser::ClassFile>> assemble_benchmark_class()
+{
+    ClassFileBuilder builder;
+    auto this_class = builder.add_class("MarkingBenchmark"sv);
+    auto super_class = builder.add_class("java/lang/Object"sv);
+    auto tree_method = builder.add_method_reference(this_class, "tree"sv, "(I)[Ljava/lang/Object;"sv);
+
+    // Every node of the tree is an Object[], its superclass is also the component class
+    // static Object[] tree(int depth) {
+    //     Object[] node = new Object[4];
+    //     if (depth > 0) {
+    //         for (int i = 0; i < 4; i++)
+    //             node[i] = tree(depth - 1);
+    //     }
+    //     return node;
+    // }
+    builder.add_static_method("tree"sv, "(I)[Ljava/lang/Object;"sv, 4, 3,
+        {
+            /*  0 */ op(Opcode::Iconst4),
+            /*  1 */ op(Opcode::Anewarray), static_cast<u8>(super_class >> 8), static_cast<u8>(super_class & 0xFF),
+            /*  4 */ op(Opcode::Astore1),
+            /*  5 */ op(Opcode::Iload0),
+            /*  6 */ op(Opcode::Ifle), 0x00, 31 - 6,
+            /*  9 */ op(Opcode::Iconst0),
+            /* 10 */ op(Opcode::Istore2),
+            /* 11 */ op(Opcode::Goto), 0x00, 26 - 11,
+            /* 14 */ op(Opcode::Aload1),
+            /* 15 */ op(Opcode::Iload2),
+            /* 16 */ op(Opcode::Iload0),
+            /* 17 */ op(Opcode::Iconst1),
+            /* 18 */ op(Opcode::Isub),
+            /* 19 */ op(Opcode::Invokestatic), static_cast<u8>(tree_method >> 8), static_cast<u8>(tree_method & 0xFF),
+            /* 22 */ op(Opcode::Aastore),
+            /* 23 */ op(Opcode::Iinc), 2, 1,
+            /* 26 */ op(Opcode::Iload2),
+            /* 27 */ op(Opcode::Iconst4),
+            /* 28 */ op(Opcode::IfIcmplt), 0xFF, static_cast<u8>(14 - 28),
+            /* 31 */ op(Opcode::Aload1),
+            /* 32 */ op(Opcode::Areturn),
+        });
+
+    return builder.build_class_file(Access::Public, this_class, super_class);
+}
+
+ErrorOr<int> serenity_main(Main::Arguments arguments)
+{
+    size_t depth = 10;
+    size_t runs = 5;
+
+    auto args_parser = make<Core::ArgsParser>();
+    args_parser->add_option(depth, "The depth of the tree, which has 4^depth leaves", "depth", 'd', "depth");
+    args_parser->add_option(runs, "The number of collections for each thread count, the fastest mark phase is reported", "runs", 'n', "count");
+    args_parser->parse(arguments);
+
+    Loader::ClassRegistry class_registry;
+    auto class_file = TRY(assemble_benchmark_class());
+    auto class_name = TRY(Loader::ClassLoader::class_name(*class_file));
+    TRY(class_registry.register_class(class_name, move(class_file)));
+
+    auto runtime = TRY(Interpreter::Runtime::create(class_registry, Interpreter::default_dispatch_mode()));
+    auto* klass = TRY(runtime->resolve_class(TRY(Symbol::intern("MarkingBenchmark"sv))));
+    TRY(runtime->initialize_class(*klass));
+
+    auto* method = klass->declared_method(TRY(Symbol::intern("tree"sv)), TRY(Symbol::intern("(I)[Ljava/lang/Object;"sv)));
+    VERIFY(method);
+
+    auto argument = Interpreter::Value::from_int(static_cast<i32>(depth));
+    auto* tree = TRY(runtime->interpreter().invoke(*method, { &argument, 1 })).as_reference();
+
+    // Nothing else references the tree, so it's kept alive for as long as the benchmark runs
+    auto& heap = runtime->heap();
+    Interpreter::Heap::TemporaryRoot tree_root(heap, tree);
+
+    Interpreter::Heap::CollectionStatistics last_collection {};
+    heap.set_collection_observer([&](Interpreter::Heap::CollectionStatistics const& statistics) {
+        last_collection = statistics;
+    });
+
+    u64 single_thread_nanoseconds = 0;
+    for (size_t thread_count : { 1, 2, 4, 8, 16 }) {
+        heap.set_marking_thread_count(thread_count);
+
+        auto best_nanoseconds = NumericLimits<u64>::max();
+        size_t marked_bytes = 0;
+        for (size_t run = 0; run < runs; run++) {
+            runtime->collect_garbage(Interpreter::Heap::CollectionKind::Full);
+            best_nanoseconds = min(best_nanoseconds, last_collection.mark_nanoseconds);
+            marked_bytes = last_collection.marked_bytes;
+        }
+
+        if (thread_count == 1)
+            single_thread_nanoseconds = best_nanoseconds;
+
+        outln("{} threads: marked {:.1} MiB in {:.2} ms, {:.0} MiB/s, speedup {:.2}x",
+            thread_count,
+            static_cast<double>(marked_bytes) / MiB,
+            best_nanoseconds / 1e6,
+            (static_cast<double>(marked_bytes) / MiB) / (best_nanoseconds / 1e9),
+            static_cast<double>(single_thread_nanoseconds) / best_nanoseconds);
+    }
+
+    return 0;
+}
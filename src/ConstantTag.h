@@ -13,12 +13,24 @@
 struct Constant {
     // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4-140
     enum Tag : u8 {
+        // The slot following a Long or Double constant, it must be valid but is considered unusable
+        Unusable = 0,
+
         // Raw UTF8 data
         UTF8 = 1,
 
         // Used to represent constant primitives of the type int
         Integer = 3,
 
+        // Used to represent constant primitives of the type float
+        Float = 4,
+
+        // Used to represent constant primitives of the type long, takes up two slots in the constant pool
+        Long = 5,
+
+        // Used to represent constant primitives of the type double, takes up two slots in the constant pool
+        Double = 6,
+
         // Used to represent a class or an interface
         Class = 7,
 
@@ -31,7 +43,28 @@ struct Constant {
         // Used to represent a reference to a method on an Object
         MethodReference = 10,
 
+        // Used to represent a reference to a method on an interface
+        InterfaceMethodReference = 11,
+
         // Used to represent a field or a method, without indicating which class or interface it belongs to
         NameAndType = 12,
+
+        // Used to represent a method handle
+        MethodHandle = 15,
+
+        // Used to represent a method type
+        MethodType = 16,
+
+        // Used to represent a dynamically-computed constant, produced by invocation of a bootstrap method
+        Dynamic = 17,
+
+        // Used by an invokedynamic instruction to specify a bootstrap method and the dynamic invocation name
+        InvokeDynamic = 18,
+
+        // Used to represent a module, only found in the constant pool of a module-info class
+        Module = 19,
+
+        // Used to represent a package exported or opened by a module, only found in the constant pool of a module-info class
+        Package = 20,
     };
 };
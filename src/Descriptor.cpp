@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Descriptor.h"
+
+// Skips over a single field type, returning the index after it
+static ErrorOr<size_t> skip_field_type(StringView descriptor, size_t index)
+{
+    // Each array dimension is a prefix on the component type
+    while (index < descriptor.length() && descriptor[index] == FieldDescriptor::ArrayDimension)
+        index++;
+
+    if (index >= descriptor.length())
+        return Error::from_string_literal("Unexpected end of descriptor");
+
+    if (descriptor[index] != FieldDescriptor::ReferenceStart)
+        return index + 1;
+
+    auto end = descriptor.find(FieldDescriptor::ReferenceEnd, index);
+    if (!end.has_value())
+        return Error::from_string_literal("Unterminated class name in descriptor");
+
+    return *end + 1;
+}
+
+ErrorOr<MethodDescriptorInfo> parse_method_descriptor(StringView descriptor)
+{
+    if (descriptor.is_empty() || descriptor[0] != MethodDescriptor::ParametersStart)
+        return Error::from_string_literal("Method descriptor must start with '('");
+
+    u16 parameter_slots = 0;
+    size_t index = 1;
+    while (index < descriptor.length() && descriptor[index] != MethodDescriptor::ParametersEnd) {
+        // Arrays are references, even if their component type is a long or a double
+        auto slots = descriptor[index] == FieldDescriptor::ArrayDimension ? 1 : slot_count_for_descriptor(descriptor[index]);
+        parameter_slots += slots;
+
+        index = TRY(skip_field_type(descriptor, index));
+    }
+
+    if (index + 1 >= descriptor.length())
+        return Error::from_string_literal("Method descriptor is missing its return type");
+
+    auto return_type = descriptor[index + 1];
+    u8 return_slots = return_type == MethodDescriptor::Void ? 0 : slot_count_for_descriptor(return_type);
+
+    return MethodDescriptorInfo {
+        .parameter_slots = parameter_slots,
+        .return_slots = return_slots,
+        .return_type = return_type,
+    };
+}
+
+ErrorOr<void> for_each_parameter_type(StringView descriptor, Function<void(char)> const& callback)
+{
+    if (descriptor.is_empty() || descriptor[0] != MethodDescriptor::ParametersStart)
+        return Error::from_string_literal("Method descriptor must start with '('");
+
+    size_t index = 1;
+    while (index < descriptor.length() && descriptor[index] != MethodDescriptor::ParametersEnd) {
+        callback(descriptor[index]);
+        index = TRY(skip_field_type(descriptor, index));
+    }
+
+    return {};
+}
@@ -6,6 +6,11 @@
 
 #pragma once
 
+#include <AK/Error.h>
+#include <AK/Function.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.3.2
 enum FieldDescriptor : char const {
     // Signed byte
@@ -20,6 +25,9 @@ enum FieldDescriptor : char const {
     // Single-precision floating point value
     Float = 'F',
 
+    // Integer
+    Int = 'I',
+
     // Long integer
     Long = 'J',
 
@@ -38,3 +46,60 @@ enum FieldDescriptor : char const {
     // One array dimension
     ArrayDimension = '[',
 };
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.3.3
+enum MethodDescriptor : char const {
+    // The start of the parameter descriptors
+    ParametersStart = '(',
+
+    // The end of the parameter descriptors, the return descriptor follows
+    ParametersEnd = ')',
+
+    // The method does not return a value
+    Void = 'V',
+};
+
+// The number of local variable (or operand stack) slots that a value with this descriptor takes up
+constexpr u8 slot_count_for_descriptor(char descriptor)
+{
+    return descriptor == FieldDescriptor::Long || descriptor == FieldDescriptor::Double ? 2 : 1;
+}
+
+// The number of bytes that an array element (or field) with this descriptor takes up in memory
+constexpr u8 size_for_descriptor(char descriptor)
+{
+    switch (descriptor) {
+    case FieldDescriptor::Byte:
+    case FieldDescriptor::Boolean:
+        return 1;
+    case FieldDescriptor::Char:
+    case FieldDescriptor::Short:
+        return 2;
+    case FieldDescriptor::Int:
+    case FieldDescriptor::Float:
+        return 4;
+    case FieldDescriptor::Long:
+    case FieldDescriptor::Double:
+        return 8;
+    default:
+        // References
+        return sizeof(void*);
+    }
+}
+
+struct MethodDescriptorInfo {
+    // The number of local variable slots taken up by the parameters, this doesn't include `this`
+    u16 parameter_slots;
+
+    // The number of operand stack slots taken up by the return value, this is 0 for void methods
+    u8 return_slots;
+
+    // The first character of the return descriptor
+    char return_type;
+};
+
+// Parses a method descriptor, e.g. `(IJLjava/lang/String;)V`
+ErrorOr<MethodDescriptorInfo> parse_method_descriptor(StringView descriptor);
+
+// Calls the callback with the first character of each parameter's descriptor, e.g. `I`, `L` and `[` for `(ILjava/lang/String;[J)V`
+ErrorOr<void> for_each_parameter_type(StringView descriptor, Function<void(char)> const& callback);
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Class.h"
+#include <AK/Array.h>
+
+namespace Interpreter {
+
+Method::Method(Class& owner, Symbol name, Symbol descriptor, u16 access_flags, MethodDescriptorInfo descriptor_info, RefPtr<Parser::CodeAttribute> code)
+    : m_owner(owner)
+    , m_name(name)
+    , m_descriptor(descriptor)
+    , m_access_flags(access_flags)
+    , m_argument_slots(descriptor_info.parameter_slots + ((access_flags & Access::Static) ? 0 : 1))
+    , m_return_slots(descriptor_info.return_slots)
+    , m_code(move(code))
+{
+}
+
+bool Method::is_selected_by_receiver() const
+{
+    return !is_static() && !(m_access_flags & Access::Private) && m_name != WellKnownSymbols::the().init;
+}
+
+ErrorOr<InstructionStream*> Method::decode_instructions()
+{
+    VERIFY(m_code);
+
+    m_instructions = TRY(InstructionStream::decode(*this));
+    return m_instructions.ptr();
+}
+
+Field::Field(Class& owner, Symbol name, Symbol descriptor, u16 access_flags, u32 offset)
+    : m_owner(owner)
+    , m_name(name)
+    , m_descriptor(descriptor)
+    , m_access_flags(access_flags)
+    , m_offset(offset)
+{
+}
+
+bool Field::is_reference() const
+{
+    auto type = m_descriptor.view()[0];
+    return type == FieldDescriptor::ReferenceStart || type == FieldDescriptor::ArrayDimension;
+}
+
+Class::Class(Symbol name, u16 access_flags, Class* super_class, Parser::ClassFile const* class_file, RefPtr<SymbolicatedConstantPool> constant_pool)
+    : m_name(name)
+    , m_access_flags(access_flags)
+    , m_super_class(super_class)
+    , m_class_file(class_file)
+    , m_constant_pool(move(constant_pool))
+{
+}
+
+ErrorOr<void> Class::add_interface(Class& interface)
+{
+    TRY(m_interfaces.try_append(&interface));
+    return {};
+}
+
+ErrorOr<Method*> Class::add_method(Symbol name, Symbol descriptor, u16 access_flags, RefPtr<Parser::CodeAttribute> code)
+{
+    auto descriptor_info = TRY(parse_method_descriptor(descriptor.view()));
+    auto method = TRY(try_make<Method>(*this, name, descriptor, access_flags, descriptor_info, move(code)));
+
+    auto* method_pointer = method.ptr();
+    TRY(m_methods.try_append(move(method)));
+
+    return method_pointer;
+}
+
+ErrorOr<Method*> Class::add_native_method(Symbol name, Symbol descriptor, u16 access_flags, NativeFunction native_function)
+{
+    auto* method = TRY(add_method(name, descriptor, access_flags | Access::Native, nullptr));
+    method->set_native_function(native_function);
+
+    return method;
+}
+
+ErrorOr<Field*> Class::add_field(Symbol name, Symbol descriptor, u16 access_flags)
+{
+    if (descriptor.is_null() || descriptor.length() == 0)
+        return Error::from_string_literal("Field descriptor must not be empty");
+
+    // Static fields each take up a full Value, as they're accessed through a pointer to one
+    u32 offset = 0;
+    if (access_flags & Access::Static) {
+        offset = m_static_values.size();
+        TRY(m_static_values.try_append(Value()));
+    }
+
+    auto field = TRY(try_make<Field>(*this, name, descriptor, access_flags, offset));
+
+    auto* field_pointer = field.ptr();
+    TRY(m_fields.try_append(move(field)));
+
+    return field_pointer;
+}
+
+// Adds the interface and all of its superinterfaces to the list, if they aren't in it already
+static ErrorOr<void> collect_interfaces(Class& interface, Vector<Class*>& interfaces)
+{
+    if (interfaces.contains_slow(&interface))
+        return {};
+
+    TRY(interfaces.try_append(&interface));
+    for (auto* superinterface : interface.interfaces())
+        TRY(collect_interfaces(*superinterface, interfaces));
+
+    return {};
+}
+
+ErrorOr<void> Class::build_dispatch_tables()
+{
+    // Interfaces don't have a vtable, their methods are numbered in the order that they're declared instead.
+    // Every itable section for this interface has its methods in that order.
+    if (is_interface()) {
+        for (auto& method : m_methods) {
+            if (method->is_selected_by_receiver())
+                method->set_dispatch_index(m_interface_method_count++);
+        }
+
+        return {};
+    }
+
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.4.5
+    // FIXME: A package-private method can only be overridden by a method in the same run-time package.
+    auto inherited_vtable_size = m_super_class ? m_super_class->vtable().size() : 0;
+    if (m_super_class)
+        TRY(m_vtable.try_extend(m_super_class->vtable()));
+
+    for (auto& method : m_methods) {
+        if (!method->is_selected_by_receiver())
+            continue;
+
+        // Symbols are interned, so comparing the name and descriptor of each inherited method is just comparing pointers
+        auto dispatch_index = m_vtable.size();
+        for (size_t i = 0; i < inherited_vtable_size; i++) {
+            if (m_vtable[i]->name() == method->name() && m_vtable[i]->descriptor() == method->descriptor()) {
+                dispatch_index = i;
+                break;
+            }
+        }
+
+        method->set_dispatch_index(dispatch_index);
+        if (dispatch_index == m_vtable.size())
+            TRY(m_vtable.try_append(method.ptr()));
+        else
+            m_vtable[dispatch_index] = method.ptr();
+    }
+
+    // The superclass' interfaces come first, so that the most commonly implemented interfaces are found sooner
+    Vector<Class*> interfaces;
+    for (auto* klass = m_super_class; klass; klass = klass->super_class()) {
+        for (auto* interface : klass->interfaces())
+            TRY(collect_interfaces(*interface, interfaces));
+    }
+
+    for (auto* interface : m_interfaces)
+        TRY(collect_interfaces(*interface, interfaces));
+
+    TRY(m_itable_sections.try_ensure_capacity(interfaces.size()));
+    for (auto* interface : interfaces) {
+        m_itable_sections.unchecked_append(ItableSection { interface, static_cast<u32>(m_itable.size()) });
+        TRY(m_itable.try_resize(m_itable.size() + interface->m_interface_method_count));
+
+        for (auto& interface_method : interface->methods()) {
+            if (interface_method->is_selected_by_receiver())
+                m_itable[m_itable_sections.last().offset + interface_method->dispatch_index()] = select_interface_method(*interface_method, interfaces);
+        }
+    }
+
+    return {};
+}
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.4.6
+Method* Class::select_interface_method(Method& interface_method, Vector<Class*> const& interfaces)
+{
+    // If C contains a declaration of an instance method that can override the interface method, then that is the selected method.
+    // Otherwise, if C has a superclass, a search for a declaration of such an instance method is performed in the superclass.
+    // The vtable has the most specific declaration of every one of these methods.
+    for (auto* method : m_vtable) {
+        if (method->name() == interface_method.name() && method->descriptor() == interface_method.descriptor())
+            return method;
+    }
+
+    // Otherwise, a default method from one of the superinterfaces is selected.
+    // FIXME: This should choose the maximally-specific superinterface method, we take the first one that we find.
+    for (auto* interface : interfaces) {
+        auto* method = interface->declared_method(interface_method.name(), interface_method.descriptor());
+        if (method && method->is_selected_by_receiver() && !method->is_abstract())
+            return method;
+    }
+
+    // An abstract method throws an AbstractMethodError when it's invoked
+    return &interface_method;
+}
+
+ErrorOr<void> Class::lay_out_instance_fields()
+{
+    if (m_super_class) {
+        TRY(m_instance_fields.try_extend(m_super_class->instance_fields()));
+        TRY(m_reference_field_offsets.try_extend(m_super_class->reference_field_offsets()));
+    }
+
+    // Grouped by size, in the order that they are placed
+    Array<Vector<Field*>, 5> fields_by_size;
+    auto group_of = [](Field const& field) -> size_t {
+        if (field.is_reference())
+            return 0;
+
+        switch (field.size()) {
+        case 8:
+            return 1;
+        case 4:
+            return 2;
+        case 2:
+            return 3;
+        default:
+            return 4;
+        }
+    };
+
+    for (auto& field : m_fields) {
+        if (!field->is_static())
+            TRY(fields_by_size[group_of(*field)].try_append(field.ptr()));
+    }
+
+    auto end = m_super_class ? m_super_class->instance_size() : 0;
+    auto place = [&](Field& field, u32 offset) -> ErrorOr<void> {
+        field.set_offset(offset);
+        TRY(m_instance_fields.try_append(&field));
+
+        if (field.is_reference())
+            TRY(m_reference_field_offsets.try_append(offset));
+
+        return {};
+    };
+
+    // Whenever a group's first field would need padding before it (e.g. after a superclass which ends with a byte), the smaller fields fill the gap.
+    // The largest field which can be placed at the end without any padding is placed first, until the gap is full.
+    auto fill_gap = [&](size_t first_smaller_group, u32 gap_end) -> ErrorOr<void> {
+        while (end < gap_end) {
+            Field* field = nullptr;
+            for (size_t group = first_smaller_group; group < fields_by_size.size() && !field; group++) {
+                auto& fields = fields_by_size[group];
+                if (!fields.is_empty() && end % fields.first()->size() == 0 && end + fields.first()->size() <= gap_end) {
+                    field = fields.first();
+                    fields.remove(0);
+                }
+            }
+
+            if (!field)
+                break;
+
+            TRY(place(*field, end));
+            end += field->size();
+        }
+
+        return {};
+    };
+
+    // Every group's size divides the size of the group before it, so once the first field is aligned, the rest are too
+    for (size_t group = 0; group < fields_by_size.size(); group++) {
+        auto& fields = fields_by_size[group];
+        if (fields.is_empty())
+            continue;
+
+        if (auto alignment = fields.first()->size(); end % alignment != 0)
+            TRY(fill_gap(group + 1, align_up_to(end, alignment)));
+
+        for (auto* field : fields) {
+            auto offset = align_up_to(end, field->size());
+            TRY(place(*field, offset));
+            end = offset + field->size();
+        }
+    }
+
+    // Fields are always placed at increasing offsets, so the inherited fields followed by the new ones are already in order
+    m_instance_size = end;
+    return {};
+}
+
+Method* Class::declared_method(Symbol name, Symbol descriptor)
+{
+    for (auto& method : m_methods) {
+        if (method->name() == name && method->descriptor() == descriptor)
+            return method.ptr();
+    }
+
+    return nullptr;
+}
+
+Method* Class::lookup_method(Symbol name, Symbol descriptor)
+{
+    // Method resolution attempts to look up the referenced method in C and its superclasses
+    for (auto* klass = this; klass; klass = klass->super_class()) {
+        if (auto* method = klass->declared_method(name, descriptor))
+            return method;
+    }
+
+    // Otherwise, method lookup attempts to locate the referenced method in the superinterfaces of the specified class C.
+    // FIXME: This should choose the maximally-specific superinterface method, we take the first one that we find.
+    for (auto* klass = this; klass; klass = klass->super_class()) {
+        for (auto* interface : klass->interfaces()) {
+            if (auto* method = interface->lookup_method(name, descriptor))
+                return method;
+        }
+    }
+
+    return nullptr;
+}
+
+Field* Class::lookup_field(Symbol name, Symbol descriptor)
+{
+    // If C declares a field with the name and descriptor specified by the field reference, field lookup succeeds.
+    for (auto& field : m_fields) {
+        if (field->name() == name && field->descriptor() == descriptor)
+            return field.ptr();
+    }
+
+    // Otherwise, field lookup is applied recursively to the direct superinterfaces of the specified class or interface C.
+    for (auto* interface : m_interfaces) {
+        if (auto* field = interface->lookup_field(name, descriptor))
+            return field;
+    }
+
+    // Otherwise, if C has a superclass S, field lookup is applied recursively to S.
+    if (m_super_class)
+        return m_super_class->lookup_field(name, descriptor);
+
+    return nullptr;
+}
+
+bool Class::is_assignable_to(Class const& other) const
+{
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-6.html#jvms-6.5.checkcast
+    if (this == &other)
+        return true;
+
+    if (is_array()) {
+        // Arrays are objects, and implement Cloneable and Serializable
+        if (!other.is_array()) {
+            auto const& symbols = WellKnownSymbols::the();
+            return other.name() == symbols.java_lang_Object || other.name() == symbols.java_lang_Cloneable || other.name() == symbols.java_io_Serializable;
+        }
+
+        // Primitive arrays are only assignable to arrays of the same type, which would have been the same class
+        if (!m_component_class || !other.component_class())
+            return false;
+
+        return m_component_class->is_assignable_to(*other.component_class());
+    }
+
+    for (auto const* klass = this; klass; klass = klass->super_class()) {
+        if (klass == &other)
+            return true;
+
+        for (auto const* interface : klass->interfaces()) {
+            if (interface->is_assignable_to(other))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "../AccessFlags.h"
+#include "../Descriptor.h"
+#include "../Parser/Attribute.h"
+#include "../Parser/ClassFile.h"
+#include "../Symbol.h"
+#include "InstructionStream.h"
+#include "SymbolicatedConstantPool.h"
+#include "Value.h"
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NumericLimits.h>
+#include <AK/OwnPtr.h>
+#include <AK/Span.h>
+#include <AK/Vector.h>
+
+namespace Interpreter {
+
+// Forward-declaration
+class Class;
+class Runtime;
+
+// Implemented by the virtual machine itself, instead of by bytecode.
+// The arguments are laid out the same way as a frame's local variables, including `this` for instance methods.
+using NativeFunction = ErrorOr<Value> (*)(Runtime& runtime, Span<Value> arguments);
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-2.html#jvms-2.9
+class Method {
+public:
+    Method(Class& owner, Symbol name, Symbol descriptor, u16 access_flags, MethodDescriptorInfo descriptor_info, RefPtr<Parser::CodeAttribute> code);
+
+    Class& owner() { return m_owner; };
+
+    // The unqualified name of this method
+    Symbol name() const { return m_name; };
+
+    // The descriptor (signature) of this method
+    Symbol descriptor() const { return m_descriptor; };
+
+    u16 access_flags() const { return m_access_flags; };
+    bool is_static() const { return m_access_flags & Access::Static; };
+    bool is_abstract() const { return m_access_flags & Access::Abstract; };
+    bool is_native() const { return m_native_function != nullptr; };
+
+    // Whether invokevirtual and invokeinterface select this method (or an override of it) from the class of the receiver,
+    // which is every instance method apart from private methods and instance initialization methods.
+    bool is_selected_by_receiver() const;
+
+    // For a method declared by a class, this is its index in the vtable of that class (and every subclass).
+    // For a method declared by an interface, this is its index within that interface's part of an itable.
+    // Only methods which are selected by the receiver have one, see Class::build_dispatch_tables().
+    u32 dispatch_index() const
+    {
+        VERIFY(m_dispatch_index != no_dispatch_index);
+        return m_dispatch_index;
+    }
+
+    void set_dispatch_index(u32 dispatch_index) { m_dispatch_index = dispatch_index; };
+
+    // The number of local variable slots taken up by the arguments, including `this` for instance methods
+    u16 argument_slots() const { return m_argument_slots; };
+
+    // The number of operand stack slots taken up by the return value, this is 0 for void methods
+    u8 return_slots() const { return m_return_slots; };
+
+    // The bytecode of this method, this is null for native and abstract methods
+    Parser::CodeAttribute* code() { return m_code.ptr(); };
+
+    // The decoded form of the bytecode that the interpreter executes, this is decoded the first time that it is needed
+    ErrorOr<InstructionStream*> instructions()
+    {
+        if (m_instructions) [[likely]]
+            return m_instructions.ptr();
+
+        return decode_instructions();
+    }
+
+    // Null if the method hasn't been decoded yet, e.g. for diagnostics which shouldn't decode every method
+    InstructionStream* decoded_instructions() { return m_instructions.ptr(); };
+
+    NativeFunction native_function() const { return m_native_function; };
+    void set_native_function(NativeFunction native_function) { m_native_function = native_function; };
+
+private:
+    ErrorOr<InstructionStream*> decode_instructions();
+
+    Class& m_owner;
+    Symbol m_name;
+    Symbol m_descriptor;
+    u16 m_access_flags;
+
+    u16 m_argument_slots;
+    u8 m_return_slots;
+
+    static constexpr u32 no_dispatch_index = NumericLimits<u32>::max();
+    u32 m_dispatch_index { no_dispatch_index };
+
+    RefPtr<Parser::CodeAttribute> m_code;
+    OwnPtr<InstructionStream> m_instructions;
+    NativeFunction m_native_function { nullptr };
+};
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-2.html#jvms-2.3
+class Field {
+public:
+    Field(Class& owner, Symbol name, Symbol descriptor, u16 access_flags, u32 offset);
+
+    Class& owner() { return m_owner; };
+
+    // The unqualified name of this field
+    Symbol name() const { return m_name; };
+
+    // The descriptor (type) of this field
+    Symbol descriptor() const { return m_descriptor; };
+
+    u16 access_flags() const { return m_access_flags; };
+    bool is_static() const { return m_access_flags & Access::Static; };
+
+    // Long and double fields take up two slots on the operand stack
+    bool is_category_2() const { return slot_count_for_descriptor(m_descriptor.view()[0]) == 2; };
+
+    // For instance fields, this is the offset of the field's storage within an object, which is assigned when its class is laid out.
+    // For static fields, this is the index of the field within its class' static values.
+    u32 offset() const { return m_offset; };
+    void set_offset(u32 offset) { m_offset = offset; };
+
+    // The number of bytes that this field takes up in an object
+    u8 size() const { return size_for_descriptor(m_descriptor.view()[0]); };
+    bool is_reference() const;
+
+private:
+    Class& m_owner;
+    Symbol m_name;
+    Symbol m_descriptor;
+    u16 m_access_flags;
+    u32 m_offset;
+};
+
+// A class or interface which has been linked by the runtime, ready to be initialized and used by the interpreter.
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.4
+class Class {
+public:
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.5
+    enum class State {
+        // Linked, but <clinit> hasn't been run yet
+        Linked,
+
+        // <clinit> is currently running
+        Initializing,
+
+        // Ready to be used
+        Initialized,
+    };
+
+    Class(Symbol name, u16 access_flags, Class* super_class, Parser::ClassFile const* class_file, RefPtr<SymbolicatedConstantPool> constant_pool);
+
+    // The binary name of this class, e.g. `java/lang/Object`
+    Symbol name() const { return m_name; };
+
+    u16 access_flags() const { return m_access_flags; };
+    bool is_interface() const { return m_access_flags & Access::Interface; };
+
+    // Null for java/lang/Object, interfaces have java/lang/Object as their superclass
+    Class* super_class() const { return m_super_class; };
+
+    // The direct super-interfaces of this class or interface
+    Vector<Class*> const& interfaces() const { return m_interfaces; };
+    ErrorOr<void> add_interface(Class& interface);
+
+    // The class file that this class was linked from, this is null for classes which are defined by the runtime itself
+    Parser::ClassFile const* class_file() const { return m_class_file; };
+
+    // The run-time constant pool of this class, this is null for classes which are defined by the runtime itself
+    SymbolicatedConstantPool* constant_pool() { return m_constant_pool.ptr(); };
+
+    Vector<NonnullOwnPtr<Method>> const& methods() const { return m_methods; };
+    ErrorOr<Method*> add_method(Symbol name, Symbol descriptor, u16 access_flags, RefPtr<Parser::CodeAttribute> code);
+    ErrorOr<Method*> add_native_method(Symbol name, Symbol descriptor, u16 access_flags, NativeFunction native_function);
+
+    Vector<NonnullOwnPtr<Field>> const& fields() const { return m_fields; };
+
+    // Static fields are given their own storage, instance fields are given an offset by lay_out_instance_fields()
+    ErrorOr<Field*> add_field(Symbol name, Symbol descriptor, u16 access_flags);
+
+    // Assigns an offset to each instance field declared by this class, once all of them have been added.
+    // The superclass must already have been laid out, its fields keep their offsets so that code compiled against it still works.
+    //
+    // Fields are packed by size, so that each one is aligned to its size without any padding between them:
+    // references first, followed by the other 8-byte fields, and then the 4, 2 and 1-byte fields.
+    // Any gap that would be left before a group (e.g. at the end of the superclass) is filled with smaller fields, the largest ones that fit first.
+    ErrorOr<void> lay_out_instance_fields();
+
+    // Every instance field of this class, including inherited ones, ordered by offset
+    Vector<Field*> const& instance_fields() const { return m_instance_fields; };
+
+    // The offset of every reference field in an instance of this class, including inherited ones
+    Vector<u32> const& reference_field_offsets() const { return m_reference_field_offsets; };
+
+    // Finds a method declared by this class, without looking at superclasses
+    Method* declared_method(Symbol name, Symbol descriptor);
+
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.4.3.3
+    Method* lookup_method(Symbol name, Symbol descriptor);
+
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.4.3.2
+    Field* lookup_field(Symbol name, Symbol descriptor);
+
+    // Lays out the vtable and itables of this class, this is done once when the class is linked, after all of its methods have been added.
+    // The superclass and every superinterface must already have their dispatch tables.
+    //
+    // The vtable starts with a copy of the superclass' vtable, an overriding method takes over the index of the method that it overrides,
+    // and any other method is appended to the end. This means that a method has the same index in the vtable of every subclass.
+    //
+    // The itable has a section for every interface that this class implements (directly or not), in which each of the interface's methods
+    // maps to the method that implements it. All of the sections are stored in a single contiguous table.
+    ErrorOr<void> build_dispatch_tables();
+
+    // Selects the method that invokevirtual or invokeinterface calls for a receiver of this class, with an indexed load from the vtable or itable.
+    // Returns null if the resolved method belongs to an interface which this class doesn't implement.
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.4.6
+    Method* select_method(Method& resolved_method) const
+    {
+        auto& resolved_class = resolved_method.owner();
+        if (!resolved_class.is_interface())
+            return m_vtable[resolved_method.dispatch_index()];
+
+        for (auto const& section : m_itable_sections) {
+            if (section.interface == &resolved_class)
+                return m_itable[section.offset + resolved_method.dispatch_index()];
+        }
+
+        return nullptr;
+    }
+
+    Vector<Method*> const& vtable() const { return m_vtable; };
+
+    // Whether an instance of this class can be assigned to a variable of the other type
+    bool is_assignable_to(Class const& other) const;
+
+    // Array classes are defined by the runtime, their name is the descriptor of the array, e.g. `[I` or `[Ljava/lang/String;`
+    bool is_array() const { return m_name.view().starts_with(FieldDescriptor::ArrayDimension); };
+
+    // The class of the elements of a reference array, this is null for arrays of primitive types
+    Class* component_class() const { return m_component_class; };
+    void set_component_class(Class* component_class) { m_component_class = component_class; };
+
+    // The size of each element of an array of this type, in bytes
+    u8 element_size() const { return size_for_descriptor(m_name.view()[1]); };
+
+    // The number of bytes needed to store the instance fields of this class, including inherited ones.
+    // This isn't rounded up, a subclass may place its own fields in the space that is left before the next 8-byte boundary.
+    u32 instance_size() const { return m_instance_size; };
+
+    Value& static_value_at(u32 index) { return m_static_values[index]; };
+
+    State state() const { return m_state; };
+    void set_state(State state) { m_state = state; };
+
+private:
+    Method* select_interface_method(Method& interface_method, Vector<Class*> const& interfaces);
+
+    Symbol m_name;
+    u16 m_access_flags;
+    Class* m_super_class;
+    Vector<Class*> m_interfaces;
+
+    Parser::ClassFile const* m_class_file;
+    RefPtr<SymbolicatedConstantPool> m_constant_pool;
+
+    Vector<NonnullOwnPtr<Method>> m_methods;
+    Vector<NonnullOwnPtr<Field>> m_fields;
+
+    // The part of the itable for a single interface, which starts at `offset`
+    struct ItableSection {
+        Class const* interface;
+        u32 offset;
+    };
+
+    Vector<Method*> m_vtable;
+    Vector<ItableSection> m_itable_sections;
+    Vector<Method*> m_itable;
+
+    // The number of methods in each itable section for this interface
+    u32 m_interface_method_count { 0 };
+
+    Class* m_component_class { nullptr };
+
+    Vector<Field*> m_instance_fields;
+    Vector<u32> m_reference_field_offsets;
+
+    u32 m_instance_size { 0 };
+    Vector<Value> m_static_values;
+
+    State m_state { State::Linked };
+};
+
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/NumericLimits.h>
+#include <AK/Types.h>
+#include <math.h>
+
+namespace Interpreter {
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-6.html#jvms-6.5.f2i
+// NaN becomes 0, and values which are out of range are clamped, instead of being undefined behaviour like they are in C++.
+template<typename Integer, typename FloatingPoint>
+Integer floating_point_to_integer(FloatingPoint value)
+{
+    if (isnan(value))
+        return 0;
+
+    if (value >= static_cast<FloatingPoint>(NumericLimits<Integer>::max()))
+        return NumericLimits<Integer>::max();
+
+    if (value <= static_cast<FloatingPoint>(NumericLimits<Integer>::min()))
+        return NumericLimits<Integer>::min();
+
+    return static_cast<Integer>(value);
+}
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-6.html#jvms-6.5.fcmp_op
+// The only difference between the `l` and `g` variants is the result when either value is NaN.
+template<typename FloatingPoint>
+i32 compare_floating_point(FloatingPoint a, FloatingPoint b, i32 nan_result)
+{
+    if (a > b)
+        return 1;
+    if (a < b)
+        return -1;
+    if (a == b)
+        return 0;
+
+    return nan_result;
+}
+
+}
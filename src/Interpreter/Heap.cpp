@@ -0,0 +1,544 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Heap.h"
+#include "Class.h"
+#include "Object.h"
+#include "WorkStealingDeque.h"
+#include <AK/HashFunctions.h>
+#include <LibThreading/Thread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+namespace Interpreter {
+
+// Every object's size is derived from its class (and its length, for arrays), so the heap doesn't need to store it.
+// This is the same size that the object was allocated with, see Runtime::allocate_object() and Runtime::allocate_array().
+static size_t size_of(Object& object)
+{
+    auto& klass = object.klass();
+    if (klass.is_array()) {
+        auto& array = static_cast<ArrayObject&>(object);
+        return align_up_to(ArrayObject::elements_offset + static_cast<size_t>(array.length()) * klass.element_size(), Heap::object_alignment);
+    }
+
+    return align_up_to(sizeof(Object) + klass.instance_size(), Heap::object_alignment);
+}
+
+// Calls the callback with each reference field of an object, or each element of an array of references
+template<typename Callback>
+static void for_each_reference_in(Object& object, Callback callback)
+{
+    auto& klass = object.klass();
+    if (klass.is_array()) {
+        // Only arrays of classes or arrays have a component class, the elements of an array of primitives aren't references
+        if (!klass.component_class())
+            return;
+
+        auto& array = static_cast<ArrayObject&>(object);
+        for (i32 i = 0; i < array.length(); i++)
+            callback(array.element_at<Object*>(i));
+
+        return;
+    }
+
+    for (auto offset : klass.reference_field_offsets())
+        callback(object.field_at<Object*>(offset));
+}
+
+static u64 monotonic_nanoseconds()
+{
+    timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<u64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+Heap::Heap(u8* base, size_t size)
+    : m_base(base)
+    , m_size(size)
+    , m_young_generation_size(size / 8)
+{
+    // Eden is made up of whole allocation buffers, the rest of the young generation is split between the survivor spaces
+    auto eden_size = align_down_to(m_young_generation_size * 3 / 4, allocation_buffer_size);
+    auto survivor_space_size = (m_young_generation_size - eden_size) / 2;
+    auto old_space_size = (size - m_young_generation_size) / 2;
+
+    m_eden.start = base;
+    m_eden.size = eden_size;
+
+    for (size_t i = 0; i < 2; i++) {
+        m_survivor_spaces[i].start = base + eden_size + i * survivor_space_size;
+        m_survivor_spaces[i].size = survivor_space_size;
+
+        m_old_spaces[i].start = base + m_young_generation_size + i * old_space_size;
+        m_old_spaces[i].size = old_space_size;
+    }
+
+    m_old_space_limit = old_space_size - m_young_generation_size;
+}
+
+Heap::~Heap()
+{
+    munmap(m_base, m_size);
+}
+
+ErrorOr<NonnullOwnPtr<Heap>> Heap::create(size_t size)
+{
+    // The young generation is an eighth of the heap, and it has to be able to hold at least one allocation buffer
+    size = align_up_to(size, 16 * allocation_buffer_size);
+
+    // The memory isn't committed until it's touched, MAP_NORESERVE stops the kernel from refusing a heap which is larger than the available memory
+    auto* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED)
+        return Error::from_errno(errno);
+
+    auto heap_or_error = try_make<Heap>(static_cast<u8*>(base), size);
+    if (heap_or_error.is_error()) {
+        munmap(base, size);
+        return heap_or_error.release_error();
+    }
+
+    auto heap = heap_or_error.release_value();
+    TRY(heap->m_card_table.try_resize(size / card_size));
+    TRY(heap->m_first_object_in_card.try_resize(size / card_size));
+    heap->m_first_object_in_card.span().fill(no_object_start);
+    heap->m_mark_bitmap = TRY(MarkBitmap::create(heap->m_base, size));
+
+    return heap;
+}
+
+u8* Heap::Space::claim(size_t bytes, size_t limit)
+{
+    auto current_used = used.load(AK::MemoryOrder::memory_order_relaxed);
+    do {
+        if (current_used > limit || bytes > limit - current_used)
+            return nullptr;
+    } while (!used.compare_exchange_strong(current_used, current_used + bytes, AK::MemoryOrder::memory_order_relaxed));
+
+    return start + current_used;
+}
+
+size_t Heap::size() const
+{
+    return m_eden.size + m_survivor_spaces[m_current_survivor_space].size + m_old_space_limit;
+}
+
+size_t Heap::used() const
+{
+    auto used_in = [](Space const& space) { return space.used.load(AK::MemoryOrder::memory_order_relaxed); };
+    return used_in(m_eden) + used_in(m_survivor_spaces[m_current_survivor_space]) + used_in(m_old_spaces[m_current_old_space]);
+}
+
+u8* Heap::allocate_slow(ThreadLocalAllocationBuffer& allocation_buffer, size_t size)
+{
+    // Objects which are larger than an allocation buffer would take up a large part of eden, and would have to be copied by young collections,
+    // so they are allocated in the old generation straight away.
+    // FIXME: Recording where the object starts isn't thread-safe, but there's only a single interpreter thread.
+    if (size > allocation_buffer_size) {
+        auto* allocation = old_space().claim(size, m_old_space_limit);
+        if (!allocation)
+            return nullptr;
+
+        record_object_start(allocation);
+        allocation_buffer.m_retired_bytes += size;
+        allocation_buffer.m_allocated_objects++;
+
+        return allocation;
+    }
+
+    // Unusually large objects get their own allocation, instead of wasting the rest of a buffer
+    if (size > allocation_buffer_size / 4) {
+        auto* allocation = m_eden.claim(size, m_eden.size);
+        if (!allocation)
+            return nullptr;
+
+        allocation_buffer.m_retired_bytes += size;
+        allocation_buffer.m_allocated_objects++;
+
+        return allocation;
+    }
+
+    // The rest of the old buffer is wasted, it's at most a quarter of a buffer
+    auto* buffer = m_eden.claim(allocation_buffer_size, m_eden.size);
+    if (!buffer)
+        return nullptr;
+
+    allocation_buffer.m_retired_bytes += allocation_buffer.m_top - allocation_buffer.m_start;
+    allocation_buffer.m_start = buffer;
+    allocation_buffer.m_top = buffer;
+    allocation_buffer.m_end = buffer + allocation_buffer_size;
+    allocation_buffer.m_refills++;
+
+    auto* allocation = allocation_buffer.try_allocate(size);
+    VERIFY(allocation);
+
+    return allocation;
+}
+
+void Heap::record_object_start(u8* address)
+{
+    auto card = card_index(address);
+    if (m_first_object_in_card[card] == no_object_start)
+        m_first_object_in_card[card] = static_cast<u16>(static_cast<size_t>(address - m_base) % card_size);
+}
+
+template<typename Callback>
+void Heap::for_each_object_in_card(size_t card, u8* end, Callback callback)
+{
+    auto first_object = m_first_object_in_card[card];
+    if (first_object == no_object_start)
+        return;
+
+    auto* card_start = m_base + card * card_size;
+    for (auto* address = card_start + first_object; address < card_start + card_size && address < end;) {
+        auto& object = *reinterpret_cast<Object*>(address);
+        address += size_of(object);
+        callback(object);
+    }
+}
+
+void Heap::collect_garbage(CollectionKind kind, Function<void(ReferenceVisitor const&)> const& visit_roots)
+{
+    auto start_nanoseconds = monotonic_nanoseconds();
+
+    // In the worst case, a young collection promotes everything in eden and the survivor space
+    auto young_generation_used = m_eden.used.load(AK::MemoryOrder::memory_order_relaxed) + survivor_space().used.load(AK::MemoryOrder::memory_order_relaxed);
+    auto old_generation_available = m_old_space_limit - min(m_old_space_limit, old_space().used.load(AK::MemoryOrder::memory_order_relaxed));
+    if (kind == CollectionKind::Young && (!m_young_collections_enabled || young_generation_used > old_generation_available))
+        kind = CollectionKind::Full;
+
+    CollectionStatistics statistics { .kind = kind, .used_before = used() };
+    if (kind == CollectionKind::Young)
+        collect_young_generation(visit_roots, statistics);
+    else
+        collect_everything(visit_roots, statistics);
+
+    statistics.used_after = used();
+    statistics.pause_nanoseconds = monotonic_nanoseconds() - start_nanoseconds;
+
+    if (kind == CollectionKind::Young)
+        m_young_collections++;
+    else
+        m_full_collections++;
+
+    m_reclaimed_bytes += statistics.used_before - statistics.used_after;
+    m_promoted_bytes += statistics.promoted_bytes;
+    m_pause_nanoseconds += statistics.pause_nanoseconds;
+
+    if (m_logging_enabled) {
+        dbgln("GC #{} ({}): {} KiB -> {} KiB, {} KiB reclaimed, {} objects survived, {} KiB promoted, paused for {:.3} ms", collections(),
+            kind == CollectionKind::Young ? "young"sv : "full"sv, statistics.used_before / KiB, statistics.used_after / KiB,
+            (statistics.used_before - statistics.used_after) / KiB, statistics.surviving_objects, statistics.promoted_bytes / KiB, statistics.pause_nanoseconds / 1e6);
+    }
+
+    if (m_collection_observer)
+        m_collection_observer(statistics);
+}
+
+void Heap::collect_young_generation(Function<void(ReferenceVisitor const&)> const& visit_roots, CollectionStatistics& statistics)
+{
+    auto& from_space = survivor_space();
+    auto& to_space = empty_survivor_space();
+    auto& old = old_space();
+
+    // Survivors are copied to the end of the empty survivor space, and promoted objects to the end of the old generation, in the order that they're found
+    auto* old_top = old.top();
+    auto* survivor_free = to_space.start;
+    auto* promoted_free = old_top;
+
+    auto evacuate = [&](Object*& reference) {
+        if (!reference || !is_in_young_generation(reference) || to_space.contains(reference))
+            return;
+
+        // Every other reference to an object that has already been copied is pointed at the same copy
+        if (reference->is_forwarded()) {
+            reference = reference->forwarding_address();
+            return;
+        }
+
+        // Objects which have already survived a collection are promoted, and so is anything that doesn't fit in the survivor space.
+        // The check before the collection made sure that the old generation has room for all of them.
+        auto size = size_of(*reference);
+        u8* copy = nullptr;
+        if (from_space.contains(reference) || size > static_cast<size_t>(to_space.start + to_space.size - survivor_free)) {
+            copy = promoted_free;
+            promoted_free += size;
+            VERIFY(promoted_free <= old.start + old.size);
+
+            record_object_start(copy);
+            statistics.promoted_bytes += size;
+        } else {
+            copy = survivor_free;
+            survivor_free += size;
+        }
+
+        memcpy(copy, reference, size);
+        statistics.surviving_objects++;
+
+        reference->set_forwarding_address(reinterpret_cast<Object*>(copy));
+        reference = reinterpret_cast<Object*>(copy);
+    };
+
+    // Returns whether the object still references the young generation afterwards, in which case it has to stay in the remembered set
+    auto evacuate_references_of = [&](Object& object) {
+        auto references_young_generation = false;
+        for_each_reference_in(object, [&](Object*& reference) {
+            evacuate(reference);
+            if (reference && is_in_young_generation(reference))
+                references_young_generation = true;
+        });
+
+        return references_young_generation;
+    };
+
+    visit_roots(evacuate);
+    for (auto* temporary_root : m_temporary_roots)
+        evacuate(*temporary_root);
+
+    // Old objects that have been written to since the last collection are the only ones that could reference young objects,
+    // the rest of the old generation doesn't need to be looked at.
+    auto end_card = card_index(old_top + card_size - 1);
+    for (auto card = card_index(old.start); card < end_card; card++) {
+        if (m_card_table[card] == clean_card)
+            continue;
+
+        m_card_table[card] = clean_card;
+        for_each_object_in_card(card, old_top, [&](Object& object) {
+            if (evacuate_references_of(object))
+                m_card_table[card] = dirty_card;
+        });
+    }
+
+    // Both the survivors and the promoted objects that haven't been scanned yet are the queue of objects whose references still point into eden or the old survivor space.
+    // A promoted object which still references a survivor is remembered in the same way as a write to it would be.
+    auto* survivor_scan = to_space.start;
+    auto* promoted_scan = old_top;
+    while (survivor_scan < survivor_free || promoted_scan < promoted_free) {
+        while (survivor_scan < survivor_free) {
+            auto& object = *reinterpret_cast<Object*>(survivor_scan);
+            for_each_reference_in(object, evacuate);
+            survivor_scan += size_of(object);
+        }
+
+        while (promoted_scan < promoted_free) {
+            auto& object = *reinterpret_cast<Object*>(promoted_scan);
+            if (evacuate_references_of(object))
+                record_write(object);
+
+            promoted_scan += size_of(object);
+        }
+    }
+
+    update_identity_hash_codes(CollectionKind::Young);
+    reset_allocation_buffers();
+
+    // Giving the pages back to the kernel also means that they're zero-filled the next time that they're touched,
+    // which is what allocation (and the next collection) expects of an empty space.
+    madvise(m_eden.start, m_eden.used.load(AK::MemoryOrder::memory_order_relaxed), MADV_DONTNEED);
+    madvise(from_space.start, from_space.used.load(AK::MemoryOrder::memory_order_relaxed), MADV_DONTNEED);
+
+    m_eden.used.store(0, AK::MemoryOrder::memory_order_relaxed);
+    from_space.used.store(0, AK::MemoryOrder::memory_order_relaxed);
+    to_space.used.store(survivor_free - to_space.start, AK::MemoryOrder::memory_order_relaxed);
+    old.used.store(promoted_free - old.start, AK::MemoryOrder::memory_order_relaxed);
+    m_current_survivor_space = 1 - m_current_survivor_space;
+}
+
+void Heap::collect_everything(Function<void(ReferenceVisitor const&)> const& visit_roots, CollectionStatistics& statistics)
+{
+    static_assert(object_alignment == MarkBitmap::bytes_per_bit, "Every object must have its own mark bit");
+
+    // The roots are gathered up front, so that marking doesn't depend on the code that finds them being thread-safe
+    Vector<Object*> roots;
+    auto gather = [&](Object*& reference) {
+        if (reference)
+            MUST(roots.try_append(reference));
+    };
+
+    visit_roots(gather);
+    for (auto* temporary_root : m_temporary_roots)
+        gather(*temporary_root);
+
+    auto mark_start_nanoseconds = monotonic_nanoseconds();
+    mark_reachable_objects(roots, statistics);
+    statistics.mark_nanoseconds = monotonic_nanoseconds() - mark_start_nanoseconds;
+
+    // Marked objects are copied to the empty half of the old generation in address order, oldest first, which keeps objects that were allocated together close together.
+    // It always has room for everything, as allocation and promotion stop while the current half still has room for the whole young generation.
+    auto& old = old_space();
+    auto& to_space = empty_old_space();
+    auto* free = to_space.start;
+
+    for (auto* space : { &old, &survivor_space(), &m_eden }) {
+        m_mark_bitmap->for_each_marked(space->start, space->top(), [&](u8* address) {
+            auto& object = *reinterpret_cast<Object*>(address);
+            auto size = size_of(object);
+            VERIFY(size <= static_cast<size_t>(to_space.start + to_space.size - free));
+
+            memcpy(free, address, size);
+            record_object_start(free);
+            object.set_forwarding_address(reinterpret_cast<Object*>(free));
+
+            free += size;
+            statistics.surviving_objects++;
+        });
+
+        m_mark_bitmap->clear(space->start, space->top());
+    }
+
+    // Every reference is to a marked object, which now has a forwarding address
+    auto update = [](Object*& reference) {
+        if (reference && reference->is_forwarded())
+            reference = reference->forwarding_address();
+    };
+
+    visit_roots(update);
+    for (auto* temporary_root : m_temporary_roots)
+        update(*temporary_root);
+
+    for (auto* scan = to_space.start; scan < free;) {
+        auto& object = *reinterpret_cast<Object*>(scan);
+        for_each_reference_in(object, update);
+        scan += size_of(object);
+    }
+
+    update_identity_hash_codes(CollectionKind::Full);
+    reset_allocation_buffers();
+
+    // Nothing references the young generation any more, and the objects in the old half have all moved
+    m_card_table.span().fill(clean_card);
+    m_first_object_in_card.span().slice(card_index(old.start), old.size / card_size).fill(no_object_start);
+
+    for (auto* space : { &m_eden, &survivor_space(), &old }) {
+        madvise(space->start, space->used.load(AK::MemoryOrder::memory_order_relaxed), MADV_DONTNEED);
+        space->used.store(0, AK::MemoryOrder::memory_order_relaxed);
+    }
+
+    to_space.used.store(free - to_space.start, AK::MemoryOrder::memory_order_relaxed);
+    m_current_old_space = 1 - m_current_old_space;
+}
+
+void Heap::mark_reachable_objects(ReadonlySpan<Object*> roots, CollectionStatistics& statistics)
+{
+    auto worker_count = m_marking_thread_count;
+
+    // Each worker has a deque of the objects that it has marked but not scanned yet (i.e. grey objects).
+    // A worker that runs out steals from the others, so a worker which finds a large part of the heap doesn't have to scan all of it by itself.
+    Vector<NonnullOwnPtr<WorkStealingDeque<Object*>>> deques;
+    for (size_t i = 0; i < worker_count; i++)
+        MUST(deques.try_append(MUST(try_make<WorkStealingDeque<Object*>>())));
+
+    // The roots are dealt out before any of the workers start, which is the only time that a deque is pushed to by a thread that doesn't own it
+    for (size_t i = 0; i < roots.size(); i++) {
+        if (m_mark_bitmap->mark(roots[i]))
+            MUST(deques[i % worker_count]->push(roots[i]));
+    }
+
+    Atomic<size_t> idle_workers { 0 };
+    Atomic<size_t> marked_bytes { 0 };
+
+    // Marking is over once every worker is idle at the same time, as only a worker that isn't idle can push more objects.
+    // An idle worker which sees that a deque isn't empty goes back to stealing.
+    auto wait_for_work = [&]() {
+        idle_workers.fetch_add(1, AK::MemoryOrder::memory_order_acq_rel);
+        while (true) {
+            if (idle_workers.load(AK::MemoryOrder::memory_order_acquire) == worker_count)
+                return false;
+
+            for (auto const& deque : deques) {
+                if (!deque->is_empty()) {
+                    idle_workers.fetch_sub(1, AK::MemoryOrder::memory_order_acq_rel);
+                    return true;
+                }
+            }
+
+            sched_yield();
+        }
+    };
+
+    auto worker = [&](size_t index) -> intptr_t {
+        auto& deque = *deques[index];
+        size_t bytes = 0;
+
+        auto scan = [&](Object& object) {
+            bytes += size_of(object);
+            for_each_reference_in(object, [&](Object*& reference) {
+                if (reference && m_mark_bitmap->mark(reference))
+                    MUST(deque.push(reference));
+            });
+        };
+
+        do {
+            for (auto object = deque.pop(); object.has_value(); object = deque.pop())
+                scan(**object);
+
+            // Victims are tried in order, starting after this worker, so that thieves don't all pick on the same worker
+            for (size_t i = 1; i < worker_count; i++) {
+                if (auto object = deques[(index + i) % worker_count]->steal(); object.has_value()) {
+                    scan(**object);
+                    break;
+                }
+            }
+        } while (!deque.is_empty() || wait_for_work());
+
+        marked_bytes.fetch_add(bytes, AK::MemoryOrder::memory_order_relaxed);
+        return 0;
+    };
+
+    // The thread that is collecting garbage is one of the workers
+    Vector<NonnullRefPtr<Threading::Thread>> threads;
+    for (size_t i = 1; i < worker_count; i++) {
+        auto thread = Threading::Thread::construct([&worker, i] { return worker(i); }, "GC Marker"sv);
+        thread->start();
+        MUST(threads.try_append(move(thread)));
+    }
+
+    worker(0);
+    for (auto& thread : threads)
+        (void)thread->join();
+
+    statistics.marked_bytes = marked_bytes.load(AK::MemoryOrder::memory_order_relaxed);
+}
+
+void Heap::update_identity_hash_codes(CollectionKind kind)
+{
+    HashMap<Object*, i32> identity_hash_codes;
+    for (auto const& [object, hash_code] : m_identity_hash_codes) {
+        auto was_collected = is_in_young_generation(object) || (kind == CollectionKind::Full && old_space().contains(object));
+        if (!was_collected)
+            MUST(identity_hash_codes.try_set(object, hash_code));
+        else if (object->is_forwarded())
+            MUST(identity_hash_codes.try_set(object->forwarding_address(), hash_code));
+    }
+
+    m_identity_hash_codes = move(identity_hash_codes);
+}
+
+void Heap::reset_allocation_buffers()
+{
+    for (auto* allocation_buffer : m_allocation_buffers) {
+        allocation_buffer->m_retired_bytes += allocation_buffer->m_top - allocation_buffer->m_start;
+        allocation_buffer->m_start = nullptr;
+        allocation_buffer->m_top = nullptr;
+        allocation_buffer->m_end = nullptr;
+    }
+}
+
+ErrorOr<i32> Heap::identity_hash_code(Object& object)
+{
+    if (auto hash_code = m_identity_hash_codes.get(&object); hash_code.has_value())
+        return *hash_code;
+
+    auto hash_code = static_cast<i32>(ptr_hash(&object));
+    TRY(m_identity_hash_codes.try_set(&object, hash_code));
+
+    return hash_code;
+}
+
+}
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "MarkBitmap.h"
+#include "Value.h"
+#include <AK/Atomic.h>
+#include <AK/Error.h>
+#include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NumericLimits.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+namespace Interpreter {
+
+// Forward-declaration
+class Object;
+
+// A thread's private part of the heap, objects are allocated from it by bumping a pointer, without any synchronization.
+// When it runs out, the heap hands the thread a new one (see Heap::allocate()).
+class ThreadLocalAllocationBuffer {
+public:
+    // The fast path of an allocation, returns null if the buffer doesn't have enough space left
+    u8* try_allocate(size_t size)
+    {
+        if (size > static_cast<size_t>(m_end - m_top)) [[unlikely]]
+            return nullptr;
+
+        auto* allocation = m_top;
+        m_top += size;
+        m_allocated_objects++;
+
+        return allocation;
+    }
+
+    // Diagnostics, these include every buffer that this thread has been given
+    u64 allocated_bytes() const { return m_retired_bytes + (m_top - m_start); };
+    u64 allocated_objects() const { return m_allocated_objects; };
+    u64 refills() const { return m_refills; };
+
+private:
+    friend class Heap;
+
+    u8* m_start { nullptr };
+    u8* m_top { nullptr };
+    u8* m_end { nullptr };
+
+    // The bytes allocated from previous buffers, and objects which were too large for a buffer
+    u64 m_retired_bytes { 0 };
+    u64 m_allocated_objects { 0 };
+    u64 m_refills { 0 };
+};
+
+// Called with each reference that keeps an object alive. The garbage collector moves objects, so the visitor updates the reference to the object's new address.
+using ReferenceVisitor = Function<void(Object*&)>;
+
+// Visits a root which is stored as a Value (e.g. a local variable or a static field), which must hold a reference
+inline void visit_reference_value(Value& value, ReferenceVisitor const& visitor)
+{
+    auto* object = value.as_reference();
+    visitor(object);
+    value = Value::from_reference(object);
+}
+
+// The memory that every object lives in: a single region, which is reserved up front and split into two generations.
+//
+// New objects are allocated in the young generation's eden, which is carved into thread-local allocation buffers (TLABs),
+// so that threads don't contend with each other on every allocation. Most objects die young, so when eden is full,
+// only the young generation is collected: the objects that are still reachable are copied into a survivor space,
+// and the ones that have already survived a collection are promoted into the old generation.
+//
+// The old generation is only collected when it can't be sure to hold everything that a young collection might promote.
+// Like the young generation, it's split into two halves. A full collection marks every reachable object on several threads at once,
+// and then copies the marked objects into the empty half. See collect_garbage().
+//
+// A young collection doesn't look at the whole old generation, it only scans the objects whose cards have been dirtied by the write barrier.
+// See record_write().
+//
+// The region is mapped lazily by the kernel, so reserving a large heap only costs address space until it's used.
+// Memory from the region is zero-filled, which is the default value of every field and array element.
+class Heap {
+public:
+    // The size of the whole region, the young generation is an eighth of it
+    static constexpr size_t default_size = 512 * MiB;
+    static constexpr size_t allocation_buffer_size = 256 * KiB;
+
+    // Every allocation is rounded up to this, so that 8-byte fields and array elements stay aligned
+    static constexpr size_t object_alignment = 8;
+
+    // The granularity of the write barrier, a young collection scans every object that starts in a dirty card
+    static constexpr size_t card_shift = 9;
+    static constexpr size_t card_size = 1 << card_shift;
+
+    static constexpr u8 clean_card = 0;
+    static constexpr u8 dirty_card = 1;
+
+    enum class CollectionKind {
+        Young,
+        Full,
+    };
+
+    struct CollectionStatistics {
+        CollectionKind kind;
+        size_t used_before { 0 };
+        size_t used_after { 0 };
+        size_t surviving_objects { 0 };
+        size_t promoted_bytes { 0 };
+        u64 pause_nanoseconds { 0 };
+
+        // Only full collections have a mark phase
+        size_t marked_bytes { 0 };
+        u64 mark_nanoseconds { 0 };
+    };
+
+    Heap(u8* base, size_t size);
+    ~Heap();
+
+    static ErrorOr<NonnullOwnPtr<Heap>> create(size_t size = default_size);
+
+    // Returns null if the heap is full, the caller can collect garbage and try again (see Runtime::allocate_memory())
+    u8* allocate(ThreadLocalAllocationBuffer& allocation_buffer, size_t size)
+    {
+        size = align_up_to(size, object_alignment);
+        if (auto* allocation = allocation_buffer.try_allocate(size)) [[likely]]
+            return allocation;
+
+        return allocate_slow(allocation_buffer, size);
+    }
+
+    // The write barrier, which must be called whenever a reference is stored into an object (or an array).
+    // It dirties the card that the object starts in, so that the next young collection treats the object's references as roots,
+    // as the old generation could now reference a young object. It doesn't check which generation the object is in, as the check would cost more than the store.
+    // Static fields don't need it, they are roots of every collection.
+    void record_write(Object& object)
+    {
+        m_card_table[static_cast<size_t>(reinterpret_cast<u8*>(&object) - m_base) / card_size] = dirty_card;
+    }
+
+    // Compiled code does the same thing as record_write() inline, by storing to `biased_card_table() + (address >> card_shift)`.
+    // The bias is subtracted up front, so that the address of the object doesn't need to be made relative to the start of the heap first.
+    FlatPtr biased_card_table() const { return reinterpret_cast<FlatPtr>(m_card_table.data()) - (reinterpret_cast<FlatPtr>(m_base) >> card_shift); };
+
+    // Every thread's allocation buffer, they're emptied by each garbage collection, as the eden that they were in is freed
+    ErrorOr<void> add_allocation_buffer(ThreadLocalAllocationBuffer& allocation_buffer) { return m_allocation_buffers.try_append(&allocation_buffer); };
+
+    // A stop-the-world copying collection (Cheney's algorithm): every object that is reachable from the roots is copied out of the spaces that are being collected,
+    // and everything left behind is freed at once. The roots must be precise, as every reference to an object is updated when it moves.
+    //
+    // A young collection is turned into a full one if the old generation might not have room for the objects that it would promote.
+    void collect_garbage(CollectionKind kind, Function<void(ReferenceVisitor const&)> const& visit_roots);
+
+    // Keeps an object which is only referenced from C++ alive across an allocation, and updates the pointer if the object moves
+    class TemporaryRoot {
+    public:
+        TemporaryRoot(Heap& heap, Object*& object)
+            : m_heap(heap)
+        {
+            m_heap.m_temporary_roots.append(&object);
+        }
+
+        ~TemporaryRoot() { m_heap.m_temporary_roots.take_last(); };
+
+    private:
+        Heap& m_heap;
+    };
+
+    // The identity hash code of an object (i.e. Object.hashCode()), which has to stay the same after the object moves.
+    // It's derived from the object's address the first time that it's asked for, and remembered from then on.
+    ErrorOr<i32> identity_hash_code(Object& object);
+
+    // Logs the kind, the pause time and the number of bytes reclaimed by each collection
+    void set_logging_enabled(bool logging_enabled) { m_logging_enabled = logging_enabled; };
+
+    // Called after every collection, e.g. to record the distribution of pause times
+    void set_collection_observer(Function<void(CollectionStatistics const&)> observer) { m_collection_observer = move(observer); };
+
+    // When disabled, every collection is a full collection, which is only useful to compare the two
+    void set_young_collections_enabled(bool young_collections_enabled) { m_young_collections_enabled = young_collections_enabled; };
+
+    // The number of threads that mark objects during a full collection, including the thread that is collecting garbage
+    void set_marking_thread_count(size_t marking_thread_count) { m_marking_thread_count = max<size_t>(marking_thread_count, 1); };
+
+    // The most that objects can use at once: eden, a survivor space and half of the old generation
+    size_t size() const;
+    size_t used() const;
+
+    // Diagnostics
+    u64 collections() const { return m_young_collections + m_full_collections; };
+    u64 young_collections() const { return m_young_collections; };
+    u64 full_collections() const { return m_full_collections; };
+    u64 reclaimed_bytes() const { return m_reclaimed_bytes; };
+    u64 promoted_bytes() const { return m_promoted_bytes; };
+    u64 pause_nanoseconds() const { return m_pause_nanoseconds; };
+
+private:
+    // The first object which starts in a card isn't known
+    static constexpr u16 no_object_start = NumericLimits<u16>::max();
+
+    // Objects are allocated in a space by bumping the amount of it that's used.
+    // Only eden and the old generation are allocated from by more than one thread, survivor spaces are only filled by the garbage collector.
+    struct Space {
+        u8* start { nullptr };
+        size_t size { 0 };
+        Atomic<size_t> used { 0 };
+
+        bool contains(void const* address) const { return address >= start && address < start + size; };
+        u8* top() const { return start + used.load(AK::MemoryOrder::memory_order_relaxed); };
+
+        // Returns null if the space would be filled past `limit`
+        u8* claim(size_t bytes, size_t limit);
+    };
+
+    u8* allocate_slow(ThreadLocalAllocationBuffer& allocation_buffer, size_t size);
+
+    void collect_young_generation(Function<void(ReferenceVisitor const&)> const& visit_roots, CollectionStatistics&);
+    void collect_everything(Function<void(ReferenceVisitor const&)> const& visit_roots, CollectionStatistics&);
+
+    // Marks every object that is reachable from the roots, see collect_everything()
+    void mark_reachable_objects(ReadonlySpan<Object*> roots, CollectionStatistics&);
+
+    // Objects that didn't survive lose their identity hash code, and the ones that moved keep theirs
+    void update_identity_hash_codes(CollectionKind kind);
+
+    // Every allocation buffer was in eden, so the next allocation from each of them claims a new one
+    void reset_allocation_buffers();
+
+    // The old generation is only ever filled in address order, so the first object that starts in a card is the first one that's recorded
+    void record_object_start(u8* address);
+
+    // Calls the callback with each object that starts in the card, and before `end`
+    template<typename Callback>
+    void for_each_object_in_card(size_t card, u8* end, Callback callback);
+
+    size_t card_index(void const* address) const { return static_cast<size_t>(static_cast<u8 const*>(address) - m_base) / card_size; };
+    bool is_in_young_generation(void const* address) const { return address >= m_base && address < m_base + m_young_generation_size; };
+
+    Space& survivor_space() { return m_survivor_spaces[m_current_survivor_space]; };
+    Space& empty_survivor_space() { return m_survivor_spaces[1 - m_current_survivor_space]; };
+    Space& old_space() { return m_old_spaces[m_current_old_space]; };
+    Space& empty_old_space() { return m_old_spaces[1 - m_current_old_space]; };
+
+    // The whole region: eden, the two survivor spaces, and the two halves of the old generation, in that order
+    u8* m_base;
+    size_t m_size;
+    size_t m_young_generation_size;
+
+    Space m_eden;
+    Space m_survivor_spaces[2];
+    size_t m_current_survivor_space { 0 };
+
+    // Objects are allocated in (and promoted into) the current half, the other half is empty (and zeroed) until the next full collection copies objects into it.
+    // Promotion and allocation stop at `m_old_space_limit`, so that a full collection always has room for the whole young generation as well.
+    Space m_old_spaces[2];
+    size_t m_current_old_space { 0 };
+    size_t m_old_space_limit { 0 };
+
+    // One byte per card of the whole region, and the offset of the first object which starts in each card of the old generation
+    Vector<u8> m_card_table;
+    Vector<u16> m_first_object_in_card;
+
+    OwnPtr<MarkBitmap> m_mark_bitmap;
+    size_t m_marking_thread_count { 1 };
+
+    Vector<ThreadLocalAllocationBuffer*> m_allocation_buffers;
+    Vector<Object**> m_temporary_roots;
+    HashMap<Object*, i32> m_identity_hash_codes;
+
+    Function<void(CollectionStatistics const&)> m_collection_observer;
+    bool m_young_collections_enabled { true };
+    bool m_logging_enabled { false };
+
+    u64 m_young_collections { 0 };
+    u64 m_full_collections { 0 };
+    u64 m_reclaimed_bytes { 0 };
+    u64 m_promoted_bytes { 0 };
+    u64 m_pause_nanoseconds { 0 };
+};
+
+}
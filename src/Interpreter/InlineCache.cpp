@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "InlineCache.h"
+
+namespace Interpreter {
+
+void InlineCache::update(Class const& receiver_class, Method& method)
+{
+    if (m_is_megamorphic)
+        return;
+
+    // Once every entry is taken, the call site is megamorphic for good, so the entries don't need to be searched any more
+    if (m_entry_count == polymorphic_entry_count) {
+        m_entry_count = 0;
+        m_is_megamorphic = true;
+        return;
+    }
+
+    m_entries[m_entry_count++] = { &receiver_class, &method };
+}
+
+InlineCache::State InlineCache::state() const
+{
+    if (m_is_megamorphic)
+        return State::Megamorphic;
+
+    if (m_entry_count == 0)
+        return State::Empty;
+
+    return m_entry_count == 1 ? State::Monomorphic : State::Polymorphic;
+}
+
+}
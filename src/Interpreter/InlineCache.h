@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/Assertions.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+
+namespace Interpreter {
+
+// Forward-declaration
+class Class;
+class Method;
+
+// Remembers the method that was selected for each receiver class seen by an invokevirtual or invokeinterface instruction.
+//
+// Most call sites only ever see a single receiver class, so the cache starts out monomorphic (a single entry),
+// and grows into a polymorphic cache of up to `polymorphic_entry_count` entries as more receiver classes are seen.
+// A call site which sees even more receiver classes than that is megamorphic: it stops caching,
+// and every call selects the method from the receiver's class.
+class InlineCache {
+public:
+    enum class State : u8 {
+        Empty,
+        Monomorphic,
+        Polymorphic,
+        Megamorphic,
+    };
+
+    static constexpr size_t polymorphic_entry_count = 4;
+
+    InlineCache(Method& resolved_method, u32 bytecode_offset)
+        : m_resolved_method(resolved_method)
+        , m_bytecode_offset(bytecode_offset)
+    {
+    }
+
+    // The method that the call site's symbolic reference was resolved to
+    Method& resolved_method() { return m_resolved_method; };
+
+    // The offset of the call site in its method's bytecode
+    u32 bytecode_offset() const { return m_bytecode_offset; };
+
+    // Returns the method that was selected for the receiver class, or null if it has to be selected by the caller
+    Method* lookup(Class const& receiver_class)
+    {
+        for (size_t i = 0; i < m_entry_count; i++) {
+            if (m_entries[i].receiver_class == &receiver_class) [[likely]] {
+                m_hits++;
+                return m_entries[i].method;
+            }
+        }
+
+        m_misses++;
+        return nullptr;
+    }
+
+    // Remembers the method that was selected after a miss
+    void update(Class const& receiver_class, Method& method);
+
+    State state() const;
+
+    // The only entry of a monomorphic cache, the optimizing compiler inlines the method behind a check of the receiver's class
+    Class const* monomorphic_receiver_class() const
+    {
+        VERIFY(state() == State::Monomorphic);
+        return m_entries[0].receiver_class;
+    }
+
+    Method* monomorphic_method() const
+    {
+        VERIFY(state() == State::Monomorphic);
+        return m_entries[0].method;
+    }
+
+    // Diagnostics, every call through the call site is either a hit or a miss
+    u64 hits() const { return m_hits; };
+    u64 misses() const { return m_misses; };
+
+private:
+    struct Entry {
+        Class const* receiver_class { nullptr };
+        Method* method { nullptr };
+    };
+
+    Method& m_resolved_method;
+    u32 m_bytecode_offset;
+
+    Array<Entry, polymorphic_entry_count> m_entries;
+    u8 m_entry_count { 0 };
+    bool m_is_megamorphic { false };
+
+    u64 m_hits { 0 };
+    u64 m_misses { 0 };
+};
+
+constexpr StringView inline_cache_state_name(InlineCache::State state)
+{
+    switch (state) {
+    case InlineCache::State::Empty:
+        return "empty"sv;
+    case InlineCache::State::Monomorphic:
+        return "monomorphic"sv;
+    case InlineCache::State::Polymorphic:
+        return "polymorphic"sv;
+    case InlineCache::State::Megamorphic:
+        return "megamorphic"sv;
+    }
+
+    VERIFY_NOT_REACHED();
+}
+
+}
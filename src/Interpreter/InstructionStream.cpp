@@ -0,0 +1,564 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "InstructionStream.h"
+#include "Class.h"
+#include <AK/NumericLimits.h>
+
+namespace Interpreter {
+
+// Operands are stored in big-endian order, and aren't necessarily aligned
+static u16 read_u2(ReadonlyBytes code, size_t offset)
+{
+    return static_cast<u16>((code[offset] << 8) | code[offset + 1]);
+}
+
+static i16 read_i2(ReadonlyBytes code, size_t offset)
+{
+    return static_cast<i16>(read_u2(code, offset));
+}
+
+static i32 read_i4(ReadonlyBytes code, size_t offset)
+{
+    return static_cast<i32>((static_cast<u32>(read_u2(code, offset)) << 16) | read_u2(code, offset + 2));
+}
+
+// Returns the length of the instruction at the offset in bytes, including its opcode
+static ErrorOr<size_t> instruction_length_at(ReadonlyBytes code, size_t offset)
+{
+    if (code[offset] >= opcode_count) {
+        dbgln("InstructionStream: Unknown opcode {:#02x} at offset {}", code[offset], offset);
+        return Error::from_string_literal("java/lang/VerifyError");
+    }
+
+    auto opcode = static_cast<Opcode>(code[offset]);
+    switch (opcode) {
+    case Opcode::Tableswitch: {
+        // The operands start at the next multiple of 4 bytes from the start of the code, after 0 to 3 bytes of padding
+        auto operands = align_up_to(offset + 1, 4);
+        if (operands + 12 > code.size())
+            return Error::from_string_literal("java/lang/VerifyError");
+
+        auto low = read_i4(code, operands + 4);
+        auto high = read_i4(code, operands + 8);
+        if (low > high)
+            return Error::from_string_literal("java/lang/VerifyError");
+
+        return operands + 12 + static_cast<size_t>(static_cast<i64>(high) - low + 1) * 4 - offset;
+    }
+
+    case Opcode::Lookupswitch: {
+        auto operands = align_up_to(offset + 1, 4);
+        if (operands + 8 > code.size())
+            return Error::from_string_literal("java/lang/VerifyError");
+
+        auto pair_count = read_i4(code, operands + 4);
+        if (pair_count < 0)
+            return Error::from_string_literal("java/lang/VerifyError");
+
+        return operands + 8 + static_cast<size_t>(pair_count) * 8 - offset;
+    }
+
+    case Opcode::Wide:
+        if (offset + 1 >= code.size())
+            return Error::from_string_literal("java/lang/VerifyError");
+
+        // iinc has a second, two byte operand when it is modified by wide
+        return static_cast<Opcode>(code[offset + 1]) == Opcode::Iinc ? 6 : 4;
+
+    default:
+        return opcode_length(opcode);
+    }
+}
+
+// Execution must never fall off the end of the code, so the last instruction always transfers control somewhere else
+static bool is_unconditional_control_transfer(Opcode opcode)
+{
+    switch (opcode) {
+    case Opcode::Goto:
+    case Opcode::GotoW:
+    case Opcode::Ret:
+    case Opcode::Tableswitch:
+    case Opcode::Lookupswitch:
+    case Opcode::Ireturn:
+    case Opcode::Lreturn:
+    case Opcode::Freturn:
+    case Opcode::Dreturn:
+    case Opcode::Areturn:
+    case Opcode::Return:
+    case Opcode::Athrow:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The branches whose target is an instruction index, jsr isn't one of them as a subroutine isn't a loop
+static bool is_branch(Opcode opcode)
+{
+    switch (opcode) {
+    case Opcode::Ifeq:
+    case Opcode::Ifne:
+    case Opcode::Iflt:
+    case Opcode::Ifge:
+    case Opcode::Ifgt:
+    case Opcode::Ifle:
+    case Opcode::IfIcmpeq:
+    case Opcode::IfIcmpne:
+    case Opcode::IfIcmplt:
+    case Opcode::IfIcmpge:
+    case Opcode::IfIcmpgt:
+    case Opcode::IfIcmple:
+    case Opcode::IfAcmpeq:
+    case Opcode::IfAcmpne:
+    case Opcode::Goto:
+    case Opcode::GotoW:
+    case Opcode::Ifnull:
+    case Opcode::Ifnonnull:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Every branch that jumps backwards gets the index of its loop, loops are told apart by their header.
+// There are always fewer loops than 65536, as every branch takes up at least 3 bytes of the (at most 65535 byte) code.
+static ErrorOr<Vector<Loop>> find_loops(Vector<Instruction>& instructions)
+{
+    Vector<Loop> loops;
+    for (u32 index = 0; index < instructions.size(); index++) {
+        auto& instruction = instructions[index];
+        if (!is_branch(instruction.opcode) || static_cast<u32>(instruction.operand) > index)
+            continue;
+
+        auto header = static_cast<u32>(instruction.operand);
+        auto loop = loops.find_first_index_if([&](auto const& loop) { return loop.header == header; });
+        if (!loop.has_value()) {
+            loop = loops.size();
+            TRY(loops.try_append(Loop { .header = header }));
+        }
+
+        VERIFY(*loop <= NumericLimits<u16>::max());
+        instruction.index = static_cast<u16>(*loop);
+    }
+
+    return loops;
+}
+
+// Symbolicates the constant pool entry that an instruction refers to, which must be one of the expected types
+template<typename... Types>
+static ErrorOr<SymbolicatedReference*> reference_at(SymbolicatedConstantPool& constant_pool, u16 index, Types... expected_types)
+{
+    if (!constant_pool.parsed_pool()->is_valid_index(index)) {
+        dbgln("InstructionStream: Constant pool index {} is out of bounds", index);
+        return Error::from_string_literal("java/lang/VerifyError");
+    }
+
+    auto reference = TRY(constant_pool.get_or_symbolicate(index));
+    if (!reference || ((reference->type() != expected_types) && ...)) {
+        dbgln("InstructionStream: Constant pool entry {} has the wrong type for the instruction", index);
+        return Error::from_string_literal("java/lang/VerifyError");
+    }
+
+    // The constant pool keeps its entries alive for as long as the class exists
+    return reference.ptr();
+}
+
+InstructionStream::InstructionStream(Vector<Instruction> instructions, Vector<u32> bytecode_offsets, Vector<NonnullOwnPtr<SwitchTable>> switch_tables, Vector<ExceptionHandler> exception_handlers, Vector<Loop> loops, ReferenceMaps reference_maps)
+    : m_instructions(move(instructions))
+    , m_bytecode_offsets(move(bytecode_offsets))
+    , m_switch_tables(move(switch_tables))
+    , m_exception_handlers(move(exception_handlers))
+    , m_loops(move(loops))
+    , m_reference_maps(move(reference_maps))
+{
+}
+
+ErrorOr<InlineCache*> InstructionStream::add_inline_cache(Method& resolved_method, u32 bytecode_offset)
+{
+    auto inline_cache = TRY(try_make<InlineCache>(resolved_method, bytecode_offset));
+    auto* inline_cache_ptr = inline_cache.ptr();
+
+    TRY(m_inline_caches.try_append(move(inline_cache)));
+    return inline_cache_ptr;
+}
+
+ErrorOr<StringConcatenation const*> InstructionStream::add_string_concatenation(NonnullOwnPtr<StringConcatenation> string_concatenation)
+{
+    auto* string_concatenation_ptr = string_concatenation.ptr();
+    TRY(m_string_concatenations.try_append(move(string_concatenation)));
+    return string_concatenation_ptr;
+}
+
+ErrorOr<NonnullOwnPtr<InstructionStream>> InstructionStream::decode(Method& method)
+{
+    VERIFY(method.code());
+    VERIFY(method.owner().constant_pool());
+
+    auto code = method.code()->code();
+    auto& constant_pool = *method.owner().constant_pool();
+
+    // The first pass finds where each instruction starts, so that branch targets can be turned into instruction indices
+    static constexpr u32 not_an_instruction = NumericLimits<u32>::max();
+
+    Vector<u32> bytecode_offsets;
+    Vector<u32> instruction_indices;
+    TRY(instruction_indices.try_resize(code.size()));
+    instruction_indices.span().fill(not_an_instruction);
+
+    for (size_t offset = 0; offset < code.size();) {
+        auto length = TRY(instruction_length_at(code, offset));
+        if (offset + length > code.size()) {
+            dbgln("InstructionStream: The last instruction of {}.{}{} is truncated", method.owner().name(), method.name(), method.descriptor());
+            return Error::from_string_literal("java/lang/VerifyError");
+        }
+
+        instruction_indices[offset] = bytecode_offsets.size();
+        TRY(bytecode_offsets.try_append(offset));
+        offset += length;
+    }
+
+    if (bytecode_offsets.is_empty() || !is_unconditional_control_transfer(static_cast<Opcode>(code[bytecode_offsets.last()]))) {
+        dbgln("InstructionStream: Execution can fall off the end of {}.{}{}", method.owner().name(), method.name(), method.descriptor());
+        return Error::from_string_literal("java/lang/VerifyError");
+    }
+
+    // The target of every branch must be the start of an instruction
+    auto target_at = [&](size_t offset, i64 relative_offset) -> ErrorOr<i32> {
+        auto target = static_cast<i64>(offset) + relative_offset;
+        if (target < 0 || target >= static_cast<i64>(code.size()) || instruction_indices[target] == not_an_instruction) {
+            dbgln("InstructionStream: The branch at offset {} in {}.{}{} has an invalid target", offset, method.owner().name(), method.name(), method.descriptor());
+            return Error::from_string_literal("java/lang/VerifyError");
+        }
+
+        return static_cast<i32>(instruction_indices[target]);
+    };
+
+    Vector<Instruction> instructions;
+    Vector<NonnullOwnPtr<SwitchTable>> switch_tables;
+    TRY(instructions.try_ensure_capacity(bytecode_offsets.size()));
+
+    for (auto offset : bytecode_offsets) {
+        Instruction instruction;
+        instruction.opcode = static_cast<Opcode>(code[offset]);
+
+        switch (instruction.opcode) {
+        // Constants
+        case Opcode::IconstM1:
+        case Opcode::Iconst0:
+        case Opcode::Iconst1:
+        case Opcode::Iconst2:
+        case Opcode::Iconst3:
+        case Opcode::Iconst4:
+        case Opcode::Iconst5:
+            instruction.operand = to_underlying(instruction.opcode) - to_underlying(Opcode::Iconst0);
+            break;
+
+        case Opcode::Lconst0:
+        case Opcode::Lconst1:
+            instruction.operand = to_underlying(instruction.opcode) - to_underlying(Opcode::Lconst0);
+            break;
+
+        case Opcode::Fconst0:
+        case Opcode::Fconst1:
+        case Opcode::Fconst2:
+            instruction.operand = to_underlying(instruction.opcode) - to_underlying(Opcode::Fconst0);
+            break;
+
+        case Opcode::Dconst0:
+        case Opcode::Dconst1:
+            instruction.operand = to_underlying(instruction.opcode) - to_underlying(Opcode::Dconst0);
+            break;
+
+        case Opcode::Bipush:
+            instruction.operand = static_cast<i8>(code[offset + 1]);
+            break;
+
+        case Opcode::Sipush:
+            instruction.operand = read_i2(code, offset + 1);
+            break;
+
+        case Opcode::Ldc:
+            instruction.reference = TRY(reference_at(constant_pool, code[offset + 1], SymbolicatedReference::Numeric, SymbolicatedReference::String, SymbolicatedReference::Class, SymbolicatedReference::MethodType, SymbolicatedReference::MethodHandle, SymbolicatedReference::DynamicConstant));
+            break;
+
+        case Opcode::LdcW:
+            instruction.reference = TRY(reference_at(constant_pool, read_u2(code, offset + 1), SymbolicatedReference::Numeric, SymbolicatedReference::String, SymbolicatedReference::Class, SymbolicatedReference::MethodType, SymbolicatedReference::MethodHandle, SymbolicatedReference::DynamicConstant));
+            break;
+
+        case Opcode::Ldc2W:
+            instruction.reference = TRY(reference_at(constant_pool, read_u2(code, offset + 1), SymbolicatedReference::Numeric, SymbolicatedReference::DynamicConstant));
+            break;
+
+        // Local variables, the implicit index of e.g. iload_0 is made explicit
+        case Opcode::Iload:
+        case Opcode::Lload:
+        case Opcode::Fload:
+        case Opcode::Dload:
+        case Opcode::Aload:
+        case Opcode::Istore:
+        case Opcode::Lstore:
+        case Opcode::Fstore:
+        case Opcode::Dstore:
+        case Opcode::Astore:
+        case Opcode::Ret:
+            instruction.index = code[offset + 1];
+            break;
+
+        case Opcode::Iload0:
+        case Opcode::Iload1:
+        case Opcode::Iload2:
+        case Opcode::Iload3:
+            instruction.index = to_underlying(instruction.opcode) - to_underlying(Opcode::Iload0);
+            break;
+
+        case Opcode::Lload0:
+        case Opcode::Lload1:
+        case Opcode::Lload2:
+        case Opcode::Lload3:
+            instruction.index = to_underlying(instruction.opcode) - to_underlying(Opcode::Lload0);
+            break;
+
+        case Opcode::Fload0:
+        case Opcode::Fload1:
+        case Opcode::Fload2:
+        case Opcode::Fload3:
+            instruction.index = to_underlying(instruction.opcode) - to_underlying(Opcode::Fload0);
+            break;
+
+        case Opcode::Dload0:
+        case Opcode::Dload1:
+        case Opcode::Dload2:
+        case Opcode::Dload3:
+            instruction.index = to_underlying(instruction.opcode) - to_underlying(Opcode::Dload0);
+            break;
+
+        case Opcode::Aload0:
+        case Opcode::Aload1:
+        case Opcode::Aload2:
+        case Opcode::Aload3:
+            instruction.index = to_underlying(instruction.opcode) - to_underlying(Opcode::Aload0);
+            break;
+
+        case Opcode::Istore0:
+        case Opcode::Istore1:
+        case Opcode::Istore2:
+        case Opcode::Istore3:
+            instruction.index = to_underlying(instruction.opcode) - to_underlying(Opcode::Istore0);
+            break;
+
+        case Opcode::Lstore0:
+        case Opcode::Lstore1:
+        case Opcode::Lstore2:
+        case Opcode::Lstore3:
+            instruction.index = to_underlying(instruction.opcode) - to_underlying(Opcode::Lstore0);
+            break;
+
+        case Opcode::Fstore0:
+        case Opcode::Fstore1:
+        case Opcode::Fstore2:
+        case Opcode::Fstore3:
+            instruction.index = to_underlying(instruction.opcode) - to_underlying(Opcode::Fstore0);
+            break;
+
+        case Opcode::Dstore0:
+        case Opcode::Dstore1:
+        case Opcode::Dstore2:
+        case Opcode::Dstore3:
+            instruction.index = to_underlying(instruction.opcode) - to_underlying(Opcode::Dstore0);
+            break;
+
+        case Opcode::Astore0:
+        case Opcode::Astore1:
+        case Opcode::Astore2:
+        case Opcode::Astore3:
+            instruction.index = to_underlying(instruction.opcode) - to_underlying(Opcode::Astore0);
+            break;
+
+        case Opcode::Iinc:
+            instruction.index = code[offset + 1];
+            instruction.operand = static_cast<i8>(code[offset + 2]);
+            break;
+
+        // The wide instruction's opcode is replaced by the opcode that it modifies
+        case Opcode::Wide: {
+            instruction.opcode = static_cast<Opcode>(code[offset + 1]);
+            instruction.index = read_u2(code, offset + 2);
+
+            switch (instruction.opcode) {
+            case Opcode::Iload:
+            case Opcode::Lload:
+            case Opcode::Fload:
+            case Opcode::Dload:
+            case Opcode::Aload:
+            case Opcode::Istore:
+            case Opcode::Lstore:
+            case Opcode::Fstore:
+            case Opcode::Dstore:
+            case Opcode::Astore:
+            case Opcode::Ret:
+                break;
+
+            case Opcode::Iinc:
+                instruction.operand = read_i2(code, offset + 4);
+                break;
+
+            default:
+                dbgln("InstructionStream: {} can't be modified by wide", opcode_name(instruction.opcode));
+                return Error::from_string_literal("java/lang/VerifyError");
+            }
+
+            break;
+        }
+
+        // Branches
+        case Opcode::Ifeq:
+        case Opcode::Ifne:
+        case Opcode::Iflt:
+        case Opcode::Ifge:
+        case Opcode::Ifgt:
+        case Opcode::Ifle:
+        case Opcode::IfIcmpeq:
+        case Opcode::IfIcmpne:
+        case Opcode::IfIcmplt:
+        case Opcode::IfIcmpge:
+        case Opcode::IfIcmpgt:
+        case Opcode::IfIcmple:
+        case Opcode::IfAcmpeq:
+        case Opcode::IfAcmpne:
+        case Opcode::Goto:
+        case Opcode::Jsr:
+        case Opcode::Ifnull:
+        case Opcode::Ifnonnull:
+            instruction.operand = TRY(target_at(offset, read_i2(code, offset + 1)));
+            break;
+
+        case Opcode::GotoW:
+        case Opcode::JsrW:
+            instruction.operand = TRY(target_at(offset, read_i4(code, offset + 1)));
+            break;
+
+        case Opcode::Tableswitch: {
+            auto operands = align_up_to(offset + 1, 4);
+            auto switch_table = TRY(try_make<SwitchTable>());
+            switch_table->default_target = TRY(target_at(offset, read_i4(code, operands)));
+            switch_table->low = read_i4(code, operands + 4);
+
+            auto high = read_i4(code, operands + 8);
+            auto target_count = static_cast<size_t>(static_cast<i64>(high) - switch_table->low + 1);
+            TRY(switch_table->targets.try_ensure_capacity(target_count));
+            for (size_t i = 0; i < target_count; i++)
+                switch_table->targets.unchecked_append(TRY(target_at(offset, read_i4(code, operands + 12 + i * 4))));
+
+            instruction.switch_table = switch_table.ptr();
+            TRY(switch_tables.try_append(move(switch_table)));
+            break;
+        }
+
+        case Opcode::Lookupswitch: {
+            auto operands = align_up_to(offset + 1, 4);
+            auto switch_table = TRY(try_make<SwitchTable>());
+            switch_table->default_target = TRY(target_at(offset, read_i4(code, operands)));
+
+            auto pair_count = static_cast<size_t>(read_i4(code, operands + 4));
+            TRY(switch_table->matches.try_ensure_capacity(pair_count));
+            TRY(switch_table->targets.try_ensure_capacity(pair_count));
+            for (size_t i = 0; i < pair_count; i++) {
+                auto match = read_i4(code, operands + 8 + i * 8);
+
+                // The pairs must be sorted in increasing numerical order by match, so that they can be binary searched
+                if (i > 0 && match <= switch_table->matches.last()) {
+                    dbgln("InstructionStream: The lookupswitch at offset {} isn't sorted", offset);
+                    return Error::from_string_literal("java/lang/VerifyError");
+                }
+
+                switch_table->matches.unchecked_append(match);
+                switch_table->targets.unchecked_append(TRY(target_at(offset, read_i4(code, operands + 8 + i * 8 + 4))));
+            }
+
+            instruction.switch_table = switch_table.ptr();
+            TRY(switch_tables.try_append(move(switch_table)));
+            break;
+        }
+
+        // References to the run-time constant pool
+        case Opcode::Getstatic:
+        case Opcode::Putstatic:
+        case Opcode::Getfield:
+        case Opcode::Putfield:
+            instruction.reference = TRY(reference_at(constant_pool, read_u2(code, offset + 1), SymbolicatedReference::Field));
+            break;
+
+        // Since class files version 52.0, invokespecial and invokestatic can also refer to interface methods
+        case Opcode::Invokevirtual:
+        case Opcode::Invokespecial:
+        case Opcode::Invokestatic:
+            instruction.reference = TRY(reference_at(constant_pool, read_u2(code, offset + 1), SymbolicatedReference::Method, SymbolicatedReference::InterfaceMethod));
+            break;
+
+        // The count operand of invokeinterface is redundant, the number of argument slots comes from the method's descriptor
+        case Opcode::Invokeinterface:
+            instruction.reference = TRY(reference_at(constant_pool, read_u2(code, offset + 1), SymbolicatedReference::InterfaceMethod));
+            break;
+
+        case Opcode::Invokedynamic:
+            instruction.reference = TRY(reference_at(constant_pool, read_u2(code, offset + 1), SymbolicatedReference::DynamicCallSite));
+            break;
+
+        case Opcode::New:
+        case Opcode::Anewarray:
+        case Opcode::Checkcast:
+        case Opcode::Instanceof:
+            instruction.reference = TRY(reference_at(constant_pool, read_u2(code, offset + 1), SymbolicatedReference::Class));
+            break;
+
+        case Opcode::Multianewarray:
+            instruction.reference = TRY(reference_at(constant_pool, read_u2(code, offset + 1), SymbolicatedReference::Class));
+            instruction.index = code[offset + 3];
+            if (instruction.index == 0)
+                return Error::from_string_literal("java/lang/VerifyError");
+            break;
+
+        case Opcode::Newarray:
+            instruction.index = code[offset + 1];
+            break;
+
+        // Everything else only has operands on the operand stack
+        default:
+            break;
+        }
+
+        instructions.unchecked_append(instruction);
+    }
+
+    // The exception table uses bytecode offsets as well, its end_pc is exclusive, so it can also be the length of the code
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.7.3
+    Vector<ExceptionHandler> exception_handlers;
+    for (auto const& entry : TRY(method.code()->exception_table())) {
+        auto is_valid_offset = [&](u16 offset) { return offset < code.size() && instruction_indices[offset] != not_an_instruction; };
+        if (!is_valid_offset(entry.start_pc) || !is_valid_offset(entry.handler_pc) || (entry.end_pc != code.size() && !is_valid_offset(entry.end_pc)) || entry.start_pc >= entry.end_pc) {
+            dbgln("InstructionStream: An exception handler of {}.{}{} has an invalid range", method.owner().name(), method.name(), method.descriptor());
+            return Error::from_string_literal("java/lang/VerifyError");
+        }
+
+        ExceptionHandler handler {
+            .start = instruction_indices[entry.start_pc],
+            .end = entry.end_pc == code.size() ? static_cast<u32>(instructions.size()) : instruction_indices[entry.end_pc],
+            .handler = instruction_indices[entry.handler_pc],
+        };
+
+        if (entry.catch_type != 0)
+            handler.catch_type = static_cast<SymbolicatedClassReference*>(TRY(reference_at(constant_pool, entry.catch_type, SymbolicatedReference::Class)));
+
+        TRY(exception_handlers.try_append(handler));
+    }
+
+    auto loops = TRY(find_loops(instructions));
+    auto reference_maps = TRY(ReferenceMaps::compute(method, instructions, exception_handlers));
+    return try_make<InstructionStream>(move(instructions), move(bytecode_offsets), move(switch_tables), move(exception_handlers), move(loops), move(reference_maps));
+}
+
+}
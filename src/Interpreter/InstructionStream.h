@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "../JIT/CompiledCode.h"
+#include "InlineCache.h"
+#include "Opcode.h"
+#include "ReferenceMaps.h"
+#include "SymbolicatedReference.h"
+#include "Value.h"
+#include <AK/NonnullOwnPtr.h>
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
+
+namespace Interpreter {
+
+// Forward-declaration
+class Class;
+class Method;
+
+// The cases of a tableswitch or lookupswitch instruction, with their targets resolved to instruction indices
+struct SwitchTable {
+    // The index of the instruction to jump to when none of the cases match
+    u32 default_target { 0 };
+
+    // tableswitch: the cases are `low`, `low + 1`, ..., `low + targets.size() - 1`
+    i32 low { 0 };
+
+    // lookupswitch: the sorted match values, `targets[i]` is the target of `matches[i]`
+    Vector<i32> matches;
+
+    Vector<u32> targets;
+};
+
+// An invokedynamic call site that has been linked to string concatenation, see Runtime::resolve_call_site().
+// https://docs.oracle.com/en/java/javase/17/docs/api/java.base/java/lang/invoke/StringConcatFactory.html
+//
+// The recipe has already been split up into the constant text and the arguments, in the order that they're appended.
+struct StringConcatenation {
+    struct Part {
+        // How the argument is converted to a string: the first character of its descriptor, except that bytes and shorts are ints, and arrays are objects.
+        // This is 0 for constant text.
+        char argument_type { 0 };
+
+        // The argument's slot, counted from the first argument
+        u16 argument_slot { 0 };
+
+        Symbol text;
+    };
+
+    Vector<Part> parts;
+
+    // The number of operand stack slots that the arguments take up, which are replaced by the string
+    u16 argument_slots { 0 };
+};
+
+// An entry of the exception table, with its bytecode offsets resolved to instruction indices
+struct ExceptionHandler {
+    // The handler is active while the instructions in [start, end) are executing
+    u32 start { 0 };
+    u32 end { 0 };
+    u32 handler { 0 };
+
+    // Null if the handler catches every exception, e.g. for a `finally` block
+    SymbolicatedClassReference* catch_type { nullptr };
+};
+
+// A single instruction of the interpreter's internal form.
+//
+// Every instruction has the same size, and its operands have already been read out of the bytecode,
+// so moving to the next instruction is always `instruction + 1`.
+struct Instruction {
+    // The opcode of the original instruction, wide is folded into the instruction that it modifies
+    Opcode opcode { Opcode::Nop };
+
+    // The local variable index of loads, stores, iinc and ret (including the implicit index of e.g. iload_0),
+    // the atype of newarray, the number of dimensions of multianewarray, or the loop of a branch that jumps backwards (see InstructionStream::loops()).
+    u16 index { 0 };
+
+    // The value pushed by iconst_<i>, lconst_<l>, fconst_<f>, dconst_<d>, bipush and sipush, the increment of iinc,
+    // the index of the instruction that a branch, goto or jsr jumps to, or the offset of the field accessed by the quick forms of getfield and putfield.
+    i32 operand { 0 };
+
+    union {
+        // The entry in the run-time constant pool that the instruction refers to, until it is quickened
+        SymbolicatedReference* reference { nullptr };
+
+        // tableswitch and lookupswitch
+        SwitchTable const* switch_table;
+
+        // The operands of quickened instructions, these replace the reference that they were resolved from.
+        // ldc_quick's value is stored as its bits, as a Value can't be a member of a union.
+        u64 constant_bits;
+        Value* static_value;
+        Method* method;
+        Class* klass;
+        InlineCache* inline_cache;
+        StringConcatenation const* string_concatenation;
+    };
+};
+
+static_assert(sizeof(Instruction) == 16, "Instructions should stay small, so that more of them fit in a cache line");
+
+// A loop is whatever the branches that jump backwards to the same instruction (its header) enclose.
+// Each of those branches counts towards the loop's back-edges, see TieringPolicy.
+struct Loop {
+    // The index of the instruction that the loop's back-edges jump to
+    u32 header { 0 };
+
+    u64 backedge_count { 0 };
+};
+
+// The bytecode of a method, decoded into fixed-width instructions.
+//
+// Decoding happens once, when the method is first invoked, and does everything that doesn't depend on run-time state:
+// - Variable-length instructions, `wide` prefixes, and the padding of tableswitch and lookupswitch are gone.
+// - Branch targets are the index of an instruction, instead of a byte offset.
+// - Constant pool indices have been replaced by pointers into the symbolicated constant pool.
+// - The reference maps of the garbage collector have been computed, see ReferenceMaps.
+//
+// Anything that does depend on run-time state is done by the interpreter, which rewrites an instruction to its quick form
+// the first time that it is executed (e.g. getfield becomes getfield_quick, with the field's offset as its operand).
+class InstructionStream {
+public:
+    InstructionStream(Vector<Instruction> instructions, Vector<u32> bytecode_offsets, Vector<NonnullOwnPtr<SwitchTable>> switch_tables, Vector<ExceptionHandler> exception_handlers, Vector<Loop> loops, ReferenceMaps reference_maps);
+
+    // Decodes the bytecode of a method which has a Code attribute
+    static ErrorOr<NonnullOwnPtr<InstructionStream>> decode(Method& method);
+
+    // The instructions aren't const, as they are quickened in-place
+    Instruction* instructions() { return m_instructions.data(); };
+    size_t size() const { return m_instructions.size(); };
+
+    // The offset of the instruction at the index in the original bytecode, e.g. for exception tables and line numbers
+    u32 bytecode_offset(size_t index) const { return m_bytecode_offsets[index]; };
+
+    // The inline caches of the invokevirtual and invokeinterface instructions, these are created when a call site is quickened
+    ErrorOr<InlineCache*> add_inline_cache(Method& resolved_method, u32 bytecode_offset);
+    Vector<NonnullOwnPtr<InlineCache>> const& inline_caches() const { return m_inline_caches; };
+
+    // The string concatenations of the invokedynamic instructions, these are created when a call site is linked
+    ErrorOr<StringConcatenation const*> add_string_concatenation(NonnullOwnPtr<StringConcatenation> string_concatenation);
+
+    // In the order of the exception table, which is the order that they're searched in when an exception is thrown
+    Vector<ExceptionHandler> const& exception_handlers() const { return m_exception_handlers; };
+
+    // Which slots of a frame that is executing this method hold references, see Interpreter::visit_roots()
+    ReferenceMaps const& reference_maps() const { return m_reference_maps; };
+
+    // ldc_quick instructions whose constant is an object (i.e. a string) are roots of the garbage collector, which updates them if it moves the object
+    ErrorOr<void> add_reference_constant(Instruction& instruction) { return m_reference_constants.try_append(static_cast<u32>(&instruction - m_instructions.data())); };
+
+    bool is_reference_constant(Instruction const& instruction) const { return m_reference_constants.contains_slow(static_cast<u32>(&instruction - m_instructions.data())); };
+
+    template<typename Callback>
+    void for_each_reference_constant(Callback callback)
+    {
+        for (auto index : m_reference_constants)
+            callback(m_instructions[index]);
+    }
+
+    // How hot the method is, which decides when it gets compiled. See TieringPolicy.
+    u64 invocation_count() const { return m_invocation_count; };
+    void count_invocation() { m_invocation_count++; };
+
+    // The back-edges of every loop in the method, added together
+    u64 backedge_count() const { return m_backedge_count; };
+
+    // Only branches which jump backwards are counted, a loop made out of a tableswitch or lookupswitch never gets hot. Returns the loop's new count.
+    u64 count_backedge(u16 loop)
+    {
+        m_backedge_count++;
+        return ++m_loops[loop].backedge_count;
+    }
+
+    // In the order that their first back-edge appears in the method
+    Vector<Loop> const& loops() const { return m_loops; };
+
+    // Baseline code increments the counters itself, see JIT::BaselineCompiler
+    u64* backedge_count_pointer() { return &m_backedge_count; };
+    u64* loop_backedge_count_pointer(u16 loop) { return &m_loops[loop].backedge_count; };
+
+    // The method's machine code, if it has been compiled
+    JIT::CompiledCode* compiled_code() { return m_compiled_code.ptr(); };
+    void set_compiled_code(NonnullOwnPtr<JIT::CompiledCode> compiled_code)
+    {
+        m_compiled_code = move(compiled_code);
+        m_compilation_count++;
+    }
+
+    // The method is still hot, so it's compiled again when it's next invoked (or loops), which is bounded by TieringPolicy::compilation_limit
+    void discard_compiled_code() { m_compiled_code = nullptr; };
+
+    u32 compilation_count() const { return m_compilation_count; };
+
+    // A method that can't be compiled (or that has been compiled too many times) is only ever interpreted
+    bool is_compilable() const { return m_is_compilable; };
+    void set_not_compilable() { m_is_compilable = false; };
+
+    // A method that can't be optimized (or whose optimized code has been thrown away) stays in baseline code
+    bool is_optimizable() const { return m_is_optimizable; };
+    void set_not_optimizable() { m_is_optimizable = false; };
+
+private:
+    Vector<Instruction> m_instructions;
+    Vector<u32> m_bytecode_offsets;
+
+    // Referenced by the tableswitch and lookupswitch instructions
+    Vector<NonnullOwnPtr<SwitchTable>> m_switch_tables;
+
+    // Referenced by the invokevirtual_quick and invokeinterface_quick instructions
+    Vector<NonnullOwnPtr<InlineCache>> m_inline_caches;
+
+    // Referenced by the invokedynamic_quick instructions
+    Vector<NonnullOwnPtr<StringConcatenation>> m_string_concatenations;
+
+    Vector<ExceptionHandler> m_exception_handlers;
+
+    Vector<Loop> m_loops;
+
+    ReferenceMaps m_reference_maps;
+
+    // The indices of the ldc_quick instructions with an object as their constant
+    Vector<u32> m_reference_constants;
+
+    u64 m_invocation_count { 0 };
+    u64 m_backedge_count { 0 };
+
+    OwnPtr<JIT::CompiledCode> m_compiled_code;
+    u32 m_compilation_count { 0 };
+    bool m_is_compilable { true };
+    bool m_is_optimizable { true };
+};
+
+}
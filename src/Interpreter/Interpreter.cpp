@@ -0,0 +1,1962 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Interpreter.h"
+#include "../JIT/BaselineCompiler.h"
+#include "../JIT/OptimizingCompiler.h"
+#include "FloatingPoint.h"
+#include "Natives.h"
+#include "Opcode.h"
+#include "Runtime.h"
+#include <AK/Array.h>
+#include <AK/ScopeGuard.h>
+#include <math.h>
+
+namespace Interpreter {
+
+// Each getfield and putfield is quickened to the form that loads or stores the field's type, using the same sizes as arrays
+static Opcode getfield_quick_opcode(char descriptor)
+{
+    switch (descriptor) {
+    case FieldDescriptor::Byte:
+    case FieldDescriptor::Boolean:
+        return Opcode::GetfieldByteQuick;
+    case FieldDescriptor::Char:
+        return Opcode::GetfieldCharQuick;
+    case FieldDescriptor::Short:
+        return Opcode::GetfieldShortQuick;
+    case FieldDescriptor::Int:
+    case FieldDescriptor::Float:
+        return Opcode::GetfieldIntQuick;
+    case FieldDescriptor::Long:
+    case FieldDescriptor::Double:
+        return Opcode::GetfieldLongQuick;
+    default:
+        return Opcode::GetfieldReferenceQuick;
+    }
+}
+
+static Opcode putfield_quick_opcode(char descriptor)
+{
+    switch (descriptor) {
+    case FieldDescriptor::Boolean:
+        return Opcode::PutfieldBooleanQuick;
+    case FieldDescriptor::Byte:
+        return Opcode::PutfieldByteQuick;
+    case FieldDescriptor::Char:
+    case FieldDescriptor::Short:
+        return Opcode::PutfieldShortQuick;
+    case FieldDescriptor::Int:
+    case FieldDescriptor::Float:
+        return Opcode::PutfieldIntQuick;
+    case FieldDescriptor::Long:
+    case FieldDescriptor::Double:
+        return Opcode::PutfieldLongQuick;
+    default:
+        return Opcode::PutfieldReferenceQuick;
+    }
+}
+
+Interpreter::Interpreter(Runtime& runtime, DispatchMode dispatch_mode, Vector<Value> stack, OwnPtr<JIT::CodeCache> code_cache)
+    : m_runtime(runtime)
+    , m_dispatch_mode(dispatch_mode)
+    , m_stack(move(stack))
+    , m_code_cache(move(code_cache))
+{
+    m_stack_top = m_stack.data();
+    m_jit_enabled = m_code_cache.ptr() != nullptr;
+}
+
+ErrorOr<NonnullOwnPtr<Interpreter>> Interpreter::create(Runtime& runtime, DispatchMode dispatch_mode)
+{
+    if (!is_dispatch_mode_supported(dispatch_mode))
+        return Error::from_string_literal("Threaded dispatch requires a build with CAOVM_COMPUTED_GOTO enabled");
+
+    auto stack = Vector<Value>();
+    TRY(stack.try_resize(stack_slot_count));
+
+    OwnPtr<JIT::CodeCache> code_cache;
+    if constexpr (is_jit_supported())
+        code_cache = TRY(JIT::CodeCache::create());
+
+    return try_make<Interpreter>(runtime, dispatch_mode, move(stack), move(code_cache));
+}
+
+ErrorOr<Value> Interpreter::invoke(Method& method, ReadonlySpan<Value> arguments)
+{
+    VERIFY(arguments.size() == method.argument_slots());
+
+    auto* stack_end = m_stack.data() + m_stack.size();
+    if (arguments.size() > static_cast<size_t>(stack_end - m_stack_top))
+        return Error::from_string_literal("java/lang/StackOverflowError");
+
+    // The arguments are copied to the top of the stack, where they become the callee's local variables
+    auto* frame = m_stack_top;
+    for (size_t i = 0; i < arguments.size(); i++)
+        frame[i] = arguments[i];
+
+    return invoke_in_place(method, frame);
+}
+
+ErrorOr<Value> Interpreter::invoke_in_place(Method& method, Value* arguments)
+{
+#if CAOVM_COMPUTED_GOTO
+    if (m_dispatch_mode == DispatchMode::Threaded)
+        return call<DispatchMode::Threaded>(method, arguments);
+#endif
+
+    return call<DispatchMode::Switch>(method, arguments);
+}
+
+template<DispatchMode mode>
+ErrorOr<Value> Interpreter::call(Method& method, Value* arguments)
+{
+    auto* code = method.code();
+    if (!method.is_native() && !code) {
+        dbgln("Interpreter: {}.{}{} does not have any code", method.owner().name(), method.name(), method.descriptor());
+        return Error::from_string_literal("java/lang/AbstractMethodError");
+    }
+
+    // A frame's local variables start at its arguments, and its operand stack immediately follows them
+    auto* frame_end = method.is_native()
+        ? arguments + method.argument_slots()
+        : arguments + code->max_locals() + code->max_stack();
+
+    if (frame_end > m_stack.data() + m_stack.size())
+        return Error::from_string_literal("java/lang/StackOverflowError");
+
+    auto* previous_stack_top = m_stack_top;
+    m_stack_top = max(m_stack_top, frame_end);
+    ScopeGuard restore_stack_top = [&] {
+        m_stack_top = previous_stack_top;
+    };
+
+    if (method.is_native())
+        return method.native_function()(m_runtime, { arguments, method.argument_slots() });
+
+    auto& instruction_stream = *TRY(method.instructions());
+    instruction_stream.count_invocation();
+    if (m_jit_enabled) {
+        if (!instruction_stream.compiled_code() && m_tiering_policy.should_compile(instruction_stream))
+            compile(method, instruction_stream);
+        else if (m_tiering_policy.should_optimize(instruction_stream))
+            optimize(method, instruction_stream);
+
+        if (instruction_stream.compiled_code())
+            return execute_compiled_code<mode>(method, instruction_stream, arguments);
+    }
+
+    return execute<mode>(method, instruction_stream, arguments);
+}
+
+void Interpreter::compile(Method& method, InstructionStream& instruction_stream)
+{
+    // Code which keeps being thrown away isn't worth compiling again
+    if (instruction_stream.compilation_count() >= TieringPolicy::compilation_limit) {
+        if (m_jit_logging_enabled)
+            dbgln("JIT: {}.{}{} has been compiled {} times, it will only be interpreted from now on", method.owner().name(), method.name(), method.descriptor(), instruction_stream.compilation_count());
+
+        instruction_stream.set_not_compilable();
+        return;
+    }
+
+    auto compiled_code = JIT::BaselineCompiler::compile(method, instruction_stream, m_runtime.heap(), *m_code_cache, m_tiering_policy);
+    if (compiled_code.is_error()) {
+        if (m_jit_logging_enabled)
+            dbgln("JIT: Failed to compile {}.{}{}: {}", method.owner().name(), method.name(), method.descriptor(), compiled_code.error());
+
+        instruction_stream.set_not_compilable();
+        return;
+    }
+
+    if (m_jit_logging_enabled) {
+        dbgln("JIT: Compiled {}.{}{} ({} instructions, {} invocations, {} back-edges) into {} bytes",
+            method.owner().name(), method.name(), method.descriptor(), instruction_stream.size(),
+            instruction_stream.invocation_count(), instruction_stream.backedge_count(), compiled_code.value()->size());
+    }
+
+    instruction_stream.set_compiled_code(compiled_code.release_value());
+}
+
+void Interpreter::optimize(Method& method, InstructionStream& instruction_stream)
+{
+    // The baseline code stays, so the method is never compiled more often than the limit allows
+    if (instruction_stream.compilation_count() >= TieringPolicy::compilation_limit) {
+        instruction_stream.set_not_optimizable();
+        return;
+    }
+
+    auto compiled_code = JIT::OptimizingCompiler::compile(method, instruction_stream, m_runtime.heap(), *m_code_cache, m_jit_logging_enabled);
+    if (compiled_code.is_error()) {
+        if (m_jit_logging_enabled)
+            dbgln("JIT: Failed to optimize {}.{}{}: {}", method.owner().name(), method.name(), method.descriptor(), compiled_code.error());
+
+        instruction_stream.set_not_optimizable();
+        return;
+    }
+
+    if (m_jit_logging_enabled) {
+        dbgln("JIT: Optimized {}.{}{} ({} instructions, {} invocations, {} back-edges) into {} bytes",
+            method.owner().name(), method.name(), method.descriptor(), instruction_stream.size(),
+            instruction_stream.invocation_count(), instruction_stream.backedge_count(), compiled_code.value()->size());
+    }
+
+    instruction_stream.set_compiled_code(compiled_code.release_value());
+}
+
+template<DispatchMode mode>
+ErrorOr<Value> Interpreter::execute_compiled_code(Method& method, InstructionStream& instruction_stream, Value* locals)
+{
+    auto exit = run_compiled_code(method, instruction_stream, locals, instruction_stream.compiled_code()->entry_point(), 0);
+    switch (exit.reason) {
+    case JIT::ExitReason::Return:
+        return Value::from_bits(exit.value);
+    case JIT::ExitReason::Throw:
+        // Only the interpreter runs exception handlers, it catches the exception at the instruction that the compiled code stopped at
+        if (instruction_stream.exception_handlers().is_empty())
+            return m_pending_error.release_value();
+
+        return execute<mode>(method, instruction_stream, locals, static_cast<u32>(exit.value), m_pending_error.release_value());
+    case JIT::ExitReason::Deoptimize:
+        return execute<mode>(method, instruction_stream, locals, static_cast<u32>(exit.value));
+    case JIT::ExitReason::Continue:
+    case JIT::ExitReason::TierUp:
+        break;
+    }
+
+    VERIFY_NOT_REACHED();
+}
+
+JIT::Exit Interpreter::run_compiled_code(Method& method, InstructionStream& instruction_stream, Value* locals, JIT::EntryPoint entry_point, u32 start_index)
+{
+    // The frame is the same as the interpreter's, the compiled code updates its pc before every safepoint
+    Frame frame { m_current_frame, instruction_stream, locals, instruction_stream.instructions() + start_index };
+    m_current_frame = &frame;
+    auto exit = entry_point(locals, *this, &frame.pc);
+    m_current_frame = frame.caller;
+
+    // Compiled code only throws from a safepoint, so its pc is the instruction that threw
+    if (exit.reason == JIT::ExitReason::Throw)
+        exit.value = frame.pc - instruction_stream.instructions();
+
+    if (exit.reason == JIT::ExitReason::TierUp)
+        return tier_up(method, instruction_stream, locals, static_cast<u16>(exit.value));
+
+    if (exit.reason != JIT::ExitReason::Deoptimize)
+        return exit;
+
+    // A recursive call to the same method can already have thrown the code away.
+    // Code which keeps deoptimizing is thrown away, so that it can be compiled again once the instructions that it stops at have been quickened.
+    // Optimized code has made assumptions that didn't hold, so the method isn't optimized again.
+    auto* compiled_code = instruction_stream.compiled_code();
+    if (compiled_code && compiled_code->count_deoptimization() > TieringPolicy::deoptimization_limit) {
+        if (m_jit_logging_enabled)
+            dbgln("JIT: Discarding the code of {}.{}{}, it has deoptimized {} times", method.owner().name(), method.name(), method.descriptor(), compiled_code->deoptimizations());
+
+        if (compiled_code->tier() == JIT::CompiledCode::Tier::Optimized)
+            instruction_stream.set_not_optimizable();
+
+        instruction_stream.discard_compiled_code();
+    }
+
+    return exit;
+}
+
+JIT::Exit Interpreter::tier_up(Method& method, InstructionStream& instruction_stream, Value* locals, u16 loop)
+{
+    auto header = instruction_stream.loops()[loop].header;
+
+    // A recursive invocation of the method can already have optimized it (or thrown its code away)
+    auto* baseline_code = instruction_stream.compiled_code();
+    if (baseline_code && baseline_code->tier() == JIT::CompiledCode::Tier::Baseline && instruction_stream.is_optimizable())
+        optimize(method, instruction_stream);
+
+    // If the method couldn't be optimized, the frame carries on in the baseline code, which doesn't exit at this loop again.
+    // If the optimized code can't enter the loop, the interpreter carries on from the loop's header instead.
+    auto* compiled_code = instruction_stream.compiled_code();
+    if (!compiled_code || !compiled_code->loop_entry_point(loop))
+        return { JIT::ExitReason::Deoptimize, header };
+
+    if (m_jit_logging_enabled && compiled_code->tier() == JIT::CompiledCode::Tier::Optimized)
+        dbgln("JIT: Entering the optimized code of {}.{}{} at the loop at instruction {}", method.owner().name(), method.name(), method.descriptor(), header);
+
+    return run_compiled_code(method, instruction_stream, locals, compiled_code->loop_entry_point(loop), header);
+}
+
+Optional<JIT::Exit> Interpreter::replace_on_stack(Method& method, InstructionStream& instruction_stream, Value* locals, u16 loop)
+{
+    if (!instruction_stream.compiled_code())
+        compile(method, instruction_stream);
+
+    // Optimized code can't enter a loop whose header is only reached from instructions that it deoptimizes at, see JIT::GraphBuilder
+    auto* compiled_code = instruction_stream.compiled_code();
+    if (!compiled_code || !compiled_code->loop_entry_point(loop))
+        return {};
+
+    auto header = instruction_stream.loops()[loop].header;
+    if (m_jit_logging_enabled)
+        dbgln("JIT: Entering the compiled code of {}.{}{} at the loop at instruction {}", method.owner().name(), method.name(), method.descriptor(), header);
+
+    return run_compiled_code(method, instruction_stream, locals, compiled_code->loop_entry_point(loop), header);
+}
+
+void Interpreter::visit_roots(ReferenceVisitor const& visitor)
+{
+    // A callee's arguments are also the top of its caller's operand stack, and the callee can store something else in them.
+    // Only the callee's reference map knows what they hold, so each frame's slots end where its callee's local variables begin.
+    // Native methods don't have a frame, but they don't store to their arguments either.
+    Value* callee_locals = nullptr;
+    for (auto* frame = m_current_frame; frame; frame = frame->caller) {
+        auto instruction_index = static_cast<u32>(frame->pc - frame->instruction_stream.instructions());
+        frame->instruction_stream.reference_maps().for_each_reference_slot(instruction_index, [&](u32 slot) {
+            auto* value = frame->locals + slot;
+            if (!callee_locals || value < callee_locals)
+                visit_reference_value(*value, visitor);
+        });
+
+        callee_locals = frame->locals;
+    }
+
+    if (m_pending_exception)
+        visitor(m_pending_exception);
+}
+
+// The error that an exception object is propagated as, see throw_exception()
+static bool is_pending_exception(Error const& error)
+{
+    return !error.is_errno() && error.string_literal() == "Pending exception"sv;
+}
+
+Error Interpreter::throw_exception(Object& exception)
+{
+    m_pending_exception = &exception;
+    return Error::from_string_literal("Pending exception");
+}
+
+Class* Interpreter::exception_class(Error const& error)
+{
+    if (is_pending_exception(error)) {
+        VERIFY(m_pending_exception);
+        return &m_pending_exception->klass();
+    }
+
+    if (error.is_errno())
+        return nullptr;
+
+    // Only the bootstrap classes are thrown by the Java Virtual Machine itself, and those are always defined, so their names have been interned.
+    // Any other error message isn't interned just to find out that it isn't a class.
+    auto name = Symbol::find(error.string_literal());
+    if (name.is_null())
+        return nullptr;
+
+    auto* klass = m_runtime.find_class(name);
+    auto* throwable_class = m_runtime.find_class(WellKnownSymbols::the().java_lang_Throwable);
+    if (!klass || !throwable_class || !klass->is_assignable_to(*throwable_class))
+        return nullptr;
+
+    return klass;
+}
+
+ErrorOr<Object*> Interpreter::exception_object(Error error)
+{
+    if (is_pending_exception(error))
+        return exchange(m_pending_exception, nullptr);
+
+    // The exceptions that the Java Virtual Machine throws itself don't have a detail message, so there's no constructor to run (see Throwable in Natives.cpp)
+    auto* klass = exception_class(error);
+    if (!klass)
+        return error;
+
+    return m_runtime.allocate_object(*klass);
+}
+
+ErrorOr<u32> Interpreter::catch_exception(Method& method, Frame& frame, u32 index, Error error)
+{
+    auto* thrown_class = exception_class(error);
+    if (!thrown_class)
+        return error;
+
+    // The operand stack is discarded, and the exception is the only thing on it once the handler starts
+    auto* exception_slot = frame.locals + method.code()->max_locals();
+    for (auto const& handler : frame.instruction_stream.exception_handlers()) {
+        if (index < handler.start || index >= handler.end)
+            continue;
+
+        // The garbage collector can run while the catch type is resolved, or while the exception is allocated.
+        // The frame's reference map at the handler only has the local variables that are live on every path to it, and the exception.
+        frame.pc = frame.instruction_stream.instructions() + handler.handler;
+        *exception_slot = Value::from_reference(nullptr);
+
+        if (handler.catch_type) {
+            auto* catch_class = TRY(m_runtime.resolve_class_reference(*handler.catch_type));
+            if (!thrown_class->is_assignable_to(*catch_class))
+                continue;
+        }
+
+        *exception_slot = Value::from_reference(TRY(exception_object(move(error))));
+        return handler.handler;
+    }
+
+    return error;
+}
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-6.html
+//
+// Every instruction's handler is written once, below. What happens at the end of a handler depends on the dispatch mode:
+// - Switch: jump back to the top of the loop, and `switch` on the next opcode.
+// - Threaded: jump straight to the next instruction's handler through `dispatch_table`.
+template<DispatchMode mode>
+ErrorOr<Value> Interpreter::execute(Method& method, InstructionStream& instruction_stream, Value* locals, u32 start_index, Optional<Error> exception)
+{
+    auto& klass = method.owner();
+
+    Instruction* instructions = instruction_stream.instructions();
+    Instruction* pc = instructions + start_index;
+
+    // The operand stack is empty when the frame is created, it grows upwards towards the end of the frame.
+    // `sp` always points at the first free slot.
+    Value* sp = locals + method.code()->max_locals();
+    if (start_index != 0)
+        sp += *instruction_stream.reference_maps().stack_depth(start_index);
+
+    Frame frame { m_current_frame, instruction_stream, locals, pc };
+    m_current_frame = &frame;
+    ScopeGuard pop_frame = [&] {
+        m_current_frame = frame.caller;
+    };
+
+#if CAOVM_COMPUTED_GOTO
+#    define __ENUMERATE_OPCODE(name, mnemonic, value, length) &&handle_##name,
+    static void* const dispatch_table[opcode_count + quick_opcode_count] = {
+        ENUMERATE_OPCODES(__ENUMERATE_OPCODE)
+            ENUMERATE_QUICK_OPCODES(__ENUMERATE_OPCODE)
+    };
+#    undef __ENUMERATE_OPCODE
+
+    // The decoder rejects any opcode that isn't defined by the JVM, and the interpreter only ever rewrites them to quick opcodes,
+    // so every opcode that can be executed has an entry in the table.
+    static_assert(to_underlying(Opcode::JsrW) == opcode_count - 1, "The opcodes must be contiguous and in order");
+    static_assert(to_underlying(Opcode::LdcQuick) == opcode_count, "The quick opcodes must immediately follow the JVM's opcodes");
+
+#    define INSTRUCTION(name) \
+        case Opcode::name:    \
+        handle_##name:
+#    define DISPATCH()                                           \
+        do {                                                     \
+            if constexpr (mode == DispatchMode::Threaded)        \
+                goto* dispatch_table[to_underlying(pc->opcode)]; \
+            else                                                 \
+                goto dispatch;                                   \
+        } while (0)
+#else
+#    define INSTRUCTION(name) case Opcode::name:
+#    define DISPATCH() goto dispatch
+#endif
+
+#define NEXT()      \
+    do {            \
+        pc++;       \
+        DISPATCH(); \
+    } while (0)
+
+// Jumping backwards is a loop, which makes the method hotter.
+// Once the loop is hot enough, the frame carries on in compiled code from the loop's header, see TieringPolicy.
+#define JUMP_TO(target)                                                                                         \
+    do {                                                                                                        \
+        auto* _destination = instructions + (target);                                                           \
+        if (_destination <= pc) {                                                                               \
+            auto _backedge_count = instruction_stream.count_backedge(pc->index);                                \
+            if (m_jit_enabled && m_tiering_policy.should_replace_on_stack(instruction_stream, _backedge_count)) \
+                goto on_stack_replacement;                                                                      \
+        }                                                                                                       \
+        pc = _destination;                                                                                      \
+        DISPATCH();                                                                                             \
+    } while (0)
+
+#define BRANCH_IF(condition)      \
+    do {                          \
+        if (condition)            \
+            JUMP_TO(pc->operand); \
+        NEXT();                   \
+    } while (0)
+
+// Rewrites the current instruction to its quick form, and then executes it again.
+// Its operands must already have been replaced with whatever the quick form expects.
+#define QUICKEN(quick_opcode)        \
+    do {                             \
+        pc->opcode = (quick_opcode); \
+        DISPATCH();                  \
+    } while (0)
+
+// Records where this frame has stopped, before anything that can run the garbage collector.
+// Every instruction that does this must be a safepoint, so that the frame's reference map at `pc` exists.
+#define SAFEPOINT() (frame.pc = pc)
+
+#define PUSH(value) (*sp++ = (value))
+#define POP() (*--sp)
+
+// Long and double values take up two slots, the value is stored in the first one
+#define PUSH2(value)     \
+    do {                 \
+        sp[0] = (value); \
+        sp += 2;         \
+    } while (0)
+#define POP2() (sp -= 2, sp[0])
+
+// The instruction at `pc` throws, the frame's exception handlers either catch the exception, or it's thrown by the caller's invocation instead
+#define THROW_ERROR(error)     \
+    do {                       \
+        exception = (error);   \
+        goto exception_thrown; \
+    } while (0)
+
+#define THROW(exception_class) THROW_ERROR(Error::from_string_literal(exception_class))
+
+// Anything that fails while an instruction executes is thrown by that instruction, like TRY but with THROW_ERROR
+#define TRY_OR_THROW(expression)                  \
+    ({                                            \
+        auto _result = (expression);              \
+        if (_result.is_error()) [[unlikely]]      \
+            THROW_ERROR(_result.release_error()); \
+        _result.release_value();                  \
+    })
+
+#define POP_ARRAY_AND_INDEX()                                      \
+    auto index = POP().as_int();                                   \
+    auto* array = static_cast<ArrayObject*>(POP().as_reference()); \
+    if (!array)                                                    \
+        THROW("java/lang/NullPointerException");                   \
+    if (!array->is_index_in_bounds(index))                         \
+        THROW("java/lang/ArrayIndexOutOfBoundsException");
+
+#define POP_OBJECT()                     \
+    auto* object = POP().as_reference(); \
+    if (!object)                         \
+        THROW("java/lang/NullPointerException");
+
+#define INT_BINARY(expression)             \
+    {                                      \
+        auto b = POP().as_int();           \
+        auto a = POP().as_int();           \
+        PUSH(Value::from_int(expression)); \
+        NEXT();                            \
+    }
+
+#define LONG_BINARY(expression)              \
+    {                                        \
+        auto b = POP2().as_long();           \
+        auto a = POP2().as_long();           \
+        PUSH2(Value::from_long(expression)); \
+        NEXT();                              \
+    }
+
+#define LONG_SHIFT(expression)               \
+    {                                        \
+        auto b = POP().as_int() & 0x3f;      \
+        auto a = POP2().as_long();           \
+        PUSH2(Value::from_long(expression)); \
+        NEXT();                              \
+    }
+
+#define FLOAT_BINARY(expression)             \
+    {                                        \
+        auto b = POP().as_float();           \
+        auto a = POP().as_float();           \
+        PUSH(Value::from_float(expression)); \
+        NEXT();                              \
+    }
+
+#define DOUBLE_BINARY(expression)              \
+    {                                          \
+        auto b = POP2().as_double();           \
+        auto a = POP2().as_double();           \
+        PUSH2(Value::from_double(expression)); \
+        NEXT();                                \
+    }
+
+// Pops the arguments off of the operand stack, and pushes the method's return value in their place
+#define INVOKE(method_to_invoke, arguments)                                       \
+    do {                                                                          \
+        SAFEPOINT();                                                              \
+        auto result = TRY_OR_THROW(call<mode>(*(method_to_invoke), (arguments))); \
+        sp = (arguments);                                                         \
+        if ((method_to_invoke)->return_slots() == 2)                              \
+            PUSH2(result);                                                        \
+        else if ((method_to_invoke)->return_slots() == 1)                         \
+            PUSH(result);                                                         \
+        NEXT();                                                                   \
+    } while (0)
+
+    if (exception.has_value())
+        goto exception_thrown;
+
+    // Threaded dispatch never jumps back here, it goes straight from one instruction's handler to the next
+[[maybe_unused]] dispatch:
+#if CAOVM_COMPUTED_GOTO
+    if constexpr (mode == DispatchMode::Threaded)
+        goto* dispatch_table[to_underlying(pc->opcode)];
+#endif
+
+    switch (pc->opcode) {
+    INSTRUCTION(Nop)
+    {
+        NEXT();
+    }
+
+    // Constants, the value has already been decoded from the opcode or its operands
+    INSTRUCTION(AconstNull)
+    {
+        PUSH(Value::from_reference(nullptr));
+        NEXT();
+    }
+
+    INSTRUCTION(IconstM1)
+    INSTRUCTION(Iconst0)
+    INSTRUCTION(Iconst1)
+    INSTRUCTION(Iconst2)
+    INSTRUCTION(Iconst3)
+    INSTRUCTION(Iconst4)
+    INSTRUCTION(Iconst5)
+    INSTRUCTION(Bipush)
+    INSTRUCTION(Sipush)
+    {
+        PUSH(Value::from_int(pc->operand));
+        NEXT();
+    }
+
+    INSTRUCTION(Lconst0)
+    INSTRUCTION(Lconst1)
+    {
+        PUSH2(Value::from_long(pc->operand));
+        NEXT();
+    }
+
+    INSTRUCTION(Fconst0)
+    INSTRUCTION(Fconst1)
+    INSTRUCTION(Fconst2)
+    {
+        PUSH(Value::from_float(static_cast<float>(pc->operand)));
+        NEXT();
+    }
+
+    INSTRUCTION(Dconst0)
+    INSTRUCTION(Dconst1)
+    {
+        PUSH2(Value::from_double(static_cast<double>(pc->operand)));
+        NEXT();
+    }
+
+    // Loadable constants never change once they have been loaded, so the value replaces the constant pool reference
+    INSTRUCTION(Ldc)
+    INSTRUCTION(LdcW)
+    {
+        SAFEPOINT();
+        auto constant = TRY_OR_THROW(m_runtime.load_constant(*pc->reference));
+
+        // A string or class constant is an object, which the garbage collector has to be able to find (and move) once it's part of the instruction
+        if (pc->reference->type() == SymbolicatedReference::String || pc->reference->type() == SymbolicatedReference::Class)
+            TRY_OR_THROW(instruction_stream.add_reference_constant(*pc));
+
+        pc->constant_bits = constant.bits();
+        QUICKEN(Opcode::LdcQuick);
+    }
+
+    INSTRUCTION(Ldc2W)
+    {
+        pc->constant_bits = TRY_OR_THROW(m_runtime.load_constant(*pc->reference)).bits();
+        QUICKEN(Opcode::Ldc2WQuick);
+    }
+
+    INSTRUCTION(LdcQuick)
+    {
+        PUSH(Value::from_bits(pc->constant_bits));
+        NEXT();
+    }
+
+    INSTRUCTION(Ldc2WQuick)
+    {
+        PUSH2(Value::from_bits(pc->constant_bits));
+        NEXT();
+    }
+
+    // Loads, every slot holds a full Value so the type doesn't matter.
+    // The implicit index of e.g. iload_0 has been decoded into the instruction's index.
+    INSTRUCTION(Iload)
+    INSTRUCTION(Fload)
+    INSTRUCTION(Aload)
+    INSTRUCTION(Iload0)
+    INSTRUCTION(Iload1)
+    INSTRUCTION(Iload2)
+    INSTRUCTION(Iload3)
+    INSTRUCTION(Fload0)
+    INSTRUCTION(Fload1)
+    INSTRUCTION(Fload2)
+    INSTRUCTION(Fload3)
+    INSTRUCTION(Aload0)
+    INSTRUCTION(Aload1)
+    INSTRUCTION(Aload2)
+    INSTRUCTION(Aload3)
+    {
+        PUSH(locals[pc->index]);
+        NEXT();
+    }
+
+    INSTRUCTION(Lload)
+    INSTRUCTION(Dload)
+    INSTRUCTION(Lload0)
+    INSTRUCTION(Lload1)
+    INSTRUCTION(Lload2)
+    INSTRUCTION(Lload3)
+    INSTRUCTION(Dload0)
+    INSTRUCTION(Dload1)
+    INSTRUCTION(Dload2)
+    INSTRUCTION(Dload3)
+    {
+        PUSH2(locals[pc->index]);
+        NEXT();
+    }
+
+    // Array loads
+    INSTRUCTION(Iaload)
+    {
+        POP_ARRAY_AND_INDEX();
+        PUSH(Value::from_int(array->element_at<i32>(index)));
+        NEXT();
+    }
+
+    INSTRUCTION(Laload)
+    {
+        POP_ARRAY_AND_INDEX();
+        PUSH2(Value::from_long(array->element_at<i64>(index)));
+        NEXT();
+    }
+
+    INSTRUCTION(Faload)
+    {
+        POP_ARRAY_AND_INDEX();
+        PUSH(Value::from_float(array->element_at<float>(index)));
+        NEXT();
+    }
+
+    INSTRUCTION(Daload)
+    {
+        POP_ARRAY_AND_INDEX();
+        PUSH2(Value::from_double(array->element_at<double>(index)));
+        NEXT();
+    }
+
+    INSTRUCTION(Aaload)
+    {
+        POP_ARRAY_AND_INDEX();
+        PUSH(Value::from_reference(array->element_at<Object*>(index)));
+        NEXT();
+    }
+
+    // Used for both byte and boolean arrays
+    INSTRUCTION(Baload)
+    {
+        POP_ARRAY_AND_INDEX();
+        PUSH(Value::from_int(array->element_at<i8>(index)));
+        NEXT();
+    }
+
+    INSTRUCTION(Caload)
+    {
+        POP_ARRAY_AND_INDEX();
+        PUSH(Value::from_int(array->element_at<u16>(index)));
+        NEXT();
+    }
+
+    INSTRUCTION(Saload)
+    {
+        POP_ARRAY_AND_INDEX();
+        PUSH(Value::from_int(array->element_at<i16>(index)));
+        NEXT();
+    }
+
+    // Stores
+    INSTRUCTION(Istore)
+    INSTRUCTION(Fstore)
+    INSTRUCTION(Astore)
+    INSTRUCTION(Istore0)
+    INSTRUCTION(Istore1)
+    INSTRUCTION(Istore2)
+    INSTRUCTION(Istore3)
+    INSTRUCTION(Fstore0)
+    INSTRUCTION(Fstore1)
+    INSTRUCTION(Fstore2)
+    INSTRUCTION(Fstore3)
+    INSTRUCTION(Astore0)
+    INSTRUCTION(Astore1)
+    INSTRUCTION(Astore2)
+    INSTRUCTION(Astore3)
+    {
+        locals[pc->index] = POP();
+        NEXT();
+    }
+
+    INSTRUCTION(Lstore)
+    INSTRUCTION(Dstore)
+    INSTRUCTION(Lstore0)
+    INSTRUCTION(Lstore1)
+    INSTRUCTION(Lstore2)
+    INSTRUCTION(Lstore3)
+    INSTRUCTION(Dstore0)
+    INSTRUCTION(Dstore1)
+    INSTRUCTION(Dstore2)
+    INSTRUCTION(Dstore3)
+    {
+        locals[pc->index] = POP2();
+        NEXT();
+    }
+
+    // Array stores
+    INSTRUCTION(Iastore)
+    {
+        auto value = POP().as_int();
+        POP_ARRAY_AND_INDEX();
+        array->element_at<i32>(index) = value;
+        NEXT();
+    }
+
+    INSTRUCTION(Lastore)
+    {
+        auto value = POP2().as_long();
+        POP_ARRAY_AND_INDEX();
+        array->element_at<i64>(index) = value;
+        NEXT();
+    }
+
+    INSTRUCTION(Fastore)
+    {
+        auto value = POP().as_float();
+        POP_ARRAY_AND_INDEX();
+        array->element_at<float>(index) = value;
+        NEXT();
+    }
+
+    INSTRUCTION(Dastore)
+    {
+        auto value = POP2().as_double();
+        POP_ARRAY_AND_INDEX();
+        array->element_at<double>(index) = value;
+        NEXT();
+    }
+
+    INSTRUCTION(Aastore)
+    {
+        auto* value = POP().as_reference();
+        POP_ARRAY_AND_INDEX();
+
+        // The value must be assignable to the component type of the array, which is only known at run-time
+        auto* component_class = array->klass().component_class();
+        if (value && component_class && !value->klass().is_assignable_to(*component_class))
+            THROW("java/lang/ArrayStoreException");
+
+        array->element_at<Object*>(index) = value;
+        m_runtime.heap().record_write(*array);
+        NEXT();
+    }
+
+    INSTRUCTION(Bastore)
+    {
+        auto value = POP().as_int();
+        POP_ARRAY_AND_INDEX();
+
+        // Values stored into boolean arrays are narrowed to their lowest bit
+        if (array->klass().name().view()[1] == FieldDescriptor::Boolean)
+            value &= 1;
+
+        array->element_at<i8>(index) = static_cast<i8>(value);
+        NEXT();
+    }
+
+    INSTRUCTION(Castore)
+    {
+        auto value = POP().as_int();
+        POP_ARRAY_AND_INDEX();
+        array->element_at<u16>(index) = static_cast<u16>(value);
+        NEXT();
+    }
+
+    INSTRUCTION(Sastore)
+    {
+        auto value = POP().as_int();
+        POP_ARRAY_AND_INDEX();
+        array->element_at<i16>(index) = static_cast<i16>(value);
+        NEXT();
+    }
+
+    // Stack manipulation, these work on slots, so category 2 values are handled by the same forms
+    INSTRUCTION(Pop)
+    {
+        sp -= 1;
+        NEXT();
+    }
+
+    INSTRUCTION(Pop2)
+    {
+        sp -= 2;
+        NEXT();
+    }
+
+    INSTRUCTION(Dup)
+    {
+        sp[0] = sp[-1];
+        sp += 1;
+        NEXT();
+    }
+
+    INSTRUCTION(DupX1)
+    {
+        // ..., value2, value1 → ..., value1, value2, value1
+        auto value1 = sp[-1];
+        auto value2 = sp[-2];
+        sp[-2] = value1;
+        sp[-1] = value2;
+        sp[0] = value1;
+        sp += 1;
+        NEXT();
+    }
+
+    INSTRUCTION(DupX2)
+    {
+        // ..., value3, value2, value1 → ..., value1, value3, value2, value1
+        auto value1 = sp[-1];
+        auto value2 = sp[-2];
+        auto value3 = sp[-3];
+        sp[-3] = value1;
+        sp[-2] = value3;
+        sp[-1] = value2;
+        sp[0] = value1;
+        sp += 1;
+        NEXT();
+    }
+
+    INSTRUCTION(Dup2)
+    {
+        // ..., value2, value1 → ..., value2, value1, value2, value1
+        sp[0] = sp[-2];
+        sp[1] = sp[-1];
+        sp += 2;
+        NEXT();
+    }
+
+    INSTRUCTION(Dup2X1)
+    {
+        // ..., value3, value2, value1 → ..., value2, value1, value3, value2, value1
+        auto value1 = sp[-1];
+        auto value2 = sp[-2];
+        auto value3 = sp[-3];
+        sp[-3] = value2;
+        sp[-2] = value1;
+        sp[-1] = value3;
+        sp[0] = value2;
+        sp[1] = value1;
+        sp += 2;
+        NEXT();
+    }
+
+    INSTRUCTION(Dup2X2)
+    {
+        // ..., value4, value3, value2, value1 → ..., value2, value1, value4, value3, value2, value1
+        auto value1 = sp[-1];
+        auto value2 = sp[-2];
+        auto value3 = sp[-3];
+        auto value4 = sp[-4];
+        sp[-4] = value2;
+        sp[-3] = value1;
+        sp[-2] = value4;
+        sp[-1] = value3;
+        sp[0] = value2;
+        sp[1] = value1;
+        sp += 2;
+        NEXT();
+    }
+
+    INSTRUCTION(Swap)
+    {
+        swap(sp[-1], sp[-2]);
+        NEXT();
+    }
+
+    // Arithmetic, integer overflow wraps around in Java, so it's done on unsigned values to avoid undefined behaviour
+    INSTRUCTION(Iadd)
+    INT_BINARY(static_cast<i32>(static_cast<u32>(a) + static_cast<u32>(b)))
+
+    INSTRUCTION(Ladd)
+    LONG_BINARY(static_cast<i64>(static_cast<u64>(a) + static_cast<u64>(b)))
+
+    INSTRUCTION(Fadd)
+    FLOAT_BINARY(a + b)
+
+    INSTRUCTION(Dadd)
+    DOUBLE_BINARY(a + b)
+
+    INSTRUCTION(Isub)
+    INT_BINARY(static_cast<i32>(static_cast<u32>(a) - static_cast<u32>(b)))
+
+    INSTRUCTION(Lsub)
+    LONG_BINARY(static_cast<i64>(static_cast<u64>(a) - static_cast<u64>(b)))
+
+    INSTRUCTION(Fsub)
+    FLOAT_BINARY(a - b)
+
+    INSTRUCTION(Dsub)
+    DOUBLE_BINARY(a - b)
+
+    INSTRUCTION(Imul)
+    INT_BINARY(static_cast<i32>(static_cast<u32>(a) * static_cast<u32>(b)))
+
+    INSTRUCTION(Lmul)
+    LONG_BINARY(static_cast<i64>(static_cast<u64>(a) * static_cast<u64>(b)))
+
+    INSTRUCTION(Fmul)
+    FLOAT_BINARY(a * b)
+
+    INSTRUCTION(Dmul)
+    DOUBLE_BINARY(a * b)
+
+    INSTRUCTION(Idiv)
+    {
+        auto b = POP().as_int();
+        auto a = POP().as_int();
+        if (b == 0)
+            THROW("java/lang/ArithmeticException");
+
+        // Dividing the smallest int by -1 overflows, the result is the dividend
+        PUSH(Value::from_int(b == -1 ? static_cast<i32>(0u - static_cast<u32>(a)) : a / b));
+        NEXT();
+    }
+
+    INSTRUCTION(Ldiv)
+    {
+        auto b = POP2().as_long();
+        auto a = POP2().as_long();
+        if (b == 0)
+            THROW("java/lang/ArithmeticException");
+
+        PUSH2(Value::from_long(b == -1 ? static_cast<i64>(0u - static_cast<u64>(a)) : a / b));
+        NEXT();
+    }
+
+    INSTRUCTION(Fdiv)
+    FLOAT_BINARY(a / b)
+
+    INSTRUCTION(Ddiv)
+    DOUBLE_BINARY(a / b)
+
+    INSTRUCTION(Irem)
+    {
+        auto b = POP().as_int();
+        auto a = POP().as_int();
+        if (b == 0)
+            THROW("java/lang/ArithmeticException");
+
+        PUSH(Value::from_int(b == -1 ? 0 : a % b));
+        NEXT();
+    }
+
+    INSTRUCTION(Lrem)
+    {
+        auto b = POP2().as_long();
+        auto a = POP2().as_long();
+        if (b == 0)
+            THROW("java/lang/ArithmeticException");
+
+        PUSH2(Value::from_long(b == -1 ? 0 : a % b));
+        NEXT();
+    }
+
+    INSTRUCTION(Frem)
+    FLOAT_BINARY(fmodf(a, b))
+
+    INSTRUCTION(Drem)
+    DOUBLE_BINARY(fmod(a, b))
+
+    INSTRUCTION(Ineg)
+    {
+        auto value = POP().as_int();
+        PUSH(Value::from_int(static_cast<i32>(0u - static_cast<u32>(value))));
+        NEXT();
+    }
+
+    INSTRUCTION(Lneg)
+    {
+        auto value = POP2().as_long();
+        PUSH2(Value::from_long(static_cast<i64>(0u - static_cast<u64>(value))));
+        NEXT();
+    }
+
+    INSTRUCTION(Fneg)
+    {
+        auto value = POP().as_float();
+        PUSH(Value::from_float(-value));
+        NEXT();
+    }
+
+    INSTRUCTION(Dneg)
+    {
+        auto value = POP2().as_double();
+        PUSH2(Value::from_double(-value));
+        NEXT();
+    }
+
+    // Only the low 5 (or 6, for longs) bits of the shift distance are used
+    INSTRUCTION(Ishl)
+    INT_BINARY(static_cast<i32>(static_cast<u32>(a) << (b & 0x1f)))
+
+    INSTRUCTION(Lshl)
+    LONG_SHIFT(static_cast<i64>(static_cast<u64>(a) << b))
+
+    INSTRUCTION(Ishr)
+    INT_BINARY(a >> (b & 0x1f))
+
+    INSTRUCTION(Lshr)
+    LONG_SHIFT(a >> b)
+
+    INSTRUCTION(Iushr)
+    INT_BINARY(static_cast<i32>(static_cast<u32>(a) >> (b & 0x1f)))
+
+    INSTRUCTION(Lushr)
+    LONG_SHIFT(static_cast<i64>(static_cast<u64>(a) >> b))
+
+    INSTRUCTION(Iand)
+    INT_BINARY(a & b)
+
+    INSTRUCTION(Land)
+    LONG_BINARY(a & b)
+
+    INSTRUCTION(Ior)
+    INT_BINARY(a | b)
+
+    INSTRUCTION(Lor)
+    LONG_BINARY(a | b)
+
+    INSTRUCTION(Ixor)
+    INT_BINARY(a ^ b)
+
+    INSTRUCTION(Lxor)
+    LONG_BINARY(a ^ b)
+
+    INSTRUCTION(Iinc)
+    {
+        auto& local = locals[pc->index];
+        local = Value::from_int(static_cast<i32>(static_cast<u32>(local.as_int()) + static_cast<u32>(pc->operand)));
+        NEXT();
+    }
+
+    // Conversions
+    INSTRUCTION(I2l)
+    {
+        auto value = POP().as_int();
+        PUSH2(Value::from_long(value));
+        NEXT();
+    }
+
+    INSTRUCTION(I2f)
+    {
+        auto value = POP().as_int();
+        PUSH(Value::from_float(static_cast<float>(value)));
+        NEXT();
+    }
+
+    INSTRUCTION(I2d)
+    {
+        auto value = POP().as_int();
+        PUSH2(Value::from_double(static_cast<double>(value)));
+        NEXT();
+    }
+
+    INSTRUCTION(L2i)
+    {
+        auto value = POP2().as_long();
+        PUSH(Value::from_int(static_cast<i32>(value)));
+        NEXT();
+    }
+
+    INSTRUCTION(L2f)
+    {
+        auto value = POP2().as_long();
+        PUSH(Value::from_float(static_cast<float>(value)));
+        NEXT();
+    }
+
+    INSTRUCTION(L2d)
+    {
+        auto value = POP2().as_long();
+        PUSH2(Value::from_double(static_cast<double>(value)));
+        NEXT();
+    }
+
+    INSTRUCTION(F2i)
+    {
+        auto value = POP().as_float();
+        PUSH(Value::from_int(floating_point_to_integer<i32>(value)));
+        NEXT();
+    }
+
+    INSTRUCTION(F2l)
+    {
+        auto value = POP().as_float();
+        PUSH2(Value::from_long(floating_point_to_integer<i64>(value)));
+        NEXT();
+    }
+
+    INSTRUCTION(F2d)
+    {
+        auto value = POP().as_float();
+        PUSH2(Value::from_double(value));
+        NEXT();
+    }
+
+    INSTRUCTION(D2i)
+    {
+        auto value = POP2().as_double();
+        PUSH(Value::from_int(floating_point_to_integer<i32>(value)));
+        NEXT();
+    }
+
+    INSTRUCTION(D2l)
+    {
+        auto value = POP2().as_double();
+        PUSH2(Value::from_long(floating_point_to_integer<i64>(value)));
+        NEXT();
+    }
+
+    INSTRUCTION(D2f)
+    {
+        auto value = POP2().as_double();
+        PUSH(Value::from_float(static_cast<float>(value)));
+        NEXT();
+    }
+
+    INSTRUCTION(I2b)
+    {
+        sp[-1] = Value::from_int(static_cast<i8>(sp[-1].as_int()));
+        NEXT();
+    }
+
+    INSTRUCTION(I2c)
+    {
+        sp[-1] = Value::from_int(static_cast<u16>(sp[-1].as_int()));
+        NEXT();
+    }
+
+    INSTRUCTION(I2s)
+    {
+        sp[-1] = Value::from_int(static_cast<i16>(sp[-1].as_int()));
+        NEXT();
+    }
+
+    // Comparisons
+    INSTRUCTION(Lcmp)
+    {
+        auto b = POP2().as_long();
+        auto a = POP2().as_long();
+        PUSH(Value::from_int(a > b ? 1 : (a < b ? -1 : 0)));
+        NEXT();
+    }
+
+    INSTRUCTION(Fcmpl)
+    INSTRUCTION(Fcmpg)
+    {
+        auto b = POP().as_float();
+        auto a = POP().as_float();
+        PUSH(Value::from_int(compare_floating_point(a, b, pc->opcode == Opcode::Fcmpg ? 1 : -1)));
+        NEXT();
+    }
+
+    INSTRUCTION(Dcmpl)
+    INSTRUCTION(Dcmpg)
+    {
+        auto b = POP2().as_double();
+        auto a = POP2().as_double();
+        PUSH(Value::from_int(compare_floating_point(a, b, pc->opcode == Opcode::Dcmpg ? 1 : -1)));
+        NEXT();
+    }
+
+    // Branches, the offset is relative to the start of the branch instruction
+    INSTRUCTION(Ifeq)
+    {
+        auto value = POP().as_int();
+        BRANCH_IF(value == 0);
+    }
+
+    INSTRUCTION(Ifne)
+    {
+        auto value = POP().as_int();
+        BRANCH_IF(value != 0);
+    }
+
+    INSTRUCTION(Iflt)
+    {
+        auto value = POP().as_int();
+        BRANCH_IF(value < 0);
+    }
+
+    INSTRUCTION(Ifge)
+    {
+        auto value = POP().as_int();
+        BRANCH_IF(value >= 0);
+    }
+
+    INSTRUCTION(Ifgt)
+    {
+        auto value = POP().as_int();
+        BRANCH_IF(value > 0);
+    }
+
+    INSTRUCTION(Ifle)
+    {
+        auto value = POP().as_int();
+        BRANCH_IF(value <= 0);
+    }
+
+    INSTRUCTION(IfIcmpeq)
+    {
+        auto b = POP().as_int();
+        auto a = POP().as_int();
+        BRANCH_IF(a == b);
+    }
+
+    INSTRUCTION(IfIcmpne)
+    {
+        auto b = POP().as_int();
+        auto a = POP().as_int();
+        BRANCH_IF(a != b);
+    }
+
+    INSTRUCTION(IfIcmplt)
+    {
+        auto b = POP().as_int();
+        auto a = POP().as_int();
+        BRANCH_IF(a < b);
+    }
+
+    INSTRUCTION(IfIcmpge)
+    {
+        auto b = POP().as_int();
+        auto a = POP().as_int();
+        BRANCH_IF(a >= b);
+    }
+
+    INSTRUCTION(IfIcmpgt)
+    {
+        auto b = POP().as_int();
+        auto a = POP().as_int();
+        BRANCH_IF(a > b);
+    }
+
+    INSTRUCTION(IfIcmple)
+    {
+        auto b = POP().as_int();
+        auto a = POP().as_int();
+        BRANCH_IF(a <= b);
+    }
+
+    INSTRUCTION(IfAcmpeq)
+    {
+        auto* b = POP().as_reference();
+        auto* a = POP().as_reference();
+        BRANCH_IF(a == b);
+    }
+
+    INSTRUCTION(IfAcmpne)
+    {
+        auto* b = POP().as_reference();
+        auto* a = POP().as_reference();
+        BRANCH_IF(a != b);
+    }
+
+    INSTRUCTION(Goto)
+    INSTRUCTION(GotoW)
+    {
+        JUMP_TO(pc->operand);
+    }
+
+    // jsr and ret can't appear in class files with a version of 51.0 or above, but older class files still use them for `finally` blocks.
+    // The return address is stored as the index of the instruction after the jsr.
+    INSTRUCTION(Jsr)
+    INSTRUCTION(JsrW)
+    {
+        PUSH(Value::from_bits(pc + 1 - instructions));
+        pc = instructions + pc->operand;
+        DISPATCH();
+    }
+
+    INSTRUCTION(Ret)
+    {
+        pc = instructions + locals[pc->index].bits();
+        DISPATCH();
+    }
+
+    INSTRUCTION(Tableswitch)
+    {
+        auto const& switch_table = *pc->switch_table;
+
+        // Out of range indices (including those below `low`) wrap around to large unsigned values
+        auto case_index = static_cast<u64>(static_cast<i64>(POP().as_int()) - switch_table.low);
+        pc = instructions + (case_index < switch_table.targets.size() ? switch_table.targets[case_index] : switch_table.default_target);
+        DISPATCH();
+    }
+
+    INSTRUCTION(Lookupswitch)
+    {
+        auto const& switch_table = *pc->switch_table;
+
+        // The matches are sorted, so they can be binary searched
+        auto key = POP().as_int();
+        auto target = switch_table.default_target;
+        size_t low = 0;
+        size_t high = switch_table.matches.size();
+        while (low < high) {
+            auto middle = low + (high - low) / 2;
+            auto match = switch_table.matches[middle];
+            if (match < key) {
+                low = middle + 1;
+            } else if (match > key) {
+                high = middle;
+            } else {
+                target = switch_table.targets[middle];
+                break;
+            }
+        }
+
+        pc = instructions + target;
+        DISPATCH();
+    }
+
+    // Returns
+    INSTRUCTION(Ireturn)
+    INSTRUCTION(Freturn)
+    INSTRUCTION(Areturn)
+    {
+        return POP();
+    }
+
+    INSTRUCTION(Lreturn)
+    INSTRUCTION(Dreturn)
+    {
+        return POP2();
+    }
+
+    INSTRUCTION(Return)
+    {
+        return Value();
+    }
+
+    // Fields, each access is resolved once and then quickened with the field's location
+    INSTRUCTION(Getstatic)
+    INSTRUCTION(Putstatic)
+    {
+        SAFEPOINT();
+        auto* field = TRY_OR_THROW(m_runtime.resolve_field_reference(static_cast<SymbolicatedFieldReference&>(*pc->reference)));
+        if (!field->is_static())
+            THROW("java/lang/IncompatibleClassChangeError");
+
+        // The class that declared the resolved field is initialized if it hasn't been initialized already
+        auto& owner = field->owner();
+        TRY_OR_THROW(m_runtime.initialize_class(owner));
+
+        auto* static_value = &owner.static_value_at(field->offset());
+        auto is_get = pc->opcode == Opcode::Getstatic;
+
+        // The quick forms don't check the state of the class, so the instruction can't be quickened while <clinit> is still running
+        if (owner.state() != Class::State::Initialized) {
+            if (is_get && field->is_category_2())
+                PUSH2(*static_value);
+            else if (is_get)
+                PUSH(*static_value);
+            else
+                *static_value = field->is_category_2() ? POP2() : POP();
+
+            NEXT();
+        }
+
+        pc->static_value = static_value;
+        if (is_get)
+            QUICKEN(field->is_category_2() ? Opcode::Getstatic2Quick : Opcode::GetstaticQuick);
+
+        QUICKEN(field->is_category_2() ? Opcode::Putstatic2Quick : Opcode::PutstaticQuick);
+    }
+
+    INSTRUCTION(Getfield)
+    INSTRUCTION(Putfield)
+    {
+        auto* field = TRY_OR_THROW(m_runtime.resolve_field_reference(static_cast<SymbolicatedFieldReference&>(*pc->reference)));
+        if (field->is_static())
+            THROW("java/lang/IncompatibleClassChangeError");
+
+        // The quick form loads or stores the field at its offset, with the size that the field was laid out with
+        pc->operand = static_cast<i32>(field->offset());
+        if (pc->opcode == Opcode::Getfield)
+            QUICKEN(getfield_quick_opcode(field->descriptor().view()[0]));
+
+        QUICKEN(putfield_quick_opcode(field->descriptor().view()[0]));
+    }
+
+    INSTRUCTION(GetstaticQuick)
+    {
+        PUSH(*pc->static_value);
+        NEXT();
+    }
+
+    INSTRUCTION(Getstatic2Quick)
+    {
+        PUSH2(*pc->static_value);
+        NEXT();
+    }
+
+    INSTRUCTION(PutstaticQuick)
+    {
+        *pc->static_value = POP();
+        NEXT();
+    }
+
+    INSTRUCTION(Putstatic2Quick)
+    {
+        *pc->static_value = POP2();
+        NEXT();
+    }
+
+    // Used for both byte and boolean fields
+    INSTRUCTION(GetfieldByteQuick)
+    {
+        POP_OBJECT();
+        PUSH(Value::from_int(object->field_at<i8>(pc->operand)));
+        NEXT();
+    }
+
+    INSTRUCTION(GetfieldCharQuick)
+    {
+        POP_OBJECT();
+        PUSH(Value::from_int(object->field_at<u16>(pc->operand)));
+        NEXT();
+    }
+
+    INSTRUCTION(GetfieldShortQuick)
+    {
+        POP_OBJECT();
+        PUSH(Value::from_int(object->field_at<i16>(pc->operand)));
+        NEXT();
+    }
+
+    // Used for both int and float fields, a float is stored as its bits
+    INSTRUCTION(GetfieldIntQuick)
+    {
+        POP_OBJECT();
+        PUSH(Value::from_int(object->field_at<i32>(pc->operand)));
+        NEXT();
+    }
+
+    // Used for both long and double fields, a double is stored as its bits
+    INSTRUCTION(GetfieldLongQuick)
+    {
+        POP_OBJECT();
+        PUSH2(Value::from_long(object->field_at<i64>(pc->operand)));
+        NEXT();
+    }
+
+    INSTRUCTION(GetfieldReferenceQuick)
+    {
+        POP_OBJECT();
+        PUSH(Value::from_reference(object->field_at<Object*>(pc->operand)));
+        NEXT();
+    }
+
+    // Values stored into boolean fields are narrowed to their lowest bit
+    INSTRUCTION(PutfieldBooleanQuick)
+    {
+        auto value = POP().as_int();
+        POP_OBJECT();
+        object->field_at<u8>(pc->operand) = static_cast<u8>(value & 1);
+        NEXT();
+    }
+
+    INSTRUCTION(PutfieldByteQuick)
+    {
+        auto value = POP().as_int();
+        POP_OBJECT();
+        object->field_at<i8>(pc->operand) = static_cast<i8>(value);
+        NEXT();
+    }
+
+    // Used for both short and char fields, which only differ when they're loaded
+    INSTRUCTION(PutfieldShortQuick)
+    {
+        auto value = POP().as_int();
+        POP_OBJECT();
+        object->field_at<i16>(pc->operand) = static_cast<i16>(value);
+        NEXT();
+    }
+
+    INSTRUCTION(PutfieldIntQuick)
+    {
+        auto value = POP().as_int();
+        POP_OBJECT();
+        object->field_at<i32>(pc->operand) = value;
+        NEXT();
+    }
+
+    INSTRUCTION(PutfieldLongQuick)
+    {
+        auto value = POP2().as_long();
+        POP_OBJECT();
+        object->field_at<i64>(pc->operand) = value;
+        NEXT();
+    }
+
+    INSTRUCTION(PutfieldReferenceQuick)
+    {
+        auto* value = POP().as_reference();
+        POP_OBJECT();
+        object->field_at<Object*>(pc->operand) = value;
+        m_runtime.heap().record_write(*object);
+        NEXT();
+    }
+
+    // Method invocation, the arguments on top of the operand stack become the first local variables of the callee.
+    // Each call site is resolved once, and then quickened with the method that it resolved to (or that it always selects).
+    INSTRUCTION(Invokevirtual)
+    INSTRUCTION(Invokeinterface)
+    {
+        auto* resolved_method = TRY_OR_THROW(m_runtime.resolve_method_reference(static_cast<SymbolicatedMethodReference&>(*pc->reference)));
+        if (resolved_method->is_static())
+            THROW("java/lang/IncompatibleClassChangeError");
+
+        // Private and final methods can't be overridden, so they are always the method that gets selected
+        auto can_be_overridden = !(resolved_method->access_flags() & (Access::Private | Access::Final)) && !(resolved_method->owner().access_flags() & Access::Final);
+        if (!can_be_overridden) {
+            if (resolved_method->is_abstract())
+                THROW("java/lang/AbstractMethodError");
+
+            pc->method = resolved_method;
+            QUICKEN(Opcode::InvokenonvirtualQuick);
+        }
+
+        // Every other call site selects the method from the class of the receiver, which is cached per call site
+        pc->inline_cache = TRY_OR_THROW(instruction_stream.add_inline_cache(*resolved_method, instruction_stream.bytecode_offset(pc - instructions)));
+        QUICKEN(pc->opcode == Opcode::Invokeinterface ? Opcode::InvokeinterfaceQuick : Opcode::InvokevirtualQuick);
+    }
+
+    INSTRUCTION(Invokespecial)
+    {
+        auto* resolved_method = TRY_OR_THROW(m_runtime.resolve_method_reference(static_cast<SymbolicatedMethodReference&>(*pc->reference)));
+        if (resolved_method->is_static())
+            THROW("java/lang/IncompatibleClassChangeError");
+
+        // Calls to a superclass' method (e.g. `super.toString()`) are looked up from the direct superclass of the current class,
+        // unless the method is an instance initialization method.
+        // The selected method doesn't depend on the receiver, so it is the same every time that this instruction is executed.
+        auto* method = resolved_method;
+        auto& resolved_class = resolved_method->owner();
+        if (resolved_method->name() != WellKnownSymbols::the().init && !resolved_class.is_interface() && &resolved_class != &klass && klass.super_class() && klass.is_assignable_to(resolved_class))
+            method = klass.super_class()->lookup_method(resolved_method->name(), resolved_method->descriptor());
+
+        if (!method || method->is_abstract())
+            THROW("java/lang/AbstractMethodError");
+
+        pc->method = method;
+        QUICKEN(Opcode::InvokenonvirtualQuick);
+    }
+
+    INSTRUCTION(Invokestatic)
+    {
+        SAFEPOINT();
+        auto* method = TRY_OR_THROW(m_runtime.resolve_method_reference(static_cast<SymbolicatedMethodReference&>(*pc->reference)));
+        if (!method->is_static())
+            THROW("java/lang/IncompatibleClassChangeError");
+
+        // The class that declared the resolved method is initialized if it hasn't been initialized already
+        TRY_OR_THROW(m_runtime.initialize_class(method->owner()));
+
+        // invokestatic_quick doesn't check the state of the class, see getstatic
+        if (method->owner().state() != Class::State::Initialized) {
+            auto* arguments = sp - method->argument_slots();
+            INVOKE(method, arguments);
+        }
+
+        pc->method = method;
+        QUICKEN(Opcode::InvokestaticQuick);
+    }
+
+    INSTRUCTION(InvokevirtualQuick)
+    INSTRUCTION(InvokeinterfaceQuick)
+    {
+        auto& inline_cache = *pc->inline_cache;
+        auto* arguments = sp - inline_cache.resolved_method().argument_slots();
+        auto* receiver = arguments[0].as_reference();
+        if (!receiver)
+            THROW("java/lang/NullPointerException");
+
+        // A miss (and every call from a megamorphic call site) selects the method from the receiver's vtable or itable
+        auto* method = inline_cache.lookup(receiver->klass());
+        if (!method) [[unlikely]] {
+            method = receiver->klass().select_method(inline_cache.resolved_method());
+            if (!method)
+                THROW("java/lang/IncompatibleClassChangeError");
+
+            if (method->is_abstract())
+                THROW("java/lang/AbstractMethodError");
+
+            inline_cache.update(receiver->klass(), *method);
+        }
+
+        INVOKE(method, arguments);
+    }
+
+    INSTRUCTION(InvokenonvirtualQuick)
+    {
+        auto* arguments = sp - pc->method->argument_slots();
+        if (!arguments[0].as_reference())
+            THROW("java/lang/NullPointerException");
+
+        INVOKE(pc->method, arguments);
+    }
+
+    INSTRUCTION(InvokestaticQuick)
+    {
+        auto* arguments = sp - pc->method->argument_slots();
+        INVOKE(pc->method, arguments);
+    }
+
+    // Each call site is linked by running its bootstrap method the first time that it's executed, see Runtime::resolve_call_site()
+    INSTRUCTION(Invokedynamic)
+    {
+        auto string_concatenation = TRY_OR_THROW(m_runtime.resolve_call_site(klass, static_cast<SymbolicatedDynamicReference&>(*pc->reference)));
+        pc->string_concatenation = TRY_OR_THROW(instruction_stream.add_string_concatenation(move(string_concatenation)));
+        QUICKEN(Opcode::InvokedynamicQuick);
+    }
+
+    INSTRUCTION(InvokedynamicQuick)
+    {
+        SAFEPOINT();
+        auto& string_concatenation = *pc->string_concatenation;
+        auto* arguments = sp - string_concatenation.argument_slots;
+        auto* string = TRY_OR_THROW(concatenate_strings(m_runtime, string_concatenation, { arguments, string_concatenation.argument_slots }));
+
+        sp = arguments;
+        PUSH(Value::from_reference(string));
+        NEXT();
+    }
+
+    // Objects
+    INSTRUCTION(New)
+    {
+        SAFEPOINT();
+        auto* class_to_instantiate = TRY_OR_THROW(m_runtime.resolve_class_reference(static_cast<SymbolicatedClassReference&>(*pc->reference)));
+        if (class_to_instantiate->is_interface() || (class_to_instantiate->access_flags() & Access::Abstract))
+            THROW("java/lang/InstantiationError");
+
+        TRY_OR_THROW(m_runtime.initialize_class(*class_to_instantiate));
+
+        // new_quick doesn't check the state of the class, see getstatic
+        if (class_to_instantiate->state() != Class::State::Initialized) {
+            PUSH(Value::from_reference(TRY_OR_THROW(m_runtime.allocate_object(*class_to_instantiate))));
+            NEXT();
+        }
+
+        pc->klass = class_to_instantiate;
+        QUICKEN(Opcode::NewQuick);
+    }
+
+    INSTRUCTION(NewQuick)
+    {
+        SAFEPOINT();
+        PUSH(Value::from_reference(TRY_OR_THROW(m_runtime.allocate_object(*pc->klass))));
+        NEXT();
+    }
+
+    INSTRUCTION(Newarray)
+    {
+        SAFEPOINT();
+        auto* array_class = TRY_OR_THROW(m_runtime.primitive_array_class(pc->index));
+        auto length = POP().as_int();
+
+        PUSH(Value::from_reference(TRY_OR_THROW(m_runtime.allocate_array(*array_class, length))));
+        NEXT();
+    }
+
+    INSTRUCTION(Anewarray)
+    {
+        auto* component_class = TRY_OR_THROW(m_runtime.resolve_class_reference(static_cast<SymbolicatedClassReference&>(*pc->reference)));
+        pc->klass = TRY_OR_THROW(m_runtime.array_class_of(*component_class));
+        QUICKEN(Opcode::AnewarrayQuick);
+    }
+
+    INSTRUCTION(AnewarrayQuick)
+    {
+        SAFEPOINT();
+        auto length = POP().as_int();
+
+        PUSH(Value::from_reference(TRY_OR_THROW(m_runtime.allocate_array(*pc->klass, length))));
+        NEXT();
+    }
+
+    INSTRUCTION(Multianewarray)
+    {
+        pc->klass = TRY_OR_THROW(m_runtime.resolve_class_reference(static_cast<SymbolicatedClassReference&>(*pc->reference)));
+        QUICKEN(Opcode::MultianewarrayQuick);
+    }
+
+    INSTRUCTION(MultianewarrayQuick)
+    {
+        SAFEPOINT();
+        auto dimensions = pc->index;
+
+        Array<i32, 255> lengths;
+        sp -= dimensions;
+        for (size_t i = 0; i < dimensions; i++)
+            lengths[i] = sp[i].as_int();
+
+        PUSH(Value::from_reference(TRY_OR_THROW(m_runtime.allocate_multi_array(*pc->klass, lengths.span().trim(dimensions)))));
+        NEXT();
+    }
+
+    INSTRUCTION(Arraylength)
+    {
+        auto* array = static_cast<ArrayObject*>(POP().as_reference());
+        if (!array)
+            THROW("java/lang/NullPointerException");
+
+        PUSH(Value::from_int(array->length()));
+        NEXT();
+    }
+
+    INSTRUCTION(Athrow)
+    {
+        auto* thrown_object = POP().as_reference();
+        if (!thrown_object)
+            THROW("java/lang/NullPointerException");
+
+        THROW_ERROR(throw_exception(*thrown_object));
+    }
+
+    // The class is only resolved once a non-null object reaches the instruction, as null passes every check
+    INSTRUCTION(Checkcast)
+    INSTRUCTION(Instanceof)
+    {
+        if (!sp[-1].as_reference()) {
+            if (pc->opcode == Opcode::Instanceof)
+                sp[-1] = Value::from_int(0);
+
+            NEXT();
+        }
+
+        pc->klass = TRY_OR_THROW(m_runtime.resolve_class_reference(static_cast<SymbolicatedClassReference&>(*pc->reference)));
+        QUICKEN(pc->opcode == Opcode::Checkcast ? Opcode::CheckcastQuick : Opcode::InstanceofQuick);
+    }
+
+    INSTRUCTION(CheckcastQuick)
+    {
+        // The operand stack is unchanged if the cast succeeds
+        auto* object = sp[-1].as_reference();
+        if (object && !object->klass().is_assignable_to(*pc->klass))
+            THROW("java/lang/ClassCastException");
+
+        NEXT();
+    }
+
+    INSTRUCTION(InstanceofQuick)
+    {
+        auto* object = POP().as_reference();
+        auto result = object && object->klass().is_assignable_to(*pc->klass);
+
+        PUSH(Value::from_int(result ? 1 : 0));
+        NEXT();
+    }
+
+    // FIXME: There's only a single thread, so monitors don't need to do anything yet.
+    INSTRUCTION(Monitorenter)
+    INSTRUCTION(Monitorexit)
+    {
+        if (!POP().as_reference())
+            THROW("java/lang/NullPointerException");
+
+        NEXT();
+    }
+
+    INSTRUCTION(Ifnull)
+    {
+        auto* object = POP().as_reference();
+        BRANCH_IF(object == nullptr);
+    }
+
+    INSTRUCTION(Ifnonnull)
+    {
+        auto* object = POP().as_reference();
+        BRANCH_IF(object != nullptr);
+    }
+
+    // wide is folded into the instruction that it modifies when the method is decoded
+    INSTRUCTION(Wide)
+    {
+        VERIFY_NOT_REACHED();
+    }
+    }
+
+    // `pc` is still the branch at the end of the hot loop, and the branch's operands have already been popped
+on_stack_replacement : {
+    auto loop = pc->index;
+    pc = instructions + instruction_stream.loops()[loop].header;
+
+    auto exit = replace_on_stack(method, instruction_stream, locals, loop);
+    if (exit.has_value()) {
+        switch (exit->reason) {
+        case JIT::ExitReason::Return:
+            return Value::from_bits(exit->value);
+        case JIT::ExitReason::Throw:
+            pc = instructions + exit->value;
+            THROW_ERROR(m_pending_error.release_value());
+        case JIT::ExitReason::Deoptimize:
+            pc = instructions + exit->value;
+            sp = locals + method.code()->max_locals() + *instruction_stream.reference_maps().stack_depth(exit->value);
+            break;
+        case JIT::ExitReason::Continue:
+        case JIT::ExitReason::TierUp:
+            VERIFY_NOT_REACHED();
+        }
+    }
+
+    DISPATCH();
+}
+
+exception_thrown : {
+    auto handler = catch_exception(method, frame, pc - instructions, exception.release_value());
+    if (handler.is_error())
+        return handler.release_error();
+
+    pc = instructions + handler.value();
+    sp = locals + method.code()->max_locals() + 1;
+    DISPATCH();
+}
+
+#undef INSTRUCTION
+#undef DISPATCH
+#undef NEXT
+#undef JUMP_TO
+#undef BRANCH_IF
+#undef QUICKEN
+#undef SAFEPOINT
+#undef PUSH
+#undef POP
+#undef PUSH2
+#undef POP2
+#undef THROW_ERROR
+#undef THROW
+#undef TRY_OR_THROW
+#undef POP_ARRAY_AND_INDEX
+#undef POP_OBJECT
+#undef INT_BINARY
+#undef LONG_BINARY
+#undef LONG_SHIFT
+#undef FLOAT_BINARY
+#undef DOUBLE_BINARY
+#undef INVOKE
+}
+
+}
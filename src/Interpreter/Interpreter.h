@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "../JIT/CodeCache.h"
+#include "Class.h"
+#include "Heap.h"
+#include "TieringPolicy.h"
+#include "Value.h"
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/Span.h>
+#include <AK/Vector.h>
+
+// Computed gotos are a GNU extension (supported by both GCC and clang), this is controlled by the CAOVM_COMPUTED_GOTO CMake option.
+#ifndef CAOVM_COMPUTED_GOTO
+#    define CAOVM_COMPUTED_GOTO 0
+#endif
+
+// The baseline JIT only generates x86-64 code for the System V calling convention, this is controlled by the CAOVM_JIT CMake option.
+#ifndef CAOVM_JIT
+#    define CAOVM_JIT 0
+#endif
+
+namespace Interpreter {
+
+// Forward-declaration
+class Runtime;
+
+// How the interpreter moves from one instruction's handler to the next.
+enum class DispatchMode {
+    // A single `switch` over the opcode, every instruction jumps back to the top of the loop.
+    // This is portable, but every dispatch goes through the same (hard to predict) indirect branch.
+    Switch,
+
+    // Direct threading: every handler ends with its own indirect jump through a table of label addresses.
+    // The branch predictor gets a separate history for each handler, which predicts common instruction pairs well.
+    Threaded,
+};
+
+// Threaded dispatch is used whenever it has been compiled in
+constexpr DispatchMode default_dispatch_mode()
+{
+    return CAOVM_COMPUTED_GOTO ? DispatchMode::Threaded : DispatchMode::Switch;
+}
+
+constexpr bool is_dispatch_mode_supported(DispatchMode mode)
+{
+    return mode == DispatchMode::Switch || CAOVM_COMPUTED_GOTO;
+}
+
+constexpr StringView dispatch_mode_name(DispatchMode mode)
+{
+    return mode == DispatchMode::Threaded ? "threaded"sv : "switch"sv;
+}
+
+constexpr bool is_jit_supported()
+{
+    return CAOVM_JIT;
+}
+
+// Executes the bytecode of methods.
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-2.html#jvms-2.6
+//
+// Every frame lives on a single contiguous stack of Values: its local variables are immediately followed by its operand stack.
+// When a method is invoked, the arguments on top of the caller's operand stack become the first local variables of the callee, without any copies.
+// Methods are executed from their decoded InstructionStream, never from the raw bytecode.
+// Instructions which refer to the constant pool are rewritten to a quick form once they have been resolved, so that they never need to be resolved again.
+// Both dispatch modes share the same instruction handlers, see Interpreter.cpp.
+//
+// Methods which are invoked often enough (or which loop for long enough) are compiled to machine code by the baseline JIT, see TieringPolicy and JIT::BaselineCompiler.
+// The hottest of those are compiled again by the optimizing JIT, see JIT::OptimizingCompiler.
+// Compiled code uses the same frames as the interpreter, and hands a frame back to the interpreter whenever it can't carry on by itself.
+// A frame can move the other way in the middle of a hot loop, from the interpreter to the compiled code.
+class Interpreter {
+public:
+    // The number of slots in the interpreter's stack, every frame takes up max_locals + max_stack slots
+    static constexpr size_t stack_slot_count = 1024 * 1024;
+
+    Interpreter(Runtime& runtime, DispatchMode dispatch_mode, Vector<Value> stack, OwnPtr<JIT::CodeCache> code_cache);
+
+    static ErrorOr<NonnullOwnPtr<Interpreter>> create(Runtime& runtime, DispatchMode dispatch_mode);
+
+    DispatchMode dispatch_mode() const { return m_dispatch_mode; };
+    void set_dispatch_mode(DispatchMode dispatch_mode)
+    {
+        VERIFY(is_dispatch_mode_supported(dispatch_mode));
+        m_dispatch_mode = dispatch_mode;
+    }
+
+    // Hot methods are only compiled while the JIT is enabled, which it is by default when it's supported
+    bool is_jit_enabled() const { return m_jit_enabled; };
+    void set_jit_enabled(bool enabled)
+    {
+        VERIFY(!enabled || m_code_cache);
+        m_jit_enabled = enabled;
+    }
+
+    // Logs every method that is compiled or optimized (or that fails to), with its optimized IR, every time that a loop moves to compiled code, and every time that compiled code is thrown away
+    void set_jit_logging_enabled(bool enabled) { m_jit_logging_enabled = enabled; };
+
+    // Decides when methods are compiled, its thresholds can be changed before anything runs
+    TieringPolicy& tiering_policy() { return m_tiering_policy; };
+
+    // Invokes a method from outside of the bytecode, e.g. `main`, `<clinit>`, or from a native method.
+    // The arguments must be laid out as the method's local variables, including `this` for instance methods.
+    ErrorOr<Value> invoke(Method& method, ReadonlySpan<Value> arguments);
+
+    // Invokes a method whose arguments are already on top of the caller's operand stack, like the invoke instructions do.
+    // Compiled code calls this, as it doesn't have a dispatch mode of its own.
+    ErrorOr<Value> invoke_in_place(Method& method, Value* arguments);
+
+    // The error that compiled code's helper functions fail with, which is returned once the compiled code has exited
+    void set_pending_error(Error error) { m_pending_error = move(error); };
+
+    // Exceptions are propagated as errors, from the instruction that threw them to the first frame with an exception handler that catches them.
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-2.html#jvms-2.10
+    //
+    // An exception which the Java Virtual Machine throws itself (e.g. java/lang/NullPointerException) is an error with the binary name of its class,
+    // its object is only allocated once something catches it. An exception object which Java code throws is kept here until it's caught,
+    // and the returned error is propagated in its place.
+    Error throw_exception(Object& exception);
+
+    // The class of the exception that an error propagates, or null if the error isn't a Java exception (e.g. running out of memory while parsing a class file)
+    Class* exception_class(Error const& error);
+
+    // The exception object that an error propagates, allocating it if it hasn't been allocated yet.
+    // Anything that isn't a Java exception is returned as the error.
+    ErrorOr<Object*> exception_object(Error error);
+
+    Runtime& runtime() { return m_runtime; };
+
+    // Objects allocated by this thread are bump-allocated from its own buffer, see Heap
+    ThreadLocalAllocationBuffer& allocation_buffer() { return m_allocation_buffer; };
+
+    // Visits every reference in the frames that are executing, which are found with the reference maps of each frame's method
+    void visit_roots(ReferenceVisitor const& visitor);
+
+private:
+    // A frame which is executing bytecode, each one links to the frame that was executing before it
+    struct Frame {
+        Frame* caller { nullptr };
+        InstructionStream& instruction_stream;
+        Value* locals { nullptr };
+
+        // This is only updated by instructions where the garbage collector can run, see ReferenceMaps::is_safepoint().
+        // Any other instruction would have to store it on every dispatch.
+        Instruction* pc { nullptr };
+    };
+
+    template<DispatchMode mode>
+    ErrorOr<Value> call(Method& method, Value* arguments);
+
+    // Starts executing at the instruction at `start_index`, which is only ever non-zero when compiled code has handed the frame over.
+    // The operand stack must already hold whatever the instruction expects.
+    // If there is an exception, it has been thrown by that instruction, and the frame carries on from whichever of its exception handlers catches it.
+    template<DispatchMode mode>
+    ErrorOr<Value> execute(Method& method, InstructionStream& instruction_stream, Value* locals, u32 start_index = 0, Optional<Error> exception = {});
+
+    // Finds the first of the frame's exception handlers which catches an exception thrown by the instruction at `index`, and puts the exception on the operand stack.
+    // Returns the index of the handler's first instruction, or the error if no handler catches it.
+    ErrorOr<u32> catch_exception(Method& method, Frame& frame, u32 index, Error error);
+
+    template<DispatchMode mode>
+    ErrorOr<Value> execute_compiled_code(Method& method, InstructionStream& instruction_stream, Value* locals);
+
+    // Runs compiled code on a frame, starting at the entry point's instruction, and throws the code away if it keeps deoptimizing
+    JIT::Exit run_compiled_code(Method& method, InstructionStream& instruction_stream, Value* locals, JIT::EntryPoint entry_point, u32 start_index);
+
+    // Moves a frame that the interpreter is executing into compiled code, at the header of a hot loop.
+    // The method is compiled first if it needs to be, nothing happens if it can't be compiled.
+    Optional<JIT::Exit> replace_on_stack(Method& method, InstructionStream& instruction_stream, Value* locals, u16 loop);
+
+    // Marks the method as not compilable if it fails to compile
+    void compile(Method& method, InstructionStream& instruction_stream);
+
+    // Replaces the method's baseline code with optimized code, and marks the method as not optimizable if it fails to compile
+    void optimize(Method& method, InstructionStream& instruction_stream);
+
+    // Moves a frame from a hot loop of baseline code into optimized code, at the loop's header
+    JIT::Exit tier_up(Method& method, InstructionStream& instruction_stream, Value* locals, u16 loop);
+
+    Runtime& m_runtime;
+    DispatchMode m_dispatch_mode;
+
+    Vector<Value> m_stack;
+
+    // The first slot after the frame that is currently executing, anything invoked from outside of the bytecode starts here.
+    Value* m_stack_top { nullptr };
+
+    // The innermost frame which is executing bytecode, native methods don't have a frame
+    Frame* m_current_frame { nullptr };
+
+    ThreadLocalAllocationBuffer m_allocation_buffer;
+
+    // Only created when the JIT is supported
+    OwnPtr<JIT::CodeCache> m_code_cache;
+    TieringPolicy m_tiering_policy;
+    bool m_jit_enabled { false };
+    bool m_jit_logging_enabled { false };
+    Optional<Error> m_pending_error;
+
+    // The exception object that is being thrown, see throw_exception()
+    Object* m_pending_exception { nullptr };
+};
+
+}
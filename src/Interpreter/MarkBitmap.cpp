@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "MarkBitmap.h"
+#include <string.h>
+#include <sys/mman.h>
+
+namespace Interpreter {
+
+MarkBitmap::MarkBitmap(u8 const* heap_base, u64* words, size_t word_count)
+    : m_heap_base(heap_base)
+    , m_words(words)
+    , m_word_count(word_count)
+{
+}
+
+MarkBitmap::~MarkBitmap()
+{
+    munmap(m_words, m_word_count * sizeof(u64));
+}
+
+ErrorOr<NonnullOwnPtr<MarkBitmap>> MarkBitmap::create(u8 const* heap_base, size_t heap_size)
+{
+    auto word_count = (heap_size + bytes_per_word - 1) / bytes_per_word;
+
+    auto* words = mmap(nullptr, word_count * sizeof(u64), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (words == MAP_FAILED)
+        return Error::from_errno(errno);
+
+    auto bitmap = try_make<MarkBitmap>(heap_base, static_cast<u64*>(words), word_count);
+    if (bitmap.is_error())
+        munmap(words, word_count * sizeof(u64));
+
+    return bitmap;
+}
+
+void MarkBitmap::clear(u8 const* start, u8 const* end)
+{
+    auto first_word = bit_index(start) / 64;
+    auto end_word = (bit_index(end) + 63) / 64;
+    memset(m_words + first_word, 0, (end_word - first_word) * sizeof(u64));
+}
+
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/BuiltinWrappers.h>
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Types.h>
+
+namespace Interpreter {
+
+// The mark bits of every object in the heap, kept to the side of the objects themselves.
+//
+// There's one bit for every `bytes_per_bit` bytes of the heap, and an object is marked by setting the bit of its first word.
+// Bits are set atomically, so that several threads can mark at once, and the thread that sets an object's bit is the one that scans it.
+// Like the heap, the bitmap is mapped lazily, so only the parts of it that cover objects which have been marked take up memory.
+class MarkBitmap {
+public:
+    // Objects are never closer together than this, see Heap::object_alignment
+    static constexpr size_t bytes_per_bit = 8;
+    static constexpr size_t bytes_per_word = bytes_per_bit * 64;
+
+    MarkBitmap(u8 const* heap_base, u64* words, size_t word_count);
+    ~MarkBitmap();
+
+    static ErrorOr<NonnullOwnPtr<MarkBitmap>> create(u8 const* heap_base, size_t heap_size);
+
+    // Returns whether the object wasn't marked yet, i.e. whether the caller has to scan it
+    bool mark(void const* address)
+    {
+        auto index = bit_index(address);
+        auto bit = static_cast<u64>(1) << (index % 64);
+        return !(AK::atomic_fetch_or(&m_words[index / 64], bit, AK::MemoryOrder::memory_order_relaxed) & bit);
+    }
+
+    bool is_marked(void const* address) const
+    {
+        auto index = bit_index(address);
+        return m_words[index / 64] & (static_cast<u64>(1) << (index % 64));
+    }
+
+    // Calls the callback with the address of each marked object between `start` and `end`, in address order.
+    // `start` must be the start of a word of the bitmap, and the bitmap must not be changing.
+    template<typename Callback>
+    void for_each_marked(u8* start, u8* end, Callback callback) const
+    {
+        auto first_word = bit_index(start) / 64;
+        auto end_word = (bit_index(end) + 63) / 64;
+        for (auto word = first_word; word < end_word; word++) {
+            for (auto bits = m_words[word]; bits; bits &= bits - 1) {
+                auto bit = count_trailing_zeroes(bits);
+                callback(const_cast<u8*>(m_heap_base) + (word * 64 + bit) * bytes_per_bit);
+            }
+        }
+    }
+
+    // Unmarks every object between `start` and `end`, which must both be the start of a word of the bitmap
+    void clear(u8 const* start, u8 const* end);
+
+private:
+    size_t bit_index(void const* address) const { return static_cast<size_t>(static_cast<u8 const*>(address) - m_heap_base) / bytes_per_bit; };
+
+    u8 const* m_heap_base;
+    u64* m_words;
+    size_t m_word_count;
+};
+
+}
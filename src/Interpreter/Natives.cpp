@@ -0,0 +1,531 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Natives.h"
+#include "Runtime.h"
+#include <AK/StringBuilder.h>
+#include <math.h>
+#include <time.h>
+
+namespace Interpreter {
+
+static ErrorOr<void> add_native_method(Class& klass, StringView name, StringView descriptor, u16 access_flags, NativeFunction native_function)
+{
+    TRY(klass.add_native_method(TRY(Symbol::intern(name)), TRY(Symbol::intern(descriptor)), access_flags, native_function));
+    return {};
+}
+
+// Class names are printed with dots instead of slashes, e.g. `java.lang.Object`
+static void append_class_name(StringBuilder& builder, Class const& klass)
+{
+    for (auto character : klass.name().view())
+        builder.append(character == '/' ? '.' : character);
+}
+
+static void append_floating_point(StringBuilder& builder, double value)
+{
+    if (isnan(value)) {
+        builder.append("NaN"sv);
+        return;
+    }
+
+    if (isinf(value)) {
+        builder.append(value > 0 ? "Infinity"sv : "-Infinity"sv);
+        return;
+    }
+
+    // Java always prints at least one digit after the decimal point
+    if (value == trunc(value) && fabs(value) < 1e7) {
+        builder.appendff("{}{}.0", signbit(value) && value == 0 ? "-"sv : ""sv, static_cast<i64>(value));
+        return;
+    }
+
+    // FIXME: Java prints the shortest decimal that uniquely identifies the value, and uses scientific notation outside of [10^-3, 10^7).
+    builder.appendff("{}", value);
+}
+
+// Appends a value the same way that String.valueOf would
+static ErrorOr<void> append_value(Runtime& runtime, StringBuilder& builder, char type, Value value)
+{
+    switch (type) {
+    case FieldDescriptor::Boolean:
+        builder.append(value.as_int() ? "true"sv : "false"sv);
+        return {};
+
+    case FieldDescriptor::Char:
+        builder.append_code_point(static_cast<u16>(value.as_int()));
+        return {};
+
+    case FieldDescriptor::Int:
+        builder.appendff("{}", value.as_int());
+        return {};
+
+    case FieldDescriptor::Long:
+        builder.appendff("{}", value.as_long());
+        return {};
+
+    case FieldDescriptor::Float:
+        append_floating_point(builder, value.as_float());
+        return {};
+
+    case FieldDescriptor::Double:
+        append_floating_point(builder, value.as_double());
+        return {};
+
+    case FieldDescriptor::ArrayDimension: {
+        // The only array overloads are for char[]
+        auto* array = static_cast<ArrayObject*>(value.as_reference());
+        if (!array)
+            return Error::from_string_literal("java/lang/NullPointerException");
+
+        for (i32 i = 0; i < array->length(); i++)
+            builder.append_code_point(array->element_at<u16>(i));
+
+        return {};
+    }
+
+    case FieldDescriptor::ReferenceStart: {
+        auto* object = value.as_reference();
+        if (!object) {
+            builder.append("null"sv);
+            return {};
+        }
+
+        if (runtime.is_string(*object)) {
+            builder.append(runtime.string_value(*object));
+            return {};
+        }
+
+        // Any other object is converted by its toString, which can run the garbage collector
+        auto const& symbols = WellKnownSymbols::the();
+        if (auto* to_string = object->klass().lookup_method(symbols.to_string, symbols.to_string_descriptor)) {
+            auto* string = TRY(runtime.interpreter().invoke(*to_string, { &value, 1 })).as_reference();
+            builder.append(string && runtime.is_string(*string) ? runtime.string_value(*string) : "null"sv);
+            return {};
+        }
+
+        // The default implementation of Object.toString
+        append_class_name(builder, object->klass());
+        builder.appendff("@{:x}", static_cast<u32>(TRY(runtime.heap().identity_hash_code(*object))));
+        return {};
+    }
+
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+// https://docs.oracle.com/en/java/javase/17/docs/api/java.base/java/io/PrintStream.html
+// FIXME: Every PrintStream writes to the standard output.
+template<char type, bool newline>
+static ErrorOr<Value> print_stream_print(Runtime& runtime, Span<Value> arguments)
+{
+    // The first argument is the PrintStream itself
+    StringBuilder builder;
+    if constexpr (type != MethodDescriptor::Void)
+        TRY(append_value(runtime, builder, type, arguments[1]));
+
+    if constexpr (newline)
+        builder.append('\n');
+
+    out("{}", builder.string_view());
+    return Value();
+}
+
+struct PrintMethod {
+    StringView name;
+    StringView descriptor;
+    NativeFunction function;
+};
+
+static constexpr PrintMethod print_methods[] = {
+    { "println"sv, "()V"sv, print_stream_print<MethodDescriptor::Void, true> },
+    { "println"sv, "(Z)V"sv, print_stream_print<FieldDescriptor::Boolean, true> },
+    { "println"sv, "(C)V"sv, print_stream_print<FieldDescriptor::Char, true> },
+    { "println"sv, "(I)V"sv, print_stream_print<FieldDescriptor::Int, true> },
+    { "println"sv, "(J)V"sv, print_stream_print<FieldDescriptor::Long, true> },
+    { "println"sv, "(F)V"sv, print_stream_print<FieldDescriptor::Float, true> },
+    { "println"sv, "(D)V"sv, print_stream_print<FieldDescriptor::Double, true> },
+    { "println"sv, "([C)V"sv, print_stream_print<FieldDescriptor::ArrayDimension, true> },
+    { "println"sv, "(Ljava/lang/String;)V"sv, print_stream_print<FieldDescriptor::ReferenceStart, true> },
+    { "println"sv, "(Ljava/lang/Object;)V"sv, print_stream_print<FieldDescriptor::ReferenceStart, true> },
+    { "print"sv, "(Z)V"sv, print_stream_print<FieldDescriptor::Boolean, false> },
+    { "print"sv, "(C)V"sv, print_stream_print<FieldDescriptor::Char, false> },
+    { "print"sv, "(I)V"sv, print_stream_print<FieldDescriptor::Int, false> },
+    { "print"sv, "(J)V"sv, print_stream_print<FieldDescriptor::Long, false> },
+    { "print"sv, "(F)V"sv, print_stream_print<FieldDescriptor::Float, false> },
+    { "print"sv, "(D)V"sv, print_stream_print<FieldDescriptor::Double, false> },
+    { "print"sv, "([C)V"sv, print_stream_print<FieldDescriptor::ArrayDimension, false> },
+    { "print"sv, "(Ljava/lang/String;)V"sv, print_stream_print<FieldDescriptor::ReferenceStart, false> },
+    { "print"sv, "(Ljava/lang/Object;)V"sv, print_stream_print<FieldDescriptor::ReferenceStart, false> },
+};
+
+// https://docs.oracle.com/en/java/javase/17/docs/api/java.base/java/lang/Object.html
+static ErrorOr<Value> object_init(Runtime&, Span<Value>)
+{
+    return Value();
+}
+
+// Objects move when garbage is collected, so their hash code can't just be their address
+static ErrorOr<Value> object_hash_code(Runtime& runtime, Span<Value> arguments)
+{
+    return Value::from_int(TRY(runtime.heap().identity_hash_code(*arguments[0].as_reference())));
+}
+
+// https://docs.oracle.com/en/java/javase/17/docs/api/java.base/java/lang/String.html
+static ErrorOr<Value> string_length(Runtime& runtime, Span<Value> arguments)
+{
+    // FIXME: This is the length in bytes, not UTF-16 code units.
+    return Value::from_int(static_cast<i32>(runtime.string_value(*arguments[0].as_reference()).length()));
+}
+
+static ErrorOr<Value> string_hash_code(Runtime& runtime, Span<Value> arguments)
+{
+    // s[0]*31^(n-1) + s[1]*31^(n-2) + ... + s[n-1]
+    u32 hash = 0;
+    for (auto character : runtime.string_value(*arguments[0].as_reference()))
+        hash = 31 * hash + static_cast<u8>(character);
+
+    return Value::from_int(static_cast<i32>(hash));
+}
+
+static ErrorOr<Value> string_to_string(Runtime&, Span<Value> arguments)
+{
+    return arguments[0];
+}
+
+// https://docs.oracle.com/en/java/javase/17/docs/api/java.base/java/lang/Class.html
+// The binary name of the class with dots instead of slashes, e.g. `java.lang.String` or `[Ljava.lang.String;`
+static ErrorOr<Value> class_get_name(Runtime& runtime, Span<Value> arguments)
+{
+    StringBuilder builder;
+    append_class_name(builder, runtime.represented_class(*arguments[0].as_reference()));
+
+    return Value::from_reference(TRY(runtime.allocate_string(builder.string_view())));
+}
+
+// The name of the class, preceded by whether it's a class or an interface, e.g. `class java.lang.String`
+static ErrorOr<Value> class_to_string(Runtime& runtime, Span<Value> arguments)
+{
+    auto& klass = runtime.represented_class(*arguments[0].as_reference());
+
+    StringBuilder builder;
+    builder.append(klass.is_interface() ? "interface "sv : "class "sv);
+    append_class_name(builder, klass);
+
+    return Value::from_reference(TRY(runtime.allocate_string(builder.string_view())));
+}
+
+// https://docs.oracle.com/en/java/javase/17/docs/api/java.base/java/lang/Throwable.html
+// A throwable only has a detail message, stack traces and causes aren't recorded.
+// The message is stored in a field that isn't visible to Java code, like the contents of a string.
+static ErrorOr<Field*> detail_message_field(Object& throwable)
+{
+    auto* field = throwable.klass().lookup_field(TRY(Symbol::intern("<detailMessage>"sv)), TRY(Symbol::intern("Ljava/lang/String;"sv)));
+    VERIFY(field);
+    return field;
+}
+
+static ErrorOr<Value> throwable_init_with_message(Runtime& runtime, Span<Value> arguments)
+{
+    auto& throwable = *arguments[0].as_reference();
+    auto* field = TRY(detail_message_field(throwable));
+
+    throwable.field_at<Object*>(field->offset()) = arguments[1].as_reference();
+    runtime.heap().record_write(throwable);
+    return Value();
+}
+
+static ErrorOr<Value> throwable_get_message(Runtime&, Span<Value> arguments)
+{
+    auto& throwable = *arguments[0].as_reference();
+    auto* field = TRY(detail_message_field(throwable));
+
+    return Value::from_reference(throwable.field_at<Object*>(field->offset()));
+}
+
+// The name of the throwable's class, followed by its detail message if it has one, e.g. `java.lang.RuntimeException: Something went wrong`
+static ErrorOr<Value> throwable_to_string(Runtime& runtime, Span<Value> arguments)
+{
+    auto& throwable = *arguments[0].as_reference();
+    auto* message = throwable.field_at<Object*>(TRY(detail_message_field(throwable))->offset());
+
+    StringBuilder builder;
+    append_class_name(builder, throwable.klass());
+    if (message) {
+        builder.append(": "sv);
+        builder.append(runtime.string_value(*message));
+    }
+
+    return Value::from_reference(TRY(runtime.allocate_string(builder.string_view())));
+}
+
+// Without a stack trace, this only prints the throwable itself
+static ErrorOr<Value> throwable_print_stack_trace(Runtime& runtime, Span<Value> arguments)
+{
+    StringBuilder builder;
+    TRY(append_value(runtime, builder, FieldDescriptor::ReferenceStart, arguments[0]));
+
+    warnln("{}", builder.string_view());
+    return Value();
+}
+
+// The subclasses of Throwable that the Java Virtual Machine throws itself, along with their superclasses.
+// Each one comes after its superclass, and only inherits Throwable's methods.
+struct ExceptionClass {
+    StringView name;
+    StringView super_class_name;
+};
+
+static constexpr ExceptionClass exception_classes[] = {
+    { "java/lang/Exception"sv, "java/lang/Throwable"sv },
+    { "java/lang/RuntimeException"sv, "java/lang/Exception"sv },
+    { "java/lang/ArithmeticException"sv, "java/lang/RuntimeException"sv },
+    { "java/lang/ArrayStoreException"sv, "java/lang/RuntimeException"sv },
+    { "java/lang/ClassCastException"sv, "java/lang/RuntimeException"sv },
+    { "java/lang/IllegalArgumentException"sv, "java/lang/RuntimeException"sv },
+    { "java/lang/IllegalStateException"sv, "java/lang/RuntimeException"sv },
+    { "java/lang/IndexOutOfBoundsException"sv, "java/lang/RuntimeException"sv },
+    { "java/lang/ArrayIndexOutOfBoundsException"sv, "java/lang/IndexOutOfBoundsException"sv },
+    { "java/lang/NegativeArraySizeException"sv, "java/lang/RuntimeException"sv },
+    { "java/lang/NullPointerException"sv, "java/lang/RuntimeException"sv },
+    { "java/lang/UnsupportedOperationException"sv, "java/lang/RuntimeException"sv },
+    { "java/lang/Error"sv, "java/lang/Throwable"sv },
+    { "java/lang/LinkageError"sv, "java/lang/Error"sv },
+    { "java/lang/BootstrapMethodError"sv, "java/lang/LinkageError"sv },
+    { "java/lang/ClassCircularityError"sv, "java/lang/LinkageError"sv },
+    { "java/lang/IncompatibleClassChangeError"sv, "java/lang/LinkageError"sv },
+    { "java/lang/AbstractMethodError"sv, "java/lang/IncompatibleClassChangeError"sv },
+    { "java/lang/InstantiationError"sv, "java/lang/IncompatibleClassChangeError"sv },
+    { "java/lang/NoSuchFieldError"sv, "java/lang/IncompatibleClassChangeError"sv },
+    { "java/lang/NoSuchMethodError"sv, "java/lang/IncompatibleClassChangeError"sv },
+    { "java/lang/NoClassDefFoundError"sv, "java/lang/LinkageError"sv },
+    { "java/lang/VerifyError"sv, "java/lang/LinkageError"sv },
+    { "java/lang/VirtualMachineError"sv, "java/lang/Error"sv },
+    { "java/lang/OutOfMemoryError"sv, "java/lang/VirtualMachineError"sv },
+    { "java/lang/StackOverflowError"sv, "java/lang/VirtualMachineError"sv },
+};
+
+// https://docs.oracle.com/en/java/javase/17/docs/api/java.base/java/lang/System.html
+static ErrorOr<Value> system_current_time_millis(Runtime&, Span<Value>)
+{
+    timespec now {};
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    return Value::from_long(static_cast<i64>(now.tv_sec) * 1000 + now.tv_nsec / 1000000);
+}
+
+static ErrorOr<Value> system_nano_time(Runtime&, Span<Value>)
+{
+    timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return Value::from_long(static_cast<i64>(now.tv_sec) * 1000000000 + now.tv_nsec);
+}
+
+ErrorOr<void> define_bootstrap_classes(Runtime& runtime)
+{
+    auto const& symbols = WellKnownSymbols::the();
+
+    auto* object_class = TRY(runtime.define_class(symbols.java_lang_Object, Access::Public, nullptr));
+    TRY(add_native_method(*object_class, "<init>"sv, "()V"sv, Access::Public, object_init));
+    TRY(add_native_method(*object_class, "hashCode"sv, "()I"sv, Access::Public, object_hash_code));
+
+    // The contents of a string are stored as bytes, in an array that's referenced by a field that isn't visible to Java code
+    auto* string_class = TRY(runtime.define_class(symbols.java_lang_String, Access::Public | Access::Final, object_class));
+    auto* string_value_field = TRY(string_class->add_field(TRY(Symbol::intern("<value>"sv)), TRY(Symbol::intern("[B"sv)), Access::Private | Access::Final));
+    runtime.set_string_value_field(*string_value_field);
+
+    TRY(add_native_method(*string_class, "length"sv, "()I"sv, Access::Public, string_length));
+    TRY(add_native_method(*string_class, "hashCode"sv, "()I"sv, Access::Public, string_hash_code));
+    TRY(add_native_method(*string_class, "toString"sv, "()Ljava/lang/String;"sv, Access::Public, string_to_string));
+
+    // A class object references the class that it represents from a field that isn't visible to Java code, see Runtime::class_object()
+    auto* class_class = TRY(runtime.define_class(symbols.java_lang_Class, Access::Public | Access::Final, object_class));
+    auto* represented_class_field = TRY(class_class->add_field(TRY(Symbol::intern("<class>"sv)), TRY(Symbol::intern("J"sv)), Access::Private | Access::Final));
+    runtime.set_represented_class_field(*represented_class_field);
+
+    TRY(add_native_method(*class_class, "getName"sv, "()Ljava/lang/String;"sv, Access::Public, class_get_name));
+    TRY(add_native_method(*class_class, "toString"sv, "()Ljava/lang/String;"sv, Access::Public, class_to_string));
+
+    auto* print_stream_class = TRY(runtime.define_class(symbols.java_io_PrintStream, Access::Public, object_class));
+    for (auto const& print_method : print_methods)
+        TRY(add_native_method(*print_stream_class, print_method.name, print_method.descriptor, Access::Public, print_method.function));
+
+    auto* system_class = TRY(runtime.define_class(symbols.java_lang_System, Access::Public | Access::Final, object_class));
+    TRY(add_native_method(*system_class, "currentTimeMillis"sv, "()J"sv, Access::Public | Access::Static, system_current_time_millis));
+    TRY(add_native_method(*system_class, "nanoTime"sv, "()J"sv, Access::Public | Access::Static, system_nano_time));
+
+    auto* out_field = TRY(system_class->add_field(TRY(Symbol::intern("out"sv)), TRY(Symbol::intern("Ljava/io/PrintStream;"sv)), Access::Public | Access::Static | Access::Final));
+
+    auto* throwable_class = TRY(runtime.define_class(symbols.java_lang_Throwable, Access::Public, object_class));
+    TRY(throwable_class->add_field(TRY(Symbol::intern("<detailMessage>"sv)), TRY(Symbol::intern("Ljava/lang/String;"sv)), Access::Private));
+    TRY(add_native_method(*throwable_class, "<init>"sv, "()V"sv, Access::Public, object_init));
+    TRY(add_native_method(*throwable_class, "<init>"sv, "(Ljava/lang/String;)V"sv, Access::Public, throwable_init_with_message));
+    TRY(add_native_method(*throwable_class, "getMessage"sv, "()Ljava/lang/String;"sv, Access::Public, throwable_get_message));
+    TRY(add_native_method(*throwable_class, "getLocalizedMessage"sv, "()Ljava/lang/String;"sv, Access::Public, throwable_get_message));
+    TRY(add_native_method(*throwable_class, "toString"sv, "()Ljava/lang/String;"sv, Access::Public, throwable_to_string));
+    TRY(add_native_method(*throwable_class, "printStackTrace"sv, "()V"sv, Access::Public, throwable_print_stack_trace));
+
+    Vector<Class*> classes;
+    for (auto* klass : { object_class, string_class, class_class, print_stream_class, system_class, throwable_class })
+        TRY(classes.try_append(klass));
+
+    for (auto const& exception_class : exception_classes) {
+        auto* super_class = runtime.find_class(TRY(Symbol::intern(exception_class.super_class_name)));
+        VERIFY(super_class);
+
+        TRY(classes.try_append(TRY(runtime.define_class(TRY(Symbol::intern(exception_class.name)), Access::Public, super_class))));
+    }
+
+    // None of these classes have a static initializer.
+    // They are laid out once all of their fields and native methods have been added, superclasses first.
+    for (auto* klass : classes) {
+        TRY(klass->lay_out_instance_fields());
+        TRY(klass->build_dispatch_tables());
+        klass->set_state(Class::State::Initialized);
+    }
+
+    system_class->static_value_at(out_field->offset()) = Value::from_reference(TRY(runtime.allocate_object(*print_stream_class)));
+
+    return {};
+}
+
+// https://docs.oracle.com/en/java/javase/17/docs/api/java.base/java/lang/invoke/StringConcatFactory.html#makeConcatWithConstants(java.lang.invoke.MethodHandles.Lookup,java.lang.String,java.lang.invoke.MethodType,java.lang.String,java.lang.Object...)
+ErrorOr<NonnullOwnPtr<StringConcatenation>> link_string_concatenation(SymbolicatedConstantPool& constant_pool, Symbol descriptor, bool has_recipe, ReadonlySpan<u16> static_arguments)
+{
+    // The bootstrap method would fail with a StringConcatException, which linking wraps in a BootstrapMethodError
+    auto linkage_error = [&](StringView reason) {
+        dbgln("Natives: Can't link the string concatenation {}: {}", descriptor, reason);
+        return Error::from_string_literal("java/lang/BootstrapMethodError");
+    };
+
+    auto descriptor_info = TRY(parse_method_descriptor(descriptor.view()));
+    if (descriptor_info.return_type != FieldDescriptor::ReferenceStart)
+        return linkage_error("It doesn't return a string"sv);
+
+    auto string_concatenation = TRY(try_make<StringConcatenation>());
+    string_concatenation->argument_slots = descriptor_info.parameter_slots;
+
+    // There are never more parameters than parameter slots
+    Vector<StringConcatenation::Part> arguments;
+    TRY(arguments.try_ensure_capacity(descriptor_info.parameter_slots));
+
+    u16 argument_slot = 0;
+    TRY(for_each_parameter_type(descriptor.view(), [&](char type) {
+        StringConcatenation::Part argument { .argument_type = type, .argument_slot = argument_slot };
+        if (type == FieldDescriptor::Byte || type == FieldDescriptor::Short)
+            argument.argument_type = FieldDescriptor::Int;
+        else if (type == FieldDescriptor::ArrayDimension)
+            argument.argument_type = FieldDescriptor::ReferenceStart;
+
+        arguments.unchecked_append(argument);
+        argument_slot += type == FieldDescriptor::ArrayDimension ? 1 : slot_count_for_descriptor(type);
+    }));
+
+    if (!has_recipe) {
+        if (!static_arguments.is_empty())
+            return linkage_error("makeConcat doesn't have any static arguments"sv);
+
+        string_concatenation->parts = move(arguments);
+        return string_concatenation;
+    }
+
+    // The recipe is the first static argument, the others are the constants that it refers to
+    auto string_at = [&](u16 index) -> ErrorOr<Optional<Symbol>> {
+        if (!constant_pool.parsed_pool()->is_valid_index(index) || constant_pool.parsed_pool()->tag_at(index) != Constant::Tag::String)
+            return Optional<Symbol> {};
+
+        return TRY(constant_pool.get_or_symbolicate_string(index))->value();
+    };
+
+    auto recipe = static_arguments.is_empty() ? Optional<Symbol> {} : TRY(string_at(static_arguments[0]));
+    if (!recipe.has_value())
+        return linkage_error("The recipe isn't a string constant"sv);
+
+    // Each \1 in the recipe is the next argument, and each \2 is the next constant. Everything else is copied as it is.
+    static constexpr char argument_tag = '\1';
+    static constexpr char constant_tag = '\2';
+
+    StringBuilder text;
+    auto append_text = [&]() -> ErrorOr<void> {
+        if (text.is_empty())
+            return {};
+
+        TRY(string_concatenation->parts.try_append(StringConcatenation::Part { .text = TRY(Symbol::intern(text.string_view())) }));
+        text.clear();
+        return {};
+    };
+
+    size_t next_argument = 0;
+    size_t next_constant = 1;
+    for (auto character : recipe->view()) {
+        if (character == argument_tag) {
+            if (next_argument == arguments.size())
+                return linkage_error("The recipe has more arguments than the call site"sv);
+
+            TRY(append_text());
+            TRY(string_concatenation->parts.try_append(arguments[next_argument++]));
+            continue;
+        }
+
+        if (character != constant_tag) {
+            text.append(character);
+            continue;
+        }
+
+        // The constants are converted to strings once, when the call site is linked
+        if (next_constant == static_arguments.size())
+            return linkage_error("The recipe has more constants than the bootstrap method"sv);
+
+        auto index = static_arguments[next_constant++];
+        if (auto string = TRY(string_at(index)); string.has_value()) {
+            text.append(string->view());
+            continue;
+        }
+
+        if (!constant_pool.parsed_pool()->is_valid_index(index))
+            return linkage_error("A constant is out of bounds"sv);
+
+        switch (constant_pool.parsed_pool()->tag_at(index)) {
+        case Constant::Tag::Integer:
+            text.appendff("{}", TRY(constant_pool.get_or_symbolicate_numeric(index))->as_int());
+            break;
+        case Constant::Tag::Long:
+            text.appendff("{}", TRY(constant_pool.get_or_symbolicate_numeric(index))->as_long());
+            break;
+        case Constant::Tag::Float:
+            append_floating_point(text, TRY(constant_pool.get_or_symbolicate_numeric(index))->as_float());
+            break;
+        case Constant::Tag::Double:
+            append_floating_point(text, TRY(constant_pool.get_or_symbolicate_numeric(index))->as_double());
+            break;
+        default:
+            return linkage_error("Only string and numeric constants are supported"sv);
+        }
+    }
+
+    if (next_argument != arguments.size())
+        return linkage_error("The recipe has fewer arguments than the call site"sv);
+
+    TRY(append_text());
+    return string_concatenation;
+}
+
+ErrorOr<Object*> concatenate_strings(Runtime& runtime, StringConcatenation const& string_concatenation, ReadonlySpan<Value> arguments)
+{
+    StringBuilder builder;
+    for (auto const& part : string_concatenation.parts) {
+        if (part.argument_type == 0)
+            builder.append(part.text.view());
+        else
+            TRY(append_value(runtime, builder, part.argument_type, arguments[part.argument_slot]));
+    }
+
+    return runtime.allocate_string(builder.string_view());
+}
+
+}
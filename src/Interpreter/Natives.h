@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "../Symbol.h"
+#include "InstructionStream.h"
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Span.h>
+
+namespace Interpreter {
+
+// Forward-declaration
+class Runtime;
+
+// Defines the classes that the runtime always provides itself, along with their native methods.
+// These are just enough of java.lang and java.io to run simple programs without a class library on the classpath,
+// including java/lang/Throwable and every exception that the Java Virtual Machine throws itself.
+ErrorOr<void> define_bootstrap_classes(Runtime& runtime);
+
+// Links an invokedynamic call site whose bootstrap method is one of StringConcatFactory's, given the bootstrap method's static arguments.
+// https://docs.oracle.com/en/java/javase/17/docs/api/java.base/java/lang/invoke/StringConcatFactory.html
+// makeConcatWithConstants has a recipe (and the constants that it refers to), makeConcat appends the arguments in order.
+ErrorOr<NonnullOwnPtr<StringConcatenation>> link_string_concatenation(SymbolicatedConstantPool& constant_pool, Symbol descriptor, bool has_recipe, ReadonlySpan<u16> static_arguments);
+
+// Converts each argument of a linked call site the same way that String.valueOf would, and returns the concatenation as a new string.
+// Converting an object calls its toString, which can run the garbage collector, so the arguments must be somewhere that the garbage collector updates.
+ErrorOr<Object*> concatenate_strings(Runtime& runtime, StringConcatenation const& string_concatenation, ReadonlySpan<Value> arguments);
+
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "Value.h"
+#include <AK/BitCast.h>
+#include <AK/Types.h>
+
+namespace Interpreter {
+
+// Forward-declaration
+class Class;
+
+// Every object on the heap starts with this header, its instance fields immediately follow it.
+class Object {
+public:
+    Object(Class& klass)
+        : m_class(&klass)
+    {
+    }
+
+    Class& klass() const { return *m_class; };
+
+    // Once the garbage collector has copied an object, the original's class is replaced by the address of its copy.
+    // Classes are at least 8-byte aligned, so the lowest bit tells the two apart. See Heap::collect_garbage().
+    bool is_forwarded() const { return bit_cast<FlatPtr>(m_class) & forwarded_bit; };
+    Object* forwarding_address() const { return bit_cast<Object*>(bit_cast<FlatPtr>(m_class) & ~forwarded_bit); };
+    void set_forwarding_address(Object* copy) { m_class = bit_cast<Class*>(bit_cast<FlatPtr>(copy) | forwarded_bit); };
+
+    // The instance fields of this object, a field's offset is relative to the start of this storage.
+    // Each field is stored with the size of its type, and is aligned to that size, see Class::lay_out_instance_fields().
+    u8* field_storage() { return reinterpret_cast<u8*>(this + 1); };
+
+    template<typename T>
+    T& field_at(u32 offset) { return *reinterpret_cast<T*>(field_storage() + offset); };
+
+private:
+    static constexpr FlatPtr forwarded_bit = 1;
+
+    Class* m_class;
+};
+
+// An array's elements immediately follow its length, packed according to the array's component type.
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-2.html#jvms-2.4
+class ArrayObject : public Object {
+public:
+    ArrayObject(Class& klass, i32 length)
+        : Object(klass)
+        , m_length(length)
+    {
+    }
+
+    i32 length() const { return m_length; };
+
+    // Keeps 8-byte elements aligned
+    u8* element_storage() { return reinterpret_cast<u8*>(this) + elements_offset; };
+
+    template<typename T>
+    T& element_at(i32 index) { return reinterpret_cast<T*>(element_storage())[index]; };
+
+    bool is_index_in_bounds(i32 index) const { return index >= 0 && index < m_length; };
+
+    // Compiled code loads the length and the elements from these offsets, see JIT::BaselineCompiler
+    static constexpr size_t length_offset = sizeof(Object);
+    static constexpr size_t elements_offset = (sizeof(Object) + sizeof(i32) + 7) & ~static_cast<size_t>(7);
+
+private:
+    i32 m_length;
+};
+
+}
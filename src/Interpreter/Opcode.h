@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/StringView.h>
+#include <AK/Types.h>
+
+namespace Interpreter {
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-7.html
+//
+// Every opcode, in numeric order: O(name, mnemonic, value, length)
+// The length includes the opcode itself, it is 0 for instructions with a variable length (tableswitch, lookupswitch and wide).
+#define ENUMERATE_OPCODES(O)                     \
+    O(Nop, nop, 0x00, 1)                         \
+    O(AconstNull, aconst_null, 0x01, 1)          \
+    O(IconstM1, iconst_m1, 0x02, 1)              \
+    O(Iconst0, iconst_0, 0x03, 1)                \
+    O(Iconst1, iconst_1, 0x04, 1)                \
+    O(Iconst2, iconst_2, 0x05, 1)                \
+    O(Iconst3, iconst_3, 0x06, 1)                \
+    O(Iconst4, iconst_4, 0x07, 1)                \
+    O(Iconst5, iconst_5, 0x08, 1)                \
+    O(Lconst0, lconst_0, 0x09, 1)                \
+    O(Lconst1, lconst_1, 0x0A, 1)                \
+    O(Fconst0, fconst_0, 0x0B, 1)                \
+    O(Fconst1, fconst_1, 0x0C, 1)                \
+    O(Fconst2, fconst_2, 0x0D, 1)                \
+    O(Dconst0, dconst_0, 0x0E, 1)                \
+    O(Dconst1, dconst_1, 0x0F, 1)                \
+    O(Bipush, bipush, 0x10, 2)                   \
+    O(Sipush, sipush, 0x11, 3)                   \
+    O(Ldc, ldc, 0x12, 2)                         \
+    O(LdcW, ldc_w, 0x13, 3)                      \
+    O(Ldc2W, ldc2_w, 0x14, 3)                    \
+    O(Iload, iload, 0x15, 2)                     \
+    O(Lload, lload, 0x16, 2)                     \
+    O(Fload, fload, 0x17, 2)                     \
+    O(Dload, dload, 0x18, 2)                     \
+    O(Aload, aload, 0x19, 2)                     \
+    O(Iload0, iload_0, 0x1A, 1)                  \
+    O(Iload1, iload_1, 0x1B, 1)                  \
+    O(Iload2, iload_2, 0x1C, 1)                  \
+    O(Iload3, iload_3, 0x1D, 1)                  \
+    O(Lload0, lload_0, 0x1E, 1)                  \
+    O(Lload1, lload_1, 0x1F, 1)                  \
+    O(Lload2, lload_2, 0x20, 1)                  \
+    O(Lload3, lload_3, 0x21, 1)                  \
+    O(Fload0, fload_0, 0x22, 1)                  \
+    O(Fload1, fload_1, 0x23, 1)                  \
+    O(Fload2, fload_2, 0x24, 1)                  \
+    O(Fload3, fload_3, 0x25, 1)                  \
+    O(Dload0, dload_0, 0x26, 1)                  \
+    O(Dload1, dload_1, 0x27, 1)                  \
+    O(Dload2, dload_2, 0x28, 1)                  \
+    O(Dload3, dload_3, 0x29, 1)                  \
+    O(Aload0, aload_0, 0x2A, 1)                  \
+    O(Aload1, aload_1, 0x2B, 1)                  \
+    O(Aload2, aload_2, 0x2C, 1)                  \
+    O(Aload3, aload_3, 0x2D, 1)                  \
+    O(Iaload, iaload, 0x2E, 1)                   \
+    O(Laload, laload, 0x2F, 1)                   \
+    O(Faload, faload, 0x30, 1)                   \
+    O(Daload, daload, 0x31, 1)                   \
+    O(Aaload, aaload, 0x32, 1)                   \
+    O(Baload, baload, 0x33, 1)                   \
+    O(Caload, caload, 0x34, 1)                   \
+    O(Saload, saload, 0x35, 1)                   \
+    O(Istore, istore, 0x36, 2)                   \
+    O(Lstore, lstore, 0x37, 2)                   \
+    O(Fstore, fstore, 0x38, 2)                   \
+    O(Dstore, dstore, 0x39, 2)                   \
+    O(Astore, astore, 0x3A, 2)                   \
+    O(Istore0, istore_0, 0x3B, 1)                \
+    O(Istore1, istore_1, 0x3C, 1)                \
+    O(Istore2, istore_2, 0x3D, 1)                \
+    O(Istore3, istore_3, 0x3E, 1)                \
+    O(Lstore0, lstore_0, 0x3F, 1)                \
+    O(Lstore1, lstore_1, 0x40, 1)                \
+    O(Lstore2, lstore_2, 0x41, 1)                \
+    O(Lstore3, lstore_3, 0x42, 1)                \
+    O(Fstore0, fstore_0, 0x43, 1)                \
+    O(Fstore1, fstore_1, 0x44, 1)                \
+    O(Fstore2, fstore_2, 0x45, 1)                \
+    O(Fstore3, fstore_3, 0x46, 1)                \
+    O(Dstore0, dstore_0, 0x47, 1)                \
+    O(Dstore1, dstore_1, 0x48, 1)                \
+    O(Dstore2, dstore_2, 0x49, 1)                \
+    O(Dstore3, dstore_3, 0x4A, 1)                \
+    O(Astore0, astore_0, 0x4B, 1)                \
+    O(Astore1, astore_1, 0x4C, 1)                \
+    O(Astore2, astore_2, 0x4D, 1)                \
+    O(Astore3, astore_3, 0x4E, 1)                \
+    O(Iastore, iastore, 0x4F, 1)                 \
+    O(Lastore, lastore, 0x50, 1)                 \
+    O(Fastore, fastore, 0x51, 1)                 \
+    O(Dastore, dastore, 0x52, 1)                 \
+    O(Aastore, aastore, 0x53, 1)                 \
+    O(Bastore, bastore, 0x54, 1)                 \
+    O(Castore, castore, 0x55, 1)                 \
+    O(Sastore, sastore, 0x56, 1)                 \
+    O(Pop, pop, 0x57, 1)                         \
+    O(Pop2, pop2, 0x58, 1)                       \
+    O(Dup, dup, 0x59, 1)                         \
+    O(DupX1, dup_x1, 0x5A, 1)                    \
+    O(DupX2, dup_x2, 0x5B, 1)                    \
+    O(Dup2, dup2, 0x5C, 1)                       \
+    O(Dup2X1, dup2_x1, 0x5D, 1)                  \
+    O(Dup2X2, dup2_x2, 0x5E, 1)                  \
+    O(Swap, swap, 0x5F, 1)                       \
+    O(Iadd, iadd, 0x60, 1)                       \
+    O(Ladd, ladd, 0x61, 1)                       \
+    O(Fadd, fadd, 0x62, 1)                       \
+    O(Dadd, dadd, 0x63, 1)                       \
+    O(Isub, isub, 0x64, 1)                       \
+    O(Lsub, lsub, 0x65, 1)                       \
+    O(Fsub, fsub, 0x66, 1)                       \
+    O(Dsub, dsub, 0x67, 1)                       \
+    O(Imul, imul, 0x68, 1)                       \
+    O(Lmul, lmul, 0x69, 1)                       \
+    O(Fmul, fmul, 0x6A, 1)                       \
+    O(Dmul, dmul, 0x6B, 1)                       \
+    O(Idiv, idiv, 0x6C, 1)                       \
+    O(Ldiv, ldiv, 0x6D, 1)                       \
+    O(Fdiv, fdiv, 0x6E, 1)                       \
+    O(Ddiv, ddiv, 0x6F, 1)                       \
+    O(Irem, irem, 0x70, 1)                       \
+    O(Lrem, lrem, 0x71, 1)                       \
+    O(Frem, frem, 0x72, 1)                       \
+    O(Drem, drem, 0x73, 1)                       \
+    O(Ineg, ineg, 0x74, 1)                       \
+    O(Lneg, lneg, 0x75, 1)                       \
+    O(Fneg, fneg, 0x76, 1)                       \
+    O(Dneg, dneg, 0x77, 1)                       \
+    O(Ishl, ishl, 0x78, 1)                       \
+    O(Lshl, lshl, 0x79, 1)                       \
+    O(Ishr, ishr, 0x7A, 1)                       \
+    O(Lshr, lshr, 0x7B, 1)                       \
+    O(Iushr, iushr, 0x7C, 1)                     \
+    O(Lushr, lushr, 0x7D, 1)                     \
+    O(Iand, iand, 0x7E, 1)                       \
+    O(Land, land, 0x7F, 1)                       \
+    O(Ior, ior, 0x80, 1)                         \
+    O(Lor, lor, 0x81, 1)                         \
+    O(Ixor, ixor, 0x82, 1)                       \
+    O(Lxor, lxor, 0x83, 1)                       \
+    O(Iinc, iinc, 0x84, 3)                       \
+    O(I2l, i2l, 0x85, 1)                         \
+    O(I2f, i2f, 0x86, 1)                         \
+    O(I2d, i2d, 0x87, 1)                         \
+    O(L2i, l2i, 0x88, 1)                         \
+    O(L2f, l2f, 0x89, 1)                         \
+    O(L2d, l2d, 0x8A, 1)                         \
+    O(F2i, f2i, 0x8B, 1)                         \
+    O(F2l, f2l, 0x8C, 1)                         \
+    O(F2d, f2d, 0x8D, 1)                         \
+    O(D2i, d2i, 0x8E, 1)                         \
+    O(D2l, d2l, 0x8F, 1)                         \
+    O(D2f, d2f, 0x90, 1)                         \
+    O(I2b, i2b, 0x91, 1)                         \
+    O(I2c, i2c, 0x92, 1)                         \
+    O(I2s, i2s, 0x93, 1)                         \
+    O(Lcmp, lcmp, 0x94, 1)                       \
+    O(Fcmpl, fcmpl, 0x95, 1)                     \
+    O(Fcmpg, fcmpg, 0x96, 1)                     \
+    O(Dcmpl, dcmpl, 0x97, 1)                     \
+    O(Dcmpg, dcmpg, 0x98, 1)                     \
+    O(Ifeq, ifeq, 0x99, 3)                       \
+    O(Ifne, ifne, 0x9A, 3)                       \
+    O(Iflt, iflt, 0x9B, 3)                       \
+    O(Ifge, ifge, 0x9C, 3)                       \
+    O(Ifgt, ifgt, 0x9D, 3)                       \
+    O(Ifle, ifle, 0x9E, 3)                       \
+    O(IfIcmpeq, if_icmpeq, 0x9F, 3)              \
+    O(IfIcmpne, if_icmpne, 0xA0, 3)              \
+    O(IfIcmplt, if_icmplt, 0xA1, 3)              \
+    O(IfIcmpge, if_icmpge, 0xA2, 3)              \
+    O(IfIcmpgt, if_icmpgt, 0xA3, 3)              \
+    O(IfIcmple, if_icmple, 0xA4, 3)              \
+    O(IfAcmpeq, if_acmpeq, 0xA5, 3)              \
+    O(IfAcmpne, if_acmpne, 0xA6, 3)              \
+    O(Goto, goto, 0xA7, 3)                       \
+    O(Jsr, jsr, 0xA8, 3)                         \
+    O(Ret, ret, 0xA9, 2)                         \
+    O(Tableswitch, tableswitch, 0xAA, 0)         \
+    O(Lookupswitch, lookupswitch, 0xAB, 0)       \
+    O(Ireturn, ireturn, 0xAC, 1)                 \
+    O(Lreturn, lreturn, 0xAD, 1)                 \
+    O(Freturn, freturn, 0xAE, 1)                 \
+    O(Dreturn, dreturn, 0xAF, 1)                 \
+    O(Areturn, areturn, 0xB0, 1)                 \
+    O(Return, return, 0xB1, 1)                   \
+    O(Getstatic, getstatic, 0xB2, 3)             \
+    O(Putstatic, putstatic, 0xB3, 3)             \
+    O(Getfield, getfield, 0xB4, 3)               \
+    O(Putfield, putfield, 0xB5, 3)               \
+    O(Invokevirtual, invokevirtual, 0xB6, 3)     \
+    O(Invokespecial, invokespecial, 0xB7, 3)     \
+    O(Invokestatic, invokestatic, 0xB8, 3)       \
+    O(Invokeinterface, invokeinterface, 0xB9, 5) \
+    O(Invokedynamic, invokedynamic, 0xBA, 5)     \
+    O(New, new, 0xBB, 3)                         \
+    O(Newarray, newarray, 0xBC, 2)               \
+    O(Anewarray, anewarray, 0xBD, 3)             \
+    O(Arraylength, arraylength, 0xBE, 1)         \
+    O(Athrow, athrow, 0xBF, 1)                   \
+    O(Checkcast, checkcast, 0xC0, 3)             \
+    O(Instanceof, instanceof, 0xC1, 3)           \
+    O(Monitorenter, monitorenter, 0xC2, 1)       \
+    O(Monitorexit, monitorexit, 0xC3, 1)         \
+    O(Wide, wide, 0xC4, 0)                       \
+    O(Multianewarray, multianewarray, 0xC5, 4)   \
+    O(Ifnull, ifnull, 0xC6, 3)                   \
+    O(Ifnonnull, ifnonnull, 0xC7, 3)             \
+    O(GotoW, goto_w, 0xC8, 5)                    \
+    O(JsrW, jsr_w, 0xC9, 5)
+
+// The "quick" forms of instructions which refer to the run-time constant pool, O(name, mnemonic, value, length)
+//
+// These never appear in a class file, the interpreter rewrites an instruction in its InstructionStream to its quick form
+// once the instruction's symbolic reference has been resolved, see Interpreter.cpp.
+// They use the values after the last opcode, which are reserved by the JVM specification (e.g. breakpoint, impdep1 and impdep2).
+// The length is that of the instruction which was quickened.
+// getfield and putfield have a quick form for each way that an instance field can be stored, see Class::lay_out_instance_fields().
+#define ENUMERATE_QUICK_OPCODES(O)                               \
+    O(LdcQuick, ldc_quick, 0xCA, 2)                              \
+    O(Ldc2WQuick, ldc2_w_quick, 0xCB, 3)                         \
+    O(GetstaticQuick, getstatic_quick, 0xCC, 3)                  \
+    O(Getstatic2Quick, getstatic2_quick, 0xCD, 3)                \
+    O(PutstaticQuick, putstatic_quick, 0xCE, 3)                  \
+    O(Putstatic2Quick, putstatic2_quick, 0xCF, 3)                \
+    O(GetfieldByteQuick, getfield_byte_quick, 0xD0, 3)           \
+    O(GetfieldCharQuick, getfield_char_quick, 0xD1, 3)           \
+    O(GetfieldShortQuick, getfield_short_quick, 0xD2, 3)         \
+    O(GetfieldIntQuick, getfield_int_quick, 0xD3, 3)             \
+    O(GetfieldLongQuick, getfield_long_quick, 0xD4, 3)           \
+    O(GetfieldReferenceQuick, getfield_reference_quick, 0xD5, 3) \
+    O(PutfieldBooleanQuick, putfield_boolean_quick, 0xD6, 3)     \
+    O(PutfieldByteQuick, putfield_byte_quick, 0xD7, 3)           \
+    O(PutfieldShortQuick, putfield_short_quick, 0xD8, 3)         \
+    O(PutfieldIntQuick, putfield_int_quick, 0xD9, 3)             \
+    O(PutfieldLongQuick, putfield_long_quick, 0xDA, 3)           \
+    O(PutfieldReferenceQuick, putfield_reference_quick, 0xDB, 3) \
+    O(InvokevirtualQuick, invokevirtual_quick, 0xDC, 3)          \
+    O(InvokenonvirtualQuick, invokenonvirtual_quick, 0xDD, 3)    \
+    O(InvokestaticQuick, invokestatic_quick, 0xDE, 3)            \
+    O(InvokeinterfaceQuick, invokeinterface_quick, 0xDF, 5)      \
+    O(NewQuick, new_quick, 0xE0, 3)                              \
+    O(AnewarrayQuick, anewarray_quick, 0xE1, 3)                  \
+    O(MultianewarrayQuick, multianewarray_quick, 0xE2, 4)        \
+    O(CheckcastQuick, checkcast_quick, 0xE3, 3)                  \
+    O(InstanceofQuick, instanceof_quick, 0xE4, 3)                \
+    O(InvokedynamicQuick, invokedynamic_quick, 0xE5, 5)
+
+enum class Opcode : u8 {
+#define __ENUMERATE_OPCODE(name, mnemonic, value, length) name = value,
+    ENUMERATE_OPCODES(__ENUMERATE_OPCODE)
+    ENUMERATE_QUICK_OPCODES(__ENUMERATE_OPCODE)
+#undef __ENUMERATE_OPCODE
+};
+
+// The opcodes are contiguous, anything at or above this value is reserved (e.g. breakpoint, impdep1 and impdep2)
+#define __ENUMERATE_OPCODE(name, mnemonic, value, length) +1
+static constexpr size_t opcode_count = 0 ENUMERATE_OPCODES(__ENUMERATE_OPCODE);
+
+// The quick opcodes follow on from the last opcode, so every opcode in an InstructionStream is below `opcode_count + quick_opcode_count`
+static constexpr size_t quick_opcode_count = 0 ENUMERATE_QUICK_OPCODES(__ENUMERATE_OPCODE);
+#undef __ENUMERATE_OPCODE
+
+// The length of an instruction in bytes, including its opcode, or 0 if it has a variable length
+constexpr u8 opcode_length(Opcode opcode)
+{
+    switch (opcode) {
+#define __ENUMERATE_OPCODE(name, mnemonic, value, length) \
+    case Opcode::name:                                    \
+        return length;
+        ENUMERATE_OPCODES(__ENUMERATE_OPCODE)
+        ENUMERATE_QUICK_OPCODES(__ENUMERATE_OPCODE)
+#undef __ENUMERATE_OPCODE
+    }
+
+    return 0;
+}
+
+// The mnemonic for an opcode, as used by the JVM specification, e.g. `invokevirtual`
+constexpr StringView opcode_name(Opcode opcode)
+{
+    switch (opcode) {
+#define __ENUMERATE_OPCODE(name, mnemonic, value, length) \
+    case Opcode::name:                                    \
+        return #mnemonic##sv;
+        ENUMERATE_OPCODES(__ENUMERATE_OPCODE)
+        ENUMERATE_QUICK_OPCODES(__ENUMERATE_OPCODE)
+#undef __ENUMERATE_OPCODE
+    }
+
+    return "<reserved>"sv;
+}
+
+}
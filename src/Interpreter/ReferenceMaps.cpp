@@ -0,0 +1,1018 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "ReferenceMaps.h"
+#include "Class.h"
+#include "InstructionStream.h"
+#include <AK/HashMap.h>
+#include <AK/NumericLimits.h>
+#include <AK/Optional.h>
+
+namespace Interpreter {
+
+// What a local variable or operand stack slot holds, as far as the garbage collector is concerned.
+// A return address (pushed by jsr) also remembers which subroutine it returns from, so that the analysis knows where a ret can go.
+using SlotKind = u8;
+static constexpr SlotKind non_reference = 0;
+static constexpr SlotKind reference = 1;
+static constexpr SlotKind first_return_address = 2;
+static constexpr size_t max_subroutine_count = NumericLimits<SlotKind>::max() - first_return_address + 1;
+
+static SlotKind kind_for_descriptor(char descriptor)
+{
+    return descriptor == FieldDescriptor::ReferenceStart || descriptor == FieldDescriptor::ArrayDimension ? reference : non_reference;
+}
+
+bool ReferenceMaps::is_safepoint(Opcode opcode)
+{
+    switch (opcode) {
+    // String constants are interned (and allocated) the first time that they're loaded
+    case Opcode::Ldc:
+    case Opcode::LdcW:
+    // These initialize the class that they refer to, which runs its static initializer
+    case Opcode::Getstatic:
+    case Opcode::Putstatic:
+    case Opcode::New:
+    case Opcode::Invokestatic:
+    case Opcode::Invokevirtual:
+    case Opcode::Invokespecial:
+    case Opcode::Invokeinterface:
+    case Opcode::Invokedynamic:
+    case Opcode::Newarray:
+    case Opcode::Anewarray:
+    case Opcode::Multianewarray:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The number of slots that an instruction pops off of the operand stack and pushes onto it, for every instruction which only ever pushes non-references
+struct StackEffect {
+    u8 pops { 0 };
+    u8 pushes { 0 };
+};
+
+static Optional<StackEffect> non_reference_stack_effect(Opcode opcode)
+{
+    switch (opcode) {
+    case Opcode::Nop:
+        return StackEffect { 0, 0 };
+
+    case Opcode::IconstM1:
+    case Opcode::Iconst0:
+    case Opcode::Iconst1:
+    case Opcode::Iconst2:
+    case Opcode::Iconst3:
+    case Opcode::Iconst4:
+    case Opcode::Iconst5:
+    case Opcode::Fconst0:
+    case Opcode::Fconst1:
+    case Opcode::Fconst2:
+    case Opcode::Bipush:
+    case Opcode::Sipush:
+        return StackEffect { 0, 1 };
+
+    case Opcode::Lconst0:
+    case Opcode::Lconst1:
+    case Opcode::Dconst0:
+    case Opcode::Dconst1:
+        return StackEffect { 0, 2 };
+
+    case Opcode::Ineg:
+    case Opcode::Fneg:
+    case Opcode::I2f:
+    case Opcode::F2i:
+    case Opcode::I2b:
+    case Opcode::I2c:
+    case Opcode::I2s:
+    case Opcode::Arraylength:
+    case Opcode::Instanceof:
+        return StackEffect { 1, 1 };
+
+    case Opcode::I2l:
+    case Opcode::I2d:
+    case Opcode::F2l:
+    case Opcode::F2d:
+        return StackEffect { 1, 2 };
+
+    case Opcode::Iaload:
+    case Opcode::Faload:
+    case Opcode::Baload:
+    case Opcode::Caload:
+    case Opcode::Saload:
+    case Opcode::Iadd:
+    case Opcode::Fadd:
+    case Opcode::Isub:
+    case Opcode::Fsub:
+    case Opcode::Imul:
+    case Opcode::Fmul:
+    case Opcode::Idiv:
+    case Opcode::Fdiv:
+    case Opcode::Irem:
+    case Opcode::Frem:
+    case Opcode::Ishl:
+    case Opcode::Ishr:
+    case Opcode::Iushr:
+    case Opcode::Iand:
+    case Opcode::Ior:
+    case Opcode::Ixor:
+    case Opcode::Fcmpl:
+    case Opcode::Fcmpg:
+    case Opcode::L2i:
+    case Opcode::L2f:
+    case Opcode::D2i:
+    case Opcode::D2f:
+        return StackEffect { 2, 1 };
+
+    case Opcode::Laload:
+    case Opcode::Daload:
+    case Opcode::Lneg:
+    case Opcode::Dneg:
+    case Opcode::L2d:
+    case Opcode::D2l:
+        return StackEffect { 2, 2 };
+
+    case Opcode::Lshl:
+    case Opcode::Lshr:
+    case Opcode::Lushr:
+        return StackEffect { 3, 2 };
+
+    case Opcode::Ladd:
+    case Opcode::Dadd:
+    case Opcode::Lsub:
+    case Opcode::Dsub:
+    case Opcode::Lmul:
+    case Opcode::Dmul:
+    case Opcode::Ldiv:
+    case Opcode::Ddiv:
+    case Opcode::Lrem:
+    case Opcode::Drem:
+    case Opcode::Land:
+    case Opcode::Lor:
+    case Opcode::Lxor:
+        return StackEffect { 4, 2 };
+
+    case Opcode::Lcmp:
+    case Opcode::Dcmpl:
+    case Opcode::Dcmpg:
+        return StackEffect { 4, 1 };
+
+    case Opcode::Pop:
+    case Opcode::Monitorenter:
+    case Opcode::Monitorexit:
+        return StackEffect { 1, 0 };
+
+    case Opcode::Pop2:
+        return StackEffect { 2, 0 };
+
+    case Opcode::Iastore:
+    case Opcode::Fastore:
+    case Opcode::Aastore:
+    case Opcode::Bastore:
+    case Opcode::Castore:
+    case Opcode::Sastore:
+        return StackEffect { 3, 0 };
+
+    case Opcode::Lastore:
+    case Opcode::Dastore:
+        return StackEffect { 4, 0 };
+
+    default:
+        return {};
+    }
+}
+
+namespace {
+
+// A subroutine is the code that a jsr jumps to, which returns with ret. Class files before version 51.0 use them for `finally` blocks.
+struct Subroutine {
+    u32 entry { 0 };
+
+    // The jsr instructions which call this subroutine, execution continues after one of them when the subroutine returns
+    Vector<u32> callers;
+
+    // The subroutines that this subroutine calls
+    Vector<size_t> callees;
+
+    // The local variables that this subroutine (or a subroutine that it calls) stores to.
+    // Every other local variable is the same when the subroutine returns as it was at the jsr which called it.
+    Vector<bool> stored_locals;
+
+    // Every ret that returns from this subroutine, merged. The depth is empty until a ret has been reached.
+    Vector<SlotKind> return_state;
+    Optional<u32> return_depth;
+};
+
+// Abstract interpretation of a method's instructions, until the state at every reachable instruction stops changing
+class Analysis {
+public:
+    Analysis(Method& method, ReadonlySpan<Instruction> instructions, ReadonlySpan<ExceptionHandler> exception_handlers)
+        : m_method(method)
+        , m_instructions(instructions)
+        , m_exception_handlers(exception_handlers)
+        , m_max_locals(method.code()->max_locals())
+        , m_max_stack(method.code()->max_stack())
+        , m_frame_size(m_max_locals + m_max_stack)
+    {
+    }
+
+    ErrorOr<void> run();
+
+    // The state before the instruction has executed, or null if the instruction can't be reached
+    SlotKind const* state_at(u32 index) const { return m_depths[index].has_value() ? m_states.data() + index * m_frame_size : nullptr; };
+    u32 depth_at(u32 index) const { return *m_depths[index]; };
+
+private:
+    ErrorOr<void> find_subroutines();
+    ErrorOr<void> step(u32 index);
+
+    // Merges the current state into the state before the instruction, it's analysed again if that changed anything
+    ErrorOr<void> merge_into(u32 index);
+
+    // Merges the state before the instruction into each exception handler that covers it
+    ErrorOr<void> merge_into_handlers(u32 index);
+
+    // Merges the state after a subroutine returns into the instruction after a jsr which called it
+    ErrorOr<void> merge_return_into_caller(Subroutine const& subroutine, u32 caller);
+
+    ErrorOr<void> check_local(u32 index, u32 slot_count);
+    ErrorOr<void> push(SlotKind kind);
+    ErrorOr<void> push_non_references(u32 count);
+    ErrorOr<void> push_descriptor(char descriptor);
+    ErrorOr<SlotKind> pop();
+    ErrorOr<void> pop(u32 count);
+
+    Error verify_error(StringView reason) const;
+
+    Method& m_method;
+    ReadonlySpan<Instruction> m_instructions;
+    ReadonlySpan<ExceptionHandler> m_exception_handlers;
+    u32 m_max_locals;
+    u32 m_max_stack;
+    u32 m_frame_size;
+
+    // The state before each instruction: its local variables followed by its operand stack, and the operand stack's depth
+    Vector<SlotKind> m_states;
+    Vector<Optional<u32>> m_depths;
+
+    Vector<u32> m_worklist;
+    Vector<bool> m_is_in_worklist;
+
+    // The state of the instruction that is being analysed
+    u32 m_index { 0 };
+    Vector<SlotKind> m_state;
+    u32 m_depth { 0 };
+
+    Vector<Subroutine> m_subroutines;
+    HashMap<u32, size_t> m_subroutine_at_entry;
+};
+
+Error Analysis::verify_error(StringView reason) const
+{
+    dbgln("ReferenceMaps: {} at instruction {} of {}.{}{}", reason, m_index, m_method.owner().name(), m_method.name(), m_method.descriptor());
+    return Error::from_string_literal("java/lang/VerifyError");
+}
+
+ErrorOr<void> Analysis::run()
+{
+    TRY(m_states.try_resize(m_instructions.size() * m_frame_size));
+    TRY(m_depths.try_resize(m_instructions.size()));
+    TRY(m_is_in_worklist.try_resize(m_instructions.size()));
+    TRY(m_state.try_resize(m_frame_size));
+
+    TRY(find_subroutines());
+
+    // The arguments are the first local variables, every other local variable is unusable until it has been stored to
+    if (m_method.argument_slots() > m_max_locals)
+        return verify_error("The arguments don't fit in the local variables"sv);
+
+    u32 slot = 0;
+    if (!m_method.is_static())
+        m_state[slot++] = reference;
+
+    TRY(for_each_parameter_type(m_method.descriptor().view(), [&](char type) {
+        m_state[slot] = kind_for_descriptor(type);
+        slot += type == FieldDescriptor::ArrayDimension ? 1 : slot_count_for_descriptor(type);
+    }));
+
+    TRY(merge_into(0));
+
+    while (!m_worklist.is_empty()) {
+        auto index = m_worklist.take_last();
+        m_is_in_worklist[index] = false;
+
+        auto const* state = state_at(index);
+        for (u32 i = 0; i < m_frame_size; i++)
+            m_state[i] = state[i];
+        m_depth = depth_at(index);
+
+        m_index = index;
+        TRY(merge_into_handlers(index));
+        TRY(step(index));
+    }
+
+    return {};
+}
+
+ErrorOr<void> Analysis::find_subroutines()
+{
+    for (u32 index = 0; index < m_instructions.size(); index++) {
+        auto const& instruction = m_instructions[index];
+        if (instruction.opcode != Opcode::Jsr && instruction.opcode != Opcode::JsrW)
+            continue;
+
+        auto entry = static_cast<u32>(instruction.operand);
+        auto subroutine_index = m_subroutine_at_entry.get(entry);
+        if (!subroutine_index.has_value()) {
+            if (m_subroutines.size() == max_subroutine_count)
+                return verify_error("Too many subroutines"sv);
+
+            subroutine_index = m_subroutines.size();
+            TRY(m_subroutine_at_entry.try_set(entry, *subroutine_index));
+
+            Subroutine subroutine;
+            subroutine.entry = entry;
+            TRY(subroutine.stored_locals.try_resize(m_max_locals));
+            TRY(subroutine.return_state.try_resize(m_frame_size));
+            TRY(m_subroutines.try_append(move(subroutine)));
+        }
+
+        TRY(m_subroutines[*subroutine_index].callers.try_append(index));
+    }
+
+    // Find the local variables that each subroutine stores to, by following its control flow up to each ret.
+    // Calls to other subroutines are skipped over, and their stores are added afterwards.
+    Vector<bool> is_visited;
+    TRY(is_visited.try_resize(m_instructions.size()));
+    Vector<u32> pending;
+
+    for (auto& subroutine : m_subroutines) {
+        is_visited.span().fill(false);
+        TRY(pending.try_append(subroutine.entry));
+
+        auto mark_stored = [&](u32 local, u32 slot_count) {
+            for (u32 i = local; i < local + slot_count && i < m_max_locals; i++)
+                subroutine.stored_locals[i] = true;
+        };
+
+        while (!pending.is_empty()) {
+            auto index = pending.take_last();
+            if (is_visited[index])
+                continue;
+
+            is_visited[index] = true;
+            auto const& instruction = m_instructions[index];
+
+            switch (instruction.opcode) {
+            case Opcode::Istore:
+            case Opcode::Fstore:
+            case Opcode::Astore:
+            case Opcode::Istore0:
+            case Opcode::Istore1:
+            case Opcode::Istore2:
+            case Opcode::Istore3:
+            case Opcode::Fstore0:
+            case Opcode::Fstore1:
+            case Opcode::Fstore2:
+            case Opcode::Fstore3:
+            case Opcode::Astore0:
+            case Opcode::Astore1:
+            case Opcode::Astore2:
+            case Opcode::Astore3:
+            case Opcode::Iinc:
+                mark_stored(instruction.index, 1);
+                break;
+
+            case Opcode::Lstore:
+            case Opcode::Dstore:
+            case Opcode::Lstore0:
+            case Opcode::Lstore1:
+            case Opcode::Lstore2:
+            case Opcode::Lstore3:
+            case Opcode::Dstore0:
+            case Opcode::Dstore1:
+            case Opcode::Dstore2:
+            case Opcode::Dstore3:
+                mark_stored(instruction.index, 2);
+                break;
+
+            default:
+                break;
+            }
+
+            switch (instruction.opcode) {
+            case Opcode::Jsr:
+            case Opcode::JsrW:
+                TRY(subroutine.callees.try_append(*m_subroutine_at_entry.get(instruction.operand)));
+                TRY(pending.try_append(index + 1));
+                break;
+
+            case Opcode::Goto:
+            case Opcode::GotoW:
+                TRY(pending.try_append(instruction.operand));
+                break;
+
+            case Opcode::Ifeq:
+            case Opcode::Ifne:
+            case Opcode::Iflt:
+            case Opcode::Ifge:
+            case Opcode::Ifgt:
+            case Opcode::Ifle:
+            case Opcode::IfIcmpeq:
+            case Opcode::IfIcmpne:
+            case Opcode::IfIcmplt:
+            case Opcode::IfIcmpge:
+            case Opcode::IfIcmpgt:
+            case Opcode::IfIcmple:
+            case Opcode::IfAcmpeq:
+            case Opcode::IfAcmpne:
+            case Opcode::Ifnull:
+            case Opcode::Ifnonnull:
+                TRY(pending.try_append(instruction.operand));
+                TRY(pending.try_append(index + 1));
+                break;
+
+            case Opcode::Tableswitch:
+            case Opcode::Lookupswitch:
+                TRY(pending.try_append(instruction.switch_table->default_target));
+                TRY(pending.try_extend(instruction.switch_table->targets));
+                break;
+
+            case Opcode::Ret:
+            case Opcode::Ireturn:
+            case Opcode::Lreturn:
+            case Opcode::Freturn:
+            case Opcode::Dreturn:
+            case Opcode::Areturn:
+            case Opcode::Return:
+            case Opcode::Athrow:
+                break;
+
+            default:
+                TRY(pending.try_append(index + 1));
+                break;
+            }
+        }
+    }
+
+    // A subroutine also stores to everything that the subroutines it calls store to
+    for (auto changed = true; changed;) {
+        changed = false;
+        for (auto& subroutine : m_subroutines) {
+            for (auto callee : subroutine.callees) {
+                for (u32 local = 0; local < m_max_locals; local++) {
+                    if (m_subroutines[callee].stored_locals[local] && !subroutine.stored_locals[local]) {
+                        subroutine.stored_locals[local] = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    return {};
+}
+
+ErrorOr<void> Analysis::merge_into(u32 index)
+{
+    auto* state = m_states.data() + index * m_frame_size;
+    auto& depth = m_depths[index];
+
+    auto changed = false;
+    if (!depth.has_value()) {
+        for (u32 i = 0; i < m_max_locals + m_depth; i++)
+            state[i] = m_state[i];
+
+        depth = m_depth;
+        changed = true;
+    } else {
+        if (*depth != m_depth)
+            return verify_error("The operand stack has a different depth on each path"sv);
+
+        for (u32 i = 0; i < m_max_locals + m_depth; i++) {
+            if (state[i] != m_state[i] && state[i] != non_reference) {
+                state[i] = non_reference;
+                changed = true;
+            }
+        }
+    }
+
+    if (changed && !m_is_in_worklist[index]) {
+        m_is_in_worklist[index] = true;
+        TRY(m_worklist.try_append(index));
+    }
+
+    return {};
+}
+
+ErrorOr<void> Analysis::merge_into_handlers(u32 index)
+{
+    // An exception is thrown before the instruction has changed any local variables, and the handler starts with only the exception on the operand stack
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-2.html#jvms-2.10
+    for (auto const& handler : m_exception_handlers) {
+        if (index < handler.start || index >= handler.end)
+            continue;
+
+        if (m_max_stack == 0)
+            return verify_error("There is no room on the operand stack for the exception"sv);
+
+        auto depth = m_depth;
+        auto top_of_stack = m_state[m_max_locals];
+
+        m_depth = 1;
+        m_state[m_max_locals] = reference;
+        TRY(merge_into(handler.handler));
+
+        m_depth = depth;
+        m_state[m_max_locals] = top_of_stack;
+    }
+
+    return {};
+}
+
+ErrorOr<void> Analysis::merge_return_into_caller(Subroutine const& subroutine, u32 caller)
+{
+    auto const* caller_state = state_at(caller);
+    if (!caller_state)
+        return {};
+
+    for (u32 local = 0; local < m_max_locals; local++)
+        m_state[local] = subroutine.stored_locals[local] ? subroutine.return_state[local] : caller_state[local];
+
+    m_depth = *subroutine.return_depth;
+    for (u32 i = m_max_locals; i < m_max_locals + m_depth; i++)
+        m_state[i] = subroutine.return_state[i];
+
+    if (caller + 1 >= m_instructions.size())
+        return verify_error("Execution can fall off the end of the code"sv);
+
+    return merge_into(caller + 1);
+}
+
+ErrorOr<void> Analysis::check_local(u32 index, u32 slot_count)
+{
+    if (index + slot_count > m_max_locals)
+        return verify_error("Local variable is out of bounds"sv);
+
+    return {};
+}
+
+ErrorOr<void> Analysis::push(SlotKind kind)
+{
+    if (m_depth == m_max_stack)
+        return verify_error("The operand stack overflows"sv);
+
+    m_state[m_max_locals + m_depth++] = kind;
+    return {};
+}
+
+ErrorOr<void> Analysis::push_non_references(u32 count)
+{
+    for (u32 i = 0; i < count; i++)
+        TRY(push(non_reference));
+
+    return {};
+}
+
+// Pushes a value of the type, e.g. the value of a field or the return value of a method
+ErrorOr<void> Analysis::push_descriptor(char descriptor)
+{
+    if (slot_count_for_descriptor(descriptor) == 2)
+        return push_non_references(2);
+
+    return push(kind_for_descriptor(descriptor));
+}
+
+ErrorOr<SlotKind> Analysis::pop()
+{
+    if (m_depth == 0)
+        return verify_error("The operand stack underflows"sv);
+
+    return m_state[m_max_locals + --m_depth];
+}
+
+ErrorOr<void> Analysis::pop(u32 count)
+{
+    if (count > m_depth)
+        return verify_error("The operand stack underflows"sv);
+
+    m_depth -= count;
+    return {};
+}
+
+ErrorOr<void> Analysis::step(u32 index)
+{
+    auto const& instruction = m_instructions[index];
+    auto const opcode = instruction.opcode;
+
+    // Most instructions continue with the next instruction, anything that doesn't returns early
+    if (auto effect = non_reference_stack_effect(opcode); effect.has_value()) {
+        TRY(pop(effect->pops));
+        TRY(push_non_references(effect->pushes));
+        return merge_into(index + 1);
+    }
+
+    switch (opcode) {
+    case Opcode::AconstNull:
+    case Opcode::New:
+        TRY(push(reference));
+        break;
+
+    case Opcode::Ldc:
+    case Opcode::LdcW:
+    case Opcode::Ldc2W: {
+        // Every loadable constant apart from numbers is an object (strings, classes, method types and method handles),
+        // and a dynamically-computed constant has the type of its field descriptor.
+        auto& constant = *instruction.reference;
+        if (constant.type() == SymbolicatedReference::Numeric)
+            TRY(push_non_references(static_cast<SymbolicatedNumericReference&>(constant).is_category_2() ? 2 : 1));
+        else if (constant.type() == SymbolicatedReference::DynamicConstant)
+            TRY(push_descriptor(static_cast<SymbolicatedDynamicReference&>(constant).descriptor().view()[0]));
+        else
+            TRY(push(reference));
+        break;
+    }
+
+    case Opcode::Iload:
+    case Opcode::Fload:
+    case Opcode::Iload0:
+    case Opcode::Iload1:
+    case Opcode::Iload2:
+    case Opcode::Iload3:
+    case Opcode::Fload0:
+    case Opcode::Fload1:
+    case Opcode::Fload2:
+    case Opcode::Fload3:
+        TRY(check_local(instruction.index, 1));
+        TRY(push(non_reference));
+        break;
+
+    case Opcode::Lload:
+    case Opcode::Dload:
+    case Opcode::Lload0:
+    case Opcode::Lload1:
+    case Opcode::Lload2:
+    case Opcode::Lload3:
+    case Opcode::Dload0:
+    case Opcode::Dload1:
+    case Opcode::Dload2:
+    case Opcode::Dload3:
+        TRY(check_local(instruction.index, 2));
+        TRY(push_non_references(2));
+        break;
+
+    case Opcode::Aload:
+    case Opcode::Aload0:
+    case Opcode::Aload1:
+    case Opcode::Aload2:
+    case Opcode::Aload3:
+        TRY(check_local(instruction.index, 1));
+        TRY(push(m_state[instruction.index]));
+        break;
+
+    case Opcode::Istore:
+    case Opcode::Fstore:
+    case Opcode::Istore0:
+    case Opcode::Istore1:
+    case Opcode::Istore2:
+    case Opcode::Istore3:
+    case Opcode::Fstore0:
+    case Opcode::Fstore1:
+    case Opcode::Fstore2:
+    case Opcode::Fstore3:
+        TRY(check_local(instruction.index, 1));
+        TRY(pop(1));
+        m_state[instruction.index] = non_reference;
+        break;
+
+    case Opcode::Lstore:
+    case Opcode::Dstore:
+    case Opcode::Lstore0:
+    case Opcode::Lstore1:
+    case Opcode::Lstore2:
+    case Opcode::Lstore3:
+    case Opcode::Dstore0:
+    case Opcode::Dstore1:
+    case Opcode::Dstore2:
+    case Opcode::Dstore3:
+        TRY(check_local(instruction.index, 2));
+        TRY(pop(2));
+        m_state[instruction.index] = non_reference;
+        m_state[instruction.index + 1] = non_reference;
+        break;
+
+    // astore can also store the return address of a subroutine
+    case Opcode::Astore:
+    case Opcode::Astore0:
+    case Opcode::Astore1:
+    case Opcode::Astore2:
+    case Opcode::Astore3:
+        TRY(check_local(instruction.index, 1));
+        m_state[instruction.index] = TRY(pop());
+        break;
+
+    case Opcode::Iinc:
+        TRY(check_local(instruction.index, 1));
+        m_state[instruction.index] = non_reference;
+        break;
+
+    case Opcode::Aaload:
+        TRY(pop(2));
+        TRY(push(reference));
+        break;
+
+    // The stack manipulation instructions copy whatever is in the slots, `value1` is the top of the stack
+    case Opcode::Dup: {
+        auto value1 = TRY(pop());
+        TRY(push(value1));
+        TRY(push(value1));
+        break;
+    }
+
+    case Opcode::DupX1: {
+        auto value1 = TRY(pop());
+        auto value2 = TRY(pop());
+        TRY(push(value1));
+        TRY(push(value2));
+        TRY(push(value1));
+        break;
+    }
+
+    case Opcode::DupX2: {
+        auto value1 = TRY(pop());
+        auto value2 = TRY(pop());
+        auto value3 = TRY(pop());
+        TRY(push(value1));
+        TRY(push(value3));
+        TRY(push(value2));
+        TRY(push(value1));
+        break;
+    }
+
+    case Opcode::Dup2: {
+        auto value1 = TRY(pop());
+        auto value2 = TRY(pop());
+        TRY(push(value2));
+        TRY(push(value1));
+        TRY(push(value2));
+        TRY(push(value1));
+        break;
+    }
+
+    case Opcode::Dup2X1: {
+        auto value1 = TRY(pop());
+        auto value2 = TRY(pop());
+        auto value3 = TRY(pop());
+        TRY(push(value2));
+        TRY(push(value1));
+        TRY(push(value3));
+        TRY(push(value2));
+        TRY(push(value1));
+        break;
+    }
+
+    case Opcode::Dup2X2: {
+        auto value1 = TRY(pop());
+        auto value2 = TRY(pop());
+        auto value3 = TRY(pop());
+        auto value4 = TRY(pop());
+        TRY(push(value2));
+        TRY(push(value1));
+        TRY(push(value4));
+        TRY(push(value3));
+        TRY(push(value2));
+        TRY(push(value1));
+        break;
+    }
+
+    case Opcode::Swap: {
+        auto value1 = TRY(pop());
+        auto value2 = TRY(pop());
+        TRY(push(value1));
+        TRY(push(value2));
+        break;
+    }
+
+    // Branches
+    case Opcode::Ifeq:
+    case Opcode::Ifne:
+    case Opcode::Iflt:
+    case Opcode::Ifge:
+    case Opcode::Ifgt:
+    case Opcode::Ifle:
+    case Opcode::Ifnull:
+    case Opcode::Ifnonnull:
+        TRY(pop(1));
+        TRY(merge_into(instruction.operand));
+        break;
+
+    case Opcode::IfIcmpeq:
+    case Opcode::IfIcmpne:
+    case Opcode::IfIcmplt:
+    case Opcode::IfIcmpge:
+    case Opcode::IfIcmpgt:
+    case Opcode::IfIcmple:
+    case Opcode::IfAcmpeq:
+    case Opcode::IfAcmpne:
+        TRY(pop(2));
+        TRY(merge_into(instruction.operand));
+        break;
+
+    case Opcode::Goto:
+    case Opcode::GotoW:
+        return merge_into(instruction.operand);
+
+    case Opcode::Tableswitch:
+    case Opcode::Lookupswitch:
+        TRY(pop(1));
+        TRY(merge_into(instruction.switch_table->default_target));
+        for (auto target : instruction.switch_table->targets)
+            TRY(merge_into(target));
+        return {};
+
+    case Opcode::Jsr:
+    case Opcode::JsrW: {
+        auto subroutine_index = *m_subroutine_at_entry.get(instruction.operand);
+        auto const& subroutine = m_subroutines[subroutine_index];
+
+        TRY(push(static_cast<SlotKind>(first_return_address + subroutine_index)));
+        TRY(merge_into(instruction.operand));
+
+        // Once the subroutine is known to return, execution also continues after this jsr
+        if (subroutine.return_depth.has_value())
+            TRY(merge_return_into_caller(subroutine, index));
+
+        return {};
+    }
+
+    case Opcode::Ret: {
+        TRY(check_local(instruction.index, 1));
+
+        auto return_address = m_state[instruction.index];
+        if (return_address < first_return_address)
+            return verify_error("ret's local variable doesn't hold a return address"sv);
+
+        auto& subroutine = m_subroutines[return_address - first_return_address];
+        auto changed = false;
+        if (!subroutine.return_depth.has_value()) {
+            for (u32 i = 0; i < m_max_locals + m_depth; i++)
+                subroutine.return_state[i] = m_state[i];
+
+            subroutine.return_depth = m_depth;
+            changed = true;
+        } else {
+            if (*subroutine.return_depth != m_depth)
+                return verify_error("The operand stack has a different depth at each ret"sv);
+
+            for (u32 i = 0; i < m_max_locals + m_depth; i++) {
+                if (subroutine.return_state[i] != m_state[i] && subroutine.return_state[i] != non_reference) {
+                    subroutine.return_state[i] = non_reference;
+                    changed = true;
+                }
+            }
+        }
+
+        if (changed) {
+            for (auto caller : subroutine.callers)
+                TRY(merge_return_into_caller(subroutine, caller));
+        }
+
+        return {};
+    }
+
+    case Opcode::Ireturn:
+    case Opcode::Freturn:
+    case Opcode::Areturn:
+    case Opcode::Athrow:
+        TRY(pop(1));
+        return {};
+
+    case Opcode::Lreturn:
+    case Opcode::Dreturn:
+        TRY(pop(2));
+        return {};
+
+    case Opcode::Return:
+        return {};
+
+    // Fields
+    case Opcode::Getstatic:
+    case Opcode::Getfield:
+    case Opcode::Putstatic:
+    case Opcode::Putfield: {
+        auto type = static_cast<SymbolicatedFieldReference&>(*instruction.reference).descriptor().view()[0];
+        if (opcode == Opcode::Putstatic || opcode == Opcode::Putfield)
+            TRY(pop(slot_count_for_descriptor(type)));
+
+        if (opcode == Opcode::Getfield || opcode == Opcode::Putfield)
+            TRY(pop(1));
+
+        if (opcode == Opcode::Getstatic || opcode == Opcode::Getfield)
+            TRY(push_descriptor(type));
+        break;
+    }
+
+    // Method invocation
+    case Opcode::Invokevirtual:
+    case Opcode::Invokespecial:
+    case Opcode::Invokestatic:
+    case Opcode::Invokeinterface:
+    case Opcode::Invokedynamic: {
+        auto descriptor = opcode == Opcode::Invokedynamic
+            ? static_cast<SymbolicatedDynamicReference&>(*instruction.reference).descriptor()
+            : static_cast<SymbolicatedMethodReference&>(*instruction.reference).descriptor();
+
+        auto descriptor_info = TRY(parse_method_descriptor(descriptor.view()));
+        auto has_receiver = opcode != Opcode::Invokestatic && opcode != Opcode::Invokedynamic;
+        TRY(pop(descriptor_info.parameter_slots + (has_receiver ? 1 : 0)));
+
+        if (descriptor_info.return_slots != 0)
+            TRY(push_descriptor(descriptor_info.return_type));
+        break;
+    }
+
+    // Objects
+    case Opcode::Newarray:
+    case Opcode::Anewarray:
+    case Opcode::Checkcast:
+        TRY(pop(1));
+        TRY(push(reference));
+        break;
+
+    case Opcode::Multianewarray:
+        TRY(pop(instruction.index));
+        TRY(push(reference));
+        break;
+
+    default:
+        // wide has been folded into the instruction that it modifies, and nothing has been quickened yet
+        dbgln("ReferenceMaps: Unexpected {} at instruction {}", opcode_name(opcode), index);
+        VERIFY_NOT_REACHED();
+    }
+
+    // Conditional branches also continue with the next instruction.
+    // The decoder has already checked that the last instruction can't continue past the end of the code.
+    return merge_into(index + 1);
+}
+
+}
+
+ErrorOr<ReferenceMaps> ReferenceMaps::compute(Method& method, ReadonlySpan<Instruction> instructions, ReadonlySpan<ExceptionHandler> exception_handlers)
+{
+    VERIFY(method.code());
+
+    Analysis analysis(method, instructions, exception_handlers);
+    TRY(analysis.run());
+
+    ReferenceMaps reference_maps;
+    TRY(reference_maps.m_stack_depths.try_ensure_capacity(instructions.size()));
+    for (u32 index = 0; index < instructions.size(); index++) {
+        auto const* state = analysis.state_at(index);
+        reference_maps.m_stack_depths.unchecked_append(state ? analysis.depth_at(index) : unreachable);
+        // The interpreter stops at the start of an exception handler while it allocates the exception
+        auto is_handler = false;
+        for (auto const& handler : exception_handlers)
+            is_handler |= handler.handler == index;
+
+        if (!state || (!is_safepoint(instructions[index].opcode) && !is_handler))
+            continue;
+
+        Map map;
+        map.instruction_index = index;
+        map.first_reference_slot = reference_maps.m_reference_slots.size();
+
+        auto slot_count = method.code()->max_locals() + analysis.depth_at(index);
+        for (u32 slot = 0; slot < slot_count; slot++) {
+            if (state[slot] == reference)
+                TRY(reference_maps.m_reference_slots.try_append(slot));
+        }
+
+        map.reference_slot_count = reference_maps.m_reference_slots.size() - map.first_reference_slot;
+        TRY(reference_maps.m_maps.try_append(map));
+    }
+
+    return reference_maps;
+}
+
+ReferenceMaps::Map const& ReferenceMaps::find(u32 instruction_index) const
+{
+    // A frame can only be stopped at an instruction which has a map, see is_safepoint()
+    size_t low = 0;
+    size_t high = m_maps.size();
+    while (low < high) {
+        auto middle = low + (high - low) / 2;
+        if (m_maps[middle].instruction_index < instruction_index)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    VERIFY(low < m_maps.size() && m_maps[low].instruction_index == instruction_index);
+    return m_maps[low];
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "Opcode.h"
+#include <AK/Error.h>
+#include <AK/NumericLimits.h>
+#include <AK/Optional.h>
+#include <AK/Span.h>
+#include <AK/Vector.h>
+
+namespace Interpreter {
+
+// Forward-declaration
+class Method;
+struct ExceptionHandler;
+struct Instruction;
+
+// Which slots of a frame hold references, at every instruction where the garbage collector can run while the frame is active.
+// These make the interpreter's stack a precise set of roots: the garbage collector never has to guess whether a slot holds a reference.
+//
+// The maps come from the same type inference that the verifier does (https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.10.2.2),
+// except that the only type that matters is whether or not a slot holds a reference.
+// A slot which holds a reference on one path and something else on another can't be used by either path once they merge, so it isn't a root.
+class ReferenceMaps {
+public:
+    // Also rejects code whose operand stack overflows or underflows, or which uses a local variable that doesn't exist.
+    // An exception handler is reached from every instruction that it covers, see InstructionStream::exception_handlers().
+    static ErrorOr<ReferenceMaps> compute(Method& method, ReadonlySpan<Instruction> instructions, ReadonlySpan<ExceptionHandler> exception_handlers);
+
+    // The garbage collector only runs when a frame is stopped at an instruction which can allocate, initialize a class, or invoke a method,
+    // or at the start of an exception handler while the exception is allocated
+    static bool is_safepoint(Opcode opcode);
+
+    // Calls the callback with the index of each slot that holds a reference when the frame is stopped at the instruction (before it has executed).
+    // Slots are numbered from the first local variable, the operand stack immediately follows the local variables.
+    template<typename Callback>
+    void for_each_reference_slot(u32 instruction_index, Callback callback) const
+    {
+        auto const& map = find(instruction_index);
+        for (u32 i = 0; i < map.reference_slot_count; i++)
+            callback(m_reference_slots[map.first_reference_slot + i]);
+    }
+
+    // The number of instructions with a map, instructions that are never reached don't have one
+    size_t size() const { return m_maps.size(); };
+
+    // The depth of the operand stack before the instruction has executed, which is the same on every path that reaches it.
+    // The baseline JIT addresses the operand stack with it, and the interpreter uses it to carry on from where compiled code stopped.
+    Optional<u32> stack_depth(u32 instruction_index) const
+    {
+        auto depth = m_stack_depths[instruction_index];
+        if (depth == unreachable)
+            return {};
+
+        return depth;
+    }
+
+private:
+    struct Map {
+        u32 instruction_index { 0 };
+
+        // The reference slots of this map are `m_reference_slots[first_reference_slot .. first_reference_slot + reference_slot_count]`
+        u32 first_reference_slot { 0 };
+        u32 reference_slot_count { 0 };
+    };
+
+    Map const& find(u32 instruction_index) const;
+
+    // Sorted by instruction index
+    Vector<Map> m_maps;
+    Vector<u32> m_reference_slots;
+
+    // One for every instruction, including the ones that are never reached
+    static constexpr u32 unreachable = NumericLimits<u32>::max();
+    Vector<u32> m_stack_depths;
+};
+
+}
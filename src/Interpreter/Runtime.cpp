@@ -0,0 +1,651 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Runtime.h"
+#include "Natives.h"
+#include <AK/Array.h>
+#include <AK/ScopeGuard.h>
+#include <AK/String.h>
+#include <AK/QuickSort.h>
+#include <AK/NumericLimits.h>
+#include <AK/kmalloc.h>
+
+namespace Interpreter {
+
+// Returns the binary name of the CONSTANT_Class_info at the index
+static ErrorOr<Symbol> class_name_at(Parser::ConstantPool const& constant_pool, u16 index)
+{
+    auto class_info = TRY(constant_pool.class_at(index));
+    return TRY(constant_pool.utf8_at(class_info.name_index())).symbol();
+}
+
+Runtime::Runtime(Loader::ClassRegistry& registry)
+    : m_registry(registry)
+{
+}
+
+Runtime::~Runtime() = default;
+
+ErrorOr<NonnullOwnPtr<Runtime>> Runtime::create(Loader::ClassRegistry& registry, DispatchMode dispatch_mode, size_t heap_size)
+{
+    auto runtime = TRY(try_make<Runtime>(registry));
+    runtime->m_heap = TRY(Heap::create(heap_size));
+    runtime->m_interpreter = TRY(Interpreter::create(*runtime, dispatch_mode));
+    TRY(runtime->m_heap->add_allocation_buffer(runtime->m_interpreter->allocation_buffer()));
+
+    TRY(define_bootstrap_classes(*runtime));
+    return runtime;
+}
+
+ErrorOr<Class*> Runtime::resolve_class(Symbol name)
+{
+    if (auto* klass = find_class(name))
+        return klass;
+
+    // Array classes don't have a class file, they're created by the Java Virtual Machine
+    if (name.view().starts_with(FieldDescriptor::ArrayDimension))
+        return define_array_class(name);
+
+    auto* class_file = m_registry.find(name);
+    if (!class_file) {
+        dbgln("Runtime: Could not find a definition for {}", name);
+        return Error::from_string_literal("java/lang/NoClassDefFoundError");
+    }
+
+    return link_class(name, *class_file);
+}
+
+Class* Runtime::find_class(Symbol name)
+{
+    auto iterator = m_classes.find(name);
+    if (iterator == m_classes.end())
+        return nullptr;
+
+    return iterator->value.ptr();
+}
+
+ErrorOr<Class*> Runtime::define_class(Symbol name, u16 access_flags, Class* super_class)
+{
+    auto klass = TRY(try_make<Class>(name, access_flags, super_class, nullptr, nullptr));
+
+    auto* class_pointer = klass.ptr();
+    TRY(m_classes.try_set(name, move(klass)));
+
+    return class_pointer;
+}
+
+ErrorOr<Class*> Runtime::link_class(Symbol name, Parser::ClassFile const& class_file)
+{
+    // If C is its own superclass or superinterface, loading throws a ClassCircularityError
+    if (m_classes_being_linked.contains(name)) {
+        dbgln("Runtime: {} is its own superclass or superinterface", name);
+        return Error::from_string_literal("java/lang/ClassCircularityError");
+    }
+
+    // The class loader verifies a class once, every runtime that links it shares the outcome
+    if (auto const* failure = m_registry.verification_failure(name)) {
+        dbgln("Runtime: {} failed verification: {}", name, *failure);
+        return Error::from_string_literal("java/lang/VerifyError");
+    }
+
+    TRY(m_classes_being_linked.try_set(name));
+    ScopeGuard remove_from_classes_being_linked = [&] {
+        m_classes_being_linked.remove(name);
+    };
+
+    auto const& constant_pool = *class_file.constant_pool;
+
+    // The superclass and superinterfaces must be linked before this class is
+    Class* super_class = nullptr;
+    if (class_file.super_class != 0)
+        super_class = TRY(resolve_class(TRY(class_name_at(constant_pool, class_file.super_class))));
+
+    auto symbolicated_pool = SymbolicatedConstantPool::create(class_file.constant_pool);
+    auto klass = TRY(try_make<Class>(name, class_file.access_flags, super_class, &class_file, move(symbolicated_pool)));
+
+    for (auto interface_index : class_file.interfaces) {
+        auto* interface = TRY(resolve_class(TRY(class_name_at(constant_pool, interface_index))));
+        TRY(klass->add_interface(*interface));
+    }
+
+    for (auto const& field_info : class_file.fields) {
+        auto field_name = TRY(constant_pool.utf8_at(field_info->name_index)).symbol();
+        auto field_descriptor = TRY(constant_pool.utf8_at(field_info->descriptor_index)).symbol();
+        TRY(klass->add_field(field_name, field_descriptor, field_info->access_flags));
+    }
+
+    TRY(klass->lay_out_instance_fields());
+
+    for (auto const& method_info : class_file.methods) {
+        auto method_name = TRY(constant_pool.utf8_at(method_info->name_index)).symbol();
+        auto method_descriptor = TRY(constant_pool.utf8_at(method_info->descriptor_index)).symbol();
+
+        // Native and abstract methods don't have a Code attribute
+        RefPtr<Parser::CodeAttribute> code;
+        for (auto const& attribute : method_info->attributes) {
+            if (attribute->type() == Parser::AttributeType::Code)
+                code = static_ptr_cast<Parser::CodeAttribute>(attribute);
+        }
+
+        TRY(klass->add_method(method_name, method_descriptor, method_info->access_flags, move(code)));
+    }
+
+    // Overriding is resolved once here, so that selecting a method at a call site is just an indexed load
+    TRY(klass->build_dispatch_tables());
+
+    auto* class_pointer = klass.ptr();
+    TRY(m_classes.try_set(name, move(klass)));
+
+    return class_pointer;
+}
+
+ErrorOr<Class*> Runtime::define_array_class(Symbol name)
+{
+    // The component type follows the first array dimension, e.g. `[[I` is an array of `[I`, and `[Ljava/lang/String;` is an array of `java/lang/String`
+    auto component_descriptor = name.view().substring_view(1);
+    if (component_descriptor.is_empty())
+        return Error::from_string_literal("Array class is missing its component type");
+
+    Class* component_class = nullptr;
+    if (component_descriptor[0] == FieldDescriptor::ArrayDimension) {
+        component_class = TRY(resolve_class(TRY(Symbol::intern(component_descriptor))));
+    } else if (component_descriptor[0] == FieldDescriptor::ReferenceStart) {
+        if (component_descriptor.length() < 3 || !component_descriptor.ends_with(FieldDescriptor::ReferenceEnd))
+            return Error::from_string_literal("Invalid array component type");
+
+        component_class = TRY(resolve_class(TRY(Symbol::intern(component_descriptor.substring_view(1, component_descriptor.length() - 2)))));
+    } else if (component_descriptor.length() != 1) {
+        return Error::from_string_literal("Invalid array component type");
+    }
+
+    // The direct superclass of an array type is Object
+    auto* object_class = TRY(resolve_class(WellKnownSymbols::the().java_lang_Object));
+    auto* array_class = TRY(define_class(name, Access::Public | Access::Final | Access::Abstract, object_class));
+    array_class->set_component_class(component_class);
+    TRY(array_class->lay_out_instance_fields());
+    TRY(array_class->build_dispatch_tables());
+
+    // Array classes don't have a static initializer
+    array_class->set_state(Class::State::Initialized);
+
+    return array_class;
+}
+
+ErrorOr<Class*> Runtime::array_class_of(Class& component_class)
+{
+    auto name = component_class.is_array()
+        ? TRY(String::formatted("[{}", component_class.name()))
+        : TRY(String::formatted("[L{};", component_class.name()));
+
+    return resolve_class(TRY(Symbol::intern(name.bytes_as_string_view())));
+}
+
+ErrorOr<Class*> Runtime::primitive_array_class(u8 array_type)
+{
+    // The atype operand of each newarray instruction must take one of the values T_BOOLEAN (4) through T_LONG (11)
+    static constexpr StringView array_class_names[] = { "[Z"sv, "[C"sv, "[F"sv, "[D"sv, "[B"sv, "[S"sv, "[I"sv, "[J"sv };
+    if (array_type < 4 || array_type > 11)
+        return Error::from_string_literal("Invalid newarray type");
+
+    return resolve_class(TRY(Symbol::intern(array_class_names[array_type - 4])));
+}
+
+ErrorOr<void> Runtime::initialize_class(Class& klass)
+{
+    // If the class is already initialized, or is being initialized by this thread, then this is a recursive request for initialization
+    if (klass.state() != Class::State::Linked)
+        return {};
+
+    klass.set_state(Class::State::Initializing);
+
+    // If C is a class rather than an interface, then its superclass must be initialized first
+    if (!klass.is_interface() && klass.super_class())
+        TRY(initialize_class(*klass.super_class()));
+
+    // Static fields with a ConstantValue attribute are set before the static initializer is run.
+    // The class' fields are in the same order as the class file's.
+    if (auto const* class_file = klass.class_file()) {
+        for (size_t i = 0; i < class_file->fields.size(); i++) {
+            auto const& field_info = class_file->fields[i];
+            if (!(field_info->access_flags & Access::Static))
+                continue;
+
+            for (auto const& attribute : field_info->attributes) {
+                if (attribute->type() != Parser::AttributeType::ConstantValue)
+                    continue;
+
+                auto& constant_value = static_cast<Parser::ConstantValueAttribute&>(*attribute);
+                auto& field = *klass.fields()[i];
+                klass.static_value_at(field.offset()) = TRY(load_constant(klass, constant_value.value_index()));
+            }
+        }
+    }
+
+    auto const& symbols = WellKnownSymbols::the();
+    if (auto* static_initializer = klass.declared_method(symbols.clinit, symbols.void_method_descriptor))
+        TRY(m_interpreter->invoke(*static_initializer, {}));
+
+    klass.set_state(Class::State::Initialized);
+    return {};
+}
+
+ErrorOr<Class*> Runtime::resolve_class_reference(SymbolicatedClassReference& reference)
+{
+    return resolve_class(reference.name());
+}
+
+ErrorOr<Method*> Runtime::resolve_method_reference(SymbolicatedMethodReference& reference)
+{
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.4.3.3
+    auto* owner = TRY(resolve_class(reference.owner()->name()));
+
+    auto* method = owner->lookup_method(reference.name(), reference.descriptor());
+    if (!method) {
+        dbgln("Runtime: Could not find method {}.{}{}", owner->name(), reference.name(), reference.descriptor());
+        return Error::from_string_literal("java/lang/NoSuchMethodError");
+    }
+
+    return method;
+}
+
+ErrorOr<Field*> Runtime::resolve_field_reference(SymbolicatedFieldReference& reference)
+{
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.4.3.2
+    auto* owner = TRY(resolve_class(reference.owner()->name()));
+
+    auto* field = owner->lookup_field(reference.name(), reference.descriptor());
+    if (!field) {
+        dbgln("Runtime: Could not find field {}.{}:{}", owner->name(), reference.name(), reference.descriptor());
+        return Error::from_string_literal("java/lang/NoSuchFieldError");
+    }
+
+    return field;
+}
+
+ErrorOr<NonnullOwnPtr<StringConcatenation>> Runtime::resolve_call_site(Class& klass, SymbolicatedDynamicReference& reference)
+{
+    auto const& symbols = WellKnownSymbols::the();
+
+    // There may be at most one BootstrapMethods attribute in the attributes table of a ClassFile structure
+    RefPtr<Parser::BootstrapMethodsAttribute> bootstrap_methods;
+    if (auto const* class_file = klass.class_file()) {
+        for (auto const& attribute : class_file->attributes) {
+            if (attribute->type() == Parser::AttributeType::BootstrapMethods)
+                bootstrap_methods = static_ptr_cast<Parser::BootstrapMethodsAttribute>(attribute);
+        }
+    }
+
+    if (!bootstrap_methods || reference.bootstrap_method_attr_index() >= bootstrap_methods->bootstrap_methods().size()) {
+        dbgln("Runtime: {} does not have a bootstrap method at index {}", klass.name(), reference.bootstrap_method_attr_index());
+        return Error::from_string_literal("java/lang/BootstrapMethodError");
+    }
+
+    auto const& bootstrap_method = bootstrap_methods->bootstrap_methods()[reference.bootstrap_method_attr_index()];
+    auto& constant_pool = *klass.constant_pool();
+    if (!constant_pool.parsed_pool()->is_valid_index(bootstrap_method.method_ref) || constant_pool.parsed_pool()->tag_at(bootstrap_method.method_ref) != Constant::Tag::MethodHandle)
+        return Error::from_string_literal("java/lang/BootstrapMethodError");
+
+    // The bootstrap method is a static method, which the runtime implements itself instead of invoking it
+    auto& method_handle = static_cast<SymbolicatedMethodHandleReference&>(*TRY(constant_pool.get_or_symbolicate(bootstrap_method.method_ref)));
+    auto is_string_concatenation = [&] {
+        if (method_handle.kind() != Parser::ConstantMethodHandleInfo::InvokeStatic || method_handle.reference()->type() != SymbolicatedReference::Method)
+            return false;
+
+        auto& method = static_cast<SymbolicatedMethodReference&>(*method_handle.reference());
+        return method.owner()->name() == symbols.java_lang_invoke_StringConcatFactory && (method.name() == symbols.make_concat || method.name() == symbols.make_concat_with_constants);
+    };
+
+    if (!is_string_concatenation()) {
+        dbgln("Runtime: Unsupported bootstrap method for {} in {}: {}", reference.name(), klass.name(), TRY(method_handle.debug_description()));
+        return Error::from_string_literal("java/lang/BootstrapMethodError");
+    }
+
+    auto& method = static_cast<SymbolicatedMethodReference&>(*method_handle.reference());
+    auto has_recipe = method.name() == symbols.make_concat_with_constants;
+    return link_string_concatenation(constant_pool, reference.descriptor(), has_recipe, bootstrap_method.arguments);
+}
+
+ErrorOr<Value> Runtime::load_constant(Class& klass, u16 index)
+{
+    VERIFY(klass.constant_pool());
+
+    auto reference = TRY(klass.constant_pool()->get_or_symbolicate(index));
+    if (!reference)
+        return Error::from_string_literal("Constant pool entry is not a loadable constant");
+
+    return load_constant(*reference);
+}
+
+ErrorOr<Value> Runtime::load_constant(SymbolicatedReference& reference)
+{
+    switch (reference.type()) {
+    case SymbolicatedReference::Type::Numeric: {
+        auto& numeric = static_cast<SymbolicatedNumericReference&>(reference);
+        switch (numeric.tag()) {
+        case Constant::Tag::Integer:
+            return Value::from_int(numeric.as_int());
+        case Constant::Tag::Float:
+            return Value::from_float(numeric.as_float());
+        case Constant::Tag::Long:
+            return Value::from_long(numeric.as_long());
+        case Constant::Tag::Double:
+            return Value::from_double(numeric.as_double());
+        default:
+            VERIFY_NOT_REACHED();
+        }
+    }
+
+    case SymbolicatedReference::Type::String: {
+        auto& string = static_cast<SymbolicatedStringReference&>(reference);
+        return Value::from_reference(TRY(intern_string(string.value())));
+    }
+
+    // Resolving a class constant doesn't initialize the class
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.4.3.1
+    case SymbolicatedReference::Type::Class: {
+        auto* klass = TRY(resolve_class_reference(static_cast<SymbolicatedClassReference&>(reference)));
+        return Value::from_reference(TRY(class_object(*klass)));
+    }
+
+    default:
+        // FIXME: Support method type, method handle and dynamically-computed constants.
+        //        Until then, resolving them fails like any other resolution would, so that the program can catch it.
+        dbgln("Runtime: Unsupported constant: {}", TRY(reference.debug_description()));
+        return Error::from_string_literal("java/lang/LinkageError");
+    }
+}
+
+ErrorOr<u8*> Runtime::allocate_memory(size_t size)
+{
+    // FIXME: There's only a single interpreter thread, so every allocation comes from its buffer.
+    auto& allocation_buffer = m_interpreter->allocation_buffer();
+    if (auto* memory = m_heap->allocate(allocation_buffer, size)) [[likely]]
+        return memory;
+
+    // Eden is full, which is the only time that garbage is collected. Most objects die young, so collecting the young generation is usually enough.
+    collect_garbage(Heap::CollectionKind::Young);
+    if (auto* memory = m_heap->allocate(allocation_buffer, size))
+        return memory;
+
+    // The object might not fit into eden at all, or the old generation might be full
+    collect_garbage(Heap::CollectionKind::Full);
+    if (auto* memory = m_heap->allocate(allocation_buffer, size))
+        return memory;
+
+    return Error::from_string_literal("java/lang/OutOfMemoryError");
+}
+
+ErrorOr<Object*> Runtime::allocate_object(Class& klass)
+{
+    auto* memory = TRY(allocate_memory(sizeof(Object) + klass.instance_size()));
+    return new (memory) Object(klass);
+}
+
+ErrorOr<ArrayObject*> Runtime::allocate_array(Class& array_class, i32 length)
+{
+    VERIFY(array_class.is_array());
+
+    if (length < 0)
+        return Error::from_string_literal("java/lang/NegativeArraySizeException");
+
+    auto* memory = TRY(allocate_memory(ArrayObject::elements_offset + static_cast<size_t>(length) * array_class.element_size()));
+    return new (memory) ArrayObject(array_class, length);
+}
+
+ErrorOr<ArrayObject*> Runtime::allocate_multi_array(Class& array_class, ReadonlySpan<i32> lengths)
+{
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-6.html#jvms-6.5.multianewarray
+    // If any count value is less than zero, multianewarray throws a NegativeArraySizeException, before allocating anything.
+    for (auto length : lengths) {
+        if (length < 0)
+            return Error::from_string_literal("java/lang/NegativeArraySizeException");
+    }
+
+    Object* array = TRY(allocate_array(array_class, lengths[0]));
+    if (lengths.size() == 1)
+        return static_cast<ArrayObject*>(array);
+
+    auto* component_class = array_class.component_class();
+    if (!component_class || !component_class->is_array())
+        return Error::from_string_literal("multianewarray has more dimensions than its array type");
+
+    // Nothing else references the array until it's returned, but allocating its elements can move it
+    Heap::TemporaryRoot array_root(*m_heap, array);
+    for (i32 i = 0; i < lengths[0]; i++) {
+        auto* element = TRY(allocate_multi_array(*component_class, lengths.slice(1)));
+        static_cast<ArrayObject*>(array)->element_at<Object*>(i) = element;
+        m_heap->record_write(*array);
+    }
+
+    return static_cast<ArrayObject*>(array);
+}
+
+ErrorOr<Object*> Runtime::intern_string(Symbol value)
+{
+    if (auto existing_string = m_interned_strings.get(value); existing_string.has_value())
+        return *existing_string;
+
+    auto* string = TRY(allocate_string(value.view()));
+    TRY(m_interned_strings.try_set(value, string));
+    return string;
+}
+
+ErrorOr<Object*> Runtime::allocate_string(StringView value)
+{
+    VERIFY(m_string_value_field);
+
+    // T_BYTE, see primitive_array_class()
+    if (!m_byte_array_class)
+        m_byte_array_class = TRY(primitive_array_class(8));
+
+    if (value.length() > static_cast<size_t>(NumericLimits<i32>::max()))
+        return Error::from_string_literal("java/lang/OutOfMemoryError");
+
+    Object* bytes = TRY(allocate_array(*m_byte_array_class, static_cast<i32>(value.length())));
+    if (!value.is_empty())
+        memcpy(static_cast<ArrayObject*>(bytes)->element_storage(), value.characters_without_null_termination(), value.length());
+
+    // Allocating the string can move its contents
+    Heap::TemporaryRoot bytes_root(*m_heap, bytes);
+    auto* string = TRY(allocate_object(m_string_value_field->owner()));
+    string->field_at<Object*>(m_string_value_field->offset()) = bytes;
+    m_heap->record_write(*string);
+
+    return string;
+}
+
+StringView Runtime::string_value(Object& string)
+{
+    VERIFY(m_string_value_field);
+    VERIFY(&string.klass() == &m_string_value_field->owner());
+
+    auto* bytes = static_cast<ArrayObject*>(string.field_at<Object*>(m_string_value_field->offset()));
+    return { bytes->element_storage(), static_cast<size_t>(bytes->length()) };
+}
+
+ErrorOr<Object*> Runtime::class_object(Class& klass)
+{
+    VERIFY(m_represented_class_field);
+
+    if (auto existing_object = m_class_objects.get(&klass); existing_object.has_value())
+        return *existing_object;
+
+    // Classes aren't in the heap, so the pointer is stored in a long field, which the garbage collector doesn't trace
+    auto* object = TRY(allocate_object(m_represented_class_field->owner()));
+    object->field_at<Class*>(m_represented_class_field->offset()) = &klass;
+
+    TRY(m_class_objects.try_set(&klass, object));
+    return object;
+}
+
+Class& Runtime::represented_class(Object& class_object)
+{
+    VERIFY(m_represented_class_field);
+    VERIFY(&class_object.klass() == &m_represented_class_field->owner());
+
+    return *class_object.field_at<Class*>(m_represented_class_field->offset());
+}
+
+ErrorOr<void> Runtime::run_main(Symbol class_name)
+{
+    auto const& symbols = WellKnownSymbols::the();
+    auto* klass = TRY(resolve_class(class_name));
+
+    auto* main_method = klass->declared_method(symbols.main, symbols.main_descriptor);
+    if (!main_method || !main_method->is_static()) {
+        warnln("Error: Main method not found in class {}, please define the main method as:", class_name);
+        warnln("   public static void main(String[] args)");
+        return Error::from_string_literal("Main method not found");
+    }
+
+    TRY(initialize_class(*klass));
+
+    // FIXME: Pass the program's arguments through
+    auto* string_array_class = TRY(array_class_of(*TRY(resolve_class(symbols.java_lang_String))));
+    auto* arguments = TRY(allocate_array(*string_array_class, 0));
+
+    auto argument = Value::from_reference(arguments);
+    auto result = m_interpreter->invoke(*main_method, { &argument, 1 });
+    if (!result.is_error())
+        return {};
+
+    // Anything that isn't a Java exception (e.g. a class file that fails to parse) is returned as it is
+    auto* exception = TRY(m_interpreter->exception_object(result.release_error()));
+    Heap::TemporaryRoot exception_root(*m_heap, exception);
+
+    // Every exception is a Throwable, whose toString gives its class and detail message
+    auto description = exception->klass().name().view();
+    if (auto* to_string = exception->klass().lookup_method(symbols.to_string, symbols.to_string_descriptor)) {
+        auto receiver = Value::from_reference(exception);
+        auto string = m_interpreter->invoke(*to_string, { &receiver, 1 });
+        if (!string.is_error() && string.value().as_reference())
+            description = string_value(*string.value().as_reference());
+    }
+
+    // Stack traces aren't recorded, so only the exception itself is printed
+    warnln("Exception in thread \"main\" {}", description);
+    return Error::from_string_literal("Uncaught exception");
+}
+
+void Runtime::visit_roots(ReferenceVisitor const& visitor)
+{
+    for (auto const& [class_name, klass] : m_classes) {
+        for (auto const& field : klass->fields()) {
+            if (field->is_static() && field->is_reference())
+                visit_reference_value(klass->static_value_at(field->offset()), visitor);
+        }
+
+        for (auto const& method : klass->methods()) {
+            auto* instruction_stream = method->decoded_instructions();
+            if (!instruction_stream)
+                continue;
+
+            instruction_stream->for_each_reference_constant([&](Instruction& instruction) {
+                auto constant = Value::from_bits(instruction.constant_bits);
+                visit_reference_value(constant, visitor);
+                instruction.constant_bits = constant.bits();
+            });
+        }
+    }
+
+    for (auto& [value, string] : m_interned_strings)
+        visitor(string);
+
+    for (auto& [klass, class_object] : m_class_objects)
+        visitor(class_object);
+
+    m_interpreter->visit_roots(visitor);
+}
+
+void Runtime::collect_garbage(Heap::CollectionKind kind)
+{
+    m_heap->collect_garbage(kind, [&](ReferenceVisitor const& visitor) {
+        visit_roots(visitor);
+    });
+}
+
+void Runtime::dump_inline_caches()
+{
+    u64 total_hits = 0;
+    u64 total_misses = 0;
+    Array<size_t, 4> call_sites_in_state {};
+
+    for (auto const& [class_name, klass] : m_classes) {
+        for (auto const& method : klass->methods()) {
+            auto* instruction_stream = method->decoded_instructions();
+            if (!instruction_stream)
+                continue;
+
+            for (auto const& inline_cache : instruction_stream->inline_caches()) {
+                auto& resolved_method = inline_cache->resolved_method();
+                dbgln("{}.{}{} @ {}: {}.{}{} is {}, {} hits, {} misses", class_name, method->name(), method->descriptor(), inline_cache->bytecode_offset(),
+                    resolved_method.owner().name(), resolved_method.name(), resolved_method.descriptor(),
+                    inline_cache_state_name(inline_cache->state()), inline_cache->hits(), inline_cache->misses());
+
+                total_hits += inline_cache->hits();
+                total_misses += inline_cache->misses();
+                call_sites_in_state[to_underlying(inline_cache->state())]++;
+            }
+        }
+    }
+
+    dbgln("Inline caches: {} hits, {} misses, {} monomorphic, {} polymorphic, {} megamorphic call sites", total_hits, total_misses,
+        call_sites_in_state[to_underlying(InlineCache::State::Monomorphic)],
+        call_sites_in_state[to_underlying(InlineCache::State::Polymorphic)],
+        call_sites_in_state[to_underlying(InlineCache::State::Megamorphic)]);
+}
+
+void Runtime::dump_allocation_statistics()
+{
+    auto const& allocation_buffer = m_interpreter->allocation_buffer();
+    dbgln("Allocations: {} objects, {} bytes, {} allocation buffer refills", allocation_buffer.allocated_objects(), allocation_buffer.allocated_bytes(), allocation_buffer.refills());
+    dbgln("Heap: {} of {} bytes in use", m_heap->used(), m_heap->size());
+    dbgln("Garbage collection: {} young and {} full collections, {} bytes reclaimed, {} bytes promoted, paused for {:.3} ms in total", m_heap->young_collections(),
+        m_heap->full_collections(), m_heap->reclaimed_bytes(), m_heap->promoted_bytes(), m_heap->pause_nanoseconds() / 1e6);
+}
+
+// How far a method has got through the tiers, see TieringPolicy
+static StringView tier_name(InstructionStream& instruction_stream)
+{
+    if (auto* compiled_code = instruction_stream.compiled_code())
+        return compiled_code->tier() == JIT::CompiledCode::Tier::Optimized ? "optimized"sv : "compiled"sv;
+
+    return instruction_stream.is_compilable() ? "interpreted"sv : "only interpreted"sv;
+}
+
+void Runtime::dump_profile(size_t method_count)
+{
+    Vector<Method*> methods;
+    for (auto const& [class_name, klass] : m_classes) {
+        for (auto const& method : klass->methods()) {
+            if (method->decoded_instructions())
+                methods.append(method.ptr());
+        }
+    }
+
+    // A back-edge is worth as much as an invocation, they both mean that the method's code has run once more
+    auto hotness = [](Method* method) {
+        auto* instruction_stream = method->decoded_instructions();
+        return instruction_stream->invocation_count() + instruction_stream->backedge_count();
+    };
+    quick_sort(methods, [&](Method* a, Method* b) { return hotness(a) > hotness(b); });
+
+    auto const& tiering_policy = m_interpreter->tiering_policy();
+    dbgln("Profile: the hottest {} of {} executed methods, compiled after {} invocations or {} back-edges", min(method_count, methods.size()), methods.size(),
+        tiering_policy.invocation_threshold(), tiering_policy.backedge_threshold());
+
+    for (size_t i = 0; i < min(method_count, methods.size()); i++) {
+        auto& method = *methods[i];
+        auto& instruction_stream = *method.decoded_instructions();
+        dbgln("{}.{}{}: {} invocations, {} back-edges, {}, {} compilations", method.owner().name(), method.name(), method.descriptor(),
+            instruction_stream.invocation_count(), instruction_stream.backedge_count(), tier_name(instruction_stream), instruction_stream.compilation_count());
+
+        for (auto const& loop : instruction_stream.loops())
+            dbgln("    loop @ {}: {} back-edges", instruction_stream.bytecode_offset(loop.header), loop.backedge_count);
+    }
+}
+
+}
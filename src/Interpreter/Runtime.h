@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "../Loader/ClassLoader.h"
+#include "../Symbol.h"
+#include "Class.h"
+#include "Interpreter.h"
+#include "Object.h"
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Span.h>
+
+namespace Interpreter {
+
+// Owns everything that the interpreter needs at run-time: linked classes, the heap, and interned strings.
+//
+// Classes are linked lazily from the class registry, the first time that they're referenced.
+// A few classes (e.g. java/lang/Object, java/lang/String, java/lang/Class and java/lang/System) are always defined by the
+// runtime itself, so that programs can run without a class library on the classpath. See Natives.cpp.
+class Runtime {
+public:
+    Runtime(Loader::ClassRegistry& registry);
+    ~Runtime();
+
+    static ErrorOr<NonnullOwnPtr<Runtime>> create(Loader::ClassRegistry& registry, DispatchMode dispatch_mode, size_t heap_size = Heap::default_size);
+
+    Interpreter& interpreter() { return *m_interpreter; };
+    Heap& heap() { return *m_heap; };
+
+    // Returns the class with the binary name, linking it if this is the first time that it has been referenced.
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.3
+    ErrorOr<Class*> resolve_class(Symbol name);
+
+    // Returns the class with the binary name if it has already been defined or linked, without linking anything
+    Class* find_class(Symbol name);
+
+    // Defines a class which doesn't have a class file, e.g. array classes and the bootstrap classes.
+    // The caller adds its members, and then builds its dispatch tables.
+    ErrorOr<Class*> define_class(Symbol name, u16 access_flags, Class* super_class);
+
+    // Returns the class for an array of the component class, e.g. `[Ljava/lang/String;` for `java/lang/String`
+    ErrorOr<Class*> array_class_of(Class& component_class);
+
+    // Returns the class for an array of a primitive type, given its `atype` from a newarray instruction
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-6.html#jvms-6.5.newarray
+    ErrorOr<Class*> primitive_array_class(u8 array_type);
+
+    // Runs the class' static initializer, if it hasn't been initialized yet
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.5
+    ErrorOr<void> initialize_class(Class& klass);
+
+    // Resolves the symbolic references in a class' constant pool to the run-time structures that they refer to
+    ErrorOr<Class*> resolve_class_reference(SymbolicatedClassReference& reference);
+    ErrorOr<Method*> resolve_method_reference(SymbolicatedMethodReference& reference);
+    ErrorOr<Field*> resolve_field_reference(SymbolicatedFieldReference& reference);
+
+    // Runs the bootstrap method of an invokedynamic call site, which links it to what it does every time that it's executed.
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.4.3.6
+    // The only bootstrap methods are StringConcatFactory's, which javac uses for string concatenation, see Natives.cpp.
+    ErrorOr<NonnullOwnPtr<StringConcatenation>> resolve_call_site(Class& klass, SymbolicatedDynamicReference& reference);
+
+    // Loads a numeric, string or class constant from a class' constant pool, e.g. for ldc or a ConstantValue attribute
+    ErrorOr<Value> load_constant(SymbolicatedReference& reference);
+    ErrorOr<Value> load_constant(Class& klass, u16 index);
+
+    // Objects are allocated from the allocation buffer of the interpreter thread, garbage is collected whenever eden is full.
+    // Any object that the caller only references from C++ can move (or be freed) while allocating, see Heap::TemporaryRoot.
+    ErrorOr<Object*> allocate_object(Class& klass);
+    ErrorOr<ArrayObject*> allocate_array(Class& array_class, i32 length);
+    ErrorOr<ArrayObject*> allocate_multi_array(Class& array_class, ReadonlySpan<i32> lengths);
+
+    // String literals are interned, so every literal with the same contents is the same object
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.1
+    ErrorOr<Object*> intern_string(Symbol value);
+
+    // Every other string is a new object, e.g. the result of string concatenation.
+    // Its contents are copied into a byte array that the string references, so both are reclaimed by the garbage collector.
+    ErrorOr<Object*> allocate_string(StringView value);
+
+    // Returns the contents of a java/lang/String object.
+    // They're stored in the heap, so the view is only valid until the next allocation, which can move them.
+    StringView string_value(Object& string);
+
+    bool is_string(Object const& object) const { return m_string_value_field && &object.klass() == &m_string_value_field->owner(); };
+
+    // Every class is represented by a single java/lang/Class object, which is created the first time that it's needed, e.g. by ldc
+    ErrorOr<Object*> class_object(Class& klass);
+
+    // Returns the class that a java/lang/Class object represents
+    Class& represented_class(Object& class_object);
+
+    // Set up by the bootstrap classes, see Natives.cpp
+    void set_string_value_field(Field& field) { m_string_value_field = &field; };
+    void set_represented_class_field(Field& field) { m_represented_class_field = &field; };
+
+    // Runs `public static void main(String[])` in the class with the binary name.
+    // An exception that main doesn't catch is printed, like the uncaught exception handler of the main thread would.
+    ErrorOr<void> run_main(Symbol class_name);
+
+    // Every reference that keeps objects alive, apart from the references between objects:
+    // the interpreter's frames, static fields, interned strings, class objects, and the reference constants of quickened ldc instructions.
+    void visit_roots(ReferenceVisitor const& visitor);
+
+    // The world is already stopped when this is called, as the only interpreter thread is the one that is allocating
+    void collect_garbage(Heap::CollectionKind kind);
+
+    // Prints the state and the hit / miss counters of every inline cache, for the call sites that have been executed
+    void dump_inline_caches();
+
+    // Prints how much each thread has allocated, how much of the heap is in use, and how much garbage has been collected
+    void dump_allocation_statistics();
+
+    // Prints the hottest methods that have been executed, with how often each one was invoked and how often each of its loops branched backwards
+    void dump_profile(size_t method_count);
+
+private:
+    ErrorOr<u8*> allocate_memory(size_t size);
+
+    ErrorOr<Class*> link_class(Symbol name, Parser::ClassFile const& class_file);
+    ErrorOr<Class*> define_array_class(Symbol name);
+
+    Loader::ClassRegistry& m_registry;
+
+    HashMap<Symbol, NonnullOwnPtr<Class>> m_classes;
+
+    // Used to detect a class which is its own superclass or superinterface
+    HashTable<Symbol> m_classes_being_linked;
+
+    HashMap<Symbol, Object*> m_interned_strings;
+    Field* m_string_value_field { nullptr };
+    Class* m_byte_array_class { nullptr };
+
+    HashMap<Class*, Object*> m_class_objects;
+    Field* m_represented_class_field { nullptr };
+
+    OwnPtr<Heap> m_heap;
+    OwnPtr<Interpreter> m_interpreter;
+};
+
+}
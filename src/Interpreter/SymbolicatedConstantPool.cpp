@@ -13,6 +13,8 @@ namespace Interpreter {
 SymbolicatedConstantPool::SymbolicatedConstantPool(NonnullRefPtr<Parser::ConstantPool> parsed_pool)
     : m_parsed_pool(move(parsed_pool))
 {
+    // There is a slot for every index into the constant pool, slot 0 is never used
+    m_entries.resize(m_parsed_pool->size());
 }
 
 NonnullRefPtr<SymbolicatedConstantPool> SymbolicatedConstantPool::create(NonnullRefPtr<Parser::ConstantPool> parsed_pool)
@@ -24,81 +26,126 @@ NonnullRefPtr<SymbolicatedConstantPool> SymbolicatedConstantPool::create(Nonnull
 // Iterates through the entries found in the constant pool and symbolicates them
 ErrorOr<void> SymbolicatedConstantPool::symbolicate()
 {
-    // Loop through the entries in the constant pool
-    auto const& constant_entries = parsed_pool()->entries();
-    for (size_t i = 0; i < constant_entries.size(); i++) {
-        // We only really need the entry for grabbing the tag, we use the index for everything else
-        auto const& entry = constant_entries.at(i);
-
-        // The constant pool references are 1-indexed
-        auto index = i + 1;
-
-        // If we already have symbolicated this index, we don't need to do anything else
-        if (entries().contains(index)) {
-            continue;
-        }
-
-        // Attempt to symbolicate the entry
-        switch (entry->tag()) {
-        case Constant::Tag::Class: {
-            auto reference = TRY(SymbolicatedClassReference::create(index, this));
-            entries().set(index, reference);
-
-            break;
-        }
-
-        case Constant::Tag::MethodReference: {
-            auto reference = TRY(SymbolicatedMethodReference::create(index, this));
-            entries().set(index, reference);
-
-            break;
-        }
-
-        case Constant::Tag::FieldReference: {
-            auto reference = TRY(SymbolicatedFieldReference::create(index, this));
-            entries().set(index, reference);
-
-            break;
-        }
-
-        // Only used indirectly when constructing the run-time constant pool.
-        // No entries in the run-time constant pool correspond directly to these structures.
-        case Constant::Tag::UTF8:
-        case Constant::Tag::NameAndType: {
-            break;
-        }
-
-        default: {
-            // FIXME: We need to use proper error types
-            warnln("!!! No symbolicator for {} at {}\n", TRY(entry->debug_description()), index);
-            break;
-        }
-        }
+    // Loop through the entries in the constant pool, the constant pool references are 1-indexed
+    for (u16 index = 1; index < parsed_pool()->size(); index++) {
+        (void)TRY(get_or_symbolicate(index));
     }
 
     return {};
 }
 
-ErrorOr<NonnullRefPtr<SymbolicatedClassReference>> SymbolicatedConstantPool::get_or_symbolicate_class(u16 index)
+ErrorOr<RefPtr<SymbolicatedReference>> SymbolicatedConstantPool::symbolicate_entry(u16 index)
 {
-    // Attempt to get the existing symbolicated class reference
-    auto optional_reference = entries().get(index);
-    if (optional_reference.has_value()) {
-        auto reference = optional_reference.value();
+    // Attempt to symbolicate the entry
+    RefPtr<SymbolicatedReference> reference;
+    switch (parsed_pool()->tag_at(index)) {
+    case Constant::Tag::Class: {
+        reference = TRY(SymbolicatedClassReference::create(index, this));
+        break;
+    }
+
+    case Constant::Tag::MethodReference:
+    case Constant::Tag::InterfaceMethodReference: {
+        reference = TRY(SymbolicatedMethodReference::create(index, this));
+        break;
+    }
+
+    case Constant::Tag::FieldReference: {
+        reference = TRY(SymbolicatedFieldReference::create(index, this));
+        break;
+    }
+
+    case Constant::Tag::MethodHandle: {
+        reference = TRY(SymbolicatedMethodHandleReference::create(index, this));
+        break;
+    }
+
+    case Constant::Tag::MethodType: {
+        reference = TRY(SymbolicatedMethodTypeReference::create(index, this));
+        break;
+    }
 
-        // We need to verify that we have the correct type
-        VERIFY(reference->type() == SymbolicatedReference::Type::Class);
+    case Constant::Tag::Dynamic:
+    case Constant::Tag::InvokeDynamic: {
+        reference = TRY(SymbolicatedDynamicReference::create(index, this));
+        break;
+    }
+
+    case Constant::Tag::String: {
+        reference = TRY(SymbolicatedStringReference::create(index, this));
+        break;
+    }
+
+    case Constant::Tag::Integer:
+    case Constant::Tag::Float:
+    case Constant::Tag::Long:
+    case Constant::Tag::Double: {
+        reference = TRY(SymbolicatedNumericReference::create(index, this));
+        break;
+    }
 
-        // All we need to do now is cast it to the expected type :)
-        auto& casted_reference = static_cast<SymbolicatedClassReference&>(*reference);
-        return adopt_ref(casted_reference);
+    // Only used indirectly when constructing the run-time constant pool.
+    // No entries in the run-time constant pool correspond directly to these structures.
+    case Constant::Tag::UTF8:
+    case Constant::Tag::NameAndType:
+    case Constant::Tag::Module:
+    case Constant::Tag::Package:
+    case Constant::Tag::Unusable: {
+        return nullptr;
     }
+    }
+
+    VERIFY(reference);
 
-    // We don't have a reference already, so let's create one.
-    auto reference = TRY(SymbolicatedClassReference::create(index, this));
-    entries().set(index, reference);
+    // Symbolicating a reference may symbolicate other entries (e.g. its owner class), but never this one.
+    VERIFY(!m_entries[index]);
+    m_entries[index] = reference;
+    m_resolved_count++;
 
     return reference;
 }
 
+ErrorOr<NonnullRefPtr<SymbolicatedClassReference>> SymbolicatedConstantPool::get_or_symbolicate_class(u16 index)
+{
+    auto reference = TRY(get_or_symbolicate(index));
+
+    // We need to verify that we have the correct type
+    VERIFY(reference && reference->type() == SymbolicatedReference::Type::Class);
+
+    // All we need to do now is cast it to the expected type :)
+    return static_cast<SymbolicatedClassReference&>(*reference);
+}
+
+ErrorOr<NonnullRefPtr<SymbolicatedMethodReference>> SymbolicatedConstantPool::get_or_symbolicate_method(u16 index)
+{
+    auto reference = TRY(get_or_symbolicate(index));
+    VERIFY(reference && (reference->type() == SymbolicatedReference::Type::Method || reference->type() == SymbolicatedReference::Type::InterfaceMethod));
+
+    return static_cast<SymbolicatedMethodReference&>(*reference);
+}
+
+ErrorOr<NonnullRefPtr<SymbolicatedFieldReference>> SymbolicatedConstantPool::get_or_symbolicate_field(u16 index)
+{
+    auto reference = TRY(get_or_symbolicate(index));
+    VERIFY(reference && reference->type() == SymbolicatedReference::Type::Field);
+
+    return static_cast<SymbolicatedFieldReference&>(*reference);
+}
+
+ErrorOr<NonnullRefPtr<SymbolicatedStringReference>> SymbolicatedConstantPool::get_or_symbolicate_string(u16 index)
+{
+    auto reference = TRY(get_or_symbolicate(index));
+    VERIFY(reference && reference->type() == SymbolicatedReference::Type::String);
+
+    return static_cast<SymbolicatedStringReference&>(*reference);
+}
+
+ErrorOr<NonnullRefPtr<SymbolicatedNumericReference>> SymbolicatedConstantPool::get_or_symbolicate_numeric(u16 index)
+{
+    auto reference = TRY(get_or_symbolicate(index));
+    VERIFY(reference && reference->type() == SymbolicatedReference::Type::Numeric);
+
+    return static_cast<SymbolicatedNumericReference&>(*reference);
+}
+
 }
@@ -9,13 +9,16 @@
 #include "../Parser/ConstantPool.h"
 #include "SymbolicatedReference.h"
 #include <AK/Forward.h>
-#include <AK/HashMap.h>
+#include <AK/Vector.h>
 
 namespace Interpreter {
 
 // The symbolicated constant pool takes a parsed constant pool, and
 // symbolicates its entries.
 //
+// Entries are symbolicated lazily, the first time that they are referenced (e.g. by an instruction),
+// and are then cached. Most entries in a class' constant pool are never used at runtime.
+//
 // See the JVM spec for more information on how to symbolicate entries:
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.1
 class SymbolicatedConstantPool : public RefCounted<SymbolicatedConstantPool> {
@@ -23,22 +26,60 @@ public:
     SymbolicatedConstantPool(NonnullRefPtr<Parser::ConstantPool> parsed_pool);
     static NonnullRefPtr<SymbolicatedConstantPool> create(NonnullRefPtr<Parser::ConstantPool> parsed_pool);
 
-    // Iterates through the entries found in the constant pool and symbolicates them
+    // Eagerly iterates through the entries found in the constant pool and symbolicates them, this is only useful for debugging
     ErrorOr<void> symbolicate();
 
     // Returns a reference to the non-symbolicated constant pool
-    NonnullRefPtr<Parser::ConstantPool> parsed_pool() { return m_parsed_pool; };
+    NonnullRefPtr<Parser::ConstantPool> const& parsed_pool() { return m_parsed_pool; };
+
+    // The number of entries that have been symbolicated so far
+    size_t resolved_count() const { return m_resolved_count; };
+
+    // Indexed directly by the constant pool index, a null entry has not been symbolicated (yet).
+    Vector<RefPtr<SymbolicatedReference>> const& entries() { return m_entries; };
 
-    HashMap<u16, NonnullRefPtr<SymbolicatedReference>>& entries() { return m_entries; };
+    // Returns the symbolicated reference at the index, or null if it hasn't been symbolicated yet
+    SymbolicatedReference* entry_at(u16 index)
+    {
+        VERIFY(index < m_entries.size());
+        return m_entries[index].ptr();
+    }
+
+    // Attempts to retreive a symbolicated reference, or creates it if it hasn't been symbolicated yet.
+    // Returns null for constants which don't have a corresponding entry in the run-time constant pool (e.g. UTF8 or NameAndType).
+    ErrorOr<RefPtr<SymbolicatedReference>> get_or_symbolicate(u16 index)
+    {
+        // If we already have symbolicated this index, we don't need to do anything else
+        if (auto* reference = entry_at(index))
+            return RefPtr<SymbolicatedReference>(reference);
+
+        return symbolicate_entry(index);
+    }
 
     // Attempts to retreive a symbolicated class reference, or creates if it hasn't been symbolicated yet
     ErrorOr<NonnullRefPtr<SymbolicatedClassReference>> get_or_symbolicate_class(u16 index);
 
+    // Attempts to retreive a symbolicated method or interface method reference, or creates if it hasn't been symbolicated yet
+    ErrorOr<NonnullRefPtr<SymbolicatedMethodReference>> get_or_symbolicate_method(u16 index);
+
+    // Attempts to retreive a symbolicated field reference, or creates if it hasn't been symbolicated yet
+    ErrorOr<NonnullRefPtr<SymbolicatedFieldReference>> get_or_symbolicate_field(u16 index);
+
+    // Attempts to retreive a symbolicated string constant, or creates if it hasn't been symbolicated yet
+    ErrorOr<NonnullRefPtr<SymbolicatedStringReference>> get_or_symbolicate_string(u16 index);
+
+    // Attempts to retreive a symbolicated numeric constant, or creates if it hasn't been symbolicated yet
+    ErrorOr<NonnullRefPtr<SymbolicatedNumericReference>> get_or_symbolicate_numeric(u16 index);
+
 private:
+    ErrorOr<RefPtr<SymbolicatedReference>> symbolicate_entry(u16 index);
+
     // The non-symbolicated constant pool
     NonnullRefPtr<Parser::ConstantPool> m_parsed_pool;
 
-    HashMap<u16, NonnullRefPtr<SymbolicatedReference>> m_entries;
+    Vector<RefPtr<SymbolicatedReference>> m_entries;
+
+    size_t m_resolved_count { 0 };
 };
 
 }
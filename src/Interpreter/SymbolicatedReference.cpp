@@ -5,7 +5,6 @@
  */
 
 #include "SymbolicatedReference.h"
-#include "../Descriptor.h"
 #include "../Parser/ConstantInfo.h"
 #include "SymbolicatedConstantPool.h"
 
@@ -18,7 +17,7 @@ SymbolicatedReference::SymbolicatedReference(u16 index, SymbolicatedReference::T
 }
 
 // A symbolic reference to a class or interface is derived from a CONSTANT_Class_info structure
-SymbolicatedClassReference::SymbolicatedClassReference(u16 index, String name)
+SymbolicatedClassReference::SymbolicatedClassReference(u16 index, Symbol name)
     : SymbolicatedReference(index, SymbolicatedReference::Type::Class)
     , m_name(move(name))
 {
@@ -27,20 +26,16 @@ SymbolicatedClassReference::SymbolicatedClassReference(u16 index, String name)
 ErrorOr<NonnullRefPtr<SymbolicatedClassReference>> SymbolicatedClassReference::create(u16 index, SymbolicatedConstantPool* symbolicated_pool)
 {
     // The entry at the index must be a Constant_Class_info structure.
-    auto const& class_info = TRY(symbolicated_pool->parsed_pool()->class_at(index));
+    auto class_info = TRY(symbolicated_pool->parsed_pool()->class_at(index));
 
     // The entry at `name_index` must be a Constant_Utf8_info structure.
-    auto const& name_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(class_info->name_index()));
+    auto name_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(class_info.name_index()));
 
     // For a nonarray class or an interface, the name is the binary name of the class or interface.
-    auto name = name_utf8->data();
-
-    // For an array class of n dimensions...
-    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#:~:text=For%20an%20array%20class%20of%20n%20dimensions
-    if (name.starts_with(FieldDescriptor::ArrayDimension)) {
-        dbgln("SymbolicatedClassReference::create: Array [{}] classes not implemented!");
-        TODO();
-    }
+    // For an array class of n dimensions, the name begins with n occurrences of `[`, followed by the descriptor of the element type.
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.1
+    // Both are resolved by name, Runtime::resolve_class creates the array classes.
+    auto name = name_utf8.symbol();
 
     return try_make_ref_counted<SymbolicatedClassReference>(index, name);
 }
@@ -58,37 +53,42 @@ ErrorOr<String> SymbolicatedClassReference::debug_description()
 }
 
 // A symbolic reference to a method of a class is derived from a CONSTANT_Methodref_info structure
-SymbolicatedMethodReference::SymbolicatedMethodReference(u16 index, String name, String descriptor, NonnullRefPtr<SymbolicatedClassReference> owner)
-    : SymbolicatedReference(index, SymbolicatedReference::Type::Method)
+// A symbolic reference to a method of an interface is derived from a CONSTANT_InterfaceMethodref_info structure
+SymbolicatedMethodReference::SymbolicatedMethodReference(u16 index, SymbolicatedReference::Type type, Symbol name, Symbol descriptor, NonnullRefPtr<SymbolicatedClassReference> owner)
+    : SymbolicatedReference(index, type)
     , m_name(move(name))
     , m_descriptor(move(descriptor))
     , m_owner(owner)
 {
 }
 
-// Attempts to symbolicate a class reference, given its index into the parsed constant pool
+// Attempts to symbolicate a method or interface method reference, given its index into the parsed constant pool
 ErrorOr<NonnullRefPtr<SymbolicatedMethodReference>> SymbolicatedMethodReference::create(u16 index, SymbolicatedConstantPool* symbolicated_pool)
 {
-    // The entry at the index must be a Constant_Methodref_info structure.
-    auto const& field_info = TRY(symbolicated_pool->parsed_pool()->method_reference_at(index));
+    // The entry at the index must be a Constant_Methodref_info or Constant_InterfaceMethodref_info structure.
+    auto is_interface = symbolicated_pool->parsed_pool()->tag_at(index) == Constant::Tag::InterfaceMethodReference;
+    auto field_info = is_interface
+        ? TRY(symbolicated_pool->parsed_pool()->interface_method_reference_at(index))
+        : TRY(symbolicated_pool->parsed_pool()->method_reference_at(index));
 
     // The entry at `name_and_type_index` must be a CONSTANT_NameAndType_info structure.
-    auto const& name_and_type = TRY(symbolicated_pool->parsed_pool()->name_and_type_at(field_info->name_and_type_index()));
+    auto name_and_type = TRY(symbolicated_pool->parsed_pool()->name_and_type_at(field_info.name_and_type_index()));
 
     // The entries at `name_index` and `descriptor_index` must be CONSTANT_Utf8_info structures.
-    auto const& name_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(name_and_type->name_index()));
-    auto const& descriptor_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(name_and_type->descriptor_index()));
+    auto name_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(name_and_type.name_index()));
+    auto descriptor_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(name_and_type.descriptor_index()));
 
     // Represents the field's name
-    auto name = name_utf8->data();
+    auto name = name_utf8.symbol();
 
     // Represents a valid field or method (in this case field) descriptor.
-    auto descriptor = descriptor_utf8->data();
+    auto descriptor = descriptor_utf8.symbol();
 
     // The value of the `class_index` type must correspond to a SymbolicatedClassReference.
-    auto owner = TRY(symbolicated_pool->get_or_symbolicate_class(field_info->class_index()));
+    auto owner = TRY(symbolicated_pool->get_or_symbolicate_class(field_info.class_index()));
 
-    return try_make_ref_counted<SymbolicatedMethodReference>(index, name, descriptor, owner);
+    auto type = is_interface ? SymbolicatedReference::Type::InterfaceMethod : SymbolicatedReference::Type::Method;
+    return try_make_ref_counted<SymbolicatedMethodReference>(index, type, name, descriptor, owner);
 }
 
 // Used for debugging
@@ -107,7 +107,7 @@ ErrorOr<String> SymbolicatedMethodReference::debug_description()
 
 // A symbolic reference to a method of a class is derived from a CONSTANT_Fieldref_info structure
 // Very similar to a SymbolicatedMethodReference
-SymbolicatedFieldReference::SymbolicatedFieldReference(u16 index, String name, String descriptor, NonnullRefPtr<SymbolicatedClassReference> owner)
+SymbolicatedFieldReference::SymbolicatedFieldReference(u16 index, Symbol name, Symbol descriptor, NonnullRefPtr<SymbolicatedClassReference> owner)
     : SymbolicatedReference(index, SymbolicatedReference::Type::Field)
     , m_name(move(name))
     , m_descriptor(move(descriptor))
@@ -115,27 +115,27 @@ SymbolicatedFieldReference::SymbolicatedFieldReference(u16 index, String name, S
 {
 }
 
-// Attempts to symbolicate a class reference, given its index into the parsed constant pool
+// Attempts to symbolicate a field reference, given its index into the parsed constant pool
 ErrorOr<NonnullRefPtr<SymbolicatedFieldReference>> SymbolicatedFieldReference::create(u16 index, SymbolicatedConstantPool* symbolicated_pool)
 {
     // The entry at the index must be a Constant_Methodref_info structure.
-    auto const& method_info = TRY(symbolicated_pool->parsed_pool()->field_reference_at(index));
+    auto method_info = TRY(symbolicated_pool->parsed_pool()->field_reference_at(index));
 
     // The entry at `name_and_type_index` must be a CONSTANT_NameAndType_info structure.
-    auto const& name_and_type = TRY(symbolicated_pool->parsed_pool()->name_and_type_at(method_info->name_and_type_index()));
+    auto name_and_type = TRY(symbolicated_pool->parsed_pool()->name_and_type_at(method_info.name_and_type_index()));
 
     // The entries at `name_index` and `descriptor_index` must be CONSTANT_Utf8_info structures.
-    auto const& name_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(name_and_type->name_index()));
-    auto const& descriptor_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(name_and_type->descriptor_index()));
+    auto name_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(name_and_type.name_index()));
+    auto descriptor_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(name_and_type.descriptor_index()));
 
     // Represents either an unqualified name, or the special method name `<init>`
-    auto name = name_utf8->data();
+    auto name = name_utf8.symbol();
 
     // Represents a valid field or method (in this case method) descriptor.
-    auto descriptor = descriptor_utf8->data();
+    auto descriptor = descriptor_utf8.symbol();
 
     // The value of the `class_index` type must correspond to a SymbolicatedClassReference.
-    auto owner = TRY(symbolicated_pool->get_or_symbolicate_class(method_info->class_index()));
+    auto owner = TRY(symbolicated_pool->get_or_symbolicate_class(method_info.class_index()));
 
     return try_make_ref_counted<SymbolicatedFieldReference>(index, name, descriptor, owner);
 }
@@ -154,4 +154,230 @@ ErrorOr<String> SymbolicatedFieldReference::debug_description()
     return builder.to_string();
 }
 
+// A symbolic reference to a method handle is derived from a CONSTANT_MethodHandle_info structure
+SymbolicatedMethodHandleReference::SymbolicatedMethodHandleReference(u16 index, Parser::ConstantMethodHandleInfo::ReferenceKind kind, NonnullRefPtr<SymbolicatedReference> reference)
+    : SymbolicatedReference(index, SymbolicatedReference::Type::MethodHandle)
+    , m_kind(kind)
+    , m_reference(move(reference))
+{
+}
+
+// Attempts to symbolicate a method handle, given its index into the parsed constant pool
+ErrorOr<NonnullRefPtr<SymbolicatedMethodHandleReference>> SymbolicatedMethodHandleReference::create(u16 index, SymbolicatedConstantPool* symbolicated_pool)
+{
+    // The entry at the index must be a CONSTANT_MethodHandle_info structure.
+    auto method_handle_info = TRY(symbolicated_pool->parsed_pool()->method_handle_at(index));
+
+    // The entry at `reference_index` is a field, method or interface method reference depending on the kind of the handle.
+    auto reference_tag = symbolicated_pool->parsed_pool()->tag_at(method_handle_info.reference_index());
+    switch (method_handle_info.reference_kind()) {
+    case Parser::ConstantMethodHandleInfo::ReferenceKind::GetField:
+    case Parser::ConstantMethodHandleInfo::ReferenceKind::GetStatic:
+    case Parser::ConstantMethodHandleInfo::ReferenceKind::PutField:
+    case Parser::ConstantMethodHandleInfo::ReferenceKind::PutStatic:
+        VERIFY(reference_tag == Constant::Tag::FieldReference);
+        break;
+    case Parser::ConstantMethodHandleInfo::ReferenceKind::InvokeVirtual:
+    case Parser::ConstantMethodHandleInfo::ReferenceKind::NewInvokeSpecial:
+        VERIFY(reference_tag == Constant::Tag::MethodReference);
+        break;
+    case Parser::ConstantMethodHandleInfo::ReferenceKind::InvokeStatic:
+    case Parser::ConstantMethodHandleInfo::ReferenceKind::InvokeSpecial:
+        VERIFY(reference_tag == Constant::Tag::MethodReference || reference_tag == Constant::Tag::InterfaceMethodReference);
+        break;
+    case Parser::ConstantMethodHandleInfo::ReferenceKind::InvokeInterface:
+        VERIFY(reference_tag == Constant::Tag::InterfaceMethodReference);
+        break;
+    }
+
+    auto reference = TRY(symbolicated_pool->get_or_symbolicate(method_handle_info.reference_index()));
+    return try_make_ref_counted<SymbolicatedMethodHandleReference>(index, method_handle_info.reference_kind(), reference.release_nonnull());
+}
+
+// Used for debugging
+ErrorOr<String> SymbolicatedMethodHandleReference::debug_description()
+{
+    StringBuilder builder;
+
+    builder.append("SymbolicatedMethodHandleReference { "sv);
+    builder.appendff("kind = {}, ", to_underlying(this->kind()));
+    builder.appendff("reference = {}", TRY(this->reference()->debug_description()));
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
+// A symbolic reference to a method type is derived from a CONSTANT_MethodType_info structure
+SymbolicatedMethodTypeReference::SymbolicatedMethodTypeReference(u16 index, Symbol descriptor)
+    : SymbolicatedReference(index, SymbolicatedReference::Type::MethodType)
+    , m_descriptor(move(descriptor))
+{
+}
+
+// Attempts to symbolicate a method type, given its index into the parsed constant pool
+ErrorOr<NonnullRefPtr<SymbolicatedMethodTypeReference>> SymbolicatedMethodTypeReference::create(u16 index, SymbolicatedConstantPool* symbolicated_pool)
+{
+    // The entry at the index must be a CONSTANT_MethodType_info structure.
+    auto method_type_info = TRY(symbolicated_pool->parsed_pool()->method_type_at(index));
+
+    // The entry at `descriptor_index` must be a CONSTANT_Utf8_info structure representing a method descriptor.
+    auto descriptor_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(method_type_info.descriptor_index()));
+    auto descriptor = descriptor_utf8.symbol();
+
+    return try_make_ref_counted<SymbolicatedMethodTypeReference>(index, descriptor);
+}
+
+// Used for debugging
+ErrorOr<String> SymbolicatedMethodTypeReference::debug_description()
+{
+    StringBuilder builder;
+
+    builder.append("SymbolicatedMethodTypeReference { "sv);
+    builder.appendff("descriptor = \"{}\"", this->descriptor());
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
+// A symbolic reference to a dynamically-computed constant is derived from a CONSTANT_Dynamic_info structure
+// A symbolic reference to a dynamically-computed call site is derived from a CONSTANT_InvokeDynamic_info structure
+SymbolicatedDynamicReference::SymbolicatedDynamicReference(u16 index, SymbolicatedReference::Type type, u16 bootstrap_method_attr_index, Symbol name, Symbol descriptor)
+    : SymbolicatedReference(index, type)
+    , m_bootstrap_method_attr_index(bootstrap_method_attr_index)
+    , m_name(move(name))
+    , m_descriptor(move(descriptor))
+{
+}
+
+// Attempts to symbolicate a dynamically-computed constant or call site, given its index into the parsed constant pool
+ErrorOr<NonnullRefPtr<SymbolicatedDynamicReference>> SymbolicatedDynamicReference::create(u16 index, SymbolicatedConstantPool* symbolicated_pool)
+{
+    // The entry at the index must be a CONSTANT_Dynamic_info or CONSTANT_InvokeDynamic_info structure.
+    auto is_call_site = symbolicated_pool->parsed_pool()->tag_at(index) == Constant::Tag::InvokeDynamic;
+    auto dynamic_info = is_call_site
+        ? TRY(symbolicated_pool->parsed_pool()->invoke_dynamic_at(index))
+        : TRY(symbolicated_pool->parsed_pool()->dynamic_at(index));
+
+    // The entry at `name_and_type_index` must be a CONSTANT_NameAndType_info structure.
+    auto name_and_type = TRY(symbolicated_pool->parsed_pool()->name_and_type_at(dynamic_info.name_and_type_index()));
+
+    // The entries at `name_index` and `descriptor_index` must be CONSTANT_Utf8_info structures.
+    auto name_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(name_and_type.name_index()));
+    auto descriptor_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(name_and_type.descriptor_index()));
+
+    auto name = name_utf8.symbol();
+    auto descriptor = descriptor_utf8.symbol();
+
+    auto type = is_call_site ? SymbolicatedReference::Type::DynamicCallSite : SymbolicatedReference::Type::DynamicConstant;
+    return try_make_ref_counted<SymbolicatedDynamicReference>(index, type, dynamic_info.bootstrap_method_attr_index(), name, descriptor);
+}
+
+// Used for debugging
+ErrorOr<String> SymbolicatedDynamicReference::debug_description()
+{
+    StringBuilder builder;
+
+    builder.append("SymbolicatedDynamicReference { "sv);
+    builder.appendff("bootstrap_method_attr_index = {}, ", this->bootstrap_method_attr_index());
+    builder.appendff("name = \"{}\", ", this->name());
+    builder.appendff("descriptor = \"{}\"", this->descriptor());
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
+// A string constant is a reference to an instance of class String, derived from a CONSTANT_String_info structure
+SymbolicatedStringReference::SymbolicatedStringReference(u16 index, Symbol value)
+    : SymbolicatedReference(index, SymbolicatedReference::Type::String)
+    , m_value(move(value))
+{
+}
+
+// Attempts to symbolicate a string constant, given its index into the parsed constant pool
+ErrorOr<NonnullRefPtr<SymbolicatedStringReference>> SymbolicatedStringReference::create(u16 index, SymbolicatedConstantPool* symbolicated_pool)
+{
+    // The entry at the index must be a CONSTANT_String_info structure.
+    auto string_info = TRY(symbolicated_pool->parsed_pool()->string_at(index));
+
+    // The entry at `string_index` must be a CONSTANT_Utf8_info structure.
+    auto value_utf8 = TRY(symbolicated_pool->parsed_pool()->utf8_at(string_info.index()));
+    auto value = value_utf8.symbol();
+
+    return try_make_ref_counted<SymbolicatedStringReference>(index, value);
+}
+
+// Used for debugging
+ErrorOr<String> SymbolicatedStringReference::debug_description()
+{
+    StringBuilder builder;
+
+    builder.append("SymbolicatedStringReference { "sv);
+    builder.appendff("value = \"{}\"", this->value());
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
+// Numeric constants are derived from CONSTANT_Integer_info, CONSTANT_Float_info, CONSTANT_Long_info and CONSTANT_Double_info structures
+SymbolicatedNumericReference::SymbolicatedNumericReference(u16 index, Constant::Tag tag, u64 bits)
+    : SymbolicatedReference(index, SymbolicatedReference::Type::Numeric)
+    , m_tag(tag)
+    , m_bits(bits)
+{
+}
+
+// Attempts to symbolicate a numeric constant, given its index into the parsed constant pool
+ErrorOr<NonnullRefPtr<SymbolicatedNumericReference>> SymbolicatedNumericReference::create(u16 index, SymbolicatedConstantPool* symbolicated_pool)
+{
+    auto const& parsed_pool = symbolicated_pool->parsed_pool();
+    auto tag = parsed_pool->tag_at(index);
+
+    u64 bits = 0;
+    switch (tag) {
+    case Constant::Tag::Integer:
+        bits = TRY(parsed_pool->integer_at(index)).value();
+        break;
+    case Constant::Tag::Float:
+        bits = TRY(parsed_pool->float_at(index)).bytes();
+        break;
+    case Constant::Tag::Long:
+        bits = TRY(parsed_pool->long_at(index)).bytes();
+        break;
+    case Constant::Tag::Double:
+        bits = TRY(parsed_pool->double_at(index)).bytes();
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+
+    return try_make_ref_counted<SymbolicatedNumericReference>(index, tag, bits);
+}
+
+// Used for debugging
+ErrorOr<String> SymbolicatedNumericReference::debug_description()
+{
+    StringBuilder builder;
+
+    builder.append("SymbolicatedNumericReference { "sv);
+    switch (this->tag()) {
+    case Constant::Tag::Integer:
+        builder.appendff("int = {}", this->as_int());
+        break;
+    case Constant::Tag::Float:
+        builder.appendff("float = {}", this->as_float());
+        break;
+    case Constant::Tag::Long:
+        builder.appendff("long = {}", this->as_long());
+        break;
+    case Constant::Tag::Double:
+        builder.appendff("double = {}", this->as_double());
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
 }
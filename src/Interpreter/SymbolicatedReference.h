@@ -6,6 +6,10 @@
 
 #pragma once
 
+#include "../ConstantTag.h"
+#include "../Parser/ConstantInfo.h"
+#include "../Symbol.h"
+#include <AK/BitCast.h>
 #include <AK/RefCounted.h>
 #include <AK/String.h>
 
@@ -33,14 +37,35 @@ public:
         Method,
 
         // A symbolic reference to a method of a class is derived from a CONSTANT_Fieldref_info structure
-        Field
+        Field,
+
+        // A symbolic reference to a method of an interface is derived from a CONSTANT_InterfaceMethodref_info structure
+        InterfaceMethod,
+
+        // A symbolic reference to a method handle is derived from a CONSTANT_MethodHandle_info structure
+        MethodHandle,
+
+        // A symbolic reference to a method type is derived from a CONSTANT_MethodType_info structure
+        MethodType,
+
+        // A symbolic reference to a dynamically-computed constant is derived from a CONSTANT_Dynamic_info structure
+        DynamicConstant,
+
+        // A symbolic reference to a dynamically-computed call site is derived from a CONSTANT_InvokeDynamic_info structure
+        DynamicCallSite,
+
+        // A string constant is a reference to an instance of class String, derived from a CONSTANT_String_info structure
+        String,
+
+        // Numeric constants are derived from CONSTANT_Integer_info, CONSTANT_Float_info, CONSTANT_Long_info and CONSTANT_Double_info structures
+        Numeric,
     };
 
     SymbolicatedReference(u16 index, Type type);
     virtual ~SymbolicatedReference() = default;
 
     // Used for debugging
-    virtual ErrorOr<String> debug_description() = 0;
+    virtual ErrorOr<AK::String> debug_description() = 0;
 
     // The index into the constant pool for the original constant
     // used to derive this symbolicated reference
@@ -57,43 +82,44 @@ private:
 // A symbolic reference to a class or interface is derived from a CONSTANT_Class_info structure
 class SymbolicatedClassReference : public SymbolicatedReference {
 public:
-    SymbolicatedClassReference(u16 index, String name);
+    SymbolicatedClassReference(u16 index, Symbol name);
 
     // Attempts to symbolicate a class reference, given its index into the parsed constant pool
     static ErrorOr<NonnullRefPtr<SymbolicatedClassReference>> create(u16 index, SymbolicatedConstantPool* symbolicated_pool);
 
     // Used for debugging
-    ErrorOr<String> debug_description();
+    ErrorOr<AK::String> debug_description();
 
     // The fully qualified name of this class
-    String const& name() { return m_name; };
+    Symbol const& name() { return m_name; };
 
 private:
-    String m_name;
+    Symbol m_name;
 };
 
 // A symbolic reference to a method of a class is derived from a CONSTANT_Methodref_info structure
+// A symbolic reference to a method of an interface is derived from a CONSTANT_InterfaceMethodref_info structure
 class SymbolicatedMethodReference : public SymbolicatedReference {
 public:
-    SymbolicatedMethodReference(u16 index, String name, String descriptor, NonnullRefPtr<SymbolicatedClassReference> owner);
+    SymbolicatedMethodReference(u16 index, Type type, Symbol name, Symbol descriptor, NonnullRefPtr<SymbolicatedClassReference> owner);
 
-    // Attempts to symbolicate a method reference, given its index into the parsed constant pool
+    // Attempts to symbolicate a method or interface method reference, given its index into the parsed constant pool
     static ErrorOr<NonnullRefPtr<SymbolicatedMethodReference>> create(u16 index, SymbolicatedConstantPool* symbolicated_pool);
 
     // Used for debugging
-    ErrorOr<String> debug_description();
+    ErrorOr<AK::String> debug_description();
 
     // The unqualified name of this method
-    String const& name() { return m_name; };
+    Symbol const& name() { return m_name; };
 
     // The descriptor (signature) of this method
-    String const& descriptor() { return m_descriptor; };
+    Symbol const& descriptor() { return m_descriptor; };
 
     NonnullRefPtr<SymbolicatedClassReference> const& owner() { return m_owner; };
 
 private:
-    String m_name;
-    String m_descriptor;
+    Symbol m_name;
+    Symbol m_descriptor;
     NonnullRefPtr<SymbolicatedClassReference> m_owner;
 };
 
@@ -101,26 +127,141 @@ private:
 // Very similar to a SymbolicatedMethodReference
 class SymbolicatedFieldReference : public SymbolicatedReference {
 public:
-    SymbolicatedFieldReference(u16 index, String name, String descriptor, NonnullRefPtr<SymbolicatedClassReference> owner);
+    SymbolicatedFieldReference(u16 index, Symbol name, Symbol descriptor, NonnullRefPtr<SymbolicatedClassReference> owner);
 
-    // Attempts to symbolicate a method reference, given its index into the parsed constant pool
+    // Attempts to symbolicate a field reference, given its index into the parsed constant pool
     static ErrorOr<NonnullRefPtr<SymbolicatedFieldReference>> create(u16 index, SymbolicatedConstantPool* symbolicated_pool);
 
     // Used for debugging
-    ErrorOr<String> debug_description();
+    ErrorOr<AK::String> debug_description();
 
     // The unqualified name of this method
-    String const& name() { return m_name; };
+    Symbol const& name() { return m_name; };
 
     // The descriptor (signature) of this method
-    String const& descriptor() { return m_descriptor; };
+    Symbol const& descriptor() { return m_descriptor; };
 
     NonnullRefPtr<SymbolicatedClassReference> const& owner() { return m_owner; };
 
 private:
-    String m_name;
-    String m_descriptor;
+    Symbol m_name;
+    Symbol m_descriptor;
     NonnullRefPtr<SymbolicatedClassReference> m_owner;
 };
 
+// A symbolic reference to a method handle is derived from a CONSTANT_MethodHandle_info structure
+class SymbolicatedMethodHandleReference : public SymbolicatedReference {
+public:
+    SymbolicatedMethodHandleReference(u16 index, Parser::ConstantMethodHandleInfo::ReferenceKind kind, NonnullRefPtr<SymbolicatedReference> reference);
+
+    // Attempts to symbolicate a method handle, given its index into the parsed constant pool
+    static ErrorOr<NonnullRefPtr<SymbolicatedMethodHandleReference>> create(u16 index, SymbolicatedConstantPool* symbolicated_pool);
+
+    // Used for debugging
+    ErrorOr<AK::String> debug_description();
+
+    // Characterizes the bytecode behavior of this method handle
+    Parser::ConstantMethodHandleInfo::ReferenceKind kind() { return m_kind; };
+
+    // A symbolic reference to the field or method that this method handle refers to
+    NonnullRefPtr<SymbolicatedReference> const& reference() { return m_reference; };
+
+private:
+    Parser::ConstantMethodHandleInfo::ReferenceKind m_kind;
+    NonnullRefPtr<SymbolicatedReference> m_reference;
+};
+
+// A symbolic reference to a method type is derived from a CONSTANT_MethodType_info structure
+class SymbolicatedMethodTypeReference : public SymbolicatedReference {
+public:
+    SymbolicatedMethodTypeReference(u16 index, Symbol descriptor);
+
+    // Attempts to symbolicate a method type, given its index into the parsed constant pool
+    static ErrorOr<NonnullRefPtr<SymbolicatedMethodTypeReference>> create(u16 index, SymbolicatedConstantPool* symbolicated_pool);
+
+    // Used for debugging
+    ErrorOr<AK::String> debug_description();
+
+    // The method descriptor of this method type
+    Symbol const& descriptor() { return m_descriptor; };
+
+private:
+    Symbol m_descriptor;
+};
+
+// A symbolic reference to a dynamically-computed constant is derived from a CONSTANT_Dynamic_info structure
+// A symbolic reference to a dynamically-computed call site is derived from a CONSTANT_InvokeDynamic_info structure
+class SymbolicatedDynamicReference : public SymbolicatedReference {
+public:
+    SymbolicatedDynamicReference(u16 index, Type type, u16 bootstrap_method_attr_index, Symbol name, Symbol descriptor);
+
+    // Attempts to symbolicate a dynamically-computed constant or call site, given its index into the parsed constant pool
+    static ErrorOr<NonnullRefPtr<SymbolicatedDynamicReference>> create(u16 index, SymbolicatedConstantPool* symbolicated_pool);
+
+    // Used for debugging
+    ErrorOr<AK::String> debug_description();
+
+    // An index into the bootstrap_methods array of the BootstrapMethods attribute of this class
+    u16 bootstrap_method_attr_index() { return m_bootstrap_method_attr_index; };
+
+    // The unqualified name of this constant or call site
+    Symbol const& name() { return m_name; };
+
+    // A field descriptor for dynamically-computed constants, or a method descriptor for call sites
+    Symbol const& descriptor() { return m_descriptor; };
+
+private:
+    u16 m_bootstrap_method_attr_index;
+    Symbol m_name;
+    Symbol m_descriptor;
+};
+
+// A string constant is a reference to an instance of class String, derived from a CONSTANT_String_info structure
+class SymbolicatedStringReference : public SymbolicatedReference {
+public:
+    SymbolicatedStringReference(u16 index, Symbol value);
+
+    // Attempts to symbolicate a string constant, given its index into the parsed constant pool
+    static ErrorOr<NonnullRefPtr<SymbolicatedStringReference>> create(u16 index, SymbolicatedConstantPool* symbolicated_pool);
+
+    // Used for debugging
+    ErrorOr<AK::String> debug_description();
+
+    // The sequence of Unicode code points given by the CONSTANT_Utf8_info structure
+    Symbol const& value() { return m_value; };
+
+private:
+    Symbol m_value;
+};
+
+// Numeric constants are derived from CONSTANT_Integer_info, CONSTANT_Float_info, CONSTANT_Long_info and CONSTANT_Double_info structures
+class SymbolicatedNumericReference : public SymbolicatedReference {
+public:
+    SymbolicatedNumericReference(u16 index, Constant::Tag tag, u64 bits);
+
+    // Attempts to symbolicate a numeric constant, given its index into the parsed constant pool
+    static ErrorOr<NonnullRefPtr<SymbolicatedNumericReference>> create(u16 index, SymbolicatedConstantPool* symbolicated_pool);
+
+    // Used for debugging
+    ErrorOr<AK::String> debug_description();
+
+    // Integer, Float, Long or Double
+    Constant::Tag tag() { return m_tag; };
+
+    // Long and Double constants take up two slots on the operand stack and in local variables
+    bool is_category_2() { return m_tag == Constant::Tag::Long || m_tag == Constant::Tag::Double; };
+
+    // The raw bits of the constant, interpret them according to `tag()`
+    u64 bits() { return m_bits; };
+
+    i32 as_int() { return static_cast<i32>(m_bits); };
+    float as_float() { return bit_cast<float>(static_cast<u32>(m_bits)); };
+    i64 as_long() { return static_cast<i64>(m_bits); };
+    double as_double() { return bit_cast<double>(m_bits); };
+
+private:
+    Constant::Tag m_tag;
+    u64 m_bits;
+};
+
 }
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "InstructionStream.h"
+#include <AK/Types.h>
+
+namespace Interpreter {
+
+// Decides how each method is executed, from the profile that the interpreter keeps in every method's InstructionStream.
+//
+// A method moves through the same tiers as it gets hotter:
+// 1. The first time that it's invoked, its bytecode is translated into an InstructionStream.
+// 2. It's interpreted, and each instruction is quickened the first time that it's executed.
+// 3. Once it's hot, the baseline JIT compiles it (see JIT::BaselineCompiler), either when it's next invoked, or when one of its loops branches backwards.
+//    In a loop, the frame carries on executing in the compiled code from the loop's header, without waiting for the method to return (on-stack replacement).
+// 4. Once it's even hotter, the optimizing JIT compiles it again (see JIT::OptimizingCompiler), either when it's next invoked, or when one of the baseline code's loops branches backwards.
+//    The baseline code counts its own back-edges, and hands the frame over at the loop's header (see JIT::ExitReason::TierUp), so that it carries on in the optimized code.
+//    Optimized code that keeps deoptimizing is thrown away, and the method is never optimized again.
+//
+// The interpreter counts every invocation and every back-edge, whether the JIT is enabled or not, so the profile can be used to tune the thresholds for a workload.
+class TieringPolicy {
+public:
+    static constexpr u64 default_invocation_threshold = 1000;
+    static constexpr u64 default_backedge_threshold = 10000;
+    static constexpr u64 default_optimization_invocation_threshold = 10000;
+    static constexpr u64 default_optimization_backedge_threshold = 100000;
+
+    // Compiled code which keeps deoptimizing is thrown away, so that the method can be compiled again once the instructions that it stopped at have been quickened.
+    // A method which has been compiled too many times is only interpreted from then on.
+    static constexpr u32 deoptimization_limit = 8;
+    static constexpr u32 compilation_limit = 4;
+
+    u64 invocation_threshold() const { return m_invocation_threshold; };
+    void set_invocation_threshold(u64 threshold) { m_invocation_threshold = threshold; };
+
+    u64 backedge_threshold() const { return m_backedge_threshold; };
+    void set_backedge_threshold(u64 threshold) { m_backedge_threshold = threshold; };
+
+    u64 optimization_invocation_threshold() const { return m_optimization_invocation_threshold; };
+    void set_optimization_invocation_threshold(u64 threshold) { m_optimization_invocation_threshold = threshold; };
+
+    u64 optimization_backedge_threshold() const { return m_optimization_backedge_threshold; };
+    void set_optimization_backedge_threshold(u64 threshold) { m_optimization_backedge_threshold = threshold; };
+
+    // Without the optimizing JIT, hot methods stay in baseline code
+    bool is_optimization_enabled() const { return m_optimization_enabled; };
+    void set_optimization_enabled(bool enabled) { m_optimization_enabled = enabled; };
+
+    // When the method is invoked: once it has been invoked often enough, or all of its loops together have branched backwards often enough
+    bool should_compile(InstructionStream const& instruction_stream) const
+    {
+        return instruction_stream.is_compilable()
+            && (instruction_stream.invocation_count() >= m_invocation_threshold || instruction_stream.backedge_count() >= m_backedge_threshold);
+    }
+
+    // When a loop branches backwards: once the loop by itself has branched backwards often enough
+    bool should_replace_on_stack(InstructionStream const& instruction_stream, u64 loop_backedge_count) const
+    {
+        return loop_backedge_count >= m_backedge_threshold && instruction_stream.is_compilable();
+    }
+
+    // When the method is invoked with baseline code: the same as should_compile(), but with the optimization thresholds.
+    // A loop of baseline code checks its own threshold, see JIT::BaselineCompiler.
+    bool should_optimize(InstructionStream& instruction_stream) const
+    {
+        auto* compiled_code = instruction_stream.compiled_code();
+        return m_optimization_enabled && instruction_stream.is_optimizable() && compiled_code && compiled_code->tier() == JIT::CompiledCode::Tier::Baseline
+            && (instruction_stream.invocation_count() >= m_optimization_invocation_threshold || instruction_stream.backedge_count() >= m_optimization_backedge_threshold);
+    }
+
+private:
+    u64 m_invocation_threshold { default_invocation_threshold };
+    u64 m_backedge_threshold { default_backedge_threshold };
+    u64 m_optimization_invocation_threshold { default_optimization_invocation_threshold };
+    u64 m_optimization_backedge_threshold { default_optimization_backedge_threshold };
+    bool m_optimization_enabled { true };
+};
+
+}
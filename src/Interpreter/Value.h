@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/BitCast.h>
+#include <AK/Types.h>
+
+namespace Interpreter {
+
+// Forward-declaration
+class Object;
+
+// A single slot in a local variable array or operand stack.
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-2.html#jvms-2.6.1
+//
+// Every slot is 8 bytes wide, so a value of any type can be stored in a single slot.
+// Long and double values still take up two slots, as the class file's indices (and max_locals / max_stack) expect them to.
+// The value is stored in the first slot, and the second slot is left unused.
+class Value {
+public:
+    constexpr Value() = default;
+
+    static Value from_int(i32 value) { return Value(static_cast<u64>(static_cast<i64>(value))); };
+    static Value from_long(i64 value) { return Value(static_cast<u64>(value)); };
+    static Value from_float(float value) { return Value(bit_cast<u32>(value)); };
+    static Value from_double(double value) { return Value(bit_cast<u64>(value)); };
+    static Value from_reference(Object* value) { return Value(bit_cast<FlatPtr>(value)); };
+    static Value from_bits(u64 bits) { return Value(bits); };
+
+    i32 as_int() const { return static_cast<i32>(m_bits); };
+    i64 as_long() const { return static_cast<i64>(m_bits); };
+    float as_float() const { return bit_cast<float>(static_cast<u32>(m_bits)); };
+    double as_double() const { return bit_cast<double>(m_bits); };
+    Object* as_reference() const { return bit_cast<Object*>(static_cast<FlatPtr>(m_bits)); };
+
+    u64 bits() const { return m_bits; };
+
+private:
+    explicit constexpr Value(u64 bits)
+        : m_bits(bits)
+    {
+    }
+
+    u64 m_bits { 0 };
+};
+
+static_assert(sizeof(Value) == 8);
+
+}
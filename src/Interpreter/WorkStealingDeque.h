@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Noncopyable.h>
+#include <AK/Optional.h>
+#include <AK/Vector.h>
+
+namespace Interpreter {
+
+// A Chase-Lev work-stealing deque, as described in "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al.)
+// https://www.di.ens.fr/~zappa/readings/ppopp13.pdf
+//
+// The thread that owns the deque pushes and pops at its bottom, like a stack, which only needs a compare-and-swap when taking the last element.
+// Any other thread can steal from its top, so an idle thread takes the oldest work, which tends to be the work that leads to the most further work.
+template<typename T>
+class WorkStealingDeque {
+    AK_MAKE_NONCOPYABLE(WorkStealingDeque);
+    AK_MAKE_NONMOVABLE(WorkStealingDeque);
+
+public:
+    static constexpr size_t initial_capacity = 1024;
+
+    WorkStealingDeque() = default;
+
+    // Only called by the owner, the deque grows when it's full, which is the only way that this can fail
+    ErrorOr<void> push(T value)
+    {
+        auto bottom = m_bottom.load(AK::MemoryOrder::memory_order_relaxed);
+        auto top = m_top.load(AK::MemoryOrder::memory_order_acquire);
+        auto* buffer = m_buffer.load(AK::MemoryOrder::memory_order_relaxed);
+        if (!buffer || bottom - top >= static_cast<i64>(buffer->capacity()))
+            buffer = TRY(grow(top, bottom));
+
+        buffer->store(bottom, value);
+        AK::atomic_thread_fence(AK::MemoryOrder::memory_order_release);
+        m_bottom.store(bottom + 1, AK::MemoryOrder::memory_order_relaxed);
+
+        return {};
+    }
+
+    // Only called by the owner, takes the most recently pushed element
+    Optional<T> pop()
+    {
+        auto bottom = m_bottom.load(AK::MemoryOrder::memory_order_relaxed) - 1;
+        auto* buffer = m_buffer.load(AK::MemoryOrder::memory_order_relaxed);
+        m_bottom.store(bottom, AK::MemoryOrder::memory_order_relaxed);
+        AK::atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+
+        auto top = m_top.load(AK::MemoryOrder::memory_order_relaxed);
+        if (top > bottom) {
+            m_bottom.store(bottom + 1, AK::MemoryOrder::memory_order_relaxed);
+            return {};
+        }
+
+        auto value = buffer->load(bottom);
+        if (top == bottom) {
+            // This is the last element, which a thief could be taking at the same time
+            auto taken = m_top.compare_exchange_strong(top, top + 1, AK::MemoryOrder::memory_order_seq_cst);
+            m_bottom.store(bottom + 1, AK::MemoryOrder::memory_order_relaxed);
+            if (!taken)
+                return {};
+        }
+
+        return value;
+    }
+
+    // Called by any thread, takes the oldest element. This can also fail if another thread took the same element first.
+    Optional<T> steal()
+    {
+        auto top = m_top.load(AK::MemoryOrder::memory_order_acquire);
+        AK::atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+        auto bottom = m_bottom.load(AK::MemoryOrder::memory_order_acquire);
+        if (top >= bottom)
+            return {};
+
+        auto* buffer = m_buffer.load(AK::MemoryOrder::memory_order_acquire);
+        auto value = buffer->load(top);
+        if (!m_top.compare_exchange_strong(top, top + 1, AK::MemoryOrder::memory_order_seq_cst))
+            return {};
+
+        return value;
+    }
+
+    // Only a hint when other threads are using the deque, as it can change straight afterwards
+    bool is_empty() const { return m_bottom.load(AK::MemoryOrder::memory_order_relaxed) <= m_top.load(AK::MemoryOrder::memory_order_relaxed); };
+
+private:
+    // A circular buffer, indexed by the (ever-increasing) top and bottom of the deque
+    class Buffer {
+    public:
+        size_t capacity() const { return m_elements.size(); };
+
+        // Elements are read by thieves while the owner writes to other elements, so every access is atomic
+        T load(i64 index) { return AK::atomic_load(&m_elements[index & (capacity() - 1)], AK::MemoryOrder::memory_order_relaxed); };
+        void store(i64 index, T value) { AK::atomic_store(&m_elements[index & (capacity() - 1)], value, AK::MemoryOrder::memory_order_relaxed); };
+
+    private:
+        friend class WorkStealingDeque;
+
+        // The size is always a power of two
+        Vector<T> m_elements;
+    };
+
+    ErrorOr<Buffer*> grow(i64 top, i64 bottom)
+    {
+        auto* old_buffer = m_buffer.load(AK::MemoryOrder::memory_order_relaxed);
+
+        auto new_buffer = TRY(try_make<Buffer>());
+        TRY(new_buffer->m_elements.try_resize(old_buffer ? old_buffer->capacity() * 2 : initial_capacity));
+        for (auto index = top; index < bottom; index++)
+            new_buffer->store(index, old_buffer->load(index));
+
+        auto* buffer = new_buffer.ptr();
+        TRY(m_buffers.try_append(move(new_buffer)));
+        m_buffer.store(buffer, AK::MemoryOrder::memory_order_release);
+
+        return buffer;
+    }
+
+    Atomic<i64> m_top { 0 };
+    Atomic<i64> m_bottom { 0 };
+    Atomic<Buffer*> m_buffer { nullptr };
+
+    // Every buffer that the deque has had, a thief might still be reading from an old one after it has grown
+    Vector<NonnullOwnPtr<Buffer>> m_buffers;
+};
+
+}
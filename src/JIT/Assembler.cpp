@@ -0,0 +1,471 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Assembler.h"
+
+namespace JIT {
+
+static bool fits_in_i8(i64 value)
+{
+    return value >= -128 && value <= 127;
+}
+
+static bool fits_in_i32(i64 value)
+{
+    return value >= -2147483648LL && value <= 2147483647LL;
+}
+
+void Assembler::emit16(u16 value)
+{
+    emit8(value & 0xFF);
+    emit8(value >> 8);
+}
+
+void Assembler::emit32(u32 value)
+{
+    for (size_t i = 0; i < 4; i++)
+        emit8((value >> (i * 8)) & 0xFF);
+}
+
+void Assembler::emit64(u64 value)
+{
+    for (size_t i = 0; i < 8; i++)
+        emit8((value >> (i * 8)) & 0xFF);
+}
+
+void Assembler::emit_label_reference(Label& target)
+{
+    // Relative to the end of the field, which is the end of every instruction that refers to a label
+    m_label_references.append(LabelReference { .position = m_code.size(), .target = &target, .origin_label = nullptr, .origin = m_code.size() + 4 });
+    emit32(0);
+}
+
+void Assembler::emit_instruction(OperandSize size, u8 prefix, std::initializer_list<u8> opcode, u8 reg, Address const& rm)
+{
+    auto base = to_underlying(rm.base);
+    auto index = rm.index.has_value() ? to_underlying(*rm.index) : 0;
+
+    // rsp can't be an index, its encoding means that there isn't one
+    VERIFY(!rm.index.has_value() || *rm.index != Register::RSP);
+
+    if (prefix != 0)
+        emit8(prefix);
+    else if (size == OperandSize::Word)
+        emit8(0x66);
+
+    // Byte instructions always have a REX prefix, so that registers 4-7 are spl, bpl, sil and dil (instead of ah, ch, dh and bh)
+    u8 rex = 0x40 | (size == OperandSize::QuadWord ? 0x08 : 0) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3);
+    if (rex != 0x40 || size == OperandSize::Byte)
+        emit8(rex);
+
+    for (auto byte : opcode)
+        emit8(byte);
+
+    // A base of rsp or r12 needs a SIB byte, and a base of rbp or r13 always needs a displacement
+    auto needs_sib = rm.index.has_value() || (base & 7) == 4;
+    u8 mod = 2;
+    if (rm.displacement == 0 && (base & 7) != 5)
+        mod = 0;
+    else if (fits_in_i8(rm.displacement))
+        mod = 1;
+
+    emit8((mod << 6) | ((reg & 7) << 3) | (needs_sib ? 4 : (base & 7)));
+
+    if (needs_sib) {
+        u8 scale_bits = 0;
+        switch (rm.scale) {
+        case 1:
+            scale_bits = 0;
+            break;
+        case 2:
+            scale_bits = 1;
+            break;
+        case 4:
+            scale_bits = 2;
+            break;
+        case 8:
+            scale_bits = 3;
+            break;
+        default:
+            VERIFY_NOT_REACHED();
+        }
+
+        emit8((scale_bits << 6) | ((rm.index.has_value() ? (index & 7) : 4) << 3) | (base & 7));
+    }
+
+    if (mod == 1)
+        emit8(static_cast<u8>(rm.displacement));
+    else if (mod == 2)
+        emit32(static_cast<u32>(rm.displacement));
+}
+
+void Assembler::emit_instruction(OperandSize size, u8 prefix, std::initializer_list<u8> opcode, u8 reg, Register rm)
+{
+    auto rm_index = to_underlying(rm);
+
+    if (prefix != 0)
+        emit8(prefix);
+    else if (size == OperandSize::Word)
+        emit8(0x66);
+
+    u8 rex = 0x40 | (size == OperandSize::QuadWord ? 0x08 : 0) | ((reg >> 3) << 2) | (rm_index >> 3);
+    if (rex != 0x40 || size == OperandSize::Byte)
+        emit8(rex);
+
+    for (auto byte : opcode)
+        emit8(byte);
+
+    emit8(0xC0 | ((reg & 7) << 3) | (rm_index & 7));
+}
+
+void Assembler::mov(OperandSize size, Register destination, Register source)
+{
+    emit_instruction(size, 0, { static_cast<u8>(size == OperandSize::Byte ? 0x8A : 0x8B) }, to_underlying(destination), source);
+}
+
+void Assembler::mov(OperandSize size, Register destination, Address const& source)
+{
+    emit_instruction(size, 0, { static_cast<u8>(size == OperandSize::Byte ? 0x8A : 0x8B) }, to_underlying(destination), source);
+}
+
+void Assembler::mov(OperandSize size, Address const& destination, Register source)
+{
+    emit_instruction(size, 0, { static_cast<u8>(size == OperandSize::Byte ? 0x88 : 0x89) }, to_underlying(source), destination);
+}
+
+void Assembler::mov(OperandSize size, Address const& destination, i32 immediate)
+{
+    emit_instruction(size, 0, { static_cast<u8>(size == OperandSize::Byte ? 0xC6 : 0xC7) }, 0, destination);
+
+    // A 64-bit store sign-extends its 32-bit immediate
+    if (size == OperandSize::Byte)
+        emit8(static_cast<u8>(immediate));
+    else if (size == OperandSize::Word)
+        emit16(static_cast<u16>(immediate));
+    else
+        emit32(static_cast<u32>(immediate));
+}
+
+void Assembler::mov(Register destination, u64 immediate)
+{
+    auto index = to_underlying(destination);
+
+    // A 32-bit move zero-extends, and a 64-bit move of a 32-bit immediate sign-extends it
+    if (immediate <= 0xFFFFFFFF) {
+        if (index >= 8)
+            emit8(0x41);
+        emit8(0xB8 + (index & 7));
+        emit32(static_cast<u32>(immediate));
+        return;
+    }
+
+    if (fits_in_i32(static_cast<i64>(immediate))) {
+        emit_instruction(OperandSize::QuadWord, 0, { 0xC7 }, 0, destination);
+        emit32(static_cast<u32>(immediate));
+        return;
+    }
+
+    emit8(0x48 | (index >> 3));
+    emit8(0xB8 + (index & 7));
+    emit64(immediate);
+}
+
+static u8 sign_extension_opcode(OperandSize source_size)
+{
+    switch (source_size) {
+    case OperandSize::Byte:
+        return 0xBE;
+    case OperandSize::Word:
+        return 0xBF;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+void Assembler::movsx(OperandSize source_size, Register destination, Register source)
+{
+    if (source_size == OperandSize::DoubleWord) {
+        emit_instruction(OperandSize::QuadWord, 0, { 0x63 }, to_underlying(destination), source);
+        return;
+    }
+
+    emit_instruction(OperandSize::QuadWord, 0, { 0x0F, sign_extension_opcode(source_size) }, to_underlying(destination), source);
+}
+
+void Assembler::movsx(OperandSize source_size, Register destination, Address const& source)
+{
+    if (source_size == OperandSize::DoubleWord) {
+        emit_instruction(OperandSize::QuadWord, 0, { 0x63 }, to_underlying(destination), source);
+        return;
+    }
+
+    emit_instruction(OperandSize::QuadWord, 0, { 0x0F, sign_extension_opcode(source_size) }, to_underlying(destination), source);
+}
+
+void Assembler::movzx(OperandSize source_size, Register destination, Register source)
+{
+    VERIFY(source_size == OperandSize::Byte || source_size == OperandSize::Word);
+    emit_instruction(OperandSize::DoubleWord, 0, { 0x0F, static_cast<u8>(source_size == OperandSize::Byte ? 0xB6 : 0xB7) }, to_underlying(destination), source);
+}
+
+void Assembler::movzx(OperandSize source_size, Register destination, Address const& source)
+{
+    VERIFY(source_size == OperandSize::Byte || source_size == OperandSize::Word);
+    emit_instruction(OperandSize::DoubleWord, 0, { 0x0F, static_cast<u8>(source_size == OperandSize::Byte ? 0xB6 : 0xB7) }, to_underlying(destination), source);
+}
+
+void Assembler::lea(Register destination, Address const& source)
+{
+    emit_instruction(OperandSize::QuadWord, 0, { 0x8D }, to_underlying(destination), source);
+}
+
+void Assembler::lea(Register destination, Label& label)
+{
+    auto index = to_underlying(destination);
+    emit8(0x48 | ((index >> 3) << 2));
+    emit8(0x8D);
+
+    // A ModRM with mod 00 and rm 101 is relative to the instruction pointer in 64-bit mode
+    emit8(((index & 7) << 3) | 0x05);
+    emit_label_reference(label);
+}
+
+void Assembler::arithmetic(ArithmeticOperation operation, OperandSize size, Register destination, Register source)
+{
+    auto opcode = static_cast<u8>((to_underlying(operation) << 3) | (size == OperandSize::Byte ? 0x02 : 0x03));
+    emit_instruction(size, 0, { opcode }, to_underlying(destination), source);
+}
+
+void Assembler::arithmetic(ArithmeticOperation operation, OperandSize size, Register destination, Address const& source)
+{
+    auto opcode = static_cast<u8>((to_underlying(operation) << 3) | (size == OperandSize::Byte ? 0x02 : 0x03));
+    emit_instruction(size, 0, { opcode }, to_underlying(destination), source);
+}
+
+void Assembler::arithmetic(ArithmeticOperation operation, OperandSize size, Address const& destination, Register source)
+{
+    auto opcode = static_cast<u8>((to_underlying(operation) << 3) | (size == OperandSize::Byte ? 0x00 : 0x01));
+    emit_instruction(size, 0, { opcode }, to_underlying(source), destination);
+}
+
+// Every form with an immediate shares the same opcodes, the operation is the ModRM's opcode extension
+static u8 arithmetic_immediate_opcode(OperandSize size, i32 immediate)
+{
+    if (size == OperandSize::Byte)
+        return 0x80;
+
+    return fits_in_i8(immediate) ? 0x83 : 0x81;
+}
+
+void Assembler::emit_arithmetic_immediate(OperandSize size, i32 immediate)
+{
+    if (size == OperandSize::Byte || fits_in_i8(immediate))
+        emit8(static_cast<u8>(immediate));
+    else if (size == OperandSize::Word)
+        emit16(static_cast<u16>(immediate));
+    else
+        emit32(static_cast<u32>(immediate));
+}
+
+void Assembler::arithmetic(ArithmeticOperation operation, OperandSize size, Register destination, i32 immediate)
+{
+    emit_instruction(size, 0, { arithmetic_immediate_opcode(size, immediate) }, to_underlying(operation), destination);
+    emit_arithmetic_immediate(size, immediate);
+}
+
+void Assembler::arithmetic(ArithmeticOperation operation, OperandSize size, Address const& destination, i32 immediate)
+{
+    emit_instruction(size, 0, { arithmetic_immediate_opcode(size, immediate) }, to_underlying(operation), destination);
+    emit_arithmetic_immediate(size, immediate);
+}
+
+void Assembler::test(OperandSize size, Register a, Register b)
+{
+    emit_instruction(size, 0, { static_cast<u8>(size == OperandSize::Byte ? 0x84 : 0x85) }, to_underlying(b), a);
+}
+
+void Assembler::imul(OperandSize size, Register destination, Register source)
+{
+    VERIFY(size == OperandSize::DoubleWord || size == OperandSize::QuadWord);
+    emit_instruction(size, 0, { 0x0F, 0xAF }, to_underlying(destination), source);
+}
+
+void Assembler::imul(OperandSize size, Register destination, Address const& source)
+{
+    VERIFY(size == OperandSize::DoubleWord || size == OperandSize::QuadWord);
+    emit_instruction(size, 0, { 0x0F, 0xAF }, to_underlying(destination), source);
+}
+
+void Assembler::neg(OperandSize size, Register reg)
+{
+    emit_instruction(size, 0, { static_cast<u8>(size == OperandSize::Byte ? 0xF6 : 0xF7) }, 3, reg);
+}
+
+void Assembler::shift(ShiftOperation operation, OperandSize size, Register reg, u8 count)
+{
+    emit_instruction(size, 0, { static_cast<u8>(size == OperandSize::Byte ? 0xC0 : 0xC1) }, to_underlying(operation), reg);
+    emit8(count);
+}
+
+void Assembler::shift_by_cl(ShiftOperation operation, OperandSize size, Register reg)
+{
+    emit_instruction(size, 0, { static_cast<u8>(size == OperandSize::Byte ? 0xD2 : 0xD3) }, to_underlying(operation), reg);
+}
+
+void Assembler::sign_extend_accumulator(OperandSize size)
+{
+    VERIFY(size == OperandSize::DoubleWord || size == OperandSize::QuadWord);
+    if (size == OperandSize::QuadWord)
+        emit8(0x48);
+    emit8(0x99);
+}
+
+void Assembler::idiv(OperandSize size, Register divisor)
+{
+    emit_instruction(size, 0, { static_cast<u8>(size == OperandSize::Byte ? 0xF6 : 0xF7) }, 7, divisor);
+}
+
+void Assembler::set(Condition condition, Register destination)
+{
+    emit_instruction(OperandSize::Byte, 0, { 0x0F, static_cast<u8>(0x90 + to_underlying(condition)) }, 0, destination);
+}
+
+// movss/addss/... use 0xF3, and movsd/addsd/... use 0xF2
+static u8 float_prefix(OperandSize size)
+{
+    VERIFY(size == OperandSize::DoubleWord || size == OperandSize::QuadWord);
+    return size == OperandSize::DoubleWord ? 0xF3 : 0xF2;
+}
+
+// An SSE register in the r/m field of ModRM is encoded just like a general purpose register with the same number
+static Register as_register(FloatRegister reg)
+{
+    return static_cast<Register>(to_underlying(reg));
+}
+
+void Assembler::float_operation(FloatOperation operation, OperandSize size, FloatRegister destination, FloatRegister source)
+{
+    emit_instruction(OperandSize::DoubleWord, float_prefix(size), { 0x0F, to_underlying(operation) }, to_underlying(destination), as_register(source));
+}
+
+void Assembler::float_operation(FloatOperation operation, OperandSize size, FloatRegister destination, Address const& source)
+{
+    emit_instruction(OperandSize::DoubleWord, float_prefix(size), { 0x0F, to_underlying(operation) }, to_underlying(destination), source);
+}
+
+void Assembler::float_store(OperandSize size, Address const& destination, FloatRegister source)
+{
+    emit_instruction(OperandSize::DoubleWord, float_prefix(size), { 0x0F, 0x11 }, to_underlying(source), destination);
+}
+
+void Assembler::float_to_bits(OperandSize size, Register destination, FloatRegister source)
+{
+    // movd or movq, a 32-bit destination is zero-extended like any other
+    emit_instruction(size, 0x66, { 0x0F, 0x7E }, to_underlying(source), destination);
+}
+
+void Assembler::bits_to_float(OperandSize size, FloatRegister destination, Register source)
+{
+    // movd or movq, the rest of the SSE register is cleared
+    emit_instruction(size, 0x66, { 0x0F, 0x6E }, to_underlying(destination), source);
+}
+
+void Assembler::integer_to_float(OperandSize float_size, OperandSize integer_size, FloatRegister destination, Register source)
+{
+    emit_instruction(integer_size, float_prefix(float_size), { 0x0F, 0x2A }, to_underlying(destination), source);
+}
+
+void Assembler::integer_to_float(OperandSize float_size, OperandSize integer_size, FloatRegister destination, Address const& source)
+{
+    // cvtsi2ss or cvtsi2sd, REX.W makes the source a 64-bit integer
+    emit_instruction(integer_size, float_prefix(float_size), { 0x0F, 0x2A }, to_underlying(destination), source);
+}
+
+void Assembler::float_to_float(OperandSize source_size, FloatRegister destination, FloatRegister source)
+{
+    emit_instruction(OperandSize::DoubleWord, float_prefix(source_size), { 0x0F, 0x5A }, to_underlying(destination), as_register(source));
+}
+
+void Assembler::float_to_float(OperandSize source_size, FloatRegister destination, Address const& source)
+{
+    // cvtss2sd or cvtsd2ss
+    emit_instruction(OperandSize::DoubleWord, float_prefix(source_size), { 0x0F, 0x5A }, to_underlying(destination), source);
+}
+
+void Assembler::bind(Label& label)
+{
+    VERIFY(!label.is_bound());
+    label.m_offset = m_code.size();
+}
+
+void Assembler::jump(Label& label)
+{
+    emit8(0xE9);
+    emit_label_reference(label);
+}
+
+void Assembler::jump(Condition condition, Label& label)
+{
+    emit8(0x0F);
+    emit8(0x80 + to_underlying(condition));
+    emit_label_reference(label);
+}
+
+void Assembler::jump(Register target)
+{
+    emit_instruction(OperandSize::DoubleWord, 0, { 0xFF }, 4, target);
+}
+
+void Assembler::call(Register target)
+{
+    emit_instruction(OperandSize::DoubleWord, 0, { 0xFF }, 2, target);
+}
+
+void Assembler::push(Register reg)
+{
+    auto index = to_underlying(reg);
+    if (index >= 8)
+        emit8(0x41);
+    emit8(0x50 + (index & 7));
+}
+
+void Assembler::pop(Register reg)
+{
+    auto index = to_underlying(reg);
+    if (index >= 8)
+        emit8(0x41);
+    emit8(0x58 + (index & 7));
+}
+
+void Assembler::ret()
+{
+    emit8(0xC3);
+}
+
+void Assembler::jump_table_entry(Label& table, Label& target)
+{
+    m_label_references.append(LabelReference { .position = m_code.size(), .target = &target, .origin_label = &table, .origin = 0 });
+    emit32(0);
+}
+
+ReadonlyBytes Assembler::finalize()
+{
+    for (auto const& reference : m_label_references) {
+        VERIFY(reference.target->is_bound());
+        auto origin = reference.origin_label ? *reference.origin_label->m_offset : reference.origin;
+        auto displacement = static_cast<i64>(*reference.target->m_offset) - static_cast<i64>(origin);
+        VERIFY(fits_in_i32(displacement));
+
+        auto value = static_cast<u32>(static_cast<i32>(displacement));
+        for (size_t i = 0; i < 4; i++)
+            m_code[reference.position + i] = (value >> (i * 8)) & 0xFF;
+    }
+
+    m_label_references.clear();
+    return m_code.span();
+}
+
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/Span.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+#include <initializer_list>
+
+namespace JIT {
+
+// The general purpose registers, in the order that they are encoded
+enum class Register : u8 {
+    RAX,
+    RCX,
+    RDX,
+    RBX,
+    RSP,
+    RBP,
+    RSI,
+    RDI,
+    R8,
+    R9,
+    R10,
+    R11,
+    R12,
+    R13,
+    R14,
+    R15,
+};
+
+// Compiled code only ever needs a couple of SSE registers at once
+enum class FloatRegister : u8 {
+    XMM0,
+    XMM1,
+};
+
+// The size of an operand in bytes. For floating point instructions, DoubleWord is a float and QuadWord is a double.
+enum class OperandSize : u8 {
+    Byte = 1,
+    Word = 2,
+    DoubleWord = 4,
+    QuadWord = 8,
+};
+
+// The condition codes of jcc and setcc, as they are encoded
+enum class Condition : u8 {
+    Overflow = 0x0,
+    NotOverflow = 0x1,
+    Below = 0x2,
+    AboveOrEqual = 0x3,
+    Equal = 0x4,
+    NotEqual = 0x5,
+    BelowOrEqual = 0x6,
+    Above = 0x7,
+    Sign = 0x8,
+    NotSign = 0x9,
+    Parity = 0xA,
+    NotParity = 0xB,
+    Less = 0xC,
+    GreaterOrEqual = 0xD,
+    LessOrEqual = 0xE,
+    Greater = 0xF,
+};
+
+// A memory operand, `[base + index * scale + displacement]`
+struct Address {
+    Register base;
+    i32 displacement { 0 };
+    Optional<Register> index {};
+    u8 scale { 1 };
+};
+
+// A position in the code, which can be referred to before it's known where it is
+class Label {
+public:
+    bool is_bound() const { return m_offset.has_value(); };
+
+    // Where the label is bound, from the start of the code
+    size_t offset() const { return m_offset.value(); };
+
+private:
+    friend class Assembler;
+
+    Optional<size_t> m_offset;
+};
+
+// Encodes x86-64 instructions into a buffer.
+// https://www.intel.com/content/www/us/en/developer/articles/technical/intel-sdm.html
+//
+// Only the instructions that the JIT's compilers need are here, and each one always uses the same encoding, e.g. every jump has a 32-bit displacement.
+// Jumps to labels which haven't been bound yet are patched by finalize(), so the code is position-independent and can be copied anywhere.
+class Assembler {
+public:
+    enum class ArithmeticOperation : u8 {
+        Add = 0,
+        Or = 1,
+        And = 4,
+        Subtract = 5,
+        Xor = 6,
+        Compare = 7,
+    };
+
+    enum class ShiftOperation : u8 {
+        Left = 4,
+        LogicalRight = 5,
+        ArithmeticRight = 7,
+    };
+
+    enum class FloatOperation : u8 {
+        Load = 0x10,
+        Add = 0x58,
+        Multiply = 0x59,
+        Subtract = 0x5C,
+        Divide = 0x5E,
+    };
+
+    // Moves, a 32-bit destination register is zero-extended to 64 bits
+    void mov(OperandSize, Register destination, Register source);
+    void mov(OperandSize, Register destination, Address const& source);
+    void mov(OperandSize, Address const& destination, Register source);
+    void mov(OperandSize, Address const& destination, i32 immediate);
+
+    // Uses the shortest encoding for the value
+    void mov(Register destination, u64 immediate);
+
+    // These always extend to 64 bits
+    void movsx(OperandSize source_size, Register destination, Register source);
+    void movsx(OperandSize source_size, Register destination, Address const& source);
+    void movzx(OperandSize source_size, Register destination, Register source);
+    void movzx(OperandSize source_size, Register destination, Address const& source);
+
+    void lea(Register destination, Address const& source);
+
+    // The address of a label, relative to the instruction pointer
+    void lea(Register destination, Label& label);
+
+    // Integer arithmetic
+    void arithmetic(ArithmeticOperation, OperandSize, Register destination, Register source);
+    void arithmetic(ArithmeticOperation, OperandSize, Register destination, Address const& source);
+    void arithmetic(ArithmeticOperation, OperandSize, Address const& destination, Register source);
+    void arithmetic(ArithmeticOperation, OperandSize, Register destination, i32 immediate);
+    void arithmetic(ArithmeticOperation, OperandSize, Address const& destination, i32 immediate);
+    void test(OperandSize, Register, Register);
+    void imul(OperandSize, Register destination, Register source);
+    void imul(OperandSize, Register destination, Address const& source);
+    void neg(OperandSize, Register);
+    void shift(ShiftOperation, OperandSize, Register, u8 count);
+    void shift_by_cl(ShiftOperation, OperandSize, Register);
+
+    // cdq or cqo, which sign-extend the accumulator into rdx for idiv
+    void sign_extend_accumulator(OperandSize);
+    void idiv(OperandSize, Register divisor);
+
+    // Sets the lowest byte of the register to 1 if the condition holds, or 0 if it doesn't
+    void set(Condition, Register destination);
+
+    // Floating point arithmetic, on the lowest element of an SSE register
+    void float_operation(FloatOperation, OperandSize, FloatRegister destination, FloatRegister source);
+    void float_operation(FloatOperation, OperandSize, FloatRegister destination, Address const& source);
+    void float_store(OperandSize, Address const& destination, FloatRegister source);
+    void float_to_bits(OperandSize, Register destination, FloatRegister source);
+    void bits_to_float(OperandSize, FloatRegister destination, Register source);
+    void integer_to_float(OperandSize float_size, OperandSize integer_size, FloatRegister destination, Register source);
+    void integer_to_float(OperandSize float_size, OperandSize integer_size, FloatRegister destination, Address const& source);
+    void float_to_float(OperandSize source_size, FloatRegister destination, FloatRegister source);
+    void float_to_float(OperandSize source_size, FloatRegister destination, Address const& source);
+
+    // Control flow
+    void bind(Label&);
+    void jump(Label&);
+    void jump(Condition, Label&);
+    void jump(Register);
+    void call(Register);
+    void push(Register);
+    void pop(Register);
+    void ret();
+
+    // A 32-bit entry of a jump table: the offset of the target from the start of the table
+    void jump_table_entry(Label& table, Label& target);
+
+    size_t size() const { return m_code.size(); };
+
+    // Fills in every reference to a label, every label that has been referred to must have been bound
+    ReadonlyBytes finalize();
+
+private:
+    // A 32-bit field which holds `target - origin`, where the origin is either a fixed offset or another label
+    struct LabelReference {
+        size_t position { 0 };
+        Label* target { nullptr };
+        Label* origin_label { nullptr };
+        size_t origin { 0 };
+    };
+
+    void emit8(u8 value) { m_code.append(value); };
+    void emit16(u16 value);
+    void emit32(u32 value);
+    void emit64(u64 value);
+    void emit_label_reference(Label& target);
+    void emit_arithmetic_immediate(OperandSize, i32 immediate);
+
+    // Emits the prefixes, opcode and ModRM (and SIB and displacement) of an instruction.
+    // The size picks between byte registers, the operand-size prefix, and REX.W, and `prefix` is the mandatory prefix of SSE instructions (or 0).
+    // `reg` is either a register or an opcode extension.
+    void emit_instruction(OperandSize, u8 prefix, std::initializer_list<u8> opcode, u8 reg, Address const& rm);
+    void emit_instruction(OperandSize, u8 prefix, std::initializer_list<u8> opcode, u8 reg, Register rm);
+
+    Vector<u8> m_code;
+    Vector<LabelReference> m_label_references;
+};
+
+}
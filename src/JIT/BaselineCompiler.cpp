@@ -0,0 +1,1094 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "BaselineCompiler.h"
+#include "../Interpreter/Interpreter.h"
+#include "../Interpreter/Object.h"
+#include "Helpers.h"
+#include <AK/Array.h>
+#include <AK/NumericLimits.h>
+
+namespace JIT {
+
+using Interpreter::ArrayObject;
+using Interpreter::Instruction;
+using Interpreter::Object;
+using Interpreter::Opcode;
+using Interpreter::Value;
+
+using ArithmeticOperation = Assembler::ArithmeticOperation;
+using FloatOperation = Assembler::FloatOperation;
+using ShiftOperation = Assembler::ShiftOperation;
+
+// The sizes that Java's types are operated on with, a slot is always 8 bytes
+static constexpr auto int_size = OperandSize::DoubleWord;
+static constexpr auto long_size = OperandSize::QuadWord;
+static constexpr auto float_size = OperandSize::DoubleWord;
+static constexpr auto double_size = OperandSize::QuadWord;
+static constexpr auto slot_size = OperandSize::QuadWord;
+
+static constexpr i32 field_storage_offset = sizeof(Object);
+
+BaselineCompiler::BaselineCompiler(Interpreter::Method& method, Interpreter::InstructionStream& instruction_stream, Interpreter::Heap& heap, Interpreter::TieringPolicy const& tiering_policy)
+    : m_method(method)
+    , m_instruction_stream(instruction_stream)
+    , m_heap(heap)
+    , m_tiering_policy(tiering_policy)
+    , m_max_locals(method.code()->max_locals())
+    , m_counts_backedges(tiering_policy.is_optimization_enabled() && instruction_stream.is_optimizable())
+{
+}
+
+ErrorOr<NonnullOwnPtr<CompiledCode>> BaselineCompiler::compile(Interpreter::Method& method, Interpreter::InstructionStream& instruction_stream, Interpreter::Heap& heap, CodeCache& code_cache, Interpreter::TieringPolicy const& tiering_policy)
+{
+    BaselineCompiler compiler(method, instruction_stream, heap, tiering_policy);
+    TRY(compiler.compile_method());
+
+    auto code = compiler.m_assembler.finalize();
+    auto const* entry_point = TRY(code_cache.install(code));
+
+    Vector<EntryPoint> loop_entry_points;
+    TRY(loop_entry_points.try_ensure_capacity(compiler.m_loop_entry_labels.size()));
+    for (auto const& label : compiler.m_loop_entry_labels)
+        loop_entry_points.unchecked_append(label.is_bound() ? reinterpret_cast<EntryPoint>(entry_point + label.offset()) : nullptr);
+
+    return try_make<CompiledCode>(CompiledCode::Tier::Baseline, reinterpret_cast<EntryPoint>(entry_point), move(loop_entry_points), code.size());
+}
+
+ErrorOr<void> BaselineCompiler::compile_method()
+{
+    // The assembler refers to these until the code is finalized, so they can't be resized once anything has been emitted
+    auto instruction_count = m_instruction_stream.size();
+    TRY(m_instruction_labels.try_resize(instruction_count));
+    TRY(m_deoptimization_labels.try_resize(instruction_count));
+    TRY(m_exit_labels.try_resize(instruction_count));
+    TRY(m_needs_deoptimization_stub.try_resize(instruction_count));
+    TRY(m_needs_exit_stub.try_resize(instruction_count));
+    TRY(m_jump_table_labels.try_resize(instruction_count));
+    TRY(m_loop_entry_labels.try_resize(m_instruction_stream.loops().size()));
+    TRY(m_backedge_labels.try_resize(m_instruction_stream.loops().size()));
+    TRY(m_needs_backedge_stub.try_resize(m_instruction_stream.loops().size()));
+
+    emit_prologue();
+
+    auto* instructions = m_instruction_stream.instructions();
+    auto const& reference_maps = m_instruction_stream.reference_maps();
+    for (u32 index = 0; index < instruction_count; index++) {
+        m_assembler.bind(m_instruction_labels[index]);
+
+        // Nothing can jump to an instruction that is never reached
+        auto depth = reference_maps.stack_depth(index);
+        if (!depth.has_value())
+            continue;
+
+        m_index = index;
+        m_depth = *depth;
+        TRY(compile_instruction(instructions[index]));
+    }
+
+    // The stubs are out of line, so that the code of each instruction falls straight through to the next one
+    for (u32 index = 0; index < instruction_count; index++) {
+        if (m_needs_deoptimization_stub[index]) {
+            m_assembler.bind(m_deoptimization_labels[index]);
+            m_assembler.mov(Register::RAX, to_underlying(ExitReason::Deoptimize));
+        }
+
+        if (m_needs_deoptimization_stub[index] || m_needs_exit_stub[index]) {
+            m_assembler.bind(m_exit_labels[index]);
+            m_assembler.mov(Register::RDX, index);
+            m_assembler.jump(m_epilogue);
+        }
+    }
+
+    // Each loop's entry has its own prologue, which then jumps straight to the loop's header
+    auto const& loops = m_instruction_stream.loops();
+    for (size_t loop = 0; loop < loops.size(); loop++) {
+        if (!reference_maps.stack_depth(loops[loop].header).has_value())
+            continue;
+
+        m_assembler.bind(m_loop_entry_labels[loop]);
+        emit_prologue();
+        m_assembler.jump(m_instruction_labels[loops[loop].header]);
+    }
+
+    // Each loop's back-edges count towards the profile, like the interpreter's do, until the loop is hot enough to be optimized.
+    // The loop has to reach the threshold exactly, so it only exits once, even if the method can't be optimized.
+    for (size_t loop = 0; loop < loops.size(); loop++) {
+        if (!m_needs_backedge_stub[loop])
+            continue;
+
+        auto threshold = max(m_tiering_policy.optimization_backedge_threshold(), loops[loop].backedge_count + 1);
+        m_assembler.bind(m_backedge_labels[loop]);
+        m_assembler.mov(Register::RAX, bit_cast<FlatPtr>(m_instruction_stream.backedge_count_pointer()));
+        m_assembler.arithmetic(ArithmeticOperation::Add, OperandSize::QuadWord, Address { .base = Register::RAX }, 1);
+        m_assembler.mov(Register::RAX, bit_cast<FlatPtr>(m_instruction_stream.loop_backedge_count_pointer(loop)));
+        m_assembler.mov(OperandSize::QuadWord, Register::RCX, Address { .base = Register::RAX });
+        m_assembler.arithmetic(ArithmeticOperation::Add, OperandSize::QuadWord, Register::RCX, 1);
+        m_assembler.mov(OperandSize::QuadWord, Address { .base = Register::RAX }, Register::RCX);
+        m_assembler.mov(Register::RDX, threshold);
+        m_assembler.arithmetic(ArithmeticOperation::Compare, OperandSize::QuadWord, Register::RCX, Register::RDX);
+        m_assembler.jump(Condition::NotEqual, m_instruction_labels[loops[loop].header]);
+
+        m_assembler.mov(Register::RAX, to_underlying(ExitReason::TierUp));
+        m_assembler.mov(Register::RDX, loop);
+        m_assembler.jump(m_epilogue);
+    }
+
+    // The exit reason is in rax, and its value is in rdx
+    m_assembler.bind(m_epilogue);
+    m_assembler.pop(Register::R14);
+    m_assembler.pop(Register::R13);
+    m_assembler.pop(Register::R12);
+    m_assembler.pop(Register::RBX);
+    m_assembler.pop(Register::RBP);
+    m_assembler.ret();
+
+    // Every tableswitch's jump table holds the offset of each case's code from the start of the table
+    for (u32 index = 0; index < instruction_count; index++) {
+        auto& instruction = instructions[index];
+        if (instruction.opcode != Opcode::Tableswitch || !reference_maps.stack_depth(index).has_value())
+            continue;
+
+        m_assembler.bind(m_jump_table_labels[index]);
+        for (auto target : instruction.switch_table->targets)
+            m_assembler.jump_table_entry(m_jump_table_labels[index], m_instruction_labels[target]);
+    }
+
+    return {};
+}
+
+void BaselineCompiler::emit_prologue()
+{
+    // rbx, r12 and r13 are callee-saved, so they survive calls to the helpers.
+    // r14 isn't used, it's only saved to keep the stack 16-byte aligned for those calls.
+    m_assembler.push(Register::RBP);
+    m_assembler.mov(OperandSize::QuadWord, Register::RBP, Register::RSP);
+    m_assembler.push(Register::RBX);
+    m_assembler.push(Register::R12);
+    m_assembler.push(Register::R13);
+    m_assembler.push(Register::R14);
+    m_assembler.mov(OperandSize::QuadWord, Register::RBX, Register::RDI);
+    m_assembler.mov(OperandSize::QuadWord, Register::R12, Register::RSI);
+    m_assembler.mov(OperandSize::QuadWord, Register::R13, Register::RDX);
+}
+
+Address BaselineCompiler::slot(u32 index) const
+{
+    return { .base = Register::RBX, .displacement = static_cast<i32>(index * sizeof(Value)) };
+}
+
+Address BaselineCompiler::operand(u32 slots_from_top) const
+{
+    return slot(m_max_locals + m_depth - slots_from_top);
+}
+
+Label& BaselineCompiler::deoptimization_label()
+{
+    m_needs_deoptimization_stub[m_index] = true;
+    return m_deoptimization_labels[m_index];
+}
+
+Label& BaselineCompiler::exit_label()
+{
+    m_needs_exit_stub[m_index] = true;
+    return m_exit_labels[m_index];
+}
+
+Label& BaselineCompiler::branch_target(Instruction const& branch)
+{
+    auto target = static_cast<u32>(branch.operand);
+    if (m_counts_backedges && target <= m_index) {
+        m_needs_backedge_stub[branch.index] = true;
+        return m_backedge_labels[branch.index];
+    }
+
+    return m_instruction_labels[target];
+}
+
+Label& BaselineCompiler::create_label()
+{
+    m_local_labels.append(make<Label>());
+    return *m_local_labels.last();
+}
+
+void BaselineCompiler::store_constant(Address const& address, u64 bits)
+{
+    // A 64-bit store sign-extends its immediate
+    auto value = static_cast<i64>(bits);
+    if (value >= NumericLimits<i32>::min() && value <= NumericLimits<i32>::max()) {
+        m_assembler.mov(slot_size, address, static_cast<i32>(value));
+        return;
+    }
+
+    m_assembler.mov(Register::RAX, bits);
+    m_assembler.mov(slot_size, address, Register::RAX);
+}
+
+void BaselineCompiler::store_int(Address const& address, Register value)
+{
+    m_assembler.movsx(int_size, value, value);
+    m_assembler.mov(slot_size, address, value);
+}
+
+void BaselineCompiler::shuffle(u32 popped, std::initializer_list<u32> pushed)
+{
+    static constexpr Array<Register, 4> registers { Register::RAX, Register::RCX, Register::RDX, Register::RSI };
+    VERIFY(popped <= registers.size());
+
+    for (u32 i = 1; i <= popped; i++)
+        m_assembler.mov(slot_size, registers[i - 1], operand(i));
+
+    auto first_slot = m_max_locals + m_depth - popped;
+    for (auto value : pushed)
+        m_assembler.mov(slot_size, slot(first_slot++), registers[value - 1]);
+}
+
+void BaselineCompiler::load_object(Address const& address)
+{
+    m_assembler.mov(slot_size, Register::RAX, address);
+    m_assembler.test(slot_size, Register::RAX, Register::RAX);
+    m_assembler.jump(Condition::Equal, deoptimization_label());
+}
+
+void BaselineCompiler::load_array_and_index(Address const& array, Address const& index)
+{
+    load_object(array);
+    m_assembler.movsx(int_size, Register::RCX, index);
+
+    // A negative index is a large unsigned one, so a single comparison checks both bounds
+    m_assembler.arithmetic(ArithmeticOperation::Compare, int_size, Register::RCX, Address { .base = Register::RAX, .displacement = ArrayObject::length_offset });
+    m_assembler.jump(Condition::AboveOrEqual, deoptimization_label());
+}
+
+void BaselineCompiler::store_pc()
+{
+    m_assembler.mov(Register::RAX, bit_cast<FlatPtr>(m_instruction_stream.instructions() + m_index));
+    m_assembler.mov(slot_size, Address { .base = Register::R13 }, Register::RAX);
+}
+
+void BaselineCompiler::call_helper(Helper helper, Instruction& instruction)
+{
+    m_assembler.mov(OperandSize::QuadWord, Register::RDI, Register::R12);
+    m_assembler.mov(Register::RSI, bit_cast<FlatPtr>(&instruction));
+    m_assembler.lea(Register::RDX, operand(0));
+    m_assembler.mov(Register::RAX, bit_cast<FlatPtr>(helper));
+    m_assembler.call(Register::RAX);
+
+    m_assembler.test(int_size, Register::RAX, Register::RAX);
+    m_assembler.jump(Condition::NotEqual, exit_label());
+}
+
+// The element of the array in rax at the index in rcx
+static Address element_address(u8 element_size)
+{
+    return { .base = Register::RAX, .displacement = ArrayObject::elements_offset, .index = Register::RCX, .scale = element_size };
+}
+
+// The field of the object in rax
+static Address field_address(Instruction const& instruction)
+{
+    return { .base = Register::RAX, .displacement = field_storage_offset + instruction.operand };
+}
+
+ErrorOr<void> BaselineCompiler::compile_instruction(Instruction& instruction)
+{
+    auto& assembler = m_assembler;
+
+    auto branch_if = [&](Condition condition) {
+        assembler.jump(condition, branch_target(instruction));
+    };
+
+    auto return_value = [&](Address const& value) {
+        assembler.mov(slot_size, Register::RDX, value);
+        assembler.mov(Register::RAX, to_underlying(ExitReason::Return));
+        assembler.jump(m_epilogue);
+    };
+
+    switch (instruction.opcode) {
+    case Opcode::Nop:
+        return {};
+
+    // Constants
+    case Opcode::AconstNull:
+        store_constant(operand(0), 0);
+        return {};
+
+    case Opcode::IconstM1:
+    case Opcode::Iconst0:
+    case Opcode::Iconst1:
+    case Opcode::Iconst2:
+    case Opcode::Iconst3:
+    case Opcode::Iconst4:
+    case Opcode::Iconst5:
+    case Opcode::Bipush:
+    case Opcode::Sipush:
+        store_constant(operand(0), Value::from_int(instruction.operand).bits());
+        return {};
+
+    case Opcode::Lconst0:
+    case Opcode::Lconst1:
+        store_constant(operand(0), Value::from_long(instruction.operand).bits());
+        return {};
+
+    case Opcode::Fconst0:
+    case Opcode::Fconst1:
+    case Opcode::Fconst2:
+        store_constant(operand(0), Value::from_float(static_cast<float>(instruction.operand)).bits());
+        return {};
+
+    case Opcode::Dconst0:
+    case Opcode::Dconst1:
+        store_constant(operand(0), Value::from_double(static_cast<double>(instruction.operand)).bits());
+        return {};
+
+    // A string or class constant is loaded from the instruction, as the garbage collector updates it there when the object moves
+    case Opcode::LdcQuick:
+        assembler.mov(Register::RAX, bit_cast<FlatPtr>(&instruction.constant_bits));
+        assembler.mov(slot_size, Register::RAX, Address { .base = Register::RAX });
+        assembler.mov(slot_size, operand(0), Register::RAX);
+        return {};
+
+    case Opcode::Ldc2WQuick:
+        store_constant(operand(0), instruction.constant_bits);
+        return {};
+
+    // Loads and stores, a long or double is stored in the first of its two slots
+    case Opcode::Iload:
+    case Opcode::Fload:
+    case Opcode::Aload:
+    case Opcode::Iload0:
+    case Opcode::Iload1:
+    case Opcode::Iload2:
+    case Opcode::Iload3:
+    case Opcode::Fload0:
+    case Opcode::Fload1:
+    case Opcode::Fload2:
+    case Opcode::Fload3:
+    case Opcode::Aload0:
+    case Opcode::Aload1:
+    case Opcode::Aload2:
+    case Opcode::Aload3:
+    case Opcode::Lload:
+    case Opcode::Dload:
+    case Opcode::Lload0:
+    case Opcode::Lload1:
+    case Opcode::Lload2:
+    case Opcode::Lload3:
+    case Opcode::Dload0:
+    case Opcode::Dload1:
+    case Opcode::Dload2:
+    case Opcode::Dload3:
+        assembler.mov(slot_size, Register::RAX, slot(instruction.index));
+        assembler.mov(slot_size, operand(0), Register::RAX);
+        return {};
+
+    case Opcode::Istore:
+    case Opcode::Fstore:
+    case Opcode::Astore:
+    case Opcode::Istore0:
+    case Opcode::Istore1:
+    case Opcode::Istore2:
+    case Opcode::Istore3:
+    case Opcode::Fstore0:
+    case Opcode::Fstore1:
+    case Opcode::Fstore2:
+    case Opcode::Fstore3:
+    case Opcode::Astore0:
+    case Opcode::Astore1:
+    case Opcode::Astore2:
+    case Opcode::Astore3:
+        assembler.mov(slot_size, Register::RAX, operand(1));
+        assembler.mov(slot_size, slot(instruction.index), Register::RAX);
+        return {};
+
+    case Opcode::Lstore:
+    case Opcode::Dstore:
+    case Opcode::Lstore0:
+    case Opcode::Lstore1:
+    case Opcode::Lstore2:
+    case Opcode::Lstore3:
+    case Opcode::Dstore0:
+    case Opcode::Dstore1:
+    case Opcode::Dstore2:
+    case Opcode::Dstore3:
+        assembler.mov(slot_size, Register::RAX, operand(2));
+        assembler.mov(slot_size, slot(instruction.index), Register::RAX);
+        return {};
+
+    // Array loads, the array and the index are replaced by the element
+    case Opcode::Iaload:
+        load_array_and_index(operand(2), operand(1));
+        assembler.movsx(int_size, Register::RDX, element_address(4));
+        assembler.mov(slot_size, operand(2), Register::RDX);
+        return {};
+
+    case Opcode::Faload:
+        load_array_and_index(operand(2), operand(1));
+        assembler.mov(float_size, Register::RDX, element_address(4));
+        assembler.mov(slot_size, operand(2), Register::RDX);
+        return {};
+
+    case Opcode::Laload:
+    case Opcode::Daload:
+        load_array_and_index(operand(2), operand(1));
+        assembler.mov(long_size, Register::RDX, element_address(8));
+        assembler.mov(slot_size, operand(2), Register::RDX);
+        return {};
+
+    case Opcode::Aaload:
+        load_array_and_index(operand(2), operand(1));
+        assembler.mov(slot_size, Register::RDX, element_address(sizeof(Object*)));
+        assembler.mov(slot_size, operand(2), Register::RDX);
+        return {};
+
+    case Opcode::Baload:
+        load_array_and_index(operand(2), operand(1));
+        assembler.movsx(OperandSize::Byte, Register::RDX, element_address(1));
+        assembler.mov(slot_size, operand(2), Register::RDX);
+        return {};
+
+    case Opcode::Caload:
+        load_array_and_index(operand(2), operand(1));
+        assembler.movzx(OperandSize::Word, Register::RDX, element_address(2));
+        assembler.mov(slot_size, operand(2), Register::RDX);
+        return {};
+
+    case Opcode::Saload:
+        load_array_and_index(operand(2), operand(1));
+        assembler.movsx(OperandSize::Word, Register::RDX, element_address(2));
+        assembler.mov(slot_size, operand(2), Register::RDX);
+        return {};
+
+    // Array stores
+    case Opcode::Iastore:
+    case Opcode::Fastore:
+        load_array_and_index(operand(3), operand(2));
+        assembler.mov(int_size, Register::RDX, operand(1));
+        assembler.mov(int_size, element_address(4), Register::RDX);
+        return {};
+
+    case Opcode::Lastore:
+    case Opcode::Dastore:
+        load_array_and_index(operand(4), operand(3));
+        assembler.mov(long_size, Register::RDX, operand(2));
+        assembler.mov(long_size, element_address(8), Register::RDX);
+        return {};
+
+    case Opcode::Castore:
+    case Opcode::Sastore:
+        load_array_and_index(operand(3), operand(2));
+        assembler.mov(int_size, Register::RDX, operand(1));
+        assembler.mov(OperandSize::Word, element_address(2), Register::RDX);
+        return {};
+
+    case Opcode::Aastore:
+        call_helper(Helpers::store_reference_array_element, instruction);
+        return {};
+
+    case Opcode::Bastore:
+        call_helper(Helpers::store_byte_array_element, instruction);
+        return {};
+
+    // Stack manipulation, the depth of the operand stack already accounts for the pops
+    case Opcode::Pop:
+    case Opcode::Pop2:
+        return {};
+
+    case Opcode::Dup:
+        shuffle(1, { 1, 1 });
+        return {};
+
+    case Opcode::DupX1:
+        shuffle(2, { 1, 2, 1 });
+        return {};
+
+    case Opcode::DupX2:
+        shuffle(3, { 1, 3, 2, 1 });
+        return {};
+
+    case Opcode::Dup2:
+        shuffle(2, { 2, 1, 2, 1 });
+        return {};
+
+    case Opcode::Dup2X1:
+        shuffle(3, { 2, 1, 3, 2, 1 });
+        return {};
+
+    case Opcode::Dup2X2:
+        shuffle(4, { 2, 1, 4, 3, 2, 1 });
+        return {};
+
+    case Opcode::Swap:
+        shuffle(2, { 1, 2 });
+        return {};
+
+    // Integer arithmetic, which wraps around just like Java's
+    case Opcode::Iadd:
+    case Opcode::Isub:
+    case Opcode::Iand:
+    case Opcode::Ior:
+    case Opcode::Ixor: {
+        auto operation = instruction.opcode == Opcode::Iadd ? ArithmeticOperation::Add
+            : instruction.opcode == Opcode::Isub            ? ArithmeticOperation::Subtract
+            : instruction.opcode == Opcode::Iand            ? ArithmeticOperation::And
+            : instruction.opcode == Opcode::Ior             ? ArithmeticOperation::Or
+                                                            : ArithmeticOperation::Xor;
+
+        assembler.mov(int_size, Register::RAX, operand(2));
+        assembler.arithmetic(operation, int_size, Register::RAX, operand(1));
+        store_int(operand(2), Register::RAX);
+        return {};
+    }
+
+    case Opcode::Ladd:
+    case Opcode::Lsub:
+    case Opcode::Land:
+    case Opcode::Lor:
+    case Opcode::Lxor: {
+        auto operation = instruction.opcode == Opcode::Ladd ? ArithmeticOperation::Add
+            : instruction.opcode == Opcode::Lsub            ? ArithmeticOperation::Subtract
+            : instruction.opcode == Opcode::Land            ? ArithmeticOperation::And
+            : instruction.opcode == Opcode::Lor             ? ArithmeticOperation::Or
+                                                            : ArithmeticOperation::Xor;
+
+        assembler.mov(long_size, Register::RAX, operand(4));
+        assembler.arithmetic(operation, long_size, Register::RAX, operand(2));
+        assembler.mov(long_size, operand(4), Register::RAX);
+        return {};
+    }
+
+    case Opcode::Imul:
+        assembler.mov(int_size, Register::RAX, operand(2));
+        assembler.imul(int_size, Register::RAX, operand(1));
+        store_int(operand(2), Register::RAX);
+        return {};
+
+    case Opcode::Lmul:
+        assembler.mov(long_size, Register::RAX, operand(4));
+        assembler.imul(long_size, Register::RAX, operand(2));
+        assembler.mov(long_size, operand(4), Register::RAX);
+        return {};
+
+    // Dividing by zero is left to the interpreter to throw, and dividing by -1 is done without idiv, which would trap on the smallest value's overflow
+    case Opcode::Idiv:
+    case Opcode::Irem:
+    case Opcode::Ldiv:
+    case Opcode::Lrem: {
+        auto is_long = instruction.opcode == Opcode::Ldiv || instruction.opcode == Opcode::Lrem;
+        auto is_remainder = instruction.opcode == Opcode::Irem || instruction.opcode == Opcode::Lrem;
+        auto size = is_long ? long_size : int_size;
+        auto dividend = is_long ? operand(4) : operand(2);
+        auto divisor = is_long ? operand(2) : operand(1);
+
+        auto& divide = create_label();
+        auto& done = create_label();
+
+        assembler.mov(size, Register::RCX, divisor);
+        assembler.test(size, Register::RCX, Register::RCX);
+        assembler.jump(Condition::Equal, deoptimization_label());
+        assembler.mov(size, Register::RAX, dividend);
+        assembler.arithmetic(ArithmeticOperation::Compare, size, Register::RCX, -1);
+        assembler.jump(Condition::NotEqual, divide);
+
+        if (is_remainder)
+            assembler.mov(Register::RAX, 0);
+        else
+            assembler.neg(size, Register::RAX);
+        assembler.jump(done);
+
+        assembler.bind(divide);
+        assembler.sign_extend_accumulator(size);
+        assembler.idiv(size, Register::RCX);
+        if (is_remainder)
+            assembler.mov(size, Register::RAX, Register::RDX);
+
+        assembler.bind(done);
+        if (is_long)
+            assembler.mov(long_size, dividend, Register::RAX);
+        else
+            store_int(dividend, Register::RAX);
+        return {};
+    }
+
+    case Opcode::Ineg:
+        assembler.mov(int_size, Register::RAX, operand(1));
+        assembler.neg(int_size, Register::RAX);
+        store_int(operand(1), Register::RAX);
+        return {};
+
+    case Opcode::Lneg:
+        assembler.mov(long_size, Register::RAX, operand(2));
+        assembler.neg(long_size, Register::RAX);
+        assembler.mov(long_size, operand(2), Register::RAX);
+        return {};
+
+    // x86 only uses the low 5 (or 6, for 64-bit operands) bits of the shift distance, just like Java
+    case Opcode::Ishl:
+    case Opcode::Ishr:
+    case Opcode::Iushr: {
+        auto operation = instruction.opcode == Opcode::Ishl ? ShiftOperation::Left
+            : instruction.opcode == Opcode::Ishr            ? ShiftOperation::ArithmeticRight
+                                                            : ShiftOperation::LogicalRight;
+
+        assembler.mov(int_size, Register::RCX, operand(1));
+        assembler.mov(int_size, Register::RAX, operand(2));
+        assembler.shift_by_cl(operation, int_size, Register::RAX);
+        store_int(operand(2), Register::RAX);
+        return {};
+    }
+
+    case Opcode::Lshl:
+    case Opcode::Lshr:
+    case Opcode::Lushr: {
+        auto operation = instruction.opcode == Opcode::Lshl ? ShiftOperation::Left
+            : instruction.opcode == Opcode::Lshr            ? ShiftOperation::ArithmeticRight
+                                                            : ShiftOperation::LogicalRight;
+
+        assembler.mov(int_size, Register::RCX, operand(1));
+        assembler.mov(long_size, Register::RAX, operand(3));
+        assembler.shift_by_cl(operation, long_size, Register::RAX);
+        assembler.mov(long_size, operand(3), Register::RAX);
+        return {};
+    }
+
+    case Opcode::Iinc:
+        assembler.mov(int_size, Register::RAX, slot(instruction.index));
+        assembler.arithmetic(ArithmeticOperation::Add, int_size, Register::RAX, instruction.operand);
+        store_int(slot(instruction.index), Register::RAX);
+        return {};
+
+    // Floating point arithmetic, a float's slot holds its bits zero-extended (like Value::from_float())
+    case Opcode::Fadd:
+    case Opcode::Fsub:
+    case Opcode::Fmul:
+    case Opcode::Fdiv:
+    case Opcode::Dadd:
+    case Opcode::Dsub:
+    case Opcode::Dmul:
+    case Opcode::Ddiv: {
+        auto is_double = instruction.opcode == Opcode::Dadd || instruction.opcode == Opcode::Dsub || instruction.opcode == Opcode::Dmul || instruction.opcode == Opcode::Ddiv;
+        auto operation = (instruction.opcode == Opcode::Fadd || instruction.opcode == Opcode::Dadd) ? FloatOperation::Add
+            : (instruction.opcode == Opcode::Fsub || instruction.opcode == Opcode::Dsub)            ? FloatOperation::Subtract
+            : (instruction.opcode == Opcode::Fmul || instruction.opcode == Opcode::Dmul)            ? FloatOperation::Multiply
+                                                                                                    : FloatOperation::Divide;
+
+        if (is_double) {
+            assembler.float_operation(FloatOperation::Load, double_size, FloatRegister::XMM0, operand(4));
+            assembler.float_operation(operation, double_size, FloatRegister::XMM0, operand(2));
+            assembler.float_store(double_size, operand(4), FloatRegister::XMM0);
+            return {};
+        }
+
+        assembler.float_operation(FloatOperation::Load, float_size, FloatRegister::XMM0, operand(2));
+        assembler.float_operation(operation, float_size, FloatRegister::XMM0, operand(1));
+        assembler.float_to_bits(float_size, Register::RAX, FloatRegister::XMM0);
+        assembler.mov(slot_size, operand(2), Register::RAX);
+        return {};
+    }
+
+    case Opcode::Frem:
+        call_helper(Helpers::float_remainder, instruction);
+        return {};
+
+    case Opcode::Drem:
+        call_helper(Helpers::double_remainder, instruction);
+        return {};
+
+    // Negation only flips the sign bit, so NaN stays NaN
+    case Opcode::Fneg:
+        assembler.mov(int_size, Register::RAX, operand(1));
+        assembler.arithmetic(ArithmeticOperation::Xor, int_size, Register::RAX, NumericLimits<i32>::min());
+        assembler.mov(slot_size, operand(1), Register::RAX);
+        return {};
+
+    case Opcode::Dneg:
+        assembler.mov(Register::RCX, 0x8000000000000000);
+        assembler.arithmetic(ArithmeticOperation::Xor, long_size, operand(2), Register::RCX);
+        return {};
+
+    // Conversions, an int's slot already holds it sign-extended to 64 bits, which is the same long
+    case Opcode::I2l:
+        return {};
+
+    case Opcode::L2i:
+        assembler.mov(int_size, Register::RAX, operand(2));
+        store_int(operand(2), Register::RAX);
+        return {};
+
+    case Opcode::I2f:
+    case Opcode::L2f: {
+        auto integer_size = instruction.opcode == Opcode::I2f ? int_size : long_size;
+        auto value = instruction.opcode == Opcode::I2f ? operand(1) : operand(2);
+        assembler.integer_to_float(float_size, integer_size, FloatRegister::XMM0, value);
+        assembler.float_to_bits(float_size, Register::RAX, FloatRegister::XMM0);
+        assembler.mov(slot_size, value, Register::RAX);
+        return {};
+    }
+
+    case Opcode::I2d:
+    case Opcode::L2d: {
+        auto integer_size = instruction.opcode == Opcode::I2d ? int_size : long_size;
+        auto value = instruction.opcode == Opcode::I2d ? operand(1) : operand(2);
+        assembler.integer_to_float(double_size, integer_size, FloatRegister::XMM0, value);
+        assembler.float_store(double_size, value, FloatRegister::XMM0);
+        return {};
+    }
+
+    case Opcode::F2d:
+        assembler.float_to_float(float_size, FloatRegister::XMM0, operand(1));
+        assembler.float_store(double_size, operand(1), FloatRegister::XMM0);
+        return {};
+
+    case Opcode::D2f:
+        assembler.float_to_float(double_size, FloatRegister::XMM0, operand(2));
+        assembler.float_to_bits(float_size, Register::RAX, FloatRegister::XMM0);
+        assembler.mov(slot_size, operand(2), Register::RAX);
+        return {};
+
+    case Opcode::F2i:
+        call_helper(Helpers::float_to_int, instruction);
+        return {};
+
+    case Opcode::F2l:
+        call_helper(Helpers::float_to_long, instruction);
+        return {};
+
+    case Opcode::D2i:
+        call_helper(Helpers::double_to_int, instruction);
+        return {};
+
+    case Opcode::D2l:
+        call_helper(Helpers::double_to_long, instruction);
+        return {};
+
+    case Opcode::I2b:
+        assembler.movsx(OperandSize::Byte, Register::RAX, operand(1));
+        assembler.mov(slot_size, operand(1), Register::RAX);
+        return {};
+
+    case Opcode::I2c:
+        assembler.movzx(OperandSize::Word, Register::RAX, operand(1));
+        assembler.mov(slot_size, operand(1), Register::RAX);
+        return {};
+
+    case Opcode::I2s:
+        assembler.movsx(OperandSize::Word, Register::RAX, operand(1));
+        assembler.mov(slot_size, operand(1), Register::RAX);
+        return {};
+
+    // Comparisons, lcmp's result is (a > b) - (a < b)
+    case Opcode::Lcmp:
+        assembler.mov(long_size, Register::RAX, operand(4));
+        assembler.arithmetic(ArithmeticOperation::Compare, long_size, Register::RAX, operand(2));
+        assembler.set(Condition::Greater, Register::RAX);
+        assembler.set(Condition::Less, Register::RCX);
+        assembler.arithmetic(ArithmeticOperation::Subtract, OperandSize::Byte, Register::RAX, Register::RCX);
+        assembler.movsx(OperandSize::Byte, Register::RAX, Register::RAX);
+        assembler.mov(slot_size, operand(4), Register::RAX);
+        return {};
+
+    case Opcode::Fcmpl:
+    case Opcode::Fcmpg:
+        call_helper(Helpers::compare_floats, instruction);
+        return {};
+
+    case Opcode::Dcmpl:
+    case Opcode::Dcmpg:
+        call_helper(Helpers::compare_doubles, instruction);
+        return {};
+
+    // Branches jump straight to the code of their target
+    case Opcode::Ifeq:
+    case Opcode::Ifne:
+    case Opcode::Iflt:
+    case Opcode::Ifge:
+    case Opcode::Ifgt:
+    case Opcode::Ifle: {
+        auto condition = instruction.opcode == Opcode::Ifeq ? Condition::Equal
+            : instruction.opcode == Opcode::Ifne            ? Condition::NotEqual
+            : instruction.opcode == Opcode::Iflt            ? Condition::Less
+            : instruction.opcode == Opcode::Ifge            ? Condition::GreaterOrEqual
+            : instruction.opcode == Opcode::Ifgt            ? Condition::Greater
+                                                            : Condition::LessOrEqual;
+
+        assembler.arithmetic(ArithmeticOperation::Compare, int_size, operand(1), 0);
+        branch_if(condition);
+        return {};
+    }
+
+    case Opcode::IfIcmpeq:
+    case Opcode::IfIcmpne:
+    case Opcode::IfIcmplt:
+    case Opcode::IfIcmpge:
+    case Opcode::IfIcmpgt:
+    case Opcode::IfIcmple: {
+        auto condition = instruction.opcode == Opcode::IfIcmpeq ? Condition::Equal
+            : instruction.opcode == Opcode::IfIcmpne            ? Condition::NotEqual
+            : instruction.opcode == Opcode::IfIcmplt            ? Condition::Less
+            : instruction.opcode == Opcode::IfIcmpge            ? Condition::GreaterOrEqual
+            : instruction.opcode == Opcode::IfIcmpgt            ? Condition::Greater
+                                                                : Condition::LessOrEqual;
+
+        assembler.mov(int_size, Register::RAX, operand(2));
+        assembler.arithmetic(ArithmeticOperation::Compare, int_size, Register::RAX, operand(1));
+        branch_if(condition);
+        return {};
+    }
+
+    case Opcode::IfAcmpeq:
+    case Opcode::IfAcmpne:
+        assembler.mov(slot_size, Register::RAX, operand(2));
+        assembler.arithmetic(ArithmeticOperation::Compare, slot_size, Register::RAX, operand(1));
+        branch_if(instruction.opcode == Opcode::IfAcmpeq ? Condition::Equal : Condition::NotEqual);
+        return {};
+
+    case Opcode::Ifnull:
+    case Opcode::Ifnonnull:
+        assembler.arithmetic(ArithmeticOperation::Compare, slot_size, operand(1), 0);
+        branch_if(instruction.opcode == Opcode::Ifnull ? Condition::Equal : Condition::NotEqual);
+        return {};
+
+    case Opcode::Goto:
+    case Opcode::GotoW:
+        assembler.jump(branch_target(instruction));
+        return {};
+
+    // The return address of a jsr is only known at run-time, so every ret would have to dispatch on it
+    case Opcode::Jsr:
+    case Opcode::JsrW:
+    case Opcode::Ret:
+        return Error::from_string_literal("The baseline compiler doesn't support jsr and ret");
+
+    // Out of range indices (including those below `low`) wrap around to large unsigned values, see the interpreter
+    case Opcode::Tableswitch: {
+        auto const& switch_table = *instruction.switch_table;
+        assembler.movsx(int_size, Register::RAX, operand(1));
+        assembler.arithmetic(ArithmeticOperation::Subtract, long_size, Register::RAX, switch_table.low);
+        assembler.arithmetic(ArithmeticOperation::Compare, long_size, Register::RAX, static_cast<i32>(switch_table.targets.size()));
+        assembler.jump(Condition::AboveOrEqual, m_instruction_labels[switch_table.default_target]);
+
+        assembler.lea(Register::RCX, m_jump_table_labels[m_index]);
+        assembler.movsx(int_size, Register::RAX, Address { .base = Register::RCX, .index = Register::RAX, .scale = 4 });
+        assembler.arithmetic(ArithmeticOperation::Add, OperandSize::QuadWord, Register::RAX, Register::RCX);
+        assembler.jump(Register::RAX);
+        return {};
+    }
+
+    // Each match is compared in turn, most lookupswitches only have a few cases
+    case Opcode::Lookupswitch: {
+        auto const& switch_table = *instruction.switch_table;
+        assembler.mov(int_size, Register::RAX, operand(1));
+        for (size_t i = 0; i < switch_table.matches.size(); i++) {
+            assembler.arithmetic(ArithmeticOperation::Compare, int_size, Register::RAX, switch_table.matches[i]);
+            assembler.jump(Condition::Equal, m_instruction_labels[switch_table.targets[i]]);
+        }
+
+        assembler.jump(m_instruction_labels[switch_table.default_target]);
+        return {};
+    }
+
+    // Returns
+    case Opcode::Ireturn:
+    case Opcode::Freturn:
+    case Opcode::Areturn:
+        return_value(operand(1));
+        return {};
+
+    case Opcode::Lreturn:
+    case Opcode::Dreturn:
+        return_value(operand(2));
+        return {};
+
+    case Opcode::Return:
+        assembler.mov(Register::RDX, 0);
+        assembler.mov(Register::RAX, to_underlying(ExitReason::Return));
+        assembler.jump(m_epilogue);
+        return {};
+
+    // Fields
+    case Opcode::GetstaticQuick:
+    case Opcode::Getstatic2Quick:
+        assembler.mov(Register::RAX, bit_cast<FlatPtr>(instruction.static_value));
+        assembler.mov(slot_size, Register::RAX, Address { .base = Register::RAX });
+        assembler.mov(slot_size, operand(0), Register::RAX);
+        return {};
+
+    case Opcode::PutstaticQuick:
+    case Opcode::Putstatic2Quick:
+        assembler.mov(slot_size, Register::RCX, instruction.opcode == Opcode::PutstaticQuick ? operand(1) : operand(2));
+        assembler.mov(Register::RAX, bit_cast<FlatPtr>(instruction.static_value));
+        assembler.mov(slot_size, Address { .base = Register::RAX }, Register::RCX);
+        return {};
+
+    case Opcode::GetfieldByteQuick:
+        load_object(operand(1));
+        assembler.movsx(OperandSize::Byte, Register::RDX, field_address(instruction));
+        assembler.mov(slot_size, operand(1), Register::RDX);
+        return {};
+
+    case Opcode::GetfieldCharQuick:
+        load_object(operand(1));
+        assembler.movzx(OperandSize::Word, Register::RDX, field_address(instruction));
+        assembler.mov(slot_size, operand(1), Register::RDX);
+        return {};
+
+    case Opcode::GetfieldShortQuick:
+        load_object(operand(1));
+        assembler.movsx(OperandSize::Word, Register::RDX, field_address(instruction));
+        assembler.mov(slot_size, operand(1), Register::RDX);
+        return {};
+
+    case Opcode::GetfieldIntQuick:
+        load_object(operand(1));
+        assembler.movsx(int_size, Register::RDX, field_address(instruction));
+        assembler.mov(slot_size, operand(1), Register::RDX);
+        return {};
+
+    case Opcode::GetfieldLongQuick:
+    case Opcode::GetfieldReferenceQuick:
+        load_object(operand(1));
+        assembler.mov(slot_size, Register::RDX, field_address(instruction));
+        assembler.mov(slot_size, operand(1), Register::RDX);
+        return {};
+
+    case Opcode::PutfieldBooleanQuick:
+        load_object(operand(2));
+        assembler.mov(int_size, Register::RDX, operand(1));
+        assembler.arithmetic(ArithmeticOperation::And, int_size, Register::RDX, 1);
+        assembler.mov(OperandSize::Byte, field_address(instruction), Register::RDX);
+        return {};
+
+    case Opcode::PutfieldByteQuick:
+        load_object(operand(2));
+        assembler.mov(int_size, Register::RDX, operand(1));
+        assembler.mov(OperandSize::Byte, field_address(instruction), Register::RDX);
+        return {};
+
+    case Opcode::PutfieldShortQuick:
+        load_object(operand(2));
+        assembler.mov(int_size, Register::RDX, operand(1));
+        assembler.mov(OperandSize::Word, field_address(instruction), Register::RDX);
+        return {};
+
+    case Opcode::PutfieldIntQuick:
+        load_object(operand(2));
+        assembler.mov(int_size, Register::RDX, operand(1));
+        assembler.mov(int_size, field_address(instruction), Register::RDX);
+        return {};
+
+    case Opcode::PutfieldLongQuick:
+        load_object(operand(3));
+        assembler.mov(long_size, Register::RDX, operand(2));
+        assembler.mov(long_size, field_address(instruction), Register::RDX);
+        return {};
+
+    // The write barrier is Heap::record_write(), inlined: it dirties the card that the object starts in
+    case Opcode::PutfieldReferenceQuick:
+        load_object(operand(2));
+        assembler.mov(slot_size, Register::RDX, operand(1));
+        assembler.mov(slot_size, field_address(instruction), Register::RDX);
+        assembler.shift(ShiftOperation::LogicalRight, OperandSize::QuadWord, Register::RAX, Interpreter::Heap::card_shift);
+        assembler.mov(Register::RCX, m_heap.biased_card_table());
+        assembler.mov(OperandSize::Byte, Address { .base = Register::RCX, .index = Register::RAX }, Interpreter::Heap::dirty_card);
+        return {};
+
+    // Method invocation, the helper leaves the return value where the arguments were
+    case Opcode::InvokevirtualQuick:
+    case Opcode::InvokeinterfaceQuick:
+        store_pc();
+        call_helper(Helpers::invoke_virtual, instruction);
+        return {};
+
+    case Opcode::InvokenonvirtualQuick:
+        store_pc();
+        call_helper(Helpers::invoke_nonvirtual, instruction);
+        return {};
+
+    case Opcode::InvokestaticQuick:
+        store_pc();
+        call_helper(Helpers::invoke_static, instruction);
+        return {};
+
+    // Objects and arrays, allocating can run the garbage collector
+    case Opcode::NewQuick:
+        store_pc();
+        call_helper(Helpers::allocate_object, instruction);
+        return {};
+
+    case Opcode::Newarray:
+        store_pc();
+        call_helper(Helpers::allocate_primitive_array, instruction);
+        return {};
+
+    case Opcode::AnewarrayQuick:
+        store_pc();
+        call_helper(Helpers::allocate_array, instruction);
+        return {};
+
+    case Opcode::MultianewarrayQuick:
+        store_pc();
+        call_helper(Helpers::allocate_multi_array, instruction);
+        return {};
+
+    // Converting an object to a string calls its toString
+    case Opcode::InvokedynamicQuick:
+        store_pc();
+        call_helper(Helpers::concatenate_strings, instruction);
+        return {};
+
+    case Opcode::Arraylength:
+        load_object(operand(1));
+        assembler.movsx(int_size, Register::RDX, Address { .base = Register::RAX, .displacement = ArrayObject::length_offset });
+        assembler.mov(slot_size, operand(1), Register::RDX);
+        return {};
+
+    case Opcode::CheckcastQuick:
+        call_helper(Helpers::check_cast, instruction);
+        return {};
+
+    case Opcode::InstanceofQuick:
+        call_helper(Helpers::instance_of, instruction);
+        return {};
+
+    case Opcode::Monitorenter:
+    case Opcode::Monitorexit:
+        assembler.arithmetic(ArithmeticOperation::Compare, slot_size, operand(1), 0);
+        assembler.jump(Condition::Equal, deoptimization_label());
+        return {};
+
+    // Instructions that haven't been quickened yet are resolved (and quickened) by the interpreter, which carries on from there.
+    // Once they've all been quickened, the method is compiled again, see Interpreter::execute_compiled_code().
+    case Opcode::Ldc:
+    case Opcode::LdcW:
+    case Opcode::Ldc2W:
+    case Opcode::Getstatic:
+    case Opcode::Putstatic:
+    case Opcode::Getfield:
+    case Opcode::Putfield:
+    case Opcode::Invokevirtual:
+    case Opcode::Invokespecial:
+    case Opcode::Invokestatic:
+    case Opcode::Invokeinterface:
+    case Opcode::Invokedynamic:
+    case Opcode::New:
+    case Opcode::Anewarray:
+    case Opcode::Multianewarray:
+    case Opcode::Checkcast:
+    case Opcode::Instanceof:
+    // Exceptions are always thrown by the interpreter, which also runs the exception handlers
+    case Opcode::Athrow:
+        assembler.jump(deoptimization_label());
+        return {};
+
+    // wide is folded into the instruction that it modifies when the method is decoded
+    case Opcode::Wide:
+        VERIFY_NOT_REACHED();
+    }
+
+    VERIFY_NOT_REACHED();
+}
+
+}
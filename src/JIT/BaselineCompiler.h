@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "../Interpreter/InstructionStream.h"
+#include "Assembler.h"
+#include "CodeCache.h"
+#include "CompiledCode.h"
+#include "Helpers.h"
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Vector.h>
+#include <initializer_list>
+
+// Forward-declaration
+namespace Interpreter {
+class Heap;
+class Interpreter;
+class Method;
+class TieringPolicy;
+}
+
+namespace JIT {
+
+// Translates the decoded instructions of a hot method into x86-64 machine code, with a fixed template for each instruction.
+//
+// The compiled code keeps the interpreter's frame layout: every local variable and operand stack slot stays in memory, at the same place that the interpreter keeps it.
+// The depth of the operand stack is known before every instruction (see ReferenceMaps::stack_depth()), so each template addresses its operands directly,
+// and there's no stack pointer or dispatch left at run-time. Only a few registers are live across instructions:
+// - rbx: the frame's local variables, which the operand stack immediately follows
+// - r12: the interpreter, which is passed to the helper functions
+// - r13: the frame's pc, which is stored before every safepoint
+//
+// As nothing is cached in registers, deoptimization is trivial: the compiled code returns the index of an instruction, and the interpreter carries on from it with the same frame.
+// Any instruction that would throw an exception, and any instruction that hasn't been quickened yet, hands the frame over to the interpreter like this.
+// It works the other way around too: the interpreter can enter the code at the header of a hot loop, with a frame that it has been executing (see TieringPolicy).
+// Anything that's too large to be a template (invocations, allocations, and some type checks and conversions) calls a helper function, see Helpers.h.
+// While the method can still be optimized, the code counts the back-edges of its loops, and exits with ExitReason::TierUp once a loop is hot enough (see OptimizingCompiler).
+class BaselineCompiler {
+public:
+    // Fails if the method uses jsr or ret, or if the code cache is full
+    static ErrorOr<NonnullOwnPtr<CompiledCode>> compile(Interpreter::Method&, Interpreter::InstructionStream&, Interpreter::Heap&, CodeCache&, Interpreter::TieringPolicy const&);
+
+private:
+    BaselineCompiler(Interpreter::Method&, Interpreter::InstructionStream&, Interpreter::Heap&, Interpreter::TieringPolicy const&);
+
+    ErrorOr<void> compile_method();
+
+    // Saves the callee-saved registers, and loads the frame's registers from the entry point's arguments
+    void emit_prologue();
+    ErrorOr<void> compile_instruction(Interpreter::Instruction&);
+
+    // A slot of the frame, counting from the first local variable
+    Address slot(u32 index) const;
+
+    // The slot `slots_from_top` below the top of the operand stack before the current instruction, 1 is the top, and 0 is where the next value is pushed
+    Address operand(u32 slots_from_top) const;
+
+    // Hands the frame over to the interpreter at the current instruction
+    Label& deoptimization_label();
+
+    // Returns whatever ExitReason (apart from Continue) a helper function returned
+    Label& exit_label();
+
+    // Where a branch jumps to, a back-edge goes through its loop's counter first
+    Label& branch_target(Interpreter::Instruction const&);
+
+    // A label within the current instruction's template
+    Label& create_label();
+
+    void store_constant(Address const&, u64 bits);
+
+    // Sign-extends a 32-bit result into a whole slot, like Value::from_int()
+    void store_int(Address const&, Register);
+
+    // Pops `popped` slots, and pushes them back in the order of `pushed` (1 is the slot that was on top), for the dup and swap instructions
+    void shuffle(u32 popped, std::initializer_list<u32> pushed);
+
+    // Leaves the object in rax, after checking that it isn't null
+    void load_object(Address const&);
+
+    // Leaves the array in rax and the index in rcx, after checking that the array isn't null and that the index is within its bounds
+    void load_array_and_index(Address const& array, Address const& index);
+
+    // Records where the frame has stopped before calling something that can run the garbage collector, like SAFEPOINT() in the interpreter
+    void store_pc();
+
+    // Anything but Continue leaves the compiled code
+    void call_helper(Helper, Interpreter::Instruction&);
+
+    Interpreter::Method& m_method;
+    Interpreter::InstructionStream& m_instruction_stream;
+    Interpreter::Heap& m_heap;
+    Interpreter::TieringPolicy const& m_tiering_policy;
+    u32 m_max_locals { 0 };
+    bool m_counts_backedges { false };
+
+    Assembler m_assembler;
+    Label m_epilogue;
+
+    // One of each for every instruction: its code, its exit stubs (which are only emitted if they are used), and its jump table (for tableswitch)
+    Vector<Label> m_instruction_labels;
+    Vector<Label> m_deoptimization_labels;
+    Vector<Label> m_exit_labels;
+    Vector<bool> m_needs_deoptimization_stub;
+    Vector<bool> m_needs_exit_stub;
+    Vector<Label> m_jump_table_labels;
+
+    // One for every loop, where the interpreter enters the code at the loop's header
+    Vector<Label> m_loop_entry_labels;
+
+    // One for every loop, which counts a back-edge before jumping to the loop's header
+    Vector<Label> m_backedge_labels;
+    Vector<bool> m_needs_backedge_stub;
+
+    // The assembler refers to labels until the code is finalized, so these can't move
+    Vector<NonnullOwnPtr<Label>> m_local_labels;
+
+    // The instruction that is being compiled, and the depth of the operand stack before it
+    u32 m_index { 0 };
+    u32 m_depth { 0 };
+};
+
+}
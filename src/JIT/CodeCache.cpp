@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CodeCache.h"
+#include <AK/StdLibExtras.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace JIT {
+
+CodeCache::CodeCache(u8* base, size_t size)
+    : m_base(base)
+    , m_size(size)
+{
+}
+
+CodeCache::~CodeCache()
+{
+    munmap(m_base, m_size);
+}
+
+ErrorOr<NonnullOwnPtr<CodeCache>> CodeCache::create(size_t size)
+{
+    auto* base = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED)
+        return Error::from_errno(errno);
+
+    auto code_cache = try_make<CodeCache>(static_cast<u8*>(base), size);
+    if (code_cache.is_error())
+        munmap(base, size);
+
+    return code_cache;
+}
+
+ErrorOr<u8 const*> CodeCache::install(ReadonlyBytes code)
+{
+    auto start = align_up_to(m_used, code_alignment);
+    if (code.size() > m_size - min(start, m_size))
+        return Error::from_string_literal("The code cache is full");
+
+    // Only the pages that the code is copied into are made writable
+    auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto first_page = align_down_to(start, page_size);
+    auto end_page = align_up_to(start + code.size(), page_size);
+
+    if (mprotect(m_base + first_page, end_page - first_page, PROT_READ | PROT_WRITE) < 0)
+        return Error::from_errno(errno);
+
+    // x86-64 keeps its instruction cache coherent with stores, so the code can run as soon as it's been copied
+    memcpy(m_base + start, code.data(), code.size());
+
+    if (mprotect(m_base + first_page, end_page - first_page, PROT_READ | PROT_EXEC) < 0)
+        return Error::from_errno(errno);
+
+    m_used = start + code.size();
+    return m_base + start;
+}
+
+}
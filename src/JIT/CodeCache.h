@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Span.h>
+#include <AK/Types.h>
+
+namespace JIT {
+
+// An executable region of memory, which holds the machine code of every compiled method.
+//
+// The region is reserved up front, like the heap, and code is bump-allocated from it. Code is never freed, a method which is compiled again gets new code.
+// Its pages are never writable and executable at the same time: they are made writable while code is copied into them, and then executable again.
+// Only the interpreter thread runs compiled code, and it isn't running any of it while it installs code, so nothing executes a page while it's writable.
+class CodeCache {
+public:
+    static constexpr size_t default_size = 64 * MiB;
+
+    // The start of every method's code is aligned to this, so that its first instructions are in the same cache line
+    static constexpr size_t code_alignment = 16;
+
+    CodeCache(u8* base, size_t size);
+    ~CodeCache();
+
+    static ErrorOr<NonnullOwnPtr<CodeCache>> create(size_t size = default_size);
+
+    // Copies the code into the cache, and returns its address, which is where the code starts executing
+    ErrorOr<u8 const*> install(ReadonlyBytes code);
+
+    // Diagnostics
+    size_t size() const { return m_size; };
+    size_t used() const { return m_used; };
+
+private:
+    u8* m_base;
+    size_t m_size;
+    size_t m_used { 0 };
+};
+
+}
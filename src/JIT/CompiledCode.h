@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+// Forward-declaration
+namespace Interpreter {
+class Interpreter;
+class Value;
+struct Instruction;
+}
+
+namespace JIT {
+
+// Why compiled code has stopped running a method
+enum class ExitReason : u64 {
+    // Only returned by the helper functions that compiled code calls, the compiled code carries on
+    Continue,
+
+    // The method has returned
+    Return,
+
+    // The interpreter has to carry on executing the method, from the instruction that the compiled code stopped at.
+    // The instruction hasn't done anything yet, e.g. it's about to throw an exception, or it still has to be quickened.
+    Deoptimize,
+
+    // Something that the method called has failed, the error has been stored in the interpreter
+    Throw,
+
+    // A loop of baseline code has branched backwards often enough to be optimized, the frame is at the loop's header.
+    // Only returned by baseline code, see Interpreter::run_compiled_code().
+    TierUp,
+};
+
+// Compiled code returns this in rax and rdx, as it is two 8-byte integers
+struct Exit {
+    ExitReason reason;
+
+    // Return: the bits of the returned value
+    // Deoptimize: the index of the instruction that the interpreter carries on from
+    // TierUp: the loop, see InstructionStream::loops()
+    u64 value;
+};
+
+// Compiled code works on the same frame as the interpreter would: the local variables, immediately followed by the operand stack.
+// The frame's pc is updated before every safepoint, so that the garbage collector finds the references in the frame with its reference maps.
+using EntryPoint = Exit (*)(Interpreter::Value* locals, Interpreter::Interpreter& interpreter, Interpreter::Instruction** pc);
+
+// The machine code of a method, which lives in the CodeCache
+class CompiledCode {
+public:
+    // Which compiler the code came from, see TieringPolicy
+    enum class Tier : u8 {
+        Baseline,
+        Optimized,
+    };
+
+    CompiledCode(Tier tier, EntryPoint entry_point, Vector<EntryPoint> loop_entry_points, size_t size)
+        : m_tier(tier)
+        , m_entry_point(entry_point)
+        , m_loop_entry_points(move(loop_entry_points))
+        , m_size(size)
+    {
+    }
+
+    Tier tier() const { return m_tier; };
+
+    EntryPoint entry_point() const { return m_entry_point; };
+
+    // Starts executing at the header of one of the method's loops (see InstructionStream::loops()), with the frame that the interpreter was executing it in.
+    // This is null for a loop that can never be reached.
+    EntryPoint loop_entry_point(u16 loop) const { return m_loop_entry_points[loop]; };
+
+    // The number of bytes of machine code
+    size_t size() const { return m_size; };
+
+    // The number of times that the code has handed a frame over to the interpreter, returns the new count
+    u32 count_deoptimization() { return ++m_deoptimizations; };
+    u32 deoptimizations() const { return m_deoptimizations; };
+
+private:
+    Tier m_tier;
+    EntryPoint m_entry_point;
+    Vector<EntryPoint> m_loop_entry_points;
+    size_t m_size;
+    u32 m_deoptimizations { 0 };
+};
+
+}
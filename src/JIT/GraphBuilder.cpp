@@ -0,0 +1,1660 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "GraphBuilder.h"
+#include "../Descriptor.h"
+#include "../Interpreter/Interpreter.h"
+#include "../Symbol.h"
+#include "Helpers.h"
+
+namespace JIT {
+
+using Interpreter::Instruction;
+using Interpreter::Opcode;
+using Interpreter::Value;
+
+using IR::Block;
+using IR::MemoryKind;
+using IR::Node;
+using IR::Type;
+
+// Methods with more instructions than this are never inlined
+static constexpr size_t max_inlined_instruction_count = 32;
+
+static Type type_for_descriptor(char descriptor)
+{
+    switch (descriptor) {
+    case FieldDescriptor::Boolean:
+    case FieldDescriptor::Byte:
+    case FieldDescriptor::Char:
+    case FieldDescriptor::Short:
+    case FieldDescriptor::Int:
+        return Type::Int;
+    case FieldDescriptor::Long:
+        return Type::Long;
+    case FieldDescriptor::Float:
+        return Type::Float;
+    case FieldDescriptor::Double:
+        return Type::Double;
+    default:
+        return Type::Reference;
+    }
+}
+
+static bool is_conditional_branch(Opcode opcode)
+{
+    switch (opcode) {
+    case Opcode::Ifeq:
+    case Opcode::Ifne:
+    case Opcode::Iflt:
+    case Opcode::Ifge:
+    case Opcode::Ifgt:
+    case Opcode::Ifle:
+    case Opcode::IfIcmpeq:
+    case Opcode::IfIcmpne:
+    case Opcode::IfIcmplt:
+    case Opcode::IfIcmpge:
+    case Opcode::IfIcmpgt:
+    case Opcode::IfIcmple:
+    case Opcode::IfAcmpeq:
+    case Opcode::IfAcmpne:
+    case Opcode::Ifnull:
+    case Opcode::Ifnonnull:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Instructions that never carry on to the next one
+static bool ends_block(Opcode opcode)
+{
+    switch (opcode) {
+    case Opcode::Goto:
+    case Opcode::GotoW:
+    case Opcode::Tableswitch:
+    case Opcode::Lookupswitch:
+    case Opcode::Ireturn:
+    case Opcode::Lreturn:
+    case Opcode::Freturn:
+    case Opcode::Dreturn:
+    case Opcode::Areturn:
+    case Opcode::Return:
+    case Opcode::Athrow:
+    case Opcode::Jsr:
+    case Opcode::JsrW:
+    case Opcode::Ret:
+        return true;
+    default:
+        return is_conditional_branch(opcode);
+    }
+}
+
+// How an instruction uses a local variable, iinc both reads and writes it
+enum class LocalAccess {
+    None,
+    Read,
+    Write,
+    ReadWrite,
+};
+
+static LocalAccess local_access(Opcode opcode)
+{
+    switch (opcode) {
+    case Opcode::Iload:
+    case Opcode::Lload:
+    case Opcode::Fload:
+    case Opcode::Dload:
+    case Opcode::Aload:
+    case Opcode::Iload0:
+    case Opcode::Iload1:
+    case Opcode::Iload2:
+    case Opcode::Iload3:
+    case Opcode::Lload0:
+    case Opcode::Lload1:
+    case Opcode::Lload2:
+    case Opcode::Lload3:
+    case Opcode::Fload0:
+    case Opcode::Fload1:
+    case Opcode::Fload2:
+    case Opcode::Fload3:
+    case Opcode::Dload0:
+    case Opcode::Dload1:
+    case Opcode::Dload2:
+    case Opcode::Dload3:
+    case Opcode::Aload0:
+    case Opcode::Aload1:
+    case Opcode::Aload2:
+    case Opcode::Aload3:
+        return LocalAccess::Read;
+    case Opcode::Istore:
+    case Opcode::Lstore:
+    case Opcode::Fstore:
+    case Opcode::Dstore:
+    case Opcode::Astore:
+    case Opcode::Istore0:
+    case Opcode::Istore1:
+    case Opcode::Istore2:
+    case Opcode::Istore3:
+    case Opcode::Lstore0:
+    case Opcode::Lstore1:
+    case Opcode::Lstore2:
+    case Opcode::Lstore3:
+    case Opcode::Fstore0:
+    case Opcode::Fstore1:
+    case Opcode::Fstore2:
+    case Opcode::Fstore3:
+    case Opcode::Dstore0:
+    case Opcode::Dstore1:
+    case Opcode::Dstore2:
+    case Opcode::Dstore3:
+    case Opcode::Astore0:
+    case Opcode::Astore1:
+    case Opcode::Astore2:
+    case Opcode::Astore3:
+        return LocalAccess::Write;
+    case Opcode::Iinc:
+        return LocalAccess::ReadWrite;
+    default:
+        return LocalAccess::None;
+    }
+}
+
+static void add_edge(Block* from, Block* to)
+{
+    from->successors.append(to);
+    to->predecessors.append(from);
+}
+
+GraphBuilder::GraphBuilder(Interpreter::Method& method, Interpreter::InstructionStream& instruction_stream)
+    : m_method(method)
+    , m_instruction_stream(instruction_stream)
+    , m_instructions(instruction_stream.instructions())
+    , m_max_locals(method.code()->max_locals())
+    , m_max_stack(method.code()->max_stack())
+    , m_graph(make<IR::Graph>())
+{
+}
+
+ErrorOr<NonnullOwnPtr<IR::Graph>> GraphBuilder::build(Interpreter::Method& method, Interpreter::InstructionStream& instruction_stream)
+{
+    GraphBuilder builder(method, instruction_stream);
+    TRY(builder.build_graph());
+    return move(builder.m_graph);
+}
+
+ErrorOr<void> GraphBuilder::build_graph()
+{
+    // Only the interpreter runs exception handlers, the baseline code hands the frame over to it when something throws
+    if (!m_instruction_stream.exception_handlers().is_empty())
+        return Error::from_string_literal("The optimizing compiler doesn't support exception handlers");
+
+    // The return address of a jsr is only known at run-time, so every ret would have to dispatch on it
+    auto const& reference_maps = m_instruction_stream.reference_maps();
+    for (u32 index = 0; index < m_instruction_stream.size(); index++) {
+        auto opcode = m_instructions[index].opcode;
+        if ((opcode == Opcode::Jsr || opcode == Opcode::JsrW || opcode == Opcode::Ret) && reference_maps.stack_depth(index).has_value())
+            return Error::from_string_literal("The optimizing compiler doesn't support jsr and ret");
+    }
+
+    find_blocks();
+    compute_live_locals();
+
+    // Predecessors are built before their successors, apart from the back-edges of loops
+    Vector<Block*> post_order;
+    Vector<u8> visited;
+    visited.resize(m_block_start.size());
+    {
+        Vector<Block*> stack;
+        Vector<size_t> next_successor;
+        auto* first_block = m_block_at[0];
+        visited[first_block->id] = true;
+        stack.append(first_block);
+        next_successor.append(0);
+        while (!stack.is_empty()) {
+            auto* block = stack.last();
+            auto& next = next_successor.last();
+            if (next < block->successors.size()) {
+                auto* successor = block->successors[next++];
+                if (!visited[successor->id]) {
+                    visited[successor->id] = true;
+                    stack.append(successor);
+                    next_successor.append(0);
+                }
+                continue;
+            }
+
+            post_order.append(block);
+            stack.take_last();
+            next_successor.take_last();
+        }
+    }
+
+    for (u32 id = 0; id < visited.size(); id++) {
+        if (visited[id])
+            continue;
+
+        // Only an exception handler could be left unvisited, and build_graph() has rejected those
+        auto* block = m_block_at[m_block_start[id]];
+        while (!block->successors.is_empty())
+            block->remove_successor(block->successors.size() - 1);
+    }
+
+    build_method_entry();
+
+    // Every loop whose header can be reached has an entry of its own, which is where the interpreter hands over a frame that's in the loop
+    auto const& loops = m_instruction_stream.loops();
+    auto& loop_entries = m_graph->loop_entries();
+    loop_entries.resize(loops.size());
+    for (size_t loop = 0; loop < loops.size(); loop++) {
+        auto* header = m_block_at[loops[loop].header];
+        if (!header || !visited[header->id])
+            continue;
+
+        auto* entry = m_graph->create_block();
+        entry->is_entry = true;
+        add_edge(entry, header);
+        loop_entries[loop] = entry;
+    }
+
+    m_exit_slots.resize(m_graph->block_count());
+    m_is_built.resize(m_graph->block_count());
+    m_is_built[m_graph->entry()->id] = true;
+
+    for (size_t i = post_order.size(); i > 0; i--)
+        TRY(build_block(*post_order[i - 1]));
+
+    complete_phis();
+    return {};
+}
+
+void GraphBuilder::find_blocks()
+{
+    auto const& reference_maps = m_instruction_stream.reference_maps();
+    auto instruction_count = static_cast<u32>(m_instruction_stream.size());
+
+    Vector<u8> is_leader;
+    is_leader.resize(instruction_count + 1);
+    is_leader[0] = true;
+    for (u32 index = 0; index < instruction_count; index++) {
+        if (!reference_maps.stack_depth(index).has_value())
+            continue;
+
+        auto const& instruction = m_instructions[index];
+        if (is_conditional_branch(instruction.opcode) || instruction.opcode == Opcode::Goto || instruction.opcode == Opcode::GotoW)
+            is_leader[instruction.operand] = true;
+
+        if (instruction.opcode == Opcode::Tableswitch || instruction.opcode == Opcode::Lookupswitch) {
+            is_leader[instruction.switch_table->default_target] = true;
+            for (auto target : instruction.switch_table->targets)
+                is_leader[target] = true;
+        }
+
+        if (ends_block(instruction.opcode))
+            is_leader[index + 1] = true;
+    }
+
+    m_block_at.resize(instruction_count);
+    for (u32 index = 0; index < instruction_count; index++) {
+        if (!is_leader[index] || !reference_maps.stack_depth(index).has_value())
+            continue;
+
+        auto* block = m_graph->create_block();
+        m_block_at[index] = block;
+        m_block_start.append(index);
+
+        auto end = index;
+        while (true) {
+            end++;
+            if (ends_block(m_instructions[end - 1].opcode) || is_leader[end])
+                break;
+        }
+
+        m_block_end.append(end);
+    }
+
+    for (u32 id = 0; id < m_block_start.size(); id++) {
+        auto* block = m_block_at[m_block_start[id]];
+        auto const& last = m_instructions[m_block_end[id] - 1];
+        if (is_conditional_branch(last.opcode)) {
+            add_edge(block, m_block_at[last.operand]);
+            add_edge(block, m_block_at[m_block_end[id]]);
+        } else if (last.opcode == Opcode::Goto || last.opcode == Opcode::GotoW) {
+            add_edge(block, m_block_at[last.operand]);
+        } else if (last.opcode == Opcode::Tableswitch || last.opcode == Opcode::Lookupswitch) {
+            add_edge(block, m_block_at[last.switch_table->default_target]);
+            for (auto target : last.switch_table->targets)
+                add_edge(block, m_block_at[target]);
+        } else if (!ends_block(last.opcode)) {
+            add_edge(block, m_block_at[m_block_end[id]]);
+        }
+    }
+}
+
+// The blocks that find_blocks() creates are the first blocks of the graph, so a block's id indexes m_block_start.
+// The method has no exception handlers (see build_graph()), so nothing is live once it returns or throws.
+void GraphBuilder::compute_live_locals()
+{
+    auto words = (m_max_locals + 63) / 64;
+    auto block_count = m_block_start.size();
+    m_live_local_words = words;
+    m_live_locals.resize(m_instruction_stream.size() * words);
+
+    Vector<u64> block_live_in;
+    block_live_in.resize(block_count * words);
+
+    auto walk_block = [&](u32 id, bool record) {
+        Vector<u64> live;
+        live.resize(words);
+        for (auto const* successor : m_block_at[m_block_start[id]]->successors) {
+            for (u32 word = 0; word < words; word++)
+                live[word] |= block_live_in[successor->id * words + word];
+        }
+
+        for (auto index = m_block_end[id]; index > m_block_start[id]; index--) {
+            auto const& instruction = m_instructions[index - 1];
+            auto access = local_access(instruction.opcode);
+            auto bit = 1ull << (instruction.index % 64);
+            if (access == LocalAccess::Write)
+                live[instruction.index / 64] &= ~bit;
+            else if (access != LocalAccess::None)
+                live[instruction.index / 64] |= bit;
+
+            if (record) {
+                for (u32 word = 0; word < words; word++)
+                    m_live_locals[(index - 1) * words + word] = live[word];
+            }
+        }
+
+        auto changed = false;
+        for (u32 word = 0; word < words; word++) {
+            changed |= block_live_in[id * words + word] != live[word];
+            block_live_in[id * words + word] = live[word];
+        }
+        return changed;
+    };
+
+    auto changed = true;
+    while (changed) {
+        changed = false;
+        for (auto id = block_count; id > 0; id--)
+            changed |= walk_block(id - 1, false);
+    }
+
+    for (u32 id = 0; id < block_count; id++)
+        walk_block(id, true);
+}
+
+bool GraphBuilder::is_live_local(u32 index, u32 local) const
+{
+    return m_live_locals[index * m_live_local_words + local / 64] & (1ull << (local % 64));
+}
+
+void GraphBuilder::build_method_entry()
+{
+    auto* entry = m_graph->create_block();
+    entry->is_entry = true;
+    m_graph->set_entry(entry);
+    m_block = entry;
+
+    Vector<Node*> slots;
+    slots.resize(m_max_locals + m_max_stack);
+    for (auto& slot : slots)
+        slot = m_graph->undefined();
+
+    // The arguments are the first local variables, starting with `this` for an instance method
+    u32 slot = 0;
+    auto load_argument = [&](Type type) {
+        auto* argument = emit(IR::Opcode::LoadSlot, type);
+        argument->constant = slot;
+        slots[slot] = argument;
+        slot += (type == Type::Long || type == Type::Double) ? 2 : 1;
+    };
+
+    if (!m_method.is_static())
+        load_argument(Type::Reference);
+
+    MUST(for_each_parameter_type(m_method.descriptor().view(), [&](char descriptor) {
+        load_argument(type_for_descriptor(descriptor));
+    }));
+
+    end_block(IR::Opcode::Jump);
+    add_edge(entry, m_block_at[0]);
+    m_exit_slots.resize(m_graph->block_count());
+    m_exit_slots[entry->id] = move(slots);
+}
+
+void GraphBuilder::merge_predecessors(Block& block, u32 depth)
+{
+    auto slot_count = m_max_locals + depth;
+    Vector<Node*> slots;
+    slots.resize(m_max_locals + m_max_stack);
+    for (auto& slot : slots)
+        slot = m_graph->undefined();
+
+    // A loop's header is reached by its back-edges before they have been built, so every slot that's defined when the loop is entered gets a phi.
+    // Phis which turn out to only have a single value are removed by the optimizer.
+    auto has_unbuilt_predecessor = false;
+    for (auto* predecessor : block.predecessors)
+        has_unbuilt_predecessor |= !m_is_built[predecessor->id];
+
+    for (u32 slot = 0; slot < slot_count; slot++) {
+        Node* value = nullptr;
+        auto is_defined = true;
+        auto needs_phi = has_unbuilt_predecessor;
+        for (auto* predecessor : block.predecessors) {
+            if (!m_is_built[predecessor->id])
+                continue;
+
+            auto* predecessor_value = m_exit_slots[predecessor->id][slot];
+            if (predecessor_value == m_graph->undefined())
+                is_defined = false;
+            else if (value && value != predecessor_value)
+                needs_phi = true;
+
+            if (!value)
+                value = predecessor_value;
+        }
+
+        // A slot that isn't defined on every path can't be used by the code after the merge (the verifier ensures this)
+        if (!is_defined || !value)
+            continue;
+
+        if (!needs_phi) {
+            slots[slot] = value;
+            continue;
+        }
+
+        auto* phi = m_graph->create_node(IR::Opcode::Phi, value->type, &block);
+        phi->constant = slot;
+        for (auto* predecessor : block.predecessors)
+            phi->inputs.append(m_is_built[predecessor->id] ? m_exit_slots[predecessor->id][slot] : nullptr);
+
+        block.phis.append(phi);
+        slots[slot] = phi;
+    }
+
+    if (has_unbuilt_predecessor)
+        m_incomplete_blocks.append(&block);
+
+    m_exit_slots[block.id] = move(slots);
+}
+
+ErrorOr<void> GraphBuilder::build_block(Block& block)
+{
+    auto has_predecessor = false;
+    for (auto* predecessor : block.predecessors)
+        has_predecessor |= m_is_built[predecessor->id];
+
+    // Every path to the block ends in a Deoptimize, so it can only be reached from a loop entry (or not at all).
+    // The slots that are defined there aren't known, so the loop entry is dropped, and the interpreter carries on running the loop.
+    if (!has_predecessor) {
+        auto& loop_entries = m_graph->loop_entries();
+        for (auto& loop_entry : loop_entries) {
+            if (loop_entry && !loop_entry->successors.is_empty() && loop_entry->successors.first() == &block) {
+                loop_entry->remove_successor(0);
+                loop_entry = nullptr;
+            }
+        }
+
+        while (!block.successors.is_empty())
+            block.remove_successor(block.successors.size() - 1);
+        return {};
+    }
+
+    auto start = m_block_start[block.id];
+    auto end = m_block_end[block.id];
+    auto depth = *m_instruction_stream.reference_maps().stack_depth(start);
+    merge_predecessors(block, depth);
+
+    Frame frame { m_instruction_stream, m_max_locals, move(m_exit_slots[block.id]), depth };
+    m_block = &block;
+    m_is_built[block.id] = true;
+
+    auto continuation = Continuation::NextInstruction;
+    for (auto index = start; index < end && continuation == Continuation::NextInstruction; index++) {
+        m_index = index;
+        m_frame_state = nullptr;
+        frame.depth = *m_instruction_stream.reference_maps().stack_depth(index);
+        continuation = TRY(translate(frame, m_instructions[index]));
+    }
+
+    if (continuation == Continuation::NextInstruction)
+        end_block(IR::Opcode::Jump);
+
+    m_exit_slots[block.id] = move(frame.slots);
+    return {};
+}
+
+void GraphBuilder::complete_phis()
+{
+    for (auto* block : m_incomplete_blocks) {
+        for (size_t i = 0; i < block->predecessors.size(); i++) {
+            auto* predecessor = block->predecessors[i];
+            for (auto* phi : block->phis) {
+                if (phi->inputs[i])
+                    continue;
+
+                if (predecessor->is_entry) {
+                    // The loop entry loads the value from the interpreter's frame
+                    auto* value = m_graph->create_node(IR::Opcode::LoadSlot, phi->type, predecessor);
+                    value->constant = phi->constant;
+                    predecessor->nodes.append(value);
+                    phi->inputs[i] = value;
+                    continue;
+                }
+
+                phi->inputs[i] = m_exit_slots[predecessor->id][phi->constant];
+            }
+        }
+    }
+
+    // The interpreter's frame is left as it is, so a check that fails here has nothing to write out before it hands the frame back
+    auto const& loops = m_instruction_stream.loops();
+    auto& loop_entries = m_graph->loop_entries();
+    for (size_t loop = 0; loop < loop_entries.size(); loop++) {
+        auto* loop_entry = loop_entries[loop];
+        if (!loop_entry)
+            continue;
+
+        auto header = loops[loop].header;
+        auto depth = *m_instruction_stream.reference_maps().stack_depth(header);
+        Vector<Node*> slots;
+        slots.resize(m_max_locals + depth);
+        for (auto& slot : slots)
+            slot = m_graph->undefined();
+
+        m_block = loop_entry;
+        auto* jump = emit(IR::Opcode::Jump, Type::Void);
+        jump->frame_state = m_graph->create_frame_state(header, move(slots), depth);
+    }
+}
+
+IR::FrameState* GraphBuilder::frame_state(Frame& frame)
+{
+    if (frame.caller_frame_state)
+        return frame.caller_frame_state;
+
+    if (!m_frame_state) {
+        Vector<Node*> slots;
+        slots.append(frame.slots.data(), frame.max_locals + frame.depth);
+        for (u32 local = 0; local < frame.max_locals; local++) {
+            if (slots[local] != m_graph->undefined() && !is_live_local(m_index, local))
+                slots[local] = constant(Type::Reference, 0);
+        }
+
+        m_frame_state = m_graph->create_frame_state(m_index, move(slots), frame.depth);
+    }
+
+    return m_frame_state;
+}
+
+Node* GraphBuilder::emit(IR::Opcode opcode, Type type, Vector<Node*> inputs)
+{
+    auto* node = m_graph->create_node(opcode, type, m_block, move(inputs));
+    m_block->nodes.append(node);
+    return node;
+}
+
+Node* GraphBuilder::emit_check(Frame& frame, IR::Opcode opcode, Vector<Node*> inputs)
+{
+    auto is_inlined = frame.caller_frame_state != nullptr;
+    if (opcode == IR::Opcode::NullCheck) {
+        auto* value = inputs[0];
+        if (value->opcode == IR::Opcode::Call && value->helper == Helpers::allocate_object)
+            return nullptr;
+
+        if (is_inlined && m_inlined_non_null_values.contains_slow(value))
+            return nullptr;
+    }
+
+    if (is_inlined) {
+        m_inlined_method_checks_after_store |= m_inlined_method_has_stored;
+        if (opcode == IR::Opcode::NullCheck)
+            m_inlined_non_null_values.append(inputs[0]);
+    }
+
+    auto* check = emit(opcode, Type::Void, move(inputs));
+    check->frame_state = frame_state(frame);
+    return check;
+}
+
+Node* GraphBuilder::emit_call(Frame& frame, Helper helper, Instruction& instruction, u32 popped_slots, Type result_type, bool is_safepoint)
+{
+    auto* call = emit(IR::Opcode::Call, result_type);
+    call->helper = helper;
+    call->instruction = &instruction;
+    call->popped_slots = popped_slots;
+    call->is_safepoint = is_safepoint;
+    call->frame_state = frame_state(frame);
+
+    pop(frame, popped_slots);
+    if (result_type != Type::Void)
+        push(frame, call, result_type == Type::Long || result_type == Type::Double);
+
+    return call;
+}
+
+void GraphBuilder::end_block(IR::Opcode opcode, Vector<Node*> inputs)
+{
+    emit(opcode, Type::Void, move(inputs));
+}
+
+void GraphBuilder::deoptimize(Frame& frame)
+{
+    auto* terminator = emit(IR::Opcode::Deoptimize, Type::Void);
+    terminator->frame_state = frame_state(frame);
+
+    while (!m_block->successors.is_empty())
+        m_block->remove_successor(m_block->successors.size() - 1);
+}
+
+void GraphBuilder::pop(Frame& frame, u32 slot_count)
+{
+    VERIFY(frame.depth >= slot_count);
+    frame.depth -= slot_count;
+}
+
+void GraphBuilder::push(Frame& frame, Node* value, bool is_wide)
+{
+    frame.slots[frame.max_locals + frame.depth++] = value;
+    if (is_wide)
+        frame.slots[frame.max_locals + frame.depth++] = m_graph->undefined();
+}
+
+bool GraphBuilder::is_inlineable(Interpreter::Method& method)
+{
+    if (method.is_native() || !method.code())
+        return false;
+
+    // Only methods that have already been invoked are decoded, and their instructions quickened.
+    // An exception handler would have to catch exceptions in the middle of the caller's code.
+    auto* instruction_stream = method.decoded_instructions();
+    if (!instruction_stream || instruction_stream->size() > max_inlined_instruction_count || !instruction_stream->exception_handlers().is_empty())
+        return false;
+
+    auto* instructions = instruction_stream->instructions();
+    for (size_t index = 0; index < instruction_stream->size(); index++) {
+        switch (instructions[index].opcode) {
+        case Opcode::Ireturn:
+        case Opcode::Lreturn:
+        case Opcode::Freturn:
+        case Opcode::Dreturn:
+        case Opcode::Areturn:
+        case Opcode::Return:
+            // The body has to run straight through to its only return
+            if (index != instruction_stream->size() - 1)
+                return false;
+            continue;
+
+        case Opcode::Nop:
+        case Opcode::AconstNull:
+        case Opcode::IconstM1:
+        case Opcode::Iconst0:
+        case Opcode::Iconst1:
+        case Opcode::Iconst2:
+        case Opcode::Iconst3:
+        case Opcode::Iconst4:
+        case Opcode::Iconst5:
+        case Opcode::Lconst0:
+        case Opcode::Lconst1:
+        case Opcode::Fconst0:
+        case Opcode::Fconst1:
+        case Opcode::Fconst2:
+        case Opcode::Dconst0:
+        case Opcode::Dconst1:
+        case Opcode::Bipush:
+        case Opcode::Sipush:
+        case Opcode::LdcQuick:
+        case Opcode::Ldc2WQuick:
+        case Opcode::Iload:
+        case Opcode::Lload:
+        case Opcode::Fload:
+        case Opcode::Dload:
+        case Opcode::Aload:
+        case Opcode::Iload0:
+        case Opcode::Iload1:
+        case Opcode::Iload2:
+        case Opcode::Iload3:
+        case Opcode::Lload0:
+        case Opcode::Lload1:
+        case Opcode::Lload2:
+        case Opcode::Lload3:
+        case Opcode::Fload0:
+        case Opcode::Fload1:
+        case Opcode::Fload2:
+        case Opcode::Fload3:
+        case Opcode::Dload0:
+        case Opcode::Dload1:
+        case Opcode::Dload2:
+        case Opcode::Dload3:
+        case Opcode::Aload0:
+        case Opcode::Aload1:
+        case Opcode::Aload2:
+        case Opcode::Aload3:
+        case Opcode::Istore:
+        case Opcode::Lstore:
+        case Opcode::Fstore:
+        case Opcode::Dstore:
+        case Opcode::Astore:
+        case Opcode::Istore0:
+        case Opcode::Istore1:
+        case Opcode::Istore2:
+        case Opcode::Istore3:
+        case Opcode::Lstore0:
+        case Opcode::Lstore1:
+        case Opcode::Lstore2:
+        case Opcode::Lstore3:
+        case Opcode::Fstore0:
+        case Opcode::Fstore1:
+        case Opcode::Fstore2:
+        case Opcode::Fstore3:
+        case Opcode::Dstore0:
+        case Opcode::Dstore1:
+        case Opcode::Dstore2:
+        case Opcode::Dstore3:
+        case Opcode::Astore0:
+        case Opcode::Astore1:
+        case Opcode::Astore2:
+        case Opcode::Astore3:
+        case Opcode::Iaload:
+        case Opcode::Laload:
+        case Opcode::Faload:
+        case Opcode::Daload:
+        case Opcode::Aaload:
+        case Opcode::Baload:
+        case Opcode::Caload:
+        case Opcode::Saload:
+        case Opcode::Pop:
+        case Opcode::Pop2:
+        case Opcode::Dup:
+        case Opcode::DupX1:
+        case Opcode::DupX2:
+        case Opcode::Dup2:
+        case Opcode::Dup2X1:
+        case Opcode::Dup2X2:
+        case Opcode::Swap:
+        case Opcode::Iadd:
+        case Opcode::Ladd:
+        case Opcode::Fadd:
+        case Opcode::Dadd:
+        case Opcode::Isub:
+        case Opcode::Lsub:
+        case Opcode::Fsub:
+        case Opcode::Dsub:
+        case Opcode::Imul:
+        case Opcode::Lmul:
+        case Opcode::Fmul:
+        case Opcode::Dmul:
+        case Opcode::Idiv:
+        case Opcode::Ldiv:
+        case Opcode::Fdiv:
+        case Opcode::Ddiv:
+        case Opcode::Irem:
+        case Opcode::Lrem:
+        case Opcode::Ineg:
+        case Opcode::Lneg:
+        case Opcode::Fneg:
+        case Opcode::Dneg:
+        case Opcode::Ishl:
+        case Opcode::Lshl:
+        case Opcode::Ishr:
+        case Opcode::Lshr:
+        case Opcode::Iushr:
+        case Opcode::Lushr:
+        case Opcode::Iand:
+        case Opcode::Land:
+        case Opcode::Ior:
+        case Opcode::Lor:
+        case Opcode::Ixor:
+        case Opcode::Lxor:
+        case Opcode::Iinc:
+        case Opcode::I2l:
+        case Opcode::I2f:
+        case Opcode::I2d:
+        case Opcode::L2i:
+        case Opcode::L2f:
+        case Opcode::L2d:
+        case Opcode::F2d:
+        case Opcode::D2f:
+        case Opcode::I2b:
+        case Opcode::I2c:
+        case Opcode::I2s:
+        case Opcode::Lcmp:
+        case Opcode::GetstaticQuick:
+        case Opcode::Getstatic2Quick:
+        case Opcode::GetfieldByteQuick:
+        case Opcode::GetfieldCharQuick:
+        case Opcode::GetfieldShortQuick:
+        case Opcode::GetfieldIntQuick:
+        case Opcode::GetfieldLongQuick:
+        case Opcode::GetfieldReferenceQuick:
+        case Opcode::Arraylength:
+            continue;
+
+        // A store is rolled back if a check follows it, see try_inline()
+        case Opcode::PutfieldBooleanQuick:
+        case Opcode::PutfieldByteQuick:
+        case Opcode::PutfieldShortQuick:
+        case Opcode::PutfieldIntQuick:
+        case Opcode::PutfieldLongQuick:
+        case Opcode::PutfieldReferenceQuick:
+            continue;
+
+        // A constructor starts by calling its superclass's constructor
+        case Opcode::InvokenonvirtualQuick:
+            if (!is_object_constructor(*instructions[index].method))
+                return false;
+            continue;
+
+        // Anything that branches, calls, allocates, or stores to an array or a static field
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool GraphBuilder::is_object_constructor(Interpreter::Method& method)
+{
+    // Only java/lang/Object has no superclass, interfaces have java/lang/Object as theirs
+    return method.is_native() && !method.owner().super_class() && method.name() == WellKnownSymbols::the().init;
+}
+
+bool GraphBuilder::try_inline(Frame& frame, Instruction& instruction)
+{
+    // java/lang/Object's constructor does nothing, so only its null check is left, even in an inlined method
+    if (instruction.opcode == Opcode::InvokenonvirtualQuick && is_object_constructor(*instruction.method)) {
+        emit_check(frame, IR::Opcode::NullCheck, { peek(frame, 1) });
+        pop(frame, 1);
+        return true;
+    }
+
+    // Only calls in the method itself are inlined, an inlined method can't call anything anyway
+    if (frame.caller_frame_state)
+        return false;
+
+    // An inlined method's checks hand the frame over to the interpreter before the call, which would run its stores a second time.
+    // So if it needs a check after a store, the inlined code is thrown away, and the method is called instead.
+    auto node_count = m_block->nodes.size();
+    auto slots = frame.slots;
+    auto depth = frame.depth;
+    m_inlined_non_null_values.clear();
+    m_inlined_method_has_stored = false;
+    m_inlined_method_checks_after_store = false;
+
+    auto roll_back_if_needed = [&] {
+        if (!m_inlined_method_checks_after_store)
+            return true;
+
+        m_block->nodes.shrink(node_count);
+        frame.slots = move(slots);
+        frame.depth = depth;
+        return false;
+    };
+
+    switch (instruction.opcode) {
+    case Opcode::InvokestaticQuick: {
+        auto& callee = *instruction.method;
+        if (!is_inlineable(callee))
+            return false;
+
+        inline_method(frame, callee, callee.argument_slots());
+        return roll_back_if_needed();
+    }
+
+    case Opcode::InvokenonvirtualQuick: {
+        auto& callee = *instruction.method;
+        if (!is_inlineable(callee))
+            return false;
+
+        auto* receiver = peek(frame, callee.argument_slots());
+        emit_check(frame, IR::Opcode::NullCheck, { receiver });
+        m_inlined_non_null_values.append(receiver);
+        inline_method(frame, callee, callee.argument_slots());
+        return roll_back_if_needed();
+    }
+
+    // The receiver's class is checked against the only class that the call site has seen, which selects the same method every time
+    case Opcode::InvokevirtualQuick:
+    case Opcode::InvokeinterfaceQuick: {
+        auto& inline_cache = *instruction.inline_cache;
+        if (inline_cache.state() != Interpreter::InlineCache::State::Monomorphic)
+            return false;
+
+        auto& callee = *inline_cache.monomorphic_method();
+        if (!is_inlineable(callee))
+            return false;
+
+        auto argument_slots = inline_cache.resolved_method().argument_slots();
+        auto* receiver = peek(frame, argument_slots);
+        emit_check(frame, IR::Opcode::NullCheck, { receiver });
+        auto* class_check = emit_check(frame, IR::Opcode::ClassCheck, { receiver });
+        class_check->klass = inline_cache.monomorphic_receiver_class();
+        m_inlined_non_null_values.append(receiver);
+        inline_method(frame, callee, argument_slots);
+        return roll_back_if_needed();
+    }
+
+    default:
+        return false;
+    }
+}
+
+void GraphBuilder::inline_method(Frame& caller, Interpreter::Method& callee, u32 argument_slots)
+{
+    auto& instruction_stream = *callee.decoded_instructions();
+    auto max_locals = callee.code()->max_locals();
+
+    Frame frame { instruction_stream, max_locals, {}, 0, frame_state(caller) };
+    frame.slots.resize(max_locals + callee.code()->max_stack());
+    for (auto& slot : frame.slots)
+        slot = m_graph->undefined();
+
+    // The arguments on top of the caller's operand stack become the callee's first local variables
+    for (u32 slot = 0; slot < argument_slots; slot++)
+        frame.slots[slot] = peek(caller, argument_slots - slot);
+
+    auto* instructions = instruction_stream.instructions();
+    size_t index = 0;
+    while (MUST(translate(frame, instructions[index])) == Continuation::NextInstruction)
+        index++;
+
+    pop(caller, argument_slots);
+    switch (instructions[index].opcode) {
+    case Opcode::Ireturn:
+    case Opcode::Freturn:
+    case Opcode::Areturn:
+        push(caller, peek(frame, 1));
+        break;
+    case Opcode::Lreturn:
+    case Opcode::Dreturn:
+        push(caller, peek(frame, 2), true);
+        break;
+    case Opcode::Return:
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+ErrorOr<GraphBuilder::Continuation> GraphBuilder::translate(Frame& frame, Instruction& instruction)
+{
+    using IR::Opcode::Add;
+    using IR::Opcode::And;
+    using IR::Opcode::Divide;
+    using IR::Opcode::Multiply;
+    using IR::Opcode::Or;
+    using IR::Opcode::Remainder;
+    using IR::Opcode::ShiftLeft;
+    using IR::Opcode::ShiftRight;
+    using IR::Opcode::Subtract;
+    using IR::Opcode::UnsignedShiftRight;
+    using IR::Opcode::Xor;
+
+    auto const next = Continuation::NextInstruction;
+    auto is_inlined = frame.caller_frame_state != nullptr;
+
+    // The operands are looked at before anything is popped, so that every check sees the frame as it was before the instruction
+    auto binary = [&](IR::Opcode opcode, Type type) {
+        auto is_wide = type == Type::Long || type == Type::Double;
+        auto slot_count = is_wide ? 2u : 1u;
+        auto* result = emit(opcode, type, { peek(frame, slot_count * 2), peek(frame, slot_count) });
+        pop(frame, slot_count * 2);
+        push(frame, result, is_wide);
+        return next;
+    };
+
+    auto divide = [&](IR::Opcode opcode, Type type) {
+        auto slot_count = type == Type::Long ? 2u : 1u;
+        emit_check(frame, IR::Opcode::ZeroCheck, { peek(frame, slot_count) });
+        return binary(opcode, type);
+    };
+
+    auto shift = [&](IR::Opcode opcode, Type type) {
+        auto slot_count = type == Type::Long ? 2u : 1u;
+        auto* result = emit(opcode, type, { peek(frame, slot_count + 1), peek(frame, 1) });
+        pop(frame, slot_count + 1);
+        push(frame, result, type == Type::Long);
+        return next;
+    };
+
+    auto unary = [&](IR::Opcode opcode, Type from, Type to) {
+        auto from_slots = (from == Type::Long || from == Type::Double) ? 2u : 1u;
+        auto* result = emit(opcode, to, { peek(frame, from_slots) });
+        pop(frame, from_slots);
+        push(frame, result, to == Type::Long || to == Type::Double);
+        return next;
+    };
+
+    auto load_local = [&](bool is_wide) {
+        push(frame, frame.slots[instruction.index], is_wide);
+        return next;
+    };
+
+    auto store_local = [&](bool is_wide) {
+        auto* value = peek(frame, is_wide ? 2 : 1);
+        pop(frame, is_wide ? 2 : 1);
+        frame.slots[instruction.index] = value;
+        if (is_wide)
+            frame.slots[instruction.index + 1] = m_graph->undefined();
+        return next;
+    };
+
+    auto load_element = [&](MemoryKind memory_kind, Type type) {
+        auto* array = peek(frame, 2);
+        auto* index = peek(frame, 1);
+        emit_check(frame, IR::Opcode::NullCheck, { array });
+        emit_check(frame, IR::Opcode::BoundsCheck, { array, index });
+        auto* element = emit(IR::Opcode::LoadElement, type, { array, index });
+        element->memory_kind = memory_kind;
+        pop(frame, 2);
+        push(frame, element, type == Type::Long || type == Type::Double);
+        return next;
+    };
+
+    auto store_element = [&](MemoryKind memory_kind, bool is_wide) {
+        auto value_slots = is_wide ? 2u : 1u;
+        auto* array = peek(frame, value_slots + 2);
+        auto* index = peek(frame, value_slots + 1);
+        auto* value = peek(frame, value_slots);
+        emit_check(frame, IR::Opcode::NullCheck, { array });
+        emit_check(frame, IR::Opcode::BoundsCheck, { array, index });
+        auto* store = emit(IR::Opcode::StoreElement, Type::Void, { array, index, value });
+        store->memory_kind = memory_kind;
+        pop(frame, value_slots + 2);
+        return next;
+    };
+
+    auto load_field = [&](MemoryKind memory_kind, Type type) {
+        auto* object = peek(frame, 1);
+        emit_check(frame, IR::Opcode::NullCheck, { object });
+        auto* field = emit(IR::Opcode::LoadField, type, { object });
+        field->memory_kind = memory_kind;
+        field->constant = instruction.operand;
+        pop(frame, 1);
+        push(frame, field, memory_kind == MemoryKind::Long);
+        return next;
+    };
+
+    auto store_field = [&](MemoryKind memory_kind) {
+        auto value_slots = memory_kind == MemoryKind::Long ? 2u : 1u;
+        auto* object = peek(frame, value_slots + 1);
+        auto* value = peek(frame, value_slots);
+        emit_check(frame, IR::Opcode::NullCheck, { object });
+        auto* store = emit(IR::Opcode::StoreField, Type::Void, { object, value });
+        store->memory_kind = memory_kind;
+        store->constant = instruction.operand;
+        pop(frame, value_slots + 1);
+        m_inlined_method_has_stored |= is_inlined;
+        return next;
+    };
+
+    auto branch = [&](Condition condition, Node* left, Node* right, u32 popped) {
+        auto* terminator = emit(IR::Opcode::Branch, Type::Void, { left, right });
+        terminator->condition = condition;
+        pop(frame, popped);
+        return Continuation::EndOfBlock;
+    };
+
+    // Dup and swap: pops `popped` slots, and pushes them back in the order of `pushed` (1 is the slot that was on top)
+    auto shuffle = [&](u32 popped, std::initializer_list<u32> pushed) {
+        Vector<Node*, 4> values;
+        for (u32 i = 1; i <= popped; i++)
+            values.append(peek(frame, i));
+
+        pop(frame, popped);
+        for (auto value : pushed)
+            frame.slots[frame.max_locals + frame.depth++] = values[value - 1];
+        return next;
+    };
+
+    auto invoke = [&](Helper helper, Interpreter::Method& method) -> ErrorOr<Continuation> {
+        if (try_inline(frame, instruction))
+            return next;
+
+        auto result_type = Type::Void;
+        if (method.return_slots() > 0)
+            result_type = type_for_descriptor(TRY(parse_method_descriptor(method.descriptor().view())).return_type);
+
+        emit_call(frame, helper, instruction, method.argument_slots(), result_type, true);
+        return next;
+    };
+
+    auto zero = [&] { return constant(Type::Int, 0); };
+    auto null = [&] { return constant(Type::Reference, 0); };
+
+    switch (instruction.opcode) {
+    case Opcode::Nop:
+        return next;
+
+    // Constants, in the same form as the slot that the interpreter would push
+    case Opcode::AconstNull:
+        push(frame, null());
+        return next;
+
+    case Opcode::IconstM1:
+    case Opcode::Iconst0:
+    case Opcode::Iconst1:
+    case Opcode::Iconst2:
+    case Opcode::Iconst3:
+    case Opcode::Iconst4:
+    case Opcode::Iconst5:
+    case Opcode::Bipush:
+    case Opcode::Sipush:
+        push(frame, constant(Type::Int, Value::from_int(instruction.operand).bits()));
+        return next;
+
+    case Opcode::Lconst0:
+    case Opcode::Lconst1:
+        push(frame, constant(Type::Long, Value::from_long(instruction.operand).bits()), true);
+        return next;
+
+    case Opcode::Fconst0:
+    case Opcode::Fconst1:
+    case Opcode::Fconst2:
+        push(frame, constant(Type::Float, Value::from_float(static_cast<float>(instruction.operand)).bits()));
+        return next;
+
+    case Opcode::Dconst0:
+    case Opcode::Dconst1:
+        push(frame, constant(Type::Double, Value::from_double(static_cast<double>(instruction.operand)).bits()), true);
+        return next;
+
+    // A string or class constant is loaded from the instruction, as the garbage collector updates it there when the object moves
+    case Opcode::LdcQuick: {
+        if (frame.instruction_stream.is_reference_constant(instruction)) {
+            auto* object = emit(IR::Opcode::LoadConstant, Type::Reference);
+            object->instruction = &instruction;
+            push(frame, object);
+            return next;
+        }
+
+        push(frame, constant(Type::Unknown, instruction.constant_bits));
+        return next;
+    }
+
+    case Opcode::Ldc2WQuick:
+        push(frame, constant(Type::Unknown, instruction.constant_bits), true);
+        return next;
+
+    // Local variables are just values
+    case Opcode::Iload:
+    case Opcode::Fload:
+    case Opcode::Aload:
+    case Opcode::Iload0:
+    case Opcode::Iload1:
+    case Opcode::Iload2:
+    case Opcode::Iload3:
+    case Opcode::Fload0:
+    case Opcode::Fload1:
+    case Opcode::Fload2:
+    case Opcode::Fload3:
+    case Opcode::Aload0:
+    case Opcode::Aload1:
+    case Opcode::Aload2:
+    case Opcode::Aload3:
+        return load_local(false);
+
+    case Opcode::Lload:
+    case Opcode::Dload:
+    case Opcode::Lload0:
+    case Opcode::Lload1:
+    case Opcode::Lload2:
+    case Opcode::Lload3:
+    case Opcode::Dload0:
+    case Opcode::Dload1:
+    case Opcode::Dload2:
+    case Opcode::Dload3:
+        return load_local(true);
+
+    case Opcode::Istore:
+    case Opcode::Fstore:
+    case Opcode::Astore:
+    case Opcode::Istore0:
+    case Opcode::Istore1:
+    case Opcode::Istore2:
+    case Opcode::Istore3:
+    case Opcode::Fstore0:
+    case Opcode::Fstore1:
+    case Opcode::Fstore2:
+    case Opcode::Fstore3:
+    case Opcode::Astore0:
+    case Opcode::Astore1:
+    case Opcode::Astore2:
+    case Opcode::Astore3:
+        return store_local(false);
+
+    case Opcode::Lstore:
+    case Opcode::Dstore:
+    case Opcode::Lstore0:
+    case Opcode::Lstore1:
+    case Opcode::Lstore2:
+    case Opcode::Lstore3:
+    case Opcode::Dstore0:
+    case Opcode::Dstore1:
+    case Opcode::Dstore2:
+    case Opcode::Dstore3:
+        return store_local(true);
+
+    // Arrays
+    case Opcode::Iaload:
+        return load_element(MemoryKind::Int, Type::Int);
+    case Opcode::Laload:
+        return load_element(MemoryKind::Long, Type::Long);
+    case Opcode::Faload:
+        return load_element(MemoryKind::Float, Type::Float);
+    case Opcode::Daload:
+        return load_element(MemoryKind::Double, Type::Double);
+    case Opcode::Aaload:
+        return load_element(MemoryKind::Reference, Type::Reference);
+    case Opcode::Baload:
+        return load_element(MemoryKind::Byte, Type::Int);
+    case Opcode::Caload:
+        return load_element(MemoryKind::Char, Type::Int);
+    case Opcode::Saload:
+        return load_element(MemoryKind::Short, Type::Int);
+
+    case Opcode::Iastore:
+        return store_element(MemoryKind::Int, false);
+    case Opcode::Fastore:
+        return store_element(MemoryKind::Float, false);
+    case Opcode::Lastore:
+        return store_element(MemoryKind::Long, true);
+    case Opcode::Dastore:
+        return store_element(MemoryKind::Double, true);
+    case Opcode::Castore:
+        return store_element(MemoryKind::Char, false);
+    case Opcode::Sastore:
+        return store_element(MemoryKind::Short, false);
+
+    // These have to look at the array's class
+    case Opcode::Aastore:
+        emit_call(frame, Helpers::store_reference_array_element, instruction, 3, Type::Void, false);
+        return next;
+
+    case Opcode::Bastore:
+        emit_call(frame, Helpers::store_byte_array_element, instruction, 3, Type::Void, false);
+        return next;
+
+    case Opcode::Arraylength: {
+        auto* array = peek(frame, 1);
+        emit_check(frame, IR::Opcode::NullCheck, { array });
+        auto* length = emit(IR::Opcode::ArrayLength, Type::Int, { array });
+        pop(frame, 1);
+        push(frame, length);
+        return next;
+    }
+
+    // Stack manipulation
+    case Opcode::Pop:
+        pop(frame, 1);
+        return next;
+
+    case Opcode::Pop2:
+        pop(frame, 2);
+        return next;
+
+    case Opcode::Dup:
+        return shuffle(1, { 1, 1 });
+    case Opcode::DupX1:
+        return shuffle(2, { 1, 2, 1 });
+    case Opcode::DupX2:
+        return shuffle(3, { 1, 3, 2, 1 });
+    case Opcode::Dup2:
+        return shuffle(2, { 2, 1, 2, 1 });
+    case Opcode::Dup2X1:
+        return shuffle(3, { 2, 1, 3, 2, 1 });
+    case Opcode::Dup2X2:
+        return shuffle(4, { 2, 1, 4, 3, 2, 1 });
+    case Opcode::Swap:
+        return shuffle(2, { 1, 2 });
+
+    // Arithmetic
+    case Opcode::Iadd:
+        return binary(Add, Type::Int);
+    case Opcode::Ladd:
+        return binary(Add, Type::Long);
+    case Opcode::Fadd:
+        return binary(Add, Type::Float);
+    case Opcode::Dadd:
+        return binary(Add, Type::Double);
+    case Opcode::Isub:
+        return binary(Subtract, Type::Int);
+    case Opcode::Lsub:
+        return binary(Subtract, Type::Long);
+    case Opcode::Fsub:
+        return binary(Subtract, Type::Float);
+    case Opcode::Dsub:
+        return binary(Subtract, Type::Double);
+    case Opcode::Imul:
+        return binary(Multiply, Type::Int);
+    case Opcode::Lmul:
+        return binary(Multiply, Type::Long);
+    case Opcode::Fmul:
+        return binary(Multiply, Type::Float);
+    case Opcode::Dmul:
+        return binary(Multiply, Type::Double);
+    case Opcode::Fdiv:
+        return binary(Divide, Type::Float);
+    case Opcode::Ddiv:
+        return binary(Divide, Type::Double);
+    case Opcode::Iand:
+        return binary(And, Type::Int);
+    case Opcode::Land:
+        return binary(And, Type::Long);
+    case Opcode::Ior:
+        return binary(Or, Type::Int);
+    case Opcode::Lor:
+        return binary(Or, Type::Long);
+    case Opcode::Ixor:
+        return binary(Xor, Type::Int);
+    case Opcode::Lxor:
+        return binary(Xor, Type::Long);
+
+    // Dividing by zero is left to the interpreter to throw
+    case Opcode::Idiv:
+        return divide(Divide, Type::Int);
+    case Opcode::Ldiv:
+        return divide(Divide, Type::Long);
+    case Opcode::Irem:
+        return divide(Remainder, Type::Int);
+    case Opcode::Lrem:
+        return divide(Remainder, Type::Long);
+
+    case Opcode::Frem:
+        emit_call(frame, Helpers::float_remainder, instruction, 2, Type::Float, false);
+        return next;
+
+    case Opcode::Drem:
+        emit_call(frame, Helpers::double_remainder, instruction, 4, Type::Double, false);
+        return next;
+
+    case Opcode::Ineg:
+        return unary(IR::Opcode::Negate, Type::Int, Type::Int);
+    case Opcode::Lneg:
+        return unary(IR::Opcode::Negate, Type::Long, Type::Long);
+    case Opcode::Fneg:
+        return unary(IR::Opcode::Negate, Type::Float, Type::Float);
+    case Opcode::Dneg:
+        return unary(IR::Opcode::Negate, Type::Double, Type::Double);
+
+    case Opcode::Ishl:
+        return shift(ShiftLeft, Type::Int);
+    case Opcode::Lshl:
+        return shift(ShiftLeft, Type::Long);
+    case Opcode::Ishr:
+        return shift(ShiftRight, Type::Int);
+    case Opcode::Lshr:
+        return shift(ShiftRight, Type::Long);
+    case Opcode::Iushr:
+        return shift(UnsignedShiftRight, Type::Int);
+    case Opcode::Lushr:
+        return shift(UnsignedShiftRight, Type::Long);
+
+    case Opcode::Iinc: {
+        auto* increment = constant(Type::Int, Value::from_int(instruction.operand).bits());
+        frame.slots[instruction.index] = emit(Add, Type::Int, { frame.slots[instruction.index], increment });
+        return next;
+    }
+
+    // Conversions, an int's slot already holds it sign-extended to 64 bits, which is the same long
+    case Opcode::I2l: {
+        auto* value = peek(frame, 1);
+        pop(frame, 1);
+        push(frame, value, true);
+        return next;
+    }
+
+    case Opcode::L2i:
+        return unary(IR::Opcode::LongToInt, Type::Long, Type::Int);
+    case Opcode::I2f:
+        return unary(IR::Opcode::IntToFloat, Type::Int, Type::Float);
+    case Opcode::I2d:
+        return unary(IR::Opcode::IntToDouble, Type::Int, Type::Double);
+    case Opcode::L2f:
+        return unary(IR::Opcode::LongToFloat, Type::Long, Type::Float);
+    case Opcode::L2d:
+        return unary(IR::Opcode::LongToDouble, Type::Long, Type::Double);
+    case Opcode::F2d:
+        return unary(IR::Opcode::FloatToDouble, Type::Float, Type::Double);
+    case Opcode::D2f:
+        return unary(IR::Opcode::DoubleToFloat, Type::Double, Type::Float);
+    case Opcode::I2b:
+        return unary(IR::Opcode::IntToByte, Type::Int, Type::Int);
+    case Opcode::I2c:
+        return unary(IR::Opcode::IntToChar, Type::Int, Type::Int);
+    case Opcode::I2s:
+        return unary(IR::Opcode::IntToShort, Type::Int, Type::Int);
+
+    case Opcode::F2i:
+        emit_call(frame, Helpers::float_to_int, instruction, 1, Type::Int, false);
+        return next;
+
+    case Opcode::F2l:
+        emit_call(frame, Helpers::float_to_long, instruction, 1, Type::Long, false);
+        return next;
+
+    case Opcode::D2i:
+        emit_call(frame, Helpers::double_to_int, instruction, 2, Type::Int, false);
+        return next;
+
+    case Opcode::D2l:
+        emit_call(frame, Helpers::double_to_long, instruction, 2, Type::Long, false);
+        return next;
+
+    // Comparisons
+    case Opcode::Lcmp: {
+        auto* result = emit(IR::Opcode::CompareLong, Type::Int, { peek(frame, 4), peek(frame, 2) });
+        pop(frame, 4);
+        push(frame, result);
+        return next;
+    }
+
+    case Opcode::Fcmpl:
+    case Opcode::Fcmpg:
+        emit_call(frame, Helpers::compare_floats, instruction, 2, Type::Int, false);
+        return next;
+
+    case Opcode::Dcmpl:
+    case Opcode::Dcmpg:
+        emit_call(frame, Helpers::compare_doubles, instruction, 4, Type::Int, false);
+        return next;
+
+    // Branches, an int's slot holds it sign-extended, so every comparison can be done on the whole slot
+    case Opcode::Ifeq:
+        return branch(Condition::Equal, peek(frame, 1), zero(), 1);
+    case Opcode::Ifne:
+        return branch(Condition::NotEqual, peek(frame, 1), zero(), 1);
+    case Opcode::Iflt:
+        return branch(Condition::Less, peek(frame, 1), zero(), 1);
+    case Opcode::Ifge:
+        return branch(Condition::GreaterOrEqual, peek(frame, 1), zero(), 1);
+    case Opcode::Ifgt:
+        return branch(Condition::Greater, peek(frame, 1), zero(), 1);
+    case Opcode::Ifle:
+        return branch(Condition::LessOrEqual, peek(frame, 1), zero(), 1);
+    case Opcode::IfIcmpeq:
+    case Opcode::IfAcmpeq:
+        return branch(Condition::Equal, peek(frame, 2), peek(frame, 1), 2);
+    case Opcode::IfIcmpne:
+    case Opcode::IfAcmpne:
+        return branch(Condition::NotEqual, peek(frame, 2), peek(frame, 1), 2);
+    case Opcode::IfIcmplt:
+        return branch(Condition::Less, peek(frame, 2), peek(frame, 1), 2);
+    case Opcode::IfIcmpge:
+        return branch(Condition::GreaterOrEqual, peek(frame, 2), peek(frame, 1), 2);
+    case Opcode::IfIcmpgt:
+        return branch(Condition::Greater, peek(frame, 2), peek(frame, 1), 2);
+    case Opcode::IfIcmple:
+        return branch(Condition::LessOrEqual, peek(frame, 2), peek(frame, 1), 2);
+    case Opcode::Ifnull:
+        return branch(Condition::Equal, peek(frame, 1), null(), 1);
+    case Opcode::Ifnonnull:
+        return branch(Condition::NotEqual, peek(frame, 1), null(), 1);
+
+    case Opcode::Goto:
+    case Opcode::GotoW:
+        end_block(IR::Opcode::Jump);
+        return Continuation::EndOfBlock;
+
+    case Opcode::Tableswitch:
+    case Opcode::Lookupswitch: {
+        auto* terminator = emit(IR::Opcode::Switch, Type::Void, { peek(frame, 1) });
+        terminator->instruction = &instruction;
+        pop(frame, 1);
+        return Continuation::EndOfBlock;
+    }
+
+    // An inlined method's return value is pushed onto the caller's operand stack by inline_method()
+    case Opcode::Ireturn:
+    case Opcode::Freturn:
+    case Opcode::Areturn:
+        if (!is_inlined)
+            end_block(IR::Opcode::Return, { peek(frame, 1) });
+        return Continuation::EndOfBlock;
+
+    case Opcode::Lreturn:
+    case Opcode::Dreturn:
+        if (!is_inlined)
+            end_block(IR::Opcode::Return, { peek(frame, 2) });
+        return Continuation::EndOfBlock;
+
+    case Opcode::Return:
+        if (!is_inlined)
+            end_block(IR::Opcode::Return);
+        return Continuation::EndOfBlock;
+
+    // Fields
+    case Opcode::GetstaticQuick:
+    case Opcode::Getstatic2Quick: {
+        auto* value = emit(IR::Opcode::LoadStatic, Type::Unknown);
+        value->instruction = &instruction;
+        push(frame, value, instruction.opcode == Opcode::Getstatic2Quick);
+        return next;
+    }
+
+    case Opcode::PutstaticQuick:
+    case Opcode::Putstatic2Quick: {
+        auto value_slots = instruction.opcode == Opcode::PutstaticQuick ? 1u : 2u;
+        auto* store = emit(IR::Opcode::StoreStatic, Type::Void, { peek(frame, value_slots) });
+        store->instruction = &instruction;
+        pop(frame, value_slots);
+        return next;
+    }
+
+    // getfield_int_quick and getfield_long_quick also load floats and doubles
+    case Opcode::GetfieldByteQuick:
+        return load_field(MemoryKind::Byte, Type::Int);
+    case Opcode::GetfieldCharQuick:
+        return load_field(MemoryKind::Char, Type::Int);
+    case Opcode::GetfieldShortQuick:
+        return load_field(MemoryKind::Short, Type::Int);
+    case Opcode::GetfieldIntQuick:
+        return load_field(MemoryKind::Int, Type::Unknown);
+    case Opcode::GetfieldLongQuick:
+        return load_field(MemoryKind::Long, Type::Unknown);
+    case Opcode::GetfieldReferenceQuick:
+        return load_field(MemoryKind::Reference, Type::Reference);
+
+    case Opcode::PutfieldBooleanQuick:
+        return store_field(MemoryKind::Boolean);
+    case Opcode::PutfieldByteQuick:
+        return store_field(MemoryKind::Byte);
+    case Opcode::PutfieldShortQuick:
+        return store_field(MemoryKind::Short);
+    case Opcode::PutfieldIntQuick:
+        return store_field(MemoryKind::Int);
+    case Opcode::PutfieldLongQuick:
+        return store_field(MemoryKind::Long);
+    case Opcode::PutfieldReferenceQuick:
+        return store_field(MemoryKind::Reference);
+
+    // Method invocation
+    case Opcode::InvokevirtualQuick:
+    case Opcode::InvokeinterfaceQuick:
+        return invoke(Helpers::invoke_virtual, instruction.inline_cache->resolved_method());
+
+    case Opcode::InvokenonvirtualQuick:
+        return invoke(Helpers::invoke_nonvirtual, *instruction.method);
+
+    case Opcode::InvokestaticQuick:
+        return invoke(Helpers::invoke_static, *instruction.method);
+
+    // Objects and arrays, allocating can run the garbage collector
+    case Opcode::NewQuick:
+        emit_call(frame, Helpers::allocate_object, instruction, 0, Type::Reference, true);
+        return next;
+
+    case Opcode::Newarray:
+        emit_call(frame, Helpers::allocate_primitive_array, instruction, 1, Type::Reference, true);
+        return next;
+
+    case Opcode::AnewarrayQuick:
+        emit_call(frame, Helpers::allocate_array, instruction, 1, Type::Reference, true);
+        return next;
+
+    case Opcode::MultianewarrayQuick:
+        emit_call(frame, Helpers::allocate_multi_array, instruction, instruction.index, Type::Reference, true);
+        return next;
+
+    // Converting an object to a string calls its toString
+    case Opcode::InvokedynamicQuick:
+        emit_call(frame, Helpers::concatenate_strings, instruction, instruction.string_concatenation->argument_slots, Type::Reference, true);
+        return next;
+
+    // checkcast leaves the object where it is
+    case Opcode::CheckcastQuick:
+        emit_call(frame, Helpers::check_cast, instruction, 0, Type::Void, false);
+        return next;
+
+    case Opcode::InstanceofQuick:
+        emit_call(frame, Helpers::instance_of, instruction, 1, Type::Int, false);
+        return next;
+
+    case Opcode::Monitorenter:
+    case Opcode::Monitorexit:
+        emit_check(frame, IR::Opcode::NullCheck, { peek(frame, 1) });
+        pop(frame, 1);
+        return next;
+
+    // Instructions that haven't been quickened yet are left to the interpreter, which quickens them.
+    // Once the method deoptimizes often enough, its code is thrown away, and it's compiled again.
+    case Opcode::Ldc:
+    case Opcode::LdcW:
+    case Opcode::Ldc2W:
+    case Opcode::Getstatic:
+    case Opcode::Putstatic:
+    case Opcode::Getfield:
+    case Opcode::Putfield:
+    case Opcode::Invokevirtual:
+    case Opcode::Invokespecial:
+    case Opcode::Invokestatic:
+    case Opcode::Invokeinterface:
+    case Opcode::Invokedynamic:
+    case Opcode::New:
+    case Opcode::Anewarray:
+    case Opcode::Multianewarray:
+    case Opcode::Checkcast:
+    case Opcode::Instanceof:
+    // Exceptions are always thrown by the interpreter
+    case Opcode::Athrow:
+        deoptimize(frame);
+        return Continuation::EndOfBlock;
+
+    // These have been rejected by build_graph(), and wide is folded into the instruction that it modifies
+    case Opcode::Jsr:
+    case Opcode::JsrW:
+    case Opcode::Ret:
+    case Opcode::Wide:
+        VERIFY_NOT_REACHED();
+    }
+
+    VERIFY_NOT_REACHED();
+}
+
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "../Interpreter/InstructionStream.h"
+#include "IR.h"
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Vector.h>
+
+// Forward-declaration
+namespace Interpreter {
+class Method;
+}
+
+namespace JIT {
+
+// Lifts the decoded instructions of a method into the optimizing compiler's IR.
+//
+// Each basic block of the bytecode becomes a Block, and every local variable and operand stack slot becomes an SSA value,
+// with a phi wherever different values reach the same slot (see Braun et al., "Simple and Efficient Construction of Static Single Assignment Form").
+// The parameters are typed from the method's descriptor, and everything else from the instruction that produced it.
+//
+// Instructions that could throw are split into a check, which hands the frame over to the interpreter if it fails, and the operation itself.
+// Small methods which are called from a quickened call site (and, for virtual calls, whose inline cache has only seen one receiver class) are inlined,
+// as long as they don't branch or call anything (apart from java/lang/Object's constructor, which does nothing).
+// Their checks hand the frame over to the interpreter at the call site, so an inlined method can only store to a field once it can't fail anymore.
+//
+// A frame state only holds the local variables that the interpreter can still read, the rest are null (see compute_live_locals()).
+// This keeps values which are dead, e.g. the object from the previous iteration of a loop, from looking like they are still used.
+class GraphBuilder {
+public:
+    // Fails if the method uses jsr or ret
+    static ErrorOr<NonnullOwnPtr<IR::Graph>> build(Interpreter::Method&, Interpreter::InstructionStream&);
+
+private:
+    // Where instructions are being translated: the method's own frame, or the frame of an inlined method
+    struct Frame {
+        Interpreter::InstructionStream& instruction_stream;
+        u32 max_locals { 0 };
+
+        // The local variables, followed by the operand stack
+        Vector<IR::Node*> slots;
+        u32 depth { 0 };
+
+        // An inlined method's checks hand the caller's frame over to the interpreter, before the call
+        IR::FrameState* caller_frame_state { nullptr };
+    };
+
+    // What happens after an instruction
+    enum class Continuation {
+        NextInstruction,
+        EndOfBlock,
+    };
+
+    GraphBuilder(Interpreter::Method&, Interpreter::InstructionStream&);
+
+    ErrorOr<void> build_graph();
+
+    // Splits the instructions into basic blocks, and connects them
+    void find_blocks();
+
+    // The usual backwards data-flow analysis over the blocks, for which local variables are read before they are written again
+    void compute_live_locals();
+    bool is_live_local(u32 index, u32 local) const;
+    void build_method_entry();
+    ErrorOr<void> build_block(IR::Block&);
+
+    // Fills in the inputs of phis that come from blocks which were built after the phi, and the values of loop entries
+    void complete_phis();
+
+    // The values of the slots when the block is entered, from the values that its predecessors leave in them
+    void merge_predecessors(IR::Block&, u32 depth);
+
+    ErrorOr<Continuation> translate(Frame&, Interpreter::Instruction&);
+
+    // Translates the body of a small method in place of a call to it, returns false if it can't be inlined
+    bool try_inline(Frame&, Interpreter::Instruction&);
+    static bool is_inlineable(Interpreter::Method&);
+    static bool is_object_constructor(Interpreter::Method&);
+    void inline_method(Frame& caller, Interpreter::Method& callee, u32 argument_slots);
+
+    // The state of the frame before the current instruction
+    IR::FrameState* frame_state(Frame&);
+
+    IR::Node* emit(IR::Opcode, IR::Type, Vector<IR::Node*> inputs = {});
+
+    // A null check of a value that is known not to be null (a new object, or a value that the inlined method has already checked) isn't emitted
+    IR::Node* emit_check(Frame&, IR::Opcode, Vector<IR::Node*> inputs);
+    IR::Node* emit_call(Frame&, Helper, Interpreter::Instruction&, u32 popped_slots, IR::Type result_type, bool is_safepoint);
+    void end_block(IR::Opcode, Vector<IR::Node*> inputs = {});
+
+    // Ends the block with a Deoptimize, which hands the frame over to the interpreter at the current instruction
+    void deoptimize(Frame&);
+
+    IR::Node* constant(IR::Type type, u64 bits) { return m_graph->create_constant(type, bits); };
+
+    // The slot `slots_from_top` below the top of the operand stack, 1 is the top
+    static IR::Node* peek(Frame const& frame, u32 slots_from_top) { return frame.slots[frame.max_locals + frame.depth - slots_from_top]; };
+    void pop(Frame&, u32 slot_count);
+
+    // Pushes a value of a type which takes up two slots if `is_wide`
+    void push(Frame&, IR::Node*, bool is_wide = false);
+
+    Interpreter::Method& m_method;
+    Interpreter::InstructionStream& m_instruction_stream;
+    Interpreter::Instruction* m_instructions { nullptr };
+    u32 m_max_locals { 0 };
+    u32 m_max_stack { 0 };
+
+    NonnullOwnPtr<IR::Graph> m_graph;
+
+    // The block that starts at each instruction, which is null for instructions that don't start one
+    Vector<IR::Block*> m_block_at;
+
+    // Where each block's instructions start, and end (exclusively)
+    Vector<u32> m_block_start;
+    Vector<u32> m_block_end;
+
+    // Indexed by instruction, `m_live_local_words` words each: a bitset of the local variables that are live before the instruction
+    Vector<u64> m_live_locals;
+    u32 m_live_local_words { 0 };
+
+    // The values of the slots once each block has ended, this is empty for blocks that haven't been built (or can't be reached)
+    Vector<Vector<IR::Node*>> m_exit_slots;
+    Vector<u8> m_is_built;
+
+    // The blocks with phis that are missing some of their inputs
+    Vector<IR::Block*> m_incomplete_blocks;
+
+    // The block that is being built, and the instruction of the method's own frame that is being translated
+    IR::Block* m_block { nullptr };
+    u32 m_index { 0 };
+    IR::FrameState* m_frame_state { nullptr };
+
+    // While a method is being inlined: the values that it has checked for null, whether it has stored to a field,
+    // and whether it needs a check after that store (in which case the call isn't inlined after all)
+    Vector<IR::Node*> m_inlined_non_null_values;
+    bool m_inlined_method_has_stored { false };
+    bool m_inlined_method_checks_after_store { false };
+};
+
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Helpers.h"
+#include "../Interpreter/FloatingPoint.h"
+#include "../Interpreter/Interpreter.h"
+#include "../Interpreter/Natives.h"
+#include "../Interpreter/Runtime.h"
+#include <AK/Array.h>
+#include <math.h>
+
+namespace JIT::Helpers {
+
+using Interpreter::ArrayObject;
+using Interpreter::Instruction;
+using Interpreter::Object;
+using Interpreter::Opcode;
+using Interpreter::Value;
+
+// Helpers return Deoptimize instead of throwing an exception themselves, before they have done anything, so that the interpreter throws it from the same instruction.
+// Errors from the runtime (e.g. a class that fails to initialize) are handed to the interpreter as they are.
+#define TRY_OR_THROW(expression)                                    \
+    ({                                                              \
+        auto _result = (expression);                                \
+        if (_result.is_error()) {                                   \
+            interpreter.set_pending_error(_result.release_error()); \
+            return ExitReason::Throw;                               \
+        }                                                           \
+        _result.release_value();                                    \
+    })
+
+static ExitReason invoke(Interpreter::Interpreter& interpreter, Interpreter::Method& method, Value* arguments)
+{
+    auto result = TRY_OR_THROW(interpreter.invoke_in_place(method, arguments));
+    if (method.return_slots() > 0)
+        arguments[0] = result;
+
+    return ExitReason::Continue;
+}
+
+ExitReason invoke_virtual(Interpreter::Interpreter& interpreter, Instruction& instruction, Value* stack_top)
+{
+    auto& inline_cache = *instruction.inline_cache;
+    auto* arguments = stack_top - inline_cache.resolved_method().argument_slots();
+    auto* receiver = arguments[0].as_reference();
+    if (!receiver)
+        return ExitReason::Deoptimize;
+
+    auto* method = inline_cache.lookup(receiver->klass());
+    if (!method) [[unlikely]] {
+        method = receiver->klass().select_method(inline_cache.resolved_method());
+        if (!method || method->is_abstract())
+            return ExitReason::Deoptimize;
+
+        inline_cache.update(receiver->klass(), *method);
+    }
+
+    return invoke(interpreter, *method, arguments);
+}
+
+ExitReason invoke_nonvirtual(Interpreter::Interpreter& interpreter, Instruction& instruction, Value* stack_top)
+{
+    auto* arguments = stack_top - instruction.method->argument_slots();
+    if (!arguments[0].as_reference())
+        return ExitReason::Deoptimize;
+
+    return invoke(interpreter, *instruction.method, arguments);
+}
+
+ExitReason invoke_static(Interpreter::Interpreter& interpreter, Instruction& instruction, Value* stack_top)
+{
+    return invoke(interpreter, *instruction.method, stack_top - instruction.method->argument_slots());
+}
+
+ExitReason allocate_object(Interpreter::Interpreter& interpreter, Instruction& instruction, Value* stack_top)
+{
+    stack_top[0] = Value::from_reference(TRY_OR_THROW(interpreter.runtime().allocate_object(*instruction.klass)));
+    return ExitReason::Continue;
+}
+
+ExitReason allocate_array(Interpreter::Interpreter& interpreter, Instruction& instruction, Value* stack_top)
+{
+    auto length = stack_top[-1].as_int();
+    stack_top[-1] = Value::from_reference(TRY_OR_THROW(interpreter.runtime().allocate_array(*instruction.klass, length)));
+    return ExitReason::Continue;
+}
+
+ExitReason allocate_primitive_array(Interpreter::Interpreter& interpreter, Instruction& instruction, Value* stack_top)
+{
+    auto* array_class = TRY_OR_THROW(interpreter.runtime().primitive_array_class(instruction.index));
+    auto length = stack_top[-1].as_int();
+    stack_top[-1] = Value::from_reference(TRY_OR_THROW(interpreter.runtime().allocate_array(*array_class, length)));
+    return ExitReason::Continue;
+}
+
+ExitReason allocate_multi_array(Interpreter::Interpreter& interpreter, Instruction& instruction, Value* stack_top)
+{
+    auto dimensions = instruction.index;
+    auto* first_length = stack_top - dimensions;
+
+    Array<i32, 255> lengths;
+    for (size_t i = 0; i < dimensions; i++)
+        lengths[i] = first_length[i].as_int();
+
+    first_length[0] = Value::from_reference(TRY_OR_THROW(interpreter.runtime().allocate_multi_array(*instruction.klass, lengths.span().trim(dimensions))));
+    return ExitReason::Continue;
+}
+
+ExitReason concatenate_strings(Interpreter::Interpreter& interpreter, Instruction& instruction, Value* stack_top)
+{
+    auto& string_concatenation = *instruction.string_concatenation;
+    auto* arguments = stack_top - string_concatenation.argument_slots;
+    auto* string = TRY_OR_THROW(Interpreter::concatenate_strings(interpreter.runtime(), string_concatenation, { arguments, string_concatenation.argument_slots }));
+
+    arguments[0] = Value::from_reference(string);
+    return ExitReason::Continue;
+}
+
+ExitReason store_reference_array_element(Interpreter::Interpreter& interpreter, Instruction&, Value* stack_top)
+{
+    auto* value = stack_top[-1].as_reference();
+    auto index = stack_top[-2].as_int();
+    auto* array = static_cast<ArrayObject*>(stack_top[-3].as_reference());
+    if (!array || !array->is_index_in_bounds(index))
+        return ExitReason::Deoptimize;
+
+    auto* component_class = array->klass().component_class();
+    if (value && component_class && !value->klass().is_assignable_to(*component_class))
+        return ExitReason::Deoptimize;
+
+    array->element_at<Object*>(index) = value;
+    interpreter.runtime().heap().record_write(*array);
+    return ExitReason::Continue;
+}
+
+// bastore has to look at the array's class, as values stored into boolean arrays are narrowed to their lowest bit
+ExitReason store_byte_array_element(Interpreter::Interpreter&, Instruction&, Value* stack_top)
+{
+    auto value = stack_top[-1].as_int();
+    auto index = stack_top[-2].as_int();
+    auto* array = static_cast<ArrayObject*>(stack_top[-3].as_reference());
+    if (!array || !array->is_index_in_bounds(index))
+        return ExitReason::Deoptimize;
+
+    if (array->klass().name().view()[1] == FieldDescriptor::Boolean)
+        value &= 1;
+
+    array->element_at<i8>(index) = static_cast<i8>(value);
+    return ExitReason::Continue;
+}
+
+ExitReason check_cast(Interpreter::Interpreter&, Instruction& instruction, Value* stack_top)
+{
+    auto* object = stack_top[-1].as_reference();
+    if (object && !object->klass().is_assignable_to(*instruction.klass))
+        return ExitReason::Deoptimize;
+
+    return ExitReason::Continue;
+}
+
+ExitReason instance_of(Interpreter::Interpreter&, Instruction& instruction, Value* stack_top)
+{
+    auto* object = stack_top[-1].as_reference();
+    auto result = object && object->klass().is_assignable_to(*instruction.klass);
+    stack_top[-1] = Value::from_int(result ? 1 : 0);
+    return ExitReason::Continue;
+}
+
+ExitReason compare_floats(Interpreter::Interpreter&, Instruction& instruction, Value* stack_top)
+{
+    auto nan_result = instruction.opcode == Opcode::Fcmpg ? 1 : -1;
+    stack_top[-2] = Value::from_int(Interpreter::compare_floating_point(stack_top[-2].as_float(), stack_top[-1].as_float(), nan_result));
+    return ExitReason::Continue;
+}
+
+ExitReason compare_doubles(Interpreter::Interpreter&, Instruction& instruction, Value* stack_top)
+{
+    auto nan_result = instruction.opcode == Opcode::Dcmpg ? 1 : -1;
+    stack_top[-4] = Value::from_int(Interpreter::compare_floating_point(stack_top[-4].as_double(), stack_top[-2].as_double(), nan_result));
+    return ExitReason::Continue;
+}
+
+ExitReason float_remainder(Interpreter::Interpreter&, Instruction&, Value* stack_top)
+{
+    stack_top[-2] = Value::from_float(fmodf(stack_top[-2].as_float(), stack_top[-1].as_float()));
+    return ExitReason::Continue;
+}
+
+ExitReason double_remainder(Interpreter::Interpreter&, Instruction&, Value* stack_top)
+{
+    stack_top[-4] = Value::from_double(fmod(stack_top[-4].as_double(), stack_top[-2].as_double()));
+    return ExitReason::Continue;
+}
+
+// NaN and out of range values don't have an x86 equivalent, see floating_point_to_integer()
+ExitReason float_to_int(Interpreter::Interpreter&, Instruction&, Value* stack_top)
+{
+    stack_top[-1] = Value::from_int(Interpreter::floating_point_to_integer<i32>(stack_top[-1].as_float()));
+    return ExitReason::Continue;
+}
+
+ExitReason float_to_long(Interpreter::Interpreter&, Instruction&, Value* stack_top)
+{
+    stack_top[-1] = Value::from_long(Interpreter::floating_point_to_integer<i64>(stack_top[-1].as_float()));
+    return ExitReason::Continue;
+}
+
+ExitReason double_to_int(Interpreter::Interpreter&, Instruction&, Value* stack_top)
+{
+    stack_top[-2] = Value::from_int(Interpreter::floating_point_to_integer<i32>(stack_top[-2].as_double()));
+    return ExitReason::Continue;
+}
+
+ExitReason double_to_long(Interpreter::Interpreter&, Instruction&, Value* stack_top)
+{
+    stack_top[-2] = Value::from_long(Interpreter::floating_point_to_integer<i64>(stack_top[-2].as_double()));
+    return ExitReason::Continue;
+}
+
+#undef TRY_OR_THROW
+
+}
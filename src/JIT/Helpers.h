@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "CompiledCode.h"
+
+namespace JIT {
+
+// The functions that compiled code calls for anything that's too large to be generated inline, e.g. invocations and allocations.
+//
+// Every helper function gets the instruction that is calling it, and the first free slot of the operand stack before the instruction.
+// It takes its operands from the stack and stores its result there, so that everything which the garbage collector can move stays in the frame.
+// Both the baseline and the optimizing compiler call them, the optimizing compiler writes the operands to the frame first.
+using Helper = ExitReason (*)(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+
+namespace Helpers {
+
+// Method invocation, the return value is left where the arguments were
+ExitReason invoke_virtual(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason invoke_nonvirtual(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason invoke_static(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+
+// Objects and arrays, allocating can run the garbage collector
+ExitReason allocate_object(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason allocate_array(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason allocate_primitive_array(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason allocate_multi_array(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+
+// Array stores which have to look at the array's class
+ExitReason store_reference_array_element(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason store_byte_array_element(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+
+// String concatenation at a linked invokedynamic call site, the string is left where the arguments were
+ExitReason concatenate_strings(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+
+// Type checks
+ExitReason check_cast(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason instance_of(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+
+// Floating point operations that don't have a single x86 equivalent
+ExitReason compare_floats(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason compare_doubles(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason float_remainder(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason double_remainder(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason float_to_int(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason float_to_long(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason double_to_int(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+ExitReason double_to_long(Interpreter::Interpreter&, Interpreter::Instruction&, Interpreter::Value* stack_top);
+
+}
+
+}
@@ -0,0 +1,432 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "IR.h"
+#include <AK/Format.h>
+#include <AK/StringBuilder.h>
+
+namespace JIT::IR {
+
+bool Node::has_side_effects() const
+{
+    switch (opcode) {
+    case Opcode::StoreElement:
+    case Opcode::StoreField:
+    case Opcode::StoreStatic:
+    case Opcode::NullCheck:
+    case Opcode::BoundsCheck:
+    case Opcode::ZeroCheck:
+    case Opcode::ClassCheck:
+    case Opcode::NonNegativeCheck:
+    case Opcode::Call:
+    case Opcode::Materialize:
+    case Opcode::Jump:
+    case Opcode::Branch:
+    case Opcode::Switch:
+    case Opcode::Return:
+    case Opcode::Deoptimize:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void Block::remove_successor(size_t successor_index)
+{
+    auto* successor = successors[successor_index];
+    successors.remove(successor_index);
+
+    auto predecessor_index = successor->predecessors.find_first_index_if([&](auto* predecessor) { return predecessor == this; });
+    VERIFY(predecessor_index.has_value());
+    successor->predecessors.remove(*predecessor_index);
+    for (auto* phi : successor->phis)
+        phi->inputs.remove(*predecessor_index);
+}
+
+Graph::Graph()
+{
+    m_undefined = create_constant(Type::Unknown, 0);
+}
+
+Node* Graph::create_node(Opcode opcode, Type type, Block* block, Vector<Node*> inputs)
+{
+    auto node = make<Node>();
+    node->id = m_nodes.size();
+    node->opcode = opcode;
+    node->type = type;
+    node->block = block;
+    node->inputs = move(inputs);
+    m_nodes.append(move(node));
+    return m_nodes.last().ptr();
+}
+
+// Constants don't belong to a block, the compiled code materializes them wherever they are used
+Node* Graph::create_constant(Type type, u64 bits)
+{
+    auto* node = create_node(Opcode::Constant, type, nullptr);
+    node->constant = bits;
+    return node;
+}
+
+Block* Graph::create_block()
+{
+    auto block = make<Block>();
+    block->id = m_all_blocks.size();
+    m_all_blocks.append(move(block));
+    return m_all_blocks.last().ptr();
+}
+
+FrameState* Graph::create_frame_state(u32 index, Vector<Node*> slots, u32 depth)
+{
+    auto frame_state = make<FrameState>();
+    frame_state->index = index;
+    frame_state->slots = move(slots);
+    frame_state->depth = depth;
+    m_frame_states.append(move(frame_state));
+    return m_frame_states.last().ptr();
+}
+
+FrameState* Graph::copy_frame_state(FrameState const& frame_state)
+{
+    auto* copy = create_frame_state(frame_state.index, frame_state.slots, frame_state.depth);
+    copy->virtual_objects = frame_state.virtual_objects;
+    return copy;
+}
+
+// "A Simple, Fast Dominance Algorithm", Cooper, Harvey and Kennedy.
+// https://www.cs.rice.edu/~keith/EMBED/dom.pdf
+//
+// The code has more than one entry, so there's a virtual root above them, which is what a null immediate dominator refers to.
+void Graph::compute_dominators()
+{
+    Vector<Block*> post_order;
+    Vector<u8> visited;
+    visited.resize(m_all_blocks.size());
+
+    // An explicit stack of (block, next successor), as a recursive walk could overflow on a large method
+    Vector<Block*> entries;
+    entries.append(m_entry);
+    for (auto* loop_entry : m_loop_entries) {
+        if (loop_entry)
+            entries.append(loop_entry);
+    }
+
+    for (auto* entry : entries) {
+        Vector<Block*> stack;
+        Vector<size_t> next_successor;
+        visited[entry->id] = true;
+        stack.append(entry);
+        next_successor.append(0);
+        while (!stack.is_empty()) {
+            auto* block = stack.last();
+            auto& next = next_successor.last();
+            if (next < block->successors.size()) {
+                auto* successor = block->successors[next++];
+                if (!visited[successor->id]) {
+                    visited[successor->id] = true;
+                    stack.append(successor);
+                    next_successor.append(0);
+                }
+                continue;
+            }
+
+            post_order.append(block);
+            stack.take_last();
+            next_successor.take_last();
+        }
+    }
+
+    // Edges from blocks that can't be reached don't count, so that they can't keep a phi alive
+    for (auto& block : m_all_blocks) {
+        if (visited[block->id])
+            continue;
+
+        for (size_t i = block->successors.size(); i > 0; i--) {
+            if (visited[block->successors[i - 1]->id])
+                block->remove_successor(i - 1);
+        }
+    }
+
+    m_blocks.clear();
+    for (size_t i = post_order.size(); i > 0; i--) {
+        auto* block = post_order[i - 1];
+        block->order = m_blocks.size();
+        block->immediate_dominator = nullptr;
+        block->dominated.clear();
+        m_blocks.append(block);
+    }
+
+    Vector<u8> is_processed;
+    is_processed.resize(m_all_blocks.size());
+    for (auto* entry : entries)
+        is_processed[entry->id] = true;
+
+    auto intersect = [&](Block* a, Block* b) -> Block* {
+        while (a != b) {
+            while (a && b && a->order > b->order)
+                a = a->immediate_dominator;
+            while (a && b && b->order > a->order)
+                b = b->immediate_dominator;
+            if (!a || !b)
+                return nullptr;
+        }
+
+        return a;
+    };
+
+    auto changed = true;
+    while (changed) {
+        changed = false;
+        for (auto* block : m_blocks) {
+            if (block->is_entry)
+                continue;
+
+            Block* new_dominator = nullptr;
+            auto has_dominator = false;
+            for (auto* predecessor : block->predecessors) {
+                if (!is_processed[predecessor->id])
+                    continue;
+
+                new_dominator = has_dominator ? intersect(predecessor, new_dominator) : predecessor;
+                has_dominator = true;
+            }
+
+            if (!is_processed[block->id] || block->immediate_dominator != new_dominator) {
+                block->immediate_dominator = new_dominator;
+                is_processed[block->id] = true;
+                changed = true;
+            }
+        }
+    }
+
+    for (auto* block : m_blocks) {
+        if (block->immediate_dominator)
+            block->immediate_dominator->dominated.append(block);
+    }
+
+    // Numbering the dominator tree in pre-order makes dominates() a pair of comparisons
+    u32 counter = 0;
+    for (auto* root : m_blocks) {
+        if (root->immediate_dominator)
+            continue;
+
+        Vector<Block*> stack;
+        Vector<size_t> next_child;
+        stack.append(root);
+        next_child.append(0);
+        root->dominator_tree_start = counter++;
+        while (!stack.is_empty()) {
+            auto* block = stack.last();
+            auto& next = next_child.last();
+            if (next < block->dominated.size()) {
+                auto* child = block->dominated[next++];
+                child->dominator_tree_start = counter++;
+                stack.append(child);
+                next_child.append(0);
+                continue;
+            }
+
+            block->dominator_tree_end = counter;
+            stack.take_last();
+            next_child.take_last();
+        }
+    }
+}
+
+bool Graph::dominates(Block const* dominator, Block const* block) const
+{
+    return dominator->dominator_tree_start <= block->dominator_tree_start && block->dominator_tree_end <= dominator->dominator_tree_end;
+}
+
+void Graph::apply_replacements()
+{
+    auto resolve = [](Node* node) {
+        while (node->replacement)
+            node = node->replacement;
+        return node;
+    };
+
+    for (auto* block : m_blocks) {
+        for (auto* phi : block->phis) {
+            for (auto*& input : phi->inputs)
+                input = resolve(input);
+        }
+
+        for (auto* node : block->nodes) {
+            for (auto*& input : node->inputs)
+                input = resolve(input);
+            for (auto& field : node->fields)
+                field.value = resolve(field.value);
+        }
+    }
+
+    for (auto& frame_state : m_frame_states) {
+        for (auto*& value : frame_state->slots)
+            value = resolve(value);
+
+        for (auto& object : frame_state->virtual_objects) {
+            for (auto& field : object.fields)
+                field.value = resolve(field.value);
+        }
+    }
+
+    for (auto* block : m_blocks) {
+        block->phis.remove_all_matching([](Node* phi) { return phi->replacement != nullptr; });
+        block->nodes.remove_all_matching([](Node* node) { return node->replacement != nullptr; });
+    }
+}
+
+StringView opcode_name(Opcode opcode)
+{
+    switch (opcode) {
+#define __ENUMERATE_OPCODE(name) \
+    case Opcode::name:           \
+        return #name##sv;
+        __ENUMERATE_OPCODE(Constant)
+        __ENUMERATE_OPCODE(LoadSlot)
+        __ENUMERATE_OPCODE(Phi)
+        __ENUMERATE_OPCODE(Add)
+        __ENUMERATE_OPCODE(Subtract)
+        __ENUMERATE_OPCODE(Multiply)
+        __ENUMERATE_OPCODE(Divide)
+        __ENUMERATE_OPCODE(Remainder)
+        __ENUMERATE_OPCODE(And)
+        __ENUMERATE_OPCODE(Or)
+        __ENUMERATE_OPCODE(Xor)
+        __ENUMERATE_OPCODE(ShiftLeft)
+        __ENUMERATE_OPCODE(ShiftRight)
+        __ENUMERATE_OPCODE(UnsignedShiftRight)
+        __ENUMERATE_OPCODE(Negate)
+        __ENUMERATE_OPCODE(IntToFloat)
+        __ENUMERATE_OPCODE(IntToDouble)
+        __ENUMERATE_OPCODE(IntToByte)
+        __ENUMERATE_OPCODE(IntToChar)
+        __ENUMERATE_OPCODE(IntToShort)
+        __ENUMERATE_OPCODE(LongToInt)
+        __ENUMERATE_OPCODE(LongToFloat)
+        __ENUMERATE_OPCODE(LongToDouble)
+        __ENUMERATE_OPCODE(FloatToDouble)
+        __ENUMERATE_OPCODE(DoubleToFloat)
+        __ENUMERATE_OPCODE(CompareLong)
+        __ENUMERATE_OPCODE(ArrayLength)
+        __ENUMERATE_OPCODE(LoadElement)
+        __ENUMERATE_OPCODE(StoreElement)
+        __ENUMERATE_OPCODE(LoadField)
+        __ENUMERATE_OPCODE(StoreField)
+        __ENUMERATE_OPCODE(LoadStatic)
+        __ENUMERATE_OPCODE(StoreStatic)
+        __ENUMERATE_OPCODE(LoadConstant)
+        __ENUMERATE_OPCODE(NullCheck)
+        __ENUMERATE_OPCODE(BoundsCheck)
+        __ENUMERATE_OPCODE(ZeroCheck)
+        __ENUMERATE_OPCODE(ClassCheck)
+        __ENUMERATE_OPCODE(NonNegativeCheck)
+        __ENUMERATE_OPCODE(Call)
+        __ENUMERATE_OPCODE(Materialize)
+        __ENUMERATE_OPCODE(Jump)
+        __ENUMERATE_OPCODE(Branch)
+        __ENUMERATE_OPCODE(Switch)
+        __ENUMERATE_OPCODE(Return)
+        __ENUMERATE_OPCODE(Deoptimize)
+#undef __ENUMERATE_OPCODE
+    }
+
+    VERIFY_NOT_REACHED();
+}
+
+StringView type_name(Type type)
+{
+    switch (type) {
+    case Type::Void:
+        return "void"sv;
+    case Type::Int:
+        return "int"sv;
+    case Type::Long:
+        return "long"sv;
+    case Type::Float:
+        return "float"sv;
+    case Type::Double:
+        return "double"sv;
+    case Type::Reference:
+        return "reference"sv;
+    case Type::Unknown:
+        return "unknown"sv;
+    }
+
+    VERIFY_NOT_REACHED();
+}
+
+static void append_value(StringBuilder& builder, Node const* node)
+{
+    if (node->is_constant())
+        builder.appendff(" {:#x}", node->constant);
+    else
+        builder.appendff(" v{}", node->id);
+}
+
+static void dump_node(Node const& node)
+{
+    StringBuilder builder;
+    if (node.type != Type::Void)
+        builder.appendff("v{}: {} = ", node.id, type_name(node.type));
+
+    builder.append(opcode_name(node.opcode));
+    for (auto const* input : node.inputs)
+        append_value(builder, input);
+
+    if (node.opcode == Opcode::LoadSlot || node.opcode == Opcode::Phi || node.opcode == Opcode::LoadField || node.opcode == Opcode::StoreField)
+        builder.appendff(" [{}]", node.constant);
+
+    for (auto const& field : node.fields) {
+        builder.appendff(" [{}] =", field.offset);
+        append_value(builder, field.value);
+    }
+
+    if (node.frame_state) {
+        builder.appendff(" @{}", node.frame_state->index);
+        for (auto const& object : node.frame_state->virtual_objects) {
+            builder.appendff(" v{} {{", object.allocation->id);
+            for (auto const& field : object.fields) {
+                builder.appendff(" [{}] =", field.offset);
+                append_value(builder, field.value);
+            }
+            builder.append(" }"sv);
+        }
+    }
+
+    dbgln("    {}", builder.string_view());
+}
+
+void Graph::dump() const
+{
+    for (auto const* block : m_blocks) {
+        StringBuilder header;
+        header.appendff("block{}", block->id);
+        if (block->is_entry)
+            header.append(" (entry)"sv);
+
+        header.append(" <-"sv);
+        for (auto const* predecessor : block->predecessors)
+            header.appendff(" block{}", predecessor->id);
+
+        if (block->immediate_dominator)
+            header.appendff(", dominated by block{}", block->immediate_dominator->id);
+
+        dbgln("  {}:", header.string_view());
+        for (auto const* phi : block->phis)
+            dump_node(*phi);
+        for (auto const* node : block->nodes)
+            dump_node(*node);
+
+        StringBuilder successors;
+        for (auto const* successor : block->successors)
+            successors.appendff(" block{}", successor->id);
+        if (!block->successors.is_empty())
+            dbgln("    ->{}", successors.string_view());
+    }
+}
+
+}
@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "Assembler.h"
+#include "Helpers.h"
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+// Forward-declaration
+namespace Interpreter {
+class Class;
+struct Instruction;
+}
+
+// The optimizing compiler's intermediate representation: a control flow graph of basic blocks, whose values are in SSA form.
+//
+// Every value is defined exactly once, by a Node, and each Node refers to the values that it uses directly.
+// Where control flow merges, a phi picks the value that came from each predecessor.
+// Java's types are only tracked as far as the compiler needs them: every value lives in 8 bytes, in the same form as a slot of the interpreter's frame (see Interpreter::Value).
+namespace JIT::IR {
+
+enum class Type : u8 {
+    // Nodes that don't produce a value, e.g. stores, checks, and the end of a block
+    Void,
+
+    Int,
+    Long,
+    Float,
+    Double,
+    Reference,
+
+    // A slot whose type isn't known, e.g. an ldc constant or a static field, or a phi of two different types (which nothing can use)
+    Unknown,
+};
+
+// How a field or an array element is laid out in memory, see Class::lay_out_instance_fields()
+enum class MemoryKind : u8 {
+    Boolean,
+    Byte,
+    Char,
+    Short,
+    Int,
+    Float,
+    Long,
+    Double,
+    Reference,
+};
+
+enum class Opcode : u8 {
+    // The value of `constant`
+    Constant,
+
+    // A slot of the interpreter's frame, at an entry of the code: `slot` is counted from the first local variable
+    LoadSlot,
+
+    // Picks `inputs[i]` when the block was entered from `predecessors[i]`
+    Phi,
+
+    // Arithmetic, the operands have the same type as the result, apart from the distance of a shift which is always an int
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Remainder,
+    And,
+    Or,
+    Xor,
+    ShiftLeft,
+    ShiftRight,
+    UnsignedShiftRight,
+    Negate,
+
+    // Conversions between types, there's no conversion from int to long as an int's slot already holds it sign-extended to 64 bits
+    IntToFloat,
+    IntToDouble,
+    IntToByte,
+    IntToChar,
+    IntToShort,
+    LongToInt,
+    LongToFloat,
+    LongToDouble,
+    FloatToDouble,
+    DoubleToFloat,
+
+    // lcmp
+    CompareLong,
+
+    // Memory: the array or object is always the first input, it has already been checked for null
+    ArrayLength,
+    LoadElement,
+    StoreElement,
+    LoadField,
+    StoreField,
+    LoadStatic,
+    StoreStatic,
+
+    // An ldc constant which is an object, it's loaded from the instruction as the garbage collector can move it
+    LoadConstant,
+
+    // Checks hand the frame over to the interpreter at `frame_state` if they fail, just before the instruction which would have thrown
+    NullCheck,
+    BoundsCheck,
+    ZeroCheck,
+    ClassCheck,
+    NonNegativeCheck,
+
+    // Calls `helper` with the frame written out to the interpreter's frame, see OptimizingCompiler
+    Call,
+
+    // Allocates an object of the class of `instruction` (a new), and stores `fields` into it.
+    // This is an allocation that the optimizer has moved down to where the object escapes, see Optimizer::replace_allocations().
+    Materialize,
+
+    // The end of a block: Jump has one successor, Branch has two (taken and not taken), and Switch has the default target followed by each case's target
+    Jump,
+    Branch,
+    Switch,
+    Return,
+    Deoptimize,
+};
+
+struct Block;
+struct Node;
+
+// A field of an object whose allocation has been removed, and the value that it holds
+struct VirtualField {
+    u32 offset { 0 };
+    MemoryKind memory_kind { MemoryKind::Int };
+    Node* value { nullptr };
+};
+
+// An object whose allocation has been removed by the optimizer, which a frame state still refers to.
+// The compiled code allocates it when it hands the frame over to the interpreter, as the interpreter expects to find it in the frame.
+struct VirtualObject {
+    // The removed allocation, the slots that hold it refer to the object
+    Node* allocation { nullptr };
+
+    // The fields that have been stored to, the rest are still zero
+    Vector<VirtualField> fields;
+};
+
+// The state of the interpreter's frame before an instruction, which the compiled code writes out when it hands the frame over to the interpreter
+struct FrameState {
+    // The instruction that the interpreter carries on from
+    u32 index { 0 };
+
+    // The value of every local variable and operand stack slot, the second slot of a long or double is undefined
+    Vector<Node*> slots;
+
+    // The depth of the operand stack, the last `depth` slots are the operand stack
+    u32 depth { 0 };
+
+    Vector<VirtualObject> virtual_objects;
+
+    VirtualObject const* virtual_object(Node const* value) const
+    {
+        for (auto const& object : virtual_objects) {
+            if (object.allocation == value)
+                return &object;
+        }
+
+        return nullptr;
+    }
+};
+
+struct Node {
+    u32 id { 0 };
+    Opcode opcode { Opcode::Constant };
+    Type type { Type::Void };
+    Block* block { nullptr };
+    Vector<Node*> inputs;
+
+    // Constant: the value's bits, LoadSlot and Phi: the slot (counted from the first local variable), LoadField and StoreField: the field's offset
+    u64 constant { 0 };
+
+    MemoryKind memory_kind { MemoryKind::Int };
+
+    // Branch: how the first input compares to the second when the branch is taken
+    Condition condition { Condition::Equal };
+
+    // Materialize: the fields that are stored to once the object has been allocated
+    Vector<VirtualField> fields;
+
+    // The instruction that the node was created from, where it needs one: calls, statics, constants and switches
+    Interpreter::Instruction* instruction { nullptr };
+
+    // ClassCheck: the only class that the object can have
+    Interpreter::Class const* klass { nullptr };
+
+    // Call: the helper, and how many slots it pops off the operand stack, its result replaces them.
+    // `is_safepoint` calls can run the garbage collector, so the frame's pc is stored before them.
+    Helper helper { nullptr };
+    u32 popped_slots { 0 };
+    bool is_safepoint { false };
+
+    // Checks, calls (and Materialize) and Deoptimize, and the Jump at the end of a loop entry (where there's nothing to write out, for the checks that the optimizer adds there)
+    FrameState* frame_state { nullptr };
+
+    // Set once the node has been replaced by another value, see Graph::apply_replacements()
+    Node* replacement { nullptr };
+
+    bool is_constant() const { return opcode == Opcode::Constant; };
+    i32 as_int() const { return static_cast<i32>(constant); };
+    i64 as_long() const { return static_cast<i64>(constant); };
+
+    bool is_terminator() const { return opcode >= Opcode::Jump; };
+    bool is_check() const { return opcode >= Opcode::NullCheck && opcode <= Opcode::NonNegativeCheck; };
+
+    // Anything that must stay where it is, even if nothing uses its value
+    bool has_side_effects() const;
+};
+
+struct Block {
+    u32 id { 0 };
+
+    Vector<Node*> phis;
+
+    // Everything apart from the phis, the last node is the block's terminator
+    Vector<Node*> nodes;
+
+    // The order of the predecessors is the order of each phi's inputs
+    Vector<Block*> predecessors;
+    Vector<Block*> successors;
+
+    // Where compiled code can be entered: the start of the method, or the header of a loop (see InstructionStream::loops())
+    bool is_entry { false };
+
+    // The closest block that every path from an entry to this block goes through, this is null for the entries (and for blocks that more than one entry reaches)
+    Block* immediate_dominator { nullptr };
+    Vector<Block*> dominated;
+
+    // The position in reverse post-order, and in a pre-order walk of the dominator tree (see Graph::dominates())
+    u32 order { 0 };
+    u32 dominator_tree_start { 0 };
+    u32 dominator_tree_end { 0 };
+
+    Node* terminator() const { return nodes.last(); };
+
+    // Removes the edge to a successor, and the inputs that the successor's phis took from it
+    void remove_successor(size_t successor_index);
+};
+
+class Graph {
+public:
+    Graph();
+
+    Node* create_node(Opcode, Type, Block*, Vector<Node*> inputs = {});
+    Node* create_constant(Type, u64 bits);
+    Block* create_block();
+    FrameState* create_frame_state(u32 index, Vector<Node*> slots, u32 depth);
+    FrameState* copy_frame_state(FrameState const&);
+
+    // A slot which hasn't been written on every path, its value is never used
+    Node* undefined() const { return m_undefined; };
+
+    // Where the method starts, and where each loop of the method can be entered (null if it can't be entered)
+    Block* entry() const { return m_entry; };
+    void set_entry(Block* block) { m_entry = block; };
+    Vector<Block*>& loop_entries() { return m_loop_entries; };
+
+    Vector<NonnullOwnPtr<Node>> const& nodes() const { return m_nodes; };
+    size_t block_count() const { return m_all_blocks.size(); };
+
+    // Every block that can be reached from an entry, in reverse post-order, which is only up to date after compute_dominators()
+    Vector<Block*> const& blocks() const { return m_blocks; };
+
+    // Computes the reverse post-order and the dominator tree, and removes every block that can't be reached anymore
+    void compute_dominators();
+    bool dominates(Block const* dominator, Block const* block) const;
+
+    // Replaces every use of each node that has a replacement (see Node::replacement) with what replaces it
+    void apply_replacements();
+
+    // Calls the callback with every value that the node uses, including the values of its frame state.
+    // A virtual object isn't a value, but the values of its fields are.
+    template<typename Callback>
+    void for_each_use(Node& node, Callback callback)
+    {
+        for (auto* input : node.inputs)
+            callback(input);
+
+        for (auto const& field : node.fields)
+            callback(field.value);
+
+        if (!node.frame_state)
+            return;
+
+        auto const& frame_state = *node.frame_state;
+        for (auto* value : frame_state.slots) {
+            if (!frame_state.virtual_object(value))
+                callback(value);
+        }
+
+        for (auto const& object : frame_state.virtual_objects) {
+            for (auto const& field : object.fields)
+                callback(field.value);
+        }
+    }
+
+    // Logged with --log-jit
+    void dump() const;
+
+private:
+    Vector<NonnullOwnPtr<Node>> m_nodes;
+    Vector<NonnullOwnPtr<Block>> m_all_blocks;
+    Vector<NonnullOwnPtr<FrameState>> m_frame_states;
+    Vector<Block*> m_blocks;
+
+    Node* m_undefined { nullptr };
+    Block* m_entry { nullptr };
+    Vector<Block*> m_loop_entries;
+};
+
+StringView opcode_name(Opcode);
+StringView type_name(Type);
+
+}
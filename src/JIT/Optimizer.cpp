@@ -0,0 +1,1006 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Optimizer.h"
+#include "../Interpreter/Class.h"
+#include "../Interpreter/InstructionStream.h"
+#include "../Interpreter/Value.h"
+#include "Helpers.h"
+#include <AK/HashMap.h>
+#include <AK/NumericLimits.h>
+#include <AK/StdLibExtras.h>
+
+namespace JIT {
+
+using Interpreter::Value;
+
+using IR::Block;
+using IR::Node;
+using IR::Opcode;
+using IR::Type;
+
+static Node* resolve(Node* node)
+{
+    while (node->replacement)
+        node = node->replacement;
+    return node;
+}
+
+static bool is_same_constant(Node const* a, Node const* b)
+{
+    return a->is_constant() && b->is_constant() && a->type == b->type && a->constant == b->constant;
+}
+
+static void remove_node(Node* node)
+{
+    node->block->nodes.remove_first_matching([&](auto* other) { return other == node; });
+}
+
+static Condition negate(Condition condition)
+{
+    // The condition codes come in pairs, which only differ in their lowest bit
+    return static_cast<Condition>(to_underlying(condition) ^ 1);
+}
+
+Optimizer::Optimizer(IR::Graph& graph, Interpreter::Method& method)
+    : m_graph(graph)
+    , m_method(method)
+{
+}
+
+void Optimizer::optimize(IR::Graph& graph, Interpreter::Method& method)
+{
+    Optimizer optimizer(graph, method);
+    graph.compute_dominators();
+
+    // Folding a branch can make more phis trivial, and removing a phi can give more constants to fold
+    auto simplify = [&] {
+        while (true) {
+            auto changed = optimizer.remove_trivial_phis();
+            changed |= optimizer.fold_constants();
+            if (!changed)
+                break;
+
+            graph.compute_dominators();
+        }
+    };
+
+    simplify();
+    optimizer.eliminate_null_checks();
+    optimizer.eliminate_dead_code();
+    if (optimizer.replace_allocations())
+        simplify();
+
+    optimizer.eliminate_bounds_checks();
+    optimizer.eliminate_dead_code();
+    optimizer.split_critical_edges();
+    graph.compute_dominators();
+}
+
+bool Optimizer::remove_trivial_phis()
+{
+    auto changed = false;
+    auto removed_any = true;
+    while (removed_any) {
+        removed_any = false;
+        for (auto* block : m_graph.blocks()) {
+            for (auto* phi : block->phis) {
+                if (phi->replacement)
+                    continue;
+
+                // A phi that only picks between itself and a single other value is that value.
+                // Undefined isn't the same as any other value, as it's never written out to the interpreter's frame.
+                Node* value = nullptr;
+                auto is_trivial = true;
+                for (auto* input : phi->inputs) {
+                    input = resolve(input);
+                    if (input == phi || input == value)
+                        continue;
+
+                    if (!value) {
+                        value = input;
+                        continue;
+                    }
+
+                    if (input == m_graph.undefined() || value == m_graph.undefined() || !is_same_constant(input, value)) {
+                        is_trivial = false;
+                        break;
+                    }
+                }
+
+                if (!is_trivial || !value)
+                    continue;
+
+                phi->replacement = value;
+                removed_any = true;
+                changed = true;
+            }
+        }
+    }
+
+    if (changed)
+        m_graph.apply_replacements();
+
+    return changed;
+}
+
+// Folds integer arithmetic and comparisons, floating point arithmetic is left alone as it depends on the rounding mode
+static Optional<u64> fold(Node const& node)
+{
+    for (auto const* input : node.inputs) {
+        if (!input->is_constant())
+            return {};
+    }
+
+    auto int_result = [](u32 value) { return Value::from_int(static_cast<i32>(value)).bits(); };
+    auto long_result = [](u64 value) { return Value::from_long(static_cast<i64>(value)).bits(); };
+
+    if (node.opcode == Opcode::CompareLong) {
+        auto a = node.inputs[0]->as_long();
+        auto b = node.inputs[1]->as_long();
+        return int_result(a < b ? -1 : (a > b ? 1 : 0));
+    }
+
+    if (node.type == Type::Int && node.inputs.size() == 2) {
+        auto a = node.inputs[0]->as_int();
+        auto b = node.inputs[1]->as_int();
+        switch (node.opcode) {
+        case Opcode::Add:
+            return int_result(static_cast<u32>(a) + static_cast<u32>(b));
+        case Opcode::Subtract:
+            return int_result(static_cast<u32>(a) - static_cast<u32>(b));
+        case Opcode::Multiply:
+            return int_result(static_cast<u32>(a) * static_cast<u32>(b));
+        case Opcode::And:
+            return int_result(a & b);
+        case Opcode::Or:
+            return int_result(a | b);
+        case Opcode::Xor:
+            return int_result(a ^ b);
+        case Opcode::ShiftLeft:
+            return int_result(static_cast<u32>(a) << (b & 31));
+        case Opcode::ShiftRight:
+            return int_result(a >> (b & 31));
+        case Opcode::UnsignedShiftRight:
+            return int_result(static_cast<u32>(a) >> (b & 31));
+        case Opcode::Divide:
+            if (b == 0)
+                return {};
+            return int_result(b == -1 ? 0u - static_cast<u32>(a) : a / b);
+        case Opcode::Remainder:
+            if (b == 0)
+                return {};
+            return int_result(b == -1 ? 0 : a % b);
+        default:
+            return {};
+        }
+    }
+
+    if (node.type == Type::Long && node.inputs.size() == 2) {
+        auto a = node.inputs[0]->as_long();
+        auto b = node.inputs[1]->as_long();
+        switch (node.opcode) {
+        case Opcode::Add:
+            return long_result(static_cast<u64>(a) + static_cast<u64>(b));
+        case Opcode::Subtract:
+            return long_result(static_cast<u64>(a) - static_cast<u64>(b));
+        case Opcode::Multiply:
+            return long_result(static_cast<u64>(a) * static_cast<u64>(b));
+        case Opcode::And:
+            return long_result(a & b);
+        case Opcode::Or:
+            return long_result(a | b);
+        case Opcode::Xor:
+            return long_result(a ^ b);
+        case Opcode::ShiftLeft:
+            return long_result(static_cast<u64>(a) << (b & 63));
+        case Opcode::ShiftRight:
+            return long_result(a >> (b & 63));
+        case Opcode::UnsignedShiftRight:
+            return long_result(static_cast<u64>(a) >> (b & 63));
+        case Opcode::Divide:
+            if (b == 0)
+                return {};
+            return long_result(b == -1 ? 0u - static_cast<u64>(a) : a / b);
+        case Opcode::Remainder:
+            if (b == 0)
+                return {};
+            return long_result(b == -1 ? 0 : a % b);
+        default:
+            return {};
+        }
+    }
+
+    if (node.inputs.size() != 1)
+        return {};
+
+    auto const& value = *node.inputs[0];
+    switch (node.opcode) {
+    case Opcode::Negate:
+        if (node.type == Type::Int)
+            return int_result(0u - static_cast<u32>(value.as_int()));
+        if (node.type == Type::Long)
+            return long_result(0u - static_cast<u64>(value.as_long()));
+        return {};
+    case Opcode::LongToInt:
+        return int_result(static_cast<u32>(value.as_long()));
+    case Opcode::IntToByte:
+        return int_result(static_cast<i8>(value.as_int()));
+    case Opcode::IntToChar:
+        return int_result(static_cast<u16>(value.as_int()));
+    case Opcode::IntToShort:
+        return int_result(static_cast<i16>(value.as_int()));
+    default:
+        return {};
+    }
+}
+
+// Both operands are in the same form as a slot, so they compare the same way as the values that they hold
+static bool evaluate(Condition condition, i64 left, i64 right)
+{
+    switch (condition) {
+    case Condition::Equal:
+        return left == right;
+    case Condition::NotEqual:
+        return left != right;
+    case Condition::Less:
+        return left < right;
+    case Condition::GreaterOrEqual:
+        return left >= right;
+    case Condition::Greater:
+        return left > right;
+    case Condition::LessOrEqual:
+        return left <= right;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+void Optimizer::fold_to_jump(Block& block, size_t successor_index)
+{
+    for (size_t i = block.successors.size(); i > 0; i--) {
+        if (i - 1 != successor_index)
+            block.remove_successor(i - 1);
+    }
+
+    auto* terminator = block.terminator();
+    terminator->opcode = Opcode::Jump;
+    terminator->inputs.clear();
+    terminator->instruction = nullptr;
+}
+
+bool Optimizer::fold_constants()
+{
+    auto changed = false;
+    for (auto* block : m_graph.blocks()) {
+        Vector<Node*> removed_checks;
+        for (auto* node : block->nodes) {
+            for (auto*& input : node->inputs)
+                input = resolve(input);
+
+            if (node->opcode == Opcode::ZeroCheck && node->inputs[0]->is_constant() && node->inputs[0]->constant != 0) {
+                removed_checks.append(node);
+                continue;
+            }
+
+            if (node->opcode == Opcode::Branch && node->inputs[0]->is_constant() && node->inputs[1]->is_constant()) {
+                auto is_taken = evaluate(node->condition, node->inputs[0]->as_long(), node->inputs[1]->as_long());
+                fold_to_jump(*block, is_taken ? 0 : 1);
+                changed = true;
+                continue;
+            }
+
+            if (node->opcode == Opcode::Switch && node->inputs[0]->is_constant()) {
+                auto const& switch_table = *node->instruction->switch_table;
+                auto value = node->inputs[0]->as_int();
+
+                // The successors are the default target, followed by each case's target
+                size_t successor_index = 0;
+                if (switch_table.matches.is_empty()) {
+                    auto case_index = static_cast<i64>(value) - switch_table.low;
+                    if (case_index >= 0 && case_index < static_cast<i64>(switch_table.targets.size()))
+                        successor_index = case_index + 1;
+                } else {
+                    for (size_t i = 0; i < switch_table.matches.size(); i++) {
+                        if (switch_table.matches[i] == value)
+                            successor_index = i + 1;
+                    }
+                }
+
+                fold_to_jump(*block, successor_index);
+                changed = true;
+                continue;
+            }
+
+            auto result = fold(*node);
+            if (!result.has_value())
+                continue;
+
+            node->replacement = m_graph.create_constant(node->type, *result);
+            changed = true;
+        }
+
+        for (auto* check : removed_checks)
+            remove_node(check);
+        changed |= !removed_checks.is_empty();
+    }
+
+    if (changed)
+        m_graph.apply_replacements();
+
+    return changed;
+}
+
+Optimizer::EdgeFact Optimizer::edge_fact(Block const& block) const
+{
+    // The edge only tells us something about the block if every path to the block goes through it
+    if (block.predecessors.size() != 1)
+        return {};
+
+    auto const& predecessor = *block.predecessors.first();
+    auto const& terminator = *predecessor.terminator();
+    if (terminator.opcode != Opcode::Branch || predecessor.successors[0] == predecessor.successors[1])
+        return {};
+
+    auto condition = predecessor.successors[0] == &block ? terminator.condition : negate(terminator.condition);
+    auto* left = terminator.inputs[0];
+    auto* right = terminator.inputs[1];
+    switch (condition) {
+    case Condition::NotEqual:
+        if (right->is_constant() && right->constant == 0)
+            return { .non_null = left };
+        return {};
+    case Condition::Less:
+        return { .left = left, .right = right };
+    case Condition::Greater:
+        return { .left = right, .right = left };
+    default:
+        return {};
+    }
+}
+
+template<typename Enter, typename Leave>
+void Optimizer::walk_dominator_tree(Enter enter, Leave leave)
+{
+    for (auto* root : m_graph.blocks()) {
+        if (root->immediate_dominator)
+            continue;
+
+        Vector<Block*> stack;
+        Vector<size_t> next_child;
+        enter(*root);
+        stack.append(root);
+        next_child.append(0);
+        while (!stack.is_empty()) {
+            auto* block = stack.last();
+            auto& next = next_child.last();
+            if (next < block->dominated.size()) {
+                auto* child = block->dominated[next++];
+                enter(*child);
+                stack.append(child);
+                next_child.append(0);
+                continue;
+            }
+
+            leave(*block);
+            stack.take_last();
+            next_child.take_last();
+        }
+    }
+}
+
+void Optimizer::eliminate_null_checks()
+{
+    // Whether each value is known not to be null, in the block that is being visited
+    Vector<u8> is_non_null;
+    is_non_null.resize(m_graph.nodes().size());
+    Vector<Node*> facts;
+    Vector<size_t> fact_counts;
+
+    auto learn = [&](Node* value) {
+        if (is_non_null[value->id])
+            return;
+
+        is_non_null[value->id] = true;
+        facts.append(value);
+    };
+
+    auto is_allocation = [](Node const& node) {
+        if (node.opcode == Opcode::Materialize)
+            return true;
+
+        return node.opcode == Opcode::Call
+            && (node.helper == Helpers::allocate_object || node.helper == Helpers::allocate_array || node.helper == Helpers::allocate_primitive_array || node.helper == Helpers::allocate_multi_array);
+    };
+
+    Vector<Node*> removed_checks;
+    walk_dominator_tree(
+        [&](Block& block) {
+            fact_counts.append(facts.size());
+            if (auto fact = edge_fact(block); fact.non_null)
+                learn(fact.non_null);
+
+            for (auto* node : block.nodes) {
+                // `this` is never null
+                if (node->opcode == Opcode::LoadSlot && &block == m_graph.entry() && node->constant == 0 && !m_method.is_static())
+                    learn(node);
+
+                if (node->opcode == Opcode::LoadConstant || is_allocation(*node))
+                    learn(node);
+
+                if (node->opcode == Opcode::BoundsCheck || node->opcode == Opcode::ClassCheck)
+                    learn(node->inputs[0]);
+
+                if (node->opcode != Opcode::NullCheck)
+                    continue;
+
+                if (is_non_null[node->inputs[0]->id]) {
+                    removed_checks.append(node);
+                    continue;
+                }
+
+                learn(node->inputs[0]);
+            }
+        },
+        [&](Block&) {
+            auto count = fact_counts.take_last();
+            while (facts.size() > count)
+                is_non_null[facts.take_last()->id] = false;
+        });
+
+    for (auto* check : removed_checks)
+        remove_node(check);
+}
+
+// Scalar replacement, after "Partial Escape Analysis and Scalar Replacement for Java", Stadler, Würthinger and Mössenböck.
+// https://doi.org/10.1145/2544137.2544157
+//
+// An object escapes once anything other than its own field accesses, null checks and class checks can see it.
+// Until then, the values stored into its fields are tracked instead, and its field loads are replaced by those values:
+// - If it never escapes, its allocation is removed entirely.
+// - If it escapes at a call that comes before every other escape, the allocation is moved down to just before that call (a Materialize),
+//   so the paths that never reach the call never allocate the object.
+// A check that can fail before the object escapes hands the frame over to the interpreter, which expects to find the object.
+// So the check's frame state gets a VirtualObject, and the compiled code allocates the object when the check fails (see OptimizingCompiler).
+//
+// Unlike the paper, the fields aren't merged where control flow merges, so the fields are only stored to in the allocation's block,
+// and nothing that the call reaches can use the object without the call dominating it.
+bool Optimizer::replace_allocations()
+{
+    // Copied, as this removes the allocations from their blocks
+    Vector<Node*> allocations;
+    for (auto* block : m_graph.blocks()) {
+        for (auto* node : block->nodes) {
+            if (node->opcode == Opcode::Call && node->helper == Helpers::allocate_object)
+                allocations.append(node);
+        }
+    }
+
+    auto changed = false;
+    for (auto* allocation : allocations)
+        changed |= replace_allocation(*allocation);
+
+    if (changed)
+        m_graph.apply_replacements();
+
+    return changed;
+}
+
+bool Optimizer::replace_allocation(Node& allocation)
+{
+    auto* home = allocation.block;
+    auto& klass = *allocation.instruction->klass;
+
+    auto holds = [&](Vector<IR::VirtualField> const& fields) {
+        return fields.find_first_index_if([&](auto const& field) { return field.value == &allocation; }).has_value();
+    };
+
+    // Every node that uses the object, and whether that's through its inputs, or through its frame state.
+    // A phi's use is at the end of the predecessor that the object comes from. Another virtual object holding this one isn't followed.
+    struct Use {
+        Node* user { nullptr };
+        bool is_frame_state { false };
+    };
+
+    struct PhiUse {
+        Node* phi { nullptr };
+        Block* predecessor { nullptr };
+    };
+
+    Vector<Use> uses;
+    Vector<PhiUse> phi_uses;
+    for (auto* block : m_graph.blocks()) {
+        for (auto* phi : block->phis) {
+            for (size_t i = 0; i < phi->inputs.size(); i++) {
+                if (phi->inputs[i] == &allocation)
+                    phi_uses.append(PhiUse { phi, block->predecessors[i] });
+            }
+        }
+
+        for (auto* node : block->nodes) {
+            if (holds(node->fields))
+                return false;
+
+            if (node->inputs.contains_slow(&allocation))
+                uses.append(Use { node, false });
+
+            if (auto const* frame_state = node->frame_state) {
+                if (frame_state->slots.contains_slow(&allocation))
+                    uses.append(Use { node, true });
+
+                for (auto const& object : frame_state->virtual_objects) {
+                    if (holds(object.fields))
+                        return false;
+                }
+            }
+        }
+    }
+
+    // Whether the object can be removed from the use: a field access, a check that can't fail because of the object, or the frame state of a check
+    auto is_replaceable = [&](Use const& use) {
+        auto const& user = *use.user;
+        if (use.is_frame_state)
+            return user.is_check() || user.opcode == Opcode::Deoptimize;
+
+        switch (user.opcode) {
+        case Opcode::LoadField:
+        case Opcode::NullCheck:
+            return true;
+        case Opcode::StoreField:
+            return user.inputs[0] == &allocation && user.inputs[1] != &allocation;
+        case Opcode::ClassCheck:
+            return user.klass == &klass;
+        default:
+            return false;
+        }
+    };
+
+    auto position = [](Node const& node) {
+        return *node.block->nodes.find_first_index_if([&](auto const* other) { return other == &node; });
+    };
+
+    auto dominates = [&](Node const& dominator, Block const& block, size_t index) {
+        if (dominator.block == &block)
+            return position(dominator) < index;
+        return m_graph.dominates(dominator.block, &block);
+    };
+
+    // The escape, which has to come before every other escape: a call, where the frame is written out anyway
+    Node* escape = nullptr;
+    auto escapes = !phi_uses.is_empty();
+    for (auto const& use : uses) {
+        if (is_replaceable(use))
+            continue;
+
+        escapes = true;
+        auto& user = *use.user;
+        if (user.opcode != Opcode::Call || !user.frame_state->virtual_objects.is_empty())
+            continue;
+
+        auto dominates_every_escape = true;
+        for (auto const& other : uses) {
+            if (!is_replaceable(other) && other.user != &user)
+                dominates_every_escape &= dominates(user, *other.user->block, position(*other.user));
+        }
+
+        for (auto const& phi_use : phi_uses)
+            dominates_every_escape &= dominates(user, *phi_use.predecessor, phi_use.predecessor->nodes.size());
+
+        if (dominates_every_escape) {
+            escape = &user;
+            break;
+        }
+    }
+
+    if (escapes && !escape)
+        return false;
+
+    // The blocks that can run after the escape without allocating the object again
+    Vector<u8> is_after_escape_block;
+    is_after_escape_block.resize(m_graph.block_count());
+    if (escape) {
+        Vector<Block*> worklist;
+        worklist.append(escape->block);
+        while (!worklist.is_empty()) {
+            for (auto* successor : worklist.take_last()->successors) {
+                if (successor == home || is_after_escape_block[successor->id])
+                    continue;
+
+                is_after_escape_block[successor->id] = true;
+                worklist.append(successor);
+            }
+        }
+    }
+
+    // A call in a loop that doesn't allocate the object again would see a new one on every iteration
+    if (escape && is_after_escape_block[escape->block->id])
+        return false;
+
+    auto is_after_escape = [&](Block const& block, size_t index) {
+        if (!escape)
+            return false;
+        if (&block == escape->block && index > position(*escape))
+            return true;
+        return is_after_escape_block[block.id] != 0;
+    };
+
+    // Everything after the escape uses the allocated object, so the escape has to dominate it, and everything before it uses the fields
+    for (auto const& use : uses) {
+        auto& user = *use.user;
+        if (&user == escape)
+            continue;
+
+        if (is_after_escape(*user.block, position(user))) {
+            if (!dominates(*escape, *user.block, position(user)))
+                return false;
+            continue;
+        }
+
+        if (!is_replaceable(use))
+            return false;
+
+        // A store in another block would need a phi of the field's values
+        if (!use.is_frame_state && user.opcode == Opcode::StoreField && user.block != home)
+            return false;
+    }
+
+    for (auto const& phi_use : phi_uses) {
+        auto end = phi_use.predecessor->nodes.size();
+        if (!is_after_escape(*phi_use.predecessor, end) || !dominates(*escape, *phi_use.predecessor, end))
+            return false;
+    }
+
+    // The fields of the object, as each node of the allocation's block sees them, and then as everything after the block (and the escape) sees them
+    auto end_of_fields = escape && escape->block == home ? position(*escape) : home->nodes.size();
+    Vector<IR::VirtualField> fields;
+    HashMap<Node*, Vector<IR::VirtualField>> fields_at;
+    for (auto index = position(allocation) + 1; index < end_of_fields; index++) {
+        auto* node = home->nodes[index];
+        fields_at.set(node, fields);
+        if (node->opcode != Opcode::StoreField || node->inputs[0] != &allocation)
+            continue;
+
+        auto field = IR::VirtualField { static_cast<u32>(node->constant), node->memory_kind, node->inputs[1] };
+        if (auto existing = fields.find_first_index_if([&](auto const& other) { return other.offset == field.offset; }); existing.has_value())
+            fields[*existing] = field;
+        else
+            fields.append(field);
+    }
+
+    auto fields_seen_by = [&](Node* user) -> Vector<IR::VirtualField> const& {
+        if (user->block == home)
+            return fields_at.find(user)->value;
+        return fields;
+    };
+
+    // A reference can't be kept anywhere that the garbage collector doesn't see while the object is being allocated, so it has to be in the frame
+    auto can_allocate_at = [](IR::FrameState const& frame_state, Vector<IR::VirtualField> const& fields) {
+        for (auto const& field : fields) {
+            if (field.memory_kind == IR::MemoryKind::Reference && !field.value->is_constant() && !frame_state.slots.contains_slow(field.value))
+                return false;
+        }
+        return true;
+    };
+
+    for (auto const& use : uses) {
+        if (use.is_frame_state && use.user != escape && !is_after_escape(*use.user->block, position(*use.user))) {
+            if (!can_allocate_at(*use.user->frame_state, fields_seen_by(use.user)))
+                return false;
+        }
+    }
+
+    // The escape's frame state, where the slots that will hold the object are still null
+    IR::FrameState* materialize_frame_state = nullptr;
+    if (escape) {
+        materialize_frame_state = m_graph.copy_frame_state(*escape->frame_state);
+        for (auto*& value : materialize_frame_state->slots) {
+            if (value == &allocation)
+                value = m_graph.create_constant(Type::Reference, 0);
+        }
+
+        if (!can_allocate_at(*materialize_frame_state, fields))
+            return false;
+    }
+
+    // A load sees what the store left in memory, which is narrowed to the field's size (and a boolean to its lowest bit)
+    auto replace_load = [&](Node& load, Vector<IR::VirtualField> const& seen) {
+        auto index = seen.find_first_index_if([&](auto const& field) { return field.offset == load.constant; });
+        if (!index.has_value()) {
+            auto type = load.memory_kind == IR::MemoryKind::Reference ? Type::Reference : (load.memory_kind == IR::MemoryKind::Long ? Type::Long : Type::Int);
+            load.replacement = m_graph.create_constant(type, 0);
+            return;
+        }
+
+        auto const& field = seen[*index];
+        load.inputs = { field.value };
+        if (field.memory_kind == IR::MemoryKind::Boolean) {
+            load.opcode = Opcode::And;
+            load.inputs.append(m_graph.create_constant(Type::Int, 1));
+        } else if (load.memory_kind == IR::MemoryKind::Byte) {
+            load.opcode = Opcode::IntToByte;
+        } else if (load.memory_kind == IR::MemoryKind::Char) {
+            load.opcode = Opcode::IntToChar;
+        } else if (load.memory_kind == IR::MemoryKind::Short) {
+            load.opcode = Opcode::IntToShort;
+        } else {
+            load.replacement = field.value;
+            return;
+        }
+
+        load.type = Type::Int;
+    };
+
+    // Everything after the escape uses the object that the Materialize allocates
+    Node* materialize = nullptr;
+    if (escape) {
+        materialize = m_graph.create_node(Opcode::Materialize, Type::Reference, escape->block);
+        materialize->instruction = allocation.instruction;
+        materialize->fields = fields;
+        materialize->frame_state = materialize_frame_state;
+        materialize->is_safepoint = true;
+    }
+
+    Vector<Node*> removed;
+    for (auto const& use : uses) {
+        auto& user = *use.user;
+        if (&user == escape || is_after_escape(*user.block, position(user))) {
+            if (use.is_frame_state) {
+                user.frame_state = m_graph.copy_frame_state(*user.frame_state);
+                for (auto*& value : user.frame_state->slots) {
+                    if (value == &allocation)
+                        value = materialize;
+                }
+            }
+
+            for (auto*& input : user.inputs) {
+                if (input == &allocation)
+                    input = materialize;
+            }
+            continue;
+        }
+
+        auto const& seen = fields_seen_by(&user);
+        if (use.is_frame_state) {
+            user.frame_state = m_graph.copy_frame_state(*user.frame_state);
+            user.frame_state->virtual_objects.append(IR::VirtualObject { &allocation, seen });
+            continue;
+        }
+
+        if (user.opcode == Opcode::LoadField)
+            replace_load(user, seen);
+        else
+            removed.append(&user);
+    }
+
+    for (auto const& phi_use : phi_uses) {
+        for (size_t i = 0; i < phi_use.phi->inputs.size(); i++) {
+            if (phi_use.phi->block->predecessors[i] == phi_use.predecessor && phi_use.phi->inputs[i] == &allocation)
+                phi_use.phi->inputs[i] = materialize;
+        }
+    }
+
+    if (escape)
+        escape->block->nodes.insert(position(*escape), materialize);
+
+    removed.append(&allocation);
+    for (auto* node : removed)
+        remove_node(node);
+
+    return true;
+}
+
+bool Optimizer::is_non_negative(Node* value)
+{
+    if (value->id < m_non_negative.size() && m_non_negative[value->id] != 0)
+        return m_non_negative[value->id] == 1;
+
+    auto result = false;
+    switch (value->opcode) {
+    case Opcode::Constant:
+        result = value->as_long() >= 0 && value->as_long() <= NumericLimits<i32>::max();
+        break;
+    case Opcode::ArrayLength:
+    case Opcode::IntToChar:
+        result = true;
+        break;
+    case Opcode::And:
+        result = value->type == Type::Int && (is_non_negative(value->inputs[0]) || is_non_negative(value->inputs[1]));
+        break;
+    case Opcode::Phi:
+        result = is_induction_variable(value);
+        break;
+    default:
+        break;
+    }
+
+    if (value->id < m_non_negative.size())
+        m_non_negative[value->id] = result ? 1 : 2;
+
+    return result;
+}
+
+// A loop's induction variable starts at a non-negative value, and is incremented by 1 on each back-edge, after it has been compared with something larger (so it can't overflow)
+bool Optimizer::is_induction_variable(Node* phi)
+{
+    // Anything that leads back to the same phi is assumed to be negative, until it has been proven otherwise
+    m_non_negative[phi->id] = 2;
+
+    auto* header = phi->block;
+    Vector<Node*> loop_entry_values;
+    for (size_t i = 0; i < phi->inputs.size(); i++) {
+        auto* input = phi->inputs[i];
+        auto* predecessor = header->predecessors[i];
+        if (input == phi)
+            continue;
+
+        if (m_graph.dominates(header, predecessor)) {
+            if (input->opcode != Opcode::Add || input->type != Type::Int || input->inputs[0] != phi)
+                return false;
+
+            auto* increment = input->inputs[1];
+            if (!increment->is_constant() || increment->as_long() != 1)
+                return false;
+
+            auto is_bounded = false;
+            for (auto* block = input->block; block && !is_bounded; block = block->immediate_dominator)
+                is_bounded = edge_fact(*block).left == phi;
+
+            if (!is_bounded)
+                return false;
+
+            continue;
+        }
+
+        // The interpreter's frame can hold anything when it enters a loop, so that's checked on the way in
+        if (predecessor->is_entry && predecessor != m_graph.entry() && input->opcode == Opcode::LoadSlot) {
+            loop_entry_values.append(input);
+            continue;
+        }
+
+        if (!is_non_negative(input))
+            return false;
+    }
+
+    for (auto* value : loop_entry_values) {
+        auto* entry = value->block;
+        auto* check = m_graph.create_node(Opcode::NonNegativeCheck, Type::Void, entry, { value });
+        check->frame_state = entry->terminator()->frame_state;
+        entry->nodes.insert(entry->nodes.size() - 1, check);
+    }
+
+    m_non_negative[phi->id] = 1;
+    return true;
+}
+
+void Optimizer::eliminate_bounds_checks()
+{
+    m_non_negative.resize(m_graph.nodes().size());
+
+    // Every index that's known to be within an array in the block that is being visited, and every index that's known to be less than an array's length
+    struct Fact {
+        Node* array { nullptr };
+        Node* index { nullptr };
+    };
+    Vector<Fact> in_bounds;
+    Vector<Fact> below_length;
+    Vector<size_t> fact_counts;
+
+    auto is_same_index = [](Node const* a, Node const* b) {
+        return a == b || is_same_constant(a, b);
+    };
+
+    auto contains = [&](Vector<Fact> const& facts, Node const* array, Node const* index) {
+        for (auto const& fact : facts) {
+            if (fact.array == array && is_same_index(fact.index, index))
+                return true;
+        }
+
+        return false;
+    };
+
+    // A constant index is within the array if a larger constant index has already been checked
+    auto is_below_checked_constant = [&](Node const* array, Node const* index) {
+        if (!index->is_constant() || index->as_long() < 0)
+            return false;
+
+        for (auto const& fact : in_bounds) {
+            if (fact.array == array && fact.index->is_constant() && index->as_long() <= fact.index->as_long())
+                return true;
+        }
+
+        return false;
+    };
+
+    Vector<Node*> removed_checks;
+    walk_dominator_tree(
+        [&](Block& block) {
+            fact_counts.append(in_bounds.size());
+            fact_counts.append(below_length.size());
+
+            auto fact = edge_fact(block);
+            if (fact.left && fact.right->opcode == Opcode::ArrayLength)
+                below_length.append(Fact { fact.right->inputs[0], fact.left });
+
+            for (auto* node : block.nodes) {
+                if (node->opcode != Opcode::BoundsCheck)
+                    continue;
+
+                auto* array = node->inputs[0];
+                auto* index = node->inputs[1];
+                if (contains(in_bounds, array, index) || is_below_checked_constant(array, index) || (contains(below_length, array, index) && is_non_negative(index))) {
+                    removed_checks.append(node);
+                    continue;
+                }
+
+                in_bounds.append(Fact { array, index });
+            }
+        },
+        [&](Block&) {
+            below_length.shrink(fact_counts.take_last());
+            in_bounds.shrink(fact_counts.take_last());
+        });
+
+    for (auto* check : removed_checks)
+        remove_node(check);
+}
+
+void Optimizer::eliminate_dead_code()
+{
+    Vector<u8> is_live;
+    is_live.resize(m_graph.nodes().size());
+    Vector<Node*> worklist;
+
+    auto mark = [&](Node* value) {
+        if (is_live[value->id])
+            return;
+
+        is_live[value->id] = true;
+        worklist.append(value);
+    };
+
+    for (auto* block : m_graph.blocks()) {
+        for (auto* node : block->nodes) {
+            if (node->has_side_effects())
+                mark(node);
+        }
+    }
+
+    while (!worklist.is_empty()) {
+        auto* node = worklist.take_last();
+        m_graph.for_each_use(*node, mark);
+    }
+
+    for (auto* block : m_graph.blocks()) {
+        block->phis.remove_all_matching([&](auto* phi) { return !is_live[phi->id]; });
+        block->nodes.remove_all_matching([&](auto* node) { return !is_live[node->id]; });
+    }
+}
+
+void Optimizer::split_critical_edges()
+{
+    // Copied, as this adds blocks
+    auto blocks = m_graph.blocks();
+    for (auto* block : blocks) {
+        if (block->successors.size() < 2)
+            continue;
+
+        for (auto*& successor : block->successors) {
+            if (successor->phis.is_empty() || successor->predecessors.size() < 2)
+                continue;
+
+            // A block with the same successor twice is two separate edges, which carry the same values
+            auto* edge = m_graph.create_block();
+            auto predecessor_index = successor->predecessors.find_first_index_if([&](auto* predecessor) { return predecessor == block; });
+            successor->predecessors[*predecessor_index] = edge;
+            edge->predecessors.append(block);
+            edge->successors.append(successor);
+            edge->nodes.append(m_graph.create_node(Opcode::Jump, Type::Void, edge));
+            successor = edge;
+        }
+    }
+}
+
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "IR.h"
+#include <AK/Vector.h>
+
+// Forward-declaration
+namespace Interpreter {
+class Method;
+}
+
+namespace JIT {
+
+// The optimizing compiler's passes over a method's IR, which run in this order:
+// 1. Phis which only ever pick a single value are replaced by that value.
+// 2. Arithmetic on constants is folded, and so are branches on constants, which can leave whole blocks unreachable (and more phis trivial).
+// 3. Null checks of values that are known not to be null (e.g. `this`, a new object, or a value which has already been checked) are removed.
+// 4. New objects that don't escape the method have their allocation removed, and their fields become values (see replace_allocations()),
+//    an object that only escapes on some paths is allocated where it escapes instead. Afterwards, 1 and 2 run again, as the fields' values can be constants.
+// 5. Bounds checks are removed where the index is known to be within the array, e.g. when the same check dominates it,
+//    or in a counted loop (`for (int i = 0; i < array.length; i++)`) whose condition already compares the index with the array's length.
+// 6. Values that nothing uses are removed, this also runs before 4, where a dead phi would look like a use of the new object.
+// 7. Edges from a block with several successors to a block with phis are split, so that the register allocator has somewhere to put the phis' moves.
+//
+// Checks are only ever removed where they can't fail, so the interpreter still sees every exception that the method throws.
+class Optimizer {
+public:
+    static void optimize(IR::Graph&, Interpreter::Method&);
+
+private:
+    Optimizer(IR::Graph&, Interpreter::Method&);
+
+    bool remove_trivial_phis();
+    bool fold_constants();
+    void eliminate_null_checks();
+    bool replace_allocations();
+    bool replace_allocation(IR::Node& allocation);
+    void eliminate_bounds_checks();
+    void eliminate_dead_code();
+    void split_critical_edges();
+
+    // Folds a branch or switch to a jump to the successor at `successor_index`
+    void fold_to_jump(IR::Block&, size_t successor_index);
+
+    // What a block's only predecessor knows when it branches to the block: that `left` is less than `right` (signed), or that `value` isn't null
+    struct EdgeFact {
+        IR::Node* left { nullptr };
+        IR::Node* right { nullptr };
+        IR::Node* non_null { nullptr };
+    };
+
+    EdgeFact edge_fact(IR::Block const&) const;
+
+    // Whether an int is known to never be negative, which adds a check to a loop entry if it needs one
+    bool is_non_negative(IR::Node*);
+    bool is_induction_variable(IR::Node* phi);
+
+    // Calls the callback with every block, in a pre-order walk of the dominator tree, and then calls `leave` once every block that it dominates has been visited
+    template<typename Enter, typename Leave>
+    void walk_dominator_tree(Enter enter, Leave leave);
+
+    IR::Graph& m_graph;
+    Interpreter::Method& m_method;
+
+    // Indexed by node id: whether an int has been found to be non-negative (1), or not (2), or hasn't been looked at yet (0)
+    Vector<u8> m_non_negative;
+};
+
+}
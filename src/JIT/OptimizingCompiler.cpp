@@ -0,0 +1,1041 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "OptimizingCompiler.h"
+#include "../Interpreter/Interpreter.h"
+#include "../Interpreter/Object.h"
+#include "GraphBuilder.h"
+#include "Helpers.h"
+#include "Optimizer.h"
+#include <AK/NumericLimits.h>
+
+namespace JIT {
+
+using Interpreter::ArrayObject;
+using Interpreter::Object;
+
+using IR::Block;
+using IR::MemoryKind;
+using IR::Node;
+using IR::Opcode;
+using IR::Type;
+
+using ArithmeticOperation = Assembler::ArithmeticOperation;
+using FloatOperation = Assembler::FloatOperation;
+using ShiftOperation = Assembler::ShiftOperation;
+
+// The sizes that Java's types are operated on with, a slot (and a register) always holds 8 bytes
+static constexpr auto int_size = OperandSize::DoubleWord;
+static constexpr auto long_size = OperandSize::QuadWord;
+static constexpr auto float_size = OperandSize::DoubleWord;
+static constexpr auto double_size = OperandSize::QuadWord;
+static constexpr auto slot_size = OperandSize::QuadWord;
+
+static constexpr i32 field_storage_offset = sizeof(Object);
+
+// rbx, r12, r13, r14 and r15 are saved just below rbp, and the spill slots follow them
+static constexpr i32 saved_register_count = 5;
+
+static bool fits_in_i32(i64 value)
+{
+    return value >= NumericLimits<i32>::min() && value <= NumericLimits<i32>::max();
+}
+
+static Condition negate(Condition condition)
+{
+    // The condition codes come in pairs, which only differ in their lowest bit
+    return static_cast<Condition>(to_underlying(condition) ^ 1);
+}
+
+OptimizingCompiler::OptimizingCompiler(Interpreter::Method& method, Interpreter::InstructionStream& instruction_stream, Interpreter::Heap& heap, IR::Graph& graph, RegisterAllocator register_allocator)
+    : m_method(method)
+    , m_instruction_stream(instruction_stream)
+    , m_heap(heap)
+    , m_graph(graph)
+    , m_register_allocator(move(register_allocator))
+    , m_max_locals(method.code()->max_locals())
+{
+}
+
+ErrorOr<NonnullOwnPtr<CompiledCode>> OptimizingCompiler::compile(Interpreter::Method& method, Interpreter::InstructionStream& instruction_stream, Interpreter::Heap& heap, CodeCache& code_cache, bool dump_graph)
+{
+    auto graph = TRY(GraphBuilder::build(method, instruction_stream));
+    Optimizer::optimize(*graph, method);
+    if (dump_graph) {
+        dbgln("JIT: The optimized IR of {}.{}{}:", method.owner().name(), method.name(), method.descriptor());
+        graph->dump();
+    }
+
+    OptimizingCompiler compiler(method, instruction_stream, heap, *graph, RegisterAllocator::allocate(*graph));
+    TRY(compiler.compile_graph());
+
+    auto code = compiler.m_assembler.finalize();
+    auto const* code_start = TRY(code_cache.install(code));
+    auto entry_point = [&](Block const& block) {
+        return reinterpret_cast<EntryPoint>(code_start + compiler.m_block_labels[block.id].offset());
+    };
+
+    Vector<EntryPoint> loop_entry_points;
+    TRY(loop_entry_points.try_ensure_capacity(graph->loop_entries().size()));
+    for (auto const* loop_entry : graph->loop_entries())
+        loop_entry_points.unchecked_append(loop_entry ? entry_point(*loop_entry) : nullptr);
+
+    return try_make<CompiledCode>(CompiledCode::Tier::Optimized, entry_point(*graph->entry()), move(loop_entry_points), code.size());
+}
+
+ErrorOr<void> OptimizingCompiler::compile_graph()
+{
+    // The assembler refers to these until the code is finalized, so they can't be resized once anything has been emitted
+    TRY(m_block_labels.try_resize(m_graph.block_count()));
+
+    // Each entry has its own prologue, and no block can branch to an entry, so nothing falls through into one
+    auto const& blocks = m_graph.blocks();
+    for (size_t i = 0; i < blocks.size(); i++) {
+        auto& block = *blocks[i];
+        m_next_block = i + 1 < blocks.size() ? blocks[i + 1] : nullptr;
+        m_assembler.bind(m_block_labels[block.id]);
+        if (block.is_entry)
+            emit_prologue();
+
+        for (auto* node : block.nodes)
+            TRY(compile_node(*node));
+    }
+
+    // The stubs are out of line, so that the code of each block falls straight through to the next one
+    // If allocating a virtual object fails, the exit reason that the helper returned is still in rax
+    for (auto& stub : m_deoptimization_stubs) {
+        auto const& frame_state = *stub.node->frame_state;
+        m_assembler.bind(*stub.label);
+        write_frame_state(frame_state);
+
+        auto& failure = create_label();
+        if (!frame_state.virtual_objects.is_empty())
+            materialize_virtual_objects(frame_state, failure);
+
+        m_assembler.mov(Register::RAX, to_underlying(ExitReason::Deoptimize));
+        m_assembler.bind(failure);
+        m_assembler.mov(Register::RDX, frame_state.index);
+        m_assembler.jump(m_epilogue);
+    }
+
+    // The exit reason that the helper returned is still in rax
+    for (auto& stub : m_exit_stubs) {
+        m_assembler.bind(*stub.label);
+        m_assembler.mov(Register::RDX, stub.node->frame_state->index);
+        m_assembler.jump(m_epilogue);
+    }
+
+    // The exit reason is in rax, and its value is in rdx
+    m_assembler.bind(m_epilogue);
+    m_assembler.lea(Register::RSP, Address { .base = Register::RBP, .displacement = -saved_register_count * 8 });
+    m_assembler.pop(Register::R15);
+    m_assembler.pop(Register::R14);
+    m_assembler.pop(Register::R13);
+    m_assembler.pop(Register::R12);
+    m_assembler.pop(Register::RBX);
+    m_assembler.pop(Register::RBP);
+    m_assembler.ret();
+
+    // Every tableswitch's jump table holds the offset of each case's code from the start of the table
+    for (auto& jump_table : m_jump_tables) {
+        auto& block = *jump_table.node->block;
+        m_assembler.bind(*jump_table.label);
+        for (size_t i = 1; i < block.successors.size(); i++)
+            m_assembler.jump_table_entry(*jump_table.label, m_block_labels[block.successors[i]->id]);
+    }
+
+    return {};
+}
+
+void OptimizingCompiler::emit_prologue()
+{
+    // Unlike baseline code, r14 and r15 hold values, so they are saved as well.
+    // The stack has to stay 16-byte aligned for calls to the helpers, with the return address and the 6 saved registers that's an odd number of spill slots.
+    auto spill_slot_count = m_register_allocator.spill_slot_count() | 1;
+    m_assembler.push(Register::RBP);
+    m_assembler.mov(OperandSize::QuadWord, Register::RBP, Register::RSP);
+    m_assembler.push(Register::RBX);
+    m_assembler.push(Register::R12);
+    m_assembler.push(Register::R13);
+    m_assembler.push(Register::R14);
+    m_assembler.push(Register::R15);
+    m_assembler.arithmetic(ArithmeticOperation::Subtract, OperandSize::QuadWord, Register::RSP, static_cast<i32>(spill_slot_count * 8));
+    m_assembler.mov(OperandSize::QuadWord, Register::RBX, Register::RDI);
+    m_assembler.mov(OperandSize::QuadWord, Register::R12, Register::RSI);
+    m_assembler.mov(OperandSize::QuadWord, Register::R13, Register::RDX);
+}
+
+Address OptimizingCompiler::slot(u32 index) const
+{
+    return { .base = Register::RBX, .displacement = static_cast<i32>(index * sizeof(Interpreter::Value)) };
+}
+
+Address OptimizingCompiler::spill_slot(u32 index) const
+{
+    return { .base = Register::RBP, .displacement = -static_cast<i32>((saved_register_count + 1 + index) * 8) };
+}
+
+void OptimizingCompiler::load(Register destination, Node const& value)
+{
+    if (value.is_constant()) {
+        m_assembler.mov(destination, value.constant);
+        return;
+    }
+
+    auto location = m_register_allocator.location(value);
+    switch (location.kind) {
+    case Location::Kind::Register:
+        if (location.reg != destination)
+            m_assembler.mov(slot_size, destination, location.reg);
+        return;
+    case Location::Kind::Spill:
+        m_assembler.mov(slot_size, destination, spill_slot(location.spill_slot));
+        return;
+    case Location::Kind::None:
+        break;
+    }
+
+    VERIFY_NOT_REACHED();
+}
+
+void OptimizingCompiler::store(Node const& value, Register source)
+{
+    auto location = m_register_allocator.location(value);
+    switch (location.kind) {
+    case Location::Kind::Register:
+        if (location.reg != source)
+            m_assembler.mov(slot_size, location.reg, source);
+        return;
+    case Location::Kind::Spill:
+        m_assembler.mov(slot_size, spill_slot(location.spill_slot), source);
+        return;
+    case Location::Kind::None:
+        break;
+    }
+
+    VERIFY_NOT_REACHED();
+}
+
+void OptimizingCompiler::write_frame_state(IR::FrameState const& frame_state)
+{
+    for (u32 index = 0; index < frame_state.slots.size(); index++) {
+        auto const& value = *frame_state.slots[index];
+        if (&value == m_graph.undefined())
+            continue;
+
+        if (frame_state.virtual_object(&value)) {
+            m_assembler.mov(slot_size, slot(index), 0);
+            continue;
+        }
+
+        // A 64-bit store sign-extends its immediate
+        if (value.is_constant() && fits_in_i32(value.as_long())) {
+            m_assembler.mov(slot_size, slot(index), static_cast<i32>(value.as_long()));
+            continue;
+        }
+
+        auto location = m_register_allocator.location(value);
+        if (!value.is_constant() && location.kind == Location::Kind::Register) {
+            m_assembler.mov(slot_size, slot(index), location.reg);
+            continue;
+        }
+
+        load(Register::RAX, value);
+        m_assembler.mov(slot_size, slot(index), Register::RAX);
+    }
+}
+
+u32 OptimizingCompiler::reserve_native_stack(size_t count)
+{
+    auto size = static_cast<u32>(((1 + count + 1) & ~1ul) * 8);
+    m_assembler.arithmetic(ArithmeticOperation::Subtract, OperandSize::QuadWord, Register::RSP, static_cast<i32>(size));
+    return size;
+}
+
+void OptimizingCompiler::allocate_object(Interpreter::Instruction& instruction, u32 frame_state_index, Label& failure)
+{
+    m_assembler.mov(Register::RAX, bit_cast<FlatPtr>(m_instruction_stream.instructions() + frame_state_index));
+    m_assembler.mov(slot_size, Address { .base = Register::R13 }, Register::RAX);
+
+    m_assembler.mov(OperandSize::QuadWord, Register::RDI, Register::R12);
+    m_assembler.mov(Register::RSI, bit_cast<FlatPtr>(&instruction));
+    m_assembler.mov(OperandSize::QuadWord, Register::RDX, Register::RSP);
+    m_assembler.mov(Register::RAX, bit_cast<FlatPtr>(&Helpers::allocate_object));
+    m_assembler.call(Register::RAX);
+    m_assembler.test(int_size, Register::RAX, Register::RAX);
+    m_assembler.jump(Condition::NotEqual, failure);
+    m_assembler.mov(slot_size, Register::RCX, native_stack_slot(0));
+}
+
+// The write barrier is Heap::record_write(), inlined: it dirties the card that the object starts in
+void OptimizingCompiler::store_field(Register object, u32 offset, MemoryKind memory_kind, Register value)
+{
+    auto address = Address { .base = object, .displacement = field_storage_offset + static_cast<i32>(offset) };
+    switch (memory_kind) {
+    case MemoryKind::Boolean:
+        if (value != Register::RDX)
+            m_assembler.mov(slot_size, Register::RDX, value);
+        m_assembler.arithmetic(ArithmeticOperation::And, int_size, Register::RDX, 1);
+        m_assembler.mov(OperandSize::Byte, address, Register::RDX);
+        return;
+    case MemoryKind::Byte:
+        if (value != Register::RDX)
+            m_assembler.mov(slot_size, Register::RDX, value);
+        m_assembler.mov(OperandSize::Byte, address, Register::RDX);
+        return;
+    case MemoryKind::Char:
+    case MemoryKind::Short:
+        m_assembler.mov(OperandSize::Word, address, value);
+        return;
+    case MemoryKind::Int:
+    case MemoryKind::Float:
+        m_assembler.mov(int_size, address, value);
+        return;
+    case MemoryKind::Long:
+    case MemoryKind::Double:
+        m_assembler.mov(long_size, address, value);
+        return;
+    case MemoryKind::Reference:
+        m_assembler.mov(slot_size, address, value);
+        m_assembler.mov(slot_size, Register::RAX, object);
+        m_assembler.shift(ShiftOperation::LogicalRight, OperandSize::QuadWord, Register::RAX, Interpreter::Heap::card_shift);
+        m_assembler.mov(Register::R11, m_heap.biased_card_table());
+        m_assembler.mov(OperandSize::Byte, Address { .base = Register::R11, .index = Register::RAX }, Interpreter::Heap::dirty_card);
+        return;
+    }
+
+    VERIFY_NOT_REACHED();
+}
+
+// Only references need to be in the frame, see Optimizer::replace_allocations()
+static bool is_stashed(IR::VirtualField const& field)
+{
+    return field.memory_kind != MemoryKind::Reference && !field.value->is_constant();
+}
+
+void OptimizingCompiler::materialize_virtual_objects(IR::FrameState const& frame_state, Label& failure)
+{
+    Vector<IR::VirtualField const*> stashed;
+    for (auto const& object : frame_state.virtual_objects) {
+        for (auto const& field : object.fields) {
+            if (is_stashed(field))
+                stashed.append(&field);
+        }
+    }
+
+    auto size = reserve_native_stack(stashed.size());
+    for (size_t i = 0; i < stashed.size(); i++) {
+        load(Register::RAX, *stashed[i]->value);
+        m_assembler.mov(slot_size, native_stack_slot(1 + i), Register::RAX);
+    }
+
+    auto slot_of = [&](Node const* value) {
+        auto index = frame_state.slots.find_first_index_if([&](auto const* slot_value) { return slot_value == value; });
+        VERIFY(index.has_value());
+        return slot(*index);
+    };
+
+    for (auto const& object : frame_state.virtual_objects) {
+        allocate_object(*object.allocation->instruction, frame_state.index, failure);
+        for (u32 index = 0; index < frame_state.slots.size(); index++) {
+            if (frame_state.slots[index] == object.allocation)
+                m_assembler.mov(slot_size, slot(index), Register::RCX);
+        }
+    }
+
+    for (auto const& object : frame_state.virtual_objects) {
+        m_assembler.mov(slot_size, Register::RCX, slot_of(object.allocation));
+        for (auto const& field : object.fields) {
+            if (is_stashed(field))
+                m_assembler.mov(slot_size, Register::RDX, native_stack_slot(1 + *stashed.find_first_index_if([&](auto const* other) { return other == &field; })));
+            else if (field.value->is_constant())
+                m_assembler.mov(Register::RDX, field.value->constant);
+            else
+                m_assembler.mov(slot_size, Register::RDX, slot_of(field.value));
+
+            store_field(Register::RCX, field.offset, field.memory_kind, Register::RDX);
+        }
+    }
+
+    m_assembler.arithmetic(ArithmeticOperation::Add, OperandSize::QuadWord, Register::RSP, static_cast<i32>(size));
+}
+
+Label& OptimizingCompiler::deoptimization_label(Node const& node)
+{
+    m_deoptimization_stubs.append(Stub { const_cast<Node*>(&node), make<Label>() });
+    return *m_deoptimization_stubs.last().label;
+}
+
+void OptimizingCompiler::jump_to(Block& successor)
+{
+    if (&successor != m_next_block)
+        m_assembler.jump(m_block_labels[successor.id]);
+}
+
+// "Tilting at windmills with Coq: formal verification of a compilation algorithm for parallel moves", Rideau, Serpette and Leroy.
+// Moves whose destination no other move still reads from go first, and a cycle is broken by saving one of its destinations in r11.
+void OptimizingCompiler::emit_phi_moves(Block& block, Block& successor)
+{
+    if (successor.phis.is_empty())
+        return;
+
+    auto predecessor_index = *successor.predecessors.find_first_index_if([&](auto* predecessor) { return predecessor == &block; });
+
+    struct Move {
+        Location destination;
+        Location source;
+    };
+    Vector<Move> moves;
+    Vector<Node*> constant_phis;
+    for (auto* phi : successor.phis) {
+        auto* input = phi->inputs[predecessor_index];
+
+        // A slot that's undefined on this path is never used after the merge, so the phi can hold anything
+        if (input == m_graph.undefined())
+            continue;
+
+        if (input->is_constant()) {
+            constant_phis.append(phi);
+            continue;
+        }
+
+        auto destination = m_register_allocator.location(*phi);
+        auto source = m_register_allocator.location(*input);
+        if (destination != source)
+            moves.append(Move { destination, source });
+    }
+
+    auto emit_move = [&](Location const& destination, Location const& source) {
+        auto address = [&](Location const& location) { return spill_slot(location.spill_slot); };
+        if (destination.kind == Location::Kind::Register && source.kind == Location::Kind::Register) {
+            m_assembler.mov(slot_size, destination.reg, source.reg);
+        } else if (destination.kind == Location::Kind::Register) {
+            m_assembler.mov(slot_size, destination.reg, address(source));
+        } else if (source.kind == Location::Kind::Register) {
+            m_assembler.mov(slot_size, address(destination), source.reg);
+        } else {
+            m_assembler.mov(slot_size, Register::RAX, address(source));
+            m_assembler.mov(slot_size, address(destination), Register::RAX);
+        }
+    };
+
+    auto is_still_read = [&](Location const& location) {
+        for (auto const& move : moves) {
+            if (move.source == location)
+                return true;
+        }
+        return false;
+    };
+
+    while (!moves.is_empty()) {
+        auto ready = moves.find_first_index_if([&](auto const& move) { return !is_still_read(move.destination); });
+
+        if (ready.has_value()) {
+            emit_move(moves[*ready].destination, moves[*ready].source);
+            moves.remove(*ready);
+            continue;
+        }
+
+        auto saved = moves.first().destination;
+        Location scratch { .kind = Location::Kind::Register, .reg = Register::R11 };
+        emit_move(scratch, saved);
+        for (auto& move : moves) {
+            if (move.source == saved)
+                move.source = scratch;
+        }
+    }
+
+    for (auto* phi : constant_phis) {
+        m_assembler.mov(Register::RAX, phi->inputs[predecessor_index]->constant);
+        store(*phi, Register::RAX);
+    }
+}
+
+ErrorOr<void> OptimizingCompiler::compile_node(Node& node)
+{
+    auto& assembler = m_assembler;
+
+    // Returns the register that a value is already in, or loads it into the scratch register
+    auto in_register = [&](Node const& value, Register scratch) {
+        auto location = m_register_allocator.location(value);
+        if (!value.is_constant() && location.kind == Location::Kind::Register)
+            return location.reg;
+
+        load(scratch, value);
+        return scratch;
+    };
+
+    auto store_int = [&](Register source) {
+        assembler.movsx(int_size, source, source);
+        store(node, source);
+    };
+
+    auto store_result = [&](Register source) {
+        if (node.type == Type::Int)
+            store_int(source);
+        else
+            store(node, source);
+    };
+
+    auto integer_size = [&] { return node.type == Type::Long ? long_size : int_size; };
+
+    auto integer_arithmetic = [&](ArithmeticOperation operation) {
+        load(Register::RAX, *node.inputs[0]);
+        auto const& right = *node.inputs[1];
+        if (right.is_constant() && fits_in_i32(right.as_long()))
+            assembler.arithmetic(operation, integer_size(), Register::RAX, static_cast<i32>(right.as_long()));
+        else
+            assembler.arithmetic(operation, integer_size(), Register::RAX, in_register(right, Register::RCX));
+        store_result(Register::RAX);
+    };
+
+    // A float's register holds its bits zero-extended (like Value::from_float()), so it's moved into an SSE register for the operation
+    auto float_arithmetic = [&](FloatOperation operation) {
+        auto size = node.type == Type::Double ? double_size : float_size;
+        assembler.bits_to_float(size, FloatRegister::XMM0, in_register(*node.inputs[0], Register::RAX));
+        assembler.bits_to_float(size, FloatRegister::XMM1, in_register(*node.inputs[1], Register::RCX));
+        assembler.float_operation(operation, size, FloatRegister::XMM0, FloatRegister::XMM1);
+        assembler.float_to_bits(size, Register::RAX, FloatRegister::XMM0);
+        store(node, Register::RAX);
+    };
+
+    auto is_floating_point = node.type == Type::Float || node.type == Type::Double;
+
+    // The element at the index, after the checks
+    auto element_address = [&](u8 element_size) {
+        auto array = in_register(*node.inputs[0], Register::RAX);
+        auto index = in_register(*node.inputs[1], Register::RCX);
+        return Address { .base = array, .displacement = ArrayObject::elements_offset, .index = index, .scale = element_size };
+    };
+
+    auto field_address = [&] {
+        return Address { .base = in_register(*node.inputs[0], Register::RAX), .displacement = field_storage_offset + static_cast<i32>(node.constant) };
+    };
+
+    switch (node.opcode) {
+    case Opcode::Constant:
+    case Opcode::Phi:
+        VERIFY_NOT_REACHED();
+
+    case Opcode::LoadSlot:
+        assembler.mov(slot_size, Register::RAX, slot(node.constant));
+        store(node, Register::RAX);
+        return {};
+
+    // Arithmetic
+    case Opcode::Add:
+        if (is_floating_point)
+            float_arithmetic(FloatOperation::Add);
+        else
+            integer_arithmetic(ArithmeticOperation::Add);
+        return {};
+
+    case Opcode::Subtract:
+        if (is_floating_point)
+            float_arithmetic(FloatOperation::Subtract);
+        else
+            integer_arithmetic(ArithmeticOperation::Subtract);
+        return {};
+
+    case Opcode::And:
+        integer_arithmetic(ArithmeticOperation::And);
+        return {};
+
+    case Opcode::Or:
+        integer_arithmetic(ArithmeticOperation::Or);
+        return {};
+
+    case Opcode::Xor:
+        integer_arithmetic(ArithmeticOperation::Xor);
+        return {};
+
+    case Opcode::Multiply:
+        if (is_floating_point) {
+            float_arithmetic(FloatOperation::Multiply);
+            return {};
+        }
+
+        load(Register::RAX, *node.inputs[0]);
+        assembler.imul(integer_size(), Register::RAX, in_register(*node.inputs[1], Register::RCX));
+        store_result(Register::RAX);
+        return {};
+
+    // The divisor has already been checked for zero, and dividing by -1 is done without idiv, which would trap on the smallest value's overflow
+    case Opcode::Divide:
+    case Opcode::Remainder: {
+        if (is_floating_point) {
+            // Floating point remainders are calls to a helper
+            VERIFY(node.opcode == Opcode::Divide);
+            float_arithmetic(FloatOperation::Divide);
+            return {};
+        }
+
+        auto size = integer_size();
+        auto is_remainder = node.opcode == Opcode::Remainder;
+        auto& divide = create_label();
+        auto& done = create_label();
+
+        load(Register::RCX, *node.inputs[1]);
+        load(Register::RAX, *node.inputs[0]);
+        assembler.arithmetic(ArithmeticOperation::Compare, size, Register::RCX, -1);
+        assembler.jump(Condition::NotEqual, divide);
+
+        if (is_remainder)
+            assembler.mov(Register::RAX, 0);
+        else
+            assembler.neg(size, Register::RAX);
+        assembler.jump(done);
+
+        assembler.bind(divide);
+        assembler.sign_extend_accumulator(size);
+        assembler.idiv(size, Register::RCX);
+        if (is_remainder)
+            assembler.mov(size, Register::RAX, Register::RDX);
+
+        assembler.bind(done);
+        store_result(Register::RAX);
+        return {};
+    }
+
+    // x86 only uses the low 5 (or 6, for 64-bit operands) bits of the shift distance, just like Java
+    case Opcode::ShiftLeft:
+    case Opcode::ShiftRight:
+    case Opcode::UnsignedShiftRight: {
+        auto operation = node.opcode == Opcode::ShiftLeft ? ShiftOperation::Left
+            : node.opcode == Opcode::ShiftRight           ? ShiftOperation::ArithmeticRight
+                                                          : ShiftOperation::LogicalRight;
+
+        auto const& distance = *node.inputs[1];
+        if (distance.is_constant()) {
+            load(Register::RAX, *node.inputs[0]);
+            assembler.shift(operation, integer_size(), Register::RAX, distance.constant & (node.type == Type::Long ? 63 : 31));
+        } else {
+            load(Register::RCX, distance);
+            load(Register::RAX, *node.inputs[0]);
+            assembler.shift_by_cl(operation, integer_size(), Register::RAX);
+        }
+
+        store_result(Register::RAX);
+        return {};
+    }
+
+    // Negating a float or a double only flips the sign bit, so NaN stays NaN
+    case Opcode::Negate:
+        load(Register::RAX, *node.inputs[0]);
+        if (node.type == Type::Float) {
+            assembler.arithmetic(ArithmeticOperation::Xor, float_size, Register::RAX, NumericLimits<i32>::min());
+        } else if (node.type == Type::Double) {
+            assembler.mov(Register::RCX, 0x8000000000000000);
+            assembler.arithmetic(ArithmeticOperation::Xor, double_size, Register::RAX, Register::RCX);
+        } else {
+            assembler.neg(integer_size(), Register::RAX);
+        }
+
+        store_result(Register::RAX);
+        return {};
+
+    // Conversions
+    case Opcode::IntToFloat:
+    case Opcode::IntToDouble:
+    case Opcode::LongToFloat:
+    case Opcode::LongToDouble: {
+        auto from_size = (node.opcode == Opcode::IntToFloat || node.opcode == Opcode::IntToDouble) ? int_size : long_size;
+        auto to_size = node.type == Type::Double ? double_size : float_size;
+        assembler.integer_to_float(to_size, from_size, FloatRegister::XMM0, in_register(*node.inputs[0], Register::RAX));
+        assembler.float_to_bits(to_size, Register::RAX, FloatRegister::XMM0);
+        store(node, Register::RAX);
+        return {};
+    }
+
+    case Opcode::FloatToDouble:
+    case Opcode::DoubleToFloat: {
+        auto from_size = node.opcode == Opcode::FloatToDouble ? float_size : double_size;
+        auto to_size = node.opcode == Opcode::FloatToDouble ? double_size : float_size;
+        assembler.bits_to_float(from_size, FloatRegister::XMM0, in_register(*node.inputs[0], Register::RAX));
+        assembler.float_to_float(from_size, FloatRegister::XMM0, FloatRegister::XMM0);
+        assembler.float_to_bits(to_size, Register::RAX, FloatRegister::XMM0);
+        store(node, Register::RAX);
+        return {};
+    }
+
+    case Opcode::IntToByte:
+        load(Register::RAX, *node.inputs[0]);
+        assembler.movsx(OperandSize::Byte, Register::RAX, Register::RAX);
+        store(node, Register::RAX);
+        return {};
+
+    case Opcode::IntToChar:
+        load(Register::RAX, *node.inputs[0]);
+        assembler.movzx(OperandSize::Word, Register::RAX, Register::RAX);
+        store(node, Register::RAX);
+        return {};
+
+    case Opcode::IntToShort:
+        load(Register::RAX, *node.inputs[0]);
+        assembler.movsx(OperandSize::Word, Register::RAX, Register::RAX);
+        store(node, Register::RAX);
+        return {};
+
+    case Opcode::LongToInt:
+        load(Register::RAX, *node.inputs[0]);
+        store_int(Register::RAX);
+        return {};
+
+    // lcmp's result is (a > b) - (a < b)
+    case Opcode::CompareLong:
+        load(Register::RAX, *node.inputs[0]);
+        assembler.arithmetic(ArithmeticOperation::Compare, long_size, Register::RAX, in_register(*node.inputs[1], Register::RCX));
+        assembler.set(Condition::Greater, Register::RAX);
+        assembler.set(Condition::Less, Register::RCX);
+        assembler.arithmetic(ArithmeticOperation::Subtract, OperandSize::Byte, Register::RAX, Register::RCX);
+        assembler.movsx(OperandSize::Byte, Register::RAX, Register::RAX);
+        store(node, Register::RAX);
+        return {};
+
+    // Memory, the objects and arrays have already been checked
+    case Opcode::ArrayLength:
+        assembler.movsx(int_size, Register::RDX, Address { .base = in_register(*node.inputs[0], Register::RAX), .displacement = ArrayObject::length_offset });
+        store(node, Register::RDX);
+        return {};
+
+    case Opcode::LoadElement:
+        switch (node.memory_kind) {
+        case MemoryKind::Boolean:
+        case MemoryKind::Byte:
+            assembler.movsx(OperandSize::Byte, Register::RDX, element_address(1));
+            break;
+        case MemoryKind::Char:
+            assembler.movzx(OperandSize::Word, Register::RDX, element_address(2));
+            break;
+        case MemoryKind::Short:
+            assembler.movsx(OperandSize::Word, Register::RDX, element_address(2));
+            break;
+        case MemoryKind::Int:
+            assembler.movsx(int_size, Register::RDX, element_address(4));
+            break;
+        case MemoryKind::Float:
+            assembler.mov(float_size, Register::RDX, element_address(4));
+            break;
+        case MemoryKind::Long:
+        case MemoryKind::Double:
+        case MemoryKind::Reference:
+            assembler.mov(slot_size, Register::RDX, element_address(8));
+            break;
+        }
+
+        store(node, Register::RDX);
+        return {};
+
+    // Reference and byte (or boolean) arrays are stored to by helpers, which look at the array's class
+    case Opcode::StoreElement: {
+        auto value = in_register(*node.inputs[2], Register::RDX);
+        switch (node.memory_kind) {
+        case MemoryKind::Char:
+        case MemoryKind::Short:
+            assembler.mov(OperandSize::Word, element_address(2), value);
+            break;
+        case MemoryKind::Int:
+        case MemoryKind::Float:
+            assembler.mov(int_size, element_address(4), value);
+            break;
+        case MemoryKind::Long:
+        case MemoryKind::Double:
+            assembler.mov(long_size, element_address(8), value);
+            break;
+        case MemoryKind::Boolean:
+        case MemoryKind::Byte:
+        case MemoryKind::Reference:
+            VERIFY_NOT_REACHED();
+        }
+        return {};
+    }
+
+    // getfield_int_quick sign-extends, even for a float field, just like the interpreter
+    case Opcode::LoadField:
+        switch (node.memory_kind) {
+        case MemoryKind::Boolean:
+        case MemoryKind::Byte:
+            assembler.movsx(OperandSize::Byte, Register::RDX, field_address());
+            break;
+        case MemoryKind::Char:
+            assembler.movzx(OperandSize::Word, Register::RDX, field_address());
+            break;
+        case MemoryKind::Short:
+            assembler.movsx(OperandSize::Word, Register::RDX, field_address());
+            break;
+        case MemoryKind::Int:
+        case MemoryKind::Float:
+            assembler.movsx(int_size, Register::RDX, field_address());
+            break;
+        case MemoryKind::Long:
+        case MemoryKind::Double:
+        case MemoryKind::Reference:
+            assembler.mov(slot_size, Register::RDX, field_address());
+            break;
+        }
+
+        store(node, Register::RDX);
+        return {};
+
+    case Opcode::StoreField:
+        store_field(in_register(*node.inputs[0], Register::RCX), node.constant, node.memory_kind, in_register(*node.inputs[1], Register::RDX));
+        return {};
+
+    case Opcode::LoadStatic:
+        assembler.mov(Register::RAX, bit_cast<FlatPtr>(node.instruction->static_value));
+        assembler.mov(slot_size, Register::RAX, Address { .base = Register::RAX });
+        store(node, Register::RAX);
+        return {};
+
+    case Opcode::StoreStatic: {
+        auto value = in_register(*node.inputs[0], Register::RCX);
+        assembler.mov(Register::RAX, bit_cast<FlatPtr>(node.instruction->static_value));
+        assembler.mov(slot_size, Address { .base = Register::RAX }, value);
+        return {};
+    }
+
+    // A string constant is loaded from the instruction, as the garbage collector updates it there when the string moves
+    case Opcode::LoadConstant:
+        assembler.mov(Register::RAX, bit_cast<FlatPtr>(&node.instruction->constant_bits));
+        assembler.mov(slot_size, Register::RAX, Address { .base = Register::RAX });
+        store(node, Register::RAX);
+        return {};
+
+    // Checks, which hand the frame over to the interpreter if they fail
+    case Opcode::NullCheck: {
+        auto object = in_register(*node.inputs[0], Register::RAX);
+        assembler.test(slot_size, object, object);
+        assembler.jump(Condition::Equal, deoptimization_label(node));
+        return {};
+    }
+
+    // A negative index is a large unsigned one, so a single comparison checks both bounds
+    case Opcode::BoundsCheck: {
+        auto array = in_register(*node.inputs[0], Register::RAX);
+        auto index = in_register(*node.inputs[1], Register::RCX);
+        assembler.arithmetic(ArithmeticOperation::Compare, int_size, index, Address { .base = array, .displacement = ArrayObject::length_offset });
+        assembler.jump(Condition::AboveOrEqual, deoptimization_label(node));
+        return {};
+    }
+
+    // An int's register holds it sign-extended, so it's only zero if the whole register is
+    case Opcode::ZeroCheck: {
+        auto value = in_register(*node.inputs[0], Register::RAX);
+        assembler.test(slot_size, value, value);
+        assembler.jump(Condition::Equal, deoptimization_label(node));
+        return {};
+    }
+
+    // Classes aren't on the heap, so the garbage collector never moves them
+    case Opcode::ClassCheck: {
+        auto object = in_register(*node.inputs[0], Register::RAX);
+        assembler.mov(Register::RCX, bit_cast<FlatPtr>(node.klass));
+        assembler.arithmetic(ArithmeticOperation::Compare, slot_size, Address { .base = object }, Register::RCX);
+        assembler.jump(Condition::NotEqual, deoptimization_label(node));
+        return {};
+    }
+
+    case Opcode::NonNegativeCheck: {
+        auto value = in_register(*node.inputs[0], Register::RAX);
+        assembler.test(int_size, value, value);
+        assembler.jump(Condition::Sign, deoptimization_label(node));
+        return {};
+    }
+
+    // The helper finds its operands in the frame, and leaves its result there.
+    // Afterwards, only the slots below the operands are still as they were written, the rest can have been used by the frame of an invoked method.
+    case Opcode::Call: {
+        auto const& frame_state = *node.frame_state;
+        write_frame_state(frame_state);
+        if (node.is_safepoint) {
+            assembler.mov(Register::RAX, bit_cast<FlatPtr>(node.instruction));
+            assembler.mov(slot_size, Address { .base = Register::R13 }, Register::RAX);
+        }
+
+        assembler.mov(OperandSize::QuadWord, Register::RDI, Register::R12);
+        assembler.mov(Register::RSI, bit_cast<FlatPtr>(node.instruction));
+        assembler.lea(Register::RDX, slot(m_max_locals + frame_state.depth));
+        assembler.mov(Register::RAX, bit_cast<FlatPtr>(node.helper));
+        assembler.call(Register::RAX);
+
+        m_exit_stubs.append(Stub { &node, make<Label>() });
+        assembler.test(int_size, Register::RAX, Register::RAX);
+        assembler.jump(Condition::NotEqual, *m_exit_stubs.last().label);
+
+        auto result_slot = m_max_locals + frame_state.depth - node.popped_slots;
+        for (auto* value : m_register_allocator.live_after_call(node)) {
+            auto index = frame_state.slots.find_first_index_if([&](auto* slot_value) { return slot_value == value; });
+            if (!index.has_value() || *index >= result_slot)
+                return Error::from_string_literal("A value that is live across a call isn't in the interpreter's frame");
+
+            assembler.mov(slot_size, Register::RAX, slot(*index));
+            store(*value, Register::RAX);
+        }
+
+        if (node.type != Type::Void) {
+            assembler.mov(slot_size, Register::RAX, slot(result_slot));
+            store(node, Register::RAX);
+        }
+        return {};
+    }
+
+    // Like a call to allocate_object, but the object is only written to the frame by whatever uses it next, as the frame state has no slot for it.
+    // So the helper leaves it on the native stack instead, where the values that are live afterwards but aren't in the frame are stashed as well.
+    // Those can only be primitives, as the garbage collector would have to update a reference.
+    case Opcode::Materialize: {
+        auto const& frame_state = *node.frame_state;
+        write_frame_state(frame_state);
+
+        auto in_frame = [&](Node const* value) {
+            return frame_state.slots.find_first_index_if([&](auto const* slot_value) { return slot_value == value; });
+        };
+
+        // Spill slots aren't touched by the helper, so only registers need to be stashed
+        Vector<Node*> stashed;
+        for (auto* value : m_register_allocator.live_after_call(node)) {
+            if (in_frame(value).has_value())
+                continue;
+
+            if (value->type == Type::Reference || value->type == Type::Unknown)
+                return Error::from_string_literal("A reference that is live across an allocation isn't in the interpreter's frame");
+
+            if (m_register_allocator.location(*value).kind == Location::Kind::Register)
+                stashed.append(value);
+        }
+
+        Vector<IR::VirtualField const*> stashed_fields;
+        for (auto const& field : node.fields) {
+            if (is_stashed(field))
+                stashed_fields.append(&field);
+        }
+
+        auto size = reserve_native_stack(stashed.size() + stashed_fields.size());
+        for (size_t i = 0; i < stashed.size(); i++)
+            assembler.mov(slot_size, native_stack_slot(1 + i), m_register_allocator.location(*stashed[i]).reg);
+        for (size_t i = 0; i < stashed_fields.size(); i++) {
+            load(Register::RAX, *stashed_fields[i]->value);
+            assembler.mov(slot_size, native_stack_slot(1 + stashed.size() + i), Register::RAX);
+        }
+
+        m_exit_stubs.append(Stub { &node, make<Label>() });
+        allocate_object(*node.instruction, frame_state.index, *m_exit_stubs.last().label);
+
+        for (size_t i = 0, stashed_index = 0; i < node.fields.size(); i++) {
+            auto const& field = node.fields[i];
+            if (is_stashed(field))
+                assembler.mov(slot_size, Register::RDX, native_stack_slot(1 + stashed.size() + stashed_index++));
+            else if (field.value->is_constant())
+                assembler.mov(Register::RDX, field.value->constant);
+            else
+                assembler.mov(slot_size, Register::RDX, slot(*in_frame(field.value)));
+
+            store_field(Register::RCX, field.offset, field.memory_kind, Register::RDX);
+        }
+
+        store(node, Register::RCX);
+        for (size_t i = 0; i < stashed.size(); i++)
+            assembler.mov(slot_size, m_register_allocator.location(*stashed[i]).reg, native_stack_slot(1 + i));
+
+        for (auto* value : m_register_allocator.live_after_call(node)) {
+            if (auto index = in_frame(value); index.has_value()) {
+                assembler.mov(slot_size, Register::RAX, slot(*index));
+                store(*value, Register::RAX);
+            }
+        }
+
+        assembler.arithmetic(ArithmeticOperation::Add, OperandSize::QuadWord, Register::RSP, static_cast<i32>(size));
+        return {};
+    }
+
+    // The ends of blocks
+    case Opcode::Jump: {
+        auto& successor = *node.block->successors.first();
+        emit_phi_moves(*node.block, successor);
+        jump_to(successor);
+        return {};
+    }
+
+    // Both operands are in the same form as a slot, so they compare the same way as the values that they hold.
+    // Critical edges have been split, so neither successor has any phis.
+    case Opcode::Branch: {
+        auto& taken = *node.block->successors[0];
+        auto& not_taken = *node.block->successors[1];
+        VERIFY(taken.phis.is_empty() && not_taken.phis.is_empty());
+
+        auto left = in_register(*node.inputs[0], Register::RAX);
+        auto const& right = *node.inputs[1];
+        if (right.is_constant() && fits_in_i32(right.as_long()))
+            assembler.arithmetic(ArithmeticOperation::Compare, slot_size, left, static_cast<i32>(right.as_long()));
+        else
+            assembler.arithmetic(ArithmeticOperation::Compare, slot_size, left, in_register(right, Register::RCX));
+
+        if (&taken == m_next_block) {
+            assembler.jump(negate(node.condition), m_block_labels[not_taken.id]);
+            return {};
+        }
+
+        assembler.jump(node.condition, m_block_labels[taken.id]);
+        jump_to(not_taken);
+        return {};
+    }
+
+    // The successors are the default target, followed by each case's target
+    case Opcode::Switch: {
+        auto const& switch_table = *node.instruction->switch_table;
+        auto& successors = node.block->successors;
+        for (auto* successor : successors)
+            VERIFY(successor->phis.is_empty());
+
+        load(Register::RAX, *node.inputs[0]);
+        if (switch_table.matches.is_empty()) {
+            // Out of range indices (including those below `low`) wrap around to large unsigned values
+            assembler.arithmetic(ArithmeticOperation::Subtract, long_size, Register::RAX, switch_table.low);
+            assembler.arithmetic(ArithmeticOperation::Compare, long_size, Register::RAX, static_cast<i32>(switch_table.targets.size()));
+            assembler.jump(Condition::AboveOrEqual, m_block_labels[successors[0]->id]);
+
+            m_jump_tables.append(Stub { &node, make<Label>() });
+            auto& jump_table = *m_jump_tables.last().label;
+            assembler.lea(Register::RCX, jump_table);
+            assembler.movsx(int_size, Register::RAX, Address { .base = Register::RCX, .index = Register::RAX, .scale = 4 });
+            assembler.arithmetic(ArithmeticOperation::Add, OperandSize::QuadWord, Register::RAX, Register::RCX);
+            assembler.jump(Register::RAX);
+            return {};
+        }
+
+        for (size_t i = 0; i < switch_table.matches.size(); i++) {
+            assembler.arithmetic(ArithmeticOperation::Compare, int_size, Register::RAX, switch_table.matches[i]);
+            assembler.jump(Condition::Equal, m_block_labels[successors[i + 1]->id]);
+        }
+
+        jump_to(*successors[0]);
+        return {};
+    }
+
+    case Opcode::Return:
+        if (node.inputs.is_empty())
+            assembler.mov(Register::RDX, 0);
+        else
+            load(Register::RDX, *node.inputs[0]);
+
+        assembler.mov(Register::RAX, to_underlying(ExitReason::Return));
+        assembler.jump(m_epilogue);
+        return {};
+
+    case Opcode::Deoptimize:
+        assembler.jump(deoptimization_label(node));
+        return {};
+    }
+
+    VERIFY_NOT_REACHED();
+}
+
+Label& OptimizingCompiler::create_label()
+{
+    m_local_labels.append(make<Label>());
+    return *m_local_labels.last();
+}
+
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "../Interpreter/InstructionStream.h"
+#include "Assembler.h"
+#include "CodeCache.h"
+#include "CompiledCode.h"
+#include "IR.h"
+#include "RegisterAllocator.h"
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Vector.h>
+
+// Forward-declaration
+namespace Interpreter {
+class Heap;
+class Method;
+}
+
+namespace JIT {
+
+// Compiles the hottest methods a second time, once their baseline code has run for long enough (see TieringPolicy).
+//
+// The method is lifted into SSA form (see GraphBuilder), optimized (see Optimizer), and its values are allocated to registers (see RegisterAllocator).
+// Unlike baseline code, values live in registers, so the interpreter's frame is only written to when something else needs to see it:
+// - A check that fails writes out its frame state, and hands the frame over to the interpreter just before the instruction that would have thrown.
+// - A call to a helper function writes out the frame state before the call, so that the helper finds its operands (and the garbage collector finds every reference) in the frame.
+//   Afterwards, every value that's still live is loaded back from the frame, as the garbage collector can have moved it.
+//
+// - An object whose allocation the optimizer has removed is allocated by the check's stub if the check fails, as the interpreter expects to find it in the frame.
+//   A Materialize allocates an object at the point where it escapes, like a call to allocate_object.
+//
+// The code uses the same registers as baseline code for the frame (rbx, r12 and r13), and has the same entry points, so the interpreter treats both tiers the same way.
+class OptimizingCompiler {
+public:
+    // Fails if the method uses jsr or ret, if a value that's live across a call can't be found in the frame, or if the code cache is full
+    static ErrorOr<NonnullOwnPtr<CompiledCode>> compile(Interpreter::Method&, Interpreter::InstructionStream&, Interpreter::Heap&, CodeCache&, bool dump_graph);
+
+private:
+    OptimizingCompiler(Interpreter::Method&, Interpreter::InstructionStream&, Interpreter::Heap&, IR::Graph&, RegisterAllocator);
+
+    ErrorOr<void> compile_graph();
+
+    // Saves the callee-saved registers, reserves the spill slots, and loads the frame's registers from the entry point's arguments
+    void emit_prologue();
+    ErrorOr<void> compile_node(IR::Node&);
+
+    // Moves the values of the successor's phis into place, as if they were all moved at once
+    void emit_phi_moves(IR::Block& block, IR::Block& successor);
+    void jump_to(IR::Block& successor);
+
+    // A slot of the interpreter's frame, counting from the first local variable
+    Address slot(u32 index) const;
+    Address spill_slot(u32 index) const;
+
+    void load(Register destination, IR::Node const& value);
+    void store(IR::Node const& value, Register source);
+
+    // Writes every value of a frame state out to the interpreter's frame, a slot that holds a virtual object is null until the object has been allocated
+    void write_frame_state(IR::FrameState const&);
+
+    // Allocates the frame state's virtual objects, and writes them out to the slots that hold them.
+    // Only the frame is visible to the garbage collector, so the fields are stored once every object has been allocated: a reference from its slot in the frame,
+    // and anything else from the native stack, where it was stashed before the first allocation.
+    void materialize_virtual_objects(IR::FrameState const&, Label& failure);
+
+    // Allocates an object for a new instruction, and leaves it in rcx.
+    // The helper writes it to the top of the native stack, which the caller reserves, along with the pc of the instruction at `frame_state_index`.
+    void allocate_object(Interpreter::Instruction&, u32 frame_state_index, Label& failure);
+
+    // Stores a value into a field, this uses rax and r11 for the write barrier of a reference
+    void store_field(Register object, u32 offset, IR::MemoryKind, Register value);
+
+    // Reserves space on the native stack for the helper's result, followed by `count` stashed values, keeping the stack 16-byte aligned
+    u32 reserve_native_stack(size_t count);
+    static Address native_stack_slot(size_t index) { return { .base = Register::RSP, .displacement = static_cast<i32>(index * 8) }; };
+
+    // Hands the frame over to the interpreter at the node's frame state, the stub is emitted after the rest of the code
+    Label& deoptimization_label(IR::Node const&);
+
+    // A label within the current node's code
+    Label& create_label();
+
+    Interpreter::Method& m_method;
+    Interpreter::InstructionStream& m_instruction_stream;
+    Interpreter::Heap& m_heap;
+    IR::Graph& m_graph;
+    RegisterAllocator m_register_allocator;
+    u32 m_max_locals { 0 };
+
+    Assembler m_assembler;
+    Label m_epilogue;
+
+    // Indexed by block id
+    Vector<Label> m_block_labels;
+
+    // The block that comes after the one which is being compiled, which it can fall through to
+    IR::Block* m_next_block { nullptr };
+
+    // The stubs of checks (which deoptimize) and calls (which exit with whatever the helper returned), and the jump tables of tableswitches
+    struct Stub {
+        IR::Node* node { nullptr };
+        NonnullOwnPtr<Label> label;
+    };
+    Vector<Stub> m_deoptimization_stubs;
+    Vector<Stub> m_exit_stubs;
+    Vector<Stub> m_jump_tables;
+
+    // The assembler refers to labels until the code is finalized, so these can't move
+    Vector<NonnullOwnPtr<Label>> m_local_labels;
+};
+
+}
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "RegisterAllocator.h"
+#include <AK/NumericLimits.h>
+#include <AK/QuickSort.h>
+
+namespace JIT {
+
+using IR::Block;
+using IR::Node;
+using IR::Opcode;
+using IR::Type;
+
+static bool needs_location(Node const& node)
+{
+    return node.type != Type::Void && !node.is_constant();
+}
+
+// The live values are sets of node ids, as bitsets
+static void add(Vector<u64>& set, u32 id)
+{
+    set[id / 64] |= 1ull << (id % 64);
+}
+
+static void remove(Vector<u64>& set, u32 id)
+{
+    set[id / 64] &= ~(1ull << (id % 64));
+}
+
+template<typename Callback>
+static void for_each_id(Vector<u64> const& set, Callback callback)
+{
+    for (size_t word = 0; word < set.size(); word++) {
+        for (auto bits = set[word]; bits != 0; bits &= bits - 1)
+            callback(static_cast<u32>(word * 64 + __builtin_ctzll(bits)));
+    }
+}
+
+RegisterAllocator::RegisterAllocator(IR::Graph& graph)
+    : m_graph(graph)
+{
+}
+
+RegisterAllocator RegisterAllocator::allocate(IR::Graph& graph)
+{
+    RegisterAllocator allocator(graph);
+    allocator.number_nodes();
+    allocator.compute_liveness();
+    allocator.build_intervals();
+    allocator.scan();
+    return allocator;
+}
+
+void RegisterAllocator::number_nodes()
+{
+    m_positions.resize(m_graph.nodes().size());
+    m_block_start.resize(m_graph.block_count());
+    m_block_end.resize(m_graph.block_count());
+
+    // The phis of a block are defined where it starts, and the moves into its successors' phis happen where it ends
+    u32 position = 0;
+    for (auto* block : m_graph.blocks()) {
+        m_block_start[block->id] = position;
+        for (auto* phi : block->phis)
+            m_positions[phi->id] = position;
+        position += 2;
+
+        for (auto* node : block->nodes) {
+            m_positions[node->id] = position;
+            position += 2;
+        }
+
+        m_block_end[block->id] = position;
+        position += 2;
+    }
+}
+
+// The usual backwards data-flow analysis, until nothing changes.
+// A phi's input is live at the end of the predecessor that it comes from, rather than at the start of the phi's block.
+void RegisterAllocator::compute_liveness()
+{
+    auto word_count = (m_graph.nodes().size() + 63) / 64;
+    m_live_in.resize(m_graph.block_count());
+    m_live_out.resize(m_graph.block_count());
+    for (auto* block : m_graph.blocks()) {
+        m_live_in[block->id].resize(word_count);
+        m_live_out[block->id].resize(word_count);
+    }
+
+    auto const& blocks = m_graph.blocks();
+    auto live_at_end = [&](Block const& block) {
+        Vector<u64> live;
+        live.resize(word_count);
+        for (auto const* successor : block.successors) {
+            auto const& successor_live_in = m_live_in[successor->id];
+            for (size_t word = 0; word < word_count; word++)
+                live[word] |= successor_live_in[word];
+
+            for (size_t i = 0; i < successor->predecessors.size(); i++) {
+                if (successor->predecessors[i] != &block)
+                    continue;
+
+                for (auto const* phi : successor->phis) {
+                    if (needs_location(*phi->inputs[i]))
+                        add(live, phi->inputs[i]->id);
+                }
+            }
+        }
+
+        return live;
+    };
+
+    auto walk_block = [&](Block const& block, Vector<u64>& live, bool record_calls) {
+        for (size_t i = block.nodes.size(); i > 0; i--) {
+            auto& node = *block.nodes[i - 1];
+            remove(live, node.id);
+
+            if (record_calls && (node.opcode == Opcode::Call || node.opcode == Opcode::Materialize)) {
+                auto& live_after = m_live_after_call[node.id];
+                for_each_id(live, [&](u32 id) { live_after.append(m_graph.nodes()[id].ptr()); });
+            }
+
+            m_graph.for_each_use(node, [&](Node* value) {
+                if (needs_location(*value))
+                    add(live, value->id);
+            });
+        }
+
+        for (auto const* phi : block.phis)
+            remove(live, phi->id);
+    };
+
+    auto changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = blocks.size(); i > 0; i--) {
+            auto& block = *blocks[i - 1];
+            auto live = live_at_end(block);
+            m_live_out[block.id] = live;
+            walk_block(block, live, false);
+
+            if (live != m_live_in[block.id]) {
+                m_live_in[block.id] = move(live);
+                changed = true;
+            }
+        }
+    }
+
+    m_live_after_call.resize(m_graph.nodes().size());
+    for (auto* block : blocks) {
+        auto live = m_live_out[block->id];
+        walk_block(*block, live, true);
+    }
+}
+
+void RegisterAllocator::build_intervals()
+{
+    Vector<u32> start;
+    Vector<u32> end;
+    start.resize(m_graph.nodes().size());
+    end.resize(m_graph.nodes().size());
+    for (auto& position : start)
+        position = NumericLimits<u32>::max();
+
+    auto extend = [&](Node const& value, u32 position) {
+        start[value.id] = min(start[value.id], position);
+        end[value.id] = max(end[value.id], position);
+    };
+
+    auto const& nodes = m_graph.nodes();
+    for (auto* block : m_graph.blocks()) {
+        for_each_id(m_live_in[block->id], [&](u32 id) { extend(*nodes[id], m_block_start[block->id]); });
+        for_each_id(m_live_out[block->id], [&](u32 id) { extend(*nodes[id], m_block_end[block->id]); });
+
+        // A phi is written at the end of each predecessor, which has to keep its register free from there on
+        for (auto* phi : block->phis) {
+            extend(*phi, m_block_start[block->id]);
+            for (auto* predecessor : block->predecessors)
+                extend(*phi, m_block_end[predecessor->id]);
+        }
+
+        for (auto* node : block->nodes) {
+            auto position = m_positions[node->id];
+            if (needs_location(*node))
+                extend(*node, position + 1);
+
+            m_graph.for_each_use(*node, [&](Node* value) {
+                if (needs_location(*value))
+                    extend(*value, position);
+            });
+        }
+    }
+
+    for (auto& node : nodes) {
+        if (start[node->id] <= end[node->id])
+            m_intervals.append(Interval { node.ptr(), start[node->id], end[node->id] });
+    }
+
+    quick_sort(m_intervals, [](auto const& a, auto const& b) { return a.start < b.start; });
+}
+
+void RegisterAllocator::scan()
+{
+    m_locations.resize(m_graph.nodes().size());
+
+    Vector<Register> free_registers;
+    for (size_t i = allocatable_registers.size(); i > 0; i--)
+        free_registers.append(allocatable_registers[i - 1]);
+
+    // The intervals that have a register, sorted by where they end
+    Vector<Interval*> active;
+    auto activate = [&](Interval& interval) {
+        size_t index = 0;
+        while (index < active.size() && active[index]->end <= interval.end)
+            index++;
+        active.insert(index, &interval);
+    };
+
+    auto spill = [&](Interval& interval) {
+        m_locations[interval.value->id] = { .kind = Location::Kind::Spill, .spill_slot = m_spill_slot_count++ };
+    };
+
+    for (auto& interval : m_intervals) {
+        while (!active.is_empty() && active.first()->end < interval.start) {
+            free_registers.append(m_locations[active.first()->value->id].reg);
+            active.remove(0);
+        }
+
+        if (!free_registers.is_empty()) {
+            m_locations[interval.value->id] = { .kind = Location::Kind::Register, .reg = free_registers.take_last() };
+            activate(interval);
+            continue;
+        }
+
+        // Whichever interval ends last is spilled, which frees a register for the longest time
+        auto& last = *active.last();
+        if (last.end <= interval.end) {
+            spill(interval);
+            continue;
+        }
+
+        m_locations[interval.value->id] = m_locations[last.value->id];
+        spill(last);
+        active.take_last();
+        activate(interval);
+    }
+}
+
+}
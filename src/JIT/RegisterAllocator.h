@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "Assembler.h"
+#include "IR.h"
+#include <AK/Array.h>
+#include <AK/Vector.h>
+
+namespace JIT {
+
+// Where a value lives for as long as it's live, every value only ever has a single location
+struct Location {
+    enum class Kind : u8 {
+        // Constants are materialized wherever they are used, and values without a type (e.g. stores) don't need a location
+        None,
+        Register,
+
+        // A slot of the compiled code's own stack frame, below the registers that its prologue saves
+        Spill,
+    };
+
+    Kind kind { Kind::None };
+    Register reg { Register::RAX };
+    u32 spill_slot { 0 };
+
+    bool operator==(Location const&) const = default;
+};
+
+// Assigns a register (or a spill slot) to every value of the IR, with linear scan register allocation.
+// "Linear Scan Register Allocation", Poletto and Sarkar.
+// https://dl.acm.org/doi/10.1145/330249.330250
+//
+// The blocks are laid out in reverse post-order, and each value's live range is a single interval over that order,
+// from its definition to its last use, which covers every block that it's live through.
+// The helper functions that Call nodes call can clobber every register, and the garbage collector can move the objects that the registers refer to,
+// so the compiled code reloads every value that's live after a call from the interpreter's frame. See OptimizingCompiler.
+class RegisterAllocator {
+public:
+    // The registers that values are allocated to, the rest are either scratch registers for the compiled code (rax, rcx, rdx and r11),
+    // or hold the frame's registers (rbx, r12 and r13, see BaselineCompiler)
+    static constexpr Array<Register, 7> allocatable_registers { Register::RSI, Register::RDI, Register::R8, Register::R9, Register::R10, Register::R14, Register::R15 };
+
+    static RegisterAllocator allocate(IR::Graph&);
+
+    Location location(IR::Node const& node) const { return m_locations[node.id]; };
+    u32 spill_slot_count() const { return m_spill_slot_count; };
+
+    // The values that are still used after a Call (or Materialize) node, apart from the call's own result
+    Vector<IR::Node*> const& live_after_call(IR::Node const& call) const { return m_live_after_call[call.id]; };
+
+private:
+    explicit RegisterAllocator(IR::Graph&);
+
+    // Positions within the reverse post-order: a node's inputs are used at an even position, and its result is defined at the odd position after it
+    void number_nodes();
+    void compute_liveness();
+    void build_intervals();
+    void scan();
+
+    struct Interval {
+        IR::Node* value { nullptr };
+        u32 start { 0 };
+        u32 end { 0 };
+    };
+
+    IR::Graph& m_graph;
+
+    // Indexed by node id
+    Vector<u32> m_positions;
+    Vector<Location> m_locations;
+    Vector<Vector<IR::Node*>> m_live_after_call;
+
+    // Indexed by block id: the positions of the start and end of each block, and the values that are live when it starts and ends
+    Vector<u32> m_block_start;
+    Vector<u32> m_block_end;
+    Vector<Vector<u64>> m_live_in;
+    Vector<Vector<u64>> m_live_out;
+
+    Vector<Interval> m_intervals;
+    u32 m_spill_slot_count { 0 };
+};
+
+}
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "ClassLoader.h"
+#include "../Parser/ClassParser.h"
+#include "../Parser/ConstantInfo.h"
+#include "Verifier.h"
+#include <AK/Atomic.h>
+#include <AK/DeprecatedString.h>
+#include <AK/Optional.h>
+#include <AK/QuickSort.h>
+#include <LibCore/DirIterator.h>
+#include <LibCore/System.h>
+#include <LibThreading/Mutex.h>
+#include <LibThreading/Thread.h>
+#include <sys/stat.h>
+
+namespace Loader {
+
+ErrorOr<bool> ClassRegistry::register_class(Symbol name, NonnullOwnPtr<Parser::ClassFile> class_file)
+{
+    if (m_classes.contains(name))
+        return false;
+
+    TRY(m_classes.try_set(name, move(class_file)));
+    return true;
+}
+
+Parser::ClassFile* ClassRegistry::find(Symbol name)
+{
+    auto iterator = m_classes.find(name);
+    if (iterator == m_classes.end())
+        return nullptr;
+
+    return iterator->value.ptr();
+}
+
+String const* ClassRegistry::verification_failure(Symbol name) const
+{
+    auto iterator = m_verification_failures.find(name);
+    if (iterator == m_verification_failures.end() || !iterator->value.has_value())
+        return nullptr;
+
+    return &iterator->value.value();
+}
+
+ClassLoader::ClassLoader(ClassRegistry& registry, size_t worker_count)
+    : m_registry(registry)
+    , m_worker_count(max<size_t>(worker_count, 1))
+{
+}
+
+ErrorOr<Vector<ClassSource>> ClassLoader::collect_class_files(Vector<StringView> const& paths)
+{
+    auto class_sources = Vector<ClassSource>();
+    for (auto const& path : paths) {
+        TRY(collect_class_files(path, class_sources));
+    }
+
+    return class_sources;
+}
+
+static bool is_jar_path(StringView path)
+{
+    return path.ends_with(".jar"sv, CaseSensitivity::CaseInsensitive) || path.ends_with(".zip"sv, CaseSensitivity::CaseInsensitive);
+}
+
+ErrorOr<void> ClassLoader::collect_class_files(StringView path, Vector<ClassSource>& class_sources)
+{
+    // A path which was given explicitly is always loaded, even if it doesn't end in .class
+    auto path_stat = TRY(Core::System::stat(path));
+    if (!S_ISDIR(path_stat.st_mode)) {
+        if (is_jar_path(path))
+            return collect_jar_entries(path, class_sources);
+
+        TRY(class_sources.try_append(ClassSource { .path = TRY(String::from_utf8(path)) }));
+        return {};
+    }
+
+    Core::DirIterator iterator(path.to_deprecated_string(), Core::DirIterator::SkipParentAndBaseDir);
+    if (iterator.has_error())
+        return Error::from_string_literal("Failed to iterate over classpath directory");
+
+    // The order of directory entries isn't stable, sort them so that loading is deterministic
+    auto children = Vector<DeprecatedString>();
+    while (iterator.has_next()) {
+        TRY(children.try_append(iterator.next_full_path()));
+    }
+    quick_sort(children);
+
+    for (auto const& child : children) {
+        auto child_stat = TRY(Core::System::stat(child.view()));
+        if (S_ISDIR(child_stat.st_mode)) {
+            TRY(collect_class_files(child.view(), class_sources));
+        } else if (child.ends_with(".class"sv)) {
+            TRY(class_sources.try_append(ClassSource { .path = TRY(String::from_deprecated_string(child)) }));
+        } else if (is_jar_path(child.view())) {
+            TRY(collect_jar_entries(child.view(), class_sources));
+        }
+    }
+
+    return {};
+}
+
+ErrorOr<void> ClassLoader::collect_jar_entries(StringView path, Vector<ClassSource>& class_sources)
+{
+    auto jar_file = TRY(JarFile::open(path));
+    for (auto const& entry : jar_file->entries()) {
+        // JARs also contain resources and metadata, we're only interested in the class files
+        if (!entry.name.bytes_as_string_view().ends_with(".class"sv))
+            continue;
+
+        TRY(class_sources.try_append(ClassSource {
+            .path = entry.name,
+            .jar = jar_file.ptr(),
+            .jar_entry = &entry,
+        }));
+    }
+
+    TRY(m_jar_files.try_append(move(jar_file)));
+    return {};
+}
+
+ErrorOr<void> ClassLoader::load(Vector<StringView> const& paths)
+{
+    auto class_sources = TRY(collect_class_files(paths));
+    return load_class_files(class_sources);
+}
+
+static ErrorOr<NonnullOwnPtr<Parser::ClassFile>> parse_class_file(ClassSource const& source)
+{
+    auto class_parser = source.jar
+        ? TRY(source.jar->open_class(*source.jar_entry))
+        : TRY(Parser::ClassParser::create(source.path.bytes_as_string_view()));
+
+    auto class_file = TRY(class_parser->parse());
+
+    return try_make<Parser::ClassFile>(move(class_file));
+}
+
+// Runs the task for every index in [0, count) on up to `worker_count` threads.
+// Workers pull the next index off of a shared counter, which keeps them balanced even if some tasks take much longer than others.
+template<typename Task>
+static ErrorOr<void> for_each_index_in_parallel(size_t count, size_t worker_count, Task const& task)
+{
+    Atomic<size_t> next_index { 0 };
+    auto worker = [&]() -> intptr_t {
+        while (true) {
+            auto index = next_index.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+            if (index >= count)
+                return 0;
+
+            task(index);
+        }
+    };
+
+    // There's no point in spinning up more threads than there are tasks
+    worker_count = min(worker_count, count);
+    if (worker_count <= 1) {
+        worker();
+        return {};
+    }
+
+    auto threads = Vector<NonnullRefPtr<Threading::Thread>>();
+    for (size_t i = 0; i < worker_count; i++) {
+        auto thread = Threading::Thread::construct(worker, "ClassLoader"sv);
+        thread->start();
+        TRY(threads.try_append(move(thread)));
+    }
+
+    for (auto& thread : threads) {
+        (void)thread->join();
+    }
+
+    return {};
+}
+
+ErrorOr<void> ClassLoader::load_class_files(Vector<ClassSource> const& class_sources)
+{
+    // Each class file gets its own slot, so workers never have to synchronize while parsing.
+    // The results are merged into the registry afterwards, in classpath order, so that the first definition of a class always wins.
+    auto parsed_classes = Vector<OwnPtr<Parser::ClassFile>>();
+    TRY(parsed_classes.try_resize(class_sources.size()));
+
+    Threading::Mutex error_mutex;
+    Optional<Error> first_error;
+
+    TRY(for_each_index_in_parallel(class_sources.size(), m_worker_count, [&](size_t index) {
+        auto const& source = class_sources[index];
+        auto class_file_or_error = parse_class_file(source);
+        if (class_file_or_error.is_error()) {
+            Threading::MutexLocker locker(error_mutex);
+            warnln("Failed to load {}: {}", source.path, class_file_or_error.error());
+
+            if (!first_error.has_value())
+                first_error = class_file_or_error.release_error();
+
+            return;
+        }
+
+        parsed_classes[index] = class_file_or_error.release_value();
+    }));
+
+    if (first_error.has_value())
+        return first_error.release_value();
+
+    auto registered_classes = Vector<Symbol>();
+    for (auto& class_file : parsed_classes) {
+        auto name = TRY(class_name(*class_file));
+        auto registered = TRY(m_registry.register_class(name, class_file.release_nonnull()));
+        if (!registered) {
+            dbgln("ClassLoader: Ignoring duplicate definition of {}", name);
+            continue;
+        }
+
+        TRY(registered_classes.try_append(name));
+    }
+
+    // Every class has been registered by now, so the verifier can look at the superclasses of any of them
+    if (m_verification_enabled)
+        TRY(verify_classes(registered_classes));
+
+    return {};
+}
+
+ErrorOr<void> ClassLoader::verify_classes(Vector<Symbol> const& class_names)
+{
+    struct ClassToVerify {
+        Symbol name;
+        NonnullOwnPtr<Verifier> verifier;
+
+        // Indexed by method, so that the workers never write to the same slot
+        Vector<Optional<String>> failures;
+    };
+
+    struct MethodToVerify {
+        size_t class_index;
+        size_t method_index;
+        size_t code_length;
+    };
+
+    auto classes = Vector<ClassToVerify>();
+    auto methods = Vector<MethodToVerify>();
+    for (auto name : class_names) {
+        auto* class_file = m_registry.find(name);
+        if (!class_file || m_registry.is_verified(name) || !Verifier::can_verify(*class_file))
+            continue;
+
+        auto verifier = TRY(try_make<Verifier>(m_registry, *class_file, name));
+        auto failures = Vector<Optional<String>>();
+        TRY(failures.try_resize(class_file->methods.size()));
+
+        for (size_t method_index = 0; method_index < class_file->methods.size(); method_index++) {
+            size_t code_length = 0;
+            for (auto const& attribute : class_file->methods[method_index]->attributes) {
+                if (attribute->type() == Parser::AttributeType::Code)
+                    code_length = static_ptr_cast<Parser::CodeAttribute>(attribute)->code().size();
+            }
+
+            TRY(methods.try_append(MethodToVerify { .class_index = classes.size(), .method_index = method_index, .code_length = code_length }));
+        }
+
+        TRY(classes.try_append(ClassToVerify { .name = name, .verifier = move(verifier), .failures = move(failures) }));
+    }
+
+    // The longest methods are verified first, so that one of them doesn't hold up a single thread after the others have finished
+    quick_sort(methods, [](auto const& a, auto const& b) { return a.code_length > b.code_length; });
+
+    Threading::Mutex error_mutex;
+    Optional<Error> first_error;
+
+    TRY(for_each_index_in_parallel(methods.size(), m_worker_count, [&](size_t index) {
+        auto const& method = methods[index];
+        auto& klass = classes[method.class_index];
+
+        auto failure_or_error = klass.verifier->verify_method(*klass.verifier->class_file().methods[method.method_index]);
+        if (failure_or_error.is_error()) {
+            Threading::MutexLocker locker(error_mutex);
+            if (!first_error.has_value())
+                first_error = failure_or_error.release_error();
+
+            return;
+        }
+
+        klass.failures[method.method_index] = failure_or_error.release_value();
+    }));
+
+    if (first_error.has_value())
+        return first_error.release_value();
+
+    // A class is rejected because of its first method that fails, in the order that they're declared in
+    for (auto& klass : classes) {
+        Optional<String> class_failure;
+        for (auto& failure : klass.failures) {
+            if (failure.has_value()) {
+                class_failure = move(failure);
+                break;
+            }
+        }
+
+        if (class_failure.has_value())
+            dbgln("ClassLoader: {} failed verification: {}", klass.name, *class_failure);
+
+        TRY(m_registry.set_verification_failure(klass.name, move(class_failure)));
+    }
+
+    return {};
+}
+
+ErrorOr<Symbol> ClassLoader::class_name(Parser::ClassFile const& class_file)
+{
+    // The constant_pool entry at `this_class` must be a CONSTANT_Class_info structure representing the class or interface defined by this class file.
+    auto class_info = TRY(class_file.constant_pool->class_at(class_file.this_class));
+    auto name_utf8 = TRY(class_file.constant_pool->utf8_at(class_info.name_index()));
+
+    return name_utf8.symbol();
+}
+
+}
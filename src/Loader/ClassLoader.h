@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "../Parser/ClassFile.h"
+#include "../Symbol.h"
+#include "JarFile.h"
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+
+namespace Loader {
+
+// Holds every class that has been loaded, keyed by the binary name of the class (the name of `this_class`).
+class ClassRegistry {
+public:
+    // Registers a class, if a class with the same name already exists then the existing one is kept.
+    // This mirrors the behaviour of a classpath, where the first definition of a class wins.
+    ErrorOr<bool> register_class(Symbol name, NonnullOwnPtr<Parser::ClassFile> class_file);
+
+    // Returns the class with the binary name, or null if it hasn't been loaded
+    Parser::ClassFile* find(Symbol name);
+
+    HashMap<Symbol, NonnullOwnPtr<Parser::ClassFile>> const& classes() const { return m_classes; };
+    size_t size() const { return m_classes.size(); };
+
+    // The outcome of verifying a class (see Verifier), which every runtime that links the class reuses.
+    // Classes that were registered directly, rather than loaded from the classpath by a ClassLoader, are trusted like the JDK's own classes, and are never verified.
+    bool is_verified(Symbol name) const { return m_verification_failures.contains(name); };
+    ErrorOr<void> set_verification_failure(Symbol name, Optional<String> failure) { return m_verification_failures.try_set(name, move(failure)); };
+
+    // Returns why the class isn't type-safe, or null if it passed verification (or was never verified)
+    String const* verification_failure(Symbol name) const;
+
+private:
+    HashMap<Symbol, NonnullOwnPtr<Parser::ClassFile>> m_classes;
+
+    // Every class that has been verified, along with why it failed (if it did)
+    HashMap<Symbol, Optional<String>> m_verification_failures;
+};
+
+// A single class file on the classpath, either a loose .class file or an entry within a JAR
+struct ClassSource {
+    // The path to a loose class file, or the name of the entry within the JAR
+    String path;
+
+    // The JAR containing this class file, this is owned by the ClassLoader
+    JarFile const* jar { nullptr };
+    JarFile::Entry const* jar_entry { nullptr };
+};
+
+// Loads class files from a list of paths, which may be .class files, .jar files, or directories containing them.
+// Parsing is fanned out to a pool of worker threads, each of which runs its own independent ClassParser.
+// Once every class has been registered, their methods are verified on the same number of threads, see Verifier.
+class ClassLoader {
+public:
+    ClassLoader(ClassRegistry& registry, size_t worker_count);
+
+    // Verification is on by default, a class that fails it can't be linked
+    void set_verification_enabled(bool verification_enabled) { m_verification_enabled = verification_enabled; };
+
+    // Recursively collects every class file found at the paths, in the order that they were given
+    ErrorOr<Vector<ClassSource>> collect_class_files(Vector<StringView> const& paths);
+
+    // Parses every class file found at the paths, and registers them into the registry
+    ErrorOr<void> load(Vector<StringView> const& paths);
+
+    // Parses the class files, and registers them into the registry
+    ErrorOr<void> load_class_files(Vector<ClassSource> const& class_sources);
+
+    // Verifies every method of the registered classes, and records the outcome for each class in the registry.
+    // Each method is verified on its own, so the methods of a single class are spread over several threads.
+    // Classes which have already been verified are skipped, so loading a class again is free.
+    ErrorOr<void> verify_classes(Vector<Symbol> const& class_names);
+
+    // Returns the binary name of the class defined by a class file
+    static ErrorOr<Symbol> class_name(Parser::ClassFile const& class_file);
+
+private:
+    ErrorOr<void> collect_class_files(StringView path, Vector<ClassSource>& class_sources);
+    ErrorOr<void> collect_jar_entries(StringView path, Vector<ClassSource>& class_sources);
+
+    ClassRegistry& m_registry;
+    size_t m_worker_count;
+    bool m_verification_enabled { true };
+
+    // The class sources point at the entries of these archives, so they must outlive the sources
+    Vector<NonnullRefPtr<JarFile>> m_jar_files;
+};
+
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "JarFile.h"
+#include <LibCompress/Deflate.h>
+
+namespace Loader {
+
+// Unlike class files, all of the values in a ZIP archive are stored in little-endian order
+static ErrorOr<u16> read_u16(ReadonlyBytes bytes, size_t offset)
+{
+    if (offset + 2 > bytes.size())
+        return Error::from_string_literal("Unexpected end of JAR file");
+
+    return static_cast<u16>(bytes[offset] | (bytes[offset + 1] << 8));
+}
+
+static ErrorOr<u32> read_u32(ReadonlyBytes bytes, size_t offset)
+{
+    if (offset + 4 > bytes.size())
+        return Error::from_string_literal("Unexpected end of JAR file");
+
+    return static_cast<u32>(bytes[offset]) | (static_cast<u32>(bytes[offset + 1]) << 8) | (static_cast<u32>(bytes[offset + 2]) << 16) | (static_cast<u32>(bytes[offset + 3]) << 24);
+}
+
+static constexpr u32 end_of_central_directory_signature = 0x06054b50;
+static constexpr u32 central_directory_header_signature = 0x02014b50;
+static constexpr u32 local_file_header_signature = 0x04034b50;
+
+static constexpr size_t end_of_central_directory_size = 22;
+static constexpr size_t central_directory_header_size = 46;
+static constexpr size_t local_file_header_size = 30;
+
+JarFile::JarFile(NonnullRefPtr<Parser::ClassFileBytes> archive, Vector<Entry> entries)
+    : m_archive(move(archive))
+    , m_entries(move(entries))
+{
+}
+
+ErrorOr<NonnullRefPtr<JarFile>> JarFile::open(StringView path)
+{
+    auto archive = TRY(Parser::ClassFileBytes::map(path));
+    auto bytes = archive->bytes();
+
+    // The end of central directory record is at the end of the archive, but it may be followed by a comment of up to 65535 bytes.
+    // We have to search backwards for its signature.
+    if (bytes.size() < end_of_central_directory_size)
+        return Error::from_string_literal("JAR file is too small to be a ZIP archive");
+
+    Optional<size_t> end_of_central_directory_offset;
+    auto search_limit = bytes.size() - min(bytes.size(), end_of_central_directory_size + 0xFFFF);
+    for (auto offset = bytes.size() - end_of_central_directory_size;; offset--) {
+        if (TRY(read_u32(bytes, offset)) == end_of_central_directory_signature) {
+            end_of_central_directory_offset = offset;
+            break;
+        }
+
+        if (offset == search_limit)
+            break;
+    }
+
+    if (!end_of_central_directory_offset.has_value())
+        return Error::from_string_literal("JAR file is missing its end of central directory record");
+
+    auto entry_count = TRY(read_u16(bytes, *end_of_central_directory_offset + 10));
+    auto central_directory_offset = TRY(read_u32(bytes, *end_of_central_directory_offset + 16));
+
+    // ZIP64 archives mark these values as 0xFFFF / 0xFFFFFFFF, and store the real ones elsewhere.
+    // FIXME: Support ZIP64 archives.
+    if (entry_count == 0xFFFF || central_directory_offset == 0xFFFFFFFF)
+        return Error::from_string_literal("ZIP64 JAR files are not supported");
+
+    auto entries = Vector<Entry>();
+    TRY(entries.try_ensure_capacity(entry_count));
+
+    size_t offset = central_directory_offset;
+    for (size_t i = 0; i < entry_count; i++) {
+        if (TRY(read_u32(bytes, offset)) != central_directory_header_signature)
+            return Error::from_string_literal("Invalid central directory header in JAR file");
+
+        auto compression_method = TRY(read_u16(bytes, offset + 10));
+        auto compressed_size = TRY(read_u32(bytes, offset + 20));
+        auto uncompressed_size = TRY(read_u32(bytes, offset + 24));
+        auto name_length = TRY(read_u16(bytes, offset + 28));
+        auto extra_field_length = TRY(read_u16(bytes, offset + 30));
+        auto comment_length = TRY(read_u16(bytes, offset + 32));
+        auto local_header_offset = TRY(read_u32(bytes, offset + 42));
+
+        auto name_offset = offset + central_directory_header_size;
+        if (name_offset + name_length > bytes.size())
+            return Error::from_string_literal("Unexpected end of JAR file");
+
+        auto name = TRY(String::from_utf8(StringView { bytes.slice(name_offset, name_length) }));
+        offset = name_offset + name_length + extra_field_length + comment_length;
+
+        // Directories don't have any data associated with them
+        if (name.bytes_as_string_view().ends_with('/'))
+            continue;
+
+        entries.unchecked_append(Entry {
+            .name = move(name),
+            .compression_method = static_cast<CompressionMethod>(compression_method),
+            .compressed_size = compressed_size,
+            .uncompressed_size = uncompressed_size,
+            .local_header_offset = local_header_offset,
+        });
+    }
+
+    return try_make_ref_counted<JarFile>(move(archive), move(entries));
+}
+
+ErrorOr<ReadonlyBytes> JarFile::entry_data(Entry const& entry) const
+{
+    auto bytes = m_archive->bytes();
+
+    // The name and extra field lengths in the local header may differ from the ones in the central directory
+    if (TRY(read_u32(bytes, entry.local_header_offset)) != local_file_header_signature)
+        return Error::from_string_literal("Invalid local file header in JAR file");
+
+    auto name_length = TRY(read_u16(bytes, entry.local_header_offset + 26));
+    auto extra_field_length = TRY(read_u16(bytes, entry.local_header_offset + 28));
+
+    size_t data_offset = entry.local_header_offset + local_file_header_size + name_length + extra_field_length;
+    if (data_offset + entry.compressed_size > bytes.size())
+        return Error::from_string_literal("Unexpected end of JAR file");
+
+    return bytes.slice(data_offset, entry.compressed_size);
+}
+
+ErrorOr<NonnullOwnPtr<Parser::ClassParser>> JarFile::open_class(Entry const& entry) const
+{
+    auto data = TRY(entry_data(entry));
+
+    switch (entry.compression_method) {
+    case CompressionMethod::Stored: {
+        // Stored entries can be parsed directly out of the mapping, without any copies
+        return try_make<Parser::ClassParser>(m_archive, data);
+    }
+
+    case CompressionMethod::Deflated: {
+        auto buffer = TRY(Compress::DeflateDecompressor::decompress_all(data));
+        if (buffer.size() != entry.uncompressed_size)
+            return Error::from_string_literal("Inflated JAR entry does not match its uncompressed size");
+
+        return Parser::ClassParser::create(move(buffer));
+    }
+    }
+
+    dbgln("JarFile: Unsupported compression method {} for {}", to_underlying(entry.compression_method), entry.name);
+    return Error::from_string_literal("Unsupported compression method in JAR file");
+}
+
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "../Parser/ClassFileBytes.h"
+#include "../Parser/ClassParser.h"
+#include <AK/NonnullOwnPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+
+namespace Loader {
+
+// A JAR (or any other ZIP archive) on the classpath.
+//
+// The archive is memory-mapped, and its central directory is read once when it is opened.
+// The class loader loads every class in the archive up front, reading a class either points
+// straight into the mapping (for stored entries) or inflates it into a buffer of its own.
+//
+// https://pkware.cachefly.net/webdocs/casestudies/APPNOTE.TXT
+class JarFile : public RefCounted<JarFile> {
+public:
+    enum CompressionMethod : u16 {
+        Stored = 0,
+        Deflated = 8,
+    };
+
+    struct Entry {
+        // The name of the entry within the archive, e.g. `java/lang/Object.class`
+        String name;
+
+        CompressionMethod compression_method;
+        u32 compressed_size;
+        u32 uncompressed_size;
+
+        // The offset of the entry's local file header, its data follows that header
+        u32 local_header_offset;
+    };
+
+    JarFile(NonnullRefPtr<Parser::ClassFileBytes> archive, Vector<Entry> entries);
+
+    static ErrorOr<NonnullRefPtr<JarFile>> open(StringView path);
+
+    // Every entry in the archive, in the order of the central directory
+    Vector<Entry> const& entries() const { return m_entries; };
+
+    // Creates a parser for a class file stored in the archive.
+    // Stored entries are parsed in-place, the parser (and anything it decodes lazily) keeps the mapping alive.
+    ErrorOr<NonnullOwnPtr<Parser::ClassParser>> open_class(Entry const& entry) const;
+
+private:
+    ErrorOr<ReadonlyBytes> entry_data(Entry const& entry) const;
+
+    NonnullRefPtr<Parser::ClassFileBytes> m_archive;
+    Vector<Entry> m_entries;
+};
+
+}
@@ -0,0 +1,1777 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Verifier.h"
+#include "../AccessFlags.h"
+#include "../Descriptor.h"
+#include "../Interpreter/Opcode.h"
+#include "../Parser/Attribute.h"
+#include "../Parser/ConstantInfo.h"
+#include "ClassLoader.h"
+#include <AK/NumericLimits.h>
+#include <AK/Vector.h>
+
+namespace Loader {
+
+using Interpreter::Opcode;
+using Parser::StackMapTableAttribute;
+
+namespace {
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.10.1.2
+struct Type {
+    enum class Kind : u8 {
+        Top,
+        Integer,
+        Float,
+        Long,
+        Double,
+
+        // The kinds from here on are references
+        Null,
+        UninitializedThis,
+        Uninitialized,
+        Reference,
+    };
+
+    Kind kind { Kind::Top };
+
+    // The offset of the new instruction that created an Uninitialized object
+    u16 new_offset { 0 };
+
+    // The class of a Reference, as a binary name (e.g. `java/lang/String`) or an array descriptor (e.g. `[I`)
+    Symbol class_name;
+
+    static Type top() { return {}; };
+    static Type integer() { return { Kind::Integer }; };
+    static Type float_() { return { Kind::Float }; };
+    static Type long_() { return { Kind::Long }; };
+    static Type double_() { return { Kind::Double }; };
+    static Type null() { return { Kind::Null }; };
+    static Type uninitialized_this() { return { Kind::UninitializedThis }; };
+    static Type uninitialized(u16 new_offset) { return { Kind::Uninitialized, new_offset }; };
+    static Type reference(Symbol class_name) { return { Kind::Reference, 0, class_name }; };
+
+    bool operator==(Type const&) const = default;
+
+    // A long or a double takes up two local variables (the second of which is Top), or two slots of the operand stack
+    bool is_category_2() const { return kind == Kind::Long || kind == Kind::Double; };
+    u8 slot_count() const { return is_category_2() ? 2 : 1; };
+
+    bool is_reference() const { return kind >= Kind::Null; };
+    bool is_initialized_reference() const { return kind == Kind::Null || kind == Kind::Reference; };
+    bool is_array() const { return kind == Kind::Reference && class_name.view().starts_with(FieldDescriptor::ArrayDimension); };
+};
+
+// The types of the local variables and the operand stack before an instruction
+struct Frame {
+    // One for every local variable, up to max_locals
+    Vector<Type> locals;
+
+    // One for every value, from the bottom of the stack to the top
+    Vector<Type> stack;
+
+    // The number of slots that the values on the stack take up, which can't be more than max_stack
+    size_t stack_size { 0 };
+
+    // flagThisUninit: an instance initialization method hasn't called another instance initialization method on `this` yet
+    bool this_uninitialized { false };
+};
+
+struct MethodType {
+    Vector<Type> parameters;
+
+    // Empty if the method returns void
+    Optional<Type> return_type;
+};
+
+struct NameAndType {
+    Symbol name;
+    Symbol descriptor;
+};
+
+struct MemberReference {
+    Symbol class_name;
+    Symbol name;
+    Symbol descriptor;
+};
+
+}
+
+// The constant pool's accessors assume that the index is valid, and that the constant has the right type, so the verifier has to check that first
+static bool has_tag(Parser::ConstantPool const& constant_pool, u16 index, Constant::Tag tag)
+{
+    return constant_pool.is_valid_index(index) && constant_pool.tag_at(index) == tag;
+}
+
+static ErrorOr<Symbol> utf8_at(Parser::ConstantPool const& constant_pool, u16 index)
+{
+    if (!has_tag(constant_pool, index, Constant::Tag::UTF8))
+        return Error::from_string_literal("Expected a CONSTANT_Utf8_info");
+
+    return TRY(constant_pool.utf8_at(index)).symbol();
+}
+
+// Returns the binary name of the CONSTANT_Class_info at the index, or its descriptor if it's an array class
+static ErrorOr<Symbol> class_name_at(Parser::ConstantPool const& constant_pool, u16 index)
+{
+    if (!has_tag(constant_pool, index, Constant::Tag::Class))
+        return Error::from_string_literal("Expected a CONSTANT_Class_info");
+
+    auto class_info = TRY(constant_pool.class_at(index));
+    return utf8_at(constant_pool, class_info.name_index());
+}
+
+static ErrorOr<NameAndType> name_and_type_at(Parser::ConstantPool const& constant_pool, u16 index)
+{
+    if (!has_tag(constant_pool, index, Constant::Tag::NameAndType))
+        return Error::from_string_literal("Expected a CONSTANT_NameAndType_info");
+
+    auto name_and_type = TRY(constant_pool.name_and_type_at(index));
+    return NameAndType {
+        .name = TRY(utf8_at(constant_pool, name_and_type.name_index())),
+        .descriptor = TRY(utf8_at(constant_pool, name_and_type.descriptor_index())),
+    };
+}
+
+static ErrorOr<MemberReference> member_reference_at(Parser::ConstantPool const& constant_pool, u16 index)
+{
+    if (!constant_pool.is_valid_index(index))
+        return Error::from_string_literal("Expected a reference to a field or a method");
+
+    Parser::ConstantMemberReferenceInfo reference = TRY([&]() -> ErrorOr<Parser::ConstantMemberReferenceInfo> {
+        switch (constant_pool.tag_at(index)) {
+        case Constant::Tag::FieldReference:
+            return constant_pool.field_reference_at(index);
+        case Constant::Tag::MethodReference:
+            return constant_pool.method_reference_at(index);
+        case Constant::Tag::InterfaceMethodReference:
+            return constant_pool.interface_method_reference_at(index);
+        default:
+            return Error::from_string_literal("Expected a reference to a field or a method");
+        }
+    }());
+
+    auto name_and_type = TRY(name_and_type_at(constant_pool, reference.name_and_type_index()));
+    return MemberReference {
+        .class_name = TRY(class_name_at(constant_pool, reference.class_index())),
+        .name = name_and_type.name,
+        .descriptor = name_and_type.descriptor,
+    };
+}
+
+// Parses the field descriptor at the start of `descriptor`, and removes it from the view
+static ErrorOr<Type> parse_field_type(StringView& descriptor)
+{
+    size_t dimensions = 0;
+    while (dimensions < descriptor.length() && descriptor[dimensions] == FieldDescriptor::ArrayDimension)
+        dimensions++;
+
+    // An array type descriptor is valid only if it represents 255 or fewer dimensions
+    if (dimensions == descriptor.length() || dimensions > 255)
+        return Error::from_string_literal("Malformed field descriptor");
+
+    size_t length = dimensions + 1;
+    switch (descriptor[dimensions]) {
+    case FieldDescriptor::Byte:
+    case FieldDescriptor::Char:
+    case FieldDescriptor::Double:
+    case FieldDescriptor::Float:
+    case FieldDescriptor::Int:
+    case FieldDescriptor::Long:
+    case FieldDescriptor::Short:
+    case FieldDescriptor::Boolean:
+        break;
+    case FieldDescriptor::ReferenceStart: {
+        auto end = descriptor.find(FieldDescriptor::ReferenceEnd, dimensions);
+        if (!end.has_value() || *end == dimensions + 1)
+            return Error::from_string_literal("Malformed field descriptor");
+
+        length = *end + 1;
+        break;
+    }
+    default:
+        return Error::from_string_literal("Malformed field descriptor");
+    }
+
+    auto field_descriptor = descriptor.substring_view(0, length);
+    descriptor = descriptor.substring_view(length);
+
+    if (dimensions > 0)
+        return Type::reference(TRY(Symbol::intern(field_descriptor)));
+
+    // Booleans, bytes, chars and shorts are all ints as far as the verifier is concerned
+    switch (field_descriptor[0]) {
+    case FieldDescriptor::Float:
+        return Type::float_();
+    case FieldDescriptor::Long:
+        return Type::long_();
+    case FieldDescriptor::Double:
+        return Type::double_();
+    case FieldDescriptor::ReferenceStart:
+        return Type::reference(TRY(Symbol::intern(field_descriptor.substring_view(1, length - 2))));
+    default:
+        return Type::integer();
+    }
+}
+
+static ErrorOr<Type> parse_field_descriptor(StringView descriptor)
+{
+    auto type = TRY(parse_field_type(descriptor));
+    if (!descriptor.is_empty())
+        return Error::from_string_literal("Malformed field descriptor");
+
+    return type;
+}
+
+static ErrorOr<MethodType> parse_method_type(StringView descriptor)
+{
+    if (!descriptor.starts_with(MethodDescriptor::ParametersStart))
+        return Error::from_string_literal("Malformed method descriptor");
+
+    MethodType method_type;
+    descriptor = descriptor.substring_view(1);
+    while (!descriptor.starts_with(MethodDescriptor::ParametersEnd)) {
+        if (descriptor.is_empty())
+            return Error::from_string_literal("Malformed method descriptor");
+
+        TRY(method_type.parameters.try_append(TRY(parse_field_type(descriptor))));
+    }
+
+    descriptor = descriptor.substring_view(1);
+    if (descriptor == "V"sv)
+        return method_type;
+
+    method_type.return_type = TRY(parse_field_descriptor(descriptor));
+    return method_type;
+}
+
+// The kinds of values that the typed instructions operate on, in the order that their opcodes are in (e.g. iload, lload, fload, dload, aload)
+static Type type_for_kind(u8 kind)
+{
+    switch (kind) {
+    case 0:
+        return Type::integer();
+    case 1:
+        return Type::long_();
+    case 2:
+        return Type::float_();
+    case 3:
+        return Type::double_();
+    default:
+        // Any reference, load and store only check that it is one
+        return Type::reference({});
+    }
+}
+
+namespace {
+
+// Checks a single method, see Verifier
+class MethodVerifier {
+public:
+    MethodVerifier(Verifier const& verifier, Parser::MethodInfo const& method_info, Parser::CodeAttribute& code_attribute, Symbol name, Symbol descriptor)
+        : m_verifier(verifier)
+        , m_constant_pool(verifier.constant_pool())
+        , m_method_info(method_info)
+        , m_code_attribute(code_attribute)
+        , m_code(code_attribute.code())
+        , m_max_locals(code_attribute.max_locals())
+        , m_max_stack(code_attribute.max_stack())
+        , m_name(name)
+        , m_descriptor(descriptor)
+    {
+    }
+
+    ErrorOr<void> verify();
+
+    // The offset of the instruction that was being checked when verification failed
+    size_t offset() const { return m_offset; };
+
+private:
+    static constexpr u32 no_frame = NumericLimits<u32>::max();
+
+    struct ExceptionHandler {
+        u16 start_pc;
+        u16 end_pc;
+        u32 frame_index;
+
+        // java/lang/Throwable for a handler that catches every exception
+        Type catch_type;
+    };
+
+    ErrorOr<void> find_instructions();
+    ErrorOr<size_t> instruction_length_at(size_t offset) const;
+    ErrorOr<Vector<Type>> initial_locals();
+    ErrorOr<void> read_stack_map(Vector<Type> const& initial_locals);
+    ErrorOr<Type> type_from_stack_map(StackMapTableAttribute::VerificationType const&) const;
+    ErrorOr<Vector<Type>> expand_locals(Vector<Type> const& locals) const;
+    ErrorOr<void> read_exception_handlers();
+
+    // Returns whether execution can fall through to the next instruction
+    ErrorOr<bool> check_instruction(size_t offset);
+    ErrorOr<void> check_exception_handlers(size_t offset);
+    ErrorOr<void> check_load_constant(u16 index, bool category_2);
+    ErrorOr<void> check_field_access(Opcode, u16 index);
+    ErrorOr<void> check_invocation(Opcode, size_t offset);
+    ErrorOr<void> check_return(Opcode);
+    ErrorOr<void> initialize_object(Symbol method_class_name);
+
+    ErrorOr<bool> is_assignable(Type const& from, Type const& to) const;
+    ErrorOr<bool> is_frame_assignable(Frame const& from, Frame const& to) const;
+
+    // The target of a branch has to have a stack map frame, which the current frame is assignable to
+    ErrorOr<void> branch_to(size_t offset, i64 relative_offset);
+
+    ErrorOr<void> push(Type const&);
+    ErrorOr<Type> pop();
+    ErrorOr<void> pop(Type const& expected);
+    ErrorOr<Type> pop_reference();
+    ErrorOr<Type> pop_initialized_reference();
+
+    // Pops values that take up exactly `slot_count` slots, for the instructions that don't care about the types of the values that they move around
+    ErrorOr<Vector<Type>> pop_slots(size_t slot_count);
+    ErrorOr<void> push_all(Vector<Type> const&);
+
+    // Pops an array reference, which is either null, or an array with a component of one of the descriptors
+    ErrorOr<Type> pop_array(StringView component_descriptors);
+
+    // Returns the type of a local variable, which has to be assignable to the expected type
+    ErrorOr<Type> local(u16 index, Type const& expected) const;
+    ErrorOr<void> store(u16 index, Type const&);
+
+    // The load and store instructions that only differ by their type, see type_for_kind()
+    ErrorOr<void> load_to_stack(u16 index, u8 kind);
+    ErrorOr<void> store_from_stack(u16 index, u8 kind);
+
+    u8 read_u1(size_t offset) const { return m_code[offset]; };
+    u16 read_u2(size_t offset) const { return (static_cast<u16>(m_code[offset]) << 8) | m_code[offset + 1]; };
+    i32 read_i4(size_t offset) const { return static_cast<i32>((static_cast<u32>(m_code[offset]) << 24) | (static_cast<u32>(m_code[offset + 1]) << 16) | (static_cast<u32>(m_code[offset + 2]) << 8) | m_code[offset + 3]); };
+
+    Verifier const& m_verifier;
+    Parser::ConstantPool const& m_constant_pool;
+    Parser::MethodInfo const& m_method_info;
+    Parser::CodeAttribute& m_code_attribute;
+    ReadonlyBytes m_code;
+    u16 m_max_locals;
+    u16 m_max_stack;
+    Symbol m_name;
+    Symbol m_descriptor;
+    MethodType m_method_type;
+
+    // Indexed by offset into the code
+    Vector<bool> m_instruction_starts;
+    Vector<u32> m_frame_indices;
+
+    Vector<Frame> m_stack_map;
+    Vector<ExceptionHandler> m_exception_handlers;
+
+    Frame m_frame;
+    size_t m_offset { 0 };
+};
+
+}
+
+ErrorOr<void> MethodVerifier::verify()
+{
+    m_method_type = TRY(parse_method_type(m_descriptor.view()));
+
+    // The value of the code_length item must be greater than zero
+    if (m_code.is_empty())
+        return Error::from_string_literal("The method's code is empty");
+
+    TRY(find_instructions());
+
+    auto locals = TRY(initial_locals());
+    TRY(read_stack_map(locals));
+    TRY(read_exception_handlers());
+
+    m_frame.locals = TRY(expand_locals(locals));
+    for (auto const& local : m_frame.locals) {
+        if (local.kind == Type::Kind::UninitializedThis)
+            m_frame.this_uninitialized = true;
+    }
+
+    // Instructions are checked in order, the types that an instruction leaves behind are what the next one starts with, unless there's a stack map frame in between
+    auto falls_through = true;
+    for (size_t offset = 0; offset < m_code.size();) {
+        m_offset = offset;
+        auto length = TRY(instruction_length_at(offset));
+
+        auto frame_index = m_frame_indices[offset];
+        if (frame_index != no_frame) {
+            if (falls_through && !TRY(is_frame_assignable(m_frame, m_stack_map[frame_index])))
+                return Error::from_string_literal("The current frame isn't assignable to the stack map frame");
+
+            m_frame = m_stack_map[frame_index];
+        } else if (!falls_through) {
+            return Error::from_string_literal("The instruction after an unconditional branch doesn't have a stack map frame");
+        }
+
+        TRY(check_exception_handlers(offset));
+        falls_through = TRY(check_instruction(offset));
+        offset += length;
+    }
+
+    if (falls_through)
+        return Error::from_string_literal("Execution can fall off the end of the code");
+
+    return {};
+}
+
+ErrorOr<void> MethodVerifier::find_instructions()
+{
+    TRY(m_instruction_starts.try_resize(m_code.size()));
+    for (size_t offset = 0; offset < m_code.size();) {
+        m_offset = offset;
+        m_instruction_starts[offset] = true;
+
+        auto length = TRY(instruction_length_at(offset));
+        if (offset + length > m_code.size())
+            return Error::from_string_literal("The last instruction is truncated");
+
+        offset += length;
+    }
+
+    return {};
+}
+
+ErrorOr<size_t> MethodVerifier::instruction_length_at(size_t offset) const
+{
+    // The quick opcodes are only ever written by the interpreter, they aren't valid in a class file
+    if (m_code[offset] >= Interpreter::opcode_count)
+        return Error::from_string_literal("Unknown opcode");
+
+    auto opcode = static_cast<Opcode>(m_code[offset]);
+    switch (opcode) {
+    case Opcode::Tableswitch: {
+        // The operands start at the next multiple of 4 bytes from the start of the code, after 0 to 3 bytes of padding
+        auto operands = align_up_to(offset + 1, 4);
+        if (operands + 12 > m_code.size())
+            return Error::from_string_literal("The last instruction is truncated");
+
+        auto low = read_i4(operands + 4);
+        auto high = read_i4(operands + 8);
+        if (low > high)
+            return Error::from_string_literal("A tableswitch's low is greater than its high");
+
+        return operands + 12 + static_cast<size_t>(static_cast<i64>(high) - low + 1) * 4 - offset;
+    }
+
+    case Opcode::Lookupswitch: {
+        auto operands = align_up_to(offset + 1, 4);
+        if (operands + 8 > m_code.size())
+            return Error::from_string_literal("The last instruction is truncated");
+
+        auto pair_count = read_i4(operands + 4);
+        if (pair_count < 0)
+            return Error::from_string_literal("A lookupswitch has a negative number of pairs");
+
+        return operands + 8 + static_cast<size_t>(pair_count) * 8 - offset;
+    }
+
+    case Opcode::Wide:
+        if (offset + 1 >= m_code.size())
+            return Error::from_string_literal("The last instruction is truncated");
+
+        // iinc has a second, two byte operand when it is modified by wide
+        return static_cast<Opcode>(m_code[offset + 1]) == Opcode::Iinc ? 6 : 4;
+
+    default:
+        return Interpreter::opcode_length(opcode);
+    }
+}
+
+// The locals of the initial frame are given by the method's descriptor, as a list of types where a long or a double is a single entry (like in the StackMapTable)
+ErrorOr<Vector<Type>> MethodVerifier::initial_locals()
+{
+    auto const& symbols = WellKnownSymbols::the();
+
+    Vector<Type> locals;
+    if (!(m_method_info.access_flags & Access::Static)) {
+        // `this` isn't initialized in an instance initialization method until it calls another one, apart from in java/lang/Object
+        if (m_name == symbols.init && m_verifier.class_name() != symbols.java_lang_Object)
+            TRY(locals.try_append(Type::uninitialized_this()));
+        else
+            TRY(locals.try_append(Type::reference(m_verifier.class_name())));
+    }
+
+    TRY(locals.try_extend(m_method_type.parameters));
+    return locals;
+}
+
+ErrorOr<Vector<Type>> MethodVerifier::expand_locals(Vector<Type> const& locals) const
+{
+    Vector<Type> expanded;
+    for (auto const& local : locals) {
+        TRY(expanded.try_append(local));
+        if (local.is_category_2())
+            TRY(expanded.try_append(Type::top()));
+    }
+
+    if (expanded.size() > m_max_locals)
+        return Error::from_string_literal("The local variables don't fit in max_locals");
+
+    // Every local variable that isn't given is unusable
+    TRY(expanded.try_resize(m_max_locals));
+    return expanded;
+}
+
+ErrorOr<Type> MethodVerifier::type_from_stack_map(StackMapTableAttribute::VerificationType const& type) const
+{
+    using Tag = StackMapTableAttribute::VerificationType::Tag;
+    switch (type.tag) {
+    case Tag::Top:
+        return Type::top();
+    case Tag::Integer:
+        return Type::integer();
+    case Tag::Float:
+        return Type::float_();
+    case Tag::Double:
+        return Type::double_();
+    case Tag::Long:
+        return Type::long_();
+    case Tag::Null:
+        return Type::null();
+    case Tag::UninitializedThis:
+        return Type::uninitialized_this();
+    case Tag::Object:
+        return Type::reference(TRY(class_name_at(m_constant_pool, type.data)));
+    case Tag::Uninitialized:
+        // The offset must be that of the new instruction which created the object
+        if (type.data >= m_code.size() || !m_instruction_starts[type.data] || m_code[type.data] != to_underlying(Opcode::New))
+            return Error::from_string_literal("An uninitialized type in the StackMapTable doesn't refer to a new instruction");
+
+        return Type::uninitialized(type.data);
+    }
+
+    VERIFY_NOT_REACHED();
+}
+
+ErrorOr<void> MethodVerifier::read_stack_map(Vector<Type> const& initial_locals)
+{
+    TRY(m_frame_indices.try_resize(m_code.size()));
+    for (auto& frame_index : m_frame_indices)
+        frame_index = no_frame;
+
+    auto stack_map_table = TRY(m_code_attribute.stack_map_table());
+    if (!stack_map_table)
+        return {};
+
+    // Each frame only gives the difference from the frame before it, the first one is relative to the initial frame
+    auto locals = initial_locals;
+    size_t offset = 0;
+    auto entries = TRY(stack_map_table->frames());
+    for (size_t i = 0; i < entries.size(); i++) {
+        auto const& entry = entries[i];
+        offset = i == 0 ? entry.offset_delta : offset + entry.offset_delta + 1;
+        m_offset = offset;
+
+        if (offset >= m_code.size() || !m_instruction_starts[offset])
+            return Error::from_string_literal("A stack map frame isn't at the start of an instruction");
+
+        Frame frame;
+        switch (entry.kind) {
+        case StackMapTableAttribute::Frame::Kind::Same:
+        case StackMapTableAttribute::Frame::Kind::SameLocals1StackItem:
+            break;
+        case StackMapTableAttribute::Frame::Kind::Chop:
+            if (entry.chopped_local_count > locals.size())
+                return Error::from_string_literal("A chop frame removes more locals than there are");
+
+            locals.shrink(locals.size() - entry.chopped_local_count);
+            break;
+        case StackMapTableAttribute::Frame::Kind::Append:
+            for (auto const& local : entry.locals)
+                TRY(locals.try_append(TRY(type_from_stack_map(local))));
+            break;
+        case StackMapTableAttribute::Frame::Kind::Full:
+            locals.clear();
+            for (auto const& local : entry.locals)
+                TRY(locals.try_append(TRY(type_from_stack_map(local))));
+            break;
+        }
+
+        for (auto const& value : entry.stack) {
+            auto type = TRY(type_from_stack_map(value));
+            frame.stack_size += type.slot_count();
+            TRY(frame.stack.try_append(type));
+        }
+
+        if (frame.stack_size > m_max_stack)
+            return Error::from_string_literal("The operand stack of a stack map frame doesn't fit in max_stack");
+
+        frame.locals = TRY(expand_locals(locals));
+        for (auto const& local : frame.locals) {
+            if (local.kind == Type::Kind::UninitializedThis)
+                frame.this_uninitialized = true;
+        }
+
+        m_frame_indices[offset] = m_stack_map.size();
+        TRY(m_stack_map.try_append(move(frame)));
+    }
+
+    return {};
+}
+
+ErrorOr<void> MethodVerifier::read_exception_handlers()
+{
+    auto const& symbols = WellKnownSymbols::the();
+    auto throwable = Type::reference(symbols.java_lang_Throwable);
+
+    for (auto const& handler : TRY(m_code_attribute.exception_table())) {
+        m_offset = handler.handler_pc;
+
+        // The end of the range is exclusive, it's either the start of an instruction or the end of the code
+        auto is_instruction_boundary = [&](u16 offset) { return offset == m_code.size() || (offset < m_code.size() && m_instruction_starts[offset]); };
+        if (handler.start_pc >= handler.end_pc || !is_instruction_boundary(handler.start_pc) || !is_instruction_boundary(handler.end_pc))
+            return Error::from_string_literal("An exception handler covers an invalid range of instructions");
+
+        // The handler is the target of a branch, so it has to have a stack map frame
+        if (handler.handler_pc >= m_code.size() || m_frame_indices[handler.handler_pc] == no_frame)
+            return Error::from_string_literal("An exception handler doesn't have a stack map frame");
+
+        auto catch_type = throwable;
+        if (handler.catch_type != 0) {
+            catch_type = Type::reference(TRY(class_name_at(m_constant_pool, handler.catch_type)));
+            if (!TRY(is_assignable(catch_type, throwable)))
+                return Error::from_string_literal("An exception handler's catch type isn't a subclass of java/lang/Throwable");
+        }
+
+        TRY(m_exception_handlers.try_append(ExceptionHandler {
+            .start_pc = handler.start_pc,
+            .end_pc = handler.end_pc,
+            .frame_index = m_frame_indices[handler.handler_pc],
+            .catch_type = catch_type,
+        }));
+    }
+
+    return {};
+}
+
+// If an instruction can throw an exception, its handlers have to accept the locals that it starts with, and an operand stack with just the exception on it.
+// Like in the JVMS, every instruction is treated as if it can throw.
+ErrorOr<void> MethodVerifier::check_exception_handlers(size_t offset)
+{
+    for (auto const& handler : m_exception_handlers) {
+        if (offset < handler.start_pc || offset >= handler.end_pc)
+            continue;
+
+        auto const& target = m_stack_map[handler.frame_index];
+        if (m_frame.this_uninitialized && !target.this_uninitialized)
+            return Error::from_string_literal("The current frame isn't assignable to an exception handler's frame");
+
+        for (size_t i = 0; i < m_frame.locals.size(); i++) {
+            if (!TRY(is_assignable(m_frame.locals[i], target.locals[i])))
+                return Error::from_string_literal("The current frame isn't assignable to an exception handler's frame");
+        }
+
+        if (target.stack.size() != 1 || !TRY(is_assignable(handler.catch_type, target.stack[0])))
+            return Error::from_string_literal("An exception handler's frame doesn't expect just the exception on the operand stack");
+    }
+
+    return {};
+}
+
+ErrorOr<bool> MethodVerifier::is_assignable(Type const& from, Type const& to) const
+{
+    if (from == to || to.kind == Type::Kind::Top)
+        return true;
+
+    if (to.kind != Type::Kind::Reference)
+        return false;
+
+    if (from.kind == Type::Kind::Null)
+        return true;
+
+    if (from.kind != Type::Kind::Reference)
+        return false;
+
+    return m_verifier.is_assignable(from.class_name, to.class_name);
+}
+
+ErrorOr<bool> MethodVerifier::is_frame_assignable(Frame const& from, Frame const& to) const
+{
+    if (from.this_uninitialized && !to.this_uninitialized)
+        return false;
+
+    // Both frames have max_locals local variables
+    for (size_t i = 0; i < from.locals.size(); i++) {
+        if (!TRY(is_assignable(from.locals[i], to.locals[i])))
+            return false;
+    }
+
+    if (from.stack.size() != to.stack.size())
+        return false;
+
+    for (size_t i = 0; i < from.stack.size(); i++) {
+        if (!TRY(is_assignable(from.stack[i], to.stack[i])))
+            return false;
+    }
+
+    return true;
+}
+
+ErrorOr<void> MethodVerifier::branch_to(size_t offset, i64 relative_offset)
+{
+    auto target = static_cast<i64>(offset) + relative_offset;
+    if (target < 0 || target >= static_cast<i64>(m_code.size()) || !m_instruction_starts[target])
+        return Error::from_string_literal("A branch target isn't the start of an instruction");
+
+    auto frame_index = m_frame_indices[target];
+    if (frame_index == no_frame)
+        return Error::from_string_literal("A branch target doesn't have a stack map frame");
+
+    if (!TRY(is_frame_assignable(m_frame, m_stack_map[frame_index])))
+        return Error::from_string_literal("The current frame isn't assignable to a branch target's frame");
+
+    return {};
+}
+
+ErrorOr<void> MethodVerifier::push(Type const& type)
+{
+    if (m_frame.stack_size + type.slot_count() > m_max_stack)
+        return Error::from_string_literal("The operand stack overflows max_stack");
+
+    TRY(m_frame.stack.try_append(type));
+    m_frame.stack_size += type.slot_count();
+    return {};
+}
+
+ErrorOr<Type> MethodVerifier::pop()
+{
+    if (m_frame.stack.is_empty())
+        return Error::from_string_literal("The operand stack underflows");
+
+    auto type = m_frame.stack.take_last();
+    m_frame.stack_size -= type.slot_count();
+    return type;
+}
+
+ErrorOr<void> MethodVerifier::pop(Type const& expected)
+{
+    auto type = TRY(pop());
+    if (!TRY(is_assignable(type, expected)))
+        return Error::from_string_literal("A value on the operand stack has the wrong type");
+
+    return {};
+}
+
+ErrorOr<Type> MethodVerifier::pop_reference()
+{
+    auto type = TRY(pop());
+    if (!type.is_reference())
+        return Error::from_string_literal("Expected a reference on the operand stack");
+
+    return type;
+}
+
+ErrorOr<Type> MethodVerifier::pop_initialized_reference()
+{
+    auto type = TRY(pop());
+    if (!type.is_initialized_reference())
+        return Error::from_string_literal("Expected an initialized reference on the operand stack");
+
+    return type;
+}
+
+ErrorOr<Vector<Type>> MethodVerifier::pop_slots(size_t slot_count)
+{
+    Vector<Type> values;
+    size_t popped_slot_count = 0;
+    while (popped_slot_count < slot_count) {
+        auto type = TRY(pop());
+        popped_slot_count += type.slot_count();
+        TRY(values.try_insert(0, type));
+    }
+
+    // A long or a double can't be split in half
+    if (popped_slot_count != slot_count)
+        return Error::from_string_literal("A stack manipulation instruction splits a long or a double");
+
+    return values;
+}
+
+ErrorOr<void> MethodVerifier::push_all(Vector<Type> const& values)
+{
+    for (auto const& value : values)
+        TRY(push(value));
+
+    return {};
+}
+
+ErrorOr<Type> MethodVerifier::pop_array(StringView component_descriptors)
+{
+    auto array = TRY(pop());
+    if (array.kind == Type::Kind::Null)
+        return array;
+
+    if (!array.is_array())
+        return Error::from_string_literal("Expected an array on the operand stack");
+
+    auto component = array.class_name.view()[1];
+    for (auto descriptor : component_descriptors) {
+        if (component == descriptor)
+            return array;
+    }
+
+    return Error::from_string_literal("An array on the operand stack has the wrong component type");
+}
+
+ErrorOr<Type> MethodVerifier::local(u16 index, Type const& expected) const
+{
+    if (index + expected.slot_count() > m_max_locals)
+        return Error::from_string_literal("A local variable index is out of bounds");
+
+    auto const& type = m_frame.locals[index];
+    if (expected.kind == Type::Kind::Reference) {
+        // aload can load any reference, including one that hasn't been initialized yet
+        if (!type.is_reference())
+            return Error::from_string_literal("Expected a reference in a local variable");
+
+        return type;
+    }
+
+    if (type != expected)
+        return Error::from_string_literal("A local variable has the wrong type");
+
+    return type;
+}
+
+ErrorOr<void> MethodVerifier::store(u16 index, Type const& type)
+{
+    if (index + type.slot_count() > m_max_locals)
+        return Error::from_string_literal("A local variable index is out of bounds");
+
+    // Overwriting either half of a long or a double makes the other half unusable
+    if (index > 0 && m_frame.locals[index - 1].is_category_2())
+        m_frame.locals[index - 1] = Type::top();
+
+    m_frame.locals[index] = type;
+    if (type.is_category_2())
+        m_frame.locals[index + 1] = Type::top();
+
+    return {};
+}
+
+ErrorOr<void> MethodVerifier::load_to_stack(u16 index, u8 kind)
+{
+    return push(TRY(local(index, type_for_kind(kind))));
+}
+
+ErrorOr<void> MethodVerifier::store_from_stack(u16 index, u8 kind)
+{
+    // astore can store any reference, including one that hasn't been initialized yet
+    if (kind == 4)
+        return store(index, TRY(pop_reference()));
+
+    auto type = type_for_kind(kind);
+    TRY(pop(type));
+    return store(index, type);
+}
+
+ErrorOr<bool> MethodVerifier::check_instruction(size_t offset)
+{
+    auto const& symbols = WellKnownSymbols::the();
+    auto opcode = static_cast<Opcode>(m_code[offset]);
+    auto value = m_code[offset];
+
+    // The families of instructions that only differ by the type of value that they work with
+    if (value >= to_underlying(Opcode::Iload0) && value <= to_underlying(Opcode::Aload3)) {
+        auto index = value - to_underlying(Opcode::Iload0);
+        TRY(load_to_stack(index % 4, index / 4));
+        return true;
+    }
+
+    if (value >= to_underlying(Opcode::Istore0) && value <= to_underlying(Opcode::Astore3)) {
+        auto index = value - to_underlying(Opcode::Istore0);
+        TRY(store_from_stack(index % 4, index / 4));
+        return true;
+    }
+
+    if (value >= to_underlying(Opcode::Iadd) && value <= to_underlying(Opcode::Drem)) {
+        auto type = type_for_kind((value - to_underlying(Opcode::Iadd)) % 4);
+        TRY(pop(type));
+        TRY(pop(type));
+        TRY(push(type));
+        return true;
+    }
+
+    if (value >= to_underlying(Opcode::Ineg) && value <= to_underlying(Opcode::Dneg)) {
+        auto type = type_for_kind(value - to_underlying(Opcode::Ineg));
+        TRY(pop(type));
+        TRY(push(type));
+        return true;
+    }
+
+    // The shifts and the bitwise operations alternate between int and long, the shift distance is always an int
+    if (value >= to_underlying(Opcode::Ishl) && value <= to_underlying(Opcode::Lxor)) {
+        auto type = type_for_kind((value - to_underlying(Opcode::Ishl)) % 2);
+        TRY(pop(value <= to_underlying(Opcode::Lushr) ? Type::integer() : type));
+        TRY(pop(type));
+        TRY(push(type));
+        return true;
+    }
+
+    if (value >= to_underlying(Opcode::Ifeq) && value <= to_underlying(Opcode::Ifle)) {
+        TRY(pop(Type::integer()));
+        TRY(branch_to(offset, static_cast<i16>(read_u2(offset + 1))));
+        return true;
+    }
+
+    if (value >= to_underlying(Opcode::IfIcmpeq) && value <= to_underlying(Opcode::IfIcmple)) {
+        TRY(pop(Type::integer()));
+        TRY(pop(Type::integer()));
+        TRY(branch_to(offset, static_cast<i16>(read_u2(offset + 1))));
+        return true;
+    }
+
+    switch (opcode) {
+    case Opcode::Nop:
+        return true;
+
+    case Opcode::AconstNull:
+        TRY(push(Type::null()));
+        return true;
+
+    case Opcode::IconstM1:
+    case Opcode::Iconst0:
+    case Opcode::Iconst1:
+    case Opcode::Iconst2:
+    case Opcode::Iconst3:
+    case Opcode::Iconst4:
+    case Opcode::Iconst5:
+    case Opcode::Bipush:
+    case Opcode::Sipush:
+        TRY(push(Type::integer()));
+        return true;
+
+    case Opcode::Lconst0:
+    case Opcode::Lconst1:
+        TRY(push(Type::long_()));
+        return true;
+
+    case Opcode::Fconst0:
+    case Opcode::Fconst1:
+    case Opcode::Fconst2:
+        TRY(push(Type::float_()));
+        return true;
+
+    case Opcode::Dconst0:
+    case Opcode::Dconst1:
+        TRY(push(Type::double_()));
+        return true;
+
+    case Opcode::Ldc:
+        TRY(check_load_constant(read_u1(offset + 1), false));
+        return true;
+
+    case Opcode::LdcW:
+        TRY(check_load_constant(read_u2(offset + 1), false));
+        return true;
+
+    case Opcode::Ldc2W:
+        TRY(check_load_constant(read_u2(offset + 1), true));
+        return true;
+
+    case Opcode::Iload:
+    case Opcode::Lload:
+    case Opcode::Fload:
+    case Opcode::Dload:
+    case Opcode::Aload:
+        TRY(load_to_stack(read_u1(offset + 1), value - to_underlying(Opcode::Iload)));
+        return true;
+
+    case Opcode::Istore:
+    case Opcode::Lstore:
+    case Opcode::Fstore:
+    case Opcode::Dstore:
+    case Opcode::Astore:
+        TRY(store_from_stack(read_u1(offset + 1), value - to_underlying(Opcode::Istore)));
+        return true;
+
+    case Opcode::Iaload:
+    case Opcode::Baload:
+    case Opcode::Caload:
+    case Opcode::Saload:
+    case Opcode::Laload:
+    case Opcode::Faload:
+    case Opcode::Daload: {
+        TRY(pop(Type::integer()));
+        switch (opcode) {
+        case Opcode::Iaload:
+            TRY(pop_array("I"sv));
+            TRY(push(Type::integer()));
+            break;
+        case Opcode::Baload:
+            TRY(pop_array("BZ"sv));
+            TRY(push(Type::integer()));
+            break;
+        case Opcode::Caload:
+            TRY(pop_array("C"sv));
+            TRY(push(Type::integer()));
+            break;
+        case Opcode::Saload:
+            TRY(pop_array("S"sv));
+            TRY(push(Type::integer()));
+            break;
+        case Opcode::Laload:
+            TRY(pop_array("J"sv));
+            TRY(push(Type::long_()));
+            break;
+        case Opcode::Faload:
+            TRY(pop_array("F"sv));
+            TRY(push(Type::float_()));
+            break;
+        default:
+            TRY(pop_array("D"sv));
+            TRY(push(Type::double_()));
+            break;
+        }
+
+        return true;
+    }
+
+    case Opcode::Aaload: {
+        TRY(pop(Type::integer()));
+        auto array = TRY(pop_array("L["sv));
+        if (array.kind == Type::Kind::Null) {
+            TRY(push(Type::null()));
+            return true;
+        }
+
+        StringView component = array.class_name.view().substring_view(1);
+        TRY(push(TRY(parse_field_descriptor(component))));
+        return true;
+    }
+
+    case Opcode::Iastore:
+        TRY(pop(Type::integer()));
+        TRY(pop(Type::integer()));
+        TRY(pop_array("I"sv));
+        return true;
+
+    case Opcode::Bastore:
+        TRY(pop(Type::integer()));
+        TRY(pop(Type::integer()));
+        TRY(pop_array("BZ"sv));
+        return true;
+
+    case Opcode::Castore:
+        TRY(pop(Type::integer()));
+        TRY(pop(Type::integer()));
+        TRY(pop_array("C"sv));
+        return true;
+
+    case Opcode::Sastore:
+        TRY(pop(Type::integer()));
+        TRY(pop(Type::integer()));
+        TRY(pop_array("S"sv));
+        return true;
+
+    case Opcode::Lastore:
+        TRY(pop(Type::long_()));
+        TRY(pop(Type::integer()));
+        TRY(pop_array("J"sv));
+        return true;
+
+    case Opcode::Fastore:
+        TRY(pop(Type::float_()));
+        TRY(pop(Type::integer()));
+        TRY(pop_array("F"sv));
+        return true;
+
+    case Opcode::Dastore:
+        TRY(pop(Type::double_()));
+        TRY(pop(Type::integer()));
+        TRY(pop_array("D"sv));
+        return true;
+
+    case Opcode::Aastore:
+        // Whether the value can be stored in the array is only known at run time, which throws an ArrayStoreException if it can't
+        TRY(pop_initialized_reference());
+        TRY(pop(Type::integer()));
+        TRY(pop_array("L["sv));
+        return true;
+
+    case Opcode::Pop:
+        TRY(pop_slots(1));
+        return true;
+
+    case Opcode::Pop2:
+        TRY(pop_slots(2));
+        return true;
+
+    case Opcode::Dup: {
+        auto values = TRY(pop_slots(1));
+        TRY(push_all(values));
+        TRY(push_all(values));
+        return true;
+    }
+
+    case Opcode::DupX1:
+    case Opcode::DupX2:
+    case Opcode::Dup2:
+    case Opcode::Dup2X1:
+    case Opcode::Dup2X2: {
+        // The values at the top of the stack are copied below the values underneath them
+        auto copied_slot_count = opcode == Opcode::DupX1 || opcode == Opcode::DupX2 ? 1 : 2;
+        size_t skipped_slot_count = 2;
+        if (opcode == Opcode::Dup2)
+            skipped_slot_count = 0;
+        else if (opcode == Opcode::DupX1 || opcode == Opcode::Dup2X1)
+            skipped_slot_count = 1;
+
+        auto copied = TRY(pop_slots(copied_slot_count));
+        auto skipped = TRY(pop_slots(skipped_slot_count));
+        TRY(push_all(copied));
+        TRY(push_all(skipped));
+        TRY(push_all(copied));
+        return true;
+    }
+
+    case Opcode::Swap: {
+        auto first = TRY(pop_slots(1));
+        auto second = TRY(pop_slots(1));
+        TRY(push_all(first));
+        TRY(push_all(second));
+        return true;
+    }
+
+    case Opcode::Iinc:
+        TRY(local(read_u1(offset + 1), Type::integer()));
+        return true;
+
+    case Opcode::I2l:
+    case Opcode::I2f:
+    case Opcode::I2d:
+    case Opcode::L2i:
+    case Opcode::L2f:
+    case Opcode::L2d:
+    case Opcode::F2i:
+    case Opcode::F2l:
+    case Opcode::F2d:
+    case Opcode::D2i:
+    case Opcode::D2l:
+    case Opcode::D2f: {
+        // Each of int, long, float and double is converted to the other three, in that order
+        auto index = value - to_underlying(Opcode::I2l);
+        auto from = index / 3;
+        auto to = index % 3 >= from ? index % 3 + 1 : index % 3;
+        TRY(pop(type_for_kind(from)));
+        TRY(push(type_for_kind(to)));
+        return true;
+    }
+
+    case Opcode::I2b:
+    case Opcode::I2c:
+    case Opcode::I2s:
+        TRY(pop(Type::integer()));
+        TRY(push(Type::integer()));
+        return true;
+
+    case Opcode::Lcmp:
+        TRY(pop(Type::long_()));
+        TRY(pop(Type::long_()));
+        TRY(push(Type::integer()));
+        return true;
+
+    case Opcode::Fcmpl:
+    case Opcode::Fcmpg:
+        TRY(pop(Type::float_()));
+        TRY(pop(Type::float_()));
+        TRY(push(Type::integer()));
+        return true;
+
+    case Opcode::Dcmpl:
+    case Opcode::Dcmpg:
+        TRY(pop(Type::double_()));
+        TRY(pop(Type::double_()));
+        TRY(push(Type::integer()));
+        return true;
+
+    case Opcode::IfAcmpeq:
+    case Opcode::IfAcmpne:
+        TRY(pop_reference());
+        TRY(pop_reference());
+        TRY(branch_to(offset, static_cast<i16>(read_u2(offset + 1))));
+        return true;
+
+    case Opcode::Ifnull:
+    case Opcode::Ifnonnull:
+        TRY(pop_reference());
+        TRY(branch_to(offset, static_cast<i16>(read_u2(offset + 1))));
+        return true;
+
+    case Opcode::Goto:
+        TRY(branch_to(offset, static_cast<i16>(read_u2(offset + 1))));
+        return false;
+
+    case Opcode::GotoW:
+        TRY(branch_to(offset, read_i4(offset + 1)));
+        return false;
+
+    case Opcode::Jsr:
+    case Opcode::JsrW:
+    case Opcode::Ret:
+        // Class files that are verified by type checking can't contain subroutines (§4.9.1)
+        return Error::from_string_literal("jsr and ret can't be used in a class file that is verified by type checking");
+
+    case Opcode::Tableswitch: {
+        TRY(pop(Type::integer()));
+
+        auto operands = align_up_to(offset + 1, 4);
+        auto low = read_i4(operands + 4);
+        auto high = read_i4(operands + 8);
+        TRY(branch_to(offset, read_i4(operands)));
+        for (i64 i = 0; i < static_cast<i64>(high) - low + 1; i++)
+            TRY(branch_to(offset, read_i4(operands + 12 + i * 4)));
+
+        return false;
+    }
+
+    case Opcode::Lookupswitch: {
+        TRY(pop(Type::integer()));
+
+        auto operands = align_up_to(offset + 1, 4);
+        auto pair_count = read_i4(operands + 4);
+        TRY(branch_to(offset, read_i4(operands)));
+        for (i32 i = 0; i < pair_count; i++) {
+            auto pair = operands + 8 + i * 8;
+
+            // The keys must be sorted in increasing numerical order
+            if (i > 0 && read_i4(pair) <= read_i4(pair - 8))
+                return Error::from_string_literal("The keys of a lookupswitch aren't sorted");
+
+            TRY(branch_to(offset, read_i4(pair + 4)));
+        }
+
+        return false;
+    }
+
+    case Opcode::Ireturn:
+    case Opcode::Lreturn:
+    case Opcode::Freturn:
+    case Opcode::Dreturn:
+    case Opcode::Areturn:
+    case Opcode::Return:
+        TRY(check_return(opcode));
+        return false;
+
+    case Opcode::Getstatic:
+    case Opcode::Putstatic:
+    case Opcode::Getfield:
+    case Opcode::Putfield:
+        TRY(check_field_access(opcode, read_u2(offset + 1)));
+        return true;
+
+    case Opcode::Invokevirtual:
+    case Opcode::Invokespecial:
+    case Opcode::Invokestatic:
+    case Opcode::Invokeinterface:
+    case Opcode::Invokedynamic:
+        TRY(check_invocation(opcode, offset));
+        return true;
+
+    case Opcode::New: {
+        auto class_name = TRY(class_name_at(m_constant_pool, read_u2(offset + 1)));
+        if (class_name.view().starts_with(FieldDescriptor::ArrayDimension))
+            return Error::from_string_literal("new can't create an array");
+
+        // The object isn't initialized until its instance initialization method has been called, which it can't be more than once
+        auto type = Type::uninitialized(offset);
+        for (auto const& stack_value : m_frame.stack) {
+            if (stack_value == type)
+                return Error::from_string_literal("The object created by a new instruction is already on the operand stack");
+        }
+
+        for (auto& local : m_frame.locals) {
+            if (local == type)
+                local = Type::top();
+        }
+
+        TRY(push(type));
+        return true;
+    }
+
+    case Opcode::Newarray: {
+        // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-6.html#jvms-6.5.newarray
+        static constexpr StringView array_types[] = { "[Z"sv, "[C"sv, "[F"sv, "[D"sv, "[B"sv, "[S"sv, "[I"sv, "[J"sv };
+        auto array_type = read_u1(offset + 1);
+        if (array_type < 4 || array_type > 11)
+            return Error::from_string_literal("newarray has an invalid array type");
+
+        TRY(pop(Type::integer()));
+        TRY(push(Type::reference(TRY(Symbol::intern(array_types[array_type - 4])))));
+        return true;
+    }
+
+    case Opcode::Anewarray: {
+        auto component = TRY(class_name_at(m_constant_pool, read_u2(offset + 1)));
+        auto array_name = component.view().starts_with(FieldDescriptor::ArrayDimension)
+            ? TRY(String::formatted("[{}", component))
+            : TRY(String::formatted("[L{};", component));
+
+        TRY(pop(Type::integer()));
+        TRY(push(TRY(parse_field_descriptor(array_name.bytes_as_string_view()))));
+        return true;
+    }
+
+    case Opcode::Multianewarray: {
+        auto class_name = TRY(class_name_at(m_constant_pool, read_u2(offset + 1)));
+        auto dimensions = read_u1(offset + 3);
+
+        size_t class_dimensions = 0;
+        while (class_dimensions < class_name.length() && class_name.view()[class_dimensions] == FieldDescriptor::ArrayDimension)
+            class_dimensions++;
+
+        if (dimensions == 0 || dimensions > class_dimensions)
+            return Error::from_string_literal("multianewarray creates more dimensions than its class has");
+
+        for (size_t i = 0; i < dimensions; i++)
+            TRY(pop(Type::integer()));
+
+        TRY(push(Type::reference(class_name)));
+        return true;
+    }
+
+    case Opcode::Arraylength: {
+        auto array = TRY(pop());
+        if (array.kind != Type::Kind::Null && !array.is_array())
+            return Error::from_string_literal("Expected an array on the operand stack");
+
+        TRY(push(Type::integer()));
+        return true;
+    }
+
+    case Opcode::Athrow:
+        TRY(pop(Type::reference(symbols.java_lang_Throwable)));
+        return false;
+
+    case Opcode::Checkcast:
+        TRY(pop_initialized_reference());
+        TRY(push(Type::reference(TRY(class_name_at(m_constant_pool, read_u2(offset + 1))))));
+        return true;
+
+    case Opcode::Instanceof:
+        TRY(class_name_at(m_constant_pool, read_u2(offset + 1)));
+        TRY(pop_initialized_reference());
+        TRY(push(Type::integer()));
+        return true;
+
+    case Opcode::Monitorenter:
+    case Opcode::Monitorexit:
+        TRY(pop_reference());
+        return true;
+
+    case Opcode::Wide: {
+        auto modified_opcode = static_cast<Opcode>(m_code[offset + 1]);
+        auto index = read_u2(offset + 2);
+        switch (modified_opcode) {
+        case Opcode::Iload:
+        case Opcode::Lload:
+        case Opcode::Fload:
+        case Opcode::Dload:
+        case Opcode::Aload:
+            TRY(load_to_stack(index, to_underlying(modified_opcode) - to_underlying(Opcode::Iload)));
+            return true;
+
+        case Opcode::Istore:
+        case Opcode::Lstore:
+        case Opcode::Fstore:
+        case Opcode::Dstore:
+        case Opcode::Astore:
+            TRY(store_from_stack(index, to_underlying(modified_opcode) - to_underlying(Opcode::Istore)));
+            return true;
+
+        case Opcode::Iinc:
+            TRY(local(index, Type::integer()));
+            return true;
+
+        case Opcode::Ret:
+            return Error::from_string_literal("jsr and ret can't be used in a class file that is verified by type checking");
+
+        default:
+            return Error::from_string_literal("wide can't modify this instruction");
+        }
+    }
+
+    default:
+        // Every other opcode (i.e. breakpoint, impdep1 and impdep2) is reserved, and can't appear in a class file
+        return Error::from_string_literal("Unknown opcode");
+    }
+}
+
+ErrorOr<void> MethodVerifier::check_load_constant(u16 index, bool category_2)
+{
+    auto const& symbols = WellKnownSymbols::the();
+    if (!m_constant_pool.is_valid_index(index))
+        return Error::from_string_literal("ldc refers to a constant that can't be loaded");
+
+    switch (m_constant_pool.tag_at(index)) {
+    case Constant::Tag::Integer:
+        if (!category_2)
+            return push(Type::integer());
+        break;
+    case Constant::Tag::Float:
+        if (!category_2)
+            return push(Type::float_());
+        break;
+    case Constant::Tag::Long:
+        if (category_2)
+            return push(Type::long_());
+        break;
+    case Constant::Tag::Double:
+        if (category_2)
+            return push(Type::double_());
+        break;
+    case Constant::Tag::String:
+        if (!category_2)
+            return push(Type::reference(symbols.java_lang_String));
+        break;
+    case Constant::Tag::Class:
+        if (!category_2)
+            return push(Type::reference(symbols.java_lang_Class));
+        break;
+    case Constant::Tag::MethodType:
+        if (!category_2)
+            return push(Type::reference(symbols.java_lang_invoke_MethodType));
+        break;
+    case Constant::Tag::MethodHandle:
+        if (!category_2)
+            return push(Type::reference(symbols.java_lang_invoke_MethodHandle));
+        break;
+    case Constant::Tag::Dynamic: {
+        // A dynamically-computed constant has whichever type its descriptor says
+        auto dynamic = TRY(m_constant_pool.dynamic_at(index));
+        auto type = TRY(parse_field_descriptor(TRY(name_and_type_at(m_constant_pool, dynamic.name_and_type_index())).descriptor.view()));
+        if (type.is_category_2() == category_2)
+            return push(type);
+        break;
+    }
+    default:
+        break;
+    }
+
+    return Error::from_string_literal("ldc refers to a constant that can't be loaded");
+}
+
+ErrorOr<void> MethodVerifier::check_field_access(Opcode opcode, u16 index)
+{
+    if (!has_tag(m_constant_pool, index, Constant::Tag::FieldReference))
+        return Error::from_string_literal("Expected a CONSTANT_Fieldref_info");
+
+    auto reference = TRY(member_reference_at(m_constant_pool, index));
+    auto type = TRY(parse_field_descriptor(reference.descriptor.view()));
+    auto object_type = Type::reference(reference.class_name);
+
+    switch (opcode) {
+    case Opcode::Getstatic:
+        return push(type);
+
+    case Opcode::Putstatic:
+        return pop(type);
+
+    case Opcode::Getfield:
+        TRY(pop(object_type));
+        return push(type);
+
+    default: {
+        TRY(pop(type));
+
+        // An instance initialization method can assign the fields that its own class declares before `this` has been initialized
+        auto object = TRY(pop());
+        if (object.kind == Type::Kind::UninitializedThis && reference.class_name == m_verifier.class_name()) {
+            for (auto const& field_info : m_verifier.class_file().fields) {
+                if (TRY(utf8_at(m_constant_pool, field_info->name_index)) == reference.name && TRY(utf8_at(m_constant_pool, field_info->descriptor_index)) == reference.descriptor)
+                    return {};
+            }
+        }
+
+        if (!TRY(is_assignable(object, object_type)))
+            return Error::from_string_literal("A value on the operand stack has the wrong type");
+
+        return {};
+    }
+    }
+}
+
+ErrorOr<void> MethodVerifier::check_invocation(Opcode opcode, size_t offset)
+{
+    auto const& symbols = WellKnownSymbols::the();
+    auto index = read_u2(offset + 1);
+    if (!m_constant_pool.is_valid_index(index))
+        return Error::from_string_literal("An invoke instruction refers to an invalid constant");
+
+    auto tag = m_constant_pool.tag_at(index);
+    MemberReference reference;
+    switch (opcode) {
+    case Opcode::Invokevirtual:
+        if (tag != Constant::Tag::MethodReference)
+            return Error::from_string_literal("Expected a CONSTANT_Methodref_info");
+
+        reference = TRY(member_reference_at(m_constant_pool, index));
+        break;
+
+    case Opcode::Invokespecial:
+    case Opcode::Invokestatic:
+        if (tag != Constant::Tag::MethodReference && tag != Constant::Tag::InterfaceMethodReference)
+            return Error::from_string_literal("Expected a CONSTANT_Methodref_info or a CONSTANT_InterfaceMethodref_info");
+
+        reference = TRY(member_reference_at(m_constant_pool, index));
+        break;
+
+    case Opcode::Invokeinterface:
+        if (tag != Constant::Tag::InterfaceMethodReference)
+            return Error::from_string_literal("Expected a CONSTANT_InterfaceMethodref_info");
+
+        if (read_u1(offset + 4) != 0)
+            return Error::from_string_literal("The fourth operand byte of invokeinterface must be zero");
+
+        reference = TRY(member_reference_at(m_constant_pool, index));
+        break;
+
+    default: {
+        if (tag != Constant::Tag::InvokeDynamic)
+            return Error::from_string_literal("Expected a CONSTANT_InvokeDynamic_info");
+
+        if (read_u2(offset + 3) != 0)
+            return Error::from_string_literal("The third and fourth operand bytes of invokedynamic must be zero");
+
+        auto invoke_dynamic = TRY(m_constant_pool.invoke_dynamic_at(index));
+        auto name_and_type = TRY(name_and_type_at(m_constant_pool, invoke_dynamic.name_and_type_index()));
+        reference = MemberReference { .name = name_and_type.name, .descriptor = name_and_type.descriptor };
+        break;
+    }
+    }
+
+    // Class initialization methods are only ever invoked by the Java Virtual Machine, and instance initialization methods only by invokespecial
+    if (reference.name == symbols.clinit || (reference.name == symbols.init && opcode != Opcode::Invokespecial))
+        return Error::from_string_literal("An initialization method can't be invoked by this instruction");
+
+    auto method_type = TRY(parse_method_type(reference.descriptor.view()));
+    if (reference.name == symbols.init && method_type.return_type.has_value())
+        return Error::from_string_literal("An instance initialization method must return void");
+
+    size_t argument_slot_count = 0;
+    for (size_t i = method_type.parameters.size(); i > 0; i--) {
+        TRY(pop(method_type.parameters[i - 1]));
+        argument_slot_count += method_type.parameters[i - 1].slot_count();
+    }
+
+    switch (opcode) {
+    case Opcode::Invokevirtual:
+        TRY(pop(Type::reference(reference.class_name)));
+        break;
+
+    case Opcode::Invokespecial:
+        if (reference.name == symbols.init) {
+            TRY(initialize_object(reference.class_name));
+            break;
+        }
+
+        // Any other method invoked by invokespecial is one of the current class or its supertypes, which is invoked on an instance of the current class
+        TRY(pop(Type::reference(m_verifier.class_name())));
+        break;
+
+    case Opcode::Invokeinterface:
+        // The count operand is the number of slots that the arguments take up, including the receiver
+        if (read_u1(offset + 3) != argument_slot_count + 1)
+            return Error::from_string_literal("The count operand of invokeinterface doesn't match the method's descriptor");
+
+        // Interfaces are treated like java/lang/Object, the receiver is checked when the method is selected
+        TRY(pop(Type::reference(symbols.java_lang_Object)));
+        break;
+
+    default:
+        break;
+    }
+
+    if (method_type.return_type.has_value())
+        TRY(push(*method_type.return_type));
+
+    return {};
+}
+
+// Invoking an instance initialization method initializes every copy of the object, in the local variables and on the operand stack
+ErrorOr<void> MethodVerifier::initialize_object(Symbol method_class_name)
+{
+    auto object = TRY(pop());
+
+    Type initialized;
+    if (object.kind == Type::Kind::UninitializedThis) {
+        // `this` is initialized by another instance initialization method of the current class, or one of its direct superclass
+        if (method_class_name != m_verifier.class_name() && method_class_name != m_verifier.super_class_name())
+            return Error::from_string_literal("this must be initialized by an instance initialization method of the current class or its superclass");
+
+        initialized = Type::reference(m_verifier.class_name());
+        m_frame.this_uninitialized = false;
+    } else if (object.kind == Type::Kind::Uninitialized) {
+        // The offset of an Uninitialized type has been checked to be a new instruction
+        auto class_name = TRY(class_name_at(m_constant_pool, read_u2(object.new_offset + 1)));
+        if (method_class_name != class_name)
+            return Error::from_string_literal("An object must be initialized by an instance initialization method of its own class");
+
+        initialized = Type::reference(class_name);
+    } else {
+        return Error::from_string_literal("An instance initialization method can only be invoked on an uninitialized object");
+    }
+
+    for (auto& local : m_frame.locals) {
+        if (local == object)
+            local = initialized;
+    }
+
+    for (auto& value : m_frame.stack) {
+        if (value == object)
+            value = initialized;
+    }
+
+    return {};
+}
+
+ErrorOr<void> MethodVerifier::check_return(Opcode opcode)
+{
+    auto const& return_type = m_method_type.return_type;
+    if (opcode == Opcode::Return) {
+        if (return_type.has_value())
+            return Error::from_string_literal("return can't be used in a method that returns a value");
+
+        // An instance initialization method can't return until it has initialized `this`
+        if (m_frame.this_uninitialized)
+            return Error::from_string_literal("this is returned before it has been initialized");
+
+        return {};
+    }
+
+    auto expected = type_for_kind(to_underlying(opcode) - to_underlying(Opcode::Ireturn));
+    if (!return_type.has_value() || (expected.kind == Type::Kind::Reference ? !return_type->is_reference() : *return_type != expected))
+        return Error::from_string_literal("The return instruction doesn't match the method's return type");
+
+    return pop(*return_type);
+}
+
+Verifier::Verifier(ClassRegistry& registry, Parser::ClassFile const& class_file, Symbol class_name)
+    : m_registry(registry)
+    , m_class_file(class_file)
+    , m_class_name(class_name)
+{
+    // java/lang/Object is the only class without a superclass
+    auto super_class_name = class_name_at(constant_pool(), class_file.super_class);
+    if (!super_class_name.is_error())
+        m_super_class_name = super_class_name.release_value();
+}
+
+ErrorOr<Optional<String>> Verifier::verify_method(Parser::MethodInfo const& method_info) const
+{
+    // Abstract and native methods don't have any code to verify
+    RefPtr<Parser::CodeAttribute> code;
+    for (auto const& attribute : method_info.attributes) {
+        if (attribute->type() == Parser::AttributeType::Code)
+            code = static_ptr_cast<Parser::CodeAttribute>(attribute);
+    }
+
+    if (!code)
+        return Optional<String> {};
+
+    auto name = utf8_at(constant_pool(), method_info.name_index);
+    auto descriptor = utf8_at(constant_pool(), method_info.descriptor_index);
+    if (name.is_error() || descriptor.is_error())
+        return TRY(String::formatted("A method of {} has a malformed name or descriptor", m_class_name));
+
+    MethodVerifier method_verifier(*this, method_info, *code, name.value(), descriptor.value());
+    auto result = method_verifier.verify();
+    if (!result.is_error())
+        return Optional<String> {};
+
+    // Running out of memory doesn't say anything about the method
+    if (result.error().is_errno())
+        return result.release_error();
+
+    auto failure = TRY(String::formatted("{}{} at offset {}: {}", name.value(), descriptor.value(), method_verifier.offset(), result.error()));
+
+    // A version 50 class file that fails verification by type checking should be verified by type inference instead, which isn't implemented
+    if (m_class_file.major_version == Parser::MajorVersion::V6) {
+        dbgln("Verifier: Ignoring a failure in {}, which is a version 50 class file: {}", m_class_name, failure);
+        return Optional<String> {};
+    }
+
+    return failure;
+}
+
+Optional<Verifier::ClassInfo> Verifier::find_class(Symbol name) const
+{
+    auto const& symbols = WellKnownSymbols::the();
+    if (name == symbols.java_lang_Object)
+        return ClassInfo {};
+
+    if (name == symbols.java_lang_String || name == symbols.java_lang_Class || name == symbols.java_lang_System || name == symbols.java_io_PrintStream)
+        return ClassInfo { .super_class = symbols.java_lang_Object };
+
+    // Every array implements these
+    if (name == symbols.java_lang_Cloneable || name == symbols.java_io_Serializable)
+        return ClassInfo { .is_interface = true, .super_class = symbols.java_lang_Object };
+
+    auto* class_file = m_registry.find(name);
+    if (!class_file)
+        return {};
+
+    ClassInfo class_info { .is_interface = (class_file->access_flags & Access::Interface) != 0 };
+    auto super_class_name = class_name_at(*class_file->constant_pool, class_file->super_class);
+    if (!super_class_name.is_error())
+        class_info.super_class = super_class_name.release_value();
+
+    return class_info;
+}
+
+ErrorOr<bool> Verifier::is_assignable(Symbol from, Symbol to) const
+{
+    auto const& symbols = WellKnownSymbols::the();
+    if (from == to || to == symbols.java_lang_Object)
+        return true;
+
+    auto from_view = from.view();
+    auto to_view = to.view();
+    if (to_view.starts_with(FieldDescriptor::ArrayDimension)) {
+        if (!from_view.starts_with(FieldDescriptor::ArrayDimension))
+            return false;
+
+        // An array of primitives is only assignable to an array of the same primitive, an array of references is assignable if its component is
+        auto from_component = TRY(parse_field_descriptor(from_view.substring_view(1)));
+        auto to_component = TRY(parse_field_descriptor(to_view.substring_view(1)));
+        if (from_component.kind != Type::Kind::Reference || to_component.kind != Type::Kind::Reference)
+            return false;
+
+        return is_assignable(from_component.class_name, to_component.class_name);
+    }
+
+    // Interfaces are treated like java/lang/Object (§4.10.1.2), and a class that can't be found fails when it is resolved
+    auto to_class = find_class(to);
+    if (!to_class.has_value() || to_class->is_interface)
+        return true;
+
+    // Arrays are only assignable to java/lang/Object, or to the interfaces that every array implements
+    if (from_view.starts_with(FieldDescriptor::ArrayDimension))
+        return false;
+
+    // The registry can't be changed while a class is being verified, so a superclass chain that's longer than that has a cycle
+    auto current = from;
+    for (size_t depth = 0; depth <= m_registry.size(); depth++) {
+        auto current_class = find_class(current);
+        if (!current_class.has_value())
+            return true;
+
+        current = current_class->super_class;
+        if (current.is_null())
+            return false;
+
+        if (current == to)
+            return true;
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "../Parser/ClassFile.h"
+#include "../Symbol.h"
+#include <AK/Error.h>
+#include <AK/Optional.h>
+#include <AK/String.h>
+
+namespace Loader {
+
+// Forward-declaration
+class ClassRegistry;
+
+// Verification by type checking: https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.10.1
+//
+// The StackMapTable of a method gives the types of its local variables and operand stack at every branch target and exception handler.
+// The types are inferred from one instruction to the next, and checked against the stack map frame wherever one is given,
+// so each method is checked in a single pass over its code, independently of every other method.
+//
+// Some parts of verification aren't implemented:
+// - Class files before version 50 don't have stack maps, and have to be verified by type inference, so they aren't verified at all.
+//   A version 50 class file that fails type checking is supposed to fall back to type inference, so its failures are only logged.
+// - The protected member access check (§4.10.1.8) is skipped.
+// - Checking whether a class can be assigned to another needs the superclasses of both. If a class isn't in the registry, the check is deferred,
+//   as resolving the class is going to fail anyway.
+//
+// A Verifier only reads from the registry, so several threads can verify the methods of a class at once, as long as nothing is registered in the meantime.
+class Verifier {
+public:
+    Verifier(ClassRegistry& registry, Parser::ClassFile const& class_file, Symbol class_name);
+
+    // Whether the class file is recent enough to be verified by type checking
+    static bool can_verify(Parser::ClassFile const& class_file) { return class_file.major_version >= Parser::MajorVersion::V6; };
+
+    // Returns why the method isn't type-safe, or null if it is.
+    // This only fails if something goes wrong while checking the method, e.g. if we run out of memory.
+    ErrorOr<Optional<String>> verify_method(Parser::MethodInfo const& method_info) const;
+
+    // Whether a value of the class `from` can be used where a value of the class `to` is expected (isJavaAssignable).
+    // Both are either binary names (e.g. `java/lang/String`), or array descriptors (e.g. `[I`).
+    ErrorOr<bool> is_assignable(Symbol from, Symbol to) const;
+
+    Parser::ClassFile const& class_file() const { return m_class_file; };
+    Parser::ConstantPool const& constant_pool() const { return *m_class_file.constant_pool; };
+    Symbol class_name() const { return m_class_name; };
+
+    // A null symbol for java/lang/Object, which doesn't have a superclass
+    Symbol super_class_name() const { return m_super_class_name; };
+
+private:
+    struct ClassInfo {
+        bool is_interface { false };
+        Symbol super_class;
+    };
+
+    // Returns an empty optional if the class can't be found.
+    // The bootstrap classes that every Runtime defines (see Natives) aren't in the registry, but are known subclasses of java/lang/Object.
+    Optional<ClassInfo> find_class(Symbol name) const;
+
+    ClassRegistry& m_registry;
+    Parser::ClassFile const& m_class_file;
+    Symbol m_class_name;
+    Symbol m_super_class_name;
+};
+
+}
@@ -7,10 +7,29 @@
 #include "Attribute.h"
 #include "ClassParser.h"
 #include "ConstantPool.h"
-#include <AK/BitStream.h>
 
 namespace Parser {
 
+AttributeType attribute_type_from_name(Symbol name)
+{
+    // Symbols are interned, so each of these is a single pointer comparison
+    auto const& symbols = WellKnownSymbols::the();
+    if (name == symbols.constant_value_attribute)
+        return AttributeType::ConstantValue;
+    if (name == symbols.code_attribute)
+        return AttributeType::Code;
+    if (name == symbols.line_number_table_attribute)
+        return AttributeType::LineNumberTable;
+    if (name == symbols.source_file_attribute)
+        return AttributeType::SourceFile;
+    if (name == symbols.stack_map_table_attribute)
+        return AttributeType::StackMapTable;
+    if (name == symbols.bootstrap_methods_attribute)
+        return AttributeType::BootstrapMethods;
+
+    return AttributeType::Unknown;
+}
+
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.7.2
 ConstantValueAttribute::ConstantValueAttribute(u16 value_index)
     : Attribute(AttributeType::ConstantValue)
@@ -37,15 +56,22 @@ ErrorOr<String> ConstantValueAttribute::debug_description()
 }
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.7.3
-CodeAttribute::CodeAttribute(u16 max_stack, u16 max_locals, ByteBuffer code, Vector<NonnullRefPtr<Attribute>> attributes)
+CodeAttribute::CodeAttribute(u16 max_stack, u16 max_locals, ReadonlyBytes code, NonnullRefPtr<ClassFileBytes> storage, ReadonlyBytes exception_table_bytes, u16 exception_table_length, ReadonlyBytes attributes_bytes, u16 attributes_count, NonnullRefPtr<ConstantPool> constant_pool)
     : Attribute(AttributeType::Code)
     , m_max_stack(move(max_stack))
     , m_max_locals(move(max_locals))
-    , m_code(move(code))
-    , m_attributes(move(attributes))
+    , m_code(code)
+    , m_storage(move(storage))
+    , m_exception_table_bytes(exception_table_bytes)
+    , m_exception_table_length(exception_table_length)
+    , m_attributes_bytes(attributes_bytes)
+    , m_attributes_count(attributes_count)
+    , m_constant_pool(move(constant_pool))
 {
 }
 
+CodeAttribute::~CodeAttribute() = default;
+
 ErrorOr<NonnullRefPtr<CodeAttribute>> CodeAttribute::parse(ClassParser& class_parser, NonnullRefPtr<ConstantPool> const& constant_pool)
 {
     auto max_stack = TRY(class_parser.read_u2());
@@ -53,24 +79,89 @@ ErrorOr<NonnullRefPtr<CodeAttribute>> CodeAttribute::parse(ClassParser& class_pa
     auto code_length = TRY(class_parser.read_u4());
 
     // The value of code_length must be greater than zero (as the code array must not be empty) and less than 65536.
-    VERIFY(code_length > 0 && code_length < 65536);
+    if (code_length == 0 || code_length >= 65536)
+        return Error::from_string_literal("Invalid code_length in Code attribute");
 
     // The code array gives the actual bytes of Java Virtual Machine code that implement the method.
-    auto code = TRY(ByteBuffer::create_uninitialized(code_length));
-    TRY(class_parser.stream()->read_some(code));
+    // This points straight into the class file's storage, which the attribute keeps alive.
+    auto code = TRY(class_parser.read_bytes(code_length));
 
-    // TODO: Implement exception tables
+    // The exception table is only decoded once something needs it, i.e. the verifier, or the interpreter once the method is first invoked.
+    // Each entry is made up of four u2 items: start_pc, end_pc, handler_pc and catch_type, so the bounds of the table are known without decoding it.
     auto exception_table_length = TRY(class_parser.read_u2());
-    TRY(class_parser.stream()->discard(exception_table_length * 64));
+    auto exception_table_bytes = TRY(class_parser.read_bytes(exception_table_length * 8));
 
+    // Only the headers of the nested attributes are read for now, to find where they end.
+    // This means that the bounds of every nested attribute are checked while the class is being loaded.
     auto attributes_count = TRY(class_parser.read_u2());
-    auto attributes = Vector<NonnullRefPtr<Attribute>>();
+    auto attributes_offset = class_parser.offset();
     for (auto i = 0; i < attributes_count; i++) {
-        auto attribute = TRY(class_parser.parse_attribute(constant_pool));
-        attributes.append(move(attribute));
+        TRY(class_parser.discard(2));
+
+        auto attribute_length = TRY(class_parser.read_u4());
+        TRY(class_parser.discard(attribute_length));
+    }
+
+    auto attributes_bytes = class_parser.bytes().slice(attributes_offset, class_parser.offset() - attributes_offset);
+    return try_make_ref_counted<CodeAttribute>(max_stack, max_locals, code, class_parser.storage(), exception_table_bytes, exception_table_length, attributes_bytes, attributes_count, constant_pool);
+}
+
+ErrorOr<ReadonlySpan<NonnullRefPtr<Attribute>>> CodeAttribute::attributes()
+{
+    Threading::MutexLocker locker(m_attributes_mutex);
+
+    // Only the headers of the nested attributes were read when the class was loaded, so their contents can still be malformed.
+    // A failure isn't cached, every access fails in the same way.
+    if (!m_attributes.has_value())
+        m_attributes = TRY(parse_attributes());
+
+    return m_attributes->span();
+}
+
+ErrorOr<RefPtr<StackMapTableAttribute>> CodeAttribute::stack_map_table()
+{
+    // There may be at most one StackMapTable attribute in the attributes table of a Code attribute
+    for (auto const& attribute : TRY(attributes())) {
+        if (attribute->type() == AttributeType::StackMapTable)
+            return static_ptr_cast<StackMapTableAttribute>(attribute);
     }
 
-    return try_make_ref_counted<CodeAttribute>(max_stack, max_locals, code, move(attributes));
+    return nullptr;
+}
+
+ErrorOr<Vector<CodeAttribute::ExceptionHandler>> CodeAttribute::exception_table() const
+{
+    ClassParser class_parser(m_storage, m_exception_table_bytes);
+
+    auto table = Vector<ExceptionHandler>();
+    TRY(table.try_ensure_capacity(m_exception_table_length));
+
+    for (auto i = 0; i < m_exception_table_length; i++) {
+        table.unchecked_append(ExceptionHandler {
+            .start_pc = TRY(class_parser.read_u2()),
+            .end_pc = TRY(class_parser.read_u2()),
+            .handler_pc = TRY(class_parser.read_u2()),
+            .catch_type = TRY(class_parser.read_u2()),
+        });
+    }
+
+    return table;
+}
+
+ErrorOr<Vector<NonnullRefPtr<Attribute>>> CodeAttribute::parse_attributes()
+{
+    ClassParser class_parser(m_storage, m_attributes_bytes);
+
+    auto attributes = Vector<NonnullRefPtr<Attribute>>();
+    TRY(attributes.try_ensure_capacity(m_attributes_count));
+
+    for (auto i = 0; i < m_attributes_count; i++) {
+        auto attribute = TRY(class_parser.parse_attribute(m_constant_pool));
+        if (attribute)
+            attributes.unchecked_append(attribute.release_nonnull());
+    }
+
+    return attributes;
 }
 
 ErrorOr<String> CodeAttribute::debug_description()
@@ -82,7 +173,7 @@ ErrorOr<String> CodeAttribute::debug_description()
     builder.appendff("max_locals = {}, ", max_locals());
     builder.append("attributes = [ "sv);
 
-    for (auto const& attribute : attributes()) {
+    for (auto const& attribute : TRY(attributes())) {
         builder.appendff("{}", TRY(attribute->debug_description()));
     }
 
@@ -93,23 +184,47 @@ ErrorOr<String> CodeAttribute::debug_description()
 }
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.7.12
-LineNumberTableAttribute::LineNumberTableAttribute(Vector<LineNumberTableAttribute::Entry> table)
+LineNumberTableAttribute::LineNumberTableAttribute(NonnullRefPtr<ClassFileBytes> storage, ReadonlyBytes table_bytes, u16 table_length)
     : Attribute(AttributeType::LineNumberTable)
-    , m_table(move(table))
+    , m_storage(move(storage))
+    , m_table_bytes(table_bytes)
+    , m_table_length(table_length)
 {
 }
 
 ErrorOr<NonnullRefPtr<LineNumberTableAttribute>> LineNumberTableAttribute::parse(ClassParser& class_parser)
 {
+    // Each entry is made up of two u2 items, so the bounds of the table are known without decoding it.
     auto line_number_table_length = TRY(class_parser.read_u2());
+    auto table_bytes = TRY(class_parser.read_bytes(line_number_table_length * 4));
+
+    return try_make_ref_counted<LineNumberTableAttribute>(class_parser.storage(), table_bytes, line_number_table_length);
+}
+
+ErrorOr<ReadonlySpan<LineNumberTableAttribute::Entry>> LineNumberTableAttribute::table()
+{
+    Threading::MutexLocker locker(m_table_mutex);
+
+    // The size of the table was checked when the class was loaded, so this can only fail if we run out of memory
+    if (!m_table.has_value())
+        m_table = TRY(parse_table());
+
+    return m_table->span();
+}
+
+ErrorOr<Vector<LineNumberTableAttribute::Entry>> LineNumberTableAttribute::parse_table()
+{
+    ClassParser class_parser(m_storage, m_table_bytes);
+
     auto table = Vector<LineNumberTableAttribute::Entry>();
+    TRY(table.try_ensure_capacity(m_table_length));
 
-    for (auto i = 0; i < line_number_table_length; i++) {
+    for (auto i = 0; i < m_table_length; i++) {
         auto entry = TRY(LineNumberTableAttribute::parse_entry(class_parser));
-        table.append(entry);
+        table.unchecked_append(entry);
     }
 
-    return try_make_ref_counted<LineNumberTableAttribute>(table);
+    return table;
 }
 
 ErrorOr<LineNumberTableAttribute::Entry> LineNumberTableAttribute::parse_entry(ClassParser& class_parser)
@@ -132,15 +247,16 @@ ErrorOr<String> LineNumberTableAttribute::debug_description()
 
     builder.append("LineNumberTableAttribute { "sv);
 
+    auto table = TRY(this->table());
     size_t index = 0;
-    for (auto const& entry : table()) {
+    for (auto const& entry : table) {
         index++;
 
         builder.append("{ "sv);
         builder.appendff("pc = {}, ln = {}", entry.start_pc, entry.line_number);
         builder.append(" }"sv);
 
-        if (table().size() != index) {
+        if (table.size() != index) {
             builder.append(',');
         }
 
@@ -152,6 +268,148 @@ ErrorOr<String> LineNumberTableAttribute::debug_description()
     return builder.to_string();
 }
 
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.7.4
+StackMapTableAttribute::StackMapTableAttribute(NonnullRefPtr<ClassFileBytes> storage, ReadonlyBytes bytes)
+    : Attribute(AttributeType::StackMapTable)
+    , m_storage(move(storage))
+    , m_bytes(bytes)
+{
+}
+
+ErrorOr<NonnullRefPtr<StackMapTableAttribute>> StackMapTableAttribute::parse(ClassParser& class_parser, u32 attribute_length)
+{
+    // The entries have different sizes, so the only way to find where they end is to decode them, which is left until they're needed
+    auto bytes = TRY(class_parser.read_bytes(attribute_length));
+    return try_make_ref_counted<StackMapTableAttribute>(class_parser.storage(), bytes);
+}
+
+ErrorOr<StackMapTableAttribute::VerificationType> StackMapTableAttribute::parse_verification_type(ClassParser& class_parser)
+{
+    auto tag = TRY(class_parser.read_u1());
+    if (tag > to_underlying(VerificationType::Tag::Uninitialized))
+        return Error::from_string_literal("Invalid verification type in StackMapTable");
+
+    // Only Object_variable_info and Uninitialized_variable_info have an operand
+    auto verification_type = VerificationType { .tag = static_cast<VerificationType::Tag>(tag) };
+    if (verification_type.tag == VerificationType::Tag::Object || verification_type.tag == VerificationType::Tag::Uninitialized)
+        verification_type.data = TRY(class_parser.read_u2());
+
+    return verification_type;
+}
+
+ErrorOr<Vector<StackMapTableAttribute::Frame>> StackMapTableAttribute::frames() const
+{
+    ClassParser class_parser(m_storage, m_bytes);
+
+    auto number_of_entries = TRY(class_parser.read_u2());
+    auto frames = Vector<Frame>();
+    TRY(frames.try_ensure_capacity(number_of_entries));
+
+    for (auto i = 0; i < number_of_entries; i++) {
+        auto frame_type = TRY(class_parser.read_u1());
+
+        Frame frame { .kind = Frame::Kind::Same, .offset_delta = 0 };
+        if (frame_type <= 63) {
+            // same_frame: the offset delta is the frame type itself
+            frame.offset_delta = frame_type;
+        } else if (frame_type <= 127) {
+            // same_locals_1_stack_item_frame: the offset delta is the frame type minus 64
+            frame.kind = Frame::Kind::SameLocals1StackItem;
+            frame.offset_delta = frame_type - 64;
+            TRY(frame.stack.try_append(TRY(parse_verification_type(class_parser))));
+        } else if (frame_type <= 246) {
+            // These frame types are reserved for future use
+            return Error::from_string_literal("Reserved frame type in StackMapTable");
+        } else if (frame_type == 247) {
+            frame.kind = Frame::Kind::SameLocals1StackItem;
+            frame.offset_delta = TRY(class_parser.read_u2());
+            TRY(frame.stack.try_append(TRY(parse_verification_type(class_parser))));
+        } else if (frame_type <= 250) {
+            // chop_frame: the frame type is 251 minus the number of locals that are gone
+            frame.kind = Frame::Kind::Chop;
+            frame.offset_delta = TRY(class_parser.read_u2());
+            frame.chopped_local_count = 251 - frame_type;
+        } else if (frame_type == 251) {
+            // same_frame_extended
+            frame.offset_delta = TRY(class_parser.read_u2());
+        } else if (frame_type <= 254) {
+            // append_frame: the frame type is 251 plus the number of new locals
+            frame.kind = Frame::Kind::Append;
+            frame.offset_delta = TRY(class_parser.read_u2());
+            for (auto j = 0; j < frame_type - 251; j++)
+                TRY(frame.locals.try_append(TRY(parse_verification_type(class_parser))));
+        } else {
+            frame.kind = Frame::Kind::Full;
+            frame.offset_delta = TRY(class_parser.read_u2());
+
+            auto number_of_locals = TRY(class_parser.read_u2());
+            for (auto j = 0; j < number_of_locals; j++)
+                TRY(frame.locals.try_append(TRY(parse_verification_type(class_parser))));
+
+            auto number_of_stack_items = TRY(class_parser.read_u2());
+            for (auto j = 0; j < number_of_stack_items; j++)
+                TRY(frame.stack.try_append(TRY(parse_verification_type(class_parser))));
+        }
+
+        frames.unchecked_append(move(frame));
+    }
+
+    if (class_parser.offset() != m_bytes.size())
+        return Error::from_string_literal("StackMapTable attribute length does not match its entries");
+
+    return frames;
+}
+
+ErrorOr<String> StackMapTableAttribute::debug_description()
+{
+    StringBuilder builder;
+
+    builder.append("StackMapTable { "sv);
+    builder.appendff("length = {}", m_bytes.size());
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.7.23
+BootstrapMethodsAttribute::BootstrapMethodsAttribute(Vector<BootstrapMethod> bootstrap_methods)
+    : Attribute(AttributeType::BootstrapMethods)
+    , m_bootstrap_methods(move(bootstrap_methods))
+{
+}
+
+ErrorOr<NonnullRefPtr<BootstrapMethodsAttribute>> BootstrapMethodsAttribute::parse(ClassParser& class_parser)
+{
+    // A class only has as many bootstrap methods as it has invokedynamic call sites (and dynamic constants) with different bootstrap arguments, so these are decoded straight away
+    auto num_bootstrap_methods = TRY(class_parser.read_u2());
+    auto bootstrap_methods = Vector<BootstrapMethod>();
+    TRY(bootstrap_methods.try_ensure_capacity(num_bootstrap_methods));
+
+    for (auto i = 0; i < num_bootstrap_methods; i++) {
+        BootstrapMethod bootstrap_method { .method_ref = TRY(class_parser.read_u2()), .arguments = {} };
+
+        auto num_bootstrap_arguments = TRY(class_parser.read_u2());
+        TRY(bootstrap_method.arguments.try_ensure_capacity(num_bootstrap_arguments));
+        for (auto j = 0; j < num_bootstrap_arguments; j++)
+            bootstrap_method.arguments.unchecked_append(TRY(class_parser.read_u2()));
+
+        bootstrap_methods.unchecked_append(move(bootstrap_method));
+    }
+
+    return try_make_ref_counted<BootstrapMethodsAttribute>(move(bootstrap_methods));
+}
+
+ErrorOr<String> BootstrapMethodsAttribute::debug_description()
+{
+    StringBuilder builder;
+
+    builder.append("BootstrapMethods { "sv);
+    builder.appendff("count = {}", m_bootstrap_methods.size());
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.7.10
 SourceFileAttribute::SourceFileAttribute(u16 index)
     : Attribute(AttributeType::SourceFile)
@@ -6,15 +6,20 @@
 
 #pragma once
 
+#include "../Symbol.h"
+#include "ClassFileBytes.h"
+#include <AK/Optional.h>
 #include <AK/String.h>
+#include <LibThreading/Mutex.h>
 
 namespace Parser {
 
 // Forward-declaration
 class ClassParser;
 class ConstantPool;
+class StackMapTableAttribute;
 
-enum class AttributeType {
+enum class AttributeType : u8 {
     // A ConstantValue attribute represents the value of a constant expression
     ConstantValue,
 
@@ -27,9 +32,24 @@ enum class AttributeType {
 
     // The SourceFile attribute is an optional fixed-length attribute in the attributes table of a ClassFile structure (§4.1).
     // It provides an index into the constant pool table, denoting the name of the original source file of this class.
-    SourceFile
+    SourceFile,
+
+    // The StackMapTable attribute is a variable-length attribute in the attributes table of a Code attribute.
+    // It records the types of the local variables and the operand stack wherever control flow merges, and is used during verification by type checking.
+    StackMapTable,
+
+    // The BootstrapMethods attribute is a variable-length attribute in the attributes table of a ClassFile structure.
+    // It records the bootstrap methods used to produce dynamically-computed constants and dynamically-computed call sites (i.e. invokedynamic).
+    BootstrapMethods,
+
+    // Any attribute that we don't understand, these are skipped over when parsing.
+    // Java Virtual Machine implementations are required to silently ignore attributes that they do not recognize.
+    Unknown,
 };
 
+// Classifies an attribute by its name, returns AttributeType::Unknown if the name isn't recognized
+AttributeType attribute_type_from_name(Symbol name);
+
 class Attribute : public RefCounted<Attribute> {
 public:
     virtual ~Attribute() = default;
@@ -63,9 +83,23 @@ private:
 };
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.7.3
+//
+// Most methods are never executed, so only the header and the bounds of each part are read when the class is loaded.
+// The code is a view into the class file's storage, and the nested attributes are decoded the first time that they're accessed.
 class CodeAttribute : public Attribute {
 public:
-    CodeAttribute(u16 max_stack, u16 max_locals, ByteBuffer code, Vector<NonnullRefPtr<Attribute>> attributes);
+    // An entry of the exception table, the handler is run for exceptions of the catch type that are thrown by the instructions in [start_pc, end_pc)
+    struct ExceptionHandler {
+        u16 start_pc;
+        u16 end_pc;
+        u16 handler_pc;
+
+        // A CONSTANT_Class_info structure, or 0 if the handler catches every exception (e.g. for a `finally` block)
+        u16 catch_type;
+    };
+
+    CodeAttribute(u16 max_stack, u16 max_locals, ReadonlyBytes code, NonnullRefPtr<ClassFileBytes> storage, ReadonlyBytes exception_table_bytes, u16 exception_table_length, ReadonlyBytes attributes_bytes, u16 attributes_count, NonnullRefPtr<ConstantPool> constant_pool);
+    ~CodeAttribute() override;
 
     static ErrorOr<NonnullRefPtr<CodeAttribute>> parse(ClassParser& class_parser, NonnullRefPtr<ConstantPool> const& constant_pool);
 
@@ -73,14 +107,37 @@ public:
 
     u16 max_stack() { return m_max_stack; };
     u16 max_locals() { return m_max_locals; };
-    ByteBuffer const& code() { return m_code; };
-    Vector<NonnullRefPtr<Attribute>> const& attributes() { return m_attributes; };
+    ReadonlyBytes code() { return m_code; };
+
+    // Decodes the nested attributes on first access.
+    // Only their bounds are checked when the class is loaded, so this fails if one of them is malformed, e.g. if its name isn't a CONSTANT_Utf8_info.
+    ErrorOr<ReadonlySpan<NonnullRefPtr<Attribute>>> attributes();
+
+    // Returns null if the code doesn't have a StackMapTable, e.g. if it never branches
+    ErrorOr<RefPtr<StackMapTableAttribute>> stack_map_table();
+
+    // Decodes the table every time that it's called. The verifier checks it once, and the interpreter keeps its own decoded copy (see Interpreter::InstructionStream).
+    ErrorOr<Vector<ExceptionHandler>> exception_table() const;
 
 private:
+    ErrorOr<Vector<NonnullRefPtr<Attribute>>> parse_attributes();
+
     u16 m_max_stack;
     u16 m_max_locals;
-    ByteBuffer m_code;
-    Vector<NonnullRefPtr<Attribute>> m_attributes;
+    ReadonlyBytes m_code;
+
+    // Keeps the bytes that `m_code`, `m_exception_table_bytes` and `m_attributes_bytes` point into alive
+    NonnullRefPtr<ClassFileBytes> m_storage;
+
+    ReadonlyBytes m_exception_table_bytes;
+    u16 m_exception_table_length;
+
+    ReadonlyBytes m_attributes_bytes;
+    u16 m_attributes_count;
+    NonnullRefPtr<ConstantPool> m_constant_pool;
+
+    Threading::Mutex m_attributes_mutex;
+    Optional<Vector<NonnullRefPtr<Attribute>>> m_attributes;
 };
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.7.12
@@ -94,20 +151,129 @@ public:
         u16 line_number;
     };
 
-    LineNumberTableAttribute(Vector<Entry> table);
+    LineNumberTableAttribute(NonnullRefPtr<ClassFileBytes> storage, ReadonlyBytes table_bytes, u16 table_length);
 
     static ErrorOr<NonnullRefPtr<LineNumberTableAttribute>> parse(ClassParser& class_parser);
 
     ErrorOr<String> debug_description();
 
-    Vector<Entry> const& table() { return m_table; };
+    // Decodes the table on first access, it's only needed for stack traces and debuggers
+    ErrorOr<ReadonlySpan<Entry>> table();
 
 private:
-    Vector<Entry> m_table;
+    ErrorOr<Vector<Entry>> parse_table();
+
+    // Keeps the bytes that `m_table_bytes` points into alive
+    NonnullRefPtr<ClassFileBytes> m_storage;
+
+    ReadonlyBytes m_table_bytes;
+    u16 m_table_length;
+
+    Threading::Mutex m_table_mutex;
+    Optional<Vector<Entry>> m_table;
 
     static ErrorOr<Entry> parse_entry(ClassParser& class_parser);
 };
 
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.7.4
+//
+// Each frame is stored as the difference from the frame before it, so the table only makes sense when it's read from start to end.
+class StackMapTableAttribute : public Attribute {
+public:
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.10.1.2
+    struct VerificationType {
+        enum class Tag : u8 {
+            Top = 0,
+            Integer = 1,
+            Float = 2,
+            Double = 3,
+            Long = 4,
+            Null = 5,
+            UninitializedThis = 6,
+            Object = 7,
+            Uninitialized = 8,
+        };
+
+        Tag tag;
+
+        // The CONSTANT_Class_info structure of an Object, or the offset of the new instruction that created an Uninitialized object
+        u16 data { 0 };
+    };
+
+    struct Frame {
+        enum class Kind : u8 {
+            // The locals are the same as in the previous frame, and the operand stack is empty (same_frame and same_frame_extended)
+            Same,
+
+            // The locals are the same as in the previous frame, and the operand stack holds a single value (same_locals_1_stack_item_frame and its extended form)
+            SameLocals1StackItem,
+
+            // The last `chopped_local_count` locals of the previous frame are gone, and the operand stack is empty
+            Chop,
+
+            // The previous frame's locals are followed by `locals`, and the operand stack is empty
+            Append,
+
+            // Every local and every value on the operand stack is given explicitly
+            Full,
+        };
+
+        Kind kind;
+
+        // The frame applies at the offset of the previous frame, plus offset_delta + 1 (the first frame applies at offset_delta)
+        u16 offset_delta;
+
+        u8 chopped_local_count { 0 };
+
+        // A long or a double is a single entry, even though it takes up two local variables or two slots of the operand stack
+        Vector<VerificationType> locals;
+        Vector<VerificationType> stack;
+    };
+
+    StackMapTableAttribute(NonnullRefPtr<ClassFileBytes> storage, ReadonlyBytes bytes);
+
+    static ErrorOr<NonnullRefPtr<StackMapTableAttribute>> parse(ClassParser& class_parser, u32 attribute_length);
+
+    ErrorOr<String> debug_description();
+
+    // Only the verifier reads the frames, once per method, so they're decoded every time that this is called instead of being kept around.
+    // Fails if the entries are malformed, which isn't checked until then.
+    ErrorOr<Vector<Frame>> frames() const;
+
+private:
+    static ErrorOr<VerificationType> parse_verification_type(ClassParser& class_parser);
+
+    // Keeps the bytes that `m_bytes` points into alive
+    NonnullRefPtr<ClassFileBytes> m_storage;
+
+    // The whole attribute after its length: number_of_entries, followed by the entries
+    ReadonlyBytes m_bytes;
+};
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.7.23
+class BootstrapMethodsAttribute : public Attribute {
+public:
+    struct BootstrapMethod {
+        // A CONSTANT_MethodHandle_info structure
+        u16 method_ref;
+
+        // The static arguments of the bootstrap method, each one is a loadable constant
+        Vector<u16> arguments;
+    };
+
+    BootstrapMethodsAttribute(Vector<BootstrapMethod> bootstrap_methods);
+
+    static ErrorOr<NonnullRefPtr<BootstrapMethodsAttribute>> parse(ClassParser& class_parser);
+
+    ErrorOr<String> debug_description();
+
+    // Indexed by the bootstrap_method_attr_index of a CONSTANT_Dynamic_info or CONSTANT_InvokeDynamic_info structure
+    Vector<BootstrapMethod> const& bootstrap_methods() const { return m_bootstrap_methods; };
+
+private:
+    Vector<BootstrapMethod> m_bootstrap_methods;
+};
+
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.7.10
 class SourceFileAttribute : public Attribute {
 public:
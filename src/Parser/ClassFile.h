@@ -96,7 +96,7 @@ struct ClassFile {
     //
     // The constant_pool entry at each value of interfaces[i], where 0 ≤ i < interfaces_count, must be a CONSTANT_Class_info structure
     // representing an interface that is a direct superinterface of this class or interface type, in the left-to-right order given in the source for the type.
-    Vector<NonnullRefPtr<ConstantClassInfo>> interfaces;
+    Vector<u16> interfaces;
 
     // Each value in the fields table must be a field_info structure (§4.5) giving a complete description of a field in this class or interface.
     //
@@ -133,10 +133,8 @@ struct Formatter<Parser::ClassFile> : Formatter<StringView> {
 
         builder.appendff("  constant_pool=[\n");
 
-        auto constant_index = 1;
-        for (auto const& constant : class_file.constant_pool->entries()) {
-            builder.appendff("    {}: {}\n", constant_index, TRY(constant->debug_description()));
-            constant_index++;
+        for (u16 constant_index = 1; constant_index < class_file.constant_pool->size(); constant_index++) {
+            builder.appendff("    {}: {}\n", constant_index, TRY(class_file.constant_pool->debug_description_at(constant_index)));
         }
 
         builder.append("  ]\n"sv);
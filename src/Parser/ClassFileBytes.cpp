@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "ClassFileBytes.h"
+
+namespace Parser {
+
+ClassFileBytes::ClassFileBytes(NonnullOwnPtr<Core::MappedFile> mapped_file)
+    : m_mapped_file(move(mapped_file))
+{
+    m_bytes = m_mapped_file->bytes();
+}
+
+ClassFileBytes::ClassFileBytes(ByteBuffer buffer)
+    : m_buffer(move(buffer))
+{
+    // The buffer must be moved into place before we take a view of it, small buffers are stored inline.
+    m_bytes = m_buffer.bytes();
+}
+
+ErrorOr<NonnullRefPtr<ClassFileBytes>> ClassFileBytes::map(StringView path)
+{
+    // Mapping the file lets us decode fields straight out of the page cache, without any intermediate copies
+    auto mapped_file = TRY(Core::MappedFile::map(path));
+    return try_make_ref_counted<ClassFileBytes>(move(mapped_file));
+}
+
+ErrorOr<NonnullRefPtr<ClassFileBytes>> ClassFileBytes::adopt(ByteBuffer buffer)
+{
+    return try_make_ref_counted<ClassFileBytes>(move(buffer));
+}
+
+}
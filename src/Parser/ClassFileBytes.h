@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/Span.h>
+#include <LibCore/MappedFile.h>
+
+namespace Parser {
+
+// The backing storage for a class file, or for an archive containing class files.
+//
+// Some attributes are only decoded when they're first accessed, straight out of these bytes.
+// Every parser and lazily-decoded attribute holds a reference, so the storage lives for as long as anything can still read from it.
+class ClassFileBytes : public RefCounted<ClassFileBytes> {
+public:
+    ClassFileBytes(NonnullOwnPtr<Core::MappedFile> mapped_file);
+    ClassFileBytes(ByteBuffer buffer);
+
+    // Memory-maps the file at the path
+    static ErrorOr<NonnullRefPtr<ClassFileBytes>> map(StringView path);
+
+    // Takes ownership of a buffer
+    static ErrorOr<NonnullRefPtr<ClassFileBytes>> adopt(ByteBuffer buffer);
+
+    ReadonlyBytes bytes() const { return m_bytes; };
+
+private:
+    // Only one of these is set, `m_bytes` always points into it.
+    OwnPtr<Core::MappedFile> m_mapped_file;
+    ByteBuffer m_buffer;
+
+    ReadonlyBytes m_bytes;
+};
+
+}
@@ -5,23 +5,39 @@
  */
 
 #include "ClassParser.h"
-#include <AK/BitStream.h>
-#include <AK/MaybeOwned.h>
+#include "ConstantInfo.h"
 #include <AK/String.h>
 
 namespace Parser {
 
-ClassParser::ClassParser(NonnullOwnPtr<BigEndianInputBitStream> stream)
-    : m_stream(move(stream))
+ClassParser::ClassParser(NonnullRefPtr<ClassFileBytes> storage)
+    : m_storage(move(storage))
 {
+    m_bytes = m_storage->bytes();
+}
+
+ClassParser::ClassParser(NonnullRefPtr<ClassFileBytes> storage, ReadonlyBytes bytes)
+    : m_storage(move(storage))
+    , m_bytes(bytes)
+{
+}
+
+ErrorOr<NonnullOwnPtr<ClassParser>> ClassParser::create(StringView path)
+{
+    auto storage = TRY(ClassFileBytes::map(path));
+    return try_make<ClassParser>(move(storage));
 }
 
 ErrorOr<NonnullOwnPtr<ClassParser>> ClassParser::create(NonnullOwnPtr<Core::File> file)
 {
-    auto buffer = TRY(Core::BufferedFile::create(move(file)));
-    auto bit_stream = TRY(try_make<BigEndianInputBitStream>(MaybeOwned<Stream>(move(buffer))));
+    auto buffer = TRY(file->read_until_eof());
+    return create(move(buffer));
+}
 
-    return make<ClassParser>(move(bit_stream));
+ErrorOr<NonnullOwnPtr<ClassParser>> ClassParser::create(ByteBuffer buffer)
+{
+    auto storage = TRY(ClassFileBytes::adopt(move(buffer)));
+    return try_make<ClassParser>(move(storage));
 }
 
 ErrorOr<ClassFile> ClassParser::parse()
@@ -56,7 +72,7 @@ ErrorOr<ClassFile> ClassParser::parse()
 
     // The direct super-interfaces of this class/interface
     auto interfaces_length = TRY(this->read_u2());
-    auto interfaces = Vector<NonnullRefPtr<ConstantClassInfo>>();
+    auto interfaces = Vector<u16>();
     for (auto i = 0; i < interfaces_length; i++) {
         // Each "interface" is just a reference to an index in the constant pool table
         auto interface_info = TRY(this->parse_interface(constant_pool));
@@ -90,7 +106,8 @@ ErrorOr<ClassFile> ClassParser::parse()
     auto attributes = Vector<NonnullRefPtr<Attribute>>();
     for (auto i = 0; i < attributes_length; i++) {
         auto attribute = TRY(this->parse_attribute(constant_pool));
-        attributes.append(move(attribute));
+        if (attribute)
+            attributes.append(attribute.release_nonnull());
     }
 
     // Construct a class file struct
@@ -112,18 +129,15 @@ ErrorOr<ClassFile> ClassParser::parse()
     return file;
 }
 
-ErrorOr<NonnullRefPtr<ConstantClassInfo>> ClassParser::parse_interface(NonnullRefPtr<ConstantPool> const& constant_pool)
+ErrorOr<u16> ClassParser::parse_interface(NonnullRefPtr<ConstantPool> const& constant_pool)
 {
     // Each value in ther interfaces array is an index into the constant pool table
     auto index = TRY(this->read_u2());
-    ConstantInfo* constant = constant_pool->entries().at(index);
 
     // The constant_pool entry at each value of interfaces[i], where 0 ≤ i < interfaces_count, must be a CONSTANT_Class_info structure
-    VERIFY(constant->tag() == Constant::Tag::Class);
+    VERIFY(constant_pool->tag_at(index) == Constant::Tag::Class);
 
-    // ~~ Fancy casting woooo ~~
-    auto& casted_reference = static_cast<ConstantClassInfo&>(*constant);
-    return adopt_ref(casted_reference);
+    return index;
 }
 
 ErrorOr<NonnullOwnPtr<FieldInfo>> ClassParser::parse_field(NonnullRefPtr<ConstantPool> const& constant_pool)
@@ -142,7 +156,8 @@ ErrorOr<NonnullOwnPtr<FieldInfo>> ClassParser::parse_field(NonnullRefPtr<Constan
     auto attributes = Vector<NonnullRefPtr<Attribute>>();
     for (auto i = 0; i < attributes_count; i++) {
         auto attribute = TRY(this->parse_attribute(constant_pool));
-        attributes.append(attribute);
+        if (attribute)
+            attributes.append(attribute.release_nonnull());
     }
 
     return try_make<FieldInfo>(access_flags, name_index, descriptor_index, move(attributes));
@@ -164,54 +179,64 @@ ErrorOr<NonnullOwnPtr<MethodInfo>> ClassParser::parse_method(NonnullRefPtr<Const
     auto attributes = Vector<NonnullRefPtr<Attribute>>();
     for (auto i = 0; i < attributes_count; i++) {
         auto attribute = TRY(this->parse_attribute(constant_pool));
-        attributes.append(attribute);
+        if (attribute)
+            attributes.append(attribute.release_nonnull());
     }
 
     return try_make<MethodInfo>(access_flags, name_index, descriptor_index, move(attributes));
 }
 
-ErrorOr<NonnullRefPtr<Attribute>> ClassParser::parse_attribute(NonnullRefPtr<ConstantPool> const& constant_pool)
+ErrorOr<RefPtr<Attribute>> ClassParser::parse_attribute(NonnullRefPtr<ConstantPool> const& constant_pool)
 {
     // An index in the constant pool table to name of this attribute
     auto name_index = TRY(this->read_u2());
 
     // The length of the data for this attribute, immediately after the end of this u4
     auto attribute_length = TRY(this->read_u4());
-    (void)attribute_length; // Maybe we should validate that we've read the correct amount?
+    auto start_offset = this->offset();
 
     // The constant_pool entry at attribute_name_index must be a CONSTANT_Utf8_info structure (§4.4.7) representing the name of the attribute.
-    auto const& constant = constant_pool->entries().at(name_index - 1);
-    VERIFY(constant->tag() == Constant::Tag::UTF8);
-
-    // The attribute name helps us to understand the data that we should read next
-    auto attribute_name = static_cast<ConstantUTF8Info&>(*constant).data();
-    if (attribute_name == "ConstantValue") {
-        return ConstantValueAttribute::parse(*this);
-    } else if (attribute_name == "Code") {
-        return CodeAttribute::parse(*this, constant_pool);
-    } else if (attribute_name == "LineNumberTable") {
-        return LineNumberTableAttribute::parse(*this);
-    } else if (attribute_name == "SourceFile") {
-        return SourceFileAttribute::parse(*this);
-    } else {
-        dbgln("Unimplemented attribute: {}", attribute_name);
-        TODO();
+    // The attribute name helps us to understand the data that we should read next, it was classified when the constant pool was parsed.
+    if (!constant_pool->is_valid_index(name_index) || constant_pool->tag_at(name_index) != Constant::Tag::UTF8)
+        return Error::from_string_literal("Attribute name is not a CONSTANT_Utf8_info structure");
+
+    RefPtr<Attribute> attribute;
+    switch (constant_pool->attribute_type_at(name_index)) {
+    case AttributeType::ConstantValue:
+        attribute = TRY(ConstantValueAttribute::parse(*this));
+        break;
+
+    case AttributeType::Code:
+        attribute = TRY(CodeAttribute::parse(*this, constant_pool));
+        break;
+
+    case AttributeType::LineNumberTable:
+        attribute = TRY(LineNumberTableAttribute::parse(*this));
+        break;
+
+    case AttributeType::SourceFile:
+        attribute = TRY(SourceFileAttribute::parse(*this));
+        break;
+
+    case AttributeType::StackMapTable:
+        attribute = TRY(StackMapTableAttribute::parse(*this, attribute_length));
+        break;
+
+    case AttributeType::BootstrapMethods:
+        attribute = TRY(BootstrapMethodsAttribute::parse(*this));
+        break;
+
+    case AttributeType::Unknown:
+        // Java Virtual Machine implementations are required to silently ignore attributes that they do not recognize.
+        TRY(this->discard(attribute_length));
+        return nullptr;
     }
-}
 
-ErrorOr<u8> ClassParser::read_u1()
-{
-    return m_stream->read_bits<u8>(8);
-}
+    // The attribute must have consumed exactly attribute_length bytes, otherwise everything after it would be misread
+    if (this->offset() - start_offset != attribute_length)
+        return Error::from_string_literal("Attribute length does not match its contents");
 
-ErrorOr<u16> ClassParser::read_u2()
-{
-    return m_stream->read_bits<u16>(16);
-}
-
-ErrorOr<u32> ClassParser::read_u4()
-{
-    return m_stream->read_bits<u32>(32);
+    return attribute;
 }
 
 }
@@ -7,33 +7,108 @@
 #pragma once
 
 #include "ClassFile.h"
+#include "ClassFileBytes.h"
+#include <AK/ByteBuffer.h>
 #include <AK/NonnullOwnPtr.h>
+#include <AK/Span.h>
 #include <LibCore/File.h>
 
 namespace Parser {
 
 class ClassParser {
 public:
-    ClassParser(NonnullOwnPtr<BigEndianInputBitStream> stream);
+    // Parses the entire storage as a class file
+    ClassParser(NonnullRefPtr<ClassFileBytes> storage);
 
-    static ErrorOr<NonnullOwnPtr<ClassParser>> create(NonnullOwnPtr<Core::File> stream);
+    // Parses a range of bytes within the storage, e.g. a class file within an archive, or the contents of an attribute
+    ClassParser(NonnullRefPtr<ClassFileBytes> storage, ReadonlyBytes bytes);
+
+    // Memory-maps the class file at the path.
+    static ErrorOr<NonnullOwnPtr<ClassParser>> create(StringView path);
+
+    // Reads the entire file into a buffer.
+    static ErrorOr<NonnullOwnPtr<ClassParser>> create(NonnullOwnPtr<Core::File> file);
+
+    // Takes ownership of a buffer containing the bytes of a class file.
+    static ErrorOr<NonnullOwnPtr<ClassParser>> create(ByteBuffer buffer);
 
     ErrorOr<ClassFile> parse();
-    ErrorOr<NonnullRefPtr<Attribute>> parse_attribute(NonnullRefPtr<ConstantPool> const& constant_pool);
+
+    // Returns null for attributes that aren't recognized, they are skipped over
+    ErrorOr<RefPtr<Attribute>> parse_attribute(NonnullRefPtr<ConstantPool> const& constant_pool);
 
     // The JVM spec defines a few data types for unsigned integers, werid naming but sure...
-    ErrorOr<u8> read_u1();
-    ErrorOr<u16> read_u2();
-    ErrorOr<u32> read_u4();
+    // All of them are stored in big-endian order, and are always byte-aligned.
+    ErrorOr<u8> read_u1()
+    {
+        TRY(ensure_available(1));
+        return m_bytes[m_offset++];
+    }
+
+    ErrorOr<u16> read_u2()
+    {
+        TRY(ensure_available(2));
+        auto const* data = m_bytes.data() + m_offset;
+        m_offset += 2;
+
+        return static_cast<u16>((data[0] << 8) | data[1]);
+    }
+
+    ErrorOr<u32> read_u4()
+    {
+        TRY(ensure_available(4));
+        auto const* data = m_bytes.data() + m_offset;
+        m_offset += 4;
+
+        return (static_cast<u32>(data[0]) << 24) | (static_cast<u32>(data[1]) << 16) | (static_cast<u32>(data[2]) << 8) | static_cast<u32>(data[3]);
+    }
+
+    // Returns a view of the next `count` bytes without copying them, they are only valid for as long as the backing storage is.
+    ErrorOr<ReadonlyBytes> read_bytes(size_t count)
+    {
+        TRY(ensure_available(count));
+        auto bytes = m_bytes.slice(m_offset, count);
+        m_offset += count;
 
-    NonnullOwnPtr<BigEndianInputBitStream> const& stream() { return m_stream; };
+        return bytes;
+    }
+
+    // Skips over the next `count` bytes
+    ErrorOr<void> discard(size_t count)
+    {
+        TRY(ensure_available(count));
+        m_offset += count;
+
+        return {};
+    }
+
+    // The current position into the class file, in bytes
+    size_t offset() const { return m_offset; };
+
+    // The entire class file that is being parsed
+    ReadonlyBytes bytes() const { return m_bytes; };
+
+    // The storage that the bytes being parsed point into, lazily-decoded attributes hold onto this
+    NonnullRefPtr<ClassFileBytes> const& storage() const { return m_storage; };
 
 private:
-    ErrorOr<NonnullRefPtr<ConstantClassInfo>> parse_interface(NonnullRefPtr<ConstantPool> const& constant_pool);
+    ErrorOr<void> ensure_available(size_t count) const
+    {
+        if (count > m_bytes.size() - m_offset)
+            return Error::from_string_literal("Unexpected end of class file");
+
+        return {};
+    }
+
+    ErrorOr<u16> parse_interface(NonnullRefPtr<ConstantPool> const& constant_pool);
     ErrorOr<NonnullOwnPtr<FieldInfo>> parse_field(NonnullRefPtr<ConstantPool> const& constant_pool);
     ErrorOr<NonnullOwnPtr<MethodInfo>> parse_method(NonnullRefPtr<ConstantPool> const& constant_pool);
 
-    NonnullOwnPtr<BigEndianInputBitStream> m_stream;
+    // `m_bytes` always points into the storage
+    NonnullRefPtr<ClassFileBytes> m_storage;
+
+    ReadonlyBytes m_bytes;
+    size_t m_offset { 0 };
 };
 
 }
@@ -6,78 +6,111 @@
 
 #include "ConstantInfo.h"
 #include "ClassParser.h"
-#include <AK/BitStream.h>
-#include <AK/NonnullRefPtr.h>
+#include <AK/StringBuilder.h>
 
 namespace Parser {
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.7
-ConstantUTF8Info::ConstantUTF8Info(String data)
-    : ConstantInfo(Constant::Tag::UTF8)
-    , m_data(data)
+ConstantUTF8Info::ConstantUTF8Info(Symbol symbol)
+    : m_symbol(symbol)
 {
 }
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.1
 ConstantClassInfo::ConstantClassInfo(u16 name_index)
-    : ConstantInfo(Constant::Tag::Class)
-    , m_name_index(move(name_index))
+    : m_name_index(name_index)
 {
 }
 
-// // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.2
-ConstantMemberReferenceInfo::ConstantMemberReferenceInfo(Constant::Tag tag, u16 class_index, u16 name_and_type_index)
-    : ConstantInfo(tag)
-    , m_class_index(move(class_index))
-    , m_name_and_type_index(move(name_and_type_index))
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.2
+ConstantMemberReferenceInfo::ConstantMemberReferenceInfo(u16 class_index, u16 name_and_type_index)
+    : m_class_index(class_index)
+    , m_name_and_type_index(name_and_type_index)
 {
 }
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.3
 ConstantStringInfo::ConstantStringInfo(u16 string_index)
-    : ConstantInfo(Constant::Tag::String)
-    , m_index(string_index)
+    : m_index(string_index)
 {
 }
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.4
 ConstantIntegerInfo::ConstantIntegerInfo(u32 value)
-    : ConstantInfo(Constant::Tag::Integer)
-    , m_value(value)
+    : m_value(value)
+{
+}
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.4
+ConstantFloatInfo::ConstantFloatInfo(u32 bytes)
+    : m_bytes(bytes)
+{
+}
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.5
+ConstantLongInfo::ConstantLongInfo(u64 bytes)
+    : m_bytes(bytes)
+{
+}
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.5
+ConstantDoubleInfo::ConstantDoubleInfo(u64 bytes)
+    : m_bytes(bytes)
+{
+}
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.8
+ConstantMethodHandleInfo::ConstantMethodHandleInfo(ReferenceKind reference_kind, u16 reference_index)
+    : m_reference_kind(reference_kind)
+    , m_reference_index(reference_index)
+{
+}
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.9
+ConstantMethodTypeInfo::ConstantMethodTypeInfo(u16 descriptor_index)
+    : m_descriptor_index(descriptor_index)
+{
+}
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.10
+ConstantDynamicInfo::ConstantDynamicInfo(u16 bootstrap_method_attr_index, u16 name_and_type_index)
+    : m_bootstrap_method_attr_index(bootstrap_method_attr_index)
+    , m_name_and_type_index(name_and_type_index)
+{
+}
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.11
+ConstantModuleInfo::ConstantModuleInfo(u16 name_index)
+    : m_name_index(name_index)
 {
 }
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.6
 ConstantNameAndTypeInfo::ConstantNameAndTypeInfo(u16 name_index, u16 descriptor_index)
-    : ConstantInfo(Constant::Tag::NameAndType)
-    , m_name_index(move(name_index))
-    , m_descriptor_index(move(descriptor_index))
+    : m_name_index(name_index)
+    , m_descriptor_index(descriptor_index)
 {
 }
 
-ErrorOr<NonnullRefPtr<ConstantUTF8Info>> ConstantUTF8Info::parse(ClassParser& class_parser)
+ErrorOr<ConstantUTF8Info> ConstantUTF8Info::parse(ClassParser& class_parser)
 {
     // The value of the length item gives the number of bytes in the bytes array (not the length of the resulting string).
     auto length = TRY(class_parser.read_u2());
 
-    // The bytes array contains the bytes of the string.
-    // FIXME: String content is encoded in modified UTF-8.
-    auto buffer = TRY(ByteBuffer::create_uninitialized(length));
-    TRY(class_parser.stream()->read_until_filled(buffer));
-
-    // Convert the bytest to a UTF-8 String
-    auto string = TRY(String::from_utf8(buffer));
-    return try_make_ref_counted<ConstantUTF8Info>(string);
+    // The bytes array contains the bytes of the string, encoded in modified UTF-8.
+    // Identical strings are shared by every class, so they are interned rather than copied.
+    auto bytes = TRY(class_parser.read_bytes(length));
+    return ConstantUTF8Info(TRY(Symbol::intern(StringView { bytes })));
 }
 
-ErrorOr<NonnullRefPtr<ConstantClassInfo>> ConstantClassInfo::parse(ClassParser& class_parser)
+ErrorOr<ConstantClassInfo> ConstantClassInfo::parse(ClassParser& class_parser)
 {
     // u2 name_index;
     auto name_index = TRY(class_parser.read_u2());
-    return try_make_ref_counted<ConstantClassInfo>(name_index);
+    return ConstantClassInfo(name_index);
 }
 
-ErrorOr<NonnullRefPtr<ConstantMemberReferenceInfo>> ConstantMemberReferenceInfo::parse(Constant::Tag tag, ClassParser& class_parser)
+ErrorOr<ConstantMemberReferenceInfo> ConstantMemberReferenceInfo::parse(ClassParser& class_parser)
 {
     // u2 class_index;
     auto class_index = TRY(class_parser.read_u2());
@@ -85,24 +118,93 @@ ErrorOr<NonnullRefPtr<ConstantMemberReferenceInfo>> ConstantMemberReferenceInfo:
     // u2 name_and_type_index;
     auto name_and_type_index = TRY(class_parser.read_u2());
 
-    return try_make_ref_counted<ConstantMemberReferenceInfo>(tag, class_index, name_and_type_index);
+    return ConstantMemberReferenceInfo(class_index, name_and_type_index);
 }
 
-ErrorOr<NonnullRefPtr<ConstantStringInfo>> ConstantStringInfo::parse(ClassParser& class_parser)
+ErrorOr<ConstantStringInfo> ConstantStringInfo::parse(ClassParser& class_parser)
 {
     // u2 string_index;
     auto string_index = TRY(class_parser.read_u2());
-    return try_make_ref_counted<ConstantStringInfo>(string_index);
+    return ConstantStringInfo(string_index);
 }
 
-ErrorOr<NonnullRefPtr<ConstantIntegerInfo>> ConstantIntegerInfo::parse(ClassParser& class_parser)
+ErrorOr<ConstantIntegerInfo> ConstantIntegerInfo::parse(ClassParser& class_parser)
 {
     // u4 bytes;
     auto value = TRY(class_parser.read_u4());
-    return try_make_ref_counted<ConstantIntegerInfo>(value);
+    return ConstantIntegerInfo(value);
 }
 
-ErrorOr<NonnullRefPtr<ConstantNameAndTypeInfo>> ConstantNameAndTypeInfo::parse(ClassParser& class_parser)
+ErrorOr<ConstantFloatInfo> ConstantFloatInfo::parse(ClassParser& class_parser)
+{
+    // u4 bytes;
+    auto bytes = TRY(class_parser.read_u4());
+    return ConstantFloatInfo(bytes);
+}
+
+ErrorOr<ConstantLongInfo> ConstantLongInfo::parse(ClassParser& class_parser)
+{
+    // u4 high_bytes;
+    auto high_bytes = TRY(class_parser.read_u4());
+
+    // u4 low_bytes;
+    auto low_bytes = TRY(class_parser.read_u4());
+
+    return ConstantLongInfo((static_cast<u64>(high_bytes) << 32) | low_bytes);
+}
+
+ErrorOr<ConstantDoubleInfo> ConstantDoubleInfo::parse(ClassParser& class_parser)
+{
+    // u4 high_bytes;
+    auto high_bytes = TRY(class_parser.read_u4());
+
+    // u4 low_bytes;
+    auto low_bytes = TRY(class_parser.read_u4());
+
+    return ConstantDoubleInfo((static_cast<u64>(high_bytes) << 32) | low_bytes);
+}
+
+ErrorOr<ConstantMethodHandleInfo> ConstantMethodHandleInfo::parse(ClassParser& class_parser)
+{
+    // u1 reference_kind;
+    auto reference_kind = TRY(class_parser.read_u1());
+
+    // The value of the reference_kind item must be in the range 1 to 9.
+    if (reference_kind < ReferenceKind::GetField || reference_kind > ReferenceKind::InvokeInterface)
+        return Error::from_string_literal("Invalid method handle reference kind");
+
+    // u2 reference_index;
+    auto reference_index = TRY(class_parser.read_u2());
+
+    return ConstantMethodHandleInfo(static_cast<ReferenceKind>(reference_kind), reference_index);
+}
+
+ErrorOr<ConstantMethodTypeInfo> ConstantMethodTypeInfo::parse(ClassParser& class_parser)
+{
+    // u2 descriptor_index;
+    auto descriptor_index = TRY(class_parser.read_u2());
+    return ConstantMethodTypeInfo(descriptor_index);
+}
+
+ErrorOr<ConstantDynamicInfo> ConstantDynamicInfo::parse(ClassParser& class_parser)
+{
+    // u2 bootstrap_method_attr_index;
+    auto bootstrap_method_attr_index = TRY(class_parser.read_u2());
+
+    // u2 name_and_type_index;
+    auto name_and_type_index = TRY(class_parser.read_u2());
+
+    return ConstantDynamicInfo(bootstrap_method_attr_index, name_and_type_index);
+}
+
+ErrorOr<ConstantModuleInfo> ConstantModuleInfo::parse(ClassParser& class_parser)
+{
+    // u2 name_index;
+    auto name_index = TRY(class_parser.read_u2());
+    return ConstantModuleInfo(name_index);
+}
+
+ErrorOr<ConstantNameAndTypeInfo> ConstantNameAndTypeInfo::parse(ClassParser& class_parser)
 {
     // u2 name_index;
     auto name_index = TRY(class_parser.read_u2());
@@ -110,10 +212,10 @@ ErrorOr<NonnullRefPtr<ConstantNameAndTypeInfo>> ConstantNameAndTypeInfo::parse(C
     // u2 descriptor_index;
     auto descriptor_index = TRY(class_parser.read_u2());
 
-    return try_make_ref_counted<ConstantNameAndTypeInfo>(name_index, descriptor_index);
+    return ConstantNameAndTypeInfo(name_index, descriptor_index);
 }
 
-ErrorOr<String> ConstantUTF8Info::debug_description()
+ErrorOr<String> ConstantUTF8Info::debug_description() const
 {
     StringBuilder builder;
 
@@ -124,7 +226,7 @@ ErrorOr<String> ConstantUTF8Info::debug_description()
     return builder.to_string();
 }
 
-ErrorOr<String> ConstantClassInfo::debug_description()
+ErrorOr<String> ConstantClassInfo::debug_description() const
 {
     StringBuilder builder;
 
@@ -135,7 +237,7 @@ ErrorOr<String> ConstantClassInfo::debug_description()
     return builder.to_string();
 }
 
-ErrorOr<String> ConstantMemberReferenceInfo::debug_description()
+ErrorOr<String> ConstantMemberReferenceInfo::debug_description() const
 {
     StringBuilder builder;
 
@@ -147,7 +249,7 @@ ErrorOr<String> ConstantMemberReferenceInfo::debug_description()
     return builder.to_string();
 }
 
-ErrorOr<String> ConstantStringInfo::debug_description()
+ErrorOr<String> ConstantStringInfo::debug_description() const
 {
     StringBuilder builder;
 
@@ -158,7 +260,7 @@ ErrorOr<String> ConstantStringInfo::debug_description()
     return builder.to_string();
 }
 
-ErrorOr<String> ConstantIntegerInfo::debug_description()
+ErrorOr<String> ConstantIntegerInfo::debug_description() const
 {
     StringBuilder builder;
 
@@ -169,7 +271,7 @@ ErrorOr<String> ConstantIntegerInfo::debug_description()
     return builder.to_string();
 }
 
-ErrorOr<String> ConstantNameAndTypeInfo::debug_description()
+ErrorOr<String> ConstantNameAndTypeInfo::debug_description() const
 {
     StringBuilder builder;
 
@@ -181,4 +283,83 @@ ErrorOr<String> ConstantNameAndTypeInfo::debug_description()
     return builder.to_string();
 }
 
+ErrorOr<String> ConstantFloatInfo::debug_description() const
+{
+    StringBuilder builder;
+
+    builder.append("Float { "sv);
+    builder.appendff("{}", value());
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
+ErrorOr<String> ConstantLongInfo::debug_description() const
+{
+    StringBuilder builder;
+
+    builder.append("Long { "sv);
+    builder.appendff("{}", value());
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
+ErrorOr<String> ConstantDoubleInfo::debug_description() const
+{
+    StringBuilder builder;
+
+    builder.append("Double { "sv);
+    builder.appendff("{}", value());
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
+ErrorOr<String> ConstantMethodHandleInfo::debug_description() const
+{
+    StringBuilder builder;
+
+    builder.append("MethodHandle { "sv);
+    builder.appendff("reference_kind = {}, ", to_underlying(reference_kind()));
+    builder.appendff("reference_index = {}", reference_index());
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
+ErrorOr<String> ConstantMethodTypeInfo::debug_description() const
+{
+    StringBuilder builder;
+
+    builder.append("MethodType { "sv);
+    builder.appendff("descriptor_index = {}", descriptor_index());
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
+ErrorOr<String> ConstantDynamicInfo::debug_description() const
+{
+    StringBuilder builder;
+
+    builder.append("Dynamic { "sv);
+    builder.appendff("bootstrap_method_attr_index = {}, ", bootstrap_method_attr_index());
+    builder.appendff("name_and_type_index = {}", name_and_type_index());
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
+ErrorOr<String> ConstantModuleInfo::debug_description() const
+{
+    StringBuilder builder;
+
+    builder.append("Module { "sv);
+    builder.appendff("name_index = {}", name_index());
+    builder.append(" }"sv);
+
+    return builder.to_string();
+}
+
 }
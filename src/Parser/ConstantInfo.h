@@ -7,57 +7,51 @@
 #pragma once
 
 #include "../ConstantTag.h"
+#include "../Symbol.h"
 #include "ConstantPool.h"
+#include <AK/BitCast.h>
 #include <AK/String.h>
+#include <AK/StringView.h>
 
 namespace Parser {
 
 // Forward declaration
 class ClassParser;
 
-class ConstantInfo : public RefCounted<ConstantInfo> {
-public:
-    virtual ~ConstantInfo() = default;
-
-    Constant::Tag const& tag() { return m_tag; };
-
-    virtual ErrorOr<String> debug_description() = 0;
-
-protected:
-    ConstantInfo(Constant::Tag tag)
-        : m_tag(tag)
-    {
-    }
-
-private:
-    Constant::Tag m_tag;
-};
+// The ConstantPool does not store these structures directly, it stores a tag and a fixed-width u64 payload per slot.
+// These are lightweight views which are decoded from (and encoded to) that payload whenever they're needed.
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.7
-class ConstantUTF8Info : public ConstantInfo {
+class ConstantUTF8Info {
 public:
-    ConstantUTF8Info(String data);
+    ConstantUTF8Info(Symbol symbol);
 
-    static ErrorOr<NonnullRefPtr<ConstantUTF8Info>> parse(ClassParser& class_parser);
+    static ErrorOr<ConstantUTF8Info> parse(ClassParser& class_parser);
+    static ConstantUTF8Info from_payload(u64 payload) { return ConstantUTF8Info(Symbol::from_bits(payload)); };
+    u64 payload() const { return m_symbol.bits(); };
 
-    ErrorOr<String> debug_description();
+    ErrorOr<String> debug_description() const;
 
-    String const& data() { return m_data; };
+    // The bytes are interned in the global symbol table, so they are valid for the lifetime of the process.
+    Symbol const& symbol() const { return m_symbol; };
+    StringView data() const { return m_symbol.view(); };
 
 private:
-    String m_data;
+    Symbol m_symbol;
 };
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.1
-class ConstantClassInfo : public ConstantInfo {
+class ConstantClassInfo {
 public:
     ConstantClassInfo(u16 name_index);
 
-    static ErrorOr<NonnullRefPtr<ConstantClassInfo>> parse(ClassParser& class_parser);
+    static ErrorOr<ConstantClassInfo> parse(ClassParser& class_parser);
+    static ConstantClassInfo from_payload(u64 payload) { return ConstantClassInfo(payload); };
+    u64 payload() const { return m_name_index; };
 
-    ErrorOr<String> debug_description();
+    ErrorOr<String> debug_description() const;
 
-    u16 name_index() { return m_name_index; };
+    u16 name_index() const { return m_name_index; };
 
 private:
     // The value of the name_index item must be a valid index into the constant_pool table.
@@ -65,16 +59,18 @@ private:
 };
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.2
-class ConstantMemberReferenceInfo : public ConstantInfo {
+class ConstantMemberReferenceInfo {
 public:
-    ConstantMemberReferenceInfo(Constant::Tag tag, u16 name_index, u16 descriptor_index);
+    ConstantMemberReferenceInfo(u16 class_index, u16 name_and_type_index);
 
-    static ErrorOr<NonnullRefPtr<ConstantMemberReferenceInfo>> parse(Constant::Tag tag, ClassParser& class_parser);
+    static ErrorOr<ConstantMemberReferenceInfo> parse(ClassParser& class_parser);
+    static ConstantMemberReferenceInfo from_payload(u64 payload) { return ConstantMemberReferenceInfo(payload >> 16, payload & 0xFFFF); };
+    u64 payload() const { return (static_cast<u64>(m_class_index) << 16) | m_name_and_type_index; };
 
-    ErrorOr<String> debug_description();
+    ErrorOr<String> debug_description() const;
 
-    u16 class_index() { return m_class_index; };
-    u16 name_and_type_index() { return m_name_and_type_index; };
+    u16 class_index() const { return m_class_index; };
+    u16 name_and_type_index() const { return m_name_and_type_index; };
 
 private:
     // The constant_pool entry at that index must be a CONSTANT_Class_info structure (§4.4.1) representing a class or interface type that has the field or method as a member.
@@ -84,53 +80,117 @@ private:
     u16 m_name_and_type_index;
 };
 
-class ConstantFieldReferenceInfo : public ConstantMemberReferenceInfo {
-};
-
-class ConstantMethodReferenceInfo : public ConstantMemberReferenceInfo {
-};
+using ConstantFieldReferenceInfo = ConstantMemberReferenceInfo;
+using ConstantMethodReferenceInfo = ConstantMemberReferenceInfo;
+using ConstantInterfaceMethodReferenceInfo = ConstantMemberReferenceInfo;
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.3
-class ConstantStringInfo : public ConstantInfo {
+class ConstantStringInfo {
 public:
     ConstantStringInfo(u16 string_index);
 
-    static ErrorOr<NonnullRefPtr<ConstantStringInfo>> parse(ClassParser& class_parser);
+    static ErrorOr<ConstantStringInfo> parse(ClassParser& class_parser);
+    static ConstantStringInfo from_payload(u64 payload) { return ConstantStringInfo(payload); };
+    u64 payload() const { return m_index; };
 
-    ErrorOr<String> debug_description();
+    ErrorOr<String> debug_description() const;
 
-    u16 index() { return m_index; };
+    u16 index() const { return m_index; };
 
 private:
     u16 m_index;
 };
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.4
-class ConstantIntegerInfo : public ConstantInfo {
+class ConstantIntegerInfo {
 public:
     ConstantIntegerInfo(u32 value);
 
-    static ErrorOr<NonnullRefPtr<ConstantIntegerInfo>> parse(ClassParser& class_parser);
+    static ErrorOr<ConstantIntegerInfo> parse(ClassParser& class_parser);
+    static ConstantIntegerInfo from_payload(u64 payload) { return ConstantIntegerInfo(payload); };
+    u64 payload() const { return m_value; };
 
-    ErrorOr<String> debug_description();
+    ErrorOr<String> debug_description() const;
 
-    u32 value() { return m_value; };
+    u32 value() const { return m_value; };
 
 private:
     u32 m_value;
 };
 
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.4
+class ConstantFloatInfo {
+public:
+    ConstantFloatInfo(u32 bytes);
+
+    static ErrorOr<ConstantFloatInfo> parse(ClassParser& class_parser);
+    static ConstantFloatInfo from_payload(u64 payload) { return ConstantFloatInfo(payload); };
+    u64 payload() const { return m_bytes; };
+
+    ErrorOr<String> debug_description() const;
+
+    // The value in IEEE 754 binary32 floating-point format
+    u32 bytes() const { return m_bytes; };
+    float value() const { return bit_cast<float>(m_bytes); };
+
+private:
+    u32 m_bytes;
+};
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.5
+//
+// All 8-byte constants take up two entries in the constant_pool table, the slot after this one is unusable.
+class ConstantLongInfo {
+public:
+    ConstantLongInfo(u64 bytes);
+
+    static ErrorOr<ConstantLongInfo> parse(ClassParser& class_parser);
+    static ConstantLongInfo from_payload(u64 payload) { return ConstantLongInfo(payload); };
+    u64 payload() const { return m_bytes; };
+
+    ErrorOr<String> debug_description() const;
+
+    u64 bytes() const { return m_bytes; };
+    i64 value() const { return static_cast<i64>(m_bytes); };
+
+private:
+    u64 m_bytes;
+};
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.5
+//
+// All 8-byte constants take up two entries in the constant_pool table, the slot after this one is unusable.
+class ConstantDoubleInfo {
+public:
+    ConstantDoubleInfo(u64 bytes);
+
+    static ErrorOr<ConstantDoubleInfo> parse(ClassParser& class_parser);
+    static ConstantDoubleInfo from_payload(u64 payload) { return ConstantDoubleInfo(payload); };
+    u64 payload() const { return m_bytes; };
+
+    ErrorOr<String> debug_description() const;
+
+    // The value in IEEE 754 binary64 floating-point format
+    u64 bytes() const { return m_bytes; };
+    double value() const { return bit_cast<double>(m_bytes); };
+
+private:
+    u64 m_bytes;
+};
+
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.6
-class ConstantNameAndTypeInfo : public ConstantInfo {
+class ConstantNameAndTypeInfo {
 public:
     ConstantNameAndTypeInfo(u16 name_index, u16 descriptor_index);
 
-    static ErrorOr<NonnullRefPtr<ConstantNameAndTypeInfo>> parse(ClassParser& class_parser);
+    static ErrorOr<ConstantNameAndTypeInfo> parse(ClassParser& class_parser);
+    static ConstantNameAndTypeInfo from_payload(u64 payload) { return ConstantNameAndTypeInfo(payload >> 16, payload & 0xFFFF); };
+    u64 payload() const { return (static_cast<u64>(m_name_index) << 16) | m_descriptor_index; };
 
-    ErrorOr<String> debug_description();
+    ErrorOr<String> debug_description() const;
 
-    u16 name_index() { return m_name_index; };
-    u16 descriptor_index() { return m_descriptor_index; };
+    u16 name_index() const { return m_name_index; };
+    u16 descriptor_index() const { return m_descriptor_index; };
 
 private:
     // The constant_pool entry at that index must be a CONSTANT_Utf8_info structure (§4.4.7) representing either a valid unqualified name denoting a field or method (§4.2.2), or the special method name <init> (§2.9.1).
@@ -140,4 +200,103 @@ private:
     u16 m_descriptor_index;
 };
 
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.8
+class ConstantMethodHandleInfo {
+public:
+    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.4.3.5
+    enum ReferenceKind : u8 {
+        GetField = 1,
+        GetStatic = 2,
+        PutField = 3,
+        PutStatic = 4,
+        InvokeVirtual = 5,
+        InvokeStatic = 6,
+        InvokeSpecial = 7,
+        NewInvokeSpecial = 8,
+        InvokeInterface = 9,
+    };
+
+    ConstantMethodHandleInfo(ReferenceKind reference_kind, u16 reference_index);
+
+    static ErrorOr<ConstantMethodHandleInfo> parse(ClassParser& class_parser);
+    static ConstantMethodHandleInfo from_payload(u64 payload) { return ConstantMethodHandleInfo(static_cast<ReferenceKind>(payload >> 16), payload & 0xFFFF); };
+    u64 payload() const { return (static_cast<u64>(m_reference_kind) << 16) | m_reference_index; };
+
+    ErrorOr<String> debug_description() const;
+
+    ReferenceKind reference_kind() const { return m_reference_kind; };
+    u16 reference_index() const { return m_reference_index; };
+
+private:
+    // Denotes the kind of this method handle, which characterizes its bytecode behavior.
+    ReferenceKind m_reference_kind;
+
+    // Depending on the reference kind, the entry at this index must be a field, method or interface method reference.
+    u16 m_reference_index;
+};
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.9
+class ConstantMethodTypeInfo {
+public:
+    ConstantMethodTypeInfo(u16 descriptor_index);
+
+    static ErrorOr<ConstantMethodTypeInfo> parse(ClassParser& class_parser);
+    static ConstantMethodTypeInfo from_payload(u64 payload) { return ConstantMethodTypeInfo(payload); };
+    u64 payload() const { return m_descriptor_index; };
+
+    ErrorOr<String> debug_description() const;
+
+    u16 descriptor_index() const { return m_descriptor_index; };
+
+private:
+    // The constant_pool entry at that index must be a CONSTANT_Utf8_info structure (§4.4.7) representing a method descriptor (§4.3.3).
+    u16 m_descriptor_index;
+};
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.10
+//
+// Used for both CONSTANT_Dynamic_info and CONSTANT_InvokeDynamic_info, which share the same structure.
+class ConstantDynamicInfo {
+public:
+    ConstantDynamicInfo(u16 bootstrap_method_attr_index, u16 name_and_type_index);
+
+    static ErrorOr<ConstantDynamicInfo> parse(ClassParser& class_parser);
+    static ConstantDynamicInfo from_payload(u64 payload) { return ConstantDynamicInfo(payload >> 16, payload & 0xFFFF); };
+    u64 payload() const { return (static_cast<u64>(m_bootstrap_method_attr_index) << 16) | m_name_and_type_index; };
+
+    ErrorOr<String> debug_description() const;
+
+    u16 bootstrap_method_attr_index() const { return m_bootstrap_method_attr_index; };
+    u16 name_and_type_index() const { return m_name_and_type_index; };
+
+private:
+    // A valid index into the bootstrap_methods array of the bootstrap method table of this class file (§4.7.23).
+    u16 m_bootstrap_method_attr_index;
+
+    // The constant_pool entry at that index must be a CONSTANT_NameAndType_info structure (§4.4.6).
+    u16 m_name_and_type_index;
+};
+
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.11
+//
+// Used for both CONSTANT_Module_info and CONSTANT_Package_info, which share the same structure.
+class ConstantModuleInfo {
+public:
+    ConstantModuleInfo(u16 name_index);
+
+    static ErrorOr<ConstantModuleInfo> parse(ClassParser& class_parser);
+    static ConstantModuleInfo from_payload(u64 payload) { return ConstantModuleInfo(payload); };
+    u64 payload() const { return m_name_index; };
+
+    ErrorOr<String> debug_description() const;
+
+    u16 name_index() const { return m_name_index; };
+
+private:
+    // The constant_pool entry at that index must be a CONSTANT_Utf8_info structure (§4.4.7) representing a valid module or package name.
+    u16 m_name_index;
+};
+
+using ConstantPackageInfo = ConstantModuleInfo;
+
 }
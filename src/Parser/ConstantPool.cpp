@@ -7,124 +7,290 @@
 #include "ConstantPool.h"
 #include "ClassParser.h"
 #include "ConstantInfo.h"
-#include <AK/BitStream.h>
 #include <AK/String.h>
 
 namespace Parser {
 
 ErrorOr<NonnullRefPtr<ConstantPool>> ConstantPool::parse(u16 size, ClassParser& class_parser)
 {
-    auto entries = Vector<NonnullRefPtr<ConstantInfo>>();
+    // The constant_pool table is indexed from 1 to constant_pool_count - 1, slot 0 is left empty.
+    auto tags = Vector<u8>();
+    auto payloads = Vector<u64>();
+    auto attribute_types = Vector<AttributeType>();
+    TRY(tags.try_ensure_capacity(size + 1));
+    TRY(payloads.try_ensure_capacity(size + 1));
+    TRY(attribute_types.try_ensure_capacity(size + 1));
+
+    tags.unchecked_append(0);
+    payloads.unchecked_append(0);
+    attribute_types.unchecked_append(AttributeType::Unknown);
 
     for (int i = 0; i < size; i++) {
-        // The constant_pool table is indexed from 1 to constant_pool_count - 1.
         auto pool_index = i + 1;
         auto tag = TRY(class_parser.read_u1());
 
+        u64 payload = 0;
+        auto attribute_type = AttributeType::Unknown;
         switch (tag) {
-        case Constant::Tag::FieldReference: {
-            entries.append(TRY(ConstantMemberReferenceInfo::parse(Constant::Tag::FieldReference, class_parser)));
-            break;
-        }
-
-        case Constant::Tag::MethodReference: {
-            entries.append(TRY(ConstantMemberReferenceInfo::parse(Constant::Tag::MethodReference, class_parser)));
+        case Constant::Tag::FieldReference:
+        case Constant::Tag::MethodReference:
+        case Constant::Tag::InterfaceMethodReference: {
+            payload = TRY(ConstantMemberReferenceInfo::parse(class_parser)).payload();
             break;
         }
 
         case Constant::Tag::Class: {
-            entries.append(TRY(ConstantClassInfo::parse(class_parser)));
+            payload = TRY(ConstantClassInfo::parse(class_parser)).payload();
             break;
         }
 
         case Constant::Tag::NameAndType: {
-            entries.append(TRY(ConstantNameAndTypeInfo::parse(class_parser)));
+            payload = TRY(ConstantNameAndTypeInfo::parse(class_parser)).payload();
             break;
         }
 
         case Constant::Tag::UTF8: {
-            entries.append(TRY(ConstantUTF8Info::parse(class_parser)));
+            auto utf8_info = TRY(ConstantUTF8Info::parse(class_parser));
+            payload = utf8_info.payload();
+            attribute_type = attribute_type_from_name(utf8_info.symbol());
             break;
         }
 
         case Constant::Tag::String: {
-            entries.append(TRY(ConstantStringInfo::parse(class_parser)));
+            payload = TRY(ConstantStringInfo::parse(class_parser)).payload();
             break;
         }
 
         case Constant::Tag::Integer: {
-            entries.append(TRY(ConstantIntegerInfo::parse(class_parser)));
+            payload = TRY(ConstantIntegerInfo::parse(class_parser)).payload();
+            break;
+        }
+
+        case Constant::Tag::Float: {
+            payload = TRY(ConstantFloatInfo::parse(class_parser)).payload();
+            break;
+        }
+
+        case Constant::Tag::Long: {
+            payload = TRY(ConstantLongInfo::parse(class_parser)).payload();
+            break;
+        }
+
+        case Constant::Tag::Double: {
+            payload = TRY(ConstantDoubleInfo::parse(class_parser)).payload();
+            break;
+        }
+
+        case Constant::Tag::MethodHandle: {
+            payload = TRY(ConstantMethodHandleInfo::parse(class_parser)).payload();
+            break;
+        }
+
+        case Constant::Tag::MethodType: {
+            payload = TRY(ConstantMethodTypeInfo::parse(class_parser)).payload();
+            break;
+        }
+
+        case Constant::Tag::Dynamic:
+        case Constant::Tag::InvokeDynamic: {
+            payload = TRY(ConstantDynamicInfo::parse(class_parser)).payload();
+            break;
+        }
+
+        case Constant::Tag::Module:
+        case Constant::Tag::Package: {
+            payload = TRY(ConstantModuleInfo::parse(class_parser)).payload();
             break;
         }
 
         default: {
-            dbgln("Unimplemented tag @ {}: {}", pool_index, tag);
-            TODO();
+            dbgln("Invalid tag @ {}: {}", pool_index, tag);
+            return Error::from_string_literal("Invalid constant pool tag");
         }
         }
+
+        tags.unchecked_append(tag);
+        payloads.unchecked_append(payload);
+        attribute_types.unchecked_append(attribute_type);
+
+        // If a CONSTANT_Long_info or CONSTANT_Double_info structure is the entry at index n in the constant_pool table,
+        // then the next usable entry in the table is located at index n+2. The index n+1 must be valid but is considered unusable.
+        if (tag == Constant::Tag::Long || tag == Constant::Tag::Double) {
+            if (pool_index + 1 > size)
+                return Error::from_string_literal("8-byte constant is missing its second slot");
+
+            tags.unchecked_append(Constant::Tag::Unusable);
+            payloads.unchecked_append(0);
+            attribute_types.unchecked_append(AttributeType::Unknown);
+            i++;
+        }
     }
 
-    return try_make_ref_counted<ConstantPool>(move(entries));
+    return try_make_ref_counted<ConstantPool>(move(tags), move(payloads), move(attribute_types));
 }
 
 // Attempts to read a method reference from the constant pool
-ErrorOr<NonnullRefPtr<ConstantMethodReferenceInfo>> ConstantPool::method_reference_at(u16 index)
+ErrorOr<ConstantMemberReferenceInfo> ConstantPool::method_reference_at(u16 index) const
 {
-    // The value of the `index` item must be a valid index into the constant_pool table.
-    auto const& entry = entries().at(index - 1);
-
     // The constant_pool entry at that index must be a CONSTANT_Methodref_info structure.
-    VERIFY(entry->tag() == Constant::Tag::MethodReference);
-
-    return static_cast<Parser::ConstantMethodReferenceInfo&>(*entry);
+    return ConstantMemberReferenceInfo::from_payload(payload_at(index, Constant::Tag::MethodReference));
 }
 
 // Attempts to read a field reference from the constant pool
-ErrorOr<NonnullRefPtr<ConstantFieldReferenceInfo>> ConstantPool::field_reference_at(u16 index)
+ErrorOr<ConstantMemberReferenceInfo> ConstantPool::field_reference_at(u16 index) const
 {
-    // The value of the `index` item must be a valid index into the constant_pool table.
-    auto const& entry = entries().at(index - 1);
-
     // The constant_pool entry at that index must be a CONSTANT_Fieldref_info structure.
-    VERIFY(entry->tag() == Constant::Tag::FieldReference);
-
-    return static_cast<Parser::ConstantFieldReferenceInfo&>(*entry);
+    return ConstantMemberReferenceInfo::from_payload(payload_at(index, Constant::Tag::FieldReference));
 }
 
-// Attempts to read a method reference from the constant pool
-ErrorOr<NonnullRefPtr<ConstantNameAndTypeInfo>> ConstantPool::name_and_type_at(u16 index)
+// Attempts to read an interface method reference from the constant pool
+ErrorOr<ConstantMemberReferenceInfo> ConstantPool::interface_method_reference_at(u16 index) const
 {
-    // The value of the `index` item must be a valid index into the constant_pool table.
-    auto const& entry = entries().at(index - 1);
+    // The constant_pool entry at that index must be a CONSTANT_InterfaceMethodref_info structure.
+    return ConstantMemberReferenceInfo::from_payload(payload_at(index, Constant::Tag::InterfaceMethodReference));
+}
 
+// Attempts to read a name and type from the constant pool
+ErrorOr<ConstantNameAndTypeInfo> ConstantPool::name_and_type_at(u16 index) const
+{
     // The constant_pool entry at that index must be a CONSTANT_NameAndType_info structure.
-    VERIFY(entry->tag() == Constant::Tag::NameAndType);
-
-    return static_cast<Parser::ConstantNameAndTypeInfo&>(*entry);
+    return ConstantNameAndTypeInfo::from_payload(payload_at(index, Constant::Tag::NameAndType));
 }
 
 // Attempts to read a utf8 constant from the constant pool
-ErrorOr<NonnullRefPtr<ConstantUTF8Info>> ConstantPool::utf8_at(u16 index)
+ErrorOr<ConstantUTF8Info> ConstantPool::utf8_at(u16 index) const
 {
-    // The value of the `index` item must be a valid index into the constant_pool table.
-    auto const& entry = entries().at(index - 1);
-
     // The constant_pool entry at that index must be a CONSTANT_UTF8_info structure.
-    VERIFY(entry->tag() == Constant::Tag::UTF8);
-
-    return static_cast<Parser::ConstantUTF8Info&>(*entry);
+    return ConstantUTF8Info::from_payload(payload_at(index, Constant::Tag::UTF8));
 }
 
 // Attempts to read a class' information from the constant pool
-ErrorOr<NonnullRefPtr<ConstantClassInfo>> ConstantPool::class_at(u16 index)
+ErrorOr<ConstantClassInfo> ConstantPool::class_at(u16 index) const
 {
-    // The value of the `index` item must be a valid index into the constant_pool table.
-    auto const& entry = entries().at(index - 1);
-
     // The constant_pool entry at that index must be a CONSTANT_Class_info structure.
-    VERIFY(entry->tag() == Constant::Tag::Class);
+    return ConstantClassInfo::from_payload(payload_at(index, Constant::Tag::Class));
+}
+
+// Attempts to read a string constant from the constant pool
+ErrorOr<ConstantStringInfo> ConstantPool::string_at(u16 index) const
+{
+    // The constant_pool entry at that index must be a CONSTANT_String_info structure.
+    return ConstantStringInfo::from_payload(payload_at(index, Constant::Tag::String));
+}
+
+// Attempts to read an integer constant from the constant pool
+ErrorOr<ConstantIntegerInfo> ConstantPool::integer_at(u16 index) const
+{
+    // The constant_pool entry at that index must be a CONSTANT_Integer_info structure.
+    return ConstantIntegerInfo::from_payload(payload_at(index, Constant::Tag::Integer));
+}
+
+// Attempts to read a float constant from the constant pool
+ErrorOr<ConstantFloatInfo> ConstantPool::float_at(u16 index) const
+{
+    // The constant_pool entry at that index must be a CONSTANT_Float_info structure.
+    return ConstantFloatInfo::from_payload(payload_at(index, Constant::Tag::Float));
+}
+
+// Attempts to read a long constant from the constant pool
+ErrorOr<ConstantLongInfo> ConstantPool::long_at(u16 index) const
+{
+    // The constant_pool entry at that index must be a CONSTANT_Long_info structure.
+    return ConstantLongInfo::from_payload(payload_at(index, Constant::Tag::Long));
+}
+
+// Attempts to read a double constant from the constant pool
+ErrorOr<ConstantDoubleInfo> ConstantPool::double_at(u16 index) const
+{
+    // The constant_pool entry at that index must be a CONSTANT_Double_info structure.
+    return ConstantDoubleInfo::from_payload(payload_at(index, Constant::Tag::Double));
+}
+
+// Attempts to read a method handle from the constant pool
+ErrorOr<ConstantMethodHandleInfo> ConstantPool::method_handle_at(u16 index) const
+{
+    // The constant_pool entry at that index must be a CONSTANT_MethodHandle_info structure.
+    return ConstantMethodHandleInfo::from_payload(payload_at(index, Constant::Tag::MethodHandle));
+}
+
+// Attempts to read a method type from the constant pool
+ErrorOr<ConstantMethodTypeInfo> ConstantPool::method_type_at(u16 index) const
+{
+    // The constant_pool entry at that index must be a CONSTANT_MethodType_info structure.
+    return ConstantMethodTypeInfo::from_payload(payload_at(index, Constant::Tag::MethodType));
+}
+
+// Attempts to read a dynamically-computed constant from the constant pool
+ErrorOr<ConstantDynamicInfo> ConstantPool::dynamic_at(u16 index) const
+{
+    // The constant_pool entry at that index must be a CONSTANT_Dynamic_info structure.
+    return ConstantDynamicInfo::from_payload(payload_at(index, Constant::Tag::Dynamic));
+}
+
+// Attempts to read a dynamically-computed call site from the constant pool
+ErrorOr<ConstantDynamicInfo> ConstantPool::invoke_dynamic_at(u16 index) const
+{
+    // The constant_pool entry at that index must be a CONSTANT_InvokeDynamic_info structure.
+    return ConstantDynamicInfo::from_payload(payload_at(index, Constant::Tag::InvokeDynamic));
+}
+
+// Attempts to read a module from the constant pool
+ErrorOr<ConstantModuleInfo> ConstantPool::module_at(u16 index) const
+{
+    // The constant_pool entry at that index must be a CONSTANT_Module_info structure.
+    return ConstantModuleInfo::from_payload(payload_at(index, Constant::Tag::Module));
+}
+
+// Attempts to read a package from the constant pool
+ErrorOr<ConstantModuleInfo> ConstantPool::package_at(u16 index) const
+{
+    // The constant_pool entry at that index must be a CONSTANT_Package_info structure.
+    return ConstantModuleInfo::from_payload(payload_at(index, Constant::Tag::Package));
+}
+
+// Used for debugging
+ErrorOr<String> ConstantPool::debug_description_at(u16 index) const
+{
+    switch (tag_at(index)) {
+    case Constant::Tag::Unusable:
+        return String::from_utf8("Unusable { }"sv);
+    case Constant::Tag::UTF8:
+        return TRY(utf8_at(index)).debug_description();
+    case Constant::Tag::Integer:
+        return TRY(integer_at(index)).debug_description();
+    case Constant::Tag::Class:
+        return TRY(class_at(index)).debug_description();
+    case Constant::Tag::String:
+        return TRY(string_at(index)).debug_description();
+    case Constant::Tag::FieldReference:
+        return TRY(field_reference_at(index)).debug_description();
+    case Constant::Tag::MethodReference:
+        return TRY(method_reference_at(index)).debug_description();
+    case Constant::Tag::InterfaceMethodReference:
+        return TRY(interface_method_reference_at(index)).debug_description();
+    case Constant::Tag::NameAndType:
+        return TRY(name_and_type_at(index)).debug_description();
+    case Constant::Tag::Float:
+        return TRY(float_at(index)).debug_description();
+    case Constant::Tag::Long:
+        return TRY(long_at(index)).debug_description();
+    case Constant::Tag::Double:
+        return TRY(double_at(index)).debug_description();
+    case Constant::Tag::MethodHandle:
+        return TRY(method_handle_at(index)).debug_description();
+    case Constant::Tag::MethodType:
+        return TRY(method_type_at(index)).debug_description();
+    case Constant::Tag::Dynamic:
+        return TRY(dynamic_at(index)).debug_description();
+    case Constant::Tag::InvokeDynamic:
+        return TRY(invoke_dynamic_at(index)).debug_description();
+    case Constant::Tag::Module:
+        return TRY(module_at(index)).debug_description();
+    case Constant::Tag::Package:
+        return TRY(package_at(index)).debug_description();
+    }
 
-    return static_cast<Parser::ConstantClassInfo&>(*entry);
+    VERIFY_NOT_REACHED();
 }
 
 }
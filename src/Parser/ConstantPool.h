@@ -6,52 +6,143 @@
 
 #pragma once
 
+#include "../ConstantTag.h"
+#include "Attribute.h"
 #include <AK/Forward.h>
-#include <AK/NonnullOwnPtr.h>
+#include <AK/RefCounted.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 
 namespace Parser {
 
 // Forward-declaration
-class ConstantInfo;
 class ClassParser;
 
-class ConstantMethodReferenceInfo;
+class ConstantMemberReferenceInfo;
 class ConstantNameAndTypeInfo;
 class ConstantUTF8Info;
 class ConstantClassInfo;
-class ConstantFieldReferenceInfo;
+class ConstantStringInfo;
+class ConstantIntegerInfo;
+class ConstantFloatInfo;
+class ConstantLongInfo;
+class ConstantDoubleInfo;
+class ConstantMethodHandleInfo;
+class ConstantMethodTypeInfo;
+class ConstantDynamicInfo;
+class ConstantModuleInfo;
 
 // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4
+//
+// The constant pool is stored as a flat table, instead of an object per entry:
+// - A tag per slot, identifying the type of the constant at that index
+// - A fixed-width payload per slot, which the Constant*Info classes know how to decode
+//
+// UTF8 constants are interned into the global symbol table, their payload is the Symbol itself.
+//
+// Both tables are indexed directly by the (1-indexed) constant pool index, slot 0 is never valid.
+// Long and Double constants take up two slots, the second slot is tagged as Unusable so that indices stay direct.
+//
+// Every UTF8 constant is also classified as an attribute name once, when the pool is parsed.
+// Attributes refer to their name by index, so dispatching on an attribute is then a single table lookup.
 class ConstantPool : public RefCounted<ConstantPool> {
 public:
-    ConstantPool(Vector<NonnullRefPtr<ConstantInfo>> entries)
-        : m_entries(move(entries))
+    ConstantPool(Vector<u8> tags, Vector<u64> payloads, Vector<AttributeType> attribute_types)
+        : m_tags(move(tags))
+        , m_payloads(move(payloads))
+        , m_attribute_types(move(attribute_types))
     {
     }
 
     static ErrorOr<NonnullRefPtr<ConstantPool>> parse(u16 size, ClassParser& class_parser);
 
-    Vector<NonnullRefPtr<ConstantInfo>> const& entries() { return m_entries; };
+    // The number of slots in the constant pool table, this is equal to constant_pool_count
+    u16 size() const { return m_tags.size(); };
+
+    // Whether the index points at a slot in the constant pool table
+    bool is_valid_index(u16 index) const { return index != 0 && index < m_tags.size(); };
+
+    // Returns the tag of the constant at the index
+    Constant::Tag tag_at(u16 index) const
+    {
+        // The value of the `index` item must be a valid index into the constant_pool table.
+        VERIFY(is_valid_index(index));
+        return static_cast<Constant::Tag>(m_tags[index]);
+    }
 
     // Attempts to read a method reference from the constant pool
-    ErrorOr<NonnullRefPtr<ConstantMethodReferenceInfo>> method_reference_at(u16 index);
+    ErrorOr<ConstantMemberReferenceInfo> method_reference_at(u16 index) const;
 
     // Attempts to read a field reference from the constant pool
-    ErrorOr<NonnullRefPtr<ConstantFieldReferenceInfo>> field_reference_at(u16 index);
+    ErrorOr<ConstantMemberReferenceInfo> field_reference_at(u16 index) const;
+
+    // Attempts to read an interface method reference from the constant pool
+    ErrorOr<ConstantMemberReferenceInfo> interface_method_reference_at(u16 index) const;
 
     // Attempts to read a name and type from the constant pool
-    ErrorOr<NonnullRefPtr<ConstantNameAndTypeInfo>> name_and_type_at(u16 index);
+    ErrorOr<ConstantNameAndTypeInfo> name_and_type_at(u16 index) const;
 
     // Attempts to read a utf8 constant from the constant pool
-    ErrorOr<NonnullRefPtr<ConstantUTF8Info>> utf8_at(u16 index);
+    ErrorOr<ConstantUTF8Info> utf8_at(u16 index) const;
 
     // Attempts to read a class' information from the constant pool
-    ErrorOr<NonnullRefPtr<ConstantClassInfo>> class_at(u16 index);
+    ErrorOr<ConstantClassInfo> class_at(u16 index) const;
+
+    // Attempts to read a string constant from the constant pool
+    ErrorOr<ConstantStringInfo> string_at(u16 index) const;
+
+    // Attempts to read an integer constant from the constant pool
+    ErrorOr<ConstantIntegerInfo> integer_at(u16 index) const;
+
+    // Attempts to read a float constant from the constant pool
+    ErrorOr<ConstantFloatInfo> float_at(u16 index) const;
+
+    // Attempts to read a long constant from the constant pool
+    ErrorOr<ConstantLongInfo> long_at(u16 index) const;
+
+    // Attempts to read a double constant from the constant pool
+    ErrorOr<ConstantDoubleInfo> double_at(u16 index) const;
+
+    // Attempts to read a method handle from the constant pool
+    ErrorOr<ConstantMethodHandleInfo> method_handle_at(u16 index) const;
+
+    // Attempts to read a method type from the constant pool
+    ErrorOr<ConstantMethodTypeInfo> method_type_at(u16 index) const;
+
+    // Attempts to read a dynamically-computed constant from the constant pool
+    ErrorOr<ConstantDynamicInfo> dynamic_at(u16 index) const;
+
+    // Attempts to read a dynamically-computed call site from the constant pool
+    ErrorOr<ConstantDynamicInfo> invoke_dynamic_at(u16 index) const;
+
+    // Attempts to read a module from the constant pool
+    ErrorOr<ConstantModuleInfo> module_at(u16 index) const;
+
+    // Attempts to read a package from the constant pool
+    ErrorOr<ConstantModuleInfo> package_at(u16 index) const;
+
+    // Returns the type of attribute named by the utf8 constant at the index
+    AttributeType attribute_type_at(u16 index) const
+    {
+        // The constant_pool entry at attribute_name_index must be a CONSTANT_Utf8_info structure
+        VERIFY(tag_at(index) == Constant::Tag::UTF8);
+        return m_attribute_types[index];
+    }
+
+    // Used for debugging
+    ErrorOr<String> debug_description_at(u16 index) const;
 
 private:
-    Vector<NonnullRefPtr<ConstantInfo>> m_entries;
+    u64 payload_at(u16 index, Constant::Tag expected_tag) const
+    {
+        // The constant_pool entry at that index must be of the expected type.
+        VERIFY(tag_at(index) == expected_tag);
+        return m_payloads[index];
+    }
+
+    Vector<u8> m_tags;
+    Vector<u64> m_payloads;
+    Vector<AttributeType> m_attribute_types;
 };
 
 }
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Symbol.h"
+#include <AK/Array.h>
+#include <AK/HashTable.h>
+#include <AK/StringHash.h>
+#include <AK/kmalloc.h>
+#include <LibThreading/Mutex.h>
+#include <string.h>
+
+// The process-wide table of interned symbols.
+//
+// Class files are parsed on many threads at once, so the table is split into shards by hash,
+// each with its own lock, to keep threads from contending on a single mutex.
+// Symbols are never freed, so their storage is carved out of large blocks with a bump pointer.
+class SymbolTable {
+public:
+    static SymbolTable& the()
+    {
+        static SymbolTable table;
+        return table;
+    }
+
+    ErrorOr<Symbol> intern(StringView bytes)
+    {
+        auto content_hash = string_hash(bytes.characters_without_null_termination(), bytes.length());
+        auto& shard = m_shards[content_hash % shard_count];
+
+        Threading::MutexLocker locker(shard.mutex);
+
+        auto existing_data = shard.table.find(content_hash, [&](Symbol::Data const* data) {
+            return data->view() == bytes;
+        });
+        if (existing_data != shard.table.end())
+            return Symbol(*existing_data);
+
+        auto* data = TRY(shard.allocate(sizeof(Symbol::Data) + bytes.length()));
+        auto* header = new (data) Symbol::Data { .content_hash = content_hash, .length = static_cast<u32>(bytes.length()) };
+        if (!bytes.is_empty())
+            memcpy(data + sizeof(Symbol::Data), bytes.characters_without_null_termination(), bytes.length());
+
+        TRY(shard.table.try_set(header));
+        return Symbol(header);
+    }
+
+    Symbol find(StringView bytes)
+    {
+        auto content_hash = string_hash(bytes.characters_without_null_termination(), bytes.length());
+        auto& shard = m_shards[content_hash % shard_count];
+
+        Threading::MutexLocker locker(shard.mutex);
+
+        auto existing_data = shard.table.find(content_hash, [&](Symbol::Data const* data) {
+            return data->view() == bytes;
+        });
+        if (existing_data == shard.table.end())
+            return {};
+
+        return Symbol(*existing_data);
+    }
+
+private:
+    static constexpr size_t shard_count = 16;
+    static constexpr size_t block_size = 64 * KiB;
+
+    struct DataTraits : public GenericTraits<Symbol::Data const*> {
+        static unsigned hash(Symbol::Data const* data) { return data->content_hash; };
+        static bool equals(Symbol::Data const* a, Symbol::Data const* b) { return a->view() == b->view(); };
+    };
+
+    struct Shard {
+        ErrorOr<u8*> allocate(size_t size)
+        {
+            // Keep the headers aligned
+            size = align_up_to(size, alignof(Symbol::Data));
+
+            // Unusually large symbols get their own allocation, instead of wasting the rest of a block
+            if (size > block_size / 4) {
+                auto* allocation = static_cast<u8*>(kmalloc(size));
+                if (!allocation)
+                    return Error::from_errno(ENOMEM);
+
+                return allocation;
+            }
+
+            if (size > block_remaining) {
+                current_block = static_cast<u8*>(kmalloc(block_size));
+                if (!current_block)
+                    return Error::from_errno(ENOMEM);
+
+                block_remaining = block_size;
+            }
+
+            auto* allocation = current_block;
+            current_block += size;
+            block_remaining -= size;
+
+            return allocation;
+        }
+
+        Threading::Mutex mutex;
+        HashTable<Symbol::Data const*, DataTraits> table;
+
+        u8* current_block { nullptr };
+        size_t block_remaining { 0 };
+    };
+
+    Array<Shard, shard_count> m_shards;
+};
+
+ErrorOr<Symbol> Symbol::intern(StringView bytes)
+{
+    return SymbolTable::the().intern(bytes);
+}
+
+Symbol Symbol::find(StringView bytes)
+{
+    return SymbolTable::the().find(bytes);
+}
+
+WellKnownSymbols const& WellKnownSymbols::the()
+{
+    static WellKnownSymbols symbols {
+        .java_lang_Object = MUST(Symbol::intern("java/lang/Object"sv)),
+        .java_lang_String = MUST(Symbol::intern("java/lang/String"sv)),
+        .java_lang_System = MUST(Symbol::intern("java/lang/System"sv)),
+        .java_io_PrintStream = MUST(Symbol::intern("java/io/PrintStream"sv)),
+        .java_lang_Cloneable = MUST(Symbol::intern("java/lang/Cloneable"sv)),
+        .java_io_Serializable = MUST(Symbol::intern("java/io/Serializable"sv)),
+        .java_lang_Throwable = MUST(Symbol::intern("java/lang/Throwable"sv)),
+        .java_lang_Class = MUST(Symbol::intern("java/lang/Class"sv)),
+        .java_lang_invoke_MethodType = MUST(Symbol::intern("java/lang/invoke/MethodType"sv)),
+        .java_lang_invoke_MethodHandle = MUST(Symbol::intern("java/lang/invoke/MethodHandle"sv)),
+        .java_lang_invoke_StringConcatFactory = MUST(Symbol::intern("java/lang/invoke/StringConcatFactory"sv)),
+        .make_concat = MUST(Symbol::intern("makeConcat"sv)),
+        .make_concat_with_constants = MUST(Symbol::intern("makeConcatWithConstants"sv)),
+        .to_string = MUST(Symbol::intern("toString"sv)),
+        .to_string_descriptor = MUST(Symbol::intern("()Ljava/lang/String;"sv)),
+        .main = MUST(Symbol::intern("main"sv)),
+        .main_descriptor = MUST(Symbol::intern("([Ljava/lang/String;)V"sv)),
+        .init = MUST(Symbol::intern("<init>"sv)),
+        .clinit = MUST(Symbol::intern("<clinit>"sv)),
+        .void_method_descriptor = MUST(Symbol::intern("()V"sv)),
+        .constant_value_attribute = MUST(Symbol::intern("ConstantValue"sv)),
+        .code_attribute = MUST(Symbol::intern("Code"sv)),
+        .line_number_table_attribute = MUST(Symbol::intern("LineNumberTable"sv)),
+        .source_file_attribute = MUST(Symbol::intern("SourceFile"sv)),
+        .stack_map_table_attribute = MUST(Symbol::intern("StackMapTable"sv)),
+        .bootstrap_methods_attribute = MUST(Symbol::intern("BootstrapMethods"sv)),
+    };
+
+    return symbols;
+}
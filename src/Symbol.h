@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2023, Caoimhe Byrne <caoimhebyrne06@gmail.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <AK/Format.h>
+#include <AK/HashFunctions.h>
+#include <AK/StringView.h>
+#include <AK/Traits.h>
+#include <AK/Types.h>
+
+// A Symbol is a handle to an interned sequence of (modified UTF-8) bytes, such as a class name, member name or descriptor.
+//
+// Every distinct byte sequence is stored exactly once for the lifetime of the process, so two symbols are equal if and
+// only if they point at the same storage. Comparing and hashing symbols never has to look at their contents.
+//
+// Class files store strings in modified UTF-8, which isn't always valid UTF-8 (e.g. encoded nulls and surrogate pairs),
+// so symbols are treated as raw bytes. Convert them to a String only when it is actually needed.
+// https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-4.html#jvms-4.4.7
+class Symbol {
+public:
+    // A null symbol, which doesn't compare equal to any interned symbol
+    Symbol() = default;
+
+    // Returns the symbol for the bytes, interning them if this is the first time they've been seen.
+    // This is safe to call from multiple threads at once.
+    static ErrorOr<Symbol> intern(StringView bytes);
+
+    // Returns the symbol for the bytes if they've already been interned, or a null symbol if they haven't, without interning them
+    static Symbol find(StringView bytes);
+
+    bool is_null() const { return m_data == nullptr; };
+
+    StringView view() const
+    {
+        if (!m_data)
+            return {};
+
+        return { m_data->characters(), m_data->length };
+    }
+
+    size_t length() const { return m_data ? m_data->length : 0; };
+
+    bool operator==(Symbol const& other) const { return m_data == other.m_data; };
+
+    // Used to pack symbols into fixed-width tables, such as the constant pool's payloads
+    FlatPtr bits() const { return reinterpret_cast<FlatPtr>(m_data); };
+    static Symbol from_bits(FlatPtr bits) { return Symbol(reinterpret_cast<Data const*>(bits)); };
+
+    // Symbols are compared by identity, so hashing the pointer is enough
+    unsigned hash() const { return ptr_hash(m_data); };
+
+private:
+    friend class SymbolTable;
+
+    // The storage for an interned symbol, the bytes immediately follow this header.
+    struct Data {
+        unsigned content_hash;
+        u32 length;
+
+        char const* characters() const { return reinterpret_cast<char const*>(this + 1); };
+        StringView view() const { return { characters(), length }; };
+    };
+
+    explicit Symbol(Data const* data)
+        : m_data(data)
+    {
+    }
+
+    Data const* m_data { nullptr };
+};
+
+// Symbols which are looked up by the virtual machine itself, these are interned once at startup.
+struct WellKnownSymbols {
+    static WellKnownSymbols const& the();
+
+    // The root of the class hierarchy
+    Symbol java_lang_Object;
+
+    // Classes which the runtime needs to know about
+    Symbol java_lang_String;
+    Symbol java_lang_System;
+    Symbol java_io_PrintStream;
+
+    // Every array type implements these interfaces
+    Symbol java_lang_Cloneable;
+    Symbol java_io_Serializable;
+
+    // The types of the values that the verifier has to know about: what athrow throws, and what ldc loads
+    Symbol java_lang_Throwable;
+    Symbol java_lang_Class;
+    Symbol java_lang_invoke_MethodType;
+    Symbol java_lang_invoke_MethodHandle;
+
+    // The only bootstrap methods of invokedynamic call sites that are supported, which are implemented by the runtime itself
+    Symbol java_lang_invoke_StringConcatFactory;
+    Symbol make_concat;
+    Symbol make_concat_with_constants;
+
+    // Object.toString, which string conversion calls on every object that isn't a string
+    Symbol to_string;
+    Symbol to_string_descriptor;
+
+    // The entry point of a program, and its descriptor
+    Symbol main;
+    Symbol main_descriptor;
+
+    // The name of every instance initialization method
+    Symbol init;
+
+    // The name of every class or interface initialization method
+    Symbol clinit;
+
+    // The descriptor for a method that takes no parameters, and returns nothing
+    Symbol void_method_descriptor;
+
+    // The names of the attributes that the parser understands
+    Symbol constant_value_attribute;
+    Symbol code_attribute;
+    Symbol line_number_table_attribute;
+    Symbol source_file_attribute;
+    Symbol stack_map_table_attribute;
+    Symbol bootstrap_methods_attribute;
+};
+
+namespace AK {
+
+template<>
+struct Traits<Symbol> : public GenericTraits<Symbol> {
+    static unsigned hash(Symbol const& symbol) { return symbol.hash(); };
+    static bool equals(Symbol const& a, Symbol const& b) { return a == b; };
+};
+
+template<>
+struct Formatter<Symbol> : Formatter<StringView> {
+    ErrorOr<void> format(FormatBuilder& builder, Symbol const& symbol)
+    {
+        return Formatter<StringView>::format(builder, symbol.view());
+    }
+};
+
+}
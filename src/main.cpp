@@ -4,46 +4,131 @@
  * SPDX-License-Identifier: MIT
  */
 
-#include <AK/BitStream.h>
 #include <AK/Error.h>
 #include <AK/NonnullOwnPtr.h>
-#include <AK/Stream.h>
 #include <LibCore/ArgsParser.h>
-#include <LibCore/File.h>
 #include <LibMain/Main.h>
+#include <unistd.h>
 
-#include "Interpreter/SymbolicatedConstantPool.h"
+#include "Interpreter/Interpreter.h"
+#include "Interpreter/Runtime.h"
+#include "Loader/ClassLoader.h"
 
 #include "Parser/ClassFile.h"
-#include "Parser/ClassParser.h"
 #include "Parser/ConstantInfo.h"
 #include "Parser/ConstantPool.h"
 
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
     auto dump_constant_pool = false;
+    auto dump_inline_caches = false;
+    auto dump_allocation_statistics = false;
+    auto log_garbage_collection = false;
+    auto disable_jit = false;
+    auto disable_verification = false;
+    auto log_jit = false;
+    size_t profiled_method_count = 0;
+    auto jit_invocation_threshold = Interpreter::TieringPolicy::default_invocation_threshold;
+    auto jit_backedge_threshold = Interpreter::TieringPolicy::default_backedge_threshold;
+    auto disable_optimizing_jit = false;
+    auto jit_optimization_invocation_threshold = Interpreter::TieringPolicy::default_optimization_invocation_threshold;
+    auto jit_optimization_backedge_threshold = Interpreter::TieringPolicy::default_optimization_backedge_threshold;
+    auto heap_size_in_mebibytes = Interpreter::Heap::default_size / MiB;
+    auto worker_count = static_cast<size_t>(sysconf(_SC_NPROCESSORS_ONLN));
+    auto marking_thread_count = static_cast<size_t>(sysconf(_SC_NPROCESSORS_ONLN));
+    auto classpath = Vector<StringView>();
+    auto main_class_name = StringView();
+    auto dispatch_mode_name = StringView();
 
     auto args_parser = make<Core::ArgsParser>();
     args_parser->add_option(dump_constant_pool, "Shows the contents of the constant pool table", "dump-constant-pool", 0, Core::ArgsParser::OptionHideMode::None);
+    args_parser->add_option(dump_inline_caches, "Shows the inline cache of every virtual and interface call site after the program exits", "dump-inline-caches", 0, Core::ArgsParser::OptionHideMode::None);
+    args_parser->add_option(dump_allocation_statistics, "Shows how much has been allocated on the heap after the program exits", "dump-allocation-statistics", 0, Core::ArgsParser::OptionHideMode::None);
+    args_parser->add_option(profiled_method_count, "Shows this many of the hottest methods, with their invocation and back-edge counts, after the program exits", "dump-profile", 0, "count");
+    args_parser->add_option(log_garbage_collection, "Logs the kind, the pause time and the number of bytes reclaimed by each garbage collection", "log-gc", 0, Core::ArgsParser::OptionHideMode::None);
+    args_parser->add_option(disable_verification, "Trusts every class on the classpath, instead of verifying their bytecode", "no-verify", 0, Core::ArgsParser::OptionHideMode::None);
+    args_parser->add_option(disable_jit, "Only interprets methods, instead of compiling the hot ones to machine code", "no-jit", 0, Core::ArgsParser::OptionHideMode::None);
+    args_parser->add_option(log_jit, "Logs every method that is compiled to machine code, every loop that moves into compiled code, and every time that compiled code is thrown away", "log-jit", 0, Core::ArgsParser::OptionHideMode::None);
+    args_parser->add_option(jit_invocation_threshold, "How many times a method is invoked before it's compiled to machine code", "jit-invocation-threshold", 0, "count");
+    args_parser->add_option(jit_backedge_threshold, "How many times a method's loops branch backwards before it's compiled to machine code", "jit-backedge-threshold", 0, "count");
+    args_parser->add_option(disable_optimizing_jit, "Only compiles hot methods with the baseline JIT, instead of optimizing the hottest ones", "no-optimizing-jit", 0, Core::ArgsParser::OptionHideMode::None);
+    args_parser->add_option(jit_optimization_invocation_threshold, "How many times a method is invoked before it's optimized", "jit-optimization-invocation-threshold", 0, "count");
+    args_parser->add_option(jit_optimization_backedge_threshold, "How many times a method's loops branch backwards before it's optimized", "jit-optimization-backedge-threshold", 0, "count");
+    args_parser->add_option(heap_size_in_mebibytes, "The size of the heap in MiB, including both generations", "heap-size", 0, "size");
+    args_parser->add_option(worker_count, "The number of threads used to parse class files", "jobs", 'j', "count");
+    args_parser->add_option(marking_thread_count, "The number of threads used to mark objects during a full garbage collection", "gc-threads", 0, "count");
+    args_parser->add_option(main_class_name, "The binary name of the class to run, e.g. com/example/Main", "main-class", 'm', "name");
+    args_parser->add_option(dispatch_mode_name, "How the interpreter dispatches instructions, either 'threaded' or 'switch'", "dispatch", 0, "mode");
+    args_parser->add_positional_argument(classpath, "Class files, JAR files, or directories containing them, to load", "classpath", Core::ArgsParser::Required::No);
     args_parser->parse(arguments);
 
-    auto file = TRY(Core::File::open("Example/Test.class"sv, Core::File::OpenMode::Read));
-    auto class_parser = TRY(Parser::ClassParser::create(move(file)));
-    auto class_file = TRY(class_parser->parse());
+    if (classpath.is_empty()) {
+        classpath.append("Example/Test.class"sv);
+        if (main_class_name.is_empty())
+            main_class_name = "Test"sv;
+    }
+
+    auto dispatch_mode = Interpreter::default_dispatch_mode();
+    if (dispatch_mode_name == "switch"sv) {
+        dispatch_mode = Interpreter::DispatchMode::Switch;
+    } else if (dispatch_mode_name == "threaded"sv) {
+        dispatch_mode = Interpreter::DispatchMode::Threaded;
+    } else if (!dispatch_mode_name.is_empty()) {
+        warnln("Unknown dispatch mode '{}', expected 'threaded' or 'switch'", dispatch_mode_name);
+        return 1;
+    }
+
+    // Parse every class on the classpath in parallel
+    Loader::ClassRegistry class_registry;
+    Loader::ClassLoader class_loader(class_registry, worker_count);
+    class_loader.set_verification_enabled(!disable_verification);
+    TRY(class_loader.load(classpath));
 
     if (dump_constant_pool) {
-        // Dump the constant pool table
-        for (auto const& constant : class_file.constant_pool->entries()) {
+        for (auto const& [class_name, class_file] : class_registry.classes()) {
+            // Dump the constant pool table
             // The constant pool is 1 indexed
-            auto index = class_file.constant_pool->entries().find_first_index(constant).value() + 1;
-            dbgln("{}: {}", index, TRY(constant->debug_description()));
+            dbgln("{}:", class_name);
+            for (u16 index = 1; index < class_file->constant_pool->size(); index++) {
+                dbgln("{}: {}", index, TRY(class_file->constant_pool->debug_description_at(index)));
+            }
         }
     }
 
-    // Attempt to symbolicate the parsed constant pool
-    // https://docs.oracle.com/javase/specs/jvms/se17/html/jvms-5.html#jvms-5.1
-    auto symbolicated_constant_pool = Interpreter::SymbolicatedConstantPool::create(class_file.constant_pool);
-    TRY(symbolicated_constant_pool->symbolicate());
+    // If there's only a single class on the classpath, then that must be the main class
+    auto main_class = Symbol();
+    if (!main_class_name.is_empty()) {
+        main_class = TRY(Symbol::intern(main_class_name));
+    } else if (class_registry.size() == 1) {
+        main_class = class_registry.classes().begin()->key;
+    } else {
+        warnln("Error: There are {} classes on the classpath, please choose one to run with --main-class", class_registry.size());
+        return 1;
+    }
+
+    auto runtime = TRY(Interpreter::Runtime::create(class_registry, dispatch_mode, heap_size_in_mebibytes * MiB));
+    runtime->heap().set_logging_enabled(log_garbage_collection);
+    runtime->heap().set_marking_thread_count(marking_thread_count);
+    runtime->interpreter().set_jit_logging_enabled(log_jit);
+    runtime->interpreter().tiering_policy().set_invocation_threshold(jit_invocation_threshold);
+    runtime->interpreter().tiering_policy().set_backedge_threshold(jit_backedge_threshold);
+    runtime->interpreter().tiering_policy().set_optimization_invocation_threshold(jit_optimization_invocation_threshold);
+    runtime->interpreter().tiering_policy().set_optimization_backedge_threshold(jit_optimization_backedge_threshold);
+    runtime->interpreter().tiering_policy().set_optimization_enabled(!disable_optimizing_jit);
+    if (disable_jit)
+        runtime->interpreter().set_jit_enabled(false);
+
+    auto result = runtime->run_main(main_class);
+    if (dump_inline_caches)
+        runtime->dump_inline_caches();
+
+    if (dump_allocation_statistics)
+        runtime->dump_allocation_statistics();
+
+    if (profiled_method_count > 0)
+        runtime->dump_profile(profiled_method_count);
+
+    TRY(result);
 
     return 0;
 }